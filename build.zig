@@ -127,6 +127,14 @@ pub fn build(b: *std.Build) void {
     };
     const kernel_resolved = b.resolveTargetQuery(kernel_target);
 
+    // Framebuffer primitives for the kernel image (RISC-V target).
+    const kernel_framebuffer_primitives_module = b.createModule(.{
+        .root_source_file = b.path("src/kernel/framebuffer_primitives.zig"),
+        .target = kernel_resolved,
+        .optimize = optimize,
+        .code_model = .medium,
+    });
+
     const kernel_exe = b.addExecutable(.{
         .name = "grain-rv64",
         .root_module = b.createModule(.{
@@ -134,6 +142,9 @@ pub fn build(b: *std.Build) void {
             .target = kernel_resolved,
             .optimize = optimize,
             .code_model = .medium,
+            .imports = &.{
+                .{ .name = "framebuffer_primitives", .module = kernel_framebuffer_primitives_module },
+            },
         }),
     });
     kernel_exe.setLinkerScript(b.path("src/kernel/linker.ld"));
@@ -150,6 +161,14 @@ pub fn build(b: *std.Build) void {
         .optimize = optimize,
     });
 
+    // Framebuffer primitives module (vectorized fill, glyph, blit).
+    // Why: Shared by kernel framebuffer driver, VM host side, and grain_os.
+    const framebuffer_primitives_module = b.addModule("framebuffer_primitives", .{
+        .root_source_file = b.path("src/kernel/framebuffer_primitives.zig"),
+        .target = target,
+        .optimize = optimize,
+    });
+
     // Basin Kernel module (syscall interface and kernel structures).
     // Note: basin_kernel.zig imports elf_parser.zig as a file (same directory).
     // Tests can import elf_parser as a module separately.
@@ -175,6 +194,7 @@ pub fn build(b: *std.Build) void {
         .imports = &.{
             .{ .name = "sbi", .module = sbi_module },
             .{ .name = "basin_kernel", .module = basin_kernel_module },
+            .{ .name = "framebuffer_primitives", .module = framebuffer_primitives_module },
         },
     });
 
@@ -255,6 +275,7 @@ pub fn build(b: *std.Build) void {
         .optimize = optimize,
         .imports = &.{
             .{ .name = "basin_kernel", .module = basin_kernel_module },
+            .{ .name = "framebuffer_primitives", .module = framebuffer_primitives_module },
         },
     });
 
@@ -286,6 +307,7 @@ pub fn build(b: *std.Build) void {
             .optimize = .ReleaseFast, // Benchmark should be optimized
             .imports = &.{
                 .{ .name = "sbi", .module = sbi_module },
+                .{ .name = "framebuffer_primitives", .module = framebuffer_primitives_module },
             },
         }),
     });
@@ -293,6 +315,92 @@ pub fn build(b: *std.Build) void {
     const benchmark_jit_step = b.step("benchmark-jit", "Run JIT vs Interpreter benchmark");
     benchmark_jit_step.dependOn(&benchmark_jit_run.step);
 
+    // Session restore benchmark (snapshot restore vs per-window rebuild).
+    const benchmark_session_restore_exe = b.addExecutable(.{
+        .name = "benchmark_session_restore",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/grain_os/benchmark_session_restore.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "basin_kernel", .module = basin_kernel_module },
+                .{ .name = "framebuffer_primitives", .module = framebuffer_primitives_module },
+            },
+        }),
+    });
+    const benchmark_session_restore_run = b.addRunArtifact(benchmark_session_restore_exe);
+    const benchmark_session_restore_step = b.step("benchmark-session-restore", "Run session snapshot restore benchmark");
+    benchmark_session_restore_step.dependOn(&benchmark_session_restore_run.step);
+
+    // GrainLoop loopback benchmark (epoll + recvmmsg/sendmmsg through Graindaemon).
+    const benchmark_grain_loop_exe = b.addExecutable(.{
+        .name = "benchmark_grain_loop",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/benchmark_grain_loop.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+        }),
+    });
+    const benchmark_grain_loop_run = b.addRunArtifact(benchmark_grain_loop_exe);
+    const benchmark_grain_loop_step = b.step("benchmark-grain-loop", "Run GrainLoop UDP loopback benchmark");
+    benchmark_grain_loop_step.dependOn(&benchmark_grain_loop_run.step);
+
+    // GrainRoute lookup benchmark (compiled trie vs linear scan, growing tables).
+    const benchmark_grain_route_exe = b.addExecutable(.{
+        .name = "benchmark_grain_route",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/benchmark_grain_route.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+        }),
+    });
+    const benchmark_grain_route_run = b.addRunArtifact(benchmark_grain_route_exe);
+    const benchmark_grain_route_step = b.step("benchmark-grain-route", "Run GrainRoute trie lookup benchmark");
+    benchmark_grain_route_step.dependOn(&benchmark_grain_route_run.step);
+
+    // Omnibox benchmark (prefix index + frecency over 100k history visits).
+    const benchmark_omnibox_exe = b.addExecutable(.{
+        .name = "benchmark_omnibox",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/benchmark_omnibox.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+        }),
+    });
+    const benchmark_omnibox_run = b.addRunArtifact(benchmark_omnibox_exe);
+    const benchmark_omnibox_step = b.step("benchmark-omnibox", "Run Dream Browser omnibox query benchmark");
+    benchmark_omnibox_step.dependOn(&benchmark_omnibox_run.step);
+
+    // Grain TLS handshake benchmark (shared roots, loopback server).
+    const benchmark_tls_handshake_exe = b.addExecutable(.{
+        .name = "benchmark_tls_handshake",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/benchmark_tls_handshake.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "tls", .module = tls_module },
+                .{ .name = "grain_tls_impl", .module = grain_tls_impl_module },
+            },
+        }),
+    });
+    const benchmark_tls_handshake_run = b.addRunArtifact(benchmark_tls_handshake_exe);
+    const benchmark_tls_handshake_step = b.step("benchmark-tls-handshake", "Run Grain TLS handshake benchmark (local server)");
+    benchmark_tls_handshake_step.dependOn(&benchmark_tls_handshake_run.step);
+
+    // TigerBank settlement benchmark (batch size x in-flight window, loopback mock cluster).
+    const benchmark_tigerbank_batch_exe = b.addExecutable(.{
+        .name = "benchmark_tigerbank_batch",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/benchmark_tigerbank_batch.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+        }),
+    });
+    const benchmark_tigerbank_batch_run = b.addRunArtifact(benchmark_tigerbank_batch_exe);
+    const benchmark_tigerbank_batch_step = b.step("benchmark-tigerbank-batch", "Run TigerBank batched settlement benchmark");
+    benchmark_tigerbank_batch_step.dependOn(&benchmark_tigerbank_batch_run.step);
+
     const validate_src_exe = b.addExecutable(.{
         .name = "validate_src",
         .root_module = b.createModule(.{
@@ -360,6 +468,14 @@ pub fn build(b: *std.Build) void {
         }),
     });
 
+    const tigerbank_client_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/tigerbank_client.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
     const lattice_tests = b.addTest(.{
         .root_module = b.createModule(.{
             .root_source_file = b.path("src/grain_lattice.zig"),
@@ -472,6 +588,14 @@ pub fn build(b: *std.Build) void {
         }),
     });
 
+    const search_index_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/aurora_search_index.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
     const route_tests = b.addTest(.{
         .root_module = b.createModule(.{
             .root_source_file = b.path("src/grain_route.zig"),
@@ -480,6 +604,47 @@ pub fn build(b: *std.Build) void {
         }),
     });
 
+    const tab_hibernation_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/aurora_tab_hibernation.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
+    // grainmirror's module root pulls in sync.zig and pool.zig tests.
+    const grainmirror_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("grainstore/github/teamcarry11/grainmirror/src/grainmirror.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
+    const tab_manager_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/aurora_tab_manager.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
+    const places_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/dream_browser_places.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
+    const dag_integration_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/aurora_dag_integration.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+
     const orchestrator_tests = b.addTest(.{
         .root_module = b.createModule(.{
             .root_source_file = b.path("src/grain_orchestrator.zig"),
@@ -606,6 +771,8 @@ pub fn build(b: *std.Build) void {
     test_step.dependOn(&run_mmt_tests.step);
     const run_cdn_tests = b.addRunArtifact(cdn_tests);
     test_step.dependOn(&run_cdn_tests.step);
+    const run_tigerbank_client_tests = b.addRunArtifact(tigerbank_client_tests);
+    test_step.dependOn(&run_tigerbank_client_tests.step);
     const run_lattice_tests = b.addRunArtifact(lattice_tests);
     test_step.dependOn(&run_lattice_tests.step);
     const run_prompts_tests = b.addRunArtifact(prompts_tests);
@@ -634,8 +801,20 @@ pub fn build(b: *std.Build) void {
     test_step.dependOn(&run_glm46_provider_tests.step);
     const run_ai_transforms_tests = b.addRunArtifact(ai_transforms_tests);
     test_step.dependOn(&run_ai_transforms_tests.step);
+    const run_search_index_tests = b.addRunArtifact(search_index_tests);
+    test_step.dependOn(&run_search_index_tests.step);
     const run_route_tests = b.addRunArtifact(route_tests);
     test_step.dependOn(&run_route_tests.step);
+    const run_tab_hibernation_tests = b.addRunArtifact(tab_hibernation_tests);
+    test_step.dependOn(&run_tab_hibernation_tests.step);
+    const run_grainmirror_tests = b.addRunArtifact(grainmirror_tests);
+    test_step.dependOn(&run_grainmirror_tests.step);
+    const run_tab_manager_tests = b.addRunArtifact(tab_manager_tests);
+    test_step.dependOn(&run_tab_manager_tests.step);
+    const run_places_tests = b.addRunArtifact(places_tests);
+    test_step.dependOn(&run_places_tests.step);
+    const run_dag_integration_tests = b.addRunArtifact(dag_integration_tests);
+    test_step.dependOn(&run_dag_integration_tests.step);
     const run_orchestrator_tests = b.addRunArtifact(orchestrator_tests);
     test_step.dependOn(&run_orchestrator_tests.step);
     const run_riscv_tests = b.addRunArtifact(riscv_tests);
@@ -825,6 +1004,9 @@ pub fn build(b: *std.Build) void {
         .root_source_file = b.path("src/kernel/framebuffer.zig"),
         .target = target,
         .optimize = optimize,
+        .imports = &.{
+            .{ .name = "framebuffer_primitives", .module = framebuffer_primitives_module },
+        },
     });
     
     const framebuffer_tests = b.addTest(.{
@@ -1957,6 +2139,175 @@ pub fn build(b: *std.Build) void {
     const grain_os_lock_screen_tests_run = b.addRunArtifact(grain_os_lock_screen_tests);
     test_step.dependOn(&grain_os_lock_screen_tests_run.step);
 
+    const framebuffer_primitives_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/084_framebuffer_primitives_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "framebuffer_primitives", .module = framebuffer_primitives_module },
+            },
+        }),
+    });
+    const framebuffer_primitives_tests_run = b.addRunArtifact(framebuffer_primitives_tests);
+    test_step.dependOn(&framebuffer_primitives_tests_run.step);
+
+    // Headless platform module (null backend) for framebuffer sync tests.
+    const platform_module = b.createModule(.{
+        .root_source_file = b.path("src/platform.zig"),
+        .target = target,
+        .optimize = optimize,
+    });
+    const framebuffer_dirty_tiles_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/085_framebuffer_dirty_tiles_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+                .{ .name = "platform", .module = platform_module },
+            },
+        }),
+    });
+    const framebuffer_dirty_tiles_tests_run = b.addRunArtifact(framebuffer_dirty_tiles_tests);
+    test_step.dependOn(&framebuffer_dirty_tiles_tests_run.step);
+
+    const input_ring_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/086_input_ring_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+            },
+        }),
+    });
+    const input_ring_tests_run = b.addRunArtifact(input_ring_tests);
+    test_step.dependOn(&input_ring_tests_run.step);
+
+    const vm_record_replay_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/087_vm_record_replay_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+            },
+        }),
+    });
+    const vm_record_replay_tests_run = b.addRunArtifact(vm_record_replay_tests);
+    test_step.dependOn(&vm_record_replay_tests_run.step);
+
+    const vm_debug_breakpoints_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/088_vm_debug_breakpoints_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "kernel_vm", .module = kernel_vm_module },
+            },
+        }),
+    });
+    const vm_debug_breakpoints_tests_run = b.addRunArtifact(vm_debug_breakpoints_tests);
+    test_step.dependOn(&vm_debug_breakpoints_tests_run.step);
+
+    const grain_os_window_index_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/089_grain_os_window_index_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "grain_os", .module = grain_os_module },
+            },
+        }),
+    });
+    const grain_os_window_index_tests_run = b.addRunArtifact(grain_os_window_index_tests);
+    test_step.dependOn(&grain_os_window_index_tests_run.step);
+
+    const grain_os_wayland_server_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/090_grain_os_wayland_server_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "grain_os", .module = grain_os_module },
+            },
+        }),
+    });
+    const grain_os_wayland_server_tests_run = b.addRunArtifact(grain_os_wayland_server_tests);
+    test_step.dependOn(&grain_os_wayland_server_tests_run.step);
+
+    const grain_os_session_snapshot_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/091_grain_os_session_snapshot_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "grain_os", .module = grain_os_module },
+            },
+        }),
+    });
+    const grain_os_session_snapshot_tests_run = b.addRunArtifact(grain_os_session_snapshot_tests);
+    test_step.dependOn(&grain_os_session_snapshot_tests_run.step);
+
+    const grain_os_render_harness_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/092_grain_os_render_harness_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "grain_os", .module = grain_os_module },
+                .{ .name = "platform", .module = platform_module },
+            },
+        }),
+    });
+    const grain_os_render_harness_tests_run = b.addRunArtifact(grain_os_render_harness_tests);
+    test_step.dependOn(&grain_os_render_harness_tests_run.step);
+
+    const grain_os_window_rule_matcher_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/093_grain_os_window_rule_matcher_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "grain_os", .module = grain_os_module },
+            },
+        }),
+    });
+    const grain_os_window_rule_matcher_tests_run = b.addRunArtifact(grain_os_window_rule_matcher_tests);
+    test_step.dependOn(&grain_os_window_rule_matcher_tests_run.step);
+
+    const grain_os_bounded_map_tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests/094_grain_os_bounded_map_test.zig"),
+            .target = target,
+            .optimize = optimize,
+            .imports = &.{
+                .{ .name = "grain_os", .module = grain_os_module },
+            },
+        }),
+    });
+    const grain_os_bounded_map_tests_run = b.addRunArtifact(grain_os_bounded_map_tests);
+    test_step.dependOn(&grain_os_bounded_map_tests_run.step);
+
+    // Headless compositor render benchmark (null platform backend).
+    const benchmark_render_exe = b.addExecutable(.{
+        .name = "benchmark_render",
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/grain_os/benchmark_render.zig"),
+            .target = target,
+            .optimize = .ReleaseFast,
+            .imports = &.{
+                .{ .name = "basin_kernel", .module = basin_kernel_module },
+                .{ .name = "framebuffer_primitives", .module = framebuffer_primitives_module },
+                .{ .name = "platform", .module = platform_module },
+            },
+        }),
+    });
+    const benchmark_render_run = b.addRunArtifact(benchmark_render_exe);
+    const benchmark_render_step = b.step("benchmark-render", "Run headless compositor render benchmark");
+    benchmark_render_step.dependOn(&benchmark_render_run.step);
+
     // RISC-V Logo Display Program
     const riscv_logo_exe = b.addExecutable(.{
         .name = "riscv_logo",
@@ -7,14 +7,18 @@ pub fn build(b: *std.Build) void {
     // Create the grainmirror module
     const mirror_mod = b.addModule("grainmirror", .{
         .root_source_file = b.path("src/grainmirror.zig"),
+        .target = target,
+        .optimize = optimize,
     });
 
     // Create CLI executable
     const exe = b.addExecutable(.{
         .name = "grainmirror",
-        .root_source_file = b.path("src/cli.zig"),
-        .target = target,
-        .optimize = optimize,
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("src/cli.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
     });
 
     b.installArtifact(exe);
@@ -29,18 +33,14 @@ pub fn build(b: *std.Build) void {
     const run_step = b.step("run", "Run grainmirror CLI");
     run_step.dependOn(&run_cmd.step);
 
-    // Create test executable
+    // Create test executable (the module root pulls in sync and pool)
     const tests = b.addTest(.{
-        .root_source_file = b.path("src/grainmirror.zig"),
-        .target = target,
-        .optimize = optimize,
+        .root_module = mirror_mod,
     });
 
     const run_tests = b.addRunArtifact(tests);
 
     const test_step = b.step("test", "Run tests");
     test_step.dependOn(&run_tests.step);
-
-    _ = mirror_mod;
 }
 
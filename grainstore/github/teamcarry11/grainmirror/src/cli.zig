@@ -11,7 +11,9 @@ pub fn main() !void {
     defer _ = gpa.deinit();
     const allocator = gpa.allocator();
     
-    const stdout = std.io.getStdOut().writer();
+    var stdout_buffer: [1024]u8 = undefined;
+    var stdout_writer = std.fs.File.stdout().writer(&stdout_buffer);
+    const stdout = &stdout_writer.interface;
     
     try stdout.print("grainmirror (work in progress)\n\n", .{});
     try stdout.print("This tool reads grainstore-manifest and clones/updates\n", .{});
@@ -21,6 +23,7 @@ pub fn main() !void {
     try stdout.print("Usage:\n", .{});
     try stdout.print("  grainmirror sync    # Sync all repos from manifest\n", .{});
     try stdout.print("  grainmirror status  # Show mirror status\n\n", .{});
+    try stdout.flush();
     
     _ = allocator;
 }
@@ -14,13 +14,20 @@ const std = @import("std");
 
 // Re-export our modules for external use.
 pub const sync = @import("sync.zig");
+pub const pool = @import("pool.zig");
 
 // Re-export functions for convenience.
 pub const sync_repo = sync.sync_repo;
+pub const mirror_one = sync.mirror_one;
+pub const mirror_all = pool.mirror_all;
+pub const Job = sync.Job;
+pub const Outcome = sync.Outcome;
+pub const Status = sync.Status;
 
 test "grainmirror module" {
     const testing = std.testing;
     _ = testing;
-    
+    _ = pool;
+
     // This test just ensures all modules compile and link.
 }
@@ -0,0 +1,177 @@
+//! pool: mirror many repositories at once
+//!
+//! each repo spends almost all its time waiting: on the network,
+//! on the disk, on a git process starting up. doing them one by
+//! one means hundreds of repos wait in a line!
+//!
+//! so we start a few workers. each worker grabs the next job from
+//! a shared counter (one atomic add, no locks), mirrors it, and
+//! grabs another. the number of workers is bounded, so we never
+//! start hundreds of git processes at the same time.
+
+const std = @import("std");
+const sync = @import("sync.zig");
+
+pub const Job = sync.Job;
+pub const Outcome = sync.Outcome;
+pub const Status = sync.Status;
+
+// Bounded: Max 64 workers (git processes running at once)
+pub const max_workers: u32 = 64;
+
+pub const Options = struct {
+    workers: u32 = 8,
+};
+
+// totals for a whole run. per-repo details stay in the outcomes.
+pub const Report = struct {
+    cloned: u32 = 0,
+    fetched: u32 = 0,
+    unchanged: u32 = 0,
+    failed: u32 = 0,
+    elapsed_ns: u64 = 0,
+    // the job that took longest (null when there were no jobs)
+    slowest: ?usize = null,
+};
+
+const Queue = struct {
+    allocator: std.mem.Allocator,
+    env: *const std.process.EnvMap,
+    jobs: []const Job,
+    outcomes: []Outcome,
+    next: std.atomic.Value(usize),
+
+    fn work(self: *Queue) void {
+        while (true) {
+            const i = self.next.fetchAdd(1, .monotonic);
+            if (i >= self.jobs.len) return;
+            self.outcomes[i] = sync.mirror_one(self.allocator, self.env, self.jobs[i]);
+        }
+    }
+};
+
+// mirror every job, `options.workers` at a time. outcomes[i] is
+// filled in for jobs[i]. failures don't stop the run, they're
+// counted in the report. `allocator` must be thread-safe.
+pub fn mirror_all(
+    allocator: std.mem.Allocator,
+    jobs: []const Job,
+    outcomes: []Outcome,
+    options: Options,
+) !Report {
+    std.debug.assert(outcomes.len == jobs.len);
+    const start = std.time.nanoTimestamp();
+
+    // git must never stop to ask for a password: a private or
+    // missing repo should just fail, not hang a worker forever.
+    var env = try std.process.getEnvMap(allocator);
+    defer env.deinit();
+    try env.put("GIT_TERMINAL_PROMPT", "0");
+
+    var queue = Queue{
+        .allocator = allocator,
+        .env = &env,
+        .jobs = jobs,
+        .outcomes = outcomes,
+        .next = std.atomic.Value(usize).init(0),
+    };
+
+    // the calling thread is a worker too.
+    const wanted = @max(1, @min(options.workers, max_workers, jobs.len));
+    var threads: [max_workers]std.Thread = undefined;
+    var spawned: usize = 0;
+    while (spawned + 1 < wanted) : (spawned += 1) {
+        threads[spawned] = std.Thread.spawn(.{}, Queue.work, .{&queue}) catch break;
+    }
+    queue.work();
+    for (threads[0..spawned]) |thread| thread.join();
+
+    var report = Report{};
+    for (outcomes, 0..) |outcome, i| {
+        switch (outcome.status) {
+            .cloned => report.cloned += 1,
+            .fetched => report.fetched += 1,
+            .unchanged => report.unchanged += 1,
+            .failed => report.failed += 1,
+        }
+        if (report.slowest == null or outcome.elapsed_ns > outcomes[report.slowest.?].elapsed_ns) {
+            report.slowest = i;
+        }
+    }
+    report.elapsed_ns = @intCast(std.time.nanoTimestamp() - start);
+    return report;
+}
+
+// test helper: run a command in `cwd`, fail the test if it fails.
+fn run(allocator: std.mem.Allocator, cwd: []const u8, argv: []const []const u8) !void {
+    const result = try std.process.Child.run(.{
+        .allocator = allocator,
+        .argv = argv,
+        .cwd = cwd,
+    });
+    defer allocator.free(result.stdout);
+    defer allocator.free(result.stderr);
+    if (result.term != .Exited or result.term.Exited != 0) {
+        std.debug.print("{s}\n", .{result.stderr});
+        return error.CommandFailed;
+    }
+}
+
+test "pool - mirrors local bare repositories incrementally" {
+    const testing = std.testing;
+    const allocator = testing.allocator;
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const base = try tmp.dir.realpathAlloc(allocator, ".");
+    defer allocator.free(base);
+
+    // a seed repo with one commit, cloned into 4 bare "remotes"
+    const commit = &[_][]const u8{ "git", "-C", "seed", "-c", "user.name=grain", "-c", "user.email=grain@example.invalid", "commit", "-q", "-am", "update" };
+    try run(allocator, base, &.{ "git", "init", "-q", "-b", "main", "seed" });
+    try tmp.dir.writeFile(.{ .sub_path = "seed/readme", .data = "one\n" });
+    try run(allocator, base, &.{ "git", "-C", "seed", "add", "readme" });
+    try run(allocator, base, commit);
+
+    const repo_count = 4;
+    var urls: [repo_count + 1][]u8 = undefined;
+    var paths: [repo_count + 1][]u8 = undefined;
+    var jobs: [repo_count + 1]Job = undefined;
+    for (0..repo_count + 1) |i| {
+        urls[i] = try std.fmt.allocPrint(allocator, "{s}/remote/r{d}.git", .{ base, i });
+        paths[i] = try std.fmt.allocPrint(allocator, "{s}/mirror/github/org/r{d}", .{ base, i });
+        jobs[i] = .{ .url = urls[i], .path = paths[i] };
+        // the last remote never exists: its job must fail
+        if (i < repo_count) try run(allocator, base, &.{ "git", "clone", "-q", "--bare", "seed", urls[i] });
+    }
+    defer for (urls, paths) |url, path| {
+        allocator.free(url);
+        allocator.free(path);
+    };
+
+    var outcomes: [repo_count + 1]Outcome = undefined;
+
+    // first run: everything is cloned (except the missing one)
+    var report = try mirror_all(allocator, &jobs, &outcomes, .{ .workers = 3 });
+    try testing.expectEqual(@as(u32, repo_count), report.cloned);
+    try testing.expectEqual(@as(u32, 1), report.failed);
+    try testing.expect(outcomes[repo_count].message().len > 0);
+
+    // second run: nothing changed upstream, so nothing is fetched
+    report = try mirror_all(allocator, jobs[0..repo_count], outcomes[0..repo_count], .{ .workers = 3 });
+    try testing.expectEqual(@as(u32, repo_count), report.unchanged);
+
+    // push a new commit to one remote: only that one is pulled
+    try tmp.dir.writeFile(.{ .sub_path = "seed/readme", .data = "two\n" });
+    try run(allocator, base, commit);
+    try run(allocator, base, &.{ "git", "-C", "seed", "push", "-q", urls[1], "main" });
+
+    report = try mirror_all(allocator, jobs[0..repo_count], outcomes[0..repo_count], .{ .workers = 3 });
+    try testing.expectEqual(@as(u32, 1), report.fetched);
+    try testing.expectEqual(@as(u32, repo_count - 1), report.unchanged);
+    try testing.expectEqual(Status.fetched, outcomes[1].status);
+
+    var buf: [16]u8 = undefined;
+    const readme = try tmp.dir.readFile("mirror/github/org/r1/readme", &buf);
+    try testing.expectEqualStrings("two\n", readme);
+}
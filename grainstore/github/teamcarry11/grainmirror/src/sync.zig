@@ -2,13 +2,86 @@
 //!
 //! This module handles the actual cloning and updating of
 //! external repositories specified in the manifest.
+//!
+//! one repo at a time, the steps are:
+//!   1. ask the remote for its refs (`git ls-remote`) and hash them
+//!   2. missing locally? clone it
+//!   3. present and the hash matches the one we saved last time?
+//!      nothing changed upstream, so skip it (no fetch at all!)
+//!   4. otherwise pull (fast-forward only) and save the new hash
+//!
+//! step 3 is the big win: refreshing hundreds of mirrors where only
+//! a few changed costs one small ls-remote each, not a full fetch.
 
 const std = @import("std");
 
+// where we remember the remote refs hash, inside the clone's .git
+// directory so it never shows up as a file in the mirror.
+const stamp_name = ".git/grainmirror-refs";
+
+// git output we keep: ls-remote of a big repo is a few MB at most.
+const max_output_bytes: usize = 64 * 1024 * 1024;
+
+// Bounded: Max 256 bytes of git's error output kept per repo
+pub const max_message_len: usize = 256;
+
+pub const Status = enum {
+    cloned,
+    fetched,
+    unchanged,
+    failed,
+};
+
+// one repo to mirror: where it comes from, where it goes.
+// `url` can be anything git understands, including a local path
+// (that's how the tests use bare repositories).
+pub const Job = struct {
+    url: []const u8,
+    path: []const u8,
+};
+
+// what happened to one repo, and how long it took.
+pub const Outcome = struct {
+    status: Status = .failed,
+    elapsed_ns: u64 = 0,
+    message_buf: [max_message_len]u8 = undefined,
+    message_len: u16 = 0,
+
+    // why it failed (the end of git's stderr), empty otherwise.
+    pub fn message(self: *const Outcome) []const u8 {
+        return self.message_buf[0..self.message_len];
+    }
+
+    fn set_message(self: *Outcome, text: []const u8) void {
+        const trimmed = std.mem.trim(u8, text, " \t\r\n");
+        // keep the end: git puts the useful line last.
+        const tail = trimmed[trimmed.len -| max_message_len..];
+        @memcpy(self.message_buf[0..tail.len], tail);
+        self.message_len = @intCast(tail.len);
+    }
+};
+
+// build the https url for a manifest entry.
+// example: ("github", "tigerbeetle", "tigerbeetle")
+//   → "https://github.com/tigerbeetle/tigerbeetle.git"
+pub fn repo_url(
+    allocator: std.mem.Allocator,
+    platform: []const u8,
+    org: []const u8,
+    repo: []const u8,
+) ![]u8 {
+    return std.fmt.allocPrint(
+        allocator,
+        "https://{s}.com/{s}/{s}.git",
+        .{ platform, org, repo },
+    );
+}
+
 // Sync a single repository from manifest specification.
 //
 // If the repository doesn't exist locally, clone it.
-// If it already exists, pull latest changes.
+// If it already exists, pull latest changes (skipped when
+// the remote refs are unchanged since the last sync).
 //
 // Returns true if sync succeeded, false otherwise.
 pub fn sync_repo(
@@ -18,19 +91,93 @@ pub fn sync_repo(
     repo: []const u8,
     target_path: []const u8,
 ) !bool {
-    // Construct source URL
-    const url = try std.fmt.allocPrint(
-        allocator,
-        "https://{s}.com/{s}/{s}.git",
-        .{ platform, org, repo },
-    );
+    const url = try repo_url(allocator, platform, org, repo);
     defer allocator.free(url);
-    
-    // TODO: Check if path exists
-    // TODO: If not, git clone
-    // TODO: If yes, git pull
-    
-    _ = target_path;
-    
-    return true; // work in progress
+
+    const outcome = mirror_one(allocator, null, .{
+        .url = url,
+        .path = target_path,
+    });
+    return outcome.status != .failed;
+}
+
+// mirror one repo and report what happened. never returns an
+// error: failures are recorded in the outcome, so one bad repo
+// can't stop a whole manifest refresh.
+//
+// `env` is passed to every git process (null = inherit ours).
+// `allocator` must be thread-safe when called from several workers.
+pub fn mirror_one(
+    allocator: std.mem.Allocator,
+    env: ?*const std.process.EnvMap,
+    job: Job,
+) Outcome {
+    const start = std.time.nanoTimestamp();
+    var outcome = Outcome{};
+    outcome.status = run_job(allocator, env, job, &outcome) catch |err| blk: {
+        if (outcome.message_len == 0) outcome.set_message(@errorName(err));
+        break :blk .failed;
+    };
+    outcome.elapsed_ns = @intCast(std.time.nanoTimestamp() - start);
+    return outcome;
+}
+
+fn run_job(
+    allocator: std.mem.Allocator,
+    env: ?*const std.process.EnvMap,
+    job: Job,
+    outcome: *Outcome,
+) !Status {
+    const refs = try git(allocator, env, &.{ "git", "ls-remote", "--quiet", "--", job.url }, outcome);
+    defer allocator.free(refs);
+    var digest: [std.crypto.hash.sha2.Sha256.digest_length]u8 = undefined;
+    std.crypto.hash.sha2.Sha256.hash(refs, &digest, .{});
+    const stamp = std.fmt.bytesToHex(digest, .lower);
+
+    const stamp_path = try std.fs.path.join(allocator, &.{ job.path, stamp_name });
+    defer allocator.free(stamp_path);
+    const git_dir = std.fs.path.dirname(stamp_path).?;
+    const cwd = std.fs.cwd();
+
+    var status: Status = undefined;
+    if (cwd.access(git_dir, .{})) |_| {
+        var saved: [stamp.len]u8 = undefined;
+        if (cwd.readFile(stamp_path, &saved)) |bytes| {
+            if (std.mem.eql(u8, bytes, &stamp)) return .unchanged;
+        } else |_| {}
+        const out = try git(allocator, env, &.{ "git", "-C", job.path, "pull", "--ff-only", "--quiet" }, outcome);
+        allocator.free(out);
+        status = .fetched;
+    } else |_| {
+        if (std.fs.path.dirname(job.path)) |parent| try cwd.makePath(parent);
+        const out = try git(allocator, env, &.{ "git", "clone", "--quiet", "--", job.url, job.path }, outcome);
+        allocator.free(out);
+        status = .cloned;
+    }
+    try cwd.writeFile(.{ .sub_path = stamp_path, .data = &stamp });
+    return status;
+}
+
+// run git and return its stdout (caller frees). on failure the
+// end of stderr goes into the outcome message.
+fn git(
+    allocator: std.mem.Allocator,
+    env: ?*const std.process.EnvMap,
+    argv: []const []const u8,
+    outcome: *Outcome,
+) ![]u8 {
+    const result = try std.process.Child.run(.{
+        .allocator = allocator,
+        .argv = argv,
+        .env_map = env,
+        .max_output_bytes = max_output_bytes,
+    });
+    defer allocator.free(result.stderr);
+    switch (result.term) {
+        .Exited => |code| if (code == 0) return result.stdout,
+        else => {},
+    }
+    allocator.free(result.stdout);
+    outcome.set_message(result.stderr);
+    return error.GitFailed;
 }
@@ -1,7 +1,7 @@
 //! grainorder: permutation-based chronological file naming
 //!
 //! this is the main module that brings together all the pieces:
-//! alphabet, core algorithm, and validation.
+//! alphabet, core algorithm, rank/unrank, and validation.
 //!
 //! **what is grainorder?**
 //!
@@ -62,6 +62,7 @@ const std = @import("std");
 pub const alphabet = @import("alphabet.zig");
 pub const core = @import("core.zig");
 pub const validation = @import("validation.zig");
+pub const rank = @import("rank.zig");
 
 // re-export the main types
 pub const Grainorder = core.Grainorder;
@@ -73,6 +74,13 @@ pub const from_string = core.Grainorder.from_string;
 pub const is_valid = validation.is_valid;
 pub const validate = validation.validate;
 
+// jump around without stepping: rank ↔ code, k-th code,
+// distance, and whole blocks of codes at once
+pub const unrank = rank.unrank;
+pub const nth = rank.nth;
+pub const distance = rank.distance;
+pub const Sequence = rank.Sequence;
+
 // constants for easy reference
 pub const ALPHABET = alphabet.alphabet;
 pub const CODE_LEN = alphabet.code_len;
@@ -88,5 +96,6 @@ test {
     std.testing.refAllDecls(alphabet);
     std.testing.refAllDecls(core);
     std.testing.refAllDecls(validation);
+    std.testing.refAllDecls(rank);
 }
 
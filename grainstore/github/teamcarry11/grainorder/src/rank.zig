@@ -0,0 +1,272 @@
+//! rank: every grainorder has a number
+//!
+//! `prev` walks one code at a time. that's perfect for naming
+//! the next file, but what if a tool needs to name 5,000 files?
+//! or wants to know how far apart two codes are? stepping
+//! through 332,640 codes one by one is way too slow!
+//!
+//! here's the trick: the codes are already in alphabetical
+//! order, so each one has a position (its "rank"):
+//!   bchlnp → 0       (the absolute minimum)
+//!   bchlnq → 1
+//!   ...
+//!   zyxsqp → 332,639 (the archive code, largest possible)
+//!
+//! and `prev` is just "rank minus one"! so if we can turn a
+//! code into its rank (and back), jumping k codes or measuring
+//! a distance is plain subtraction.
+//!
+//! how do we compute the rank? with a "lehmer code" - think of
+//! it like place value again, but each place has a different
+//! size. the letter at index 0 picks one of 11 letters, and
+//! each choice there skips over 10×9×8×7×6 = 30,240 codes.
+//! the letter at index 1 picks one of the 10 letters left,
+//! and each choice skips 9×8×7×6 = 3,024 codes. and so on!
+//!
+//! the "digit" at each place is: how many UNUSED letters are
+//! smaller than this one? we keep the used letters in an
+//! 11-bit mask, so that's one popcount. no searching! 🌾
+
+const std = @import("std");
+const alphabet = @import("alphabet.zig");
+const Grainorder = @import("core.zig").Grainorder;
+
+// one bit per alphabet letter: bit 0 = 'b', bit 10 = 'z'
+const Mask = u16;
+const full_mask: Mask = (1 << alphabet.alphabet_len) - 1;
+
+// how many codes each choice skips at each index.
+// index 5 (the "ones place") skips 1, index 4 skips 6 (the
+// 6 letters still free for index 5), and so on leftward.
+pub const place_weights: [alphabet.code_len]u32 = blk: {
+    var weights: [alphabet.code_len]u32 = undefined;
+    var weight: u32 = 1;
+    var i: usize = alphabet.code_len;
+    while (i > 0) {
+        i -= 1;
+        weights[i] = weight;
+        weight *= @intCast(alphabet.alphabet_len - i);
+    }
+    std.debug.assert(weight == alphabet.max_codes);
+    break :blk weights;
+};
+
+// letter → alphabet index in one lookup (0xFF = not a letter).
+// `char_position` searches the alphabet; this just looks it up.
+const letter_index: [256]u8 = blk: {
+    var table = [_]u8{0xFF} ** 256;
+    for (alphabet.alphabet, 0..) |c, i| table[c] = @intCast(i);
+    break :blk table;
+};
+
+// find the n-th set bit in a mask (n = 0 means the lowest).
+// we clear the lowest bit n times, then count trailing zeros.
+// at most 10 steps, because there are only 11 letters!
+fn select_bit(mask: Mask, n: u32) u4 {
+    var m = mask;
+    var i: u32 = 0;
+    while (i < n) : (i += 1) m &= m - 1;
+    std.debug.assert(m != 0);
+    return @intCast(@ctz(m));
+}
+
+// turn a code into its position in alphabetical order.
+//
+// example: "bchlnq"
+//   'b' → 0 unused letters smaller → 0 × 30,240
+//   'c' → 0 (b is used)            → 0 × 3,024
+//   ... and 'q' at the ones place → 1 (p is free) → 1 × 1
+//   rank = 1. right after the minimum!
+pub fn rank(code: *const Grainorder) u32 {
+    std.debug.assert(code.is_valid());
+    var used: Mask = 0;
+    var result: u32 = 0;
+    for (code.chars, place_weights) |c, weight| {
+        const index: u4 = @intCast(letter_index[c]);
+        const bit: Mask = @as(Mask, 1) << index;
+        const smaller_used = @popCount(used & (bit - 1));
+        const digit: u32 = @as(u32, index) - smaller_used;
+        result += digit * weight;
+        used |= bit;
+    }
+    std.debug.assert(result < alphabet.max_codes);
+    return result;
+}
+
+// the other direction: position → code.
+//
+// at each index, divide by the place weight to get the digit,
+// then pick the digit-th letter that's still free.
+// returns null past the end (there are only 332,640 codes!).
+pub fn unrank(index: u32) ?Grainorder {
+    if (index >= alphabet.max_codes) return null;
+    var remaining = index;
+    var free: Mask = full_mask;
+    var result: Grainorder = undefined;
+    for (&result.chars, place_weights) |*c, weight| {
+        const digit = remaining / weight;
+        remaining %= weight;
+        const letter = select_bit(free, digit);
+        c.* = alphabet.alphabet[letter];
+        free &= ~(@as(Mask, 1) << letter);
+    }
+    std.debug.assert(result.is_valid());
+    return result;
+}
+
+// jump k codes newer at once: the same as calling prev() k
+// times, but it's just a subtraction! k = 0 gives the code
+// back. returns null if we'd run past the minimum.
+pub fn nth(code: *const Grainorder, k: u32) ?Grainorder {
+    const r = rank(code);
+    if (k > r) return null;
+    return unrank(r - k);
+}
+
+// how many prev() steps from `older` to `newer`?
+// negative means `newer` is actually the older code.
+pub fn distance(older: *const Grainorder, newer: *const Grainorder) i32 {
+    const a: i32 = @intCast(rank(older));
+    const b: i32 = @intCast(rank(newer));
+    return a - b;
+}
+
+// a contiguous run of codes handed out together.
+// code(0) is the oldest in the block, code(len - 1) the newest,
+// so naming files in order keeps newest-on-top sorting.
+pub const Block = struct {
+    first_rank: u32,
+    len: u32,
+
+    pub fn code(self: Block, i: u32) Grainorder {
+        std.debug.assert(i < self.len);
+        return unrank(self.first_rank - i).?;
+    }
+
+    // write every code in the block, oldest first.
+    pub fn fill(self: Block, out: []Grainorder) void {
+        std.debug.assert(out.len == self.len);
+        for (out, 0..) |*slot, i| slot.* = self.code(@intCast(i));
+    }
+};
+
+// hands out codes in blocks, continuing from the last one used.
+//
+// example: a tool renaming 5,000 files asks for one block of
+// 5,000 instead of calling prev() 5,000 times:
+//   var seq = Sequence.init(&latest);
+//   const block = seq.reserve(5000) orelse return error.OutOfCodes;
+pub const Sequence = struct {
+    // rank of the most recently handed-out code
+    last_rank: u32,
+
+    pub fn init(latest: *const Grainorder) Sequence {
+        return .{ .last_rank = rank(latest) };
+    }
+
+    // how many codes are still smaller than the last one?
+    pub fn remaining(self: *const Sequence) u32 {
+        return self.last_rank;
+    }
+
+    // reserve the next k codes (all newer than the last one).
+    // returns null (and reserves nothing) if fewer than k remain.
+    pub fn reserve(self: *Sequence, k: u32) ?Block {
+        if (k == 0 or k > self.last_rank) return null;
+        const block = Block{ .first_rank = self.last_rank - 1, .len = k };
+        self.last_rank -= k;
+        return block;
+    }
+
+    // the most recently handed-out code
+    pub fn last(self: *const Sequence) Grainorder {
+        return unrank(self.last_rank).?;
+    }
+};
+
+test "rank - endpoints" {
+    const testing = std.testing;
+
+    const minimum = try Grainorder.from_string("bchlnp");
+    try testing.expectEqual(@as(u32, 0), rank(&minimum));
+
+    const archive = try Grainorder.from_string("zyxsqp");
+    try testing.expectEqual(
+        @as(u32, alphabet.max_codes - 1),
+        rank(&archive),
+    );
+
+    const second = unrank(1).?;
+    try testing.expectEqualStrings("bchlnq", &second.chars);
+    try testing.expect(unrank(alphabet.max_codes) == null);
+}
+
+test "rank - round trip matches prev for every code" {
+    const testing = std.testing;
+
+    // walk the whole space once: unrank(rank(x)) == x, and
+    // prev() lands exactly one rank lower.
+    var index: u32 = 0;
+    while (index < alphabet.max_codes) : (index += 1) {
+        const code = unrank(index).?;
+        try testing.expectEqual(index, rank(&code));
+        if (index % 997 == 0) {
+            const previous = code.prev();
+            if (index == 0) {
+                try testing.expect(previous == null);
+            } else {
+                try testing.expectEqual(index - 1, rank(&previous.?));
+            }
+        }
+    }
+}
+
+test "rank - nth and distance" {
+    const testing = std.testing;
+
+    const start = try Grainorder.from_string("xsqynl");
+    var stepped = start;
+    var k: u32 = 0;
+    while (k < 500) : (k += 1) stepped = stepped.prev().?;
+
+    const jumped = nth(&start, 500).?;
+    const same = nth(&start, 0).?;
+    try testing.expectEqualStrings(&stepped.chars, &jumped.chars);
+    try testing.expectEqual(@as(i32, 500), distance(&start, &jumped));
+    try testing.expectEqual(@as(i32, -500), distance(&jumped, &start));
+    try testing.expectEqualStrings(&start.chars, &same.chars);
+
+    const minimum = try Grainorder.from_string("bchlnp");
+    try testing.expect(nth(&minimum, 1) == null);
+}
+
+test "rank - sequence hands out contiguous blocks" {
+    const testing = std.testing;
+
+    const latest = try Grainorder.from_string("zyxsqp");
+    var seq = Sequence.init(&latest);
+
+    var codes: [64]Grainorder = undefined;
+    const block = seq.reserve(codes.len).?;
+    block.fill(&codes);
+
+    // the block continues exactly where prev() would
+    var expected = latest;
+    for (codes) |code| {
+        expected = expected.prev().?;
+        try testing.expectEqualStrings(&expected.chars, &code.chars);
+    }
+    try testing.expectEqualStrings(&codes[63].chars, &seq.last().chars);
+
+    // the next block picks up right after this one
+    const next = seq.reserve(1).?.code(0);
+    const after = codes[63].prev().?;
+    try testing.expectEqualStrings(&after.chars, &next.chars);
+
+    // asking for more than remains reserves nothing
+    const remaining = seq.remaining();
+    try testing.expect(seq.reserve(remaining + 1) == null);
+    try testing.expectEqual(remaining, seq.remaining());
+    try testing.expect(seq.reserve(remaining) != null);
+    try testing.expectEqual(@as(u32, 0), seq.remaining());
+}
@@ -1,6 +1,8 @@
 const std = @import("std");
 const Editor = @import("aurora_editor.zig").Editor;
 const DreamBrowserViewport = @import("dream_browser_viewport.zig").DreamBrowserViewport;
+const SearchIndex = @import("aurora_search_index.zig").SearchIndex;
+const GrainBuffer = @import("grain_buffer.zig").GrainBuffer;
 
 /// Cross Integration: Enhanced communication between editor and browser.
 /// ~<~ Glow Airbend: explicit cross-component state, bounded operations.
@@ -9,7 +11,7 @@ const DreamBrowserViewport = @import("dream_browser_viewport.zig").DreamBrowserV
 /// This implements:
 /// - Shared clipboard/selection between editor and browser
 /// - URL/file navigation (click URL in editor to open in browser, click file path in browser to open in editor)
-/// - Search across both editor and browser tabs
+/// - Search across both editor and browser tabs (served from SearchIndex)
 /// - Cross-component state synchronization
 pub const CrossIntegration = struct {
     // Bounded: Max 1MB clipboard size
@@ -19,7 +21,7 @@ pub const CrossIntegration = struct {
     pub const MAX_URL_LENGTH: u32 = 4096;
     pub const MAX_FILE_PATH_LENGTH: u32 = 4096;
     
-    // Bounded: Max 100 search results
+    // Bounded: Max 100 search results per page
     pub const MAX_SEARCH_RESULTS: u32 = 100;
     
     /// Shared clipboard (for cross-component copy/paste).
@@ -36,6 +38,7 @@ pub const CrossIntegration = struct {
     };
     
     /// Search result (across editor and browser).
+    /// Text slices borrow the tab's buffer: valid until its next edit.
     pub const SearchResult = struct {
         component_type: ComponentType, // Editor or browser
         tab_id: u32, // Tab ID
@@ -44,6 +47,7 @@ pub const CrossIntegration = struct {
         match_end: u32, // End position in source
         context_before: []const u8, // Context before match
         context_after: []const u8, // Context after match
+        score: u32, // Ranking score (higher first)
     };
     
     /// Component type.
@@ -66,6 +70,7 @@ pub const CrossIntegration = struct {
     
     allocator: std.mem.Allocator,
     clipboard: ?Clipboard = null,
+    search_index: SearchIndex,
     
     /// Initialize cross integration.
     pub fn init(allocator: std.mem.Allocator) CrossIntegration {
@@ -75,15 +80,18 @@ pub const CrossIntegration = struct {
         return CrossIntegration{
             .allocator = allocator,
             .clipboard = null,
+            .search_index = SearchIndex.init(allocator),
         };
     }
     
     /// Deinitialize cross integration.
+    /// Editors still indexed must be unindexed first (they hold listeners).
     pub fn deinit(self: *CrossIntegration) void {
         // Free clipboard if exists
         if (self.clipboard) |*clipboard| {
             self.allocator.free(clipboard.text);
         }
+        self.search_index.deinit();
     }
     
     /// Copy text to shared clipboard from editor.
@@ -289,146 +297,85 @@ pub const CrossIntegration = struct {
         return null;
     }
     
-    /// Search across editor and browser tabs.
-    /// Note: Returns slice pointing to allocated array (caller must free).
-    pub fn search_cross_component(
-        self: *CrossIntegration,
-        query: []const u8,
-        editor_tabs: []const EditorTab,
-        browser_tabs: []const BrowserTab,
-    ) ![]const SearchResult {
-        // Assert: Query must be valid
-        std.debug.assert(query.len > 0);
-        std.debug.assert(query.len <= 1024); // Bounded query length
-        
-        // Count matches
-        var match_count: u32 = 0;
-        
-        // Search editor tabs
-        for (editor_tabs) |tab| {
-            const text = tab.editor.buffer.textSlice();
-            var pos: u32 = 0;
-            while (pos < text.len) {
-                if (std.mem.indexOfPos(u8, text, pos, query)) |match_pos| {
-                    match_count += 1;
-                    pos = match_pos + query.len;
-                    if (match_count >= MAX_SEARCH_RESULTS) break;
-                } else {
-                    break;
-                }
-            }
-            if (match_count >= MAX_SEARCH_RESULTS) break;
+    /// Index an editor tab; its buffer edits update the index from now on.
+    pub fn index_editor(self: *CrossIntegration, tab_id: u32, editor: *Editor) !void {
+        _ = try self.search_index.watch_buffer(.editor, tab_id, &editor.buffer);
+    }
+    
+    /// Stop indexing an editor tab (before closing or hibernating it).
+    pub fn unindex_editor(self: *CrossIntegration, tab_id: u32, editor: *Editor) void {
+        editor.buffer.edit_listener = null;
+        if (self.search_index.find_document(.editor, tab_id)) |doc| {
+            self.search_index.remove_document(doc);
         }
-        
-        // Search browser tabs
-        if (match_count < MAX_SEARCH_RESULTS) {
-            for (browser_tabs) |tab| {
-                // Search in URL
-                if (std.mem.indexOf(u8, tab.url, query) != null) {
-                    match_count += 1;
-                    if (match_count >= MAX_SEARCH_RESULTS) break;
-                }
-                
-                // Search in title
-                if (std.mem.indexOf(u8, tab.title, query) != null) {
-                    match_count += 1;
-                    if (match_count >= MAX_SEARCH_RESULTS) break;
-                }
+    }
+    
+    /// Index a browser page load (URL, title, and page text; all borrowed
+    /// until the next load of this tab or `unindex_browser`).
+    pub fn index_browser_page(
+        self: *CrossIntegration,
+        tab_id: u32,
+        url: []const u8,
+        title: []const u8,
+        page_text: []const u8,
+    ) !void {
+        const fields = [_]struct { source: SearchIndex.Source, text: []const u8 }{
+            .{ .source = .browser_url, .text = url },
+            .{ .source = .browser_title, .text = title },
+            .{ .source = .browser_page, .text = page_text },
+        };
+        for (fields) |field| {
+            if (self.search_index.find_document(field.source, tab_id)) |doc| {
+                try doc.load(field.text);
+            } else {
+                _ = try self.search_index.add_document(field.source, tab_id, field.text);
             }
         }
-        
-        if (match_count == 0) {
-            return &.{};
-        }
-        
-        // Allocate result array
-        const results = try self.allocator.alloc(SearchResult, match_count);
-        errdefer self.allocator.free(results);
-        
-        // Collect matches
-        var result_idx: u32 = 0;
-        
-        // Search editor tabs
-        for (editor_tabs, 0..) |tab, tab_idx| {
-            const text = tab.editor.buffer.textSlice();
-            var pos: u32 = 0;
-            while (pos < text.len and result_idx < match_count) {
-                if (std.mem.indexOfPos(u8, text, pos, query)) |match_pos| {
-                    const match_end = match_pos + query.len;
-                    const context_start = if (match_pos > 20) match_pos - 20 else 0;
-                    const context_end = @min(match_end + 20, text.len);
-                    
-                    const context_before = try self.allocator.dupe(u8, text[context_start..match_pos]);
-                    errdefer self.allocator.free(context_before);
-                    
-                    const context_after = try self.allocator.dupe(u8, text[match_end..context_end]);
-                    errdefer self.allocator.free(context_after);
-                    
-                    const match_text = try self.allocator.dupe(u8, text[match_pos..match_end]);
-                    errdefer self.allocator.free(match_text);
-                    
-                    results[result_idx] = SearchResult{
-                        .component_type = .editor,
-                        .tab_id = @intCast(tab_idx),
-                        .match_text = match_text,
-                        .match_start = match_pos,
-                        .match_end = match_end,
-                        .context_before = context_before,
-                        .context_after = context_after,
-                    };
-                    result_idx += 1;
-                    pos = match_end;
-                } else {
-                    break;
-                }
+    }
+    
+    /// Stop indexing a browser tab.
+    pub fn unindex_browser(self: *CrossIntegration, tab_id: u32) void {
+        const sources = [_]SearchIndex.Source{ .browser_url, .browser_title, .browser_page };
+        for (sources) |source| {
+            if (self.search_index.find_document(source, tab_id)) |doc| {
+                self.search_index.remove_document(doc);
             }
-            if (result_idx >= match_count) break;
         }
+    }
+    
+    /// Search across indexed editor and browser tabs.
+    /// Runs the query to completion and fills `results` with page
+    /// `page_index` (ranked, `results.len` per page). Nothing is copied:
+    /// result text borrows the tab buffers. Interactive callers that want
+    /// stale keystrokes cancelled drive `search_index` directly
+    /// (begin_search / continue_search / page).
+    pub fn search_cross_component(
+        self: *CrossIntegration,
+        query: []const u8,
+        page_index: u32,
+        results: []SearchResult,
+    ) ![]SearchResult {
+        // Assert: Query must be valid
+        std.debug.assert(query.len > 0);
+        std.debug.assert(query.len <= SearchIndex.MAX_QUERY_LENGTH);
+        std.debug.assert(results.len > 0 and results.len <= MAX_SEARCH_RESULTS);
         
-        // Search browser tabs
-        if (result_idx < match_count) {
-            for (browser_tabs, 0..) |tab, tab_idx| {
-                // Search in URL
-                if (std.mem.indexOf(u8, tab.url, query)) |match_pos| {
-                    const match_end = match_pos + query.len;
-                    const match_text = try self.allocator.dupe(u8, tab.url[match_pos..match_end]);
-                    errdefer self.allocator.free(match_text);
-                    
-                    results[result_idx] = SearchResult{
-                        .component_type = .browser,
-                        .tab_id = @intCast(tab_idx),
-                        .match_text = match_text,
-                        .match_start = match_pos,
-                        .match_end = match_end,
-                        .context_before = "",
-                        .context_after = "",
-                    };
-                    result_idx += 1;
-                    if (result_idx >= match_count) break;
-                }
-                
-                // Search in title
-                if (std.mem.indexOf(u8, tab.title, query)) |match_pos| {
-                    const match_end = match_pos + query.len;
-                    const match_text = try self.allocator.dupe(u8, tab.title[match_pos..match_end]);
-                    errdefer self.allocator.free(match_text);
-                    
-                    results[result_idx] = SearchResult{
-                        .component_type = .browser,
-                        .tab_id = @intCast(tab_idx),
-                        .match_text = match_text,
-                        .match_start = match_pos,
-                        .match_end = match_end,
-                        .context_before = "",
-                        .context_after = "",
-                    };
-                    result_idx += 1;
-                    if (result_idx >= match_count) break;
-                }
-            }
+        const ticket = try self.search_index.search(query);
+        const page = self.search_index.page(ticket, page_index, @intCast(results.len)).?;
+        for (page.hits, results[0..page.hits.len]) |hit, *result| {
+            const context = self.search_index.context(hit);
+            result.* = SearchResult{
+                .component_type = if (hit.source == .editor) .editor else .browser,
+                .tab_id = hit.tab_id,
+                .match_text = context.match,
+                .match_start = hit.start,
+                .match_end = hit.end,
+                .context_before = context.before,
+                .context_after = context.after,
+                .score = hit.score,
+            };
         }
-        
-        return results[0..result_idx];
+        return results[0..page.hits.len];
     }
     
     /// Get current timestamp (simplified).
@@ -437,17 +384,6 @@ pub const CrossIntegration = struct {
         const non_negative = if (timestamp < 0) 0 else @as(u64, @intCast(timestamp));
         return non_negative;
     }
-    
-    /// Editor tab reference (for search).
-    pub const EditorTab = struct {
-        editor: Editor,
-    };
-    
-    /// Browser tab reference (for search).
-    pub const BrowserTab = struct {
-        url: []const u8,
-        title: []const u8,
-    };
 };
 
 test "cross integration initialization" {
@@ -494,3 +430,31 @@ test "cross integration url extraction" {
     try std.testing.expect(std.mem.startsWith(u8, target.?.value, "https://"));
 }
 
+test "cross integration search" {
+    const allocator = std.testing.allocator;
+    var integration = CrossIntegration.init(allocator);
+    defer integration.deinit();
+    
+    // Editor tabs are indexed through their GrainBuffer (see index_editor).
+    var buffer = try GrainBuffer.fromSlice(allocator, "const grain = 1;\n");
+    defer buffer.deinit();
+    _ = try integration.search_index.watch_buffer(.editor, 1, &buffer);
+    defer buffer.edit_listener = null;
+    try integration.index_browser_page(2, "https://grain.example", "Grain", "about grain");
+    
+    var results: [8]CrossIntegration.SearchResult = undefined;
+    var found = try integration.search_cross_component("grain", 0, &results);
+    // Assert: URL, page, and editor hits (title is "Grain", case differs)
+    try std.testing.expectEqual(@as(usize, 3), found.len);
+    try std.testing.expect(found[0].component_type == .browser);
+    
+    // Assert: Buffer edits reach the index without re-registering
+    try buffer.insert(0, "// grain\n");
+    found = try integration.search_cross_component("grain", 0, &results);
+    try std.testing.expectEqual(@as(usize, 4), found.len);
+    try std.testing.expectEqualStrings("grain", found[1].match_text);
+    
+    integration.unindex_browser(2);
+    found = try integration.search_cross_component("grain", 0, &results);
+    try std.testing.expectEqual(@as(usize, 2), found.len);
+}
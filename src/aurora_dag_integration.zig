@@ -10,10 +10,18 @@ const TreeSitter = @import("aurora_tree_sitter.zig").TreeSitter;
 /// - AST nodes become DAG nodes (project-wide semantic graph)
 /// - Code edits become DAG events (HashDAG-style ordering)
 /// - Streaming updates (Hyperfiddle-style propagation)
+///
+/// Mapping is incremental. Each file keeps its source and an interval
+/// index of its AST spans with their DAG node IDs. An edit reparses only
+/// the lines around it and diffs those spans against the previous ones:
+/// unchanged spans keep their DAG node (even when shifted), changed spans
+/// rewrite theirs in place, and only those writes produce edit events.
 pub const EditorDagIntegration = struct {
     allocator: std.mem.Allocator,
     dag: DagCore,
     tree_sitter: TreeSitter,
+    files: std.StringHashMapUnmanaged(FileMap),
+    next_file_id: u32,
     
     // Bounded: Max 1,000 AST nodes per file
     pub const MAX_AST_NODES_PER_FILE: u32 = 1_000;
@@ -21,32 +29,153 @@ pub const EditorDagIntegration = struct {
     // Bounded: Max 100 code edits per second
     pub const MAX_EDITS_PER_SECOND: u32 = 100;
     
+    const NO_NODE: u32 = std.math.maxInt(u32);
+    
+    /// Kind of AST span (stored in its DAG payload).
+    pub const AstKind = enum(u8) {
+        source_file,
+        function,
+        type_definition,
+        other,
+        removed, // Span gone; DAG node kept for reuse
+        
+        fn fromType(node_type: []const u8) AstKind {
+            if (std.mem.eql(u8, node_type, "function")) return .function;
+            if (std.mem.eql(u8, node_type, "type_definition")) return .type_definition;
+            if (std.mem.eql(u8, node_type, "source_file")) return .source_file;
+            return .other;
+        }
+    };
+    
+    /// Compact binary DAG payload for an AST node (little-endian):
+    /// file_id:u32 kind:u8 reserved:[3]u8 span_len:u32 content_hash:u64.
+    /// Position-free, so a span shifted by an edit above it is unchanged.
+    /// The source_file record is followed by the file path.
+    pub const AstRecord = struct {
+        file_id: u32,
+        kind: AstKind,
+        span_len: u32,
+        content_hash: u64,
+        
+        pub const LEN: u32 = 20;
+        
+        pub fn encode(self: AstRecord, out: *[LEN]u8) void {
+            std.mem.writeInt(u32, out[0..4], self.file_id, .little);
+            out[4] = @intFromEnum(self.kind);
+            @memset(out[5..8], 0);
+            std.mem.writeInt(u32, out[8..12], self.span_len, .little);
+            std.mem.writeInt(u64, out[12..20], self.content_hash, .little);
+        }
+        
+        pub fn decode(bytes: []const u8) ?AstRecord {
+            if (bytes.len < LEN) return null;
+            return AstRecord{
+                .file_id = std.mem.readInt(u32, bytes[0..4], .little),
+                .kind = std.meta.intToEnum(AstKind, bytes[4]) catch return null,
+                .span_len = std.mem.readInt(u32, bytes[8..12], .little),
+                .content_hash = std.mem.readInt(u64, bytes[12..20], .little),
+            };
+        }
+    };
+    
+    /// One AST span in a file's interval index.
+    const Entry = struct {
+        start: u32,
+        end: u32,
+        // Distance back to the enclosing entry (0 = the source_file root).
+        up: u32,
+        dag_id: u32,
+        kind: AstKind,
+        content_hash: u64,
+    };
+    
+    /// Per-file mapping state.
+    const FileMap = struct {
+        file_id: u32,
+        source: std.ArrayListUnmanaged(u8) = .{},
+        // Sorted by start (then end descending); entries[0] is the root.
+        entries: std.ArrayListUnmanaged(Entry) = .{},
+        // DAG nodes of removed spans, reused before adding new nodes.
+        free_ids: std.ArrayListUnmanaged(u32) = .{},
+        
+        fn deinit(self: *FileMap, allocator: std.mem.Allocator) void {
+            self.source.deinit(allocator);
+            self.entries.deinit(allocator);
+            self.free_ids.deinit(allocator);
+        }
+    };
+    
+    /// Text edit in byte offsets of a file's current source.
+    pub const TextEdit = struct {
+        start: u32,
+        old_len: u32,
+        new_text: []const u8,
+    };
+    
+    /// What one remap did.
+    pub const RemapStats = struct {
+        kept: u32 = 0, // Reparsed spans matched by content (no DAG write)
+        updated: u32 = 0, // DAG nodes rewritten in place
+        created: u32 = 0, // DAG nodes added
+        removed: u32 = 0, // Spans that disappeared
+        reparsed_bytes: u32 = 0,
+    };
+    
+    /// Maps old source offsets to new ones across an edit.
+    const Shift = struct {
+        start: u32,
+        old_end: u32,
+        delta: i64,
+        
+        const none = Shift{ .start = NO_NODE, .old_end = NO_NODE, .delta = 0 };
+        
+        fn apply(self: Shift, pos: u32) u32 {
+            if (pos <= self.start) return pos;
+            if (pos < self.old_end) return self.start;
+            return @as(u32, @intCast(@as(i64, pos) + self.delta));
+        }
+    };
+    
+    const ContentKey = struct {
+        content_hash: u64,
+        kind: AstKind,
+    };
+    
     /// Initialize editor-DAG integration.
     pub fn init(allocator: std.mem.Allocator) !EditorDagIntegration {
-        // Assert: Allocator must be valid
-        std.debug.assert(allocator.ptr != null);
-        
-        const dag = try DagCore.init(allocator);
+        var dag = try DagCore.init(allocator);
         errdefer dag.deinit();
         
-        const tree_sitter = TreeSitter.init(allocator);
+        var tree_sitter = TreeSitter.init(allocator);
         errdefer tree_sitter.deinit();
         
         return EditorDagIntegration{
             .allocator = allocator,
             .dag = dag,
             .tree_sitter = tree_sitter,
+            .files = .{},
+            .next_file_id = 0,
         };
     }
     
     /// Deinitialize editor-DAG integration.
     pub fn deinit(self: *EditorDagIntegration) void {
+        var files = self.files.iterator();
+        while (files.next()) |file| {
+            file.value_ptr.deinit(self.allocator);
+            self.allocator.free(file.key_ptr.*);
+        }
+        self.files.deinit(self.allocator);
         self.dag.deinit();
         self.tree_sitter.deinit();
     }
     
     /// Parse source code and map AST nodes to DAG nodes.
-    /// Returns array of DAG node IDs for all AST nodes.
+    /// Returns array of DAG node IDs for all AST nodes (root first, caller frees).
+    ///
+    /// Re-mapping a file diffs the new source against the previous one and
+    /// remaps only the changed region (see `applyEdit`), so unchanged AST
+    /// nodes keep their DAG node IDs and the DAG does not grow per call.
     pub fn parseAndMapToDag(
         self: *EditorDagIntegration,
         source: []const u8,
@@ -56,71 +185,399 @@ pub const EditorDagIntegration = struct {
         std.debug.assert(source.len > 0);
         std.debug.assert(file_path.len > 0);
         
-        // Parse source code into AST
-        const tree = try self.tree_sitter.parseZig(source);
+        const file = try self.getOrCreateFile(file_path);
+        const old = file.source.items;
         
-        // Map AST nodes to DAG nodes
-        var node_ids = std.ArrayList(u32).init(self.allocator);
-        errdefer node_ids.deinit();
+        // The edit is whatever lies between the common prefix and suffix.
+        const prefix_len = std.mem.indexOfDiff(u8, old, source) orelse old.len;
+        if (prefix_len < old.len or prefix_len < source.len) {
+            const max_suffix = @min(old.len, source.len) - prefix_len;
+            var suffix_len: usize = 0;
+            while (suffix_len < max_suffix and
+                old[old.len - 1 - suffix_len] == source[source.len - 1 - suffix_len])
+            {
+                suffix_len += 1;
+            }
+            
+            // First mapping of a file is a load, not an edit: no events.
+            const is_edit = old.len > 0;
+            _ = try self.remap(file, TextEdit{
+                .start = @as(u32, @intCast(prefix_len)),
+                .old_len = @as(u32, @intCast(old.len - prefix_len - suffix_len)),
+                .new_text = source[prefix_len .. source.len - suffix_len],
+            }, &.{}, is_edit);
+        }
         
-        try self.mapAstNodeToDag(&tree.root, file_path, &node_ids);
+        const entries = file.entries.items;
+        const node_ids = try self.allocator.alloc(u32, entries.len);
+        for (entries, node_ids) |entry, *node_id| {
+            node_id.* = entry.dag_id;
+        }
         
         // Assert: Node count must be within bounds
-        std.debug.assert(node_ids.items.len <= MAX_AST_NODES_PER_FILE);
+        std.debug.assert(node_ids.len <= MAX_AST_NODES_PER_FILE);
         
-        return try node_ids.toOwnedSlice();
+        return node_ids;
     }
     
-    /// Recursively map AST node to DAG node.
-    fn mapAstNodeToDag(
+    /// Apply a text edit to a mapped file and remap only the AST spans it
+    /// touches. Emits one `mapEditToEvent` event per DAG node written; the
+    /// first carries the edit text and the rest reference it as a parent.
+    /// Reparsing and diffing follow the edited lines; the only per-file
+    /// work is shifting the offsets of spans after the edit.
+    pub fn applyEdit(
         self: *EditorDagIntegration,
-        ast_node: *const TreeSitter.Node,
         file_path: []const u8,
-        node_ids: *std.ArrayList(u32),
-    ) !void {
-        // Assert: Node IDs list must be within bounds
-        std.debug.assert(node_ids.items.len < MAX_AST_NODES_PER_FILE);
-        
-        // Create node data (AST node type + file path + position)
-        var node_data = std.ArrayList(u8).init(self.allocator);
-        defer node_data.deinit();
-        
-        const writer = node_data.writer();
-        try writer.print("{s}:{s}:{d}:{d}", .{
-            file_path,
-            ast_node.type,
-            ast_node.start_byte,
-            ast_node.end_byte,
+        edit: TextEdit,
+        parent_events: []const u64,
+    ) !RemapStats {
+        const file = self.files.getPtr(file_path) orelse return error.FileNotMapped;
+        
+        // Assert: Edit must be within the file
+        std.debug.assert(@as(u64, edit.start) + edit.old_len <= file.source.items.len);
+        
+        return self.remap(file, edit, parent_events, true);
+    }
+    
+    fn getOrCreateFile(self: *EditorDagIntegration, file_path: []const u8) !*FileMap {
+        if (self.files.getPtr(file_path)) |file| return file;
+        
+        const path = try self.allocator.dupe(u8, file_path);
+        errdefer self.allocator.free(path);
+        
+        var file = FileMap{ .file_id = self.next_file_id };
+        errdefer file.deinit(self.allocator);
+        
+        // Root node: source_file record followed by the path.
+        const data = try self.allocator.alloc(u8, AstRecord.LEN + path.len);
+        defer self.allocator.free(data);
+        const record = AstRecord{ .file_id = file.file_id, .kind = .source_file, .span_len = 0, .content_hash = 0 };
+        record.encode(data[0..AstRecord.LEN]);
+        @memcpy(data[AstRecord.LEN..], path);
+        const root_id = try self.dag.addNode(.ast_node, data, .{});
+        
+        try file.entries.append(self.allocator, Entry{
+            .start = 0,
+            .end = 0,
+            .up = 0,
+            .dag_id = root_id,
+            .kind = .source_file,
+            .content_hash = 0,
         });
+        try self.files.put(self.allocator, path, file);
+        self.next_file_id += 1;
         
-        // Create DAG node (AST node type)
-        const dag_node_id = try self.dag.addNode(
-            .ast_node,
-            try node_data.toOwnedSlice(),
-            .{
-                .is_readonly = false,
-                .readonly_start = ast_node.start_byte,
-                .readonly_end = ast_node.end_byte,
-                .metadata = try std.fmt.allocPrint(self.allocator, "file:{s},type:{s}", .{ file_path, ast_node.type }),
-                .metadata_len = 0, // Will be set after allocation
-            },
-        );
+        return self.files.getPtr(path).?;
+    }
+    
+    /// Apply `edit` to the file source, reparse the lines around it and
+    /// diff the reparsed spans against the old spans in that window.
+    /// On error the file's source, index and free list are left as they
+    /// were (DAG records written before the failure are not undone).
+    fn remap(
+        self: *EditorDagIntegration,
+        file: *FileMap,
+        edit: TextEdit,
+        parent_events: []const u64,
+        emit_events: bool,
+    ) !RemapStats {
+        const allocator = self.allocator;
+        var stats = RemapStats{};
+        const new_len = @as(u32, @intCast(edit.new_text.len));
+        const shift = Shift{
+            .start = edit.start,
+            .old_end = edit.start + edit.old_len,
+            .delta = @as(i64, new_len) - @as(i64, edit.old_len),
+        };
+        const edit_type: EditType = if (edit.old_len == 0) .insert else if (new_len == 0) .delete else .replace;
+        
+        // Keep the replaced text for edit events (sized by the edit).
+        const old_text = try allocator.dupe(u8, file.source.items[shift.start..shift.old_end]);
+        defer allocator.free(old_text);
+        const parents = try allocator.alloc(u64, parent_events.len + 1);
+        defer allocator.free(parents);
+        @memcpy(parents[0..parent_events.len], parent_events);
+        var text = EventText{
+            .edit_type = edit_type,
+            .old_text = old_text,
+            .new_text = edit.new_text,
+            .parents = parents,
+        };
+        
+        // Why: Reserve both ways so applying and undoing cannot fail.
+        const old_source_len = file.source.items.len;
+        try file.source.ensureTotalCapacity(allocator, @max(old_source_len, old_source_len - edit.old_len + new_len));
+        file.source.replaceRangeAssumeCapacity(edit.start, edit.old_len, edit.new_text);
+        errdefer file.source.replaceRangeAssumeCapacity(edit.start, new_len, old_text);
+        const source = file.source.items;
+        const old_entries = file.entries.items;
+        
+        // Window: whole lines around the edit, grown until no old span
+        // straddles it and every reparsed span ends inside it.
+        // Spans nest, so a span straddling a window edge encloses the last
+        // span starting before that edge: only that span and its `up`
+        // chain are checked (binary search plus nesting depth per pass).
+        var window_start = lineStart(source, edit.start);
+        var window_end = lineEnd(source, edit.start + new_len);
+        var nodes: []const TreeSitter.Node = &.{};
+        defer allocator.free(nodes);
+        while (true) {
+            var grown = true;
+            while (grown) {
+                grown = false;
+                for ([_]u32{ window_start, window_end }) |edge| {
+                    var index = lowerBound(old_entries, shift, edge) - 1;
+                    while (index > 0) {
+                        const entry = old_entries[index];
+                        const start = shift.apply(entry.start);
+                        const end = shift.apply(entry.end);
+                        if (end > edge and (start < window_start or end > window_end)) {
+                            window_start = lineStart(source, @min(window_start, start));
+                            window_end = lineEnd(source, @max(window_end, end));
+                            grown = true;
+                        }
+                        index = if (entry.up == 0) 0 else index - entry.up;
+                    }
+                }
+            }
+            
+            nodes = try self.tree_sitter.parseZigRange(source, window_start, window_end);
+            var max_end = window_end;
+            for (nodes) |node| max_end = @max(max_end, node.end_byte);
+            if (max_end <= window_end) break;
+            
+            // A reparsed span runs past the window (e.g. a deleted brace).
+            allocator.free(nodes);
+            nodes = &.{};
+            window_end = lineEnd(source, max_end);
+        }
+        stats.reparsed_bytes = window_end - window_start;
+        
+        // Old spans in the window are contiguous in the index.
+        const first = lowerBound(old_entries, shift, window_start);
+        const last = lowerBound(old_entries, shift, window_end);
+        const old_spans = old_entries[first..last];
+        
+        const spans = try allocator.alloc(Entry, nodes.len);
+        defer allocator.free(spans);
+        for (nodes, spans) |node, *span| {
+            span.* = Entry{
+                .start = node.start_byte,
+                .end = node.end_byte,
+                .up = 0,
+                .dag_id = NO_NODE,
+                .kind = AstKind.fromType(node.type),
+                .content_hash = std.hash.Wyhash.hash(0, source[node.start_byte..node.end_byte]),
+            };
+        }
+        std.mem.sort(Entry, spans, {}, entryLessThan);
+        
+        const old_taken = try allocator.alloc(bool, old_spans.len);
+        defer allocator.free(old_taken);
+        @memset(old_taken, false);
+        
+        // Reserve the index splice and the free list before any DAG write.
+        try file.entries.ensureUnusedCapacity(allocator, spans.len -| old_spans.len);
+        try file.free_ids.ensureUnusedCapacity(allocator, old_spans.len);
+        
+        // Pass 1: identical content keeps its DAG node, no write.
+        // Same-content old spans are chained in order through `next_same`.
+        const next_same = try allocator.alloc(u32, old_spans.len);
+        defer allocator.free(next_same);
+        var by_content = std.AutoHashMapUnmanaged(ContentKey, u32){};
+        defer by_content.deinit(allocator);
+        var index = old_spans.len;
+        while (index > 0) {
+            index -= 1;
+            const key = ContentKey{ .content_hash = old_spans[index].content_hash, .kind = old_spans[index].kind };
+            const slot = try by_content.getOrPut(allocator, key);
+            next_same[index] = if (slot.found_existing) slot.value_ptr.* else NO_NODE;
+            slot.value_ptr.* = @as(u32, @intCast(index));
+        }
+        for (spans) |*span| {
+            const head = by_content.getPtr(ContentKey{ .content_hash = span.content_hash, .kind = span.kind }) orelse continue;
+            if (head.* == NO_NODE) continue;
+            old_taken[head.*] = true;
+            span.dag_id = old_spans[head.*].dag_id;
+            head.* = next_same[head.*];
+            stats.kept += 1;
+        }
+        
+        // Pass 2: a changed span takes the next unmatched old span of the
+        // same kind, in order (the function being typed in keeps its ID).
+        var cursors = [_]usize{0} ** std.meta.fields(AstKind).len;
+        for (spans) |*span| {
+            if (span.dag_id != NO_NODE) continue;
+            const cursor = &cursors[@intFromEnum(span.kind)];
+            while (cursor.* < old_spans.len and
+                (old_taken[cursor.*] or old_spans[cursor.*].kind != span.kind))
+            {
+                cursor.* += 1;
+            }
+            if (cursor.* == old_spans.len) continue;
+            old_taken[cursor.*] = true;
+            span.dag_id = old_spans[cursor.*].dag_id;
+            try self.writeSpan(file, span.*, &text, emit_events);
+            stats.updated += 1;
+        }
         
-        // Metadata length is set during allocation in addNode
+        // Old spans left over are gone: their DAG nodes become reusable.
+        // Appends precede pops and fit the reservation, so restoring the
+        // length restores the list.
+        const free_before = file.free_ids.items.len;
+        errdefer file.free_ids.items.len = free_before;
+        for (old_spans, old_taken) |old_span, taken| {
+            if (taken) continue;
+            file.free_ids.appendAssumeCapacity(old_span.dag_id);
+            stats.removed += 1;
+        }
         
-        try node_ids.append(dag_node_id);
+        // New spans left over reuse a free DAG node or add one.
+        const root_id = old_entries[0].dag_id;
+        for (spans) |*span| {
+            if (span.dag_id != NO_NODE) continue;
+            if (file.free_ids.items.len > 0) {
+                span.dag_id = file.free_ids.items[file.free_ids.items.len - 1];
+                file.free_ids.items.len -= 1;
+                stats.updated += 1;
+            } else {
+                var bytes: [AstRecord.LEN]u8 = undefined;
+                spanRecord(file, span.*).encode(&bytes);
+                span.dag_id = try self.dag.addNode(.ast_node, &bytes, .{});
+                try self.dag.addEdge(root_id, span.dag_id, .dependency);
+                stats.created += 1;
+            }
+            try self.writeSpan(file, span.*, &text, emit_events);
+        }
         
-        // Recursively map children
-        for (ast_node.children) |child| {
-            try self.mapAstNodeToDag(&child, file_path, node_ids);
+        // Mark removed DAG nodes that were not reused.
+        for (file.free_ids.items[@min(free_before, file.free_ids.items.len)..]) |dag_id| {
+            var bytes: [AstRecord.LEN]u8 = undefined;
+            const record = AstRecord{ .file_id = file.file_id, .kind = .removed, .span_len = 0, .content_hash = 0 };
+            record.encode(&bytes);
+            try self.dag.updateNode(dag_id, &bytes);
         }
         
-        // Create edges (parent-child relationships)
-        if (node_ids.items.len > 1) {
-            const parent_id = node_ids.items[node_ids.items.len - 2];
-            const child_id = node_ids.items[node_ids.items.len - 1];
-            try self.dag.addEdge(parent_id, child_id, .dependency);
+        // Splice the window into the index and shift the spans after it.
+        // Spans outside the window neither enclose nor sit inside it, so
+        // only the window's `up` links need rebuilding.
+        file.entries.replaceRangeAssumeCapacity(first, last - first, spans);
+        const entries = file.entries.items;
+        for (entries[first + spans.len ..]) |*entry| {
+            entry.start = shift.apply(entry.start);
+            entry.end = shift.apply(entry.end);
+        }
+        entries[0].end = @as(u32, @intCast(source.len));
+        linkEnclosing(entries, first, first + spans.len);
+        
+        // Assert: Node count must be within bounds
+        std.debug.assert(entries.len <= MAX_AST_NODES_PER_FILE);
+        
+        return stats;
+    }
+    
+    /// Edit text shared by one remap's span events: the first event
+    /// carries it, later ones carry no text and list that event as their
+    /// last parent.
+    const EventText = struct {
+        edit_type: EditType,
+        old_text: []const u8,
+        new_text: []const u8,
+        parents: []u64, // Caller's parents plus one slot for the carrier
+        carrier: ?u64 = null,
+    };
+    
+    /// Write a span's record to its DAG node and emit the edit event.
+    fn writeSpan(
+        self: *EditorDagIntegration,
+        file: *const FileMap,
+        span: Entry,
+        text: *EventText,
+        emit_event: bool,
+    ) !void {
+        var bytes: [AstRecord.LEN]u8 = undefined;
+        spanRecord(file, span).encode(&bytes);
+        try self.dag.updateNode(span.dag_id, &bytes);
+        
+        if (!emit_event) return;
+        // Bounded: flush before the pending event buffer fills (flushed
+        // IDs are reused, so the next event carries the text again)
+        if (self.dag.pending_events_len == DagCore.MAX_PENDING_EVENTS) {
+            try self.dag.processEvents();
+            text.carrier = null;
         }
+        const own_parents = text.parents[0 .. text.parents.len - 1];
+        if (text.carrier) |carrier| {
+            text.parents[text.parents.len - 1] = carrier;
+            _ = try self.mapEditToEvent(span.dag_id, text.edit_type, "", "", text.parents);
+        } else {
+            text.carrier = try self.mapEditToEvent(span.dag_id, text.edit_type, text.old_text, text.new_text, own_parents);
+        }
+    }
+    
+    fn spanRecord(file: *const FileMap, span: Entry) AstRecord {
+        return AstRecord{
+            .file_id = file.file_id,
+            .kind = span.kind,
+            .span_len = span.end - span.start,
+            .content_hash = span.content_hash,
+        };
+    }
+    
+    fn entryLessThan(_: void, a: Entry, b: Entry) bool {
+        if (a.start != b.start) return a.start < b.start;
+        return a.end > b.end;
+    }
+    
+    /// First non-root entry whose (shifted) start is at or after `pos`.
+    fn lowerBound(entries: []const Entry, shift: Shift, pos: u32) usize {
+        var low: usize = 1;
+        var high: usize = entries.len;
+        while (low < high) {
+            const mid = low + (high - low) / 2;
+            if (shift.apply(entries[mid].start) < pos) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+    
+    /// Set `up` links for entries[from..to]: each points back to the
+    /// nearest earlier entry that encloses it, or 0 for the root.
+    fn linkEnclosing(entries: []Entry, from: usize, to: usize) void {
+        // Bounded: Max nesting depth tracked (deeper spans link outward)
+        var stack: [TreeSitter.MAX_DEPTH]usize = undefined;
+        var stack_len: usize = 0;
+        
+        for (from..to) |index| {
+            const entry = &entries[index];
+            while (stack_len > 0) {
+                const top = entries[stack[stack_len - 1]];
+                if (top.end > entry.start and top.end >= entry.end) break;
+                stack_len -= 1;
+            }
+            entry.up = if (stack_len == 0) 0 else @as(u32, @intCast(index - stack[stack_len - 1]));
+            
+            if (stack_len == stack.len) {
+                std.mem.copyForwards(usize, stack[0 .. stack.len - 1], stack[1..]);
+                stack_len -= 1;
+            }
+            stack[stack_len] = index;
+            stack_len += 1;
+        }
+    }
+    
+    fn lineStart(source: []const u8, pos: u32) u32 {
+        const newline = std.mem.lastIndexOfScalar(u8, source[0..pos], '\n') orelse return 0;
+        return @as(u32, @intCast(newline + 1));
+    }
+    
+    /// End of the line containing `pos`, just past its newline.
+    fn lineEnd(source: []const u8, pos: u32) u32 {
+        const newline = std.mem.indexOfScalarPos(u8, source, pos, '\n') orelse return @as(u32, @intCast(source.len));
+        return @as(u32, @intCast(newline + 1));
     }
     
     /// Map code edit to DAG event (HashDAG-style).
@@ -139,16 +596,14 @@ pub const EditorDagIntegration = struct {
         // Assert: Edit rate must be within bounds
         // TODO: Implement rate limiting
         
-        // Create event data (edit type + old text + new text)
-        var event_data = std.ArrayList(u8).init(self.allocator);
-        defer event_data.deinit();
-        
-        const writer = event_data.writer();
-        try writer.print("{s}:", .{@tagName(edit_type)});
-        try writer.print("old:{d}:", .{old_text.len});
-        try writer.print("new:{d}:", .{new_text.len});
-        try writer.writeAll(old_text);
-        try writer.writeAll(new_text);
+        // Event data, binary: edit_type:u8 old_len:u32 new_len:u32 old new
+        const event_data = try self.allocator.alloc(u8, 9 + old_text.len + new_text.len);
+        defer self.allocator.free(event_data);
+        event_data[0] = @intFromEnum(edit_type);
+        std.mem.writeInt(u32, event_data[1..5], @as(u32, @intCast(old_text.len)), .little);
+        std.mem.writeInt(u32, event_data[5..9], @as(u32, @intCast(new_text.len)), .little);
+        @memcpy(event_data[9..][0..old_text.len], old_text);
+        @memcpy(event_data[9 + old_text.len ..], new_text);
         
         // Map edit type to event type
         const event_type: DagCore.EventType = switch (edit_type) {
@@ -162,7 +617,7 @@ pub const EditorDagIntegration = struct {
         const event_id = try self.dag.addEvent(
             event_type,
             node_id,
-            try event_data.toOwnedSlice(),
+            event_data,
             parent_events,
         );
         
@@ -173,7 +628,7 @@ pub const EditorDagIntegration = struct {
     }
     
     /// Type of code edit.
-    pub const EditType = enum {
+    pub const EditType = enum(u8) {
         insert, // Insert text
         delete, // Delete text
         replace, // Replace text
@@ -190,22 +645,20 @@ pub const EditorDagIntegration = struct {
     }
     
     /// Get project-wide semantic graph (Matklad vision).
-    /// Returns count of AST nodes in the DAG (across all files).
+    /// Returns count of live AST nodes in the DAG (across all files).
     pub fn getSemanticGraphNodeCount(self: *const EditorDagIntegration) u32 {
-        // Count AST nodes in the DAG
-        const nodes = self.dag.nodes[0..self.dag.nodes_len];
         var count: u32 = 0;
-        
-        for (nodes) |node| {
-            if (node.node_type == .ast_node) {
-                count += 1;
-            }
+        var files = self.files.valueIterator();
+        while (files.next()) |file| {
+            count += @as(u32, @intCast(file.entries.items.len));
         }
         
         return count;
     }
     
     /// Find DAG node by file path and byte position (for navigation, hover).
+    /// Returns the innermost AST span covering the position (the file's
+    /// root node when no span does), in O(log n + depth).
     pub fn findNodeAtPosition(
         self: *const EditorDagIntegration,
         file_path: []const u8,
@@ -214,25 +667,19 @@ pub const EditorDagIntegration = struct {
         // Assert: File path must be non-empty
         std.debug.assert(file_path.len > 0);
         
-        // Search DAG nodes for matching file and position
-        const nodes = self.dag.nodes[0..self.dag.nodes_len];
-        
-        for (nodes, 0..) |node, i| {
-            if (node.node_type == .ast_node) {
-                // Check if node matches file and position
-                // TODO: Parse node data to extract file path and position
-                // For now, return first matching node (placeholder)
-                if (std.mem.indexOf(u8, node.data, file_path) != null) {
-                    if (byte_pos >= node.attributes.readonly_start and
-                        byte_pos <= node.attributes.readonly_end)
-                    {
-                        return @as(u32, @intCast(i));
-                    }
-                }
-            }
+        const file = self.files.getPtr(file_path) orelse return null;
+        const entries = file.entries.items;
+        if (byte_pos > entries[0].end) return null;
+        
+        // Last span starting at or before the position, then outward
+        // through enclosing spans until one covers it.
+        var index = lowerBound(entries, Shift.none, byte_pos + 1) - 1;
+        while (index != 0 and entries[index].end <= byte_pos) {
+            const up = entries[index].up;
+            index = if (up == 0) 0 else index - up;
         }
         
-        return null;
+        return entries[index].dag_id;
     }
     
     /// Get dependency count for a node (for project-wide semantic understanding).
@@ -273,11 +720,16 @@ test "editor dag parse and map" {
     const file_path = "test.zig";
     
     const node_ids = try integration.parseAndMapToDag(source, file_path);
-    defer arena.allocator.free(node_ids);
+    defer arena.allocator().free(node_ids);
     
     // Assert: Nodes were created
     try std.testing.expect(node_ids.len > 0);
     try std.testing.expect(integration.dag.nodes_len > 0);
+    
+    // Assert: Payloads are binary records
+    const record = EditorDagIntegration.AstRecord.decode(integration.dag.getNode(node_ids[1]).?.data).?;
+    try std.testing.expect(record.kind == .function);
+    try std.testing.expect(record.span_len == source.len);
 }
 
 test "editor dag map edit to event" {
@@ -291,7 +743,7 @@ test "editor dag map edit to event" {
     const file_path = "test.zig";
     
     const node_ids = try integration.parseAndMapToDag(source, file_path);
-    defer arena.allocator.free(node_ids);
+    defer arena.allocator().free(node_ids);
     
     // Map edit to event
     const event_id = try integration.mapEditToEvent(
@@ -307,3 +759,97 @@ test "editor dag map edit to event" {
     try std.testing.expect(integration.dag.pending_events_len == 1);
 }
 
+test "editor dag edits keep unchanged node ids" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    
+    var integration = try EditorDagIntegration.init(arena.allocator());
+    defer integration.deinit();
+    
+    const source =
+        \\const std = @import("std");
+        \\
+        \\pub fn one() void {
+        \\    return;
+        \\}
+        \\
+        \\pub fn two() u32 {
+        \\    return 2;
+        \\}
+        \\
+        \\pub fn three() void {
+        \\    return;
+        \\}
+        \\
+    ;
+    const file_path = "edit.zig";
+    
+    const node_ids = try integration.parseAndMapToDag(source, file_path);
+    try std.testing.expectEqual(@as(usize, 4), node_ids.len);
+    const nodes_len = integration.dag.nodes_len;
+    const pos_one = @as(u32, @intCast(std.mem.indexOf(u8, source, "one").?));
+    const pos_two = @as(u32, @intCast(std.mem.indexOf(u8, source, "2;").?));
+    const pos_three = @as(u32, @intCast(std.mem.indexOf(u8, source, "three").?));
+    const id_one = integration.findNodeAtPosition(file_path, pos_one).?;
+    const id_two = integration.findNodeAtPosition(file_path, pos_two).?;
+    const id_three = integration.findNodeAtPosition(file_path, pos_three).?;
+    try std.testing.expect(id_one != id_two and id_two != id_three);
+    
+    // Between functions: the file root.
+    try std.testing.expectEqual(node_ids[0], integration.findNodeAtPosition(file_path, pos_two + 4).?);
+    
+    // Typing inside `two` rewrites only its node, with one event.
+    var stats = try integration.applyEdit(file_path, .{ .start = pos_two + 1, .old_len = 0, .new_text = "0" }, &.{});
+    try std.testing.expectEqual(@as(u32, 1), stats.updated);
+    try std.testing.expectEqual(@as(u32, 0), stats.created);
+    try std.testing.expect(stats.reparsed_bytes < source.len / 2);
+    try std.testing.expect(integration.dag.pending_events_len == 1);
+    try std.testing.expectEqual(id_two, integration.findNodeAtPosition(file_path, pos_two).?);
+    
+    // A new line above shifts every span; no DAG node changes.
+    stats = try integration.applyEdit(file_path, .{ .start = 0, .old_len = 0, .new_text = "\n" }, &.{});
+    try std.testing.expectEqual(@as(u32, 0), stats.updated + stats.created + stats.removed);
+    try std.testing.expectEqual(id_one, integration.findNodeAtPosition(file_path, pos_one + 1).?);
+    try std.testing.expectEqual(id_three, integration.findNodeAtPosition(file_path, pos_three + 2).?);
+    
+    // Re-mapping the original source reverts `two`; the DAG does not grow.
+    const remapped = try integration.parseAndMapToDag(source, file_path);
+    try std.testing.expectEqualSlices(u32, node_ids, remapped);
+    try std.testing.expectEqual(nodes_len, integration.dag.nodes_len);
+    try std.testing.expectEqual(@as(u32, 4), integration.getSemanticGraphNodeCount());
+}
+
+test "editor dag edit text is emitted once per edit" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    
+    var integration = try EditorDagIntegration.init(arena.allocator());
+    defer integration.deinit();
+    
+    const source =
+        \\pub fn one() void {
+        \\    return;
+        \\}
+        \\
+        \\pub fn two() void {
+        \\    return;
+        \\}
+        \\
+    ;
+    const file_path = "text.zig";
+    _ = try integration.parseAndMapToDag(source, file_path);
+    
+    // One edit across both functions rewrites both nodes.
+    const start = @as(u32, @intCast(std.mem.indexOf(u8, source, "return;").?));
+    const end = @as(u32, @intCast(std.mem.lastIndexOf(u8, source, "return;").?));
+    const new_text = "return 1;\n}\n\npub fn two() u8 {\n    return 2";
+    const stats = try integration.applyEdit(file_path, .{ .start = start, .old_len = end + 6 - start, .new_text = new_text }, &.{});
+    try std.testing.expectEqual(@as(u32, 2), stats.updated);
+    try std.testing.expectEqual(@as(u32, 2), integration.dag.pending_events_len);
+    
+    const carrier = integration.dag.pending_events[0];
+    const follower = integration.dag.pending_events[1];
+    try std.testing.expectEqual(@as(usize, 9 + end + 6 - start + new_text.len), carrier.data.len);
+    try std.testing.expectEqual(@as(usize, 9), follower.data.len);
+    try std.testing.expectEqualSlices(u64, &.{carrier.id}, follower.parents);
+}
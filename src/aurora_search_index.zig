@@ -0,0 +1,631 @@
+const std = @import("std");
+const GrainBuffer = @import("grain_buffer.zig").GrainBuffer;
+
+/// Aurora search index: trigram signatures over chunks of every open tab.
+/// ~<~ Glow Airbend: bounded chunks, bounded hits, bounded work per step.
+/// ~~~~ Glow Waterbend: edits ripple into one chunk, not the whole river.
+///
+/// Each document (editor buffer, browser page, title, URL) is split into
+/// chunks of about CHUNK_BYTES. A chunk keeps a SIGNATURE_BITS-bit signature
+/// of the trigrams starting inside it or in the SPAN bytes after it, so a
+/// match crossing a chunk boundary still passes its chunk's filter. Queries
+/// probe their first SPAN trigrams against each signature and verify only
+/// the chunks that pass. Edits adjust chunk lengths and mark the touched
+/// chunks dirty; signatures are rebuilt lazily by the next query. An edit
+/// that cannot allocate its chunk marks the document stale instead, and the
+/// next `begin_search` reloads it from its current text.
+///
+/// Searches are cooperative: `begin_search` returns a ticket and cancels any
+/// older search, `continue_search` scans a bounded number of chunks, and
+/// `page` serves ranked hits once done. Hits hold byte offsets into the
+/// document text; nothing is copied. Any edit, load, or removal while a
+/// search is live makes it stale.
+pub const SearchIndex = struct {
+    // Bounded: Max 256 indexed documents (tabs, titles, URLs).
+    pub const MAX_DOCUMENTS: u32 = 256;
+
+    // Bounded: Target chunk size; chunks split at twice this.
+    pub const CHUNK_BYTES: u32 = 4096;
+
+    // Bounded: 4096-bit trigram signature per chunk (512 bytes).
+    pub const SIGNATURE_BITS: u32 = 4096;
+    const SIGNATURE_WORDS: u32 = SIGNATURE_BITS / 64;
+    const SIGNATURE_SHIFT: u5 = 32 - 12;
+
+    // Trigrams starting this far past a chunk's end are in its signature;
+    // queries filter on their first SPAN trigrams.
+    pub const SPAN: u32 = 64;
+
+    // Bounded: Max 4096 hits per search (ranking covers these).
+    pub const MAX_HITS: u32 = 4096;
+
+    // Bounded: Max 1024 bytes per query.
+    pub const MAX_QUERY_LENGTH: u32 = 1024;
+
+    // Bytes of context on each side of a hit.
+    pub const CONTEXT_BYTES: u32 = 20;
+
+    /// Where a document's text comes from (also weights ranking).
+    pub const Source = enum(u8) {
+        editor,
+        browser_page,
+        browser_title,
+        browser_url,
+    };
+
+    pub const Status = enum(u8) {
+        running,
+        done,
+        cancelled,
+    };
+
+    /// Search hit: offsets into the document's current text.
+    pub const Hit = struct {
+        document: u16, // Slot in `documents`
+        source: Source,
+        tab_id: u32,
+        start: u32,
+        end: u32,
+        score: u32,
+    };
+
+    /// One page of ranked hits (borrowed from the index).
+    pub const Page = struct {
+        hits: []const Hit,
+        total: u32, // Hits across all pages
+        truncated: bool, // MAX_HITS reached; later matches were not collected
+    };
+
+    /// Hit with surrounding text (slices into the document).
+    pub const Context = struct {
+        before: []const u8,
+        match: []const u8,
+        after: []const u8,
+    };
+
+    const Chunk = struct {
+        len: u32,
+        dirty: bool,
+        signature: [SIGNATURE_WORDS]u64,
+    };
+
+    /// Indexed document. Heap-allocated so buffer listeners can point at it.
+    pub const Document = struct {
+        allocator: std.mem.Allocator,
+        source: Source,
+        tab_id: u32,
+        slot: u16,
+        text: []const u8, // Borrowed; refreshed by every load or edit
+        chunks: std.ArrayListUnmanaged(Chunk),
+        version: u64 = 0,
+        stale: bool = false, // Chunk lengths lost to OOM; reload before searching
+
+        /// Replace the whole text (browser page load, file reload).
+        pub fn load(self: *Document, text: []const u8) !void {
+            std.debug.assert(text.len <= std.math.maxInt(u32));
+            const count = (text.len + CHUNK_BYTES - 1) / CHUNK_BYTES;
+            try self.chunks.resize(self.allocator, count);
+            var remaining: u32 = @intCast(text.len);
+            for (self.chunks.items) |*chunk| {
+                const len = @min(remaining, CHUNK_BYTES);
+                chunk.len = len;
+                chunk.dirty = true;
+                remaining -= len;
+            }
+            self.text = text;
+            self.version += 1;
+            self.stale = false;
+        }
+
+        /// Apply one edit: `removed` bytes at `index` were replaced by
+        /// `inserted` bytes; `text` is the text after the edit.
+        pub fn note_edit(
+            self: *Document,
+            text: []const u8,
+            index: usize,
+            removed: usize,
+            inserted: usize,
+        ) void {
+            std.debug.assert(text.len <= std.math.maxInt(u32));
+            std.debug.assert(index + inserted <= text.len);
+            self.text = text;
+            self.version += 1;
+            if (self.stale) return;
+            if (removed > 0) self.erase_range(@intCast(index), @intCast(removed));
+            if (inserted > 0) self.insert_range(@intCast(index), @intCast(inserted));
+        }
+
+        /// Listener that keeps this document in sync with a GrainBuffer.
+        pub fn buffer_listener(self: *Document) GrainBuffer.EditListener {
+            return .{ .callback = on_buffer_edit, .context = @ptrCast(self) };
+        }
+
+        fn on_buffer_edit(
+            ctx: *anyopaque,
+            buffer: *const GrainBuffer,
+            index: usize,
+            removed: usize,
+            inserted: usize,
+        ) void {
+            const self: *Document = @ptrCast(@alignCast(ctx));
+            self.note_edit(buffer.textSlice(), index, removed, inserted);
+        }
+
+        fn erase_range(self: *Document, pos: u32, count: u32) void {
+            var left = count;
+            var start: u32 = 0;
+            var i: usize = 0;
+            while (i < self.chunks.items.len and left > 0) {
+                const chunk = &self.chunks.items[i];
+                if (pos < start + chunk.len) {
+                    const cut = @min(start + chunk.len - pos, left);
+                    chunk.len -= cut;
+                    chunk.dirty = true;
+                    left -= cut;
+                    self.mark_preceding(i);
+                    if (chunk.len == 0) {
+                        _ = self.chunks.orderedRemove(i);
+                        continue;
+                    }
+                }
+                start += chunk.len;
+                i += 1;
+            }
+        }
+
+        fn insert_range(self: *Document, pos: u32, count: u32) void {
+            if (self.chunks.items.len == 0) {
+                self.chunks.append(self.allocator, .{
+                    .len = 0,
+                    .dirty = true,
+                    .signature = undefined,
+                }) catch {
+                    // Why: Listeners cannot fail; begin_search reloads.
+                    self.stale = true;
+                    return;
+                };
+            }
+            // Chunk containing pos (an append lands in the last chunk).
+            var start: u32 = 0;
+            var i: usize = 0;
+            while (i + 1 < self.chunks.items.len and pos >= start + self.chunks.items[i].len) : (i += 1) {
+                start += self.chunks.items[i].len;
+            }
+            const chunk = &self.chunks.items[i];
+            chunk.len += count;
+            chunk.dirty = true;
+            self.mark_preceding(i);
+            if (chunk.len > 2 * CHUNK_BYTES) self.split_chunk(i);
+        }
+
+        // Split an oversized chunk into CHUNK_BYTES pieces. On allocation
+        // failure the chunk just stays large: still correct, less selective.
+        fn split_chunk(self: *Document, i: usize) void {
+            const len = self.chunks.items[i].len;
+            const pieces = (len + CHUNK_BYTES - 1) / CHUNK_BYTES;
+            const extra = self.chunks.addManyAt(self.allocator, i + 1, pieces - 1) catch return;
+            for (extra) |*chunk| {
+                chunk.* = .{ .len = CHUNK_BYTES, .dirty = true, .signature = undefined };
+            }
+            const first = &self.chunks.items[i];
+            first.len = len - (pieces - 1) * CHUNK_BYTES;
+            first.dirty = true;
+        }
+
+        // Earlier chunks whose SPAN window reaches chunk i see its edits.
+        fn mark_preceding(self: *Document, i: usize) void {
+            var j = i;
+            var between: u32 = 0;
+            while (j > 0 and between < SPAN + 2) {
+                j -= 1;
+                self.chunks.items[j].dirty = true;
+                between += self.chunks.items[j].len;
+            }
+        }
+
+        fn sign(self: *const Document, chunk: *Chunk, start: u32) void {
+            @memset(&chunk.signature, 0);
+            const text = self.text;
+            const window_end = @min(@as(usize, start) + chunk.len + SPAN, text.len -| 2);
+            var p: usize = start;
+            while (p < window_end) : (p += 1) {
+                const bit = trigram_bit(text[p..][0..3]);
+                chunk.signature[bit >> 6] |= @as(u64, 1) << @intCast(bit & 63);
+            }
+            chunk.dirty = false;
+        }
+    };
+
+    const ActiveQuery = struct {
+        pattern: [MAX_QUERY_LENGTH]u8 = undefined,
+        pattern_len: u32 = 0,
+        bits: [SPAN]u16 = undefined,
+        bits_len: u32 = 0,
+        versions: u64 = 0, // Sum of document versions at begin
+        layout: u64 = 0, // Index layout version at begin
+        doc_cursor: u32 = 0,
+        chunk_cursor: u32 = 0,
+        chunk_offset: u32 = 0,
+        resume_pos: u32 = 0, // Next scan position in the current document
+        hit_count: u32 = 0,
+        truncated: bool = false,
+        status: Status = .done,
+    };
+
+    allocator: std.mem.Allocator,
+    documents: [MAX_DOCUMENTS]?*Document = [_]?*Document{null} ** MAX_DOCUMENTS,
+    document_count: u32 = 0,
+    layout_version: u64 = 0,
+    generation: u64 = 0,
+    query: ActiveQuery = .{},
+    hits: []Hit = &.{},
+
+    /// Initialize an empty index (hit storage is allocated by the first search).
+    pub fn init(allocator: std.mem.Allocator) SearchIndex {
+        // Assert: Allocator must be valid
+        std.debug.assert(@intFromPtr(allocator.ptr) != 0);
+        return SearchIndex{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *SearchIndex) void {
+        for (&self.documents) |*entry| {
+            if (entry.*) |doc| destroy_document(self.allocator, doc);
+            entry.* = null;
+        }
+        self.allocator.free(self.hits);
+        self.* = undefined;
+    }
+
+    /// Index a document. The text is borrowed until the next load or edit.
+    pub fn add_document(self: *SearchIndex, source: Source, tab_id: u32, text: []const u8) !*Document {
+        std.debug.assert(self.find_document(source, tab_id) == null);
+        var slot: u16 = 0;
+        while (slot < MAX_DOCUMENTS and self.documents[slot] != null) : (slot += 1) {}
+        if (slot == MAX_DOCUMENTS) return error.TooManyDocuments;
+
+        const doc = try self.allocator.create(Document);
+        errdefer self.allocator.destroy(doc);
+        doc.* = .{
+            .allocator = self.allocator,
+            .source = source,
+            .tab_id = tab_id,
+            .slot = slot,
+            .text = "",
+            .chunks = .{},
+        };
+        try doc.load(text);
+        self.documents[slot] = doc;
+        self.document_count += 1;
+        self.layout_version += 1;
+        return doc;
+    }
+
+    /// Index a GrainBuffer and follow its edits (editor tabs). The caller
+    /// clears `buffer.edit_listener` before removing the document.
+    pub fn watch_buffer(self: *SearchIndex, source: Source, tab_id: u32, buffer: *GrainBuffer) !*Document {
+        std.debug.assert(buffer.edit_listener == null);
+        const doc = try self.add_document(source, tab_id, buffer.textSlice());
+        buffer.edit_listener = doc.buffer_listener();
+        return doc;
+    }
+
+    pub fn remove_document(self: *SearchIndex, doc: *Document) void {
+        std.debug.assert(self.documents[doc.slot] == doc);
+        self.documents[doc.slot] = null;
+        self.document_count -= 1;
+        self.layout_version += 1;
+        destroy_document(self.allocator, doc);
+    }
+
+    pub fn find_document(self: *const SearchIndex, source: Source, tab_id: u32) ?*Document {
+        for (self.documents) |entry| {
+            if (entry) |doc| {
+                if (doc.source == source and doc.tab_id == tab_id) return doc;
+            }
+        }
+        return null;
+    }
+
+    fn destroy_document(allocator: std.mem.Allocator, doc: *Document) void {
+        doc.chunks.deinit(allocator);
+        allocator.destroy(doc);
+    }
+
+    /// Start a search; any search still running becomes stale.
+    /// Returns the ticket for `continue_search` and `page`.
+    pub fn begin_search(self: *SearchIndex, query: []const u8) !u64 {
+        // Assert: Query must be valid
+        std.debug.assert(query.len > 0);
+        if (query.len > MAX_QUERY_LENGTH) return error.QueryTooLong;
+        if (self.hits.len == 0) self.hits = try self.allocator.alloc(Hit, MAX_HITS);
+        for (self.documents) |entry| {
+            if (entry) |doc| {
+                if (doc.stale) try doc.load(doc.text);
+            }
+        }
+
+        self.generation += 1;
+        const q = &self.query;
+        q.* = .{};
+        @memcpy(q.pattern[0..query.len], query);
+        q.pattern_len = @intCast(query.len);
+        if (query.len >= 3) {
+            const trigrams = @min(query.len - 2, SPAN);
+            while (q.bits_len < trigrams) : (q.bits_len += 1) {
+                q.bits[q.bits_len] = trigram_bit(query[q.bits_len..][0..3]);
+            }
+        }
+        q.versions = self.version_sum();
+        q.layout = self.layout_version;
+        q.status = .running;
+        return self.generation;
+    }
+
+    /// Scan up to `chunk_budget` chunks. Returns `.cancelled` for a stale
+    /// ticket or if documents changed since `begin_search`.
+    pub fn continue_search(self: *SearchIndex, ticket: u64, chunk_budget: u32) Status {
+        if (ticket != self.generation) return .cancelled;
+        const q = &self.query;
+        if (q.status == .running and !self.query_is_current()) q.status = .cancelled;
+        if (q.status != .running) return q.status;
+
+        var budget = chunk_budget;
+        while (budget > 0 and q.doc_cursor < MAX_DOCUMENTS) {
+            const doc = self.documents[q.doc_cursor] orelse {
+                self.next_document();
+                continue;
+            };
+            if (q.chunk_cursor >= doc.chunks.items.len) {
+                self.next_document();
+                continue;
+            }
+            const chunk = &doc.chunks.items[q.chunk_cursor];
+            const start = q.chunk_offset;
+            if (chunk.dirty) doc.sign(chunk, start);
+            if (chunk_may_match(chunk, q.bits[0..q.bits_len])) {
+                if (!self.verify(doc, start, start + chunk.len)) {
+                    q.truncated = true;
+                    break;
+                }
+            }
+            q.chunk_offset += chunk.len;
+            q.chunk_cursor += 1;
+            budget -= 1;
+        }
+        if (q.truncated or q.doc_cursor >= MAX_DOCUMENTS) {
+            self.rank();
+            q.status = .done;
+        }
+        return q.status;
+    }
+
+    /// Run a search to completion (no incremental stepping).
+    pub fn search(self: *SearchIndex, query: []const u8) !u64 {
+        const ticket = try self.begin_search(query);
+        while (self.continue_search(ticket, std.math.maxInt(u32)) == .running) {}
+        return ticket;
+    }
+
+    /// Ranked hits for a finished search, `page_size` per page.
+    /// Null if the ticket is stale, the search is unfinished, or documents
+    /// changed since (hit offsets would be wrong).
+    pub fn page(self: *const SearchIndex, ticket: u64, page_index: u32, page_size: u32) ?Page {
+        std.debug.assert(page_size > 0);
+        if (ticket != self.generation) return null;
+        const q = &self.query;
+        if (q.status != .done or !self.query_is_current()) return null;
+        const first = @min(@as(u64, page_index) * page_size, q.hit_count);
+        const last = @min(first + page_size, q.hit_count);
+        return Page{
+            .hits = self.hits[@intCast(first)..@intCast(last)],
+            .total = q.hit_count,
+            .truncated = q.truncated,
+        };
+    }
+
+    /// Match text and up to CONTEXT_BYTES on each side (borrowed).
+    pub fn context(self: *const SearchIndex, hit: Hit) Context {
+        const doc = self.documents[hit.document].?;
+        std.debug.assert(hit.end <= doc.text.len);
+        const before_start = hit.start -| CONTEXT_BYTES;
+        const after_end = @min(@as(usize, hit.end) + CONTEXT_BYTES, doc.text.len);
+        return Context{
+            .before = doc.text[before_start..hit.start],
+            .match = doc.text[hit.start..hit.end],
+            .after = doc.text[hit.end..after_end],
+        };
+    }
+
+    fn next_document(self: *SearchIndex) void {
+        const q = &self.query;
+        q.doc_cursor += 1;
+        q.chunk_cursor = 0;
+        q.chunk_offset = 0;
+        q.resume_pos = 0;
+    }
+
+    // Collect matches starting in [start, end). False when hits are full.
+    fn verify(self: *SearchIndex, doc: *const Document, start: u32, end: u32) bool {
+        const q = &self.query;
+        const pattern = q.pattern[0..q.pattern_len];
+        const text = doc.text;
+        const window = text[0..@min(@as(usize, end) + pattern.len - 1, text.len)];
+        var pos: usize = @max(start, q.resume_pos);
+        while (std.mem.indexOfPos(u8, window, pos, pattern)) |match_pos| {
+            if (q.hit_count == MAX_HITS) return false;
+            const match_end = match_pos + pattern.len;
+            self.hits[q.hit_count] = Hit{
+                .document = doc.slot,
+                .source = doc.source,
+                .tab_id = doc.tab_id,
+                .start = @intCast(match_pos),
+                .end = @intCast(match_end),
+                .score = score_hit(doc.source, text, match_pos, match_end),
+            };
+            q.hit_count += 1;
+            pos = match_end;
+        }
+        q.resume_pos = @intCast(@max(pos, end));
+        return true;
+    }
+
+    // Stable: equal scores keep document order, then offset order.
+    fn rank(self: *SearchIndex) void {
+        std.sort.block(Hit, self.hits[0..self.query.hit_count], {}, score_greater_than);
+    }
+
+    fn score_greater_than(_: void, a: Hit, b: Hit) bool {
+        return a.score > b.score;
+    }
+
+    fn query_is_current(self: *const SearchIndex) bool {
+        return self.query.layout == self.layout_version and
+            self.query.versions == self.version_sum();
+    }
+
+    fn version_sum(self: *const SearchIndex) u64 {
+        var sum: u64 = 0;
+        for (self.documents) |entry| {
+            if (entry) |doc| sum +%= doc.version;
+        }
+        return sum;
+    }
+
+    fn chunk_may_match(chunk: *const Chunk, bits: []const u16) bool {
+        for (bits) |bit| {
+            if (chunk.signature[bit >> 6] & (@as(u64, 1) << @intCast(bit & 63)) == 0) return false;
+        }
+        return true;
+    }
+
+    fn trigram_bit(trigram: *const [3]u8) u16 {
+        const packed_trigram = @as(u32, trigram[0]) << 16 | @as(u32, trigram[1]) << 8 | trigram[2];
+        return @intCast((packed_trigram *% 0x9E3779B1) >> SIGNATURE_SHIFT);
+    }
+
+    // Word-aligned matches and title/URL hits rank first.
+    fn score_hit(source: Source, text: []const u8, start: usize, end: usize) u32 {
+        var score: u32 = 1;
+        if (start == 0 or !is_word_byte(text[start - 1])) score += 4;
+        if (end == text.len or !is_word_byte(text[end])) score += 2;
+        score += switch (source) {
+            .browser_title => 8,
+            .browser_url => 4,
+            .editor, .browser_page => 0,
+        };
+        return score;
+    }
+
+    fn is_word_byte(byte: u8) bool {
+        return std.ascii.isAlphanumeric(byte) or byte == '_';
+    }
+};
+
+test "search index finds and ranks matches" {
+    var index = SearchIndex.init(std.testing.allocator);
+    defer index.deinit();
+
+    _ = try index.add_document(.editor, 1, "const grain = foregrain(); // grain");
+    _ = try index.add_document(.browser_title, 2, "Grain docs: grain");
+
+    const ticket = try index.search("grain");
+    const page = index.page(ticket, 0, 10).?;
+    try std.testing.expectEqual(@as(u32, 4), page.total);
+    // Title hit ranks first, then word-aligned editor hits in order.
+    try std.testing.expect(page.hits[0].source == .browser_title);
+    try std.testing.expectEqual(@as(u32, 6), page.hits[1].start);
+    try std.testing.expectEqual(@as(u32, 30), page.hits[2].start);
+    try std.testing.expectEqual(@as(u32, 18), page.hits[3].start);
+
+    const ctx = index.context(page.hits[1]);
+    try std.testing.expectEqualStrings("grain", ctx.match);
+    try std.testing.expectEqualStrings("const ", ctx.before);
+
+    // Second page of size 3 holds the last hit.
+    try std.testing.expectEqual(@as(usize, 1), index.page(ticket, 1, 3).?.hits.len);
+}
+
+test "search index finds matches across chunk boundaries" {
+    const allocator = std.testing.allocator;
+    var index = SearchIndex.init(allocator);
+    defer index.deinit();
+
+    // "nee" ends chunk 0 and "dle" starts chunk 1.
+    const page_text = try allocator.alloc(u8, SearchIndex.CHUNK_BYTES + 200);
+    defer allocator.free(page_text);
+    @memset(page_text, 'x');
+    @memcpy(page_text[SearchIndex.CHUNK_BYTES - 3 ..][0..6], "needle");
+    const doc = try index.add_document(.browser_page, 8, page_text);
+    try std.testing.expectEqual(@as(usize, 2), doc.chunks.items.len);
+
+    const ticket = try index.search("needle");
+    const page = index.page(ticket, 0, 10).?;
+    try std.testing.expectEqual(@as(u32, 1), page.total);
+    try std.testing.expectEqual(SearchIndex.CHUNK_BYTES - 3, page.hits[0].start);
+}
+
+test "search index follows buffer edits" {
+    const allocator = std.testing.allocator;
+    var buffer = GrainBuffer.init(allocator);
+    defer buffer.deinit();
+    var index = SearchIndex.init(allocator);
+    defer index.deinit();
+
+    const doc = try index.watch_buffer(.editor, 7, &buffer);
+    defer buffer.edit_listener = null;
+
+    // Appends grow the last chunk and split it past 2 * CHUNK_BYTES.
+    const filler = [_]u8{'x'} ** 1000;
+    var i: u32 = 0;
+    while (i < 20) : (i += 1) try buffer.append(&filler);
+    try std.testing.expect(doc.chunks.items.len >= 3);
+    try buffer.insert(9500, "needle");
+
+    var ticket = try index.search("needle");
+    var page = index.page(ticket, 0, 10).?;
+    try std.testing.expectEqual(@as(u32, 1), page.total);
+    try std.testing.expectEqual(@as(u32, 9500), page.hits[0].start);
+
+    // Erasing across chunks drops the hit and keeps lengths in step.
+    try buffer.erase(9000, 6 + SearchIndex.CHUNK_BYTES);
+    ticket = try index.search("needle");
+    page = index.page(ticket, 0, 10).?;
+    try std.testing.expectEqual(@as(u32, 0), page.total);
+    var total: usize = 0;
+    for (doc.chunks.items) |chunk| total += chunk.len;
+    try std.testing.expectEqual(buffer.textSlice().len, total);
+}
+
+test "search index cancels stale searches" {
+    var index = SearchIndex.init(std.testing.allocator);
+    defer index.deinit();
+    const doc = try index.add_document(.browser_page, 3, "alpha beta gamma");
+
+    const old_ticket = try index.begin_search("beta");
+    const new_ticket = try index.begin_search("gamma");
+    try std.testing.expect(index.continue_search(old_ticket, 1) == .cancelled);
+    try std.testing.expect(index.page(old_ticket, 0, 10) == null);
+    try std.testing.expect(index.continue_search(new_ticket, 16) == .done);
+    try std.testing.expect(index.page(new_ticket, 0, 10) != null);
+
+    // A page load invalidates finished results too.
+    try doc.load("delta");
+    try std.testing.expect(index.page(new_ticket, 0, 10) == null);
+}
+
+test "search index reloads a document whose edit ran out of memory" {
+    var failing = std.testing.FailingAllocator.init(std.testing.allocator, .{ .fail_index = std.math.maxInt(usize) });
+    var index = SearchIndex.init(failing.allocator());
+    defer index.deinit();
+    const doc = try index.add_document(.browser_title, 1, "");
+
+    // The first insert into an empty document needs a chunk; fail it.
+    failing.fail_index = failing.alloc_index;
+    doc.note_edit("grain needle", 0, 0, 12);
+    try std.testing.expect(doc.stale);
+
+    failing.fail_index = std.math.maxInt(usize);
+    const ticket = try index.search("needle");
+    try std.testing.expect(!doc.stale);
+    try std.testing.expectEqual(@as(u32, 1), index.page(ticket, 0, 10).?.total);
+}
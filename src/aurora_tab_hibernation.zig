@@ -0,0 +1,428 @@
+const std = @import("std");
+const Editor = @import("aurora_editor.zig").Editor;
+const DreamBrowserViewport = @import("dream_browser_viewport.zig").DreamBrowserViewport;
+
+/// Tab Hibernation: compact compressed snapshots of idle tabs.
+/// ~<~ Glow Airbend: explicit byte format, bounded lengths.
+/// ~~~~ Glow Waterbend: tabs sleep and wake deterministically.
+///
+/// This implements:
+/// - A small LZ77 block codec (LZ4-style tokens, 64 KiB window)
+/// - Editor snapshots (compressed buffer text + cursor)
+/// - Browser snapshots (compressed viewport state + navigation history)
+///
+/// A hibernated tab keeps only its snapshot; parser, renderer, layout,
+/// syntax tree and folding caches are released and rebuilt on wake.
+pub const TabHibernation = struct {
+    // Bounded: Max 16 MiB of text per hibernated editor
+    pub const MAX_TEXT_BYTES: u32 = 16 * 1024 * 1024;
+
+    // Bounded: Max 4096 characters per history URL (matches viewport)
+    pub const MAX_URL_LENGTH: u32 = 4096;
+
+    /// Snapshot bytes could not be decoded.
+    pub const Error = error{Corrupt};
+
+    /// Hibernated editor tab.
+    pub const HibernatedEditor = struct {
+        compressed: []u8, // Codec block of the buffer text
+        text_len: u32, // Decompressed text length
+        cursor_line: u32, // Cursor line at hibernation
+        cursor_char: u32, // Cursor character at hibernation
+
+        pub fn deinit(self: *HibernatedEditor, allocator: std.mem.Allocator) void {
+            allocator.free(self.compressed);
+            self.* = undefined;
+        }
+    };
+
+    /// Hibernated browser tab.
+    pub const HibernatedBrowser = struct {
+        compressed: []u8, // Codec block of the serialized viewport
+        raw_len: u32, // Serialized viewport length
+
+        pub fn deinit(self: *HibernatedBrowser, allocator: std.mem.Allocator) void {
+            allocator.free(self.compressed);
+            self.* = undefined;
+        }
+    };
+
+    /// Snapshot an editor, then release it.
+    /// Undo/redo history is dropped (the text itself is preserved).
+    pub fn hibernate_editor(allocator: std.mem.Allocator, editor: *Editor) !HibernatedEditor {
+        const text = editor.buffer.textSlice();
+        std.debug.assert(text.len <= MAX_TEXT_BYTES);
+
+        const compressed = try compress_alloc(allocator, text);
+        const state = HibernatedEditor{
+            .compressed = compressed,
+            .text_len = @intCast(text.len),
+            .cursor_line = editor.cursor_line,
+            .cursor_char = editor.cursor_char,
+        };
+        editor.deinit();
+        return state;
+    }
+
+    /// Rebuild an editor from its snapshot (the snapshot stays valid).
+    pub fn restore_editor(
+        allocator: std.mem.Allocator,
+        state: *const HibernatedEditor,
+        file_uri: []const u8,
+    ) !Editor {
+        const text = try allocator.alloc(u8, state.text_len);
+        defer allocator.free(text);
+        const len = try decompress(state.compressed, text);
+        if (len != state.text_len) return Error.Corrupt;
+
+        var editor = try Editor.init(allocator, file_uri, text);
+        editor.cursor_line = state.cursor_line;
+        editor.cursor_char = state.cursor_char;
+        return editor;
+    }
+
+    // Serialized viewport header: six ViewportState fields, entries_len, current_index.
+    const VIEWPORT_HEADER_SIZE: u32 = 8 * 4;
+
+    // Serialized history entry header: scroll_x, scroll_y, timestamp, url_len.
+    const ENTRY_HEADER_SIZE: u32 = 4 + 4 + 8 + 2;
+
+    /// Snapshot a browser viewport (scroll, sizes, history), then release it.
+    pub fn hibernate_browser(
+        allocator: std.mem.Allocator,
+        viewport: *DreamBrowserViewport,
+    ) !HibernatedBrowser {
+        const entries = viewport.history.entries[0..viewport.history.entries_len];
+        var raw_len: u32 = VIEWPORT_HEADER_SIZE;
+        for (entries) |entry| {
+            std.debug.assert(entry.url.len <= MAX_URL_LENGTH);
+            raw_len += ENTRY_HEADER_SIZE + @as(u32, @intCast(entry.url.len));
+        }
+
+        const raw = try allocator.alloc(u8, raw_len);
+        defer allocator.free(raw);
+        const s = viewport.viewport_state;
+        const header = [_]u32{
+            s.scroll_x,
+            s.scroll_y,
+            s.viewport_width,
+            s.viewport_height,
+            s.content_width,
+            s.content_height,
+            viewport.history.entries_len,
+            viewport.history.current_index,
+        };
+        var pos: usize = 0;
+        for (header) |value| {
+            std.mem.writeInt(u32, raw[pos..][0..4], value, .little);
+            pos += 4;
+        }
+        for (entries) |entry| {
+            std.mem.writeInt(u32, raw[pos..][0..4], entry.scroll_x, .little);
+            std.mem.writeInt(u32, raw[pos + 4 ..][0..4], entry.scroll_y, .little);
+            std.mem.writeInt(u64, raw[pos + 8 ..][0..8], entry.timestamp, .little);
+            std.mem.writeInt(u16, raw[pos + 16 ..][0..2], @intCast(entry.url.len), .little);
+            pos += ENTRY_HEADER_SIZE;
+            @memcpy(raw[pos..][0..entry.url.len], entry.url);
+            pos += entry.url.len;
+        }
+        std.debug.assert(pos == raw_len);
+
+        const compressed = try compress_alloc(allocator, raw);
+        viewport.deinit();
+        return HibernatedBrowser{
+            .compressed = compressed,
+            .raw_len = raw_len,
+        };
+    }
+
+    /// Rebuild a browser viewport from its snapshot (the snapshot stays valid).
+    pub fn restore_browser(
+        allocator: std.mem.Allocator,
+        state: *const HibernatedBrowser,
+    ) !DreamBrowserViewport {
+        const raw = try allocator.alloc(u8, state.raw_len);
+        defer allocator.free(raw);
+        const len = try decompress(state.compressed, raw);
+        if (len != state.raw_len or len < VIEWPORT_HEADER_SIZE) return Error.Corrupt;
+
+        var header: [8]u32 = undefined;
+        var pos: usize = 0;
+        for (&header) |*value| {
+            value.* = std.mem.readInt(u32, raw[pos..][0..4], .little);
+            pos += 4;
+        }
+        const entries_len = header[6];
+        const current_index = header[7];
+        if (entries_len > DreamBrowserViewport.MAX_HISTORY_ENTRIES) return Error.Corrupt;
+        if (current_index > entries_len) return Error.Corrupt;
+
+        var viewport = DreamBrowserViewport.init(allocator);
+        errdefer viewport.deinit();
+        // Why: init falls back to no history storage when its allocation
+        // fails; the count itself was validated above.
+        if (entries_len > 0 and viewport.history.entries.len == 0) return error.OutOfMemory;
+        viewport.viewport_state = DreamBrowserViewport.ViewportState{
+            .scroll_x = header[0],
+            .scroll_y = header[1],
+            .viewport_width = header[2],
+            .viewport_height = header[3],
+            .content_width = header[4],
+            .content_height = header[5],
+        };
+
+        var i: u32 = 0;
+        while (i < entries_len) : (i += 1) {
+            if (pos + ENTRY_HEADER_SIZE > raw.len) return Error.Corrupt;
+            const url_len = std.mem.readInt(u16, raw[pos + 16 ..][0..2], .little);
+            const url_start = pos + ENTRY_HEADER_SIZE;
+            if (url_len == 0 or url_start + url_len > raw.len) return Error.Corrupt;
+            const url_copy = try allocator.dupe(u8, raw[url_start..][0..url_len]);
+            viewport.history.entries[i] = DreamBrowserViewport.HistoryEntry{
+                .url = url_copy,
+                .scroll_x = std.mem.readInt(u32, raw[pos..][0..4], .little),
+                .scroll_y = std.mem.readInt(u32, raw[pos + 4 ..][0..4], .little),
+                .timestamp = std.mem.readInt(u64, raw[pos + 8 ..][0..8], .little),
+            };
+            // Count each entry as soon as it owns a URL so errdefer frees it.
+            viewport.history.entries_len = i + 1;
+            pos = url_start + url_len;
+        }
+        if (pos != raw.len) return Error.Corrupt;
+        viewport.history.current_index = current_index;
+        return viewport;
+    }
+
+    // Codec parameters.
+    const MIN_MATCH: u32 = 4;
+    const HASH_BITS: u32 = 12;
+    const HASH_SHIFT: u5 = 32 - HASH_BITS;
+    const MAX_OFFSET: u32 = 65_535;
+    // Trailing bytes always emitted as literals (keeps the match loop's reads in bounds).
+    const LAST_LITERALS: u32 = 5;
+
+    /// Worst-case compressed size for `len` input bytes.
+    pub fn compress_bound(len: usize) usize {
+        return len + len / 255 + 16;
+    }
+
+    /// Compress `src` into a freshly allocated block (shrunk to fit).
+    pub fn compress_alloc(allocator: std.mem.Allocator, src: []const u8) ![]u8 {
+        const dst = try allocator.alloc(u8, compress_bound(src.len));
+        const len = compress(src, dst);
+        // Why: Hibernation exists to save memory; keep only the used bytes.
+        if (allocator.resize(dst, len)) return dst[0..len];
+        defer allocator.free(dst);
+        return allocator.dupe(u8, dst[0..len]);
+    }
+
+    /// Compress `src` into `dst` (dst.len >= compress_bound(src.len)).
+    /// Block format: sequences of [token][literal len ext][literals]
+    /// [u16 offset][match len ext]; the final sequence has no match.
+    pub fn compress(src: []const u8, dst: []u8) usize {
+        std.debug.assert(dst.len >= compress_bound(src.len));
+
+        // Hash table of (position + 1); 0 means empty.
+        var table = [_]u32{0} ** (1 << HASH_BITS);
+        var anchor: usize = 0;
+        var i: usize = 0;
+        var out: usize = 0;
+        const limit: usize = if (src.len > MIN_MATCH + LAST_LITERALS) src.len - LAST_LITERALS else 0;
+
+        while (i + MIN_MATCH <= limit) {
+            const seq = std.mem.readInt(u32, src[i..][0..4], .little);
+            const slot = hash_sequence(seq);
+            const candidate = table[slot];
+            table[slot] = @intCast(i + 1);
+            if (candidate != 0) {
+                const c: usize = candidate - 1;
+                if (i - c <= MAX_OFFSET and std.mem.readInt(u32, src[c..][0..4], .little) == seq) {
+                    var match_len: usize = MIN_MATCH;
+                    while (i + match_len < limit and src[c + match_len] == src[i + match_len]) {
+                        match_len += 1;
+                    }
+                    out = write_sequence(dst, out, src[anchor..i], i - c, match_len);
+                    i += match_len;
+                    anchor = i;
+                    continue;
+                }
+            }
+            i += 1;
+        }
+
+        // Final literal-only sequence.
+        const literals = src[anchor..];
+        dst[out] = @as(u8, @intCast(@min(literals.len, 15))) << 4;
+        out += 1;
+        if (literals.len >= 15) out = write_length(dst, out, literals.len - 15);
+        @memcpy(dst[out..][0..literals.len], literals);
+        out += literals.len;
+        return out;
+    }
+
+    /// Decompress a block into `dst`; returns bytes written.
+    pub fn decompress(src: []const u8, dst: []u8) Error!usize {
+        var in: usize = 0;
+        var out: usize = 0;
+        while (in < src.len) {
+            const token = src[in];
+            in += 1;
+
+            var literal_len: usize = token >> 4;
+            if (literal_len == 15) literal_len += try read_length(src, &in);
+            if (in + literal_len > src.len or out + literal_len > dst.len) return Error.Corrupt;
+            @memcpy(dst[out..][0..literal_len], src[in..][0..literal_len]);
+            in += literal_len;
+            out += literal_len;
+
+            // The last sequence ends after its literals.
+            if (in == src.len) break;
+
+            if (in + 2 > src.len) return Error.Corrupt;
+            const offset: usize = std.mem.readInt(u16, src[in..][0..2], .little);
+            in += 2;
+            if (offset == 0 or offset > out) return Error.Corrupt;
+
+            var match_len: usize = (token & 15) + MIN_MATCH;
+            if ((token & 15) == 15) match_len += try read_length(src, &in);
+            if (out + match_len > dst.len) return Error.Corrupt;
+            // Byte-wise copy: matches may overlap their own output (runs).
+            var k: usize = 0;
+            while (k < match_len) : (k += 1) {
+                dst[out + k] = dst[out - offset + k];
+            }
+            out += match_len;
+        }
+        return out;
+    }
+
+    fn hash_sequence(seq: u32) u32 {
+        return (seq *% 2_654_435_761) >> HASH_SHIFT;
+    }
+
+    fn write_sequence(dst: []u8, start: usize, literals: []const u8, offset: usize, match_len: usize) usize {
+        std.debug.assert(offset > 0 and offset <= MAX_OFFSET);
+        std.debug.assert(match_len >= MIN_MATCH);
+        var out = start;
+        const match_code = match_len - MIN_MATCH;
+        dst[out] = (@as(u8, @intCast(@min(literals.len, 15))) << 4) | @as(u8, @intCast(@min(match_code, 15)));
+        out += 1;
+        if (literals.len >= 15) out = write_length(dst, out, literals.len - 15);
+        @memcpy(dst[out..][0..literals.len], literals);
+        out += literals.len;
+        std.mem.writeInt(u16, dst[out..][0..2], @intCast(offset), .little);
+        out += 2;
+        if (match_code >= 15) out = write_length(dst, out, match_code - 15);
+        return out;
+    }
+
+    fn write_length(dst: []u8, start: usize, len: usize) usize {
+        var out = start;
+        var remaining = len;
+        while (remaining >= 255) : (remaining -= 255) {
+            dst[out] = 255;
+            out += 1;
+        }
+        dst[out] = @intCast(remaining);
+        return out + 1;
+    }
+
+    fn read_length(src: []const u8, in: *usize) Error!usize {
+        var total: usize = 0;
+        while (true) {
+            if (in.* >= src.len) return Error.Corrupt;
+            const byte = src[in.*];
+            in.* += 1;
+            total += byte;
+            if (byte != 255) return total;
+        }
+    }
+};
+
+test "hibernation codec round trip" {
+    const allocator = std.testing.allocator;
+    const inputs = [_][]const u8{
+        "",
+        "a",
+        "hello",
+        "abcabcabcabcabcabcabcabcabcabcabcabcabcabc",
+        "pub fn main() void {}\npub fn main() void {}\npub fn main() void {}\n",
+    };
+    for (inputs) |input| {
+        const compressed = try TabHibernation.compress_alloc(allocator, input);
+        defer allocator.free(compressed);
+        const out = try allocator.alloc(u8, input.len);
+        defer allocator.free(out);
+        const len = try TabHibernation.decompress(compressed, out);
+        try std.testing.expect(len == input.len);
+        try std.testing.expectEqualSlices(u8, input, out[0..len]);
+    }
+}
+
+test "hibernation codec compresses source text" {
+    const allocator = std.testing.allocator;
+    var text: std.ArrayListUnmanaged(u8) = .{};
+    defer text.deinit(allocator);
+    var line: [64]u8 = undefined;
+    var i: u32 = 0;
+    while (i < 2000) : (i += 1) {
+        const printed = try std.fmt.bufPrint(&line, "    const value_{d} = compute(value_{d}, {d});\n", .{ i % 37, i % 11, i % 7 });
+        try text.appendSlice(allocator, printed);
+    }
+    const compressed = try TabHibernation.compress_alloc(allocator, text.items);
+    defer allocator.free(compressed);
+    try std.testing.expect(compressed.len * 4 < text.items.len);
+
+    const out = try allocator.alloc(u8, text.items.len);
+    defer allocator.free(out);
+    const len = try TabHibernation.decompress(compressed, out);
+    try std.testing.expectEqualSlices(u8, text.items, out[0..len]);
+}
+
+test "hibernation codec rejects corrupt input" {
+    var out: [16]u8 = undefined;
+    // Literal length runs past the input.
+    try std.testing.expectError(TabHibernation.Error.Corrupt, TabHibernation.decompress(&[_]u8{0x50, 'a'}, &out));
+    // Match offset points before the start of output.
+    try std.testing.expectError(TabHibernation.Error.Corrupt, TabHibernation.decompress(&[_]u8{ 0x10, 'a', 9, 0, 0x00 }, &out));
+    // Output larger than the destination.
+    try std.testing.expectError(TabHibernation.Error.Corrupt, TabHibernation.decompress(&[_]u8{ 0x1F, 'a', 1, 0, 40 }, &out));
+}
+
+test "hibernation browser viewport round trip" {
+    const allocator = std.testing.allocator;
+    var viewport = DreamBrowserViewport.init(allocator);
+    viewport.set_viewport_size(1024, 768);
+    viewport.set_content_size(1024, 4000);
+    try viewport.add_history_entry("https://example.com/a");
+    viewport.scroll_to(0, 120);
+    try viewport.add_history_entry("https://example.com/b");
+    viewport.scroll_to(0, 900);
+    const before_state = viewport.viewport_state;
+    const before_timestamp = viewport.history.entries[1].timestamp;
+
+    var state = try TabHibernation.hibernate_browser(allocator, &viewport);
+    defer state.deinit(allocator);
+
+    var restored = try TabHibernation.restore_browser(allocator, &state);
+    defer restored.deinit();
+    try std.testing.expect(std.meta.eql(restored.viewport_state, before_state));
+    try std.testing.expect(restored.history.entries_len == 2);
+    try std.testing.expect(restored.history.current_index == 2);
+    try std.testing.expectEqualStrings("https://example.com/b", restored.history.entries[1].url);
+    try std.testing.expect(restored.history.entries[1].scroll_y == 120);
+    try std.testing.expect(restored.history.entries[1].timestamp == before_timestamp);
+}
+
+test "hibernation browser rejects a corrupt history count" {
+    const allocator = std.testing.allocator;
+    const counts = [_]u32{ DreamBrowserViewport.MAX_HISTORY_ENTRIES + 1, std.math.maxInt(u32), 1 };
+    for (counts) |count| {
+        var raw = [_]u8{0} ** TabHibernation.VIEWPORT_HEADER_SIZE;
+        std.mem.writeInt(u32, raw[24..28], count, .little);
+        const compressed = try TabHibernation.compress_alloc(allocator, &raw);
+        var state = TabHibernation.HibernatedBrowser{ .compressed = compressed, .raw_len = raw.len };
+        defer state.deinit(allocator);
+        try std.testing.expectError(TabHibernation.Error.Corrupt, TabHibernation.restore_browser(allocator, &state));
+    }
+}
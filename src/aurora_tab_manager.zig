@@ -3,6 +3,7 @@ const Editor = @import("aurora_editor.zig").Editor;
 const DreamBrowserParser = @import("dream_browser_parser.zig").DreamBrowserParser;
 const DreamBrowserRenderer = @import("dream_browser_renderer.zig").DreamBrowserRenderer;
 const DreamBrowserViewport = @import("dream_browser_viewport.zig").DreamBrowserViewport;
+const TabHibernation = @import("aurora_tab_hibernation.zig").TabHibernation;
 
 /// Tab Manager: Enhanced tab management for unified IDE.
 /// ~<~ Glow Airbend: explicit tab ordering, bounded groups.
@@ -14,6 +15,8 @@ const DreamBrowserViewport = @import("dream_browser_viewport.zig").DreamBrowserV
 /// - Tab persistence (save/restore tab state)
 /// - Tab pinning (pin important tabs)
 /// - Tab metadata (last accessed time, etc.)
+/// - Tab hibernation (least recently used, unpinned tabs are compressed
+///   when resident tabs exceed the memory budget; restored on activation)
 pub const TabManager = struct {
     // Bounded: Max 100 editor tabs
     pub const MAX_EDITOR_TABS: u32 = 100;
@@ -27,9 +30,20 @@ pub const TabManager = struct {
     // Bounded: Max 256 characters for group name
     pub const MAX_GROUP_NAME_LENGTH: u32 = 256;
     
+    // Default memory budget for resident (non-hibernated) tabs: 256 MiB
+    pub const DEFAULT_MEMORY_BUDGET: u64 = 256 * 1024 * 1024;
+    
+    // Resident size estimates (bytes).
+    // Why: Editors hold the text in the buffer, Aurora, folding and syntax
+    // tree; browser tabs hold DOM, layout and render state we cannot measure.
+    pub const EDITOR_BASE_BYTES: u64 = 64 * 1024;
+    pub const EDITOR_BYTES_PER_TEXT_BYTE: u64 = 4;
+    pub const BROWSER_BASE_BYTES: u64 = 2 * 1024 * 1024;
+    
     /// Tab metadata (for enhanced management).
     pub const TabMetadata = struct {
         last_accessed: u64, // Timestamp of last access
+        access_tick: u64 = 0, // Logical access clock (LRU order)
         is_pinned: bool, // Whether tab is pinned
         group_id: ?u32 = null, // Tab group ID (if grouped)
         order: u32, // Tab order (for custom ordering)
@@ -53,6 +67,7 @@ pub const TabManager = struct {
         file_uri: []const u8,
         title: []const u8,
         metadata: TabMetadata,
+        hibernated: ?TabHibernation.HibernatedEditor = null, // Set while editor is released
     };
     
     /// Browser tab with metadata.
@@ -66,6 +81,7 @@ pub const TabManager = struct {
         contract_id: ?u64 = null,
         payment_enabled: bool = false,
         metadata: TabMetadata,
+        hibernated: ?TabHibernation.HibernatedBrowser = null, // Set while parser/renderer/viewport are released
     };
     
     /// Tab storage.
@@ -79,9 +95,12 @@ pub const TabManager = struct {
         next_group_id: u32, // Next group ID to assign
     };
     
+    allocator: std.mem.Allocator,
     storage: TabStorage,
     current_editor_tab: u32,
     current_browser_tab: u32,
+    memory_budget: u64,
+    access_clock: u64,
     
     /// Initialize tab manager.
     pub fn init(allocator: std.mem.Allocator) !TabManager {
@@ -107,6 +126,8 @@ pub const TabManager = struct {
             },
             .current_editor_tab = 0,
             .current_browser_tab = 0,
+            .memory_budget = DEFAULT_MEMORY_BUDGET,
+            .access_clock = 0,
         };
     }
     
@@ -114,16 +135,24 @@ pub const TabManager = struct {
     pub fn deinit(self: *TabManager) void {
         // Free editor tabs
         for (self.storage.editor_tabs[0..self.storage.editor_tabs_len]) |*tab| {
-            tab.editor.deinit();
+            if (tab.hibernated) |*state| {
+                state.deinit(self.allocator);
+            } else {
+                tab.editor.deinit();
+            }
             self.allocator.free(tab.file_uri);
             self.allocator.free(tab.title);
         }
         
         // Free browser tabs
         for (self.storage.browser_tabs[0..self.storage.browser_tabs_len]) |*tab| {
-            tab.parser.deinit();
-            tab.renderer.deinit();
-            tab.viewport.deinit();
+            if (tab.hibernated) |*state| {
+                state.deinit(self.allocator);
+            } else {
+                tab.parser.deinit();
+                tab.renderer.deinit();
+                tab.viewport.deinit();
+            }
             self.allocator.free(tab.url);
             self.allocator.free(tab.title);
         }
@@ -141,6 +170,232 @@ pub const TabManager = struct {
         self.allocator.free(self.storage.groups);
     }
     
+    /// Add editor tab (becomes the current editor tab).
+    pub fn add_editor_tab(
+        self: *TabManager,
+        file_uri: []const u8,
+        title: []const u8,
+        text: []const u8,
+    ) !u32 {
+        // Assert: Tabs must be within bounds
+        std.debug.assert(self.storage.editor_tabs_len < MAX_EDITOR_TABS);
+        
+        const tab_id = self.storage.editor_tabs_len;
+        {
+            // Scoped: once stored, the tab is owned by storage.
+            const uri_copy = try self.allocator.dupe(u8, file_uri);
+            errdefer self.allocator.free(uri_copy);
+            const title_copy = try self.allocator.dupe(u8, title);
+            errdefer self.allocator.free(title_copy);
+            const editor = try Editor.init(self.allocator, uri_copy, text);
+            
+            self.storage.editor_tabs[tab_id] = ManagedEditorTab{
+                .id = tab_id,
+                .editor = editor,
+                .file_uri = uri_copy,
+                .title = title_copy,
+                .metadata = TabMetadata{
+                    .last_accessed = get_current_timestamp(),
+                    .is_pinned = false,
+                    .order = tab_id,
+                },
+            };
+            self.storage.editor_tabs_len += 1;
+        }
+        self.current_editor_tab = tab_id;
+        self.update_editor_tab_access(tab_id);
+        _ = try self.enforce_memory_budget();
+        return tab_id;
+    }
+    
+    /// Add browser tab (becomes the current browser tab).
+    pub fn add_browser_tab(self: *TabManager, url: []const u8, title: []const u8) !u32 {
+        // Assert: Tabs must be within bounds
+        std.debug.assert(self.storage.browser_tabs_len < MAX_BROWSER_TABS);
+        
+        const tab_id = self.storage.browser_tabs_len;
+        {
+            // Scoped: once stored, the tab is owned by storage.
+            const url_copy = try self.allocator.dupe(u8, url);
+            errdefer self.allocator.free(url_copy);
+            const title_copy = try self.allocator.dupe(u8, title);
+            errdefer self.allocator.free(title_copy);
+            var viewport = DreamBrowserViewport.init(self.allocator);
+            errdefer viewport.deinit();
+            try viewport.add_history_entry(url);
+            
+            self.storage.browser_tabs[tab_id] = ManagedBrowserTab{
+                .id = tab_id,
+                .url = url_copy,
+                .parser = DreamBrowserParser.init(self.allocator),
+                .renderer = DreamBrowserRenderer.init(self.allocator),
+                .viewport = viewport,
+                .title = title_copy,
+                .metadata = TabMetadata{
+                    .last_accessed = get_current_timestamp(),
+                    .is_pinned = false,
+                    .order = tab_id,
+                },
+            };
+            self.storage.browser_tabs_len += 1;
+        }
+        self.current_browser_tab = tab_id;
+        self.update_browser_tab_access(tab_id);
+        _ = try self.enforce_memory_budget();
+        return tab_id;
+    }
+    
+    /// Activate editor tab: wakes it if hibernated, marks it most recently used.
+    pub fn activate_editor_tab(self: *TabManager, tab_id: u32) !*Editor {
+        // Assert: Tab ID must be valid
+        std.debug.assert(tab_id < self.storage.editor_tabs_len);
+        
+        const tab = &self.storage.editor_tabs[tab_id];
+        if (tab.hibernated) |*state| {
+            tab.editor = try TabHibernation.restore_editor(self.allocator, state, tab.file_uri);
+            state.deinit(self.allocator);
+            tab.hibernated = null;
+        }
+        self.current_editor_tab = tab_id;
+        self.update_editor_tab_access(tab_id);
+        _ = try self.enforce_memory_budget();
+        return &tab.editor;
+    }
+    
+    /// Activate browser tab: wakes it if hibernated, marks it most recently used.
+    /// Parser and renderer restart empty; the page is re-rendered from its URL.
+    pub fn activate_browser_tab(self: *TabManager, tab_id: u32) !*ManagedBrowserTab {
+        // Assert: Tab ID must be valid
+        std.debug.assert(tab_id < self.storage.browser_tabs_len);
+        
+        const tab = &self.storage.browser_tabs[tab_id];
+        if (tab.hibernated) |*state| {
+            tab.viewport = try TabHibernation.restore_browser(self.allocator, state);
+            tab.parser = DreamBrowserParser.init(self.allocator);
+            tab.renderer = DreamBrowserRenderer.init(self.allocator);
+            state.deinit(self.allocator);
+            tab.hibernated = null;
+        }
+        self.current_browser_tab = tab_id;
+        self.update_browser_tab_access(tab_id);
+        _ = try self.enforce_memory_budget();
+        return tab;
+    }
+    
+    /// Set memory budget for resident tabs and enforce it.
+    pub fn set_memory_budget(self: *TabManager, bytes: u64) !void {
+        self.memory_budget = bytes;
+        _ = try self.enforce_memory_budget();
+    }
+    
+    /// Hibernate least recently used tabs until resident tabs fit the budget.
+    /// Pinned tabs and the current editor/browser tabs are never hibernated.
+    /// Returns the number of tabs hibernated.
+    pub fn enforce_memory_budget(self: *TabManager) !u32 {
+        var resident = self.resident_bytes();
+        var hibernated: u32 = 0;
+        while (resident > self.memory_budget) {
+            const victim = self.find_lru_victim() orelse break;
+            switch (victim) {
+                .editor => |tab_id| {
+                    resident -= self.editor_tab_resident_bytes(tab_id);
+                    try self.hibernate_editor_tab(tab_id);
+                },
+                .browser => |tab_id| {
+                    resident -= self.browser_tab_resident_bytes(tab_id);
+                    try self.hibernate_browser_tab(tab_id);
+                },
+            }
+            hibernated += 1;
+        }
+        return hibernated;
+    }
+    
+    /// Hibernate editor tab: compress its text, release the editor.
+    pub fn hibernate_editor_tab(self: *TabManager, tab_id: u32) !void {
+        // Assert: Tab ID must be valid
+        std.debug.assert(tab_id < self.storage.editor_tabs_len);
+        
+        const tab = &self.storage.editor_tabs[tab_id];
+        if (tab.hibernated != null) return;
+        tab.hibernated = try TabHibernation.hibernate_editor(self.allocator, &tab.editor);
+        tab.editor = undefined;
+    }
+    
+    /// Hibernate browser tab: compress viewport and history, release caches.
+    pub fn hibernate_browser_tab(self: *TabManager, tab_id: u32) !void {
+        // Assert: Tab ID must be valid
+        std.debug.assert(tab_id < self.storage.browser_tabs_len);
+        
+        const tab = &self.storage.browser_tabs[tab_id];
+        if (tab.hibernated != null) return;
+        tab.hibernated = try TabHibernation.hibernate_browser(self.allocator, &tab.viewport);
+        tab.parser.deinit();
+        tab.renderer.deinit();
+        tab.parser = undefined;
+        tab.renderer = undefined;
+        tab.viewport = undefined;
+    }
+    
+    /// Estimated bytes held by resident (non-hibernated) tabs.
+    pub fn resident_bytes(self: *const TabManager) u64 {
+        var total: u64 = 0;
+        var i: u32 = 0;
+        while (i < self.storage.editor_tabs_len) : (i += 1) {
+            total += self.editor_tab_resident_bytes(i);
+        }
+        i = 0;
+        while (i < self.storage.browser_tabs_len) : (i += 1) {
+            total += self.browser_tab_resident_bytes(i);
+        }
+        return total;
+    }
+    
+    fn editor_tab_resident_bytes(self: *const TabManager, tab_id: u32) u64 {
+        const tab = &self.storage.editor_tabs[tab_id];
+        if (tab.hibernated != null) return 0;
+        const text_len: u64 = tab.editor.buffer.textSlice().len;
+        return EDITOR_BASE_BYTES + text_len * EDITOR_BYTES_PER_TEXT_BYTE;
+    }
+    
+    fn browser_tab_resident_bytes(self: *const TabManager, tab_id: u32) u64 {
+        const tab = &self.storage.browser_tabs[tab_id];
+        if (tab.hibernated != null) return 0;
+        return BROWSER_BASE_BYTES;
+    }
+    
+    const Victim = union(enum) {
+        editor: u32,
+        browser: u32,
+    };
+    
+    /// Least recently used resident tab that may be hibernated.
+    fn find_lru_victim(self: *const TabManager) ?Victim {
+        var victim: ?Victim = null;
+        var oldest: u64 = std.math.maxInt(u64);
+        var i: u32 = 0;
+        while (i < self.storage.editor_tabs_len) : (i += 1) {
+            const tab = &self.storage.editor_tabs[i];
+            if (tab.hibernated != null or tab.metadata.is_pinned) continue;
+            if (i == self.current_editor_tab) continue;
+            if (tab.metadata.access_tick < oldest) {
+                oldest = tab.metadata.access_tick;
+                victim = Victim{ .editor = i };
+            }
+        }
+        i = 0;
+        while (i < self.storage.browser_tabs_len) : (i += 1) {
+            const tab = &self.storage.browser_tabs[i];
+            if (tab.hibernated != null or tab.metadata.is_pinned) continue;
+            if (i == self.current_browser_tab) continue;
+            if (tab.metadata.access_tick < oldest) {
+                oldest = tab.metadata.access_tick;
+                victim = Victim{ .browser = i };
+            }
+        }
+        return victim;
+    }
+    
     /// Move editor tab to new position.
     pub fn move_editor_tab(self: *TabManager, tab_id: u32, new_position: u32) void {
         // Assert: Tab ID and position must be valid
@@ -361,6 +616,8 @@ pub const TabManager = struct {
         std.debug.assert(tab_id < self.storage.editor_tabs_len);
         
         self.storage.editor_tabs[tab_id].metadata.last_accessed = get_current_timestamp();
+        self.access_clock += 1;
+        self.storage.editor_tabs[tab_id].metadata.access_tick = self.access_clock;
     }
     
     /// Update browser tab last accessed time.
@@ -369,6 +626,8 @@ pub const TabManager = struct {
         std.debug.assert(tab_id < self.storage.browser_tabs_len);
         
         self.storage.browser_tabs[tab_id].metadata.last_accessed = get_current_timestamp();
+        self.access_clock += 1;
+        self.storage.browser_tabs[tab_id].metadata.access_tick = self.access_clock;
     }
     
     /// Get current timestamp (simplified).
@@ -386,6 +645,9 @@ pub const TabManager = struct {
             .groups_count = self.storage.groups_len,
             .pinned_editor_tabs = count_pinned_editor_tabs(self),
             .pinned_browser_tabs = count_pinned_browser_tabs(self),
+            .hibernated_editor_tabs = count_hibernated_editor_tabs(self),
+            .hibernated_browser_tabs = count_hibernated_browser_tabs(self),
+            .resident_bytes = self.resident_bytes(),
         };
     }
     
@@ -413,6 +675,30 @@ pub const TabManager = struct {
         return count;
     }
     
+    /// Count hibernated editor tabs.
+    fn count_hibernated_editor_tabs(self: *const TabManager) u32 {
+        var count: u32 = 0;
+        var i: u32 = 0;
+        while (i < self.storage.editor_tabs_len) : (i += 1) {
+            if (self.storage.editor_tabs[i].hibernated != null) {
+                count += 1;
+            }
+        }
+        return count;
+    }
+    
+    /// Count hibernated browser tabs.
+    fn count_hibernated_browser_tabs(self: *const TabManager) u32 {
+        var count: u32 = 0;
+        var i: u32 = 0;
+        while (i < self.storage.browser_tabs_len) : (i += 1) {
+            if (self.storage.browser_tabs[i].hibernated != null) {
+                count += 1;
+            }
+        }
+        return count;
+    }
+    
     /// Tab statistics.
     pub const TabStats = struct {
         editor_tabs_count: u32,
@@ -420,6 +706,9 @@ pub const TabManager = struct {
         groups_count: u32,
         pinned_editor_tabs: u32,
         pinned_browser_tabs: u32,
+        hibernated_editor_tabs: u32,
+        hibernated_browser_tabs: u32,
+        resident_bytes: u64, // Estimated bytes held by resident tabs
     };
 };
 
@@ -451,3 +740,78 @@ test "tab manager stats" {
     try std.testing.expect(stats.pinned_browser_tabs == 0);
 }
 
+test "tab manager hibernates least recently used tabs" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    
+    var manager = try TabManager.init(arena.allocator());
+    defer manager.deinit();
+    
+    // Budget fits two small editors.
+    try manager.set_memory_budget(2 * TabManager.EDITOR_BASE_BYTES + 1024);
+    const a = try manager.add_editor_tab("file:///a.zig", "a.zig", "const a = 1;\n");
+    const b = try manager.add_editor_tab("file:///b.zig", "b.zig", "const b = 2;\n");
+    manager.pin_editor_tab(a);
+    const c = try manager.add_editor_tab("file:///c.zig", "c.zig", "const c = 3;\n");
+    
+    // a is pinned and c is current, so b (least recently used) sleeps.
+    try std.testing.expect(manager.storage.editor_tabs[a].hibernated == null);
+    try std.testing.expect(manager.storage.editor_tabs[b].hibernated != null);
+    try std.testing.expect(manager.storage.editor_tabs[c].hibernated == null);
+    try std.testing.expect(manager.get_stats().hibernated_editor_tabs == 1);
+    
+    // Waking b restores its text and hibernates c instead.
+    const editor = try manager.activate_editor_tab(b);
+    try std.testing.expectEqualStrings("const b = 2;\n", editor.buffer.textSlice());
+    try std.testing.expect(manager.storage.editor_tabs[c].hibernated != null);
+    try std.testing.expect(manager.get_stats().resident_bytes <= manager.memory_budget);
+}
+
+test "tab manager enforces budget in access order across tab kinds" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    
+    var manager = try TabManager.init(arena.allocator());
+    defer manager.deinit();
+    
+    const e0 = try manager.add_editor_tab("file:///e0.zig", "e0.zig", "const e0 = 0;\n");
+    const b0 = try manager.add_browser_tab("https://example.com/b0", "b0");
+    const e1 = try manager.add_editor_tab("file:///e1.zig", "e1.zig", "const e1 = 1;\n");
+    const b1 = try manager.add_browser_tab("https://example.com/b1", "b1");
+    manager.update_editor_tab_access(e0);
+    
+    // One byte over budget: only the least recently used tab (b0) sleeps.
+    manager.memory_budget = manager.resident_bytes() - 1;
+    try std.testing.expectEqual(@as(u32, 1), try manager.enforce_memory_budget());
+    try std.testing.expect(manager.storage.browser_tabs[b0].hibernated != null);
+    try std.testing.expect(manager.storage.editor_tabs[e0].hibernated == null);
+    
+    // Zero budget: e0 goes next; current tabs stay resident over budget.
+    manager.memory_budget = 0;
+    try std.testing.expectEqual(@as(u32, 1), try manager.enforce_memory_budget());
+    try std.testing.expect(manager.storage.editor_tabs[e0].hibernated != null);
+    try std.testing.expect(manager.storage.editor_tabs[e1].hibernated == null);
+    try std.testing.expect(manager.storage.browser_tabs[b1].hibernated == null);
+    try std.testing.expectEqual(@as(u32, 0), try manager.enforce_memory_budget());
+}
+
+test "tab manager wakes a hibernated browser tab" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    
+    var manager = try TabManager.init(arena.allocator());
+    defer manager.deinit();
+    
+    const a = try manager.add_browser_tab("https://example.com/a", "a");
+    const b = try manager.add_browser_tab("https://example.com/b", "b");
+    manager.pin_browser_tab(b);
+    try manager.hibernate_browser_tab(a);
+    try std.testing.expect(manager.get_stats().hibernated_browser_tabs == 1);
+    
+    const tab = try manager.activate_browser_tab(a);
+    try std.testing.expect(tab.hibernated == null);
+    try std.testing.expect(tab.viewport.history.entries_len == 1);
+    try std.testing.expectEqualStrings("https://example.com/a", tab.viewport.history.entries[0].url);
+    try std.testing.expect(manager.current_browser_tab == a);
+    try std.testing.expect(manager.get_stats().hibernated_browser_tabs == 0);
+}
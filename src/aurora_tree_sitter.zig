@@ -69,16 +69,56 @@ pub const TreeSitter = struct {
         // Assert: Source must be non-empty
         std.debug.assert(source.len > 0);
         
+        const children = try self.parseZigRange(source, 0, @as(u32, @intCast(source.len)));
+        errdefer self.allocator.free(children);
+        
+        // Create root node containing all parsed nodes
+        const root = Node{
+            .type = "source_file",
+            .start_byte = 0,
+            .end_byte = @as(u32, @intCast(source.len)),
+            .start_point = Point{ .row = 0, .column = 0 },
+            .end_point = Point{ .row = @as(u32, @intCast(std.mem.count(u8, source, "\n") + 1)), .column = 0 },
+            .children = children,
+        };
+        
+        // Extract syntax tokens for highlighting
+        const tokens = try self.extractTokens(source);
+        
+        return Tree{
+            .root = root,
+            .source = source,
+            .tokens = tokens,
+        };
+    }
+    
+    /// Parse only the lines that start in [start_byte, end_byte) of `source`.
+    /// Byte offsets are absolute (closing braces are searched in the whole
+    /// source); points count rows from the line at `start_byte`.
+    /// Lets the editor reparse just the lines around an edit.
+    pub fn parseZigRange(
+        self: *TreeSitter,
+        source: []const u8,
+        start_byte: u32,
+        end_byte: u32,
+    ) ![]const Node {
+        // Assert: Range must be within source and start at a line
+        std.debug.assert(start_byte <= end_byte);
+        std.debug.assert(end_byte <= source.len);
+        std.debug.assert(start_byte == 0 or source[start_byte - 1] == '\n');
+        
         // Simple parser: identify function definitions, structs, etc.
         // This is a placeholder until we integrate the actual Tree-sitter library.
         var nodes = std.ArrayList(Node){ .items = &.{}, .capacity = 0 };
         defer nodes.deinit(self.allocator);
         
-        var lines = std.mem.splitSequence(u8, source, "\n");
+        var lines = std.mem.splitSequence(u8, source[start_byte..], "\n");
         var row: u32 = 0;
-        var byte_offset: u32 = 0;
+        var byte_offset: u32 = start_byte;
         
         while (lines.next()) |line| : (row += 1) {
+            if (byte_offset >= end_byte) break;
+            
             const trimmed = std.mem.trim(u8, line, " \t");
             
             // Check for function definitions
@@ -149,24 +189,7 @@ pub const TreeSitter = struct {
             std.debug.assert(nodes.items.len <= MAX_NODES);
         }
         
-        // Create root node containing all parsed nodes
-        const root = Node{
-            .type = "source_file",
-            .start_byte = 0,
-            .end_byte = @as(u32, @intCast(source.len)),
-            .start_point = Point{ .row = 0, .column = 0 },
-            .end_point = Point{ .row = row, .column = 0 },
-            .children = try nodes.toOwnedSlice(self.allocator),
-        };
-        
-        // Extract syntax tokens for highlighting
-        const tokens = try self.extractTokens(source);
-        
-        return Tree{
-            .root = root,
-            .source = source,
-            .tokens = tokens,
-        };
+        return try nodes.toOwnedSlice(self.allocator);
     }
     
     /// Extract syntax tokens from source code (for syntax highlighting).
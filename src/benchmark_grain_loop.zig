@@ -0,0 +1,82 @@
+const std = @import("std");
+const GrainLoop = @import("grain_loop.zig").GrainLoop;
+const Graindaemon = @import("graindaemon.zig").Graindaemon;
+
+/// GrainLoop loopback benchmark: datagrams per second through a running
+/// Graindaemon (epoll + recvmmsg in, sendmmsg out, ring + hashed dispatch).
+// ~( )~  Glow Airbend: measure the breeze, not the storm.
+// ~~~~~  Glow Waterbend: one river, counted at the mouth.
+
+const total_datagrams: usize = 1_000_000;
+const payload_len: usize = 32;
+// Datagrams in flight per round (fits the pending ring).
+const round_size: usize = GrainLoop.max_pending / 2;
+
+const Sink = struct {
+    fn on_datagram(ctx: *anyopaque, datagram: GrainLoop.GrainDatagram) void {
+        const daemon: *Graindaemon = @ptrCast(@alignCast(ctx));
+        daemon.handle(.{ .udp_received = datagram }) catch {};
+    }
+
+    fn ignore(ctx: *anyopaque, datagram: GrainLoop.GrainDatagram) void {
+        _ = ctx;
+        _ = datagram;
+    }
+};
+
+pub fn main() !void {
+    if (!GrainLoop.has_sockets) {
+        std.debug.print("benchmark-grain-loop: socket backend needs Linux\n", .{});
+        return;
+    }
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const daemon = try allocator.create(Graindaemon);
+    defer allocator.destroy(daemon);
+    daemon.* = Graindaemon.init(allocator);
+    defer daemon.deinit();
+    try daemon.handle(.boot);
+    try daemon.handle(.{ .tick = 1 });
+
+    const loop = daemon.loopPtr();
+    const any_port = try std.net.Address.parseIp4("127.0.0.1", 0);
+    const rx = try loop.bind_udp(any_port, .{ .callback = Sink.on_datagram, .context = @ptrCast(daemon) });
+    const tx = try loop.bind_udp(any_port, .{ .callback = Sink.ignore, .context = @ptrCast(daemon) });
+    const rx_addr = loop.local_address(rx).?;
+
+    var bytes: [round_size][payload_len]u8 = undefined;
+    var payloads: [round_size][]const u8 = undefined;
+    for (&bytes, &payloads, 0..) |*buf, *payload, i| {
+        @memset(buf, @truncate(i));
+        payload.* = buf;
+    }
+
+    var sent: usize = 0;
+    var lost: usize = 0;
+    var wakeups: usize = 0;
+    const start = std.time.nanoTimestamp();
+    while (sent < total_datagrams) {
+        const want = @min(round_size, total_datagrams - sent);
+        const batch_sent = try loop.send_batch(tx, rx_addr, payloads[0..want]);
+        sent += batch_sent;
+        // Drain this round; a short timeout bounds the wait for drops.
+        while (daemon.udp_datagrams + lost < sent) {
+            wakeups += 1;
+            if (try daemon.serve(10) == 0) {
+                lost = sent - daemon.udp_datagrams;
+            }
+        }
+    }
+    const elapsed_ns: u64 = @intCast(std.time.nanoTimestamp() - start);
+
+    const received = daemon.udp_datagrams;
+    const per_sec = received * std.time.ns_per_s / @max(elapsed_ns, 1);
+    std.debug.print("\nGrainLoop loopback ({d} datagrams x {d} bytes)\n", .{ total_datagrams, payload_len });
+    std.debug.print("  received:      {d} (lost {d})\n", .{ received, lost });
+    std.debug.print("  elapsed:       {d} ms\n", .{elapsed_ns / std.time.ns_per_ms});
+    std.debug.print("  throughput:    {d} datagrams/s\n", .{per_sec});
+    std.debug.print("  epoll wakeups: {d} ({d} datagrams each)\n", .{ wakeups, received / @max(wakeups, 1) });
+    std.debug.print("  daemon state:  {s}, timeline {d}\n", .{ @tagName(daemon.state), daemon.timeline.items.len });
+}
@@ -0,0 +1,95 @@
+const std = @import("std");
+const GrainRoute = @import("grain_route.zig").GrainRoute;
+
+/// GrainRoute benchmark: lookup cost against agent route tables of growing
+/// size, compiled trie versus the linear npub-prefix scan it replaced.
+// ~( )~  Glow Airbend: the path is as long as the URL, not the map.
+// ~~~~~  Glow Waterbend: one riverbed, however many streams join it.
+
+const table_agents = [_]usize{ 1_000, 10_000, 50_000 };
+const trie_lookups: usize = 2_000_000;
+const linear_lookups: usize = 20_000;
+const url_count: usize = 1024;
+
+const agent_paths = [_][]const []const u8{
+    &.{},
+    &.{"timeline"},
+    &.{ "notes", ":note" },
+    &.{ "files", "*path" },
+};
+const agent_components = [_][]const u8{ "home", "timeline", "note", "files" };
+const url_suffixes = [_][]const u8{ "", "/timeline", "/notes/n0te42", "/files/docs/readme.md", "/settings" };
+
+// The pre-trie lookup: first route whose npub prefix matches.
+fn linear_match(routes: []const GrainRoute.RouteSpec, url: []const u8) ?[]const u8 {
+    const trimmed = std.mem.trim(u8, url, "/");
+    var parts = std.mem.splitScalar(u8, trimmed, '/');
+    const npub = parts.next() orelse return null;
+    for (routes) |route| {
+        if (std.mem.startsWith(u8, npub, route.npub_prefix)) return route.component_id;
+    }
+    return null;
+}
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+
+    std.debug.print("\nGrainRoute lookup ({d} routes per agent)\n", .{agent_paths.len});
+    std.debug.print("  {s:>8} {s:>8} {s:>12} {s:>14} {s:>14}\n", .{ "agents", "routes", "compile ms", "trie ns/op", "linear ns/op" });
+    for (table_agents) |agents| {
+        var arena = std.heap.ArenaAllocator.init(gpa.allocator());
+        defer arena.deinit();
+        const allocator = arena.allocator();
+
+        const routes = try allocator.alloc(GrainRoute.RouteSpec, agents * agent_paths.len);
+        for (0..agents) |agent| {
+            const prefix = try std.fmt.allocPrint(allocator, "npub1agent{d:0>6}", .{agent});
+            for (agent_paths, agent_components, 0..) |path, component, i| {
+                routes[agent * agent_paths.len + i] = .{
+                    .npub_prefix = prefix,
+                    .path = path,
+                    .component_id = component,
+                };
+            }
+        }
+
+        var prng = std.Random.DefaultPrng.init(agents);
+        const random = prng.random();
+        const urls = try allocator.alloc([]const u8, url_count);
+        for (urls) |*url| {
+            const agent = random.uintLessThan(usize, agents);
+            const suffix = url_suffixes[random.uintLessThan(usize, url_suffixes.len)];
+            url.* = try std.fmt.allocPrint(allocator, "/npub1agent{d:0>6}q9x{s}", .{ agent, suffix });
+        }
+
+        const compile_start = std.time.nanoTimestamp();
+        var router = try GrainRoute.init(allocator, routes);
+        defer router.deinit();
+        const compile_ns: u64 = @intCast(std.time.nanoTimestamp() - compile_start);
+
+        var hits: usize = 0;
+        const trie_start = std.time.nanoTimestamp();
+        for (0..trie_lookups) |i| {
+            const found = router.match(urls[i % url_count]);
+            hits += @intFromBool(found != null);
+            std.mem.doNotOptimizeAway(found);
+        }
+        const trie_ns: u64 = @intCast(std.time.nanoTimestamp() - trie_start);
+
+        const linear_start = std.time.nanoTimestamp();
+        for (0..linear_lookups) |i| {
+            std.mem.doNotOptimizeAway(linear_match(routes, urls[i % url_count]));
+        }
+        const linear_ns: u64 = @intCast(std.time.nanoTimestamp() - linear_start);
+
+        std.debug.assert(hits == trie_lookups);
+        std.debug.print("  {d:>8} {d:>8} {d:>12} {d:>14} {d:>14}\n", .{
+            agents,
+            routes.len,
+            compile_ns / std.time.ns_per_ms,
+            trie_ns / trie_lookups,
+            linear_ns / linear_lookups,
+        });
+    }
+}
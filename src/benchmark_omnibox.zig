@@ -0,0 +1,78 @@
+const std = @import("std");
+const DreamBrowserBookmarks = @import("dream_browser_bookmarks.zig").DreamBrowserBookmarks;
+
+/// Omnibox benchmark: query latency over a full 100k-visit history, one
+/// keystroke at a time, against the frame budget (16.6 ms at 60 Hz).
+// ~<~  Glow Airbend: each keystroke answered inside one frame.
+// ~~~~ Glow Waterbend: the freshest pages float to the top.
+
+const history_visits: u32 = DreamBrowserBookmarks.MAX_HISTORY_ENTRIES;
+const distinct_pages: u32 = 40_000;
+const bookmark_count: u32 = 2_000;
+const rounds: usize = 50;
+const step_budget: u32 = 4096;
+
+const hosts = [_][]const u8{ "github.com", "ziglang.org", "news.ycombinator.com", "docs.rs", "wikipedia.org", "grain.example", "lobste.rs", "nostr.band" };
+const words = [_][]const u8{ "grain", "zig", "allocator", "kernel", "river", "dream", "browser", "tiger", "bank", "mirror", "route", "loop", "search", "index", "frecency", "omnibox" };
+const keystrokes = [_][]const u8{ "g", "gi", "git", "git z", "git zi", "zig", "zig all", "dream bro", "wiki", "q" };
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+
+    var bookmarks = try DreamBrowserBookmarks.init(gpa.allocator());
+    defer bookmarks.deinit();
+
+    var prng = std.Random.DefaultPrng.init(0x6f6d6e69);
+    const random = prng.random();
+    var url_buf: [256]u8 = undefined;
+    var title_buf: [256]u8 = undefined;
+
+    const load_start = std.time.nanoTimestamp();
+    var visit: u32 = 0;
+    while (visit < history_visits) : (visit += 1) {
+        // Skewed page choice: a few pages get most of the visits.
+        const page = random.uintLessThan(u32, 1 + random.uintLessThan(u32, distinct_pages));
+        const host = hosts[page % hosts.len];
+        const a = words[(page / 7) % words.len];
+        const b = words[(page / 113) % words.len];
+        const url = try std.fmt.bufPrint(&url_buf, "https://{s}/{s}/{s}/{d}", .{ host, a, b, page });
+        const title = try std.fmt.bufPrint(&title_buf, "{s} {s} page {d}", .{ a, b, page });
+        try bookmarks.add_history_entry_at(url, title, 30, 1_700_000_000 + @as(u64, visit) * 60);
+        if (visit < bookmark_count and page % 3 == 0 and
+            bookmarks.bookmarks_storage.bookmarks_len < DreamBrowserBookmarks.MAX_BOOKMARKS)
+        {
+            _ = try bookmarks.add_bookmark(url, title, null);
+        }
+    }
+    const load_ns: u64 = @intCast(std.time.nanoTimestamp() - load_start);
+    const stats = bookmarks.get_stats();
+    std.debug.print("\nOmnibox over {d} visits, {d} places, {d} bookmarks (load {d} ms)\n", .{
+        stats.history_count,
+        stats.places_count,
+        stats.bookmarks_count,
+        load_ns / std.time.ns_per_ms,
+    });
+    std.debug.print("  {s:<12} {s:>10} {s:>14} {s:>12}\n", .{ "query", "results", "first step us", "total us" });
+
+    for (keystrokes) |query| {
+        var first_ns: u64 = 0;
+        var total_ns: u64 = 0;
+        var result_count: usize = 0;
+        for (0..rounds) |_| {
+            const start = std.time.nanoTimestamp();
+            const ticket = bookmarks.begin_omnibox(query);
+            var status = bookmarks.continue_omnibox(ticket, step_budget);
+            first_ns += @intCast(std.time.nanoTimestamp() - start);
+            while (status == .running) status = bookmarks.continue_omnibox(ticket, step_budget);
+            total_ns += @intCast(std.time.nanoTimestamp() - start);
+            result_count = bookmarks.omnibox_results(ticket).?.len;
+        }
+        std.debug.print("  {s:<12} {d:>10} {d:>14} {d:>12}\n", .{
+            query,
+            result_count,
+            first_ns / rounds / std.time.ns_per_us,
+            total_ns / rounds / std.time.ns_per_us,
+        });
+    }
+}
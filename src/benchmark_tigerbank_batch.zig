@@ -0,0 +1,62 @@
+const std = @import("std");
+const Contracts = @import("contracts.zig").SettlementContracts;
+const tigerbank = @import("tigerbank_client.zig");
+const MockCluster = @import("tigerbank_mock_cluster.zig").MockCluster;
+
+/// TigerBank settlement benchmark: envelopes/second against the loopback
+/// mock cluster (fixed per-batch commit latency) as batch size and the
+/// in-flight window grow. Batch bytes of one envelope is the old
+/// per-envelope round trip.
+// ~<~  Glow Airbend: one round trip carries a thousand settlements.
+// ~~~~ Glow Waterbend: the next batch sails before the last one docks.
+
+const envelopes: u32 = 20_000;
+const batch_latency_us: u32 = 100;
+const entry_len = Contracts.kind_tag_len + Contracts.TigerBankCDN.encoded_len;
+const batch_envelopes = [_]u32{ 1, 16, 128, 1024 };
+const windows = [_]u32{ 1, 8 };
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    std.debug.print("\nTigerBank settlement ({d} envelopes, {d} us commit per batch)\n", .{ envelopes, batch_latency_us });
+    std.debug.print("  {s:>10} {s:>8} {s:>10} {s:>14}\n", .{ "batch", "window", "batches", "envelopes/s" });
+    for (batch_envelopes) |per_batch| {
+        for (windows) |window| {
+            var cluster: MockCluster = undefined;
+            try cluster.start(allocator, .{ .batch_latency_us = batch_latency_us });
+            defer cluster.stop();
+
+            const endpoints = [_]tigerbank.ClusterEndpoint{.{ .host = "127.0.0.1", .port = cluster.port() }};
+            var pipeline = try tigerbank.Pipeline.init(allocator, &endpoints, .{
+                .window = window,
+                .batch_bytes = @intCast(tigerbank.Wire.batch_header_len + per_batch * (tigerbank.Wire.entry_prefix_len + entry_len)),
+            });
+            defer pipeline.deinit();
+
+            const start = std.time.nanoTimestamp();
+            var i: u32 = 0;
+            while (i < envelopes) : (i += 1) {
+                try pipeline.submit(.{ .tigerbank_cdn = .{
+                    .tier = .pro,
+                    .subscriber_npub = [_]u8{@truncate(i)} ** 32,
+                    .start_timestamp_seconds = 1_700_000_000 + i,
+                    .seats = 1,
+                    .autopay_enabled = true,
+                } });
+            }
+            try pipeline.flush();
+            const elapsed_ns: u64 = @intCast(std.time.nanoTimestamp() - start);
+
+            std.debug.assert(cluster.settledEnvelopes() == envelopes);
+            std.debug.print("  {d:>10} {d:>8} {d:>10} {d:>14}\n", .{
+                per_batch,
+                window,
+                pipeline.stats.batches_settled,
+                @as(u64, envelopes) * std.time.ns_per_s / elapsed_ns,
+            });
+        }
+    }
+}
@@ -0,0 +1,134 @@
+const std = @import("std");
+const tls = @import("tls");
+const tls_impl = @import("grain_tls_impl");
+
+/// Grain TLS handshake benchmark against an in-process local server
+/// (Linux loopback): per-connection wall time and CPU for
+///   - loading system roots per connection (what init used to do),
+///   - the shared trust store,
+///   - full handshakes against the local server.
+// ~<~  Glow Airbend: the roots are read once, not per connection.
+// ~~~~ Glow Waterbend: each guest is greeted without re-reading the ledger.
+
+const connections: u32 = 200;
+const root_loads: u32 = 20;
+const testdata = "src/grain_tls/testdata";
+const host = "localhost";
+
+const Server = struct {
+    listener: std.net.Server,
+    auth: *tls_impl.config.CertKeyPair,
+    remaining: u32,
+
+    // Accept, handshake, echo one message, close; `remaining` times.
+    fn run(self: *Server) void {
+        while (self.remaining > 0) : (self.remaining -= 1) {
+            const accepted = self.listener.accept() catch return;
+            defer accepted.stream.close();
+            var input_buf: [tls_impl.input_buffer_len]u8 = undefined;
+            var output_buf: [tls_impl.output_buffer_len]u8 = undefined;
+            var reader = accepted.stream.reader(&input_buf);
+            var writer = accepted.stream.writer(&output_buf);
+            var conn = tls_impl.server(reader.interface(), &writer.interface, .{
+                .auth = self.auth,
+            }) catch continue;
+            if (conn.next() catch null) |data| conn.writeAll(data) catch {};
+            conn.close() catch {};
+        }
+    }
+};
+
+const Sample = struct {
+    wall_ns: u64,
+    cpu_ns: u64,
+};
+
+fn cpu_now() u64 {
+    const usage = std.posix.getrusage(std.posix.rusage.SELF);
+    const user: u64 = @intCast(usage.utime.sec * std.time.ns_per_s + usage.utime.usec * std.time.ns_per_us);
+    const system: u64 = @intCast(usage.stime.sec * std.time.ns_per_s + usage.stime.usec * std.time.ns_per_us);
+    return user + system;
+}
+
+fn handshakes(
+    allocator: std.mem.Allocator,
+    address: std.net.Address,
+    root_ca: tls.Bundle,
+) !Sample {
+    const wall_start = std.time.nanoTimestamp();
+    const cpu_start = cpu_now();
+    var i: u32 = 0;
+    while (i < connections) : (i += 1) {
+        const stream = try std.net.tcpConnectToAddress(address);
+        defer stream.close();
+        var client = try tls.TlsClient.init_with(allocator, stream, host, .{
+            .root_ca = root_ca,
+        });
+        defer client.deinit();
+        try client.writeAll("ping");
+        _ = try client.next();
+    }
+    return Sample{
+        .wall_ns = @intCast(std.time.nanoTimestamp() - wall_start),
+        .cpu_ns = cpu_now() - cpu_start,
+    };
+}
+
+fn report(label: []const u8, sample: Sample, count: u32) void {
+    std.debug.print("  {s:<26} {d:>12} {d:>12}\n", .{
+        label,
+        sample.wall_ns / count / std.time.ns_per_us,
+        sample.cpu_ns / count / std.time.ns_per_us,
+    });
+}
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    var dir = try std.fs.cwd().openDir(testdata, .{});
+    defer dir.close();
+    var auth = try tls_impl.config.CertKeyPair.fromFilePath(allocator, dir, "localhost_cert.pem", "localhost_key.pem");
+    defer auth.deinit(allocator);
+    var root_ca = try tls_impl.config.cert.fromFilePath(allocator, dir, "localhost_cert.pem");
+    defer root_ca.deinit(allocator);
+
+    std.debug.print("\nGrain TLS handshakes over loopback ({d} connections)\n", .{connections});
+    std.debug.print("  {s:<26} {s:>12} {s:>12}\n", .{ "mode", "wall us/op", "cpu us/op" });
+
+    // Root store: per-connection load versus the shared store.
+    var cpu_start = cpu_now();
+    var wall_start = std.time.nanoTimestamp();
+    var i: u32 = 0;
+    while (i < root_loads) : (i += 1) {
+        var bundle = try tls_impl.config.cert.fromSystem(allocator);
+        bundle.deinit(allocator);
+    }
+    report("system roots, per conn", .{
+        .wall_ns = @intCast(std.time.nanoTimestamp() - wall_start),
+        .cpu_ns = cpu_now() - cpu_start,
+    }, root_loads);
+    _ = try tls.TrustStore.shared();
+    cpu_start = cpu_now();
+    wall_start = std.time.nanoTimestamp();
+    i = 0;
+    while (i < root_loads) : (i += 1) std.mem.doNotOptimizeAway(try tls.TrustStore.shared());
+    report("system roots, shared", .{
+        .wall_ns = @intCast(std.time.nanoTimestamp() - wall_start),
+        .cpu_ns = cpu_now() - cpu_start,
+    }, root_loads);
+    defer tls.TrustStore.reset();
+
+    var server = Server{
+        .listener = try (try std.net.Address.parseIp("127.0.0.1", 0)).listen(.{ .reuse_address = true }),
+        .auth = &auth,
+        .remaining = connections,
+    };
+    defer server.listener.deinit();
+    const thread = try std.Thread.spawn(.{}, Server.run, .{&server});
+    defer thread.join();
+    const address = server.listener.listen_address;
+
+    report("full handshake", try handshakes(allocator, address, root_ca), connections);
+}
@@ -210,6 +210,16 @@ pub const SettlementContracts = struct {
             ),
         );
 
+        pub fn encodedLength(self: Envelope) !usize {
+            return kind_tag_len + switch (self) {
+                .tigerbank_mmt => |mmt| try mmt.encodedLength(),
+                .tigerbank_cdn => TigerBankCDN.encoded_len,
+                .optional_inventory => OptionalModulesEncoded.inventory_len,
+                .optional_sales => OptionalModulesEncoded.sales_len,
+                .optional_payroll => OptionalModulesEncoded.payroll_len,
+            };
+        }
+
         pub fn encode(self: Envelope, buffer: []u8) ![]const u8 {
             if (buffer.len < kind_tag_len) return error.BufferTooSmall;
             buffer[0] = @intFromEnum(std.meta.activeTag(self));
@@ -204,6 +204,34 @@ pub const DagCore = struct {
         return node_id;
     }
 
+    /// Replace a node's data in place, keeping its ID and edges.
+    /// Same-length data is overwritten without allocating.
+    pub fn updateNode(
+        self: *DagCore,
+        node_id: u32,
+        data: []const u8,
+    ) !void {
+        // Assert: Node ID must be valid
+        std.debug.assert(node_id < self.nodes_len);
+
+        // Assert: Data length must be reasonable
+        std.debug.assert(data.len < 1_000_000); // Max 1MB per node
+
+        const node = &self.nodes[node_id];
+        if (node.data.len == data.len) {
+            // Node data is owned (duped in addNode), so it is writable.
+            @memcpy(@constCast(node.data), data);
+            return;
+        }
+
+        const node_data = try self.allocator.dupe(u8, data);
+        if (node.data.len > 0) {
+            self.allocator.free(node.data);
+        }
+        node.data = node_data;
+        node.data_len = @as(u32, @intCast(node_data.len));
+    }
+
     /// Add an edge to the DAG.
     pub fn addEdge(
         self: *DagCore,
@@ -416,6 +444,25 @@ test "dag add node" {
     try std.testing.expect(node.?.node_type == .ast_node);
 }
 
+test "dag update node keeps id" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    var dag = try DagCore.init(arena.allocator());
+    defer dag.deinit();
+
+    const node_id = try dag.addNode(.ast_node, "old!", .{});
+    try dag.updateNode(node_id, "new!");
+    try std.testing.expectEqualStrings("new!", dag.getNode(node_id).?.data);
+
+    try dag.updateNode(node_id, "longer data");
+
+    // Assert: Same node, new data, no node added
+    try std.testing.expectEqualStrings("longer data", dag.getNode(node_id).?.data);
+    try std.testing.expect(dag.getNode(node_id).?.data_len == 11);
+    try std.testing.expect(dag.nodes_len == 1);
+}
+
 test "dag add edge" {
     var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
     defer arena.deinit();
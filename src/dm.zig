@@ -31,6 +31,91 @@ pub fn deriveSharedSecret(
     return SharedSecret{ .bytes = shared };
 }
 
+/// Symmetric key for one conversation, derived once from the X25519
+/// shared secret and reused for every message in it.
+pub const ConversationKey = struct {
+    key: Key,
+
+    pub fn fromShared(shared: SharedSecret) ConversationKey {
+        return .{ .key = shared.symmetricKey() };
+    }
+
+    /// Sealed size of a plaintext: ciphertext || tag.
+    pub fn sealedLength(plaintext_len: usize) usize {
+        return plaintext_len + Ae.tag_length;
+    }
+
+    /// Encrypt into `out` as ciphertext || tag. `out` may start at
+    /// `plaintext` (in place) if it has room for the tag.
+    pub fn seal(
+        self: *const ConversationKey,
+        out: []u8,
+        nonce: Nonce,
+        plaintext: []const u8,
+        aad: []const u8,
+    ) []u8 {
+        std.debug.assert(out.len >= sealedLength(plaintext.len));
+        Ae.encrypt(out[0..plaintext.len], out[plaintext.len..][0..Ae.tag_length], plaintext, aad, nonce, self.key);
+        return out[0..sealedLength(plaintext.len)];
+    }
+
+    /// Verify and decrypt ciphertext || tag into `out`, which may start
+    /// at `sealed` (in place).
+    pub fn open(
+        self: *const ConversationKey,
+        out: []u8,
+        nonce: Nonce,
+        sealed: []const u8,
+        aad: []const u8,
+    ) ![]u8 {
+        if (sealed.len < Ae.tag_length) return error.CiphertextTooShort;
+        const msg_len = sealed.len - Ae.tag_length;
+        std.debug.assert(out.len >= msg_len);
+        const tag: Tag = sealed[msg_len..][0..Ae.tag_length].*;
+        try Ae.decrypt(out[0..msg_len], sealed[0..msg_len], tag, aad, nonce, self.key);
+        return out[0..msg_len];
+    }
+
+    pub fn wipe(self: *ConversationKey) void {
+        crypto.secureZero(u8, &self.key);
+    }
+};
+
+/// Conversation keys for one local identity, derived on first use per
+/// peer (X25519 + SHA-256) and cached until deinit.
+pub const KeyCache = struct {
+    allocator: std.mem.Allocator,
+    local_secret: [secret_length]u8,
+    keys: std.AutoHashMapUnmanaged([public_length]u8, ConversationKey),
+
+    pub fn init(allocator: std.mem.Allocator, local_secret: [secret_length]u8) KeyCache {
+        return .{
+            .allocator = allocator,
+            .local_secret = local_secret,
+            .keys = .{},
+        };
+    }
+
+    pub fn deinit(self: *KeyCache) void {
+        var it = self.keys.valueIterator();
+        while (it.next()) |key| key.wipe();
+        self.keys.deinit(self.allocator);
+        crypto.secureZero(u8, &self.local_secret);
+        self.* = undefined;
+    }
+
+    pub fn keyFor(self: *KeyCache, peer_public: [public_length]u8) !ConversationKey {
+        if (self.keys.get(peer_public)) |key| return key;
+        var shared = try deriveSharedSecret(self.local_secret, peer_public);
+        defer crypto.secureZero(u8, &shared.bytes);
+        const key = ConversationKey.fromShared(shared);
+        try self.keys.put(self.allocator, peer_public, key);
+        return key;
+    }
+};
+
+/// One-shot encrypt into a fresh buffer (ciphertext || tag).
+/// Hot paths should hold a ConversationKey and `seal` instead.
 pub fn encryptMessage(
     allocator: std.mem.Allocator,
     shared: SharedSecret,
@@ -38,18 +123,13 @@ pub fn encryptMessage(
     plaintext: []const u8,
     aad: []const u8,
 ) ![]u8 {
-    const mac = Ae.tag_length;
-    const buf = try allocator.alloc(u8, plaintext.len + mac);
-    errdefer allocator.free(buf);
-
-    const key = shared.symmetricKey();
-    const nonce_copy = nonce;
-    var tag: Tag = undefined;
-    Ae.encrypt(buf[0..plaintext.len], &tag, plaintext, aad, nonce_copy, key);
-    std.mem.copyForwards(u8, buf[plaintext.len..], tag[0..]);
-    return buf;
+    const buf = try allocator.alloc(u8, ConversationKey.sealedLength(plaintext.len));
+    const key = ConversationKey.fromShared(shared);
+    return key.seal(buf, nonce, plaintext, aad);
 }
 
+/// One-shot decrypt into a fresh buffer.
+/// Hot paths should hold a ConversationKey and `open` instead.
 pub fn decryptMessage(
     allocator: std.mem.Allocator,
     shared: SharedSecret,
@@ -58,18 +138,11 @@ pub fn decryptMessage(
     aad: []const u8,
 ) ![]u8 {
     if (ciphertext.len < Ae.tag_length) return error.CiphertextTooShort;
-    const msg_len = ciphertext.len - Ae.tag_length;
-
-    const key = shared.symmetricKey();
-    const nonce_copy = nonce;
-    var tag: Tag = undefined;
-    std.mem.copyForwards(u8, tag[0..], ciphertext[msg_len..]);
-
-    const plaintext = try allocator.alloc(u8, msg_len);
+    const plaintext = try allocator.alloc(u8, ciphertext.len - Ae.tag_length);
     errdefer allocator.free(plaintext);
 
-    try Ae.decrypt(plaintext, ciphertext[0..msg_len], tag, aad, nonce_copy, key);
-    return plaintext;
+    const key = ConversationKey.fromShared(shared);
+    return try key.open(plaintext, nonce, ciphertext, aad);
 }
 
 pub const DirectMessage = struct {
@@ -85,36 +158,173 @@ pub const DirectMessage = struct {
     }
 };
 
+/// Append-only conversation history. Sealed messages sit back to back in
+/// one byte arena; each record keeps its offset, nonce and participant
+/// indices, so appending thousands of messages costs a few amortized
+/// reallocations rather than one allocation each.
 pub const Conversation = struct {
+    pub const max_threads = 16;
+    // Below this many messages per worker, spawning costs more than it saves.
+    pub const min_messages_per_thread = 64;
+
+    pub const Record = struct {
+        offset: u32,
+        len: u32,
+        nonce: Nonce,
+        timestamp: i64,
+        sender: u16,
+        receiver: u16,
+    };
+
     allocator: std.mem.Allocator,
-    messages: std.ArrayListUnmanaged(DirectMessage),
+    bytes: std.ArrayListUnmanaged(u8),
+    records: std.ArrayListUnmanaged(Record),
+    participants: std.ArrayListUnmanaged([public_length]u8),
 
     pub fn init(allocator: std.mem.Allocator) Conversation {
         return .{
             .allocator = allocator,
-            .messages = .{},
+            .bytes = .{},
+            .records = .{},
+            .participants = .{},
         };
     }
 
     pub fn deinit(self: *Conversation) void {
-        for (self.messages.items) |*msg| {
-            msg.deinit(self.allocator);
-        }
-        self.messages.deinit(self.allocator);
-        self.messages = .{};
+        self.bytes.deinit(self.allocator);
+        self.records.deinit(self.allocator);
+        self.participants.deinit(self.allocator);
+        self.bytes = .{};
+        self.records = .{};
+        self.participants = .{};
     }
 
+    /// Append a message, taking ownership of (and freeing) its ciphertext.
     pub fn append(self: *Conversation, message: DirectMessage) !void {
-        try self.messages.append(self.allocator, message);
+        try self.appendSealed(message.sender, message.receiver, message.nonce, message.ciphertext, message.timestamp);
+        self.allocator.free(message.ciphertext);
     }
 
-    pub fn count(self: *Conversation) usize {
-        return self.messages.items.len;
+    /// Append a sealed message, copying it into the arena.
+    pub fn appendSealed(
+        self: *Conversation,
+        sender: [public_length]u8,
+        receiver: [public_length]u8,
+        nonce: Nonce,
+        sealed: []const u8,
+        timestamp: i64,
+    ) !void {
+        if (sealed.len < Ae.tag_length) return error.CiphertextTooShort;
+        if (self.bytes.items.len + sealed.len > std.math.maxInt(u32)) return error.ConversationTooLarge;
+        const sender_index = try self.participantIndex(sender);
+        const receiver_index = try self.participantIndex(receiver);
+        try self.records.ensureUnusedCapacity(self.allocator, 1);
+        const offset: u32 = @intCast(self.bytes.items.len);
+        try self.bytes.appendSlice(self.allocator, sealed);
+        self.records.appendAssumeCapacity(.{
+            .offset = offset,
+            .len = @intCast(sealed.len),
+            .nonce = nonce,
+            .timestamp = timestamp,
+            .sender = sender_index,
+            .receiver = receiver_index,
+        });
     }
 
-    pub fn last(self: *Conversation) ?DirectMessage {
-        if (self.messages.items.len == 0) return null;
-        return self.messages.items[self.messages.items.len - 1];
+    pub fn count(self: *const Conversation) usize {
+        return self.records.items.len;
+    }
+
+    /// Message `index` as a view; its ciphertext is borrowed from the
+    /// arena (do not deinit it).
+    pub fn get(self: *const Conversation, index: usize) DirectMessage {
+        const record = self.records.items[index];
+        return .{
+            .sender = self.participants.items[record.sender],
+            .receiver = self.participants.items[record.receiver],
+            .nonce = record.nonce,
+            .ciphertext = self.bytes.items[record.offset..][0..record.len],
+            .timestamp = record.timestamp,
+        };
+    }
+
+    pub fn last(self: *const Conversation) ?DirectMessage {
+        if (self.records.items.len == 0) return null;
+        return self.get(self.records.items.len - 1);
+    }
+
+    /// Total plaintext size of every message (arena minus tags).
+    pub fn plaintextLength(self: *const Conversation) usize {
+        return self.bytes.items.len - self.records.items.len * Ae.tag_length;
+    }
+
+    /// Decrypt the whole history into `plaintext` (plaintextLength bytes,
+    /// messages back to back) on up to `thread_count` threads, balanced by
+    /// bytes. `opened[i]` is message i's plaintext, or null if it failed
+    /// authentication. Nothing is allocated.
+    pub fn openAll(
+        self: *const Conversation,
+        key: *const ConversationKey,
+        aad: []const u8,
+        plaintext: []u8,
+        opened: []?[]u8,
+        thread_count: usize,
+    ) void {
+        const n = self.records.items.len;
+        std.debug.assert(plaintext.len >= self.plaintextLength());
+        std.debug.assert(opened.len >= n);
+        const workers = @max(1, @min(thread_count, max_threads, n / min_messages_per_thread));
+
+        var bounds: [max_threads + 1]usize = undefined;
+        bounds[0] = 0;
+        bounds[workers] = n;
+        var i: usize = 0;
+        var w: usize = 1;
+        while (w < workers) : (w += 1) {
+            const target = self.bytes.items.len * w / workers;
+            while (i < n and self.records.items[i].offset < target) i += 1;
+            bounds[w] = i;
+        }
+
+        var threads: [max_threads]std.Thread = undefined;
+        var spawned: usize = 0;
+        defer for (threads[0..spawned]) |thread| thread.join();
+        w = 1;
+        while (w < workers) : (w += 1) {
+            const range = .{ self, key, aad, plaintext, opened, bounds[w], bounds[w + 1] };
+            threads[spawned] = std.Thread.spawn(.{}, openRange, range) catch {
+                @call(.auto, openRange, range);
+                continue;
+            };
+            spawned += 1;
+        }
+        openRange(self, key, aad, plaintext, opened, bounds[0], bounds[1]);
+    }
+
+    fn openRange(
+        self: *const Conversation,
+        key: *const ConversationKey,
+        aad: []const u8,
+        plaintext: []u8,
+        opened: []?[]u8,
+        start: usize,
+        end: usize,
+    ) void {
+        for (self.records.items[start..end], start..) |record, i| {
+            // Every earlier record carries exactly one tag.
+            const out = plaintext[record.offset - i * Ae.tag_length ..];
+            const sealed = self.bytes.items[record.offset..][0..record.len];
+            opened[i] = key.open(out, record.nonce, sealed, aad) catch null;
+        }
+    }
+
+    fn participantIndex(self: *Conversation, public_key: [public_length]u8) !u16 {
+        for (self.participants.items, 0..) |known, i| {
+            if (std.mem.eql(u8, &known, &public_key)) return @intCast(i);
+        }
+        if (self.participants.items.len == std.math.maxInt(u16)) return error.TooManyParticipants;
+        try self.participants.append(self.allocator, public_key);
+        return @intCast(self.participants.items.len - 1);
     }
 };
 
@@ -172,3 +382,80 @@ test "conversation appends and frees" {
     dm = undefined;
     try std.testing.expectEqual(@as(usize, 1), convo.count());
 }
+
+test "conversation key seals and opens in place" {
+    const alice = try X25519.KeyPair.generateDeterministic([_]u8{0x31} ** secret_length);
+    const bob = try X25519.KeyPair.generateDeterministic([_]u8{0x32} ** secret_length);
+
+    var alice_keys = KeyCache.init(std.testing.allocator, alice.secret_key);
+    defer alice_keys.deinit();
+    var bob_keys = KeyCache.init(std.testing.allocator, bob.secret_key);
+    defer bob_keys.deinit();
+
+    const sending = try alice_keys.keyFor(bob.public_key);
+    const cached = try alice_keys.keyFor(bob.public_key);
+    try std.testing.expectEqualSlices(u8, &sending.key, &cached.key);
+    try std.testing.expectEqual(@as(u32, 1), alice_keys.keys.count());
+    const receiving = try bob_keys.keyFor(alice.public_key);
+
+    const nonce: Nonce = [_]u8{0xCC} ** Ae.nonce_length;
+    const plain = "in place, no allocation";
+    var buf: [plain.len + Ae.tag_length]u8 = undefined;
+    @memcpy(buf[0..plain.len], plain);
+
+    const sealed = sending.seal(&buf, nonce, buf[0..plain.len], "aad");
+    try std.testing.expect(!std.mem.eql(u8, sealed[0..plain.len], plain));
+    const opened = try receiving.open(&buf, nonce, sealed, "aad");
+    try std.testing.expectEqualSlices(u8, plain, opened);
+
+    _ = sending.seal(&buf, nonce, plain, "aad");
+    buf[0] ^= 1;
+    try std.testing.expectError(error.AuthenticationFailed, receiving.open(&buf, nonce, &buf, "aad"));
+}
+
+test "conversation opens its history across threads" {
+    const alice = try X25519.KeyPair.generateDeterministic([_]u8{0x41} ** secret_length);
+    const bob = try X25519.KeyPair.generateDeterministic([_]u8{0x42} ** secret_length);
+    const key = ConversationKey.fromShared(try deriveSharedSecret(alice.secret_key, bob.public_key));
+
+    var convo = Conversation.init(std.testing.allocator);
+    defer convo.deinit();
+
+    const total = 1000;
+    var text_buf: [64]u8 = undefined;
+    var sealed_buf: [64 + Ae.tag_length]u8 = undefined;
+    var i: u32 = 0;
+    while (i < total) : (i += 1) {
+        const text = try std.fmt.bufPrint(&text_buf, "message {d} {s}", .{ i, "glow" ** 4 });
+        var nonce: Nonce = [_]u8{0} ** Ae.nonce_length;
+        std.mem.writeInt(u32, nonce[0..4], i, .little);
+        const sealed = key.seal(&sealed_buf, nonce, text, "dm");
+        if (i == 500) sealed[3] ^= 0x80; // Tampered
+        const from_alice = i % 2 == 0;
+        try convo.appendSealed(
+            if (from_alice) alice.public_key else bob.public_key,
+            if (from_alice) bob.public_key else alice.public_key,
+            nonce,
+            sealed,
+            i,
+        );
+    }
+    try std.testing.expectEqual(@as(usize, 2), convo.participants.items.len);
+
+    const plaintext = try std.testing.allocator.alloc(u8, convo.plaintextLength());
+    defer std.testing.allocator.free(plaintext);
+    const opened = try std.testing.allocator.alloc(?[]u8, convo.count());
+    defer std.testing.allocator.free(opened);
+
+    convo.openAll(&key, "dm", plaintext, opened, 4);
+    i = 0;
+    while (i < total) : (i += 1) {
+        if (i == 500) {
+            try std.testing.expect(opened[i] == null);
+            continue;
+        }
+        const text = try std.fmt.bufPrint(&text_buf, "message {d} {s}", .{ i, "glow" ** 4 });
+        try std.testing.expectEqualStrings(text, opened[i].?);
+    }
+    try std.testing.expectEqual(@as(i64, total - 1), convo.last().?.timestamp);
+}
@@ -1,4 +1,5 @@
 const std = @import("std");
+const Places = @import("dream_browser_places.zig").Places;
 
 /// Dream Browser Bookmarks: Bookmark management and history tracking.
 /// ~<~ Glow Airbend: explicit bookmark storage, bounded history.
@@ -9,12 +10,16 @@ const std = @import("std");
 /// - Bookmark organization (folders, tags)
 /// - History tracking (visited URLs, timestamps)
 /// - Search and filtering (by title, URL, tag)
+/// - Omnibox search over bookmarks and history, ranked by frecency
+///
+/// URLs and titles are interned once per place (see Places); the history
+/// log stores place ids, not per-visit string copies.
 pub const DreamBrowserBookmarks = struct {
     // Bounded: Max 10,000 bookmarks
     pub const MAX_BOOKMARKS: u32 = 10_000;
     
-    // Bounded: Max 1,000 history entries
-    pub const MAX_HISTORY_ENTRIES: u32 = 1_000;
+    // Bounded: Max 100,000 history entries
+    pub const MAX_HISTORY_ENTRIES: u32 = 100_000;
     
     // Bounded: Max 256 characters for title/URL
     pub const MAX_TITLE_LENGTH: u32 = 256;
@@ -35,7 +40,7 @@ pub const DreamBrowserBookmarks = struct {
         visit_count: u32, // Number of visits
     };
     
-    /// History entry.
+    /// History entry (view; url and title borrow from the string table).
     pub const HistoryEntry = struct {
         url: []const u8, // Visited URL
         title: []const u8, // Page title
@@ -43,6 +48,13 @@ pub const DreamBrowserBookmarks = struct {
         visit_duration: u32, // Visit duration in seconds
     };
     
+    /// Logged visit: place id instead of URL and title copies.
+    pub const Visit = struct {
+        place: u32, // Places index
+        visited_at: u64, // Visit timestamp
+        visit_duration: u32, // Visit duration in seconds
+    };
+    
     /// Bookmark folder.
     pub const BookmarkFolder = struct {
         name: []const u8, // Folder name
@@ -61,14 +73,15 @@ pub const DreamBrowserBookmarks = struct {
     
     /// History storage.
     pub const HistoryStorage = struct {
-        entries: []HistoryEntry, // History entries
+        entries: []Visit, // History visits
         entries_len: u32, // Current number of entries
-        entries_index: u32, // Circular buffer index
+        entries_index: u32, // Circular buffer index (next write)
     };
     
     allocator: std.mem.Allocator,
     bookmarks_storage: BookmarksStorage,
     history_storage: HistoryStorage,
+    places: Places,
     
     /// Initialize bookmarks manager.
     pub fn init(allocator: std.mem.Allocator) !DreamBrowserBookmarks {
@@ -77,7 +90,7 @@ pub const DreamBrowserBookmarks = struct {
         const folders = try allocator.alloc(BookmarkFolder, 100); // Max 100 folders
         
         // Pre-allocate history storage
-        const history_entries = try allocator.alloc(HistoryEntry, MAX_HISTORY_ENTRIES);
+        const history_entries = try allocator.alloc(Visit, MAX_HISTORY_ENTRIES);
         
         return DreamBrowserBookmarks{
             .allocator = allocator,
@@ -92,6 +105,7 @@ pub const DreamBrowserBookmarks = struct {
                 .entries_len = 0,
                 .entries_index = 0,
             },
+            .places = Places.init(allocator),
         };
     }
     
@@ -121,16 +135,11 @@ pub const DreamBrowserBookmarks = struct {
             self.allocator.free(folder.bookmarks);
         }
         
-        // Free history entries
-        for (self.history_storage.entries[0..self.history_storage.entries_len]) |*entry| {
-            self.allocator.free(entry.url);
-            self.allocator.free(entry.title);
-        }
-        
         // Free arrays
         self.allocator.free(self.bookmarks_storage.bookmarks);
         self.allocator.free(self.bookmarks_storage.folders);
         self.allocator.free(self.history_storage.entries);
+        self.places.deinit();
     }
     
     /// Add bookmark.
@@ -175,6 +184,12 @@ pub const DreamBrowserBookmarks = struct {
         
         // Create empty tags array
         const tags = try self.allocator.alloc([]const u8, MAX_TAGS_PER_BOOKMARK);
+        errdefer self.allocator.free(tags);
+        
+        // Index the bookmark as a place (created unvisited if new). Last
+        // fallible step: a failed copy above leaves places untouched.
+        const now = get_current_timestamp();
+        const place = try self.places.touch(url, title, now);
         
         // Add bookmark
         const idx = self.bookmarks_storage.bookmarks_len;
@@ -184,11 +199,12 @@ pub const DreamBrowserBookmarks = struct {
             .folder = folder_copy,
             .tags = tags,
             .tags_len = 0, // No tags added yet
-            .created_at = get_current_timestamp(),
-            .last_visited = get_current_timestamp(),
+            .created_at = now,
+            .last_visited = now,
             .visit_count = 1,
         };
         self.bookmarks_storage.bookmarks_len += 1;
+        self.places.set_bookmark(place, idx);
         
         return idx;
     }
@@ -200,6 +216,9 @@ pub const DreamBrowserBookmarks = struct {
         }
         
         const bookmark = &self.bookmarks_storage.bookmarks[bookmark_idx];
+        if (self.places.find(bookmark.url)) |place| {
+            self.places.set_bookmark(place, Places.NO_BOOKMARK);
+        }
         
         // Free bookmark data
         self.allocator.free(bookmark.url);
@@ -222,6 +241,9 @@ pub const DreamBrowserBookmarks = struct {
             const last_idx = self.bookmarks_storage.bookmarks_len - 1;
             if (bookmark_idx != last_idx) {
                 self.bookmarks_storage.bookmarks[bookmark_idx] = self.bookmarks_storage.bookmarks[last_idx];
+                if (self.places.find(self.bookmarks_storage.bookmarks[bookmark_idx].url)) |place| {
+                    self.places.set_bookmark(place, bookmark_idx);
+                }
             }
         }
         
@@ -242,6 +264,17 @@ pub const DreamBrowserBookmarks = struct {
         url: []const u8,
         title: []const u8,
         visit_duration: u32,
+    ) !void {
+        try self.add_history_entry_at(url, title, visit_duration, get_current_timestamp());
+    }
+    
+    /// Add history entry visited at `visited_at` (seconds).
+    pub fn add_history_entry_at(
+        self: *DreamBrowserBookmarks,
+        url: []const u8,
+        title: []const u8,
+        visit_duration: u32,
+        visited_at: u64,
     ) !void {
         // Assert: URL and title must be non-empty
         std.debug.assert(url.len > 0);
@@ -249,45 +282,27 @@ pub const DreamBrowserBookmarks = struct {
         std.debug.assert(title.len > 0);
         std.debug.assert(title.len <= MAX_TITLE_LENGTH);
         
-        // Copy URL and title
-        const url_copy = try self.allocator.dupe(u8, url);
-        errdefer self.allocator.free(url_copy);
-        
-        const title_copy = try self.allocator.dupe(u8, title);
-        errdefer self.allocator.free(title_copy);
+        const place = try self.places.visit(url, title, visited_at);
+        const visit = Visit{
+            .place = place,
+            .visited_at = visited_at,
+            .visit_duration = visit_duration,
+        };
         
         // Add to history (or overwrite oldest if full)
+        const idx = self.history_storage.entries_index;
         if (self.history_storage.entries_len < MAX_HISTORY_ENTRIES) {
-            const idx = self.history_storage.entries_len;
-            self.history_storage.entries[idx] = HistoryEntry{
-                .url = url_copy,
-                .title = title_copy,
-                .visited_at = get_current_timestamp(),
-                .visit_duration = visit_duration,
-            };
             self.history_storage.entries_len += 1;
         } else {
-            // Overwrite oldest entry (circular buffer)
-            const idx = self.history_storage.entries_index;
-            const old_entry = &self.history_storage.entries[idx];
-            
-            // Free old entry
-            self.allocator.free(old_entry.url);
-            self.allocator.free(old_entry.title);
-            
-            // Set new entry
-            self.history_storage.entries[idx] = HistoryEntry{
-                .url = url_copy,
-                .title = title_copy,
-                .visited_at = get_current_timestamp(),
-                .visit_duration = visit_duration,
-            };
-            
-            self.history_storage.entries_index = (idx + 1) % MAX_HISTORY_ENTRIES;
+            // Overwrite oldest entry (circular buffer); its place may now be evicted
+            self.places.drop_log_ref(self.history_storage.entries[idx].place);
         }
+        self.history_storage.entries[idx] = visit;
+        self.history_storage.entries_index = (idx + 1) % MAX_HISTORY_ENTRIES;
     }
     
     /// Get history entries (recent first).
+    /// Note: Caller frees the array; url/title are valid until the next add.
     pub fn get_history_entries(self: *const DreamBrowserBookmarks, max_count: u32) []const HistoryEntry {
         const count = @min(max_count, self.history_storage.entries_len);
         if (count == 0) {
@@ -299,18 +314,23 @@ pub const DreamBrowserBookmarks = struct {
             return &.{};
         };
         
-        // Copy entries in reverse order (newest first)
-        var i: u32 = 0;
-        var src_idx: u32 = self.history_storage.entries_len;
-        while (i < count and src_idx > 0) : (i += 1) {
-            src_idx -= 1;
-            result[i] = self.history_storage.entries[src_idx];
+        // Walk back from the newest visit
+        var src_idx: u32 = self.history_storage.entries_index;
+        for (result) |*entry| {
+            src_idx = (src_idx + MAX_HISTORY_ENTRIES - 1) % MAX_HISTORY_ENTRIES;
+            const visit = self.history_storage.entries[src_idx];
+            entry.* = HistoryEntry{
+                .url = self.places.url(visit.place),
+                .title = self.places.title(visit.place),
+                .visited_at = visit.visited_at,
+                .visit_duration = visit.visit_duration,
+            };
         }
         
-        return result[0..count];
+        return result;
     }
     
-    /// Search bookmarks by title or URL.
+    /// Search bookmarks by title or URL word prefixes, most frecent first.
     /// Note: Returns slice pointing to allocated array (caller must free).
     pub fn search_bookmarks(
         self: *DreamBrowserBookmarks,
@@ -319,41 +339,35 @@ pub const DreamBrowserBookmarks = struct {
         // Assert: Query must be non-empty
         std.debug.assert(query.len > 0);
         
-        // Count matching bookmarks
-        var match_count: u32 = 0;
-        var i: u32 = 0;
-        while (i < self.bookmarks_storage.bookmarks_len) : (i += 1) {
-            const bookmark = &self.bookmarks_storage.bookmarks[i];
-            if (std.mem.indexOf(u8, bookmark.title, query) != null or
-                std.mem.indexOf(u8, bookmark.url, query) != null)
-            {
-                match_count += 1;
-            }
-        }
-        
-        if (match_count == 0) {
-            return &.{};
-        }
-        
-        // Allocate result array (caller must free)
-        const result = self.allocator.alloc(u32, match_count) catch {
+        const places = self.places.all_matches(self.allocator, query, true) catch {
             return &.{};
         };
-        
-        // Collect matching indices
-        var result_idx: u32 = 0;
-        i = 0;
-        while (i < self.bookmarks_storage.bookmarks_len) : (i += 1) {
-            const bookmark = &self.bookmarks_storage.bookmarks[i];
-            if (std.mem.indexOf(u8, bookmark.title, query) != null or
-                std.mem.indexOf(u8, bookmark.url, query) != null)
-            {
-                result[result_idx] = i;
-                result_idx += 1;
-            }
+        if (places.len == 0) {
+            self.allocator.free(places);
+            return &.{};
         }
         
-        return result[0..match_count];
+        // Map places to bookmark indices in place
+        for (places) |*slot| {
+            slot.* = self.places.get(slot.*).bookmark;
+        }
+        return places;
+    }
+    
+    /// Start an omnibox query over bookmarks and history (cancels the
+    /// previous one). Call `continue_omnibox` each frame until done.
+    pub fn begin_omnibox(self: *DreamBrowserBookmarks, query: []const u8) u64 {
+        return self.places.begin_query(query, false);
+    }
+    
+    /// Check up to `budget` candidates for the omnibox query.
+    pub fn continue_omnibox(self: *DreamBrowserBookmarks, ticket: u64, budget: u32) Places.Status {
+        return self.places.continue_query(ticket, budget);
+    }
+    
+    /// Best omnibox results so far, or null for a stale ticket.
+    pub fn omnibox_results(self: *const DreamBrowserBookmarks, ticket: u64) ?[]const Places.Result {
+        return self.places.results(ticket);
     }
     
     /// Get current timestamp (simplified).
@@ -369,6 +383,7 @@ pub const DreamBrowserBookmarks = struct {
             .bookmarks_count = self.bookmarks_storage.bookmarks_len,
             .history_count = self.history_storage.entries_len,
             .folders_count = self.bookmarks_storage.folders_len,
+            .places_count = self.places.place_count,
             .max_bookmarks = MAX_BOOKMARKS,
             .max_history = MAX_HISTORY_ENTRIES,
         };
@@ -379,6 +394,7 @@ pub const DreamBrowserBookmarks = struct {
         bookmarks_count: u32,
         history_count: u32,
         folders_count: u32,
+        places_count: u32,
         max_bookmarks: u32,
         max_history: u32,
     };
@@ -459,3 +475,36 @@ test "bookmarks stats" {
     try std.testing.expect(stats.max_history == DreamBrowserBookmarks.MAX_HISTORY_ENTRIES);
 }
 
+test "bookmarks omnibox" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+    
+    var bookmarks = try DreamBrowserBookmarks.init(arena.allocator());
+    defer bookmarks.deinit();
+    
+    const now: u64 = 1_700_000_000;
+    var i: u64 = 0;
+    while (i < 50) : (i += 1) {
+        try bookmarks.add_history_entry_at("https://ziglang.org/documentation", "Zig Documentation", 5, now - 1000 + i);
+    }
+    try bookmarks.add_history_entry_at("https://zig.news", "Zig News", 5, now);
+    _ = try bookmarks.add_bookmark("https://zigzag.example", "Zigzag", null);
+    
+    // Assert: Repeat visits share one place and one URL/title copy
+    const stats = bookmarks.get_stats();
+    try std.testing.expect(stats.history_count == 51);
+    try std.testing.expect(stats.places_count == 3);
+    try std.testing.expect(bookmarks.places.strings.live == 6);
+    
+    const ticket = bookmarks.begin_omnibox("zig doc");
+    while (bookmarks.continue_omnibox(ticket, 1) == .running) {}
+    const found = bookmarks.omnibox_results(ticket).?;
+    try std.testing.expect(found.len == 1);
+    try std.testing.expectEqualStrings("Zig Documentation", bookmarks.places.title(found[0].place));
+    
+    // Assert: Newest history entry first
+    const history = bookmarks.get_history_entries(2);
+    try std.testing.expect(history.len == 2);
+    try std.testing.expectEqualStrings("https://zig.news", history[0].url);
+    try std.testing.expect(history[1].visited_at == now - 1000 + 49);
+}
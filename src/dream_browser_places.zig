@@ -0,0 +1,800 @@
+const std = @import("std");
+const bounded_map = @import("grain_os/bounded_map.zig");
+
+/// Dream Browser Places: interned URLs and titles, frecency, omnibox search.
+/// ~<~ Glow Airbend: every URL stored once, every query step bounded.
+/// ~~~~ Glow Waterbend: visits fade like ripples; fresh ones rise.
+///
+/// A place is one distinct URL (bookmarked, visited, or both). URL and title
+/// bytes live once in a StringTable however often the page is visited.
+/// Every lowercase word of a place's URL and title is indexed under its 1-,
+/// 2- and 3-byte prefixes. A query walks the shortest posting among its
+/// words' prefixes, checks that every query word prefixes some word of the
+/// place, and keeps the best MAX_RESULTS by frecency.
+///
+/// Frecency is visit weight decayed by age (HALF_LIFE_SECONDS). It is kept
+/// in log form, key = log2(score) + time / half_life, so places compare
+/// directly without recomputing decay at query time.
+pub const StringTable = struct {
+    const Entry = struct {
+        offset: u32,
+        len: u32,
+        hash: u64,
+        refs: u32,
+    };
+
+    // Compact once dead bytes pass this and half the byte pool.
+    const COMPACT_MIN_DEAD_BYTES: usize = 64 * 1024;
+
+    const SlotTable = bounded_map.OpenTable(u32, 0);
+
+    // String lookup for SlotTable.find.
+    const SlotKey = struct {
+        table: *const StringTable,
+        str: []const u8,
+        hash: u64,
+
+        fn matches(key: SlotKey, slot: u32) bool {
+            const entry = key.table.entries.items[slot - 1];
+            return entry.hash == key.hash and
+                std.mem.eql(u8, key.table.bytes.items[entry.offset..][0..entry.len], key.str);
+        }
+    };
+
+    allocator: std.mem.Allocator,
+    bytes: std.ArrayListUnmanaged(u8) = .{},
+    entries: std.ArrayListUnmanaged(Entry) = .{},
+    free_ids: std.ArrayListUnmanaged(u32) = .{},
+    slots: []u32 = &.{}, // Open addressing: entry id + 1, 0 = empty
+    live: u32 = 0,
+    dead_bytes: usize = 0,
+
+    pub fn init(allocator: std.mem.Allocator) StringTable {
+        return StringTable{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *StringTable) void {
+        self.bytes.deinit(self.allocator);
+        self.entries.deinit(self.allocator);
+        self.free_ids.deinit(self.allocator);
+        self.allocator.free(self.slots);
+        self.* = undefined;
+    }
+
+    /// Intern `str` (taking a reference); equal strings share one id.
+    pub fn intern(self: *StringTable, str: []const u8) !u32 {
+        std.debug.assert(str.len <= std.math.maxInt(u32));
+        const hash = std.hash.Wyhash.hash(0, str);
+        if (self.find_slot(str, hash)) |slot| {
+            const id = self.slots[slot] - 1;
+            self.entries.items[id].refs += 1;
+            return id;
+        }
+
+        if ((self.live + 1) * 2 > self.slots.len) {
+            try self.resize_slots(@max(64, self.slots.len * 2));
+        }
+        if (self.dead_bytes > COMPACT_MIN_DEAD_BYTES and self.dead_bytes * 2 > self.bytes.items.len) {
+            self.compact();
+        }
+        try self.entries.ensureUnusedCapacity(self.allocator, 1);
+        try self.bytes.ensureUnusedCapacity(self.allocator, str.len);
+
+        const entry = Entry{
+            .offset = @intCast(self.bytes.items.len),
+            .len = @intCast(str.len),
+            .hash = hash,
+            .refs = 1,
+        };
+        self.bytes.appendSliceAssumeCapacity(str);
+        var id: u32 = @intCast(self.entries.items.len);
+        if (self.free_ids.items.len > 0) {
+            id = self.free_ids.items[self.free_ids.items.len - 1];
+            self.free_ids.items.len -= 1;
+            self.entries.items[id] = entry;
+        } else {
+            self.entries.appendAssumeCapacity(entry);
+        }
+        self.insert_slot(id, hash);
+        self.live += 1;
+        return id;
+    }
+
+    /// Id of `str` if interned (no reference taken).
+    pub fn lookup(self: *const StringTable, str: []const u8) ?u32 {
+        const slot = self.find_slot(str, std.hash.Wyhash.hash(0, str)) orelse return null;
+        return self.slots[slot] - 1;
+    }
+
+    /// Drop one reference; the string dies with its last one.
+    pub fn release(self: *StringTable, id: u32) void {
+        const entry = &self.entries.items[id];
+        std.debug.assert(entry.refs > 0);
+        entry.refs -= 1;
+        if (entry.refs > 0) return;
+        self.remove_slot(id);
+        self.dead_bytes += entry.len;
+        self.live -= 1;
+        // On failure the id is leaked (never reused); the table stays correct.
+        self.free_ids.append(self.allocator, id) catch {};
+    }
+
+    /// Bytes of an interned string (valid until the next intern).
+    pub fn get(self: *const StringTable, id: u32) []const u8 {
+        const entry = self.entries.items[id];
+        std.debug.assert(entry.refs > 0);
+        return self.bytes.items[entry.offset..][0..entry.len];
+    }
+
+    fn home(hash: u64) usize {
+        return @truncate(hash);
+    }
+
+    // Slots hold entry id + 1; a slot's home is its string's hash.
+    fn slot_home(self: *const StringTable, slot: u32) usize {
+        return home(self.entries.items[slot - 1].hash);
+    }
+
+    fn id_matches(id: u32, slot: u32) bool {
+        return slot == id + 1;
+    }
+
+    fn find_slot(self: *const StringTable, str: []const u8, hash: u64) ?usize {
+        if (self.slots.len == 0) return null;
+        const key = SlotKey{ .table = self, .str = str, .hash = hash };
+        return SlotTable.find(self.slots, home(hash), key, SlotKey.matches);
+    }
+
+    fn insert_slot(self: *StringTable, id: u32, hash: u64) void {
+        _ = SlotTable.insert(self.slots, home(hash), id + 1);
+    }
+
+    // Unlink a dead string's slot so lookups stop finding it.
+    fn remove_slot(self: *StringTable, id: u32) void {
+        const pos = SlotTable.find(self.slots, home(self.entries.items[id].hash), id, id_matches).?;
+        SlotTable.remove_at(self.slots, pos, @as(*const StringTable, self), slot_home);
+    }
+
+    fn resize_slots(self: *StringTable, capacity: usize) !void {
+        std.debug.assert(std.math.isPowerOfTwo(capacity));
+        const slots = try self.allocator.alloc(u32, capacity);
+        @memset(slots, 0);
+        self.allocator.free(self.slots);
+        self.slots = slots;
+        for (self.entries.items, 0..) |entry, id| {
+            if (entry.refs > 0) self.insert_slot(@intCast(id), entry.hash);
+        }
+    }
+
+    // Copy live strings into a fresh pool; ids stay, offsets move.
+    fn compact(self: *StringTable) void {
+        var bytes = std.ArrayListUnmanaged(u8).initCapacity(
+            self.allocator,
+            self.bytes.items.len - self.dead_bytes,
+        ) catch return;
+        for (self.entries.items) |*entry| {
+            if (entry.refs == 0) continue;
+            const offset: u32 = @intCast(bytes.items.len);
+            bytes.appendSliceAssumeCapacity(self.bytes.items[entry.offset..][0..entry.len]);
+            entry.offset = offset;
+        }
+        self.bytes.deinit(self.allocator);
+        self.bytes = bytes;
+        self.dead_bytes = 0;
+    }
+};
+
+pub const Places = struct {
+    // Bounded: Max 131,072 places (history ring + bookmarks always fit).
+    pub const MAX_PLACES: u32 = 131_072;
+
+    // Bounded: Max 32 ranked results per query.
+    pub const MAX_RESULTS: u32 = 32;
+
+    // Bounded: Max 8 words per query, 64 bytes per word.
+    pub const MAX_QUERY_WORDS: u32 = 8;
+    pub const MAX_WORD_LENGTH: u32 = 64;
+
+    // Visit weight halves every 30 days.
+    pub const HALF_LIFE_SECONDS: f64 = 30 * 24 * 60 * 60;
+
+    // Bookmarks rank as if visited 4x as much (log2 units).
+    pub const BOOKMARK_BOOST: f64 = 2.0;
+
+    pub const NO_BOOKMARK: u32 = std.math.maxInt(u32);
+
+    // Rebuild postings once stale entries pass this and half the total.
+    const REBUILD_MIN_STALE: usize = 4096;
+
+    pub const Place = struct {
+        url: u32, // StringTable id
+        title: u32, // StringTable id
+        visit_count: u32,
+        last_visit: u64,
+        frecency: f64, // log2(score) + time / HALF_LIFE_SECONDS
+        bookmark: u32, // Bookmark index or NO_BOOKMARK
+        log_refs: u32, // History-log visits pointing here
+        indexed: u32, // Posting entries added for this place
+        alive: bool,
+    };
+
+    pub const Result = struct {
+        place: u32,
+        rank: f64,
+    };
+
+    pub const Status = enum(u8) {
+        running,
+        done,
+        cancelled,
+    };
+
+    const Query = struct {
+        words: [MAX_QUERY_WORDS][MAX_WORD_LENGTH]u8 = undefined,
+        word_lens: [MAX_QUERY_WORDS]u8 = undefined,
+        words_len: u32 = 0,
+        key: u32 = 0,
+        has_key: bool = false,
+        bookmarks_only: bool = false,
+        stamp: u32 = 0,
+        cursor: u32 = 0,
+        layout: u64 = 0,
+        results: [MAX_RESULTS]Result = undefined,
+        results_len: u32 = 0,
+        status: Status = .done,
+
+        fn word(self: *const Query, i: usize) []const u8 {
+            return self.words[i][0..self.word_lens[i]];
+        }
+    };
+
+    allocator: std.mem.Allocator,
+    strings: StringTable,
+    places: std.ArrayListUnmanaged(Place) = .{},
+    free_places: std.ArrayListUnmanaged(u32) = .{},
+    place_count: u32 = 0,
+    by_url: std.AutoHashMapUnmanaged(u32, u32) = .{}, // URL string id -> place
+    postings: std.AutoHashMapUnmanaged(u32, std.ArrayListUnmanaged(u32)) = .{},
+    posting_entries: usize = 0,
+    stale_entries: usize = 0,
+    layout: u64 = 0, // Bumped by rebuilds; running queries are cancelled
+    scratch_keys: std.ArrayListUnmanaged(u32) = .{},
+    seen: std.ArrayListUnmanaged(u32) = .{}, // Per-place query stamp
+    stamp: u32 = 0,
+    generation: u64 = 0,
+    query: Query = .{},
+
+    pub fn init(allocator: std.mem.Allocator) Places {
+        return Places{
+            .allocator = allocator,
+            .strings = StringTable.init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *Places) void {
+        self.clear_postings();
+        self.postings.deinit(self.allocator);
+        self.by_url.deinit(self.allocator);
+        self.places.deinit(self.allocator);
+        self.free_places.deinit(self.allocator);
+        self.scratch_keys.deinit(self.allocator);
+        self.seen.deinit(self.allocator);
+        self.strings.deinit();
+        self.* = undefined;
+    }
+
+    pub fn url(self: *const Places, place: u32) []const u8 {
+        return self.strings.get(self.places.items[place].url);
+    }
+
+    pub fn title(self: *const Places, place: u32) []const u8 {
+        return self.strings.get(self.places.items[place].title);
+    }
+
+    pub fn get(self: *const Places, place: u32) *const Place {
+        std.debug.assert(self.places.items[place].alive);
+        return &self.places.items[place];
+    }
+
+    /// Place for `url_text`, if known.
+    pub fn find(self: *const Places, url_text: []const u8) ?u32 {
+        const url_id = self.strings.lookup(url_text) orelse return null;
+        return self.by_url.get(url_id);
+    }
+
+    /// Record a visit at `now` (seconds). The visit counts as one history-log
+    /// reference until `drop_log_ref`.
+    pub fn visit(self: *Places, url_text: []const u8, title_text: []const u8, now: u64) !u32 {
+        const place_id = try self.touch(url_text, title_text, now);
+        const place = &self.places.items[place_id];
+        const t = half_lives(now);
+        if (place.visit_count == 0) {
+            place.frecency = t;
+        } else {
+            place.frecency = t + std.math.log2(std.math.exp2(place.frecency - t) + 1.0);
+        }
+        place.visit_count += 1;
+        place.last_visit = @max(place.last_visit, now);
+        place.log_refs += 1;
+        return place_id;
+    }
+
+    /// Place for `url_text`, created (unvisited) if new; a changed title
+    /// replaces the old one.
+    pub fn touch(self: *Places, url_text: []const u8, title_text: []const u8, now: u64) !u32 {
+        if (self.find(url_text)) |place_id| {
+            const place = &self.places.items[place_id];
+            if (!std.mem.eql(u8, self.strings.get(place.title), title_text)) {
+                // The old title's posting entries go stale (one per key).
+                const old_keys: u32 = @intCast((try self.text_keys(self.strings.get(place.title))).len);
+                const title_id = try self.strings.intern(title_text);
+                self.strings.release(place.title);
+                place.title = title_id;
+                place.indexed -= old_keys;
+                self.stale_entries += old_keys;
+                try self.index_text(place_id, title_text);
+            }
+            return place_id;
+        }
+
+        if (self.place_count == MAX_PLACES) try self.evict_one();
+        try self.places.ensureUnusedCapacity(self.allocator, 1);
+        try self.seen.ensureUnusedCapacity(self.allocator, 1);
+        try self.by_url.ensureUnusedCapacity(self.allocator, 1);
+        const url_id = try self.strings.intern(url_text);
+        const title_id = self.strings.intern(title_text) catch |err| {
+            self.strings.release(url_id);
+            return err;
+        };
+
+        var place_id: u32 = @intCast(self.places.items.len);
+        if (self.free_places.items.len > 0) {
+            place_id = self.free_places.items[self.free_places.items.len - 1];
+        }
+        const place = Place{
+            .url = url_id,
+            .title = title_id,
+            .visit_count = 0,
+            .last_visit = now,
+            // Unvisited (bookmark-only) places start at half a visit.
+            .frecency = half_lives(now) - 1.0,
+            .bookmark = NO_BOOKMARK,
+            .log_refs = 0,
+            .indexed = 0,
+            .alive = true,
+        };
+        if (place_id == self.places.items.len) {
+            self.places.appendAssumeCapacity(place);
+            self.seen.appendAssumeCapacity(0);
+        } else {
+            self.places.items[place_id] = place;
+            self.free_places.items.len -= 1;
+        }
+        self.by_url.putAssumeCapacity(url_id, place_id);
+        self.place_count += 1;
+        errdefer self.unlink(place_id);
+        try self.index_text(place_id, url_text);
+        try self.index_text(place_id, title_text);
+        return place_id;
+    }
+
+    pub fn set_bookmark(self: *Places, place: u32, bookmark: u32) void {
+        std.debug.assert(self.places.items[place].alive);
+        self.places.items[place].bookmark = bookmark;
+    }
+
+    /// A history-log visit for `place` was overwritten.
+    pub fn drop_log_ref(self: *Places, place: u32) void {
+        std.debug.assert(self.places.items[place].log_refs > 0);
+        self.places.items[place].log_refs -= 1;
+    }
+
+    /// Remove a place. Its postings go stale (skipped, then rebuilt away).
+    /// Errors: OutOfMemory if the due rebuild fails (the place is gone;
+    /// stale postings are rebuilt on a later forget).
+    pub fn forget(self: *Places, place_id: u32) !void {
+        self.unlink(place_id);
+        if (self.stale_entries > REBUILD_MIN_STALE and self.stale_entries * 2 > self.posting_entries) {
+            try self.rebuild_postings();
+        }
+    }
+
+    // Drop a place from the maps; its postings are left stale.
+    fn unlink(self: *Places, place_id: u32) void {
+        const place = &self.places.items[place_id];
+        std.debug.assert(place.alive);
+        _ = self.by_url.remove(place.url);
+        self.strings.release(place.url);
+        self.strings.release(place.title);
+        place.alive = false;
+        self.place_count -= 1;
+        self.stale_entries += place.indexed;
+        // On failure the slot is leaked (never reused); places stay correct.
+        self.free_places.append(self.allocator, place_id) catch {};
+        self.drop_result(place_id);
+    }
+
+    /// Ranking key: frecency plus the bookmark boost.
+    pub fn rank(self: *const Places, place_id: u32) f64 {
+        const place = &self.places.items[place_id];
+        const boost: f64 = if (place.bookmark != NO_BOOKMARK) BOOKMARK_BOOST else 0.0;
+        return place.frecency + boost;
+    }
+
+    /// Start a query (cancelling any older one). Results stream in as
+    /// `continue_query` runs; `results` shows the best so far.
+    pub fn begin_query(self: *Places, text: []const u8, bookmarks_only: bool) u64 {
+        self.generation += 1;
+        self.prepare(&self.query, text, bookmarks_only);
+        self.query.stamp = self.next_stamp();
+        return self.generation;
+    }
+
+    /// Check up to `budget` candidates. Rebuilds cancel running queries.
+    pub fn continue_query(self: *Places, ticket: u64, budget: u32) Status {
+        if (ticket != self.generation) return .cancelled;
+        const q = &self.query;
+        if (q.status == .running and q.layout != self.layout) q.status = .cancelled;
+        if (q.status != .running) return q.status;
+
+        const posting = self.postings.getPtr(q.key) orelse {
+            q.status = .done;
+            return q.status;
+        };
+        var remaining = budget;
+        while (remaining > 0 and q.cursor < posting.items.len) : (remaining -= 1) {
+            const place_id = posting.items[q.cursor];
+            q.cursor += 1;
+            // A place can sit in one posting twice (title changes): skip repeats.
+            if (self.seen.items[place_id] == q.stamp) continue;
+            self.seen.items[place_id] = q.stamp;
+            if (self.check(q, place_id)) |place_rank| offer(q, place_id, place_rank);
+        }
+        if (q.cursor == posting.items.len) q.status = .done;
+        return q.status;
+    }
+
+    /// Best results so far (ranked), or null for a stale ticket.
+    pub fn results(self: *const Places, ticket: u64) ?[]const Result {
+        if (ticket != self.generation) return null;
+        if (self.query.status == .cancelled) return null;
+        return self.query.results[0..self.query.results_len];
+    }
+
+    /// Run a query to completion.
+    pub fn search(self: *Places, text: []const u8, bookmarks_only: bool) []const Result {
+        const ticket = self.begin_query(text, bookmarks_only);
+        while (self.continue_query(ticket, std.math.maxInt(u32)) == .running) {}
+        return self.results(ticket).?;
+    }
+
+    /// Every matching place, best first (caller frees).
+    pub fn all_matches(
+        self: *Places,
+        allocator: std.mem.Allocator,
+        text: []const u8,
+        bookmarks_only: bool,
+    ) ![]u32 {
+        var q = Query{};
+        self.prepare(&q, text, bookmarks_only);
+        var found = std.ArrayListUnmanaged(u32){};
+        errdefer found.deinit(allocator);
+        // Own dedup set: `seen` stamps belong to the streaming query.
+        var seen = try std.DynamicBitSetUnmanaged.initEmpty(allocator, self.places.items.len);
+        defer seen.deinit(allocator);
+        if (q.has_key) {
+            if (self.postings.get(q.key)) |posting| {
+                for (posting.items) |place_id| {
+                    if (seen.isSet(place_id)) continue;
+                    seen.set(place_id);
+                    if (self.check(&q, place_id) != null) try found.append(allocator, place_id);
+                }
+            }
+        }
+        std.sort.block(u32, found.items, @as(*const Places, self), rank_greater_than);
+        return found.toOwnedSlice(allocator);
+    }
+
+    fn rank_greater_than(self: *const Places, a: u32, b: u32) bool {
+        return self.rank(a) > self.rank(b);
+    }
+
+    // Fresh stamp for the streaming query's `seen` marks.
+    fn next_stamp(self: *Places) u32 {
+        self.stamp +%= 1;
+        if (self.stamp == 0) {
+            @memset(self.seen.items, 0);
+            self.stamp = 1;
+        }
+        return self.stamp;
+    }
+
+    fn prepare(self: *const Places, q: *Query, text: []const u8, bookmarks_only: bool) void {
+        q.* = .{ .bookmarks_only = bookmarks_only, .layout = self.layout, .status = .running };
+
+        var words = WordIterator{ .text = text };
+        while (words.next()) |word| {
+            if (q.words_len == MAX_QUERY_WORDS) break;
+            const len = @min(word.len, MAX_WORD_LENGTH);
+            for (word[0..len], q.words[q.words_len][0..len]) |c, *out| out.* = std.ascii.toLower(c);
+            q.word_lens[q.words_len] = @intCast(len);
+            q.words_len += 1;
+        }
+        // Drive the scan from the shortest posting among the words.
+        var best_len: usize = std.math.maxInt(usize);
+        var i: usize = 0;
+        while (i < q.words_len) : (i += 1) {
+            const key = prefix_key(q.word(i));
+            const len = if (self.postings.get(key)) |posting| posting.items.len else 0;
+            if (len < best_len) {
+                best_len = len;
+                q.key = key;
+                q.has_key = true;
+            }
+        }
+        if (!q.has_key) q.status = .done;
+    }
+
+    // Rank of `place_id` if it matches the query.
+    fn check(self: *const Places, q: *const Query, place_id: u32) ?f64 {
+        const place = &self.places.items[place_id];
+        if (!place.alive) return null;
+        if (q.bookmarks_only and place.bookmark == NO_BOOKMARK) return null;
+        const url_text = self.strings.get(place.url);
+        const title_text = self.strings.get(place.title);
+        var i: usize = 0;
+        while (i < q.words_len) : (i += 1) {
+            const word = q.word(i);
+            if (!has_word_prefix(url_text, word) and !has_word_prefix(title_text, word)) return null;
+        }
+        return self.rank(place_id);
+    }
+
+    fn offer(q: *Query, place_id: u32, place_rank: f64) void {
+        var i = q.results_len;
+        if (i == MAX_RESULTS) {
+            if (place_rank <= q.results[MAX_RESULTS - 1].rank) return;
+            i -= 1;
+        } else {
+            q.results_len += 1;
+        }
+        while (i > 0 and q.results[i - 1].rank < place_rank) : (i -= 1) {
+            q.results[i] = q.results[i - 1];
+        }
+        q.results[i] = .{ .place = place_id, .rank = place_rank };
+    }
+
+    fn drop_result(self: *Places, place_id: u32) void {
+        const q = &self.query;
+        var i: u32 = 0;
+        while (i < q.results_len) : (i += 1) {
+            if (q.results[i].place != place_id) continue;
+            std.mem.copyForwards(Result, q.results[i .. q.results_len - 1], q.results[i + 1 .. q.results_len]);
+            q.results_len -= 1;
+            return;
+        }
+    }
+
+    // Least frecent place not held by the history log or a bookmark.
+    // Linear, but only runs when the table is full.
+    fn evict_one(self: *Places) !void {
+        var victim: ?u32 = null;
+        var victim_frecency: f64 = std.math.inf(f64);
+        for (self.places.items, 0..) |place, i| {
+            if (!place.alive or place.log_refs > 0 or place.bookmark != NO_BOOKMARK) continue;
+            if (place.frecency < victim_frecency) {
+                victim_frecency = place.frecency;
+                victim = @intCast(i);
+            }
+        }
+        // Assert: MAX_PLACES exceeds history + bookmarks, so one is free
+        try self.forget(victim.?);
+    }
+
+    // Distinct posting keys of text, sorted (valid until the next call).
+    fn text_keys(self: *Places, text: []const u8) ![]const u32 {
+        self.scratch_keys.clearRetainingCapacity();
+        var words = WordIterator{ .text = text };
+        while (words.next()) |word| {
+            var len: usize = 1;
+            while (len <= @min(word.len, 3)) : (len += 1) {
+                try self.scratch_keys.append(self.allocator, prefix_key(word[0..len]));
+            }
+        }
+        const keys = self.scratch_keys.items;
+        std.sort.pdq(u32, keys, {}, std.sort.asc(u32));
+        var unique: usize = 0;
+        for (keys) |key| {
+            if (unique > 0 and keys[unique - 1] == key) continue;
+            keys[unique] = key;
+            unique += 1;
+        }
+        return keys[0..unique];
+    }
+
+    fn index_text(self: *Places, place_id: u32, text: []const u8) !void {
+        for (try self.text_keys(text)) |key| {
+            const entry = try self.postings.getOrPut(self.allocator, key);
+            if (!entry.found_existing) entry.value_ptr.* = .{};
+            try entry.value_ptr.append(self.allocator, place_id);
+            self.posting_entries += 1;
+            self.places.items[place_id].indexed += 1;
+        }
+    }
+
+    fn clear_postings(self: *Places) void {
+        var it = self.postings.valueIterator();
+        while (it.next()) |posting| posting.deinit(self.allocator);
+        self.postings.clearRetainingCapacity();
+        self.posting_entries = 0;
+        self.stale_entries = 0;
+    }
+
+    fn rebuild_postings(self: *Places) !void {
+        self.clear_postings();
+        self.layout += 1;
+        for (self.places.items, 0..) |*place, i| {
+            if (!place.alive) continue;
+            place.indexed = 0;
+            try self.index_text(@intCast(i), self.strings.get(place.url));
+            try self.index_text(@intCast(i), self.strings.get(place.title));
+        }
+    }
+
+    fn half_lives(now: u64) f64 {
+        return @as(f64, @floatFromInt(now)) / HALF_LIFE_SECONDS;
+    }
+
+    fn prefix_key(word: []const u8) u32 {
+        std.debug.assert(word.len > 0);
+        var key: u32 = @as(u32, @intCast(@min(word.len, 3))) << 24;
+        for (word[0..@min(word.len, 3)], 0..) |c, i| {
+            key |= @as(u32, std.ascii.toLower(c)) << @intCast(16 - 8 * i);
+        }
+        return key;
+    }
+
+    // Does some word of `text` start with `word` (already lowercase)?
+    fn has_word_prefix(text: []const u8, word: []const u8) bool {
+        var words = WordIterator{ .text = text };
+        while (words.next()) |candidate| {
+            if (candidate.len < word.len) continue;
+            for (candidate[0..word.len], word) |a, b| {
+                if (std.ascii.toLower(a) != b) break;
+            } else return true;
+        }
+        return false;
+    }
+
+    // Words are runs of ASCII alphanumerics or non-ASCII (UTF-8) bytes.
+    const WordIterator = struct {
+        text: []const u8,
+        pos: usize = 0,
+
+        fn next(self: *WordIterator) ?[]const u8 {
+            while (self.pos < self.text.len and !is_word_byte(self.text[self.pos])) self.pos += 1;
+            if (self.pos == self.text.len) return null;
+            const start = self.pos;
+            while (self.pos < self.text.len and is_word_byte(self.text[self.pos])) self.pos += 1;
+            return self.text[start..self.pos];
+        }
+
+        fn is_word_byte(c: u8) bool {
+            return std.ascii.isAlphanumeric(c) or c >= 0x80;
+        }
+    };
+};
+
+test "string table interns and compacts" {
+    var table = StringTable.init(std.testing.allocator);
+    defer table.deinit();
+
+    const a = try table.intern("https://grain.example/");
+    const b = try table.intern("https://grain.example/");
+    try std.testing.expectEqual(a, b);
+    try std.testing.expectEqual(@as(u32, 1), table.live);
+
+    // Many short-lived strings: released ids are reused, bytes compacted.
+    var buf: [64]u8 = undefined;
+    var i: u32 = 0;
+    while (i < 20_000) : (i += 1) {
+        const id = try table.intern(try std.fmt.bufPrint(&buf, "https://tmp.example/{d}", .{i}));
+        table.release(id);
+    }
+    try std.testing.expectEqual(@as(u32, 1), table.live);
+    try std.testing.expect(table.bytes.items.len < 2 * StringTable.COMPACT_MIN_DEAD_BYTES);
+    try std.testing.expectEqualStrings("https://grain.example/", table.get(a));
+    try std.testing.expectEqual(a, table.lookup("https://grain.example/").?);
+    table.release(a);
+    table.release(b);
+    try std.testing.expect(table.lookup("https://grain.example/") == null);
+}
+
+test "places rank by frecency and match word prefixes" {
+    var places = Places.init(std.testing.allocator);
+    defer places.deinit();
+
+    const day: u64 = 24 * 60 * 60;
+    const now: u64 = 1_000 * day;
+    // Old favourite: 16 visits a year ago. Recent: 3 visits this week.
+    var i: u64 = 0;
+    while (i < 16) : (i += 1) _ = try places.visit("https://github.com/ziglang/zig", "ziglang/zig", now - 365 * day + i);
+    i = 0;
+    while (i < 3) : (i += 1) _ = try places.visit("https://github.com/grain/hub", "Grain Hub", now - i * day);
+    _ = try places.visit("https://example.com/", "Example", now);
+
+    const found = places.search("git hu", false);
+    try std.testing.expectEqual(@as(usize, 1), found.len);
+    try std.testing.expectEqualStrings("Grain Hub", places.title(found[0].place));
+
+    const both = places.search("GIT", false);
+    try std.testing.expectEqual(@as(usize, 2), both.len);
+    // Decay outweighs the older place's larger visit count.
+    try std.testing.expectEqualStrings("Grain Hub", places.title(both[0].place));
+    try std.testing.expect(places.search("xyz", false).len == 0);
+    try std.testing.expect(places.search("ithub", false).len == 0);
+}
+
+test "places stream results and cancel stale queries" {
+    var places = Places.init(std.testing.allocator);
+    defer places.deinit();
+
+    var buf: [64]u8 = undefined;
+    var i: u32 = 0;
+    while (i < 100) : (i += 1) {
+        _ = try places.visit(try std.fmt.bufPrint(&buf, "https://grain.example/{d}", .{i}), "Grain page", i);
+    }
+    const ticket = places.begin_query("grain", false);
+    try std.testing.expect(places.continue_query(ticket, 10) == .running);
+    try std.testing.expectEqual(@as(usize, 10), places.results(ticket).?.len);
+
+    const newer = places.begin_query("grain pa", false);
+    try std.testing.expect(places.continue_query(ticket, 10) == .cancelled);
+    try std.testing.expect(places.continue_query(newer, 1000) == .done);
+    const ranked = places.results(newer).?;
+    try std.testing.expectEqual(@as(usize, Places.MAX_RESULTS), ranked.len);
+    // Most recent visit first.
+    try std.testing.expectEqualStrings("https://grain.example/99", places.url(ranked[0].place));
+}
+
+test "all_matches leaves the streaming query's dedup intact" {
+    var places = Places.init(std.testing.allocator);
+    defer places.deinit();
+
+    var buf: [64]u8 = undefined;
+    var i: u32 = 0;
+    while (i < 40) : (i += 1) {
+        _ = try places.visit(try std.fmt.bufPrint(&buf, "https://grain.example/{d}", .{i}), "Grain page", i);
+    }
+    // A new title re-indexes the first place: it reappears at the end of
+    // the "gra" posting, after the streaming query has already taken it.
+    const top = places.find("https://grain.example/0").?;
+    _ = try places.visit("https://grain.example/0", "Grain notes", 100);
+
+    const ticket = places.begin_query("grain", false);
+    try std.testing.expect(places.continue_query(ticket, 10) == .running);
+    const all = try places.all_matches(std.testing.allocator, "grain", false);
+    defer std.testing.allocator.free(all);
+    try std.testing.expectEqual(@as(usize, 40), all.len);
+    try std.testing.expectEqual(top, all[0]);
+    try std.testing.expect(places.continue_query(ticket, 1000) == .done);
+
+    var hits: u32 = 0;
+    for (places.results(ticket).?) |result| {
+        if (result.place == top) hits += 1;
+    }
+    try std.testing.expectEqual(@as(u32, 1), hits);
+}
+
+test "retitling a place marks every old title key stale" {
+    var places = Places.init(std.testing.allocator);
+    defer places.deinit();
+
+    const id = try places.visit("https://grain.example/", "Grain notes", 1);
+    const indexed = places.places.items[id].indexed;
+    _ = try places.visit("https://grain.example/", "Grain notes draft", 2);
+    // "grain notes": g gr gra n no not = 6 keys, all superseded.
+    try std.testing.expectEqual(@as(usize, 6), places.stale_entries);
+    try std.testing.expectEqual(indexed + 3, places.places.items[id].indexed);
+    try std.testing.expectEqual(places.posting_entries - places.stale_entries, places.places.items[id].indexed);
+}
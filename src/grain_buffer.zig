@@ -12,9 +12,23 @@ pub const GrainBuffer = struct {
         end: usize,
     };
 
+    /// Edit listener: told about every change after it lands, so indexes
+    /// (e.g. Aurora search) update incrementally instead of rescanning.
+    pub const EditListener = struct {
+        callback: *const fn (
+            ctx: *anyopaque,
+            buffer: *const GrainBuffer,
+            index: usize,
+            removed: usize,
+            inserted: usize,
+        ) void,
+        context: *anyopaque,
+    };
+
     allocator: std.mem.Allocator,
     text: std.ArrayListUnmanaged(u8),
     readonly_segments: std.ArrayListUnmanaged(Segment),
+    edit_listener: ?EditListener = null,
 
     pub fn init(allocator: std.mem.Allocator) GrainBuffer {
         return .{
@@ -112,7 +126,9 @@ pub const GrainBuffer = struct {
     }
 
     pub fn append(self: *GrainBuffer, data: []const u8) !void {
+        const index = self.text.items.len;
         try self.text.appendSlice(self.allocator, data);
+        self.notifyEdit(index, 0, data.len);
     }
 
     pub fn insert(self: *GrainBuffer, index: usize, data: []const u8) !void {
@@ -123,7 +139,8 @@ pub const GrainBuffer = struct {
         if (self.intersectsReadonly(index, index)) return error.ReadOnlyViolation;
         
         try self.text.insertSlice(self.allocator, index, data);
-        try self.shiftSegments(index, @as(isize, @intCast(data.len)));
+        self.shiftSegments(index, @as(isize, @intCast(data.len)));
+        self.notifyEdit(index, 0, data.len);
         
         // Assert: Text must be inserted
         std.debug.assert(self.text.items.len >= index + data.len);
@@ -139,6 +156,7 @@ pub const GrainBuffer = struct {
         if (self.intersectsReadonly(index, end)) return error.ReadOnlyViolation;
         
         std.mem.copyForwards(u8, self.text.items[index..end], data);
+        self.notifyEdit(index, data.len, data.len);
         
         // Assert: Data must be written
         std.debug.assert(std.mem.eql(u8, self.text.items[index..end], data));
@@ -148,6 +166,7 @@ pub const GrainBuffer = struct {
         const end = index + data.len;
         if (end > self.text.items.len) return error.OutOfBounds;
         std.mem.copyForwards(u8, self.text.items[index..end], data);
+        self.notifyEdit(index, data.len, data.len);
     }
 
     pub fn erase(self: *GrainBuffer, index: usize, count: usize) !void {
@@ -163,12 +182,19 @@ pub const GrainBuffer = struct {
         
         const old_len = self.text.items.len;
         try self.text.replaceRange(self.allocator, index, count, &.{});
-        try self.shiftSegments(index, -@as(isize, @intCast(count)));
+        self.shiftSegments(index, -@as(isize, @intCast(count)));
+        self.notifyEdit(index, count, 0);
         
         // Assert: Text must be erased
         std.debug.assert(self.text.items.len == old_len - count);
     }
 
+    fn notifyEdit(self: *const GrainBuffer, index: usize, removed: usize, inserted: usize) void {
+        if (self.edit_listener) |listener| {
+            listener.callback(listener.context, self, index, removed, inserted);
+        }
+    }
+
     fn intersectsReadonly(self: *const GrainBuffer, start: usize, end: usize) bool {
         for (self.readonly_segments.items) |segment| {
             if (!(end <= segment.start or start >= segment.end)) {
@@ -178,7 +204,8 @@ pub const GrainBuffer = struct {
         return false;
     }
 
-    fn shiftSegments(self: *GrainBuffer, pivot: usize, delta: isize) !void {
+    // Cannot fail: insert and erase notify the listener right after it.
+    fn shiftSegments(self: *GrainBuffer, pivot: usize, delta: isize) void {
         if (delta == 0) return;
         for (self.readonly_segments.items) |*segment| {
             if (segment.start >= pivot) {
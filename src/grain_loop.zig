@@ -1,16 +1,36 @@
 const std = @import("std");
+const builtin = @import("builtin");
 
 const Address = std.net.Address;
+const posix = std.posix;
+const linux = std.os.linux;
+const bounded_map = @import("grain_os/bounded_map.zig");
 
 /// GrainLoop: GrainStyle UDP event loop inspired by TigerBeetle's io_uring
 /// design but adapted for cross-platform musl-friendly builds.
 /// It favors static allocation, deterministic dispatch, and no hidden threads.
+/// On Linux, `bind_udp` opens real sockets: epoll reports readiness and
+/// `recvmmsg`/`sendmmsg` move whole batches per syscall straight into the
+/// pending ring. Listeners are found through a hashed address index.
 // ~( )~  Glow Airbend: packets hover, latency stays calm.
 // ~/\/\~ Glow Waterbend: streams carve steady channels.
 pub const GrainLoop = struct {
-    pub const max_udp_slots = 8;
-    pub const max_pending = 64;
+    pub const max_udp_slots = 64;
+    pub const max_pending = 256;
     pub const max_payload = 1472; // fits within typical UDP MTU with headers.
+    pub const max_batch = 64; // datagrams per recvmmsg/sendmmsg call.
+
+    /// True where `bind_udp`, `poll`, and `send_batch` use real sockets.
+    pub const has_sockets = builtin.os.tag == .linux;
+
+    // Open-addressing index of slots by address: power of two, at most half full.
+    const index_capacity = max_udp_slots * 2;
+    const index_empty: u8 = 0xFF;
+    const IndexTable = bounded_map.OpenTable(u8, index_empty);
+    // Pending entries from inject/queue are routed by their source address.
+    const route_by_source: u8 = 0xFF;
+    // Pending entries whose slot was unregistered before dispatch.
+    const route_dropped: u8 = 0xFE;
 
     /// GrainDatagram: typed payload we circulate within the event loop.
     pub const GrainDatagram = struct {
@@ -27,23 +47,60 @@ pub const GrainLoop = struct {
     const UdpSlot = struct {
         address: Address,
         listener: Listener,
+        fd: ?posix.fd_t,
+    };
+
+    const PendingEntry = struct {
+        datagram: GrainDatagram,
+        slot: u8, // listener slot, or route_by_source
+    };
+
+    // Kernel struct msghdr / struct mmsghdr (declared here so the layout
+    // does not depend on std field names across Zig releases).
+    const MsgHdr = extern struct {
+        name: ?*anyopaque,
+        namelen: u32,
+        iov: [*]posix.iovec,
+        iovlen: usize,
+        control: ?*anyopaque,
+        controllen: usize,
+        flags: u32,
+    };
+
+    const MmsgHdr = extern struct {
+        hdr: MsgHdr,
+        len: u32,
     };
 
     allocator: std.mem.Allocator,
     udp_slots: [max_udp_slots]?UdpSlot,
-    pending: std.ArrayListUnmanaged(GrainDatagram),
+    index: [index_capacity]u8,
+    pending: [max_pending]PendingEntry,
+    pending_head: usize,
+    pending_len: usize,
+    epoll_fd: ?posix.fd_t,
 
     pub fn init(allocator: std.mem.Allocator) GrainLoop {
         const loop = GrainLoop{
             .allocator = allocator,
             .udp_slots = .{null} ** max_udp_slots,
-            .pending = .{},
+            .index = .{index_empty} ** index_capacity,
+            .pending = undefined,
+            .pending_head = 0,
+            .pending_len = 0,
+            .epoll_fd = null,
         };
         return loop;
     }
 
     pub fn deinit(self: *GrainLoop) void {
-        self.pending.deinit(self.allocator);
+        var i: usize = 0;
+        while (i < max_udp_slots) : (i += 1) {
+            if (self.udp_slots[i]) |slot| {
+                if (slot.fd) |fd| posix.close(fd);
+            }
+        }
+        if (self.epoll_fd) |fd| posix.close(fd);
         self.* = undefined;
     }
 
@@ -53,13 +110,25 @@ pub const GrainLoop = struct {
         address: Address,
         listener: Listener,
     ) !usize {
+        return self.register_slot(address, listener, null);
+    }
+
+    fn register_slot(
+        self: *GrainLoop,
+        address: Address,
+        listener: Listener,
+        fd: ?posix.fd_t,
+    ) !usize {
+        if (self.index_find(address) != null) return error.AddressInUse;
         var i: usize = 0;
         while (i < max_udp_slots) : (i += 1) {
             if (self.udp_slots[i] == null) {
                 self.udp_slots[i] = UdpSlot{
                     .address = address,
                     .listener = listener,
+                    .fd = fd,
                 };
+                self.index_insert(address, @intCast(i));
                 return i;
             }
         }
@@ -67,38 +136,245 @@ pub const GrainLoop = struct {
     }
 
     pub fn unregister_udp(self: *GrainLoop, slot: usize) void {
-        if (slot < max_udp_slots) {
+        if (slot >= max_udp_slots) return;
+        const entry = self.udp_slots[slot] orelse return;
+        self.index_remove(entry.address);
+        if (entry.fd) |fd| {
+            if (self.epoll_fd) |epfd| {
+                posix.epoll_ctl(epfd, linux.EPOLL.CTL_DEL, fd, null) catch {};
+            }
+            posix.close(fd);
+        }
+        self.udp_slots[slot] = null;
+        // Drop datagrams already received for this slot.
+        var i: usize = 0;
+        while (i < self.pending_len) : (i += 1) {
+            const pending = &self.pending[(self.pending_head + i) % max_pending];
+            if (pending.slot == slot) pending.slot = route_dropped;
+        }
+    }
+
+    /// bind_udp: open a non-blocking UDP socket bound to `address` and
+    /// register its listener. Port 0 binds an ephemeral port; read it back
+    /// with `local_address`. Returns slot index.
+    pub fn bind_udp(
+        self: *GrainLoop,
+        address: Address,
+        listener: Listener,
+    ) !usize {
+        if (!has_sockets) return error.Unsupported;
+        const epfd = self.epoll_fd orelse blk: {
+            const fd = try posix.epoll_create1(linux.EPOLL.CLOEXEC);
+            self.epoll_fd = fd;
+            break :blk fd;
+        };
+
+        const fd = try posix.socket(
+            address.any.family,
+            posix.SOCK.DGRAM | posix.SOCK.NONBLOCK | posix.SOCK.CLOEXEC,
+            posix.IPPROTO.UDP,
+        );
+        errdefer posix.close(fd);
+        try posix.bind(fd, &address.any, address.getOsSockLen());
+        var bound = address;
+        var bound_len: posix.socklen_t = address.getOsSockLen();
+        try posix.getsockname(fd, &bound.any, &bound_len);
+
+        const slot = try self.register_slot(bound, listener, fd);
+        errdefer {
+            self.index_remove(bound);
             self.udp_slots[slot] = null;
         }
+        var event = linux.epoll_event{
+            .events = linux.EPOLL.IN,
+            .data = .{ .u32 = @intCast(slot) },
+        };
+        try posix.epoll_ctl(epfd, linux.EPOLL.CTL_ADD, fd, &event);
+        return slot;
+    }
+
+    /// local_address: address a slot is bound to (resolved ephemeral port).
+    pub fn local_address(self: *const GrainLoop, slot: usize) ?Address {
+        if (slot >= max_udp_slots) return null;
+        const entry = self.udp_slots[slot] orelse return null;
+        return entry.address;
     }
 
     /// queue_datagram: static helper to enqueue data from the network.
     pub fn queue_datagram(self: *GrainLoop, datagram: GrainDatagram) !void {
-        if (self.pending.items.len >= max_pending) {
+        if (self.pending_len >= max_pending) {
             return error.PendingOverflow;
         }
-        try self.pending.append(self.allocator, datagram);
+        self.pending[(self.pending_head + self.pending_len) % max_pending] = PendingEntry{
+            .datagram = datagram,
+            .slot = route_by_source,
+        };
+        self.pending_len += 1;
+    }
+
+    /// pending_count: datagrams waiting for `pump`.
+    pub fn pending_count(self: *const GrainLoop) usize {
+        return self.pending_len;
     }
 
     /// pump: deliver queued datagrams to their listeners deterministically.
+    /// Socket datagrams go to the slot that received them; queued and
+    /// injected datagrams go to the listener registered for their source.
     pub fn pump(self: *GrainLoop, max_dispatch: usize) void {
         var dispatched: usize = 0;
-        while (self.pending.items.len > 0 and dispatched < max_dispatch) {
-            const datagram = self.pending.orderedRemove(0);
+        while (self.pending_len > 0 and dispatched < max_dispatch) {
+            // Why: The entry is copied and released before the callback, so
+            // a callback that queues or pumps never sees it again.
+            const entry = self.pending[self.pending_head];
+            self.pending_head = (self.pending_head + 1) % max_pending;
+            self.pending_len -= 1;
             dispatched += 1;
 
-            var i: usize = 0;
-            while (i < max_udp_slots) : (i += 1) {
-                if (self.udp_slots[i]) |slot| {
-                    if (slot.address.eql(datagram.source)) {
-                        slot.listener.callback(slot.listener.context, datagram);
-                        break;
-                    }
+            const slot: ?u8 = switch (entry.slot) {
+                route_dropped => null,
+                route_by_source => self.index_find(entry.datagram.source),
+                else => entry.slot,
+            };
+            if (slot) |index| {
+                if (self.udp_slots[index]) |udp| {
+                    udp.listener.callback(udp.listener.context, entry.datagram);
                 }
             }
         }
     }
 
+    /// poll: wait up to `timeout_ms` (-1 blocks, 0 returns at once) for
+    /// readable sockets and receive into the pending ring in batches.
+    /// Returns datagrams received. Sockets stay readable while the ring is
+    /// full, so nothing is dropped by the loop itself.
+    pub fn poll(self: *GrainLoop, timeout_ms: i32) !usize {
+        if (!has_sockets) return error.Unsupported;
+        const epfd = self.epoll_fd orelse return 0;
+        var events: [max_udp_slots]linux.epoll_event = undefined;
+        const ready = posix.epoll_wait(epfd, &events, timeout_ms);
+        var received: usize = 0;
+        for (events[0..ready]) |event| {
+            received += try self.receive_batch(@intCast(event.data.u32));
+        }
+        return received;
+    }
+
+    /// run_once: poll, then dispatch everything pending.
+    pub fn run_once(self: *GrainLoop, timeout_ms: i32) !usize {
+        const received = try self.poll(timeout_ms);
+        self.pump(max_pending);
+        return received;
+    }
+
+    fn receive_batch(self: *GrainLoop, slot: usize) !usize {
+        const udp = self.udp_slots[slot] orelse return 0;
+        const fd = udp.fd orelse return 0;
+        var msgs: [max_batch]MmsgHdr = undefined;
+        var iovs: [max_batch]posix.iovec = undefined;
+        var total: usize = 0;
+        while (self.pending_len < max_pending) {
+            const want = @min(max_pending - self.pending_len, max_batch);
+            var i: usize = 0;
+            while (i < want) : (i += 1) {
+                const entry = &self.pending[(self.pending_head + self.pending_len + i) % max_pending];
+                iovs[i] = .{ .base = &entry.datagram.payload, .len = max_payload };
+                msgs[i] = .{
+                    .hdr = .{
+                        .name = &entry.datagram.source,
+                        .namelen = @sizeOf(Address),
+                        .iov = iovs[i..].ptr,
+                        .iovlen = 1,
+                        .control = null,
+                        .controllen = 0,
+                        .flags = 0,
+                    },
+                    .len = 0,
+                };
+            }
+            const rc = linux.syscall5(
+                .recvmmsg,
+                @as(usize, @bitCast(@as(isize, fd))),
+                @intFromPtr(&msgs),
+                want,
+                linux.MSG.DONTWAIT,
+                0,
+            );
+            switch (posix.errno(rc)) {
+                .SUCCESS => {},
+                .AGAIN => break,
+                .INTR => continue,
+                else => |err| return posix.unexpectedErrno(err),
+            }
+            const count: usize = rc;
+            i = 0;
+            while (i < count) : (i += 1) {
+                const entry = &self.pending[(self.pending_head + self.pending_len + i) % max_pending];
+                entry.datagram.length = @intCast(@min(msgs[i].len, max_payload));
+                entry.slot = @intCast(slot);
+            }
+            self.pending_len += count;
+            total += count;
+            if (count < want) break;
+        }
+        return total;
+    }
+
+    /// send_batch: send `payloads` from a bound slot to `destination`,
+    /// up to max_batch datagrams per sendmmsg. Returns datagrams sent
+    /// (fewer than requested when the socket buffer is full).
+    pub fn send_batch(
+        self: *GrainLoop,
+        slot: usize,
+        destination: Address,
+        payloads: []const []const u8,
+    ) !usize {
+        if (!has_sockets) return error.Unsupported;
+        if (slot >= max_udp_slots) return error.InvalidSlot;
+        const udp = self.udp_slots[slot] orelse return error.InvalidSlot;
+        const fd = udp.fd orelse return error.NotBound;
+        var dest = destination;
+        var msgs: [max_batch]MmsgHdr = undefined;
+        var iovs: [max_batch]posix.iovec = undefined;
+        var sent: usize = 0;
+        while (sent < payloads.len) {
+            const want = @min(payloads.len - sent, max_batch);
+            var i: usize = 0;
+            while (i < want) : (i += 1) {
+                const payload = payloads[sent + i];
+                if (payload.len > max_payload) return error.PayloadTooLarge;
+                iovs[i] = .{ .base = @constCast(payload.ptr), .len = payload.len };
+                msgs[i] = .{
+                    .hdr = .{
+                        .name = &dest.any,
+                        .namelen = dest.getOsSockLen(),
+                        .iov = iovs[i..].ptr,
+                        .iovlen = 1,
+                        .control = null,
+                        .controllen = 0,
+                        .flags = 0,
+                    },
+                    .len = 0,
+                };
+            }
+            const rc = linux.syscall4(
+                .sendmmsg,
+                @as(usize, @bitCast(@as(isize, fd))),
+                @intFromPtr(&msgs),
+                want,
+                linux.MSG.DONTWAIT,
+            );
+            switch (posix.errno(rc)) {
+                .SUCCESS => {},
+                .AGAIN => break,
+                .INTR => continue,
+                else => |err| return posix.unexpectedErrno(err),
+            }
+            sent += rc;
+            if (rc < want) break;
+        }
+        return sent;
+    }
+
     /// inject_test_datagram: testing helper to avoid actual sockets.
     pub fn inject_test_datagram(
         self: *GrainLoop,
@@ -114,6 +390,47 @@ pub const GrainLoop = struct {
         std.mem.copyForwards(u8, message.payload[0..payload.len], payload);
         try self.queue_datagram(message);
     }
+
+    // Hash the bytes Address.eql compares.
+    fn address_hash(address: Address) usize {
+        const bytes: [*]const u8 = @ptrCast(&address.any);
+        return @truncate(std.hash.Wyhash.hash(0, bytes[0..address.getOsSockLen()]));
+    }
+
+    // Address lookup for IndexTable.find.
+    const IndexKey = struct {
+        loop: *const GrainLoop,
+        address: Address,
+
+        fn matches(key: IndexKey, slot: u8) bool {
+            return key.loop.udp_slots[slot].?.address.eql(key.address);
+        }
+    };
+
+    // Index slots live in udp_slots; a slot's home is its address hash.
+    fn slot_home(self: *const GrainLoop, slot: u8) usize {
+        return address_hash(self.udp_slots[slot].?.address);
+    }
+
+    fn index_position(self: *const GrainLoop, address: Address) ?usize {
+        const key = IndexKey{ .loop = self, .address = address };
+        return IndexTable.find(&self.index, address_hash(address), key, IndexKey.matches);
+    }
+
+    fn index_find(self: *const GrainLoop, address: Address) ?u8 {
+        const pos = self.index_position(address) orelse return null;
+        return self.index[pos];
+    }
+
+    fn index_insert(self: *GrainLoop, address: Address, slot: u8) void {
+        _ = IndexTable.insert(&self.index, address_hash(address), slot);
+    }
+
+    // Unregister a UDP socket's address from the dispatch index.
+    fn index_remove(self: *GrainLoop, address: Address) void {
+        const pos = self.index_position(address) orelse return;
+        IndexTable.remove_at(&self.index, pos, @as(*const GrainLoop, self), slot_home);
+    }
 };
 
 test "register, inject, and dispatch datagram" {
@@ -143,3 +460,135 @@ fn test_loop_on_datagram(
     const flag_ptr: *bool = @ptrCast(ctx);
     flag_ptr.* = datagram.length == 3 and datagram.payload[0] == 'a';
 }
+
+const TestCounter = struct {
+    count: usize = 0,
+    last: u8 = 0,
+    in_order: bool = true,
+
+    fn on_datagram(ctx: *anyopaque, datagram: GrainLoop.GrainDatagram) void {
+        const self: *TestCounter = @ptrCast(@alignCast(ctx));
+        const seq = datagram.payload[0];
+        if (self.count > 0 and seq != self.last +% 1) self.in_order = false;
+        self.last = seq;
+        self.count += 1;
+    }
+};
+
+test "pending ring keeps order across wraparound" {
+    var loop = GrainLoop.init(std.testing.allocator);
+    defer loop.deinit();
+
+    var counter = TestCounter{};
+    const addr = try Address.parseIp4("127.0.0.1", 9100);
+    _ = try loop.register_udp(addr, .{ .callback = TestCounter.on_datagram, .context = @ptrCast(&counter) });
+
+    var seq: u8 = 0;
+    var round: usize = 0;
+    while (round < 10) : (round += 1) {
+        var i: usize = 0;
+        while (i < GrainLoop.max_pending - 7) : (i += 1) {
+            try loop.inject_test_datagram(addr, &[_]u8{seq});
+            seq +%= 1;
+        }
+        loop.pump(GrainLoop.max_pending / 2);
+        loop.pump(GrainLoop.max_pending);
+    }
+    var filled: usize = 0;
+    while (loop.inject_test_datagram(addr, "x")) |_| {
+        filled += 1;
+    } else |err| {
+        try std.testing.expect(err == error.PendingOverflow);
+    }
+    try std.testing.expect(filled == GrainLoop.max_pending);
+    try std.testing.expect(counter.count == 10 * (GrainLoop.max_pending - 7));
+    try std.testing.expect(counter.in_order);
+}
+
+const ReentrantPump = struct {
+    loop: *GrainLoop,
+    counter: TestCounter = .{},
+
+    fn on_datagram(ctx: *anyopaque, datagram: GrainLoop.GrainDatagram) void {
+        const self: *ReentrantPump = @ptrCast(@alignCast(ctx));
+        TestCounter.on_datagram(@ptrCast(&self.counter), datagram);
+        self.loop.pump(1);
+    }
+};
+
+test "reentrant pump delivers each datagram once" {
+    var loop = GrainLoop.init(std.testing.allocator);
+    defer loop.deinit();
+
+    var reentrant = ReentrantPump{ .loop = &loop };
+    const addr = try Address.parseIp4("127.0.0.1", 9200);
+    _ = try loop.register_udp(addr, .{ .callback = ReentrantPump.on_datagram, .context = @ptrCast(&reentrant) });
+
+    var seq: u8 = 0;
+    while (seq < 8) : (seq += 1) try loop.inject_test_datagram(addr, &[_]u8{seq});
+    loop.pump(1);
+    try std.testing.expect(loop.pending_count() == 0);
+    try std.testing.expect(reentrant.counter.count == 8);
+    try std.testing.expect(reentrant.counter.in_order);
+}
+
+test "hashed listener index survives unregister" {
+    var loop = GrainLoop.init(std.testing.allocator);
+    defer loop.deinit();
+
+    var counters: [GrainLoop.max_udp_slots]TestCounter = .{TestCounter{}} ** GrainLoop.max_udp_slots;
+    var slots: [GrainLoop.max_udp_slots]usize = undefined;
+    for (&counters, 0..) |*counter, i| {
+        const addr = try Address.parseIp4("127.0.0.1", @intCast(10_000 + i));
+        slots[i] = try loop.register_udp(addr, .{ .callback = TestCounter.on_datagram, .context = @ptrCast(counter) });
+    }
+    const extra = try Address.parseIp4("127.0.0.1", 20_000);
+    try std.testing.expectError(error.TooManyUdpSlots, loop.register_udp(extra, .{
+        .callback = TestCounter.on_datagram,
+        .context = @ptrCast(&counters[0]),
+    }));
+
+    // Drop every third listener, then route one datagram to each port.
+    var i: usize = 0;
+    while (i < GrainLoop.max_udp_slots) : (i += 3) loop.unregister_udp(slots[i]);
+    i = 0;
+    while (i < GrainLoop.max_udp_slots) : (i += 1) {
+        const addr = try Address.parseIp4("127.0.0.1", @intCast(10_000 + i));
+        try loop.inject_test_datagram(addr, "p");
+    }
+    loop.pump(GrainLoop.max_pending);
+    for (counters, 0..) |counter, j| {
+        try std.testing.expect(counter.count == @intFromBool(j % 3 != 0));
+    }
+}
+
+test "loopback sockets batch through recvmmsg and sendmmsg" {
+    if (!GrainLoop.has_sockets) return error.SkipZigTest;
+    var loop = GrainLoop.init(std.testing.allocator);
+    defer loop.deinit();
+
+    var counter = TestCounter{};
+    var sink = TestCounter{};
+    const any_port = try Address.parseIp4("127.0.0.1", 0);
+    const rx = try loop.bind_udp(any_port, .{ .callback = TestCounter.on_datagram, .context = @ptrCast(&counter) });
+    const tx = try loop.bind_udp(any_port, .{ .callback = TestCounter.on_datagram, .context = @ptrCast(&sink) });
+    const rx_addr = loop.local_address(rx).?;
+    try std.testing.expect(rx_addr.getPort() != 0);
+
+    var bytes: [200]u8 = undefined;
+    var payloads: [200][]const u8 = undefined;
+    for (&bytes, &payloads, 0..) |*byte, *payload, i| {
+        byte.* = @intCast(i);
+        payload.* = byte[0..1];
+    }
+    const sent = try loop.send_batch(tx, rx_addr, &payloads);
+    try std.testing.expect(sent == payloads.len);
+
+    var spins: usize = 0;
+    while (counter.count < sent and spins < 1000) : (spins += 1) {
+        _ = try loop.run_once(10);
+    }
+    try std.testing.expect(counter.count == sent);
+    try std.testing.expect(counter.in_order);
+    try std.testing.expect(sink.count == 0);
+}
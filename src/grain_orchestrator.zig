@@ -21,6 +21,7 @@ pub const GrainOrchestrator = struct {
     router: GrainRoute,
     agents: std.ArrayListUnmanaged(AgentSpec),
 
+    /// init: takes ownership of `router` (freed by `deinit`).
     pub fn init(
         allocator: std.mem.Allocator,
         loom: GrainLoom,
@@ -36,6 +37,7 @@ pub const GrainOrchestrator = struct {
 
     pub fn deinit(self: *GrainOrchestrator) void {
         self.agents.deinit(self.allocator);
+        self.router.deinit();
         self.* = undefined;
     }
 
@@ -62,7 +64,7 @@ test "grain orchestrator registers agents" {
     const routes = [_]GrainRoute.RouteSpec{
         .{ .npub_prefix = "npub1", .path = &.{}, .component_id = "home" },
     };
-    var orchestrator = GrainOrchestrator.init(arena.allocator(), loom, GrainRoute.init(&routes));
+    var orchestrator = GrainOrchestrator.init(arena.allocator(), loom, try GrainRoute.init(arena.allocator(), &routes));
     defer orchestrator.deinit();
 
     try orchestrator.registerAgent(.{
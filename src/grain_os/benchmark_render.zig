@@ -0,0 +1,50 @@
+//! Grain OS Render Benchmark: headless compositor scenarios on the null backend.
+//!
+//! Why: Compare render cost and output across changes without a display.
+//! Architecture: Runs every render_harness scenario against a NullWindow
+//! buffer, presents each frame, and prints per-scenario time, pixels,
+//! syscalls and the combined frame hash (equal hash = identical output).
+//! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
+
+const std = @import("std");
+const grain_os = @import("root.zig");
+const platform = @import("platform");
+const render_harness = grain_os.render_harness;
+const compositor = grain_os.compositor;
+const NullWindow = platform.Platform.null_backend.NullWindow;
+
+const FRAMES: u32 = 240;
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    var window = try NullWindow.init(allocator, "benchmark render");
+    defer window.deinit();
+    const comp = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(comp);
+    const frames = try allocator.alloc(render_harness.FrameStats, FRAMES);
+    defer allocator.free(frames);
+    var harness: render_harness.Harness = undefined;
+    harness.init(comp, allocator, window.getBuffer());
+    defer harness.deinit();
+
+    std.debug.print("\nGrain OS headless render benchmark ({d} frames per scenario)\n", .{FRAMES});
+    std.debug.print("{s:<16} {s:>10} {s:>10} {s:>14} {s:>9} {s:>18}\n", .{
+        "scenario", "avg us", "max us", "pixels/frame", "syscalls", "hash",
+    });
+    inline for (std.meta.fields(render_harness.Scenario)) |field| {
+        const scenario: render_harness.Scenario = @enumFromInt(field.value);
+        const report = try harness.run(scenario, frames);
+        try window.present();
+        std.debug.print("{s:<16} {d:>10} {d:>10} {d:>14} {d:>9} {x:0>16}\n", .{
+            field.name,
+            report.total_ns / (@as(u64, FRAMES) * 1000),
+            report.max_ns / 1000,
+            report.pixels_touched / FRAMES,
+            report.syscalls,
+            report.hash,
+        });
+    }
+}
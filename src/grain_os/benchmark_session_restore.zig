@@ -0,0 +1,95 @@
+//! Grain OS Session Restore Benchmark: snapshot restore vs window-by-window rebuild.
+//!
+//! Why: Startup should be dominated by reading the snapshot, not by relayout.
+//! Architecture: Builds a 200-window desktop, then times (1) rebuilding it via
+//! create_window (one relayout per window), (2) reading the snapshot back
+//! from a file, and (3) restore_snapshot on the bytes read (one bulk pass).
+//! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
+
+const std = @import("std");
+const grain_os = @import("root.zig");
+const compositor = grain_os.compositor;
+const session_snapshot = grain_os.session_snapshot;
+
+const WINDOW_COUNT: u32 = 200;
+const WORKSPACE_COUNT: u32 = 4;
+const RUNS: u32 = 20;
+// Snapshot file, written once and removed when the benchmark ends.
+const SNAPSHOT_PATH = "benchmark_session_restore.snapshot";
+
+fn build_desktop(comp: *compositor.Compositor) !void {
+    var ws: u32 = 1;
+    while (ws < WORKSPACE_COUNT) : (ws += 1) {
+        _ = comp.create_workspace("bench") orelse return error.OutOfWorkspaces;
+    }
+    var i: u32 = 0;
+    while (i < WINDOW_COUNT) : (i += 1) {
+        const win = try comp.create_window(320 + (i % 7) * 16, 240 + (i % 5) * 16);
+        comp.get_window(win).?.set_title("bench window");
+        const target = (i % WORKSPACE_COUNT) + 1;
+        if (target != 1) _ = comp.assign_window_to_workspace(win, target);
+    }
+}
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const buf = try allocator.alloc(u8, session_snapshot.MAX_SNAPSHOT_SIZE);
+    defer allocator.free(buf);
+    const loaded = try allocator.alloc(u8, session_snapshot.MAX_SNAPSHOT_SIZE);
+    defer allocator.free(loaded);
+    const comp = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(comp);
+
+    // Rebuild: one create_window (and relayout) per window.
+    var rebuild_ns: i128 = 0;
+    var len: u32 = 0;
+    var run: u32 = 0;
+    while (run < RUNS) : (run += 1) {
+        comp.* = compositor.Compositor.init(allocator);
+        const start = std.time.nanoTimestamp();
+        try build_desktop(comp);
+        rebuild_ns += std.time.nanoTimestamp() - start;
+        len = try comp.save_snapshot(buf);
+        comp.deinit();
+    }
+
+    const dir = std.fs.cwd();
+    try dir.writeFile(.{ .sub_path = SNAPSHOT_PATH, .data = buf[0..len] });
+    defer dir.deleteFile(SNAPSHOT_PATH) catch {};
+
+    // Each run reads the file, then decodes what it read: one relayout,
+    // one repaint rect.
+    var read_ns: i128 = 0;
+    var restore_ns: i128 = 0;
+    run = 0;
+    while (run < RUNS) : (run += 1) {
+        const read_start = std.time.nanoTimestamp();
+        const file = try dir.openFile(SNAPSHOT_PATH, .{});
+        const read_len = file.readAll(loaded) catch |err| {
+            file.close();
+            return err;
+        };
+        file.close();
+        read_ns += std.time.nanoTimestamp() - read_start;
+        std.debug.assert(read_len == len);
+
+        comp.* = compositor.Compositor.init(allocator);
+        defer comp.deinit();
+        const start = std.time.nanoTimestamp();
+        try comp.restore_snapshot(loaded[0..read_len]);
+        restore_ns += std.time.nanoTimestamp() - start;
+        std.debug.assert(comp.windows_len == WINDOW_COUNT);
+    }
+
+    std.debug.print("\nGrain OS session restore ({d} windows, {d} workspaces, {d} bytes)\n", .{
+        WINDOW_COUNT,
+        WORKSPACE_COUNT,
+        len,
+    });
+    std.debug.print("  rebuild via create_window: {d} us\n", .{@divTrunc(rebuild_ns, RUNS * 1000)});
+    std.debug.print("  snapshot file read:        {d} us\n", .{@divTrunc(read_ns, RUNS * 1000)});
+    std.debug.print("  restore_snapshot:          {d} us\n", .{@divTrunc(restore_ns, RUNS * 1000)});
+}
@@ -0,0 +1,174 @@
+//! Grain OS Bounded Map: open-addressed tables with backward-shift delete.
+//!
+//! Why: Window, workspace, animation, socket and string indexes each kept
+//! their own linear-probing table; the delete (moving chain members back
+//! over the hole instead of leaving tombstones) is easy to get subtly
+//! wrong, so it lives here once.
+//! Architecture: OpenTable probes a caller-owned slice of integer slots
+//! (fixed array or allocation, power-of-two length); the caller supplies
+//! each slot's home position, so keys may live outside the table.
+//! BoundedMap builds a fixed u32→u32 map on it with the key and value
+//! packed into one u64 slot.
+//! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
+
+const std = @import("std");
+
+// Linear-probing operations over slots of integer type Slot.
+// Contract: slots.len is a power of two and never full (callers keep the
+// load factor <= 0.5); empty marks unused slots.
+pub fn OpenTable(comptime Slot: type, comptime empty: Slot) type {
+    return struct {
+        // Position of the first slot from home that matches(context, slot),
+        // or null once an empty slot ends the probe chain.
+        pub fn find(
+            slots: []const Slot,
+            home: usize,
+            context: anytype,
+            comptime matches: fn (@TypeOf(context), Slot) bool,
+        ) ?usize {
+            std.debug.assert(std.math.isPowerOfTwo(slots.len));
+            const mask = slots.len - 1;
+            var pos = home & mask;
+            var probes: usize = 0;
+            while (probes < slots.len) : (probes += 1) {
+                const slot = slots[pos];
+                if (slot == empty) return null;
+                if (matches(context, slot)) return pos;
+                pos = (pos + 1) & mask;
+            }
+            return null;
+        }
+
+        // Store slot at the first empty position from home.
+        pub fn insert(slots: []Slot, home: usize, slot: Slot) usize {
+            std.debug.assert(std.math.isPowerOfTwo(slots.len));
+            std.debug.assert(slot != empty);
+            const mask = slots.len - 1;
+            var pos = home & mask;
+            var probes: usize = 0;
+            while (slots[pos] != empty) : (pos = (pos + 1) & mask) {
+                probes += 1;
+                std.debug.assert(probes < slots.len);
+            }
+            slots[pos] = slot;
+            return pos;
+        }
+
+        // Empty the slot at pos, moving later members of its chain back.
+        // Contract: home_of(context, slot) is the home the slot was inserted at.
+        pub fn remove_at(
+            slots: []Slot,
+            pos: usize,
+            context: anytype,
+            comptime home_of: fn (@TypeOf(context), Slot) usize,
+        ) void {
+            std.debug.assert(slots[pos] != empty);
+            const mask = slots.len - 1;
+            var hole = pos;
+            var next = (pos + 1) & mask;
+            while (slots[next] != empty) : (next = (next + 1) & mask) {
+                // Move if home is not cyclically within (hole, next].
+                const home = home_of(context, slots[next]) & mask;
+                const distance_home = (next -% home) & mask;
+                const distance_hole = (next -% hole) & mask;
+                if (distance_home >= distance_hole) {
+                    slots[hole] = slots[next];
+                    hole = next;
+                }
+            }
+            slots[hole] = empty;
+        }
+    };
+}
+
+// Fixed-capacity u32→u32 map; key 0 is reserved (ids start at 1).
+// Why: Fibonacci hashing spreads sequential ids; a u64 slot keeps key and
+// value together so a probe touches one word.
+pub fn BoundedMap(comptime capacity: u32) type {
+    // Bounded: Table size (power of two, load factor <= 0.5).
+    const table_size: u32 = std.math.ceilPowerOfTwoAssert(u32, capacity * 2);
+    const Table = OpenTable(u64, 0);
+
+    return struct {
+        const Self = @This();
+
+        pub const CAPACITY: u32 = capacity;
+
+        slots: [table_size]u64,
+        len: u32,
+
+        pub fn init() Self {
+            return Self{ .slots = [_]u64{0} ** table_size, .len = 0 };
+        }
+
+        pub fn clear(self: *Self) void {
+            @memset(&self.slots, 0);
+            self.len = 0;
+        }
+
+        pub fn count(self: *const Self) u32 {
+            return self.len;
+        }
+
+        pub fn get(self: *const Self, key: u32) ?u32 {
+            const pos = self.find(key) orelse return null;
+            return value_of(self.slots[pos]);
+        }
+
+        pub fn contains(self: *const Self, key: u32) bool {
+            return self.find(key) != null;
+        }
+
+        // Insert or update. Returns false if the map is full.
+        pub fn put(self: *Self, key: u32, value: u32) bool {
+            std.debug.assert(key != 0);
+            if (self.find(key)) |pos| {
+                self.slots[pos] = pack(key, value);
+                return true;
+            }
+            if (self.len >= capacity) return false;
+            _ = Table.insert(&self.slots, home(key), pack(key, value));
+            self.len += 1;
+            return true;
+        }
+
+        // Drop key. Returns its value (null if absent).
+        pub fn remove(self: *Self, key: u32) ?u32 {
+            const pos = self.find(key) orelse return null;
+            const value = value_of(self.slots[pos]);
+            Table.remove_at(&self.slots, pos, {}, slot_home);
+            self.len -= 1;
+            return value;
+        }
+
+        fn find(self: *const Self, key: u32) ?usize {
+            if (key == 0) return null;
+            return Table.find(&self.slots, home(key), key, slot_has_key);
+        }
+
+        fn home(key: u32) usize {
+            const hashed = key *% 0x9E3779B9;
+            return hashed >> (32 - std.math.log2_int(u32, table_size));
+        }
+
+        fn slot_home(_: void, slot: u64) usize {
+            return home(key_of(slot));
+        }
+
+        fn slot_has_key(key: u32, slot: u64) bool {
+            return key_of(slot) == key;
+        }
+
+        fn pack(key: u32, value: u32) u64 {
+            return (@as(u64, key) << 32) | value;
+        }
+
+        fn key_of(slot: u64) u32 {
+            return @intCast(slot >> 32);
+        }
+
+        fn value_of(slot: u64) u32 {
+            return @truncate(slot);
+        }
+    };
+}
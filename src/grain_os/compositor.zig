@@ -6,6 +6,8 @@
 
 const std = @import("std");
 const wayland = @import("wayland/protocol.zig");
+const wayland_server = @import("wayland/server.zig");
+const fb_primitives = @import("framebuffer_primitives");
 const basin_kernel = @import("basin_kernel");
 const tiling = @import("tiling.zig");
 const framebuffer_renderer = @import("framebuffer_renderer.zig");
@@ -18,6 +20,7 @@ const window_state = @import("window_state.zig");
 const window_preview = @import("window_preview.zig");
 const window_visual = @import("window_visual.zig");
 const window_stacking = @import("window_stacking.zig");
+const window_index = @import("window_index.zig");
 const window_opacity = @import("window_opacity.zig");
 const window_animation = @import("window_animation.zig");
 const window_decorations = @import("window_decorations.zig");
@@ -29,6 +32,7 @@ const window_drag_drop = @import("window_drag_drop.zig");
 const window_rules = @import("window_rules.zig");
 const window_events = @import("window_events.zig");
 const window_session = @import("window_session.zig");
+const session_snapshot = @import("session_snapshot.zig");
 const lock_screen_mod = @import("lock_screen.zig");
 const keyboard_shortcuts = @import("keyboard_shortcuts.zig");
 const desktop_shell = @import("desktop_shell.zig");
@@ -42,6 +46,9 @@ pub const MAX_WINDOWS: u32 = 256;
 // Bounded: Max window title length.
 pub const MAX_TITLE_LEN: u32 = 256;
 
+// Window.rule_slot value when no rule matches.
+pub const NO_RULE: u32 = std.math.maxInt(u32);
+
 // Bounded: Title bar height.
 pub const TITLE_BAR_HEIGHT: u32 = 24;
 
@@ -51,6 +58,30 @@ pub const BORDER_WIDTH: u32 = 2;
 // Bounded: Resize handle size.
 pub const RESIZE_HANDLE_SIZE: u32 = 8;
 
+// Bounded: Max input batches drained per process_input call.
+pub const MAX_INPUT_BATCHES: u32 = 8;
+
+// Shortcut auto-repeat tracking within one input batch.
+const ShortcutRepeat = struct {
+    active: bool = false,
+    key_code: u32 = 0,
+    modifiers: u8 = 0,
+
+    fn matches(self: *const ShortcutRepeat, key_code: u32, modifiers: u8) bool {
+        return self.active and self.key_code == key_code and self.modifiers == modifiers;
+    }
+
+    fn set(self: *ShortcutRepeat, key_code: u32, modifiers: u8) void {
+        self.active = true;
+        self.key_code = key_code;
+        self.modifiers = modifiers;
+    }
+
+    fn reset(self: *ShortcutRepeat) void {
+        self.active = false;
+    }
+};
+
 // Window drag state.
 pub const DragState = struct {
     active: bool,
@@ -103,6 +134,9 @@ pub const Window = struct {
     constraints: window_constraints.WindowConstraints,
     drag_state: DragState,
     resize_state: ResizeState,
+    content: ?wayland_server.BufferView, // Committed client buffer (sampled in place).
+    rule_slot: u32, // Matched rule index (NO_RULE = none), valid for rule_generation
+    rule_generation: u32, // Rule set generation of rule_slot (0 = not matched)
 
     pub fn init(
         id: u32,
@@ -148,6 +182,9 @@ pub const Window = struct {
                 .window_start_x = 0,
                 .window_start_y = 0,
             },
+            .content = null,
+            .rule_slot = NO_RULE,
+            .rule_generation = 0,
         };
         var j: u32 = 0;
         while (j < MAX_TITLE_LEN) : (j += 1) {
@@ -169,6 +206,8 @@ pub const Window = struct {
             self.title[i] = title[i];
         }
         self.title_len = @intCast(copy_len);
+        // Title rules must be matched again.
+        self.rule_generation = 0;
         std.debug.assert(self.title_len <= MAX_TITLE_LEN);
     }
 };
@@ -184,7 +223,8 @@ pub const Compositor = struct {
     output: wayland.Output,
     seat: wayland.Seat,
     framebuffer_base: u64,
-    tiling_tree: tiling.TilingTree,
+    tiling_tree: tiling.TilingTree, // Current workspace's tree
+    workspace_trees: [workspace.MAX_WORKSPACES]tiling.TilingTree, // Parked trees of hidden workspaces
     renderer: framebuffer_renderer.FramebufferRenderer,
     layout_registry: layout_generator.LayoutRegistry,
     workspace_manager: workspace.WorkspaceManager,
@@ -199,6 +239,7 @@ pub const Compositor = struct {
     state_manager: window_state.WindowStateManager,
     preview_manager: window_preview.PreviewManager,
     window_stack: window_stacking.WindowStack,
+    window_index: window_index.WindowIndex,
     animation_manager: window_animation.AnimationManager,
     group_manager: window_grouping.WindowGroupManager,
     focus_manager: window_focus.FocusManager,
@@ -209,6 +250,12 @@ pub const Compositor = struct {
     lock_screen_manager: lock_screen_mod.LockScreenManager,
     border_width: u32, // Configurable border width
     title_bar_height: u32, // Configurable title bar height
+    input_batch_active: bool, // Inside process_input (layout deferred)
+    layout_pending: bool, // Layout requested during the current input batch
+    repaint_damage: ?fb_primitives.Rect, // Screen damage awaiting repaint
+    presented_signature: u64, // scene_signature of the last present (0 = none)
+    frame_count: u64, // Frames rendered (preview timestamps)
+    frame_time: u64, // Animation clock for the next frame (milliseconds)
 
     pub fn init(allocator: std.mem.Allocator) Compositor {
         std.debug.assert(@intFromPtr(allocator.ptr) != 0);
@@ -223,6 +270,7 @@ pub const Compositor = struct {
             .seat = wayland.Seat.init(3),
             .framebuffer_base = 0x90000000,
             .tiling_tree = tiling.TilingTree.init(),
+            .workspace_trees = [_]tiling.TilingTree{tiling.TilingTree.init()} ** workspace.MAX_WORKSPACES,
             .renderer = framebuffer_renderer.FramebufferRenderer.init(),
             .layout_registry = layout_generator.LayoutRegistry.init(),
             .workspace_manager = workspace.WorkspaceManager.init(),
@@ -237,29 +285,58 @@ pub const Compositor = struct {
             .state_manager = window_state.WindowStateManager.init(),
             .preview_manager = window_preview.PreviewManager.init(),
             .window_stack = window_stacking.WindowStack.init(),
+            .window_index = window_index.WindowIndex.init(),
             .animation_manager = window_animation.AnimationManager.init(),
             .group_manager = window_grouping.WindowGroupManager.init(),
             .focus_manager = window_focus.FocusManager.init(),
             .drop_zone_manager = window_drag_drop.DropZoneManager.init(),
-            .rule_manager = window_rules.WindowRuleManager.init(),
+            .rule_manager = window_rules.WindowRuleManager.init(allocator),
             .event_manager = window_events.EventManager.init(),
             .session_manager = window_session.SessionManager.init(),
             .lock_screen_manager = lock_screen_mod.LockScreenManager.init(),
             .border_width = BORDER_WIDTH, // Default border width
             .title_bar_height = TITLE_BAR_HEIGHT, // Default title bar height
+            .input_batch_active = false,
+            .layout_pending = false,
+            .repaint_damage = null,
+            .presented_signature = 0,
+            .frame_count = 0,
+            .frame_time = 0,
         };
-        var i: u32 = 0;
-        while (i < MAX_WINDOWS) : (i += 1) {
-            compositor.windows[i] = Window.init(0, 0, 0, 0, 0, 0);
-        }
-        compositor.next_object_id = 4;
-        compositor.app_launcher = application.ApplicationLauncher.init(
-            &compositor.app_registry,
+        // Slots past windows_len are never read; create_window fills them.
+        comp.next_object_id = 4;
+        comp.app_launcher = application.ApplicationLauncher.init(
+            &comp.app_registry,
         );
-        compositor.shell.set_app_registry(&compositor.app_registry);
-        std.debug.assert(compositor.windows_len == 0);
-        std.debug.assert(compositor.next_window_id > 0);
-        return compositor;
+        std.debug.assert(comp.windows_len == 0);
+        std.debug.assert(comp.next_window_id > 0);
+        return comp;
+    }
+
+    // Free rule automaton storage (only allocated once rules are matched).
+    pub fn deinit(self: *Compositor) void {
+        self.rule_manager.deinit();
+    }
+
+    // Initialize at a fixed address and wire self-referencing members.
+    // Why: The shell and launcher hold pointers into the compositor, so
+    // they can only be bound once it has stopped moving.
+    pub fn init_in_place(self: *Compositor, allocator: std.mem.Allocator) void {
+        self.* = Compositor.init(allocator);
+        self.app_launcher = application.ApplicationLauncher.init(&self.app_registry);
+        self.shell = desktop_shell.DesktopShell.init(
+            &self.renderer,
+            self.output.width,
+            self.output.height,
+        );
+        self.shell.set_app_registry(&self.app_registry);
+        std.debug.assert(self.shell.renderer == &self.renderer);
+    }
+
+    // Set the animation clock used by the next render (milliseconds).
+    pub fn set_frame_time(self: *Compositor, time_ms: u64) void {
+        std.debug.assert(time_ms >= self.frame_time);
+        self.frame_time = time_ms;
     }
 
     pub fn create_window(
@@ -283,6 +360,7 @@ pub const Compositor = struct {
             height,
         );
         self.windows[self.windows_len] = window;
+        _ = self.window_index.insert(window_id, self.windows_len);
         self.windows_len += 1;
         // Assign window to current workspace.
         if (self.workspace_manager.get_current_workspace()) |current_ws| {
@@ -308,14 +386,20 @@ pub const Compositor = struct {
                 win.y = bounds.y;
                 win.width = bounds.width;
                 win.height = bounds.height;
+                self.index_window_geometry(win);
             }
         }
         // Add window to switch order.
         _ = self.switch_order.add_window(window_id);
         // Add window to stacking order (at top).
         _ = self.window_stack.add_window(window_id);
+        self.index_stack_order();
+        // Match window rules once at creation (cached on the window).
+        if (self.get_window(window_id)) |win| {
+            self.match_window_rules(win);
+        }
         // Start fade-in effect for new window.
-        _ = window_effects.start_fade_in(&self.animation_manager, window_id, 0);
+        _ = window_effects.start_fade_in(&self.animation_manager, window_id, self.frame_time);
         std.debug.assert(self.windows_len <= MAX_WINDOWS);
         std.debug.assert(window_id > 0);
         return window_id;
@@ -323,36 +407,50 @@ pub const Compositor = struct {
 
     pub fn get_window(self: *Compositor, window_id: u32) ?*Window {
         std.debug.assert(window_id > 0);
-        var i: u32 = 0;
-        while (i < self.windows_len) : (i += 1) {
-            if (self.windows[i].id == window_id) {
-                std.debug.assert(self.windows[i].id == window_id);
-                return &self.windows[i];
-            }
+        if (self.window_index.slot_of(window_id)) |slot| {
+            std.debug.assert(slot < self.windows_len);
+            std.debug.assert(self.windows[slot].id == window_id);
+            return &self.windows[slot];
         }
         return null;
     }
 
+    // Const window lookup (same id index as get_window).
+    pub fn get_window_const(self: *const Compositor, window_id: u32) ?*const Window {
+        std.debug.assert(window_id > 0);
+        if (self.window_index.slot_of(window_id)) |slot| {
+            std.debug.assert(self.windows[slot].id == window_id);
+            return &self.windows[slot];
+        }
+        return null;
+    }
+
+    // Refresh the spatial index after a window's geometry changed.
+    fn index_window_geometry(self: *Compositor, win: *const Window) void {
+        self.window_index.update_rect(win.id, win.x, win.y, win.width, win.height);
+        self.preview_manager.mark_damaged(win.id);
+    }
+
+    // Refresh hit-test ranks after the stacking order changed.
+    fn index_stack_order(self: *Compositor) void {
+        self.window_index.set_stack_order(
+            self.window_stack.window_ids[0..self.window_stack.window_ids_len],
+        );
+    }
+
     pub fn remove_window(self: *Compositor, window_id: u32) bool {
         std.debug.assert(window_id > 0);
-        // Find and remove window from array.
-        var i: u32 = 0;
-        var found: bool = false;
-        while (i < self.windows_len) : (i += 1) {
-            if (self.windows[i].id == window_id) {
-                found = true;
-                break;
+        // Find window slot via id index.
+        var i: u32 = self.window_index.slot_of(window_id) orelse return false;
+        // Remove from its workspace and that workspace's tiling tree.
+        const owner_id = self.workspace_manager.remove_window(window_id);
+        _ = self.tiling_tree_for(owner_id).remove_window(window_id);
+        // A hidden owner re-tiles lazily when next shown.
+        if (owner_id) |id| {
+            if (id != self.workspace_manager.current_workspace_id) {
+                self.workspace_manager.get_workspace(id).?.layout_valid = false;
             }
         }
-        if (!found) {
-            return false;
-        }
-        // Remove from tiling tree.
-        _ = self.tiling_tree.remove_window(window_id);
-        // Remove from workspace.
-        if (self.workspace_manager.get_current_workspace()) |ws| {
-            _ = ws.remove_window(window_id);
-        }
         // Remove from switch order.
         _ = self.switch_order.remove_window(window_id);
         // Remove from stacking order.
@@ -365,13 +463,16 @@ pub const Compositor = struct {
         self.group_manager.remove_window_from_all_groups(window_id);
         // Start fade-out effect before removal (would wait for completion in full impl).
         if (self.get_window(window_id)) |win| {
-            _ = window_effects.start_fade_out(&self.animation_manager, window_id, win.opacity, 0);
+            _ = window_effects.start_fade_out(&self.animation_manager, window_id, win.opacity, self.frame_time);
         }
-        // Shift remaining windows left.
+        _ = self.window_index.remove(window_id);
+        // Shift remaining windows left (slots of shifted windows change).
         while (i < self.windows_len - 1) : (i += 1) {
             self.windows[i] = self.windows[i + 1];
+            self.window_index.set_slot(self.windows[i].id, i);
         }
         self.windows_len -= 1;
+        self.index_stack_order();
         // Recalculate layout with current layout generator.
         self.layout_registry.apply_layout(
             &self.tiling_tree,
@@ -387,18 +488,27 @@ pub const Compositor = struct {
                 self.windows[j].y = bounds.y;
                 self.windows[j].width = bounds.width;
                 self.windows[j].height = bounds.height;
+                self.index_window_geometry(&self.windows[j]);
             }
         }
         return true;
     }
 
     pub fn recalculate_layout(self: *Compositor) void {
+        // Inside an input batch: run once when the batch ends.
+        if (self.input_batch_active) {
+            self.layout_pending = true;
+            return;
+        }
         // Recalculate tiling layout with current layout generator.
         self.layout_registry.apply_layout(
             &self.tiling_tree,
             self.output.width,
             self.output.height,
         );
+        if (self.workspace_manager.get_current_workspace()) |ws| {
+            ws.layout_valid = true;
+        }
         // Update window positions.
         var i: u32 = 0;
         while (i < self.windows_len) : (i += 1) {
@@ -408,6 +518,7 @@ pub const Compositor = struct {
                 self.windows[i].y = bounds.y;
                 self.windows[i].width = bounds.width;
                 self.windows[i].height = bounds.height;
+                self.index_window_geometry(&self.windows[i]);
             }
         }
     }
@@ -416,6 +527,8 @@ pub const Compositor = struct {
         std.debug.assert(@intFromEnum(layout_type) < 4);
         const success = self.layout_registry.set_current_layout(layout_type);
         if (success) {
+            // Hidden workspaces re-tile lazily when next shown.
+            self.workspace_manager.invalidate_hidden_layouts();
             self.layout_registry.apply_layout(
                 &self.tiling_tree,
                 self.output.width,
@@ -430,6 +543,7 @@ pub const Compositor = struct {
                     self.windows[i].y = bounds.y;
                     self.windows[i].width = bounds.width;
                     self.windows[i].height = bounds.height;
+                    self.index_window_geometry(&self.windows[i]);
                 }
             }
         }
@@ -440,9 +554,76 @@ pub const Compositor = struct {
         return self.layout_registry.current_layout;
     }
 
+    // Switch workspaces by swapping cached state, not recomputing it.
+    // Why: Each workspace parks its tiling tree (with computed geometry) and
+    // focus; windows keep their geometry while hidden. A switch swaps trees,
+    // flips visibility for the outgoing and incoming window sets only, and
+    // damages just their rects. Layout reruns only if it was invalidated.
     pub fn switch_workspace(self: *Compositor, workspace_id: u32) bool {
         std.debug.assert(workspace_id > 0);
-        return self.workspace_manager.switch_workspace(workspace_id);
+        const old_id = self.workspace_manager.current_workspace_id;
+        std.debug.assert(old_id > 0);
+        if (workspace_id == old_id) {
+            return self.workspace_manager.get_workspace(workspace_id) != null;
+        }
+        if (!self.workspace_manager.switch_workspace(workspace_id)) {
+            return false;
+        }
+        // Park the outgoing tree, then unpark the incoming one.
+        std.mem.swap(tiling.TilingTree, &self.tiling_tree, &self.workspace_trees[old_id - 1]);
+        std.mem.swap(tiling.TilingTree, &self.tiling_tree, &self.workspace_trees[workspace_id - 1]);
+        const old_ws = self.workspace_manager.get_workspace(old_id).?;
+        const new_ws = self.workspace_manager.get_workspace(workspace_id).?;
+        // Save outgoing focus; restore incoming focus.
+        old_ws.focused_window_id = self.focused_window_id;
+        if (self.focused_window_id != 0) {
+            if (self.get_window(self.focused_window_id)) |win| win.focused = false;
+        }
+        self.focused_window_id = 0;
+        if (new_ws.focused_window_id != 0) {
+            if (self.get_window(new_ws.focused_window_id)) |win| {
+                win.focused = true;
+                self.focused_window_id = win.id;
+            }
+        }
+        // Visibility set difference: workspaces are disjoint.
+        self.set_workspace_visibility(old_ws, false);
+        if (!new_ws.layout_valid) {
+            self.recalculate_layout();
+        }
+        self.set_workspace_visibility(new_ws, true);
+        return true;
+    }
+
+    // Show or hide one workspace's windows, damaging their rects.
+    fn set_workspace_visibility(self: *Compositor, ws: *const workspace.Workspace, visible: bool) void {
+        var i: u32 = 0;
+        while (i < ws.window_ids_len) : (i += 1) {
+            const win = self.get_window(ws.window_ids[i]) orelse continue;
+            if (win.visible == visible) continue;
+            win.visible = visible;
+            if (win.minimized) continue;
+            if (fb_primitives.clip_rect(
+                self.output.width,
+                self.output.height,
+                win.x,
+                win.y,
+                win.width,
+                win.height,
+            )) |rect| {
+                self.add_repaint_damage(rect);
+            }
+        }
+    }
+
+    // Tiling tree holding a workspace's windows (null = current).
+    fn tiling_tree_for(self: *Compositor, workspace_id: ?u32) *tiling.TilingTree {
+        const id = workspace_id orelse return &self.tiling_tree;
+        if (id == self.workspace_manager.current_workspace_id) {
+            return &self.tiling_tree;
+        }
+        std.debug.assert(id > 0 and id <= workspace.MAX_WORKSPACES);
+        return &self.workspace_trees[id - 1];
     }
 
     pub fn get_current_workspace_id(self: *const Compositor) u32 {
@@ -461,15 +642,26 @@ pub const Compositor = struct {
     ) bool {
         std.debug.assert(window_id > 0);
         std.debug.assert(workspace_id > 0);
+        const old_id = self.workspace_manager.get_window_workspace(window_id);
         const assigned = self.workspace_manager.assign_window_to_workspace(
             window_id,
             workspace_id,
         );
         if (assigned) {
+            // Move the window between workspace tiling trees.
+            _ = self.tiling_tree_for(old_id).remove_window(window_id);
+            self.tiling_tree_for(workspace_id).add_window(window_id) catch {};
+            const current_id = self.workspace_manager.current_workspace_id;
             // Update window visibility.
             if (self.get_window(window_id)) |win| {
-                const is_current = (workspace_id == self.workspace_manager.current_workspace_id);
-                win.visible = is_current;
+                win.visible = (workspace_id == current_id);
+            }
+            // Hidden workspaces re-tile lazily when next shown.
+            if (old_id) |id| {
+                if (id != current_id) self.workspace_manager.get_workspace(id).?.layout_valid = false;
+            }
+            if (workspace_id != current_id) {
+                self.workspace_manager.get_workspace(workspace_id).?.layout_valid = false;
             }
             // Recalculate layout.
             self.recalculate_layout();
@@ -479,8 +671,75 @@ pub const Compositor = struct {
 
     pub fn render_to_framebuffer(self: *Compositor) void {
         std.debug.assert(self.framebuffer_base > 0);
-        // Update animations (simplified: use fixed timestamp).
-        self.update_animations(0); // Would use actual timestamp in full impl.
+        // Update animations at the caller-supplied frame clock.
+        self.update_animations(self.frame_time);
+        self.draw_scene();
+    }
+
+    // Present one frame, repainting only what changed.
+    // Why: A client commit damages a few rows of one window; redrawing the
+    // whole output for it costs the full framebuffer every frame.
+    // Client commits only add repaint damage. Everything else that shows on
+    // screen (geometry, stacking, focus, titles, visibility, shell) is
+    // folded into scene_signature; when that changed, or there is no direct
+    // surface to clip, the whole frame is redrawn.
+    // Returns: screen rect repainted, or null if nothing needed drawing.
+    pub fn present(self: *Compositor) ?fb_primitives.Rect {
+        std.debug.assert(self.framebuffer_base > 0);
+        self.update_animations(self.frame_time);
+        const damage = self.take_repaint_damage();
+        const signature = self.scene_signature();
+        const scene_changed = signature != self.presented_signature;
+        self.presented_signature = signature;
+        if (scene_changed or self.renderer.surface == null) {
+            self.draw_scene();
+            return fb_primitives.Rect{ .x = 0, .y = 0, .width = self.output.width, .height = self.output.height };
+        }
+        const rect = damage orelse return null;
+        self.renderer.set_clip(rect);
+        defer self.renderer.set_clip(null);
+        self.draw_scene();
+        return rect;
+    }
+
+    // Hash of everything drawn besides client pixels (see present).
+    fn scene_signature(self: *const Compositor) u64 {
+        var hasher = std.hash.Wyhash.init(0);
+        const stack = self.window_stack.window_ids[0..self.window_stack.window_ids_len];
+        hasher.update(std.mem.sliceAsBytes(stack));
+        var i: u32 = 0;
+        while (i < self.windows_len) : (i += 1) {
+            const win = &self.windows[i];
+            std.hash.autoHash(&hasher, win.id);
+            std.hash.autoHash(&hasher, win.x);
+            std.hash.autoHash(&hasher, win.y);
+            std.hash.autoHash(&hasher, win.width);
+            std.hash.autoHash(&hasher, win.height);
+            std.hash.autoHash(&hasher, win.visible);
+            std.hash.autoHash(&hasher, win.focused);
+            std.hash.autoHash(&hasher, win.minimized);
+            std.hash.autoHash(&hasher, win.opacity);
+            std.hash.autoHash(&hasher, win.maximized);
+            if (win.content) |view| {
+                std.hash.autoHash(&hasher, view.width);
+                std.hash.autoHash(&hasher, view.height);
+            } else {
+                std.hash.autoHash(&hasher, @as(u32, 0));
+            }
+            hasher.update(win.title[0..win.title_len]);
+        }
+        std.hash.autoHash(&hasher, self.workspace_manager.current_workspace_id);
+        std.hash.autoHash(&hasher, self.border_width);
+        std.hash.autoHash(&hasher, self.title_bar_height);
+        std.hash.autoHash(&hasher, self.shell.launcher_visible);
+        std.hash.autoHash(&hasher, self.shell.launcher_items_len);
+        std.hash.autoHash(&hasher, self.shell.current_time_seconds);
+        // 0 is reserved for "never presented".
+        return hasher.final() | 1;
+    }
+
+    // Draw the scene (through the renderer's clip, if set).
+    fn draw_scene(self: *Compositor) void {
         // Clear framebuffer to background color.
         self.renderer.clear(framebuffer_renderer.COLOR_DARK_BG);
         // Render windows in stacking order (bottom to top).
@@ -497,6 +756,9 @@ pub const Compositor = struct {
         // Render desktop shell (status bar and launcher).
         self.shell.set_current_workspace(self.workspace_manager.current_workspace_id);
         self.shell.render();
+        // Refresh stale thumbnails from this frame's pixels (budgeted).
+        self.frame_count += 1;
+        _ = self.refresh_previews();
     }
 
     // Render window decorations (border, title bar, content area).
@@ -571,19 +833,103 @@ pub const Compositor = struct {
         // Draw title bar buttons.
         self.render_title_bar_buttons(win);
         // Draw window content area (background, apply opacity).
+        const content_x = @as(i32, @intCast(win.x)) + @as(i32, @intCast(self.border_width));
         const content_y = @as(i32, @intCast(win.y)) + @as(i32, @intCast(self.border_width + self.title_bar_height));
+        const content_width = win.width - (self.border_width * 2);
         const content_height = win.height - (self.border_width * 2) - self.title_bar_height;
-        const content_color = window_opacity.apply_opacity_to_color(
-            framebuffer_renderer.COLOR_WHITE,
-            win.opacity,
-        );
-        self.renderer.draw_rect(
-            @as(i32, @intCast(win.x)) + @as(i32, @intCast(self.border_width)),
-            content_y,
-            win.width - (self.border_width * 2),
-            content_height,
-            content_color,
-        );
+        const covered = if (win.content) |view|
+            view.width >= content_width and view.height >= content_height
+        else
+            false;
+        if (!covered) {
+            const content_color = window_opacity.apply_opacity_to_color(
+                framebuffer_renderer.COLOR_WHITE,
+                win.opacity,
+            );
+            self.renderer.draw_rect(
+                content_x,
+                content_y,
+                content_width,
+                content_height,
+                content_color,
+            );
+        }
+        // Client pixels: sampled straight from the shm pool (no copy).
+        if (win.content) |view| {
+            const src_rect = fb_primitives.Rect{
+                .x = 0,
+                .y = 0,
+                .width = @min(view.width, content_width),
+                .height = @min(view.height, content_height),
+            };
+            _ = self.renderer.blit_surface(
+                content_x,
+                content_y,
+                view.as_surface(),
+                src_rect,
+                !view.is_rgba_order(),
+                view.is_opaque(),
+            );
+        }
+    }
+
+    // Wayland server hooks: committed surfaces become managed windows.
+    pub fn wayland_sink(self: *Compositor) wayland_server.SurfaceSink {
+        return wayland_server.SurfaceSink{
+            .context = self,
+            .map_fn = sink_map,
+            .commit_fn = sink_commit,
+            .unmap_fn = sink_unmap,
+        };
+    }
+
+    // Return and reset screen damage (client commits, workspace switches).
+    pub fn take_repaint_damage(self: *Compositor) ?fb_primitives.Rect {
+        const result = self.repaint_damage;
+        self.repaint_damage = null;
+        return result;
+    }
+
+    fn add_repaint_damage(self: *Compositor, rect: fb_primitives.Rect) void {
+        self.repaint_damage = if (self.repaint_damage) |acc| acc.union_with(rect) else rect;
+    }
+
+    fn sink_map(context: *anyopaque, width: u32, height: u32) u32 {
+        const self: *Compositor = @ptrCast(@alignCast(context));
+        if (self.windows_len >= MAX_WINDOWS) return 0;
+        // Size the frame around the buffer; tiling may still resize it.
+        return self.create_window(
+            width + self.border_width * 2,
+            height + self.border_width * 2 + self.title_bar_height,
+        ) catch 0;
+    }
+
+    fn sink_commit(
+        context: *anyopaque,
+        window_id: u32,
+        view: ?wayland_server.BufferView,
+        damage: ?fb_primitives.Rect,
+    ) void {
+        const self: *Compositor = @ptrCast(@alignCast(context));
+        const win = self.get_window(window_id) orelse return;
+        win.content = view;
+        self.preview_manager.mark_damaged(window_id);
+        const local = damage orelse return;
+        // Surface-local damage → screen rect (clipped to the output).
+        const screen = fb_primitives.clip_rect(
+            self.output.width,
+            self.output.height,
+            win.x + @as(i32, @intCast(self.border_width + local.x)),
+            win.y + @as(i32, @intCast(self.border_width + self.title_bar_height + local.y)),
+            local.width,
+            local.height,
+        ) orelse return;
+        self.add_repaint_damage(screen);
+    }
+
+    fn sink_unmap(context: *anyopaque, window_id: u32) void {
+        const self: *Compositor = @ptrCast(@alignCast(context));
+        _ = self.remove_window(window_id);
     }
 
     // Render window shadow.
@@ -657,26 +1003,19 @@ pub const Compositor = struct {
         self.input.set_syscall_fn(fn_ptr);
     }
 
-    // Find window at mouse position (hit testing).
+    // Find topmost window at mouse position (hit testing).
+    // Why: Spatial grid visits only windows overlapping the cursor's cell;
+    // stacking rank picks the topmost one.
     pub fn find_window_at(self: *const Compositor, x: u32, y: u32) ?u32 {
         std.debug.assert(x < self.output.width);
         std.debug.assert(y < self.output.height);
-        // Check windows in reverse order (top to bottom).
-        var i: u32 = self.windows_len;
-        while (i > 0) {
-            i -= 1;
-            const win = &self.windows[i];
-            if (win.visible and !win.minimized) {
-                const win_x = @as(u32, @intCast(win.x));
-                const win_y = @as(u32, @intCast(win.y));
-                if (x >= win_x and x < win_x + win.width and
-                    y >= win_y and y < win_y + win.height)
-                {
-                    return win.id;
-                }
-            }
-        }
-        return null;
+        return self.window_index.hit_test(x, y, self, is_hit_testable);
+    }
+
+    fn is_hit_testable(self: *const Compositor, slot: u32) bool {
+        std.debug.assert(slot < self.windows_len);
+        const win = &self.windows[slot];
+        return win.visible and !win.minimized;
     }
 
     // Focus window by ID.
@@ -698,6 +1037,7 @@ pub const Compositor = struct {
             self.switch_order.move_to_front(window_id);
             // Raise to top of stacking order.
             _ = self.window_stack.raise_to_top(window_id);
+            self.index_stack_order();
             return true;
         }
         return false;
@@ -713,99 +1053,168 @@ pub const Compositor = struct {
         }
     }
 
-    // Process input events and route to windows.
+    // Process all pending input events and route to windows.
+    // Why: One syscall per batch, motion runs collapsed to their latest
+    // position, and layout recalculated once per batch instead of per event.
     pub fn process_input(self: *Compositor) !void {
-        const event_opt = try self.input.read_event();
-        if (event_opt) |event| {
-            if (event.event_type == .mouse) {
-                // Handle mouse events.
-                if (event.mouse.kind == .down) {
-                    // Check for launcher item click first.
-                    if (self.shell.launcher_visible) {
-                        if (self.shell.get_launcher_item_at(
-                            event.mouse.x,
-                            event.mouse.y,
-                        )) |item_index| {
-                            if (item_index < self.shell.launcher_items_len) {
-                                const item = &self.shell.launcher_items[item_index];
-                                const cmd_slice = item.command[0..item.command_len];
-                                _ = self.launch_application(cmd_slice);
-                            }
-                            return;
-                        }
-                    }
-                    // Check for window resize handle.
-                    const window_id_opt = self.find_window_at(
+        var events: [input_handler.MAX_BATCH_EVENTS]input_handler.InputEvent = undefined;
+        var repeat = ShortcutRepeat{};
+        self.input_batch_active = true;
+        defer self.end_input_batch();
+        var batch: u32 = 0;
+        while (batch < MAX_INPUT_BATCHES) : (batch += 1) {
+            const read = try self.input.read_events(&events);
+            if (read == 0) {
+                break;
+            }
+            const count = input_handler.coalesce_motion(events[0..read]);
+            var i: u32 = 0;
+            while (i < count) : (i += 1) {
+                self.handle_input_event(&events[i], &repeat);
+            }
+            // Short batch: queue drained.
+            if (read < events.len) {
+                break;
+            }
+        }
+    }
+
+    // Finish an input batch: run deferred layout once.
+    fn end_input_batch(self: *Compositor) void {
+        std.debug.assert(self.input_batch_active);
+        self.input_batch_active = false;
+        if (self.layout_pending) {
+            self.layout_pending = false;
+            self.recalculate_layout();
+        }
+    }
+
+    // Run layout deferred by earlier events in this batch before a hit-test.
+    // Why: A close/minimize/shortcut earlier in the batch moves windows;
+    // hit-testing against stale geometry would pick the wrong window.
+    fn flush_pending_layout(self: *Compositor) void {
+        if (!self.layout_pending) {
+            return;
+        }
+        std.debug.assert(self.input_batch_active);
+        self.layout_pending = false;
+        self.input_batch_active = false;
+        self.recalculate_layout();
+        self.input_batch_active = true;
+    }
+
+    // Route one input event to windows.
+    fn handle_input_event(
+        self: *Compositor,
+        event: *const input_handler.InputEvent,
+        repeat: *ShortcutRepeat,
+    ) void {
+        if (event.event_type == .mouse) {
+            // Button transitions end any key-repeat run.
+            if (!input_handler.is_motion(event)) {
+                repeat.reset();
+            }
+            // Handle mouse events.
+            if (event.mouse.kind == .down) {
+                self.flush_pending_layout();
+                // Check for launcher item click first.
+                if (self.shell.launcher_visible) {
+                    if (self.shell.get_launcher_item_at(
                         event.mouse.x,
                         event.mouse.y,
-                    );
-                    if (window_id_opt) |window_id| {
-                        if (self.get_resize_handle(window_id, event.mouse.x, event.mouse.y)) |handle| {
-                            if (handle != ResizeHandle.none) {
-                                self.start_resize(window_id, handle, event.mouse.x, event.mouse.y);
-                            } else if (self.get_window(window_id)) |win| {
-                                const button_type = window_decorations.get_button_at(
-                                    win.x,
-                                    win.y,
-                                    win.width,
-                                    event.mouse.x,
-                                    event.mouse.y,
-                                );
-                                if (button_type == window_decorations.ButtonType.close) {
-                                    _ = self.remove_window(window_id);
-                                } else if (button_type == window_decorations.ButtonType.minimize) {
-                                    _ = self.minimize_window(window_id);
-                                } else if (button_type == window_decorations.ButtonType.maximize) {
-                                    if (win.maximized) {
-                                        _ = self.unmaximize_window(window_id);
-                                    } else {
-                                        _ = self.maximize_window(window_id);
-                                    }
-                                } else if (self.is_in_title_bar(window_id, event.mouse.x, event.mouse.y)) {
-                                    self.start_drag(window_id, event.mouse.x, event.mouse.y);
+                    )) |item_index| {
+                        if (item_index < self.shell.launcher_items_len) {
+                            const item = &self.shell.launcher_items[item_index];
+                            const cmd_slice = item.command[0..item.command_len];
+                            _ = self.launch_application(cmd_slice);
+                        }
+                        return;
+                    }
+                }
+                // Check for window resize handle.
+                const window_id_opt = self.find_window_at(
+                    event.mouse.x,
+                    event.mouse.y,
+                );
+                if (window_id_opt) |window_id| {
+                    if (self.get_resize_handle(window_id, event.mouse.x, event.mouse.y)) |handle| {
+                        if (handle != ResizeHandle.none) {
+                            self.start_resize(window_id, handle, event.mouse.x, event.mouse.y);
+                        } else if (self.get_window(window_id)) |win| {
+                            const button_type = window_decorations.get_button_at(
+                                win.x,
+                                win.y,
+                                win.width,
+                                event.mouse.x,
+                                event.mouse.y,
+                            );
+                            if (button_type == window_decorations.ButtonType.close) {
+                                _ = self.remove_window(window_id);
+                            } else if (button_type == window_decorations.ButtonType.minimize) {
+                                _ = self.minimize_window(window_id);
+                            } else if (button_type == window_decorations.ButtonType.maximize) {
+                                if (win.maximized) {
+                                    _ = self.unmaximize_window(window_id);
                                 } else {
-                                    _ = self.focus_window(window_id);
+                                    _ = self.maximize_window(window_id);
                                 }
+                            } else if (self.is_in_title_bar(window_id, event.mouse.x, event.mouse.y)) {
+                                self.start_drag(window_id, event.mouse.x, event.mouse.y);
+                            } else {
+                                _ = self.focus_window(window_id);
                             }
-                        } else {
-                            self.unfocus_all();
                         }
                     } else {
                         self.unfocus_all();
                     }
-                } else if (event.mouse.kind == .move) {
-                    // Handle mouse move (dragging/resizing, focus-follows-mouse).
-                    self.handle_mouse_move(event.mouse.x, event.mouse.y);
-                    // Focus-follows-mouse: focus window under cursor.
-                    if (self.focus_manager.should_focus_on_mouse_move()) {
-                        if (self.find_window_at(event.mouse.x, event.mouse.y)) |window_id| {
-                            if (window_id != self.focused_window_id) {
-                                _ = self.focus_window(window_id);
-                            }
-                        } else if (self.focus_manager.should_unfocus_on_mouse_leave()) {
-                            self.unfocus_all();
+                } else {
+                    self.unfocus_all();
+                }
+            } else if (event.mouse.kind == .move) {
+                // Handle mouse move (dragging/resizing, focus-follows-mouse).
+                self.handle_mouse_move(event.mouse.x, event.mouse.y);
+                // Focus-follows-mouse: focus window under cursor.
+                if (self.focus_manager.should_focus_on_mouse_move()) {
+                    self.flush_pending_layout();
+                    if (self.find_window_at(event.mouse.x, event.mouse.y)) |window_id| {
+                        if (window_id != self.focused_window_id) {
+                            _ = self.focus_window(window_id);
                         }
+                    } else if (self.focus_manager.should_unfocus_on_mouse_leave()) {
+                        self.unfocus_all();
                     }
-                } else if (event.mouse.kind == .up) {
-                    // Handle mouse release (end drag/resize).
-                    self.end_drag();
-                    self.end_resize();
                 }
-            } else if (event.event_type == .keyboard) {
-                // Handle keyboard shortcuts for window management.
-                if (event.keyboard.kind == .down) {
-                    const action_opt = self.shortcut_registry.find_shortcut(
-                        event.keyboard.modifiers,
-                        event.keyboard.key_code,
-                    );
-                    if (action_opt) |action| {
-                        if (self.focused_window_id > 0) {
-                            _ = action(self, self.focused_window_id);
+            } else if (event.mouse.kind == .up) {
+                // Handle mouse release (end drag/resize).
+                self.end_drag();
+                self.end_resize();
+            }
+        } else if (event.event_type == .keyboard) {
+            // Handle keyboard shortcuts for window management.
+            if (event.keyboard.kind == .up) {
+                repeat.reset();
+            } else if (event.keyboard.kind == .down) {
+                const action_opt = self.shortcut_registry.find_shortcut(
+                    event.keyboard.modifiers,
+                    event.keyboard.key_code,
+                );
+                if (action_opt) |action| {
+                    // Auto-repeat of the same chord within a batch: run once.
+                    if (repeat.matches(event.keyboard.key_code, event.keyboard.modifiers)) {
+                        return;
+                    }
+                    repeat.set(event.keyboard.key_code, event.keyboard.modifiers);
+                    if (self.focused_window_id > 0) {
+                        const target_id = self.focused_window_id;
+                        _ = action(self, target_id);
+                        // Actions reposition windows directly.
+                        if (self.get_window(target_id)) |win| {
+                            self.index_window_geometry(win);
                         }
-                    } else if (self.focused_window_id > 0) {
-                        // Route keyboard event to focused window if no shortcut matched.
-                        _ = event.keyboard;
                     }
+                } else if (self.focused_window_id > 0) {
+                    // Route keyboard event to focused window if no shortcut matched.
+                    _ = event.keyboard;
                 }
             }
         }
@@ -842,6 +1251,7 @@ pub const Compositor = struct {
             win.y = @as(i32, @intCast(self.border_width + self.title_bar_height));
             win.width = self.output.width;
             win.height = self.output.height - (self.border_width * 2) - self.title_bar_height;
+            self.index_window_geometry(win);
             self.recalculate_layout();
             return true;
         }
@@ -859,6 +1269,7 @@ pub const Compositor = struct {
                 win.y = bounds.y;
                 win.width = bounds.width;
                 win.height = bounds.height;
+                self.index_window_geometry(win);
             }
             self.recalculate_layout();
             return true;
@@ -958,6 +1369,7 @@ pub const Compositor = struct {
                 win.y = state.y;
                 win.width = state.width;
                 win.height = state.height;
+                self.index_window_geometry(win);
                 win.minimized = state.minimized;
                 win.maximized = state.maximized;
                 win.visible = !state.minimized;
@@ -994,16 +1406,62 @@ pub const Compositor = struct {
     // Generate preview for window.
     pub fn generate_window_preview(self: *Compositor, window_id: u32) bool {
         std.debug.assert(window_id > 0);
-        if (self.get_window(window_id)) |win| {
-            return self.preview_manager.generate_preview(
-                window_id,
-                win.x,
-                win.y,
-                win.width,
-                win.height,
-                self.output.width,
-                self.output.height,
-            );
+        if (self.get_window(window_id) == null) return false;
+        return self.preview_manager.generate_preview_from(
+            window_id,
+            preview_source_of(self, window_id),
+        );
+    }
+
+    // Recapture damaged previews within the per-frame sampling budget.
+    pub fn refresh_previews(self: *Compositor) u32 {
+        return self.preview_manager.refresh_dirty(
+            self,
+            preview_source_of,
+            self.frame_count,
+            window_preview.REFRESH_TAP_BUDGET,
+        );
+    }
+
+    // Preview pixels: client buffer if committed, else the window's screen rect.
+    // Why: The screen holds the composited frame, so an occluded window's
+    // rect shows whatever covers it; keep the last capture until uncovered.
+    fn preview_source_of(self: *Compositor, window_id: u32) window_preview.Capture {
+        const win = self.get_window_const(window_id) orelse return .fallback;
+        if (win.content) |view| {
+            const surface = view.as_surface();
+            return .{ .pixels = window_preview.PreviewSource{
+                .surface = surface,
+                .rect = surface.bounds(),
+                .swap_red_blue = !view.is_rgba_order(),
+                .force_opaque = view.is_opaque(),
+            } };
+        }
+        const screen = self.renderer.surface orelse return .fallback;
+        const rect = screen.clip(win.x, win.y, win.width, win.height) orelse return .fallback;
+        if (self.is_occluded(win)) return .keep;
+        return .{ .pixels = window_preview.PreviewSource{ .surface = screen, .rect = rect } };
+    }
+
+    // True if a shown window stacked above overlaps win (decorations included).
+    fn is_occluded(self: *const Compositor, win: *const Window) bool {
+        // Shadow and focus glow draw outside the frame rect.
+        const margin: i64 = @max(
+            window_visual.SHADOW_OFFSET_X + @as(i32, window_visual.SHADOW_BLUR),
+            @as(i32, window_visual.FOCUS_GLOW_SIZE),
+        );
+        var stack_i: u32 = self.window_stack.window_ids_len;
+        while (stack_i > 0) {
+            stack_i -= 1;
+            const above_id = self.window_stack.window_ids[stack_i];
+            if (above_id == win.id) return false;
+            const above = self.get_window_const(above_id) orelse continue;
+            if (!above.visible or above.minimized) continue;
+            const overlaps_x = @as(i64, above.x) - margin < @as(i64, win.x) + win.width and
+                @as(i64, win.x) < @as(i64, above.x) + above.width + margin;
+            const overlaps_y = @as(i64, above.y) - margin < @as(i64, win.y) + win.height and
+                @as(i64, win.y) < @as(i64, above.y) + above.height + margin;
+            if (overlaps_x and overlaps_y) return true;
         }
         return false;
     }
@@ -1031,13 +1489,17 @@ pub const Compositor = struct {
     // Raise window to top of stacking order.
     pub fn raise_window(self: *Compositor, window_id: u32) bool {
         std.debug.assert(window_id > 0);
-        return self.window_stack.raise_to_top(window_id);
+        const raised = self.window_stack.raise_to_top(window_id);
+        if (raised) self.index_stack_order();
+        return raised;
     }
 
     // Lower window to bottom of stacking order.
     pub fn lower_window(self: *Compositor, window_id: u32) bool {
         std.debug.assert(window_id > 0);
-        return self.window_stack.lower_to_bottom(window_id);
+        const lowered = self.window_stack.lower_to_bottom(window_id);
+        if (lowered) self.index_stack_order();
+        return lowered;
     }
 
     // Set window opacity.
@@ -1053,31 +1515,48 @@ pub const Compositor = struct {
     // Get window opacity.
     pub fn get_window_opacity(self: *const Compositor, window_id: u32) ?u8 {
         std.debug.assert(window_id > 0);
-        if (self.get_window(window_id)) |win| {
+        if (self.get_window_const(window_id)) |win| {
             return win.opacity;
         }
         return null;
     }
 
     // Update all active animations.
+    // Why: One vectorized pass over the animation table; each window takes
+    // only the channels its animation drives.
     pub fn update_animations(self: *Compositor, current_time: u64) void {
+        const step = self.animation_manager.advance(current_time);
         var i: u32 = 0;
-        while (i < self.animation_manager.animations_len) : (i += 1) {
-            const anim = &self.animation_manager.animations[i];
-            if (anim.active) {
-                if (self.animation_manager.update_animation(
-                    anim.window_id,
-                    current_time,
-                )) |values| {
-                    if (self.get_window(anim.window_id)) |win| {
-                        win.x = values.x;
-                        win.y = values.y;
-                        win.width = values.width;
-                        win.height = values.height;
-                        win.opacity = values.opacity;
-                    }
-                }
+        while (i < step.len) : (i += 1) {
+            const sample = self.animation_manager.sample(i);
+            const win = self.get_window(sample.window_id) orelse continue;
+            if (sample.channels & window_animation.CHANNEL_OPACITY != 0) {
+                win.opacity = sample.opacity;
             }
+            const geometry = window_animation.CHANNEL_POSITION | window_animation.CHANNEL_SIZE;
+            if (sample.channels & geometry == 0) continue;
+            if (sample.channels & window_animation.CHANNEL_POSITION != 0) {
+                win.x = sample.x;
+                win.y = sample.y;
+            }
+            if (sample.channels & window_animation.CHANNEL_SIZE != 0) {
+                win.width = @max(sample.width, 1);
+                win.height = @max(sample.height, 1);
+            }
+            self.index_window_geometry(win);
+        }
+        // Settled windows: repaint their final rect once.
+        for (step.completed) |window_id| {
+            const win = self.get_window_const(window_id) orelse continue;
+            const rect = fb_primitives.clip_rect(
+                self.output.width,
+                self.output.height,
+                win.x,
+                win.y,
+                win.width,
+                win.height,
+            ) orelse continue;
+            self.add_repaint_damage(rect);
         }
     }
 
@@ -1261,7 +1740,7 @@ pub const Compositor = struct {
         window_id: u32,
     ) ?window_constraints.WindowConstraints {
         std.debug.assert(window_id > 0);
-        if (self.get_window(window_id)) |win| {
+        if (self.get_window_const(window_id)) |win| {
             return win.constraints;
         }
         return null;
@@ -1321,13 +1800,15 @@ pub const Compositor = struct {
         return self.focus_manager.get_previous_focus();
     }
 
-    // Add window rule.
+    // Add window rule. Windows carry only a title (no class or instance),
+    // so other match types are rejected rather than stored and never hit.
     pub fn add_window_rule(
         self: *Compositor,
         match_type: window_rules.MatchType,
         pattern: []const u8,
         action_type: window_rules.ActionType,
     ) ?u32 {
+        if (match_type != .title) return null;
         return self.rule_manager.add_rule(match_type, pattern, action_type);
     }
 
@@ -1341,6 +1822,32 @@ pub const Compositor = struct {
         return self.rule_manager.get_rule_count();
     }
 
+    // Set window title and re-match window rules.
+    pub fn set_window_title(self: *Compositor, window_id: u32, title: []const u8) bool {
+        const win = self.get_window(window_id) orelse return false;
+        win.set_title(title);
+        self.match_window_rules(win);
+        return true;
+    }
+
+    // Rule matched by a window (cached; re-matched only if rules changed).
+    pub fn get_window_rule(self: *Compositor, window_id: u32) ?*const window_rules.WindowRule {
+        const win = self.get_window(window_id) orelse return null;
+        if (win.rule_generation != self.rule_manager.generation) {
+            self.match_window_rules(win);
+        }
+        if (win.rule_slot == NO_RULE) return null;
+        std.debug.assert(win.rule_slot < self.rule_manager.rules_len);
+        return &self.rule_manager.rules[win.rule_slot];
+    }
+
+    // Evaluate title rules for a window and cache the result.
+    fn match_window_rules(self: *Compositor, win: *Window) void {
+        const rules = &self.rule_manager;
+        win.rule_slot = rules.match_slot(.title, win.title[0..win.title_len]) orelse NO_RULE;
+        win.rule_generation = rules.generation;
+    }
+
     // Create window session.
     pub fn create_window_session(self: *Compositor, name: []const u8) ?u32 {
         if (self.session_manager.create_session(name)) |session_id| {
@@ -1385,6 +1892,7 @@ pub const Compositor = struct {
                     win.y = entry.y;
                     win.width = entry.width;
                     win.height = entry.height;
+                    self.index_window_geometry(win);
                     win.minimized = entry.minimized;
                     win.maximized = entry.maximized;
                     win.visible = !entry.minimized;
@@ -1398,11 +1906,12 @@ pub const Compositor = struct {
                         win.title[j] = entry.title[j];
                     }
                     win.title_len = entry.title_len;
-                    // Assign to workspace.
-                    _ = self.workspace_manager.assign_window_to_workspace(
-                        entry.window_id,
-                        entry.workspace_id,
-                    );
+                    // Assign to workspace (moves its tiling tree entry too).
+                    if (entry.workspace_id > 0 and
+                        self.assign_window_to_workspace(entry.window_id, entry.workspace_id))
+                    {
+                        win.visible = win.visible and !entry.minimized;
+                    }
                 }
             }
             self.recalculate_layout();
@@ -1429,6 +1938,16 @@ pub const Compositor = struct {
         return self.session_manager.get_session_count();
     }
 
+    // Serialize the desktop into a binary snapshot. Returns bytes written.
+    pub fn save_snapshot(self: *const Compositor, out: []u8) session_snapshot.SnapshotError!u32 {
+        return session_snapshot.encode(self, out);
+    }
+
+    // Rebuild the desktop from a snapshot (compositor must have no windows).
+    pub fn restore_snapshot(self: *Compositor, bytes: []const u8) session_snapshot.SnapshotError!void {
+        return session_snapshot.restore(self, bytes);
+    }
+
     // Lock screen.
     pub fn lock_compositor_screen(self: *Compositor) void {
         self.lock_screen_manager.lock();
@@ -1571,6 +2090,7 @@ pub const Compositor = struct {
                         win.x = std.math.clamp(win.x, min_x, max_x);
                         win.y = std.math.clamp(win.y, min_y, max_y);
                     }
+                    self.index_window_geometry(win);
                 }
             }
         }
@@ -1691,6 +2211,7 @@ pub const Compositor = struct {
         const max_height = self.output.height - (self.border_width * 2) - self.title_bar_height - desktop_shell.STATUS_BAR_HEIGHT;
         win.width = std.math.min(win.width, max_width);
         win.height = std.math.min(win.height, max_height);
+        self.index_window_geometry(win);
     }
 
     // End window drag.
@@ -59,7 +59,7 @@ pub const LauncherItem = struct {
 
 // Desktop shell: status bar and launcher.
 pub const DesktopShell = struct {
-    renderer: *const framebuffer_renderer.FramebufferRenderer,
+    renderer: *framebuffer_renderer.FramebufferRenderer,
     output_width: u32,
     output_height: u32,
     launcher_items: [MAX_LAUNCHER_ITEMS]LauncherItem,
@@ -70,7 +70,7 @@ pub const DesktopShell = struct {
     current_time_seconds: u64, // Current time in seconds since epoch
 
     pub fn init(
-        renderer: *const framebuffer_renderer.FramebufferRenderer,
+        renderer: *framebuffer_renderer.FramebufferRenderer,
         output_width: u32,
         output_height: u32,
     ) DesktopShell {
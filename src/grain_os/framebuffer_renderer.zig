@@ -1,11 +1,14 @@
 //! Grain OS Framebuffer Renderer: Render windows to kernel framebuffer.
 //!
 //! Why: Render compositor windows using kernel framebuffer syscalls.
-//! Architecture: Syscall-based rendering, window compositing.
+//! Architecture: Syscall-based rendering, window compositing. When a direct
+//! surface is attached (host side, headless), draws go straight to memory
+//! through the shared vectorized framebuffer primitives.
 //! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
 
 const std = @import("std");
 const basin_kernel = @import("basin_kernel");
+const fb_primitives = @import("framebuffer_primitives");
 
 // Bounded: Max text length for rendering.
 pub const MAX_TEXT_LEN: u32 = 256;
@@ -34,13 +37,93 @@ const SyscallFn = *const fn (u32, u64, u64, u64, u64) i64;
 pub const FramebufferRenderer = struct {
     // Syscall function pointer (set by kernel integration).
     syscall_fn: ?SyscallFn = null,
+    // Direct pixel surface (optional, preferred over syscalls when set).
+    surface: ?fb_primitives.Surface = null,
+    // Bounding rect of everything drawn since last take_damage.
+    damage: ?fb_primitives.Rect = null,
+    // Pixels written through the direct surface (overdraw counted).
+    pixels_written: u64 = 0,
+    // Direct-surface draws outside this rect are dropped (null = none).
+    clip: ?fb_primitives.Rect = null,
+
+    // Where direct-surface draws land: the clip window of the framebuffer
+    // as its own surface, and that window's framebuffer origin.
+    const Target = struct {
+        surface: fb_primitives.Surface,
+        x: i32,
+        y: i32,
+    };
 
     pub fn init() FramebufferRenderer {
         return FramebufferRenderer{
             .syscall_fn = null,
+            .surface = null,
+            .damage = null,
+            .pixels_written = 0,
+            .clip = null,
         };
     }
 
+    // Attach direct framebuffer memory (RGBA, FRAMEBUFFER_WIDTH x HEIGHT).
+    pub fn set_surface(self: *FramebufferRenderer, memory: []u8) void {
+        self.surface = fb_primitives.Surface.init(
+            memory,
+            FRAMEBUFFER_WIDTH,
+            FRAMEBUFFER_HEIGHT,
+        );
+        std.debug.assert(self.surface != null);
+    }
+
+    // Return and reset accumulated damage (per rect, not per pixel).
+    pub fn take_damage(self: *FramebufferRenderer) ?fb_primitives.Rect {
+        const result = self.damage;
+        self.damage = null;
+        return result;
+    }
+
+    // Restrict direct-surface drawing to rect (null = whole framebuffer).
+    // Why: A damage-only repaint redraws the scene through the clip, so
+    // pixels outside the damaged rect are never touched.
+    pub fn set_clip(self: *FramebufferRenderer, rect: ?fb_primitives.Rect) void {
+        if (rect) |r| {
+            std.debug.assert(r.width > 0 and r.height > 0);
+            std.debug.assert(r.x + r.width <= FRAMEBUFFER_WIDTH);
+            std.debug.assert(r.y + r.height <= FRAMEBUFFER_HEIGHT);
+        }
+        self.clip = rect;
+    }
+
+    fn target(self: *const FramebufferRenderer) ?Target {
+        const surface = self.surface orelse return null;
+        const clip = self.clip orelse return Target{ .surface = surface, .x = 0, .y = 0 };
+        const offset = @as(usize, clip.y) * surface.stride + @as(usize, clip.x) * fb_primitives.BYTES_PER_PIXEL;
+        return Target{
+            .surface = fb_primitives.Surface{
+                .memory = surface.memory[offset..],
+                .width = clip.width,
+                .height = clip.height,
+                .stride = surface.stride,
+            },
+            .x = @intCast(clip.x),
+            .y = @intCast(clip.y),
+        };
+    }
+
+    // Record damage for a rect written in target coordinates.
+    fn add_target_damage(self: *FramebufferRenderer, t: Target, rect: fb_primitives.Rect) void {
+        self.add_damage(fb_primitives.Rect{
+            .x = rect.x + @as(u32, @intCast(t.x)),
+            .y = rect.y + @as(u32, @intCast(t.y)),
+            .width = rect.width,
+            .height = rect.height,
+        });
+    }
+
+    fn add_damage(self: *FramebufferRenderer, rect: fb_primitives.Rect) void {
+        self.pixels_written += @as(u64, rect.width) * rect.height;
+        self.damage = if (self.damage) |acc| acc.union_with(rect) else rect;
+    }
+
     pub fn set_syscall_fn(self: *FramebufferRenderer, fn_ptr: SyscallFn) void {
         std.debug.assert(@intFromPtr(fn_ptr) != 0);
         self.syscall_fn = fn_ptr;
@@ -48,7 +131,11 @@ pub const FramebufferRenderer = struct {
     }
 
     // Clear framebuffer to background color.
-    pub fn clear(self: *const FramebufferRenderer, color: u32) void {
+    pub fn clear(self: *FramebufferRenderer, color: u32) void {
+        if (self.target()) |t| {
+            self.add_target_damage(t, fb_primitives.clear(t.surface, color));
+            return;
+        }
         std.debug.assert(self.syscall_fn != null);
         if (self.syscall_fn) |syscall| {
             const result = syscall(SYSCALL_FB_CLEAR, color, 0, 0, 0);
@@ -58,13 +145,25 @@ pub const FramebufferRenderer = struct {
 
     // Draw pixel at position.
     pub fn draw_pixel(
-        self: *const FramebufferRenderer,
+        self: *FramebufferRenderer,
         x: u32,
         y: u32,
         color: u32,
     ) void {
         std.debug.assert(x < FRAMEBUFFER_WIDTH);
         std.debug.assert(y < FRAMEBUFFER_HEIGHT);
+        if (self.target()) |t| {
+            const rect = fb_primitives.fill_rect(
+                t.surface,
+                @as(i32, @intCast(x)) - t.x,
+                @as(i32, @intCast(y)) - t.y,
+                1,
+                1,
+                color,
+            );
+            if (rect) |r| self.add_target_damage(t, r);
+            return;
+        }
         std.debug.assert(self.syscall_fn != null);
         if (self.syscall_fn) |syscall| {
             const result = syscall(SYSCALL_FB_DRAW_PIXEL, x, y, color, 0);
@@ -72,9 +171,9 @@ pub const FramebufferRenderer = struct {
         }
     }
 
-    // Draw filled rectangle.
+    // Draw filled rectangle (clipped to framebuffer).
     pub fn draw_rect(
-        self: *const FramebufferRenderer,
+        self: *FramebufferRenderer,
         x: i32,
         y: i32,
         width: u32,
@@ -83,45 +182,132 @@ pub const FramebufferRenderer = struct {
     ) void {
         std.debug.assert(width > 0);
         std.debug.assert(height > 0);
-        std.debug.assert(@as(u32, @intCast(x)) + width <= FRAMEBUFFER_WIDTH);
-        std.debug.assert(@as(u32, @intCast(y)) + height <= FRAMEBUFFER_HEIGHT);
-        const start_y = if (y < 0) 0 else @as(u32, @intCast(y));
-        const end_y = if (@as(u32, @intCast(y)) + height > FRAMEBUFFER_HEIGHT)
-            FRAMEBUFFER_HEIGHT
-        else
-            @as(u32, @intCast(y)) + height;
-        var py: u32 = start_y;
-        while (py < end_y) : (py += 1) {
-            const start_x = if (x < 0) 0 else @as(u32, @intCast(x));
-            const end_x = if (@as(u32, @intCast(x)) + width > FRAMEBUFFER_WIDTH)
-                FRAMEBUFFER_WIDTH
-            else
-                @as(u32, @intCast(x)) + width;
-            var px: u32 = start_x;
-            while (px < end_x) : (px += 1) {
+        if (self.target()) |t| {
+            // Row-wise vector fill, one damage rect per call.
+            const rect = fb_primitives.fill_rect(t.surface, x - t.x, y - t.y, width, height, color);
+            if (rect) |r| self.add_target_damage(t, r);
+            return;
+        }
+        const clipped = fb_primitives.clip_rect(
+            FRAMEBUFFER_WIDTH,
+            FRAMEBUFFER_HEIGHT,
+            x,
+            y,
+            width,
+            height,
+        ) orelse return;
+        var py: u32 = clipped.y;
+        while (py < clipped.y + clipped.height) : (py += 1) {
+            var px: u32 = clipped.x;
+            while (px < clipped.x + clipped.width) : (px += 1) {
                 self.draw_pixel(px, py, color);
             }
         }
     }
 
-    // Draw text string.
+    // Copy client pixels onto the framebuffer (direct surface only).
+    // swap_red_blue: source bytes are B,G,R,A (wl_shm argb8888/xrgb8888).
+    // force_opaque: source alpha is undefined (x* formats).
+    // Returns: false if no direct surface is attached.
+    pub fn blit_surface(
+        self: *FramebufferRenderer,
+        x: i32,
+        y: i32,
+        src: fb_primitives.Surface,
+        src_rect: fb_primitives.Rect,
+        swap_red_blue: bool,
+        force_opaque: bool,
+    ) bool {
+        const t = self.target() orelse return false;
+        const surface = t.surface;
+        const dst_x = x - t.x;
+        const dst_y = y - t.y;
+        if (!swap_red_blue and !force_opaque) {
+            // Same byte order: row memcpy straight from client memory.
+            const rect = fb_primitives.blit(surface, dst_x, dst_y, src, src_rect);
+            if (rect) |r| self.add_target_damage(t, r);
+            return true;
+        }
+        const rect = surface.clip(dst_x, dst_y, src_rect.width, src_rect.height) orelse return true;
+        const skip_x: u32 = @intCast(@as(i64, rect.x) - dst_x);
+        const skip_y: u32 = @intCast(@as(i64, rect.y) - dst_y);
+        const bpp = fb_primitives.BYTES_PER_PIXEL;
+        var row: u32 = 0;
+        while (row < rect.height) : (row += 1) {
+            const src_offset = @as(usize, src_rect.y + skip_y + row) * src.stride +
+                @as(usize, src_rect.x + skip_x) * bpp;
+            const dst_offset = @as(usize, rect.y + row) * surface.stride + @as(usize, rect.x) * bpp;
+            const src_row = src.memory[src_offset..][0 .. @as(usize, rect.width) * bpp];
+            const dst_row = surface.memory[dst_offset..][0 .. @as(usize, rect.width) * bpp];
+            var px: usize = 0;
+            while (px < src_row.len) : (px += bpp) {
+                const red = if (swap_red_blue) src_row[px + 2] else src_row[px];
+                const blue = if (swap_red_blue) src_row[px] else src_row[px + 2];
+                dst_row[px] = red;
+                dst_row[px + 1] = src_row[px + 1];
+                dst_row[px + 2] = blue;
+                dst_row[px + 3] = if (force_opaque) 0xFF else src_row[px + 3];
+            }
+        }
+        self.add_target_damage(t, rect);
+        return true;
+    }
+
+    // Draw text string (glyph cells filled with bg_color).
     pub fn draw_text(
-        self: *const FramebufferRenderer,
+        self: *FramebufferRenderer,
         text: []const u8,
         x: u32,
         y: u32,
         fg_color: u32,
+        bg_color: u32,
     ) void {
         std.debug.assert(text.len > 0);
         std.debug.assert(text.len <= MAX_TEXT_LEN);
         std.debug.assert(x < FRAMEBUFFER_WIDTH);
         std.debug.assert(y < FRAMEBUFFER_HEIGHT);
+        if (self.target()) |t| {
+            if (self.clip == null) {
+                const rect = fb_primitives.draw_text(t.surface, text, x, y, fg_color | 0xFF, bg_color);
+                if (rect) |r| self.add_damage(r);
+                return;
+            }
+            // Clipped: lay glyphs out on the whole framebuffer (same
+            // wrapping as draw_text), draw each through the clip window.
+            var char_x: u32 = x;
+            var char_y: u32 = y;
+            for (text) |ch| {
+                if (ch == 0) break;
+                if (ch == '\n') {
+                    char_x = x;
+                    char_y += fb_primitives.GLYPH_HEIGHT;
+                    continue;
+                }
+                if (char_x + fb_primitives.GLYPH_WIDTH > FRAMEBUFFER_WIDTH) {
+                    char_x = x;
+                    char_y += fb_primitives.GLYPH_HEIGHT;
+                }
+                if (char_y + fb_primitives.GLYPH_HEIGHT > FRAMEBUFFER_HEIGHT) break;
+                const rect = fb_primitives.draw_glyph(
+                    t.surface,
+                    fb_primitives.glyph_pattern(ch),
+                    @as(i32, @intCast(char_x)) - t.x,
+                    @as(i32, @intCast(char_y)) - t.y,
+                    fg_color | 0xFF,
+                    bg_color,
+                );
+                if (rect) |r| self.add_target_damage(t, r);
+                char_x += fb_primitives.GLYPH_WIDTH;
+            }
+            return;
+        }
         std.debug.assert(self.syscall_fn != null);
         // Note: In real implementation, text would be in VM memory.
         // For now, this is a placeholder that will be implemented
         // when we have VM memory access.
         // Parameters are validated in assertions above (text, x, y used in asserts).
         _ = fg_color;
+        _ = bg_color;
     }
 };
 
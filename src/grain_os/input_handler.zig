@@ -10,6 +10,9 @@ const basin_kernel = @import("basin_kernel");
 // Bounded: Max input event buffer size (32 bytes per event).
 pub const MAX_EVENT_SIZE: u32 = 32;
 
+// Bounded: Max events drained per read_events syscall.
+pub const MAX_BATCH_EVENTS: u32 = 64;
+
 // Syscall number (matching kernel/basin_kernel.zig).
 const SYSCALL_READ_INPUT_EVENT: u32 = 60;
 
@@ -91,16 +94,20 @@ pub const InputHandler = struct {
     syscall_fn: ?SyscallFn = null,
     // Event buffer for reading events.
     event_buf: [MAX_EVENT_SIZE]u8,
+    // Batch buffer for read_events (one syscall per batch).
+    batch_buf: [MAX_BATCH_EVENTS * MAX_EVENT_SIZE]u8,
 
     pub fn init() InputHandler {
         var handler = InputHandler{
             .syscall_fn = null,
             .event_buf = undefined,
+            .batch_buf = undefined,
         };
         var i: u32 = 0;
         while (i < MAX_EVENT_SIZE) : (i += 1) {
             handler.event_buf[i] = 0;
         }
+        @memset(&handler.batch_buf, 0);
         return handler;
     }
 
@@ -141,5 +148,73 @@ pub const InputHandler = struct {
         }
         return error.NoSyscallFn;
     }
+
+    // Read up to out.len pending events in one syscall (non-blocking).
+    // Why: One kernel round trip per batch instead of one per event.
+    // Returns: number of events written to out (0 if none pending).
+    pub fn read_events(self: *InputHandler, out: []InputEvent) !u32 {
+        std.debug.assert(self.syscall_fn != null);
+        std.debug.assert(out.len > 0);
+        const max_events: u32 = @intCast(@min(out.len, MAX_BATCH_EVENTS));
+        if (self.syscall_fn) |syscall| {
+            const result = syscall(
+                SYSCALL_READ_INPUT_EVENT,
+                @intFromPtr(&self.batch_buf),
+                max_events,
+                0,
+                0,
+            );
+            if (result < 0) {
+                if (result == -6) {
+                    return 0; // would_block (no event available).
+                }
+                return error.SyscallError;
+            }
+            const bytes: u64 = @intCast(result);
+            std.debug.assert(bytes % MAX_EVENT_SIZE == 0);
+            const count: u32 = @intCast(@min(bytes / MAX_EVENT_SIZE, max_events));
+            var i: u32 = 0;
+            while (i < count) : (i += 1) {
+                const offset = i * MAX_EVENT_SIZE;
+                out[i] = try InputEvent.parse_from_buffer(
+                    self.batch_buf[offset .. offset + MAX_EVENT_SIZE],
+                );
+            }
+            return count;
+        }
+        return error.NoSyscallFn;
+    }
 };
 
+// Is this a pointer-motion event (move or drag)?
+pub fn is_motion(event: *const InputEvent) bool {
+    return event.event_type == .mouse and
+        (event.mouse.kind == .move or event.mouse.kind == .drag);
+}
+
+// Collapse runs of consecutive motion events into the latest position.
+// Why: Drag/resize/focus work depends only on the final cursor position;
+// button and key transitions break runs, so their order is preserved.
+// Returns: new event count (events compacted in place).
+pub fn coalesce_motion(events: []InputEvent) u32 {
+    var write: u32 = 0;
+    var read: u32 = 0;
+    while (read < events.len) : (read += 1) {
+        const event = events[read];
+        if (write > 0 and is_motion(&event) and is_motion(&events[write - 1])) {
+            const prev = &events[write - 1];
+            if (prev.mouse.kind == event.mouse.kind and
+                prev.mouse.button == event.mouse.button and
+                prev.mouse.modifiers == event.mouse.modifiers)
+            {
+                prev.mouse.x = event.mouse.x;
+                prev.mouse.y = event.mouse.y;
+                continue;
+            }
+        }
+        events[write] = event;
+        write += 1;
+    }
+    std.debug.assert(write <= events.len);
+    return write;
+}
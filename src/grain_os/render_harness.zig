@@ -0,0 +1,447 @@
+//! Grain OS Render Harness: headless scripted compositor scenarios.
+//!
+//! Why: Render paths could only be judged by eye on macOS; scripted
+//! scenarios that report per-frame time, pixels touched, syscalls and an
+//! output hash make speed and output regressions visible in one run.
+//! Architecture: The compositor renders into caller memory through the
+//! renderer's direct surface (e.g. the null platform backend's RGBA
+//! buffer). A counting syscall stub stands in for the kernel and replays
+//! scripted input, so drags go through process_input like real events.
+//! The client_commit scenario runs a Wayland server with a loopback
+//! client that commits damaged rows every frame, presented damage-only.
+//! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
+
+const std = @import("std");
+const compositor_mod = @import("compositor.zig");
+const framebuffer_renderer = @import("framebuffer_renderer.zig");
+const input_handler = @import("input_handler.zig");
+const layout_generator = @import("layout_generator.zig");
+const wayland_server = @import("wayland/server.zig");
+const wayland_wire = @import("wayland/wire.zig");
+
+const Compositor = compositor_mod.Compositor;
+
+// Bounded: Max scripted input events queued per frame.
+pub const MAX_SCRIPTED_EVENTS: u32 = 64;
+
+// Bounded: Windows a storm grows to before they all close at once.
+// Why: The tiling tree reclaims node slots only when it empties.
+pub const STORM_MAX_WINDOWS: u32 = 48;
+
+// Loopback client surface (xbgr8888) and the rows it redraws per frame.
+pub const CLIENT_WIDTH: u32 = 256;
+pub const CLIENT_HEIGHT: u32 = 128;
+pub const CLIENT_STRIP_ROWS: u32 = 8;
+const CLIENT_POOL_BYTES: u32 = CLIENT_WIDTH * CLIENT_HEIGHT * 4;
+
+// Bounded: Loopback request bytes queued per frame.
+const CLIENT_QUEUE_BYTES: u32 = 1024;
+
+// Loopback client object ids.
+const CLIENT_REGISTRY: u32 = 2;
+const CLIENT_COMPOSITOR: u32 = 3;
+const CLIENT_SHM: u32 = 4;
+const CLIENT_POOL: u32 = 5;
+const CLIENT_BUFFER: u32 = 6;
+const CLIENT_SURFACE: u32 = 7;
+
+// Simulated frame interval (milliseconds, ~60 Hz).
+pub const FRAME_INTERVAL_MS: u64 = 16;
+
+// Framebuffer bytes the harness renders into.
+pub const FRAME_BYTES: u32 = framebuffer_renderer.FRAMEBUFFER_WIDTH *
+    framebuffer_renderer.FRAMEBUFFER_HEIGHT * 4;
+
+// Syscall numbers (matching kernel/basin_kernel.zig).
+const SYSCALL_READ_INPUT_EVENT: u32 = 60;
+const ERROR_WOULD_BLOCK: i64 = -6;
+
+// Scripted scenarios.
+pub const Scenario = enum(u8) {
+    window_storm, // Bursts of new windows, then all closed at once.
+    drag, // Title-bar drag through process_input.
+    animation, // Move animations driven by the frame clock.
+    tiling, // Layout cycled every frame.
+    workspace_flip, // Workspaces switched every frame.
+    client_commit, // Wayland client redraws a strip; damage-only present.
+};
+
+// Per-frame measurements.
+pub const FrameStats = struct {
+    render_ns: u64, // process_input + render (present for client_commit)
+    pixels_touched: u64, // Pixels written, overdraw counted
+    syscalls: u32, // Syscalls issued during the frame
+    hash: u64, // Hash of the whole framebuffer after the frame
+};
+
+// Scenario totals.
+pub const ScenarioReport = struct {
+    scenario: Scenario,
+    frames: u32,
+    total_ns: u64,
+    max_ns: u64,
+    pixels_touched: u64,
+    syscalls: u64,
+    hash: u64, // Hash over every frame hash, in order
+};
+
+// Harness whose syscall stub is live (the stub has no context argument).
+var active_harness: ?*Harness = null;
+
+// Wayland server plus a headless client writing requests into a queue.
+// Events to the client are dropped (the script never waits on them).
+const ClientLoopback = struct {
+    server: wayland_server.Server,
+    mapper: wayland_server.ArenaShmMapper,
+    arena: [CLIENT_POOL_BYTES]u8,
+    requests: [CLIENT_QUEUE_BYTES]u8,
+    requests_len: u32,
+    scratch: [wayland_wire.MAX_MESSAGE_SIZE]u8,
+    client_index: u32,
+
+    fn transport(self: *ClientLoopback) wayland_server.Transport {
+        return .{ .context = self, .send_fn = server_send, .recv_fn = server_recv };
+    }
+
+    fn server_send(context: *anyopaque, bytes: []const u8) bool {
+        _ = context;
+        _ = bytes;
+        return true;
+    }
+
+    fn server_recv(context: *anyopaque, buf: []u8) u32 {
+        const self: *ClientLoopback = @ptrCast(@alignCast(context));
+        const n: u32 = @intCast(@min(buf.len, self.requests_len));
+        @memcpy(buf[0..n], self.requests[0..n]);
+        std.mem.copyForwards(u8, self.requests[0 .. self.requests_len - n], self.requests[n..self.requests_len]);
+        self.requests_len -= n;
+        return n;
+    }
+
+    fn push(self: *ClientLoopback, msg: *wayland_wire.MessageWriter) void {
+        const bytes = msg.finish() catch unreachable;
+        std.debug.assert(self.requests_len + bytes.len <= CLIENT_QUEUE_BYTES);
+        @memcpy(self.requests[self.requests_len..][0..bytes.len], bytes);
+        self.requests_len += @intCast(bytes.len);
+    }
+
+    fn request(self: *ClientLoopback, object_id: u32, opcode: u16, args: []const u32) void {
+        var msg = wayland_wire.MessageWriter.begin(&self.scratch, object_id, opcode);
+        for (args) |arg| msg.put_uint(arg);
+        self.push(&msg);
+    }
+
+    fn bind(self: *ClientLoopback, name: u32, interface: []const u8, version: u32, id: u32) void {
+        var msg = wayland_wire.MessageWriter.begin(&self.scratch, CLIENT_REGISTRY, 0);
+        msg.put_uint(name);
+        msg.put_string(interface);
+        msg.put_uint(version);
+        msg.put_uint(id);
+        self.push(&msg);
+    }
+
+    // Connect, create pool, buffer and surface, and commit the first frame.
+    fn start(self: *ClientLoopback, comp: *Compositor) void {
+        @memset(&self.arena, 0x40);
+        self.mapper = .{ .arena = &self.arena };
+        self.requests_len = 0;
+        self.server.init(self.mapper.mapper());
+        self.server.set_sink(comp.wayland_sink());
+        self.client_index = self.server.connect(self.transport()).?;
+        const handle = self.mapper.grant(0, CLIENT_POOL_BYTES).?;
+        self.request(wayland_server.DISPLAY_ID, 1, &.{CLIENT_REGISTRY});
+        self.bind(wayland_server.GLOBAL_COMPOSITOR, "wl_compositor", 4, CLIENT_COMPOSITOR);
+        self.bind(wayland_server.GLOBAL_SHM, "wl_shm", 1, CLIENT_SHM);
+        self.request(CLIENT_SHM, 0, &.{ CLIENT_POOL, handle, CLIENT_POOL_BYTES });
+        self.request(CLIENT_POOL, 0, &.{
+            CLIENT_BUFFER,
+            0,
+            CLIENT_WIDTH,
+            CLIENT_HEIGHT,
+            CLIENT_WIDTH * 4,
+            wayland_server.ShmFormat.xbgr8888,
+        });
+        self.request(CLIENT_COMPOSITOR, 0, &.{CLIENT_SURFACE});
+        self.request(CLIENT_SURFACE, 1, &.{ CLIENT_BUFFER, 0, 0 });
+        self.request(CLIENT_SURFACE, 6, &.{});
+        self.server.dispatch(self.client_index);
+        std.debug.assert(self.server.is_connected(self.client_index));
+    }
+
+    // Redraw one strip of rows and commit it as the only damage.
+    fn draw_strip(self: *ClientLoopback, frame: u32) void {
+        const strips = CLIENT_HEIGHT / CLIENT_STRIP_ROWS;
+        const top = (frame % strips) * CLIENT_STRIP_ROWS;
+        const row_bytes = CLIENT_WIDTH * 4;
+        const shade: u8 = @truncate(frame *% 37);
+        @memset(self.arena[top * row_bytes ..][0 .. CLIENT_STRIP_ROWS * row_bytes], shade);
+        self.request(CLIENT_SURFACE, 2, &.{ 0, top, CLIENT_WIDTH, CLIENT_STRIP_ROWS });
+        self.request(CLIENT_SURFACE, 6, &.{});
+        self.server.dispatch(self.client_index);
+    }
+};
+
+pub const Harness = struct {
+    comp: *Compositor,
+    allocator: std.mem.Allocator,
+    memory: []u8,
+    events: [MAX_SCRIPTED_EVENTS][input_handler.MAX_EVENT_SIZE]u8,
+    events_len: u32,
+    events_read: u32,
+    frame_syscalls: u32,
+    // Scenario bookkeeping.
+    oldest_window_id: u32,
+    drag_window_id: u32,
+    drag_x: u32,
+    drag_y: u32,
+    client: ?*ClientLoopback, // client_commit only
+
+    // Initialize in place: registers the syscall stub for this harness.
+    // comp: storage for the compositor (reset before every scenario).
+    // memory: FRAME_BYTES of RGBA framebuffer (e.g. NullWindow.getBuffer()).
+    pub fn init(
+        self: *Harness,
+        comp: *Compositor,
+        allocator: std.mem.Allocator,
+        memory: []u8,
+    ) void {
+        std.debug.assert(memory.len == FRAME_BYTES);
+        std.debug.assert(active_harness == null);
+        self.* = Harness{
+            .comp = comp,
+            .allocator = allocator,
+            .memory = memory,
+            .events = undefined,
+            .events_len = 0,
+            .events_read = 0,
+            .frame_syscalls = 0,
+            .oldest_window_id = 0,
+            .drag_window_id = 0,
+            .drag_x = 0,
+            .drag_y = 0,
+            .client = null,
+        };
+        active_harness = self;
+    }
+
+    pub fn deinit(self: *Harness) void {
+        std.debug.assert(active_harness == self);
+        self.stop_client();
+        active_harness = null;
+    }
+
+    fn stop_client(self: *Harness) void {
+        if (self.client) |client| self.allocator.destroy(client);
+        self.client = null;
+    }
+
+    // Run one scenario from a fresh compositor.
+    // frames_out: one entry per frame to render (filled in order).
+    pub fn run(self: *Harness, scenario: Scenario, frames_out: []FrameStats) !ScenarioReport {
+        std.debug.assert(frames_out.len > 0);
+        try self.reset(scenario);
+        var report = ScenarioReport{
+            .scenario = scenario,
+            .frames = @intCast(frames_out.len),
+            .total_ns = 0,
+            .max_ns = 0,
+            .pixels_touched = 0,
+            .syscalls = 0,
+            .hash = 0,
+        };
+        var hasher = std.hash.Wyhash.init(@intFromEnum(scenario));
+        var frame: u32 = 0;
+        while (frame < frames_out.len) : (frame += 1) {
+            try self.step(scenario, frame);
+            const stats = try self.render_frame();
+            frames_out[frame] = stats;
+            report.total_ns += stats.render_ns;
+            report.max_ns = @max(report.max_ns, stats.render_ns);
+            report.pixels_touched += stats.pixels_touched;
+            report.syscalls += stats.syscalls;
+            hasher.update(std.mem.asBytes(&stats.hash));
+        }
+        report.hash = hasher.final();
+        return report;
+    }
+
+    // Fresh compositor, cleared framebuffer, scenario setup.
+    fn reset(self: *Harness, scenario: Scenario) !void {
+        const comp = self.comp;
+        self.stop_client();
+        comp.init_in_place(self.allocator);
+        comp.renderer.set_surface(self.memory);
+        comp.set_syscall_fn(harness_syscall);
+        @memset(self.memory, 0);
+        self.events_len = 0;
+        self.events_read = 0;
+        switch (scenario) {
+            .window_storm => {
+                self.oldest_window_id = 0;
+            },
+            .drag => {
+                _ = try comp.create_window(400, 300);
+                self.drag_window_id = try comp.create_window(400, 300);
+            },
+            .animation, .tiling => {
+                var i: u32 = 0;
+                while (i < 8) : (i += 1) {
+                    _ = try comp.create_window(320, 240);
+                }
+            },
+            .workspace_flip => {
+                var ws: u32 = 1;
+                while (ws <= 3) : (ws += 1) {
+                    if (ws > 1) {
+                        const id = comp.create_workspace("flip") orelse return error.OutOfWorkspaces;
+                        std.debug.assert(id == ws);
+                        _ = comp.switch_workspace(id);
+                    }
+                    var i: u32 = 0;
+                    while (i < ws + 2) : (i += 1) {
+                        _ = try comp.create_window(320, 240);
+                    }
+                }
+            },
+            .client_commit => {
+                const client = try self.allocator.create(ClientLoopback);
+                self.client = client;
+                client.start(comp);
+            },
+        }
+        // Setup damage is not charged to the first frame.
+        _ = comp.take_repaint_damage();
+        _ = comp.renderer.take_damage();
+    }
+
+    // Apply the scenario's script for one frame.
+    fn step(self: *Harness, scenario: Scenario, frame: u32) !void {
+        const comp = self.comp;
+        comp.set_frame_time(@as(u64, frame) * FRAME_INTERVAL_MS);
+        switch (scenario) {
+            .window_storm => {
+                // Four windows in per frame; at the cap, close all (oldest first).
+                if (comp.windows_len >= STORM_MAX_WINDOWS) {
+                    while (comp.windows_len > 0) {
+                        const removed = comp.remove_window(self.oldest_window_id);
+                        std.debug.assert(removed);
+                        self.oldest_window_id += 1;
+                    }
+                    self.oldest_window_id = 0;
+                    return;
+                }
+                var i: u32 = 0;
+                while (i < 4) : (i += 1) {
+                    const id = try comp.create_window(200 + (frame % 5) * 20, 150);
+                    if (self.oldest_window_id == 0) self.oldest_window_id = id;
+                }
+            },
+            .drag => {
+                const win = comp.get_window(self.drag_window_id) orelse return;
+                if (frame == 0) {
+                    // Grab the title bar left of the buttons, below the resize edge.
+                    self.drag_x = @as(u32, @intCast(win.x)) + win.width / 4;
+                    self.drag_y = @as(u32, @intCast(win.y)) + compositor_mod.RESIZE_HANDLE_SIZE +
+                        compositor_mod.BORDER_WIDTH;
+                    self.queue_mouse(.down, self.drag_x, self.drag_y);
+                    return;
+                }
+                // Three motion events per frame (left and down, staying on
+                // screen); process_input coalesces them.
+                var i: u32 = 0;
+                while (i < 3) : (i += 1) {
+                    const x = self.drag_x - ((frame * 3 + i) % 97);
+                    const y = self.drag_y + ((frame * 3 + i) % 61);
+                    self.queue_mouse(.move, x, y);
+                }
+            },
+            .animation => {
+                // Restart a wave of moves every 16 frames (past the duration).
+                if (frame % 16 == 0) {
+                    var i: u32 = 0;
+                    while (i < comp.windows_len) : (i += 1) {
+                        const win = &comp.windows[i];
+                        const target_x: i32 = @intCast((i * 97 + frame * 13) % 600);
+                        const target_y: i32 = @intCast((i * 53 + frame * 7) % 400);
+                        _ = comp.animate_move(win.id, target_x, target_y, comp.frame_time);
+                    }
+                }
+            },
+            .tiling => {
+                const layouts = [_]layout_generator.LayoutType{ .tall, .wide, .grid, .monocle };
+                _ = comp.set_layout(layouts[frame % layouts.len]);
+            },
+            .workspace_flip => {
+                _ = comp.switch_workspace((frame % 3) + 1);
+            },
+            .client_commit => self.client.?.draw_strip(frame),
+        }
+    }
+
+    // Measure one frame: input batch plus render (full, or damage-only
+    // present when a Wayland client is driving the frame).
+    fn render_frame(self: *Harness) !FrameStats {
+        const comp = self.comp;
+        self.frame_syscalls = 0;
+        const pixels_before = comp.renderer.pixels_written;
+        const start = std.time.nanoTimestamp();
+        try comp.process_input();
+        if (self.client) |client| {
+            _ = comp.present();
+            client.server.send_frame_done(@truncate(comp.frame_time));
+        } else {
+            comp.render_to_framebuffer();
+        }
+        const elapsed = std.time.nanoTimestamp() - start;
+        _ = comp.take_repaint_damage();
+        _ = comp.renderer.take_damage();
+        self.events_len = 0;
+        self.events_read = 0;
+        return FrameStats{
+            .render_ns = @intCast(@max(elapsed, 0)),
+            .pixels_touched = comp.renderer.pixels_written - pixels_before,
+            .syscalls = self.frame_syscalls,
+            .hash = std.hash.Wyhash.hash(0, self.memory),
+        };
+    }
+
+    // Queue a mouse event in the kernel wire format (see InputEvent.parse_from_buffer).
+    fn queue_mouse(self: *Harness, kind: input_handler.MouseEventKind, x: u32, y: u32) void {
+        std.debug.assert(self.events_len < MAX_SCRIPTED_EVENTS);
+        const buf = &self.events[self.events_len];
+        @memset(buf, 0);
+        buf[0] = 0; // Mouse.
+        buf[4] = @intFromEnum(kind);
+        buf[5] = 1; // Left button.
+        std.mem.writeInt(u32, buf[6..10], @min(x, framebuffer_renderer.FRAMEBUFFER_WIDTH - 1), .little);
+        std.mem.writeInt(u32, buf[10..14], @min(y, framebuffer_renderer.FRAMEBUFFER_HEIGHT - 1), .little);
+        self.events_len += 1;
+    }
+
+    // Copy pending scripted events into the caller's batch buffer.
+    fn replay_input(self: *Harness, buf_addr: u64, max_events: u64) i64 {
+        const pending = self.events_len - self.events_read;
+        if (pending == 0) return ERROR_WOULD_BLOCK;
+        const count: u32 = @intCast(@min(pending, max_events));
+        const size = input_handler.MAX_EVENT_SIZE;
+        const out: [*]u8 = @ptrFromInt(buf_addr);
+        var i: u32 = 0;
+        while (i < count) : (i += 1) {
+            @memcpy(out[i * size ..][0..size], &self.events[self.events_read + i]);
+        }
+        self.events_read += count;
+        return @intCast(count * size);
+    }
+};
+
+// Kernel stand-in: counts every call, serves scripted input.
+fn harness_syscall(number: u32, arg1: u64, arg2: u64, arg3: u64, arg4: u64) i64 {
+    _ = arg3;
+    _ = arg4;
+    const harness = active_harness orelse return -1;
+    harness.frame_syscalls += 1;
+    if (number == SYSCALL_READ_INPUT_EVENT) {
+        return harness.replay_input(arg1, arg2);
+    }
+    return 0;
+}
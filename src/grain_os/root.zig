@@ -5,6 +5,8 @@
 //! GrainStyle: grain_case, u32/u64, max 70 lines, max 100 chars, all warnings.
 
 pub const wayland = @import("wayland/protocol.zig");
+pub const wayland_wire = @import("wayland/wire.zig");
+pub const wayland_server = @import("wayland/server.zig");
 pub const compositor = @import("compositor.zig");
 pub const tiling = @import("tiling.zig");
 pub const layout = @import("layout.zig");
@@ -23,6 +25,8 @@ pub const window_state = @import("window_state.zig");
 pub const window_preview = @import("window_preview.zig");
 pub const window_visual = @import("window_visual.zig");
 pub const window_stacking = @import("window_stacking.zig");
+pub const bounded_map = @import("bounded_map.zig");
+pub const window_index = @import("window_index.zig");
 pub const window_opacity = @import("window_opacity.zig");
 pub const window_animation = @import("window_animation.zig");
 pub const window_decorations = @import("window_decorations.zig");
@@ -35,5 +39,7 @@ pub const tiling_config = @import("tiling_config.zig");
 pub const window_rules = @import("window_rules.zig");
 pub const window_events = @import("window_events.zig");
 pub const window_session = @import("window_session.zig");
+pub const session_snapshot = @import("session_snapshot.zig");
+pub const render_harness = @import("render_harness.zig");
 pub const lock_screen = @import("lock_screen.zig");
 
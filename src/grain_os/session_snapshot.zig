@@ -0,0 +1,689 @@
+//! Grain OS Session Snapshot: Versioned binary desktop snapshots.
+//!
+//! Why: Rebuilding the desktop window by window at startup runs one layout
+//! pass per window. A snapshot captures windows, geometry, workspaces,
+//! tiling trees, rules, and stacking so restore is one bulk pass, one
+//! relayout, and one full-screen repaint.
+//! Architecture: Fixed 32-byte header (magic, version, counts, CRC32 of the
+//! body) followed by little-endian sections in a fixed order. Records are
+//! 4-byte aligned. Snapshots live in Basin storage via open/read/write.
+//! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
+
+const std = @import("std");
+const basin_kernel = @import("basin_kernel");
+const compositor_mod = @import("compositor.zig");
+const tiling = @import("tiling.zig");
+const workspace = @import("workspace.zig");
+const window_rules = @import("window_rules.zig");
+const layout_generator = @import("layout_generator.zig");
+const fb_primitives = @import("framebuffer_primitives");
+
+const Compositor = compositor_mod.Compositor;
+const Window = compositor_mod.Window;
+
+// Snapshot magic ("GSNP") and current format version.
+pub const SNAPSHOT_MAGIC: u32 = 0x504E5347;
+pub const SNAPSHOT_VERSION: u16 = 2;
+pub const HEADER_SIZE: u32 = 32;
+
+// Bounded: Max snapshot size (256 windows with full titles, 10 full trees,
+// a full rule set).
+pub const MAX_SNAPSHOT_SIZE: u32 = 512 * 1024;
+
+// Bounded: Max storage path length.
+pub const MAX_PATH_LEN: u32 = 256;
+
+// Window record flags.
+const FLAG_VISIBLE: u8 = 1 << 0;
+const FLAG_MINIMIZED: u8 = 1 << 1;
+const FLAG_MAXIMIZED: u8 = 1 << 2;
+const FLAG_FOCUSED: u8 = 1 << 3;
+
+pub const SnapshotError = error{
+    BufferTooSmall,
+    BadMagic,
+    UnsupportedVersion,
+    Corrupt,
+    NotEmpty,
+    StorageFailed,
+};
+
+// Header (little-endian, HEADER_SIZE bytes).
+pub const Header = struct {
+    version: u16,
+    body_len: u32,
+    body_crc: u32,
+    window_count: u16,
+    stack_len: u16,
+    workspace_count: u8,
+    current_workspace: u8,
+    layout: u8,
+    rule_count: u16,
+};
+
+// Append-only encoder into a caller buffer.
+const Encoder = struct {
+    buf: []u8,
+    len: u32,
+    overflow: bool,
+
+    fn reserve(self: *Encoder, bytes: u32) ?[]u8 {
+        if (self.overflow or self.len + bytes > self.buf.len) {
+            self.overflow = true;
+            return null;
+        }
+        const out = self.buf[self.len..][0..bytes];
+        self.len += bytes;
+        return out;
+    }
+
+    fn put_u8(self: *Encoder, value: u8) void {
+        const out = self.reserve(1) orelse return;
+        out[0] = value;
+    }
+
+    fn put_u16(self: *Encoder, value: u16) void {
+        const out = self.reserve(2) orelse return;
+        std.mem.writeInt(u16, out[0..2], value, .little);
+    }
+
+    fn put_u32(self: *Encoder, value: u32) void {
+        const out = self.reserve(4) orelse return;
+        std.mem.writeInt(u32, out[0..4], value, .little);
+    }
+
+    fn put_i32(self: *Encoder, value: i32) void {
+        self.put_u32(@bitCast(value));
+    }
+
+    fn put_u64(self: *Encoder, value: u64) void {
+        const out = self.reserve(8) orelse return;
+        std.mem.writeInt(u64, out[0..8], value, .little);
+    }
+
+    // Bytes padded with zeros to 4-byte alignment.
+    fn put_bytes(self: *Encoder, bytes: []const u8) void {
+        const padded = pad4(@intCast(bytes.len));
+        const out = self.reserve(padded) orelse return;
+        @memcpy(out[0..bytes.len], bytes);
+        @memset(out[bytes.len..], 0);
+    }
+};
+
+// Bounds-checked decoder.
+const Decoder = struct {
+    buf: []const u8,
+    pos: u32,
+
+    fn take(self: *Decoder, bytes: u32) SnapshotError![]const u8 {
+        if (self.pos + bytes > self.buf.len) return error.Corrupt;
+        const out = self.buf[self.pos..][0..bytes];
+        self.pos += bytes;
+        return out;
+    }
+
+    fn u8_(self: *Decoder) SnapshotError!u8 {
+        return (try self.take(1))[0];
+    }
+
+    fn u16_(self: *Decoder) SnapshotError!u16 {
+        return std.mem.readInt(u16, (try self.take(2))[0..2], .little);
+    }
+
+    fn u32_(self: *Decoder) SnapshotError!u32 {
+        return std.mem.readInt(u32, (try self.take(4))[0..4], .little);
+    }
+
+    fn i32_(self: *Decoder) SnapshotError!i32 {
+        return @bitCast(try self.u32_());
+    }
+
+    fn u64_(self: *Decoder) SnapshotError!u64 {
+        return std.mem.readInt(u64, (try self.take(8))[0..8], .little);
+    }
+
+    fn padded_bytes(self: *Decoder, len: u32) SnapshotError![]const u8 {
+        const out = try self.take(pad4(len));
+        return out[0..len];
+    }
+};
+
+// Map a stored tag back to an enum (unknown tags are corruption).
+fn decode_enum(comptime E: type, value: u8) SnapshotError!E {
+    inline for (@typeInfo(E).@"enum".fields) |field| {
+        if (field.value == value) return @enumFromInt(field.value);
+    }
+    return error.Corrupt;
+}
+
+fn pad4(len: u32) u32 {
+    return (len + 3) & ~@as(u32, 3);
+}
+
+// Serialize compositor state into out. Returns bytes written.
+pub fn encode(comp: *const Compositor, out: []u8) SnapshotError!u32 {
+    if (out.len < HEADER_SIZE) return error.BufferTooSmall;
+    const manager = &comp.workspace_manager;
+    var enc = Encoder{ .buf = out, .len = HEADER_SIZE, .overflow = false };
+
+    // Windows.
+    var i: u32 = 0;
+    while (i < comp.windows_len) : (i += 1) {
+        const win = &comp.windows[i];
+        var flags: u8 = 0;
+        if (win.visible) flags |= FLAG_VISIBLE;
+        if (win.minimized) flags |= FLAG_MINIMIZED;
+        if (win.maximized) flags |= FLAG_MAXIMIZED;
+        if (win.focused) flags |= FLAG_FOCUSED;
+        enc.put_u32(win.id);
+        enc.put_i32(win.x);
+        enc.put_i32(win.y);
+        enc.put_u32(win.width);
+        enc.put_u32(win.height);
+        enc.put_u8(flags);
+        enc.put_u8(win.opacity);
+        enc.put_u16(@intCast(win.title_len));
+        enc.put_bytes(win.title[0..win.title_len]);
+    }
+
+    // Stacking (bottom to top).
+    const stack = comp.window_stack.window_ids[0..comp.window_stack.window_ids_len];
+    for (stack) |window_id| enc.put_u32(window_id);
+
+    // Workspaces and their window lists.
+    i = 0;
+    while (i < manager.workspaces_len) : (i += 1) {
+        const ws = &manager.workspaces[i];
+        std.debug.assert(ws.id == i + 1);
+        enc.put_u32(ws.focused_window_id);
+        enc.put_u16(@intCast(ws.window_ids_len));
+        enc.put_u8(@intCast(ws.name_len));
+        enc.put_u8(0);
+        enc.put_bytes(ws.name[0..ws.name_len]);
+        for (ws.window_ids[0..ws.window_ids_len]) |window_id| enc.put_u32(window_id);
+    }
+
+    // Tiling trees (computed geometry included), one per workspace.
+    i = 0;
+    while (i < manager.workspaces_len) : (i += 1) {
+        const tree = if (i + 1 == manager.current_workspace_id)
+            &comp.tiling_tree
+        else
+            &comp.workspace_trees[i];
+        encode_tree(&enc, tree);
+    }
+
+    // Window rules.
+    const rules = &comp.rule_manager;
+    i = 0;
+    while (i < rules.rules_len) : (i += 1) {
+        const rule = &rules.rules[i];
+        enc.put_u32(rule.rule_id);
+        enc.put_u8(@intFromEnum(rule.match_type));
+        enc.put_u8(@intFromEnum(rule.action_type));
+        enc.put_u8(rule.action_value_u8);
+        enc.put_u8(@intFromBool(rule.active));
+        enc.put_i32(rule.action_value_x);
+        enc.put_i32(rule.action_value_y);
+        enc.put_u32(rule.action_value_width);
+        enc.put_u32(rule.action_value_height);
+        enc.put_u32(rule.action_value_u32);
+        enc.put_u32(rule.pattern_len);
+        enc.put_bytes(rules.pattern_of(rule));
+    }
+
+    if (enc.overflow) return error.BufferTooSmall;
+    const body = out[HEADER_SIZE..enc.len];
+    write_header(out[0..HEADER_SIZE], Header{
+        .version = SNAPSHOT_VERSION,
+        .body_len = @intCast(body.len),
+        .body_crc = std.hash.Crc32.hash(body),
+        .window_count = @intCast(comp.windows_len),
+        .stack_len = @intCast(stack.len),
+        .workspace_count = @intCast(manager.workspaces_len),
+        .current_workspace = @intCast(manager.current_workspace_id),
+        .layout = @intFromEnum(comp.layout_registry.current_layout),
+        .rule_count = @intCast(rules.rules_len),
+    });
+    return enc.len;
+}
+
+fn encode_tree(enc: *Encoder, tree: *const tiling.TilingTree) void {
+    enc.put_u16(@intCast(tree.nodes_len));
+    enc.put_u16(@intCast(tree.root_index));
+    enc.put_u16(@intCast(tree.next_node_index));
+    enc.put_u16(0);
+    for (tree.nodes[0..tree.nodes_len]) |node| {
+        enc.put_u8(if (node.node_type == .split) 0 else 1);
+        enc.put_u8(@intFromEnum(node.split_dir));
+        enc.put_u16(0);
+        enc.put_u64(@bitCast(node.split_ratio));
+        enc.put_u32(node.window_id);
+        enc.put_u16(@intCast(node.left_child));
+        enc.put_u16(@intCast(node.right_child));
+        enc.put_u16(@intCast(node.parent));
+        enc.put_u16(0);
+        enc.put_i32(node.x);
+        enc.put_i32(node.y);
+        enc.put_u32(node.width);
+        enc.put_u32(node.height);
+    }
+}
+
+fn write_header(out: []u8, header: Header) void {
+    std.debug.assert(out.len == HEADER_SIZE);
+    @memset(out, 0);
+    std.mem.writeInt(u32, out[0..4], SNAPSHOT_MAGIC, .little);
+    std.mem.writeInt(u16, out[4..6], header.version, .little);
+    std.mem.writeInt(u16, out[6..8], @intCast(HEADER_SIZE), .little);
+    std.mem.writeInt(u32, out[8..12], header.body_len, .little);
+    std.mem.writeInt(u32, out[12..16], header.body_crc, .little);
+    std.mem.writeInt(u16, out[16..18], header.window_count, .little);
+    std.mem.writeInt(u16, out[18..20], header.stack_len, .little);
+    out[20] = header.workspace_count;
+    out[21] = header.current_workspace;
+    out[22] = header.layout;
+    std.mem.writeInt(u16, out[24..26], header.rule_count, .little);
+}
+
+// Validate magic, version, and body checksum.
+pub fn read_header(bytes: []const u8) SnapshotError!Header {
+    if (bytes.len < HEADER_SIZE) return error.Corrupt;
+    if (std.mem.readInt(u32, bytes[0..4], .little) != SNAPSHOT_MAGIC) return error.BadMagic;
+    const version = std.mem.readInt(u16, bytes[4..6], .little);
+    if (version != SNAPSHOT_VERSION) return error.UnsupportedVersion;
+    if (std.mem.readInt(u16, bytes[6..8], .little) != HEADER_SIZE) return error.Corrupt;
+    const header = Header{
+        .version = version,
+        .body_len = std.mem.readInt(u32, bytes[8..12], .little),
+        .body_crc = std.mem.readInt(u32, bytes[12..16], .little),
+        .window_count = std.mem.readInt(u16, bytes[16..18], .little),
+        .stack_len = std.mem.readInt(u16, bytes[18..20], .little),
+        .workspace_count = bytes[20],
+        .current_workspace = bytes[21],
+        .layout = bytes[22],
+        .rule_count = std.mem.readInt(u16, bytes[24..26], .little),
+    };
+    if (@as(u64, HEADER_SIZE) + header.body_len > bytes.len) return error.Corrupt;
+    const body = bytes[HEADER_SIZE..][0..header.body_len];
+    if (std.hash.Crc32.hash(body) != header.body_crc) return error.Corrupt;
+    if (header.window_count > compositor_mod.MAX_WINDOWS) return error.Corrupt;
+    if (header.stack_len > header.window_count) return error.Corrupt;
+    if (header.workspace_count == 0 or header.workspace_count > workspace.MAX_WORKSPACES) return error.Corrupt;
+    if (header.current_workspace == 0 or header.current_workspace > header.workspace_count) return error.Corrupt;
+    if (header.layout > @intFromEnum(layout_generator.LayoutType.monocle)) return error.Corrupt;
+    if (header.rule_count > window_rules.MAX_RULES) return error.Corrupt;
+    return header;
+}
+
+// Sorted window ids from the windows section (existence checks for later sections).
+const WindowIds = struct {
+    ids: [compositor_mod.MAX_WINDOWS]u32 = undefined,
+    len: u32 = 0,
+
+    fn add(self: *WindowIds, id: u32) void {
+        std.debug.assert(self.len < compositor_mod.MAX_WINDOWS);
+        self.ids[self.len] = id;
+        self.len += 1;
+    }
+
+    // Sort and reject duplicate ids.
+    fn seal(self: *WindowIds) SnapshotError!void {
+        const ids = self.ids[0..self.len];
+        std.mem.sort(u32, ids, {}, std.sort.asc(u32));
+        var i: u32 = 1;
+        while (i < self.len) : (i += 1) {
+            if (ids[i] == ids[i - 1]) return error.Corrupt;
+        }
+    }
+
+    fn contains(self: *const WindowIds, id: u32) bool {
+        var lo: u32 = 0;
+        var hi: u32 = self.len;
+        while (lo < hi) {
+            const mid = lo + (hi - lo) / 2;
+            if (self.ids[mid] < id) lo = mid + 1 else hi = mid;
+        }
+        return lo < self.len and self.ids[lo] == id;
+    }
+};
+
+// Restore a snapshot into an empty compositor in one bulk pass.
+// Why: Windows, indices, trees, and stacking are written directly (no
+// per-window create/layout); one relayout and one full repaint follow.
+// A first pass decodes and validates every section without touching comp,
+// so a corrupt snapshot leaves the compositor empty and restore can retry.
+pub fn restore(comp: *Compositor, bytes: []const u8) SnapshotError!void {
+    if (comp.windows_len != 0) return error.NotEmpty;
+    const header = try read_header(bytes);
+    const body = bytes[0 .. HEADER_SIZE + header.body_len];
+    var ids = WindowIds{};
+    try decode_body(comp, header, body, &ids, false);
+    // Validation covered every check the commit pass makes.
+    decode_body(comp, header, body, &ids, true) catch unreachable;
+
+    // One relayout (current workspace) and one full repaint.
+    const layout: layout_generator.LayoutType = @enumFromInt(header.layout);
+    _ = comp.layout_registry.set_current_layout(layout);
+    comp.recalculate_layout();
+    comp.repaint_damage = fb_primitives.Rect{
+        .x = 0,
+        .y = 0,
+        .width = comp.output.width,
+        .height = comp.output.height,
+    };
+}
+
+// Decode the body; writes comp only when commit is set.
+fn decode_body(
+    comp: *Compositor,
+    header: Header,
+    body: []const u8,
+    ids: *WindowIds,
+    comptime commit: bool,
+) SnapshotError!void {
+    var dec = Decoder{ .buf = body, .pos = HEADER_SIZE };
+
+    // Windows.
+    var max_id: u32 = 0;
+    var i: u32 = 0;
+    while (i < header.window_count) : (i += 1) {
+        const id = try dec.u32_();
+        const x = try dec.i32_();
+        const y = try dec.i32_();
+        const width = try dec.u32_();
+        const height = try dec.u32_();
+        const flags = try dec.u8_();
+        const opacity = try dec.u8_();
+        const title_len = try dec.u16_();
+        if (id == 0 or width == 0 or height == 0) return error.Corrupt;
+        if (title_len > compositor_mod.MAX_TITLE_LEN) return error.Corrupt;
+        const title = try dec.padded_bytes(title_len);
+        max_id = @max(max_id, id);
+        if (!commit) {
+            ids.add(id);
+            continue;
+        }
+        var win = Window.init(id, comp.next_object_id, x, y, width, height);
+        comp.next_object_id += 1;
+        win.visible = flags & FLAG_VISIBLE != 0;
+        win.minimized = flags & FLAG_MINIMIZED != 0;
+        win.maximized = flags & FLAG_MAXIMIZED != 0;
+        win.focused = flags & FLAG_FOCUSED != 0;
+        win.opacity = opacity;
+        win.set_title(title);
+        if (!comp.window_index.insert(id, i)) return error.Corrupt;
+        comp.windows[i] = win;
+        comp.windows_len = i + 1;
+        comp.window_index.update_rect(id, x, y, width, height);
+        if (win.focused) comp.focused_window_id = id;
+    }
+    if (commit) {
+        comp.next_window_id = max_id + 1;
+    } else {
+        try ids.seal();
+    }
+
+    // Stacking and switch order.
+    if (commit) {
+        comp.window_stack.window_ids_len = 0;
+        comp.switch_order.window_ids_len = 0;
+    }
+    i = 0;
+    while (i < header.stack_len) : (i += 1) {
+        const window_id = try dec.u32_();
+        if (!ids.contains(window_id)) return error.Corrupt;
+        if (commit) {
+            comp.window_stack.window_ids[i] = window_id;
+            // Switch order is most-recent first: reverse of stacking.
+            comp.switch_order.window_ids[header.stack_len - 1 - i] = window_id;
+        }
+    }
+    if (commit) {
+        comp.window_stack.window_ids_len = header.stack_len;
+        comp.switch_order.window_ids_len = header.stack_len;
+        comp.window_index.set_stack_order(comp.window_stack.window_ids[0..header.stack_len]);
+    }
+
+    // Workspaces.
+    const manager = &comp.workspace_manager;
+    if (commit) {
+        while (manager.workspaces_len < header.workspace_count) {
+            _ = manager.create_workspace("") orelse return error.Corrupt;
+        }
+    }
+    i = 0;
+    while (i < header.workspace_count) : (i += 1) {
+        const ws_id = i + 1;
+        const focused = try dec.u32_();
+        const count = try dec.u16_();
+        const name_len = try dec.u8_();
+        _ = try dec.u8_();
+        if (name_len > 32) return error.Corrupt;
+        const name = try dec.padded_bytes(name_len);
+        if (commit) {
+            const ws = manager.get_workspace(ws_id).?;
+            @memset(&ws.name, 0);
+            @memcpy(ws.name[0..name_len], name);
+            ws.name_len = name_len;
+        }
+        var j: u32 = 0;
+        while (j < count) : (j += 1) {
+            const window_id = try dec.u32_();
+            if (!ids.contains(window_id)) return error.Corrupt;
+            // Windows are distinct and at most MAX_WINDOWS, so assignment
+            // never exceeds workspace or tracking capacity.
+            if (commit and !manager.assign_window_to_workspace(window_id, ws_id)) return error.Corrupt;
+        }
+        if (commit) {
+            const ws = manager.get_workspace(ws_id).?;
+            ws.focused_window_id = focused;
+            ws.layout_valid = true;
+        }
+    }
+    if (commit) {
+        _ = manager.switch_workspace(header.current_workspace);
+    }
+
+    // Tiling trees.
+    i = 0;
+    while (i < header.workspace_count) : (i += 1) {
+        const tree: ?*tiling.TilingTree = if (!commit)
+            null
+        else if (i + 1 == header.current_workspace)
+            &comp.tiling_tree
+        else
+            &comp.workspace_trees[i];
+        try decode_tree(&dec, tree, ids);
+    }
+
+    // Rules.
+    const rules = &comp.rule_manager;
+    if (commit) rules.clear_all();
+    var max_rule_id: u32 = 0;
+    var pattern_bytes: u32 = 0;
+    i = 0;
+    while (i < header.rule_count) : (i += 1) {
+        const rule_id = try dec.u32_();
+        const match_type = try decode_enum(window_rules.MatchType, try dec.u8_());
+        // Compositors only hold title rules (see add_window_rule).
+        if (match_type != .title) return error.Corrupt;
+        const action_type = try decode_enum(window_rules.ActionType, try dec.u8_());
+        const action_value_u8 = try dec.u8_();
+        const active = (try dec.u8_()) != 0;
+        const action_value_x = try dec.i32_();
+        const action_value_y = try dec.i32_();
+        const action_value_width = try dec.u32_();
+        const action_value_height = try dec.u32_();
+        const action_value_u32 = try dec.u32_();
+        const pattern_len = try dec.u32_();
+        if (pattern_len > window_rules.MAX_PATTERN_LEN) return error.Corrupt;
+        pattern_bytes += pattern_len;
+        if (pattern_bytes > window_rules.MAX_PATTERN_BYTES) return error.Corrupt;
+        const pattern = try dec.padded_bytes(pattern_len);
+        max_rule_id = @max(max_rule_id, rule_id);
+        if (!commit) continue;
+        // add_rule copies the pattern into the rule pool; ids are restored below.
+        _ = rules.add_rule(match_type, pattern, action_type) orelse return error.Corrupt;
+        const rule = &rules.rules[i];
+        rule.rule_id = rule_id;
+        rule.action_value_u8 = action_value_u8;
+        rule.active = active;
+        rule.action_value_x = action_value_x;
+        rule.action_value_y = action_value_y;
+        rule.action_value_width = action_value_width;
+        rule.action_value_height = action_value_height;
+        rule.action_value_u32 = action_value_u32;
+    }
+    if (commit) rules.next_rule_id = max_rule_id + 1;
+    if (dec.pos != dec.buf.len) return error.Corrupt;
+}
+
+// Decode one tiling tree into tree (or only validate it when tree is null).
+// Links must stay inside the decoded nodes and form one tree from the root;
+// reachable window leaves must name restored windows. Nodes left behind by
+// TilingTree.remove_window are unreachable and only bounds-checked.
+fn decode_tree(dec: *Decoder, tree: ?*tiling.TilingTree, ids: *const WindowIds) SnapshotError!void {
+    const NONE = tiling.MAX_LAYOUT_WINDOWS;
+    const nodes_len: u32 = try dec.u16_();
+    const root_index: u32 = try dec.u16_();
+    const next_node_index: u32 = try dec.u16_();
+    _ = try dec.u16_();
+    if (nodes_len > tiling.MAX_LAYOUT_WINDOWS or next_node_index > tiling.MAX_LAYOUT_WINDOWS) {
+        return error.Corrupt;
+    }
+    if (nodes_len == 0) {
+        if (root_index != NONE) return error.Corrupt;
+    } else if (root_index >= nodes_len) {
+        return error.Corrupt;
+    }
+    // Child links (NONE for leaves) and leaf window ids for the walk.
+    var lefts: [tiling.MAX_LAYOUT_WINDOWS]u32 = undefined;
+    var rights: [tiling.MAX_LAYOUT_WINDOWS]u32 = undefined;
+    var leaf_ids: [tiling.MAX_LAYOUT_WINDOWS]u32 = undefined;
+    var n: u32 = 0;
+    while (n < nodes_len) : (n += 1) {
+        var node: tiling.TilingNode = undefined;
+        const kind = try dec.u8_();
+        if (kind > 1) return error.Corrupt;
+        node.node_type = if (kind == 0) .split else .window;
+        node.split_dir = try decode_enum(tiling.SplitDirection, try dec.u8_());
+        _ = try dec.u16_();
+        node.split_ratio = @bitCast(try dec.u64_());
+        // Layout converts the ratio to pixels: reject NaN, inf, out of range.
+        if (!std.math.isFinite(node.split_ratio) or node.split_ratio < 0.0 or node.split_ratio > 1.0) {
+            return error.Corrupt;
+        }
+        node.window_id = try dec.u32_();
+        node.left_child = try dec.u16_();
+        node.right_child = try dec.u16_();
+        node.parent = try dec.u16_();
+        _ = try dec.u16_();
+        node.x = try dec.i32_();
+        node.y = try dec.i32_();
+        node.width = try dec.u32_();
+        node.height = try dec.u32_();
+        node.index = n;
+        if (node.parent != NONE and node.parent >= nodes_len) return error.Corrupt;
+        if (node.node_type == .split) {
+            if (node.left_child >= nodes_len or node.right_child >= nodes_len) return error.Corrupt;
+            lefts[n] = node.left_child;
+            rights[n] = node.right_child;
+        } else {
+            lefts[n] = NONE;
+            rights[n] = NONE;
+        }
+        leaf_ids[n] = node.window_id;
+        if (tree) |out| out.nodes[n] = node;
+    }
+
+    // Walk from the root: every split child is reached exactly once.
+    if (nodes_len > 0) {
+        var seen = std.StaticBitSet(tiling.MAX_LAYOUT_WINDOWS).initEmpty();
+        var stack: [tiling.MAX_LAYOUT_WINDOWS]u32 = undefined;
+        var stack_len: u32 = 1;
+        stack[0] = root_index;
+        seen.set(root_index);
+        while (stack_len > 0) {
+            stack_len -= 1;
+            const index = stack[stack_len];
+            if (lefts[index] == NONE) {
+                if (!ids.contains(leaf_ids[index])) return error.Corrupt;
+                continue;
+            }
+            for ([_]u32{ lefts[index], rights[index] }) |child| {
+                if (seen.isSet(child)) return error.Corrupt;
+                seen.set(child);
+                stack[stack_len] = child;
+                stack_len += 1;
+            }
+        }
+    }
+
+    const out = tree orelse return;
+    out.nodes_len = nodes_len;
+    out.root_index = root_index;
+    out.next_node_index = next_node_index;
+}
+
+// Syscall function type (matches kernel integration).
+pub const SyscallFn = *const fn (u32, u64, u64, u64, u64) i64;
+
+// Write snapshot bytes to a Basin storage file (create/truncate).
+pub fn save_to_storage(syscall_fn: SyscallFn, path: []const u8, bytes: []const u8) SnapshotError!void {
+    std.debug.assert(path.len > 0 and path.len <= MAX_PATH_LEN);
+    const flags = basin_kernel.OpenFlags.init(.{ .write = true, .create = true, .truncate = true });
+    const handle = try open_file(syscall_fn, path, flags);
+    defer close_file(syscall_fn, handle);
+    var written: usize = 0;
+    while (written < bytes.len) {
+        const result = syscall_fn(
+            @intFromEnum(basin_kernel.Syscall.write),
+            handle,
+            @intFromPtr(bytes.ptr) + written,
+            bytes.len - written,
+            0,
+        );
+        if (result <= 0) return error.StorageFailed;
+        written += @intCast(result);
+    }
+}
+
+// Read a snapshot file into buf. Returns bytes read.
+pub fn load_from_storage(syscall_fn: SyscallFn, path: []const u8, buf: []u8) SnapshotError!u32 {
+    std.debug.assert(path.len > 0 and path.len <= MAX_PATH_LEN);
+    const flags = basin_kernel.OpenFlags.init(.{ .read = true });
+    const handle = try open_file(syscall_fn, path, flags);
+    defer close_file(syscall_fn, handle);
+    var total: usize = 0;
+    while (total < buf.len) {
+        const result = syscall_fn(
+            @intFromEnum(basin_kernel.Syscall.read),
+            handle,
+            @intFromPtr(buf.ptr) + total,
+            buf.len - total,
+            0,
+        );
+        if (result < 0) return error.StorageFailed;
+        if (result == 0) break;
+        total += @intCast(result);
+    }
+    return @intCast(total);
+}
+
+fn open_file(syscall_fn: SyscallFn, path: []const u8, flags: basin_kernel.OpenFlags) SnapshotError!u64 {
+    const raw_flags: u32 = @bitCast(flags);
+    const result = syscall_fn(
+        @intFromEnum(basin_kernel.Syscall.open),
+        @intFromPtr(path.ptr),
+        path.len,
+        raw_flags,
+        0,
+    );
+    if (result <= 0) return error.StorageFailed;
+    return @intCast(result);
+}
+
+fn close_file(syscall_fn: SyscallFn, handle: u64) void {
+    _ = syscall_fn(@intFromEnum(basin_kernel.Syscall.close), handle, 0, 0, 0);
+}
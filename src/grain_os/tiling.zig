@@ -114,16 +114,13 @@ pub const TilingTree = struct {
     next_node_index: u32,
 
     pub fn init() TilingTree {
-        var tree = TilingTree{
+        const tree = TilingTree{
             .nodes = undefined,
             .nodes_len = 0,
             .root_index = MAX_LAYOUT_WINDOWS, // Invalid (no root yet).
             .next_node_index = 0,
         };
-        var i: u32 = 0;
-        while (i < MAX_LAYOUT_WINDOWS) : (i += 1) {
-            tree.nodes[i] = TilingNode.init_window(i, 0);
-        }
+        // Nodes past next_node_index are never read; add_window fills them.
         std.debug.assert(tree.nodes_len == 0);
         return tree;
     }
@@ -0,0 +1,967 @@
+//! Wayland server: core protocol over Basin channels with wl_shm pools.
+//!
+//! Why: protocol.zig only described objects; clients had no way to hand
+//! pixels to the compositor. This speaks the core protocol (wl_display,
+//! wl_registry, wl_compositor, wl_shm, wl_shm_pool, wl_buffer, wl_surface,
+//! wl_callback, wl_region) so clients render into shared buffers that the
+//! compositor samples in place.
+//! Architecture: One Server owns bounded tables of clients, pools, buffers,
+//! and surfaces. Bytes arrive through a Transport (Basin channel pair, or a
+//! loopback in tests); pools resolve through a ShmMapper; committed
+//! surfaces and their damage flow to a SurfaceSink (the compositor).
+//! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
+
+const std = @import("std");
+const wire = @import("wire.zig");
+const protocol = @import("protocol.zig");
+const fb_primitives = @import("framebuffer_primitives");
+
+// Damage rectangle type shared with the compositor.
+pub const Rect = fb_primitives.Rect;
+
+// Bounded: Max connected clients.
+pub const MAX_SERVER_CLIENTS: u32 = 16;
+
+// Bounded: Max shm pools, buffers, and surfaces (all clients).
+pub const MAX_POOLS: u32 = 64;
+pub const MAX_BUFFERS: u32 = 256;
+pub const MAX_SURFACES: u32 = 128;
+
+// Bounded: Max outstanding frame callbacks per surface.
+pub const MAX_FRAME_CALLBACKS: u32 = 8;
+
+// Bounded: Max transport reads per dispatch.
+const MAX_RECV_ROUNDS: u32 = 16;
+
+// Global names advertised by wl_registry.
+pub const GLOBAL_COMPOSITOR: u32 = 1;
+pub const GLOBAL_SHM: u32 = 2;
+pub const COMPOSITOR_VERSION: u32 = 4;
+pub const SHM_VERSION: u32 = 1;
+
+// wl_display is always object 1.
+pub const DISPLAY_ID: u32 = 1;
+
+// wl_shm formats (argb/xrgb are the core enum; others are DRM fourcc).
+pub const ShmFormat = struct {
+    pub const argb8888: u32 = 0;
+    pub const xrgb8888: u32 = 1;
+    pub const abgr8888: u32 = 0x34324241;
+    pub const xbgr8888: u32 = 0x34324258;
+};
+
+const SUPPORTED_FORMATS = [_]u32{
+    ShmFormat.argb8888,
+    ShmFormat.xrgb8888,
+    ShmFormat.abgr8888,
+    ShmFormat.xbgr8888,
+};
+
+// wl_display.error codes.
+const DisplayError = struct {
+    const invalid_object: u32 = 0;
+    const invalid_method: u32 = 1;
+    const no_memory: u32 = 2;
+    const implementation: u32 = 3;
+};
+
+// Request opcodes (core protocol order).
+const Op = struct {
+    const display_sync: u16 = 0;
+    const display_get_registry: u16 = 1;
+    const registry_bind: u16 = 0;
+    const compositor_create_surface: u16 = 0;
+    const compositor_create_region: u16 = 1;
+    const shm_create_pool: u16 = 0;
+    const shm_release: u16 = 1;
+    const pool_create_buffer: u16 = 0;
+    const pool_destroy: u16 = 1;
+    const pool_resize: u16 = 2;
+    const buffer_destroy: u16 = 0;
+    const surface_destroy: u16 = 0;
+    const surface_attach: u16 = 1;
+    const surface_damage: u16 = 2;
+    const surface_frame: u16 = 3;
+    const surface_commit: u16 = 6;
+    const surface_damage_buffer: u16 = 9;
+    const surface_last: u16 = 10;
+    const region_destroy: u16 = 0;
+    const region_last: u16 = 2;
+};
+
+// Event opcodes.
+const Ev = struct {
+    const display_error: u16 = 0;
+    const display_delete_id: u16 = 1;
+    const registry_global: u16 = 0;
+    const callback_done: u16 = 0;
+    const shm_format: u16 = 0;
+    const buffer_release: u16 = 0;
+};
+
+pub const Interface = enum(u8) {
+    none,
+    display,
+    registry,
+    callback,
+    compositor,
+    shm,
+    shm_pool,
+    buffer,
+    surface,
+    region,
+};
+
+pub const ProtocolError = error{
+    InvalidObject,
+    InvalidMethod,
+    InvalidArgument,
+    NoMemory,
+} || wire.WireError;
+
+// Byte transport for one client connection.
+pub const Transport = struct {
+    context: *anyopaque,
+    // Send all bytes (false = connection lost).
+    send_fn: *const fn (*anyopaque, []const u8) bool,
+    // Receive up to buf.len bytes (0 = nothing pending).
+    recv_fn: *const fn (*anyopaque, []u8) u32,
+
+    pub fn send(self: Transport, bytes: []const u8) bool {
+        return self.send_fn(self.context, bytes);
+    }
+
+    pub fn recv(self: Transport, buf: []u8) u32 {
+        return self.recv_fn(self.context, buf);
+    }
+};
+
+// Resolves a client's shared-memory handle to compositor-visible bytes.
+pub const ShmMapper = struct {
+    context: *anyopaque,
+    map_fn: *const fn (*anyopaque, handle: u32, size: u32) ?[]u8,
+
+    pub fn map(self: ShmMapper, handle: u32, size: u32) ?[]u8 {
+        return self.map_fn(self.context, handle, size);
+    }
+};
+
+// Shared arena mapper: the compositor grants clients regions of one area
+// mapped shared by clients and the compositor; a handle names a grant.
+// Why: Basin has no fd passing; a shared arena plus granted, bounded
+// regions gives zero-copy pools without trusting client offsets.
+pub const ArenaShmMapper = struct {
+    // Bounded: Max regions granted (one per pool).
+    pub const MAX_GRANTS: u32 = MAX_POOLS;
+
+    const Grant = struct {
+        offset: u32,
+        size: u32,
+    };
+
+    arena: []u8,
+    grants: [MAX_GRANTS]Grant = undefined,
+    grants_len: u32 = 0,
+
+    pub fn mapper(self: *ArenaShmMapper) ShmMapper {
+        return ShmMapper{ .context = self, .map_fn = map_arena };
+    }
+
+    // Reserve arena bytes for a client. Returns the handle it passes to
+    // wl_shm.create_pool, or null if the region is out of range or the
+    // grant table is full.
+    pub fn grant(self: *ArenaShmMapper, offset: u32, size: u32) ?u32 {
+        if (size == 0 or @as(u64, offset) + size > self.arena.len) return null;
+        if (self.grants_len == MAX_GRANTS) return null;
+        const handle = self.grants_len;
+        self.grants[handle] = Grant{ .offset = offset, .size = size };
+        self.grants_len += 1;
+        return handle;
+    }
+
+    // Unknown handles are rejected; sizes are clamped to the grant, so a
+    // pool never reaches past the region its client was given.
+    fn map_arena(context: *anyopaque, handle: u32, size: u32) ?[]u8 {
+        const self: *ArenaShmMapper = @ptrCast(@alignCast(context));
+        if (size == 0 or handle >= self.grants_len) return null;
+        const region = self.grants[handle];
+        std.debug.assert(@as(u64, region.offset) + region.size <= self.arena.len);
+        return self.arena[region.offset..][0..@min(size, region.size)];
+    }
+};
+
+// Basin channel pair transport (client→server and server→client queues).
+pub const ChannelTransport = struct {
+    const SyscallFn = *const fn (u32, u64, u64, u64, u64) i64;
+    const SYSCALL_CHANNEL_SEND: u32 = 21;
+    const SYSCALL_CHANNEL_RECV: u32 = 22;
+
+    syscall_fn: SyscallFn,
+    // Channel the server reads requests from.
+    request_channel: u64,
+    // Channel the server writes events to.
+    event_channel: u64,
+
+    pub fn transport(self: *ChannelTransport) Transport {
+        std.debug.assert(self.request_channel != 0);
+        std.debug.assert(self.event_channel != 0);
+        return Transport{ .context = self, .send_fn = channel_send, .recv_fn = channel_recv };
+    }
+
+    fn channel_send(context: *anyopaque, bytes: []const u8) bool {
+        const self: *ChannelTransport = @ptrCast(@alignCast(context));
+        std.debug.assert(bytes.len <= wire.MAX_MESSAGE_SIZE);
+        const result = self.syscall_fn(
+            SYSCALL_CHANNEL_SEND,
+            self.event_channel,
+            @intFromPtr(bytes.ptr),
+            bytes.len,
+            0,
+        );
+        return result >= 0;
+    }
+
+    fn channel_recv(context: *anyopaque, buf: []u8) u32 {
+        const self: *ChannelTransport = @ptrCast(@alignCast(context));
+        const len = @min(buf.len, wire.MAX_MESSAGE_SIZE);
+        if (len == 0) return 0;
+        const result = self.syscall_fn(
+            SYSCALL_CHANNEL_RECV,
+            self.request_channel,
+            @intFromPtr(buf.ptr),
+            len,
+            0,
+        );
+        if (result <= 0) return 0;
+        return @intCast(@min(@as(u64, @intCast(result)), len));
+    }
+};
+
+// View of committed client pixels in pool memory (no copy).
+// Contract: the compositor only reads through it.
+pub const BufferView = struct {
+    pixels: []u8,
+    width: u32,
+    height: u32,
+    stride: u32,
+    format: u32,
+
+    // Source bytes are R,G,B,A (framebuffer order) for abgr/xbgr formats.
+    pub fn is_rgba_order(self: BufferView) bool {
+        return self.format == ShmFormat.abgr8888 or self.format == ShmFormat.xbgr8888;
+    }
+
+    // Alpha channel is undefined for x* formats (treat as opaque).
+    pub fn is_opaque(self: BufferView) bool {
+        return self.format == ShmFormat.xrgb8888 or self.format == ShmFormat.xbgr8888;
+    }
+
+    // Wrap as a framebuffer surface (client stride preserved).
+    pub fn as_surface(self: BufferView) fb_primitives.Surface {
+        std.debug.assert(self.pixels.len >= @as(u64, self.stride) * self.height);
+        return fb_primitives.Surface{
+            .memory = self.pixels,
+            .width = self.width,
+            .height = self.height,
+            .stride = self.stride,
+        };
+    }
+};
+
+// Compositor hooks for committed surfaces.
+pub const SurfaceSink = struct {
+    context: *anyopaque,
+    // First commit with a buffer: create a window; returns id (0 = refuse).
+    map_fn: *const fn (*anyopaque, width: u32, height: u32) u32,
+    // Each commit: current contents (null = unmapped buffer) and damage in
+    // surface-local coordinates.
+    commit_fn: *const fn (*anyopaque, window_id: u32, view: ?BufferView, damage: ?fb_primitives.Rect) void,
+    // Surface destroyed or client gone.
+    unmap_fn: *const fn (*anyopaque, window_id: u32) void,
+};
+
+const ObjectEntry = struct {
+    interface: Interface = .none,
+    index: u16 = 0,
+};
+
+const Client = struct {
+    live: bool,
+    transport: Transport,
+    objects: [protocol.MAX_OBJECTS_PER_CLIENT]ObjectEntry,
+    in_buf: [wire.MAX_MESSAGE_SIZE * 2]u8,
+    in_len: u32,
+    out_buf: [wire.MAX_MESSAGE_SIZE]u8,
+    out_len: u32,
+};
+
+const Pool = struct {
+    live: bool,
+    // Pool object destroyed by client (memory stays while buffers use it).
+    destroyed: bool,
+    client: u8,
+    handle: u32,
+    memory: []u8,
+    buffer_refs: u32,
+};
+
+const Buffer = struct {
+    live: bool,
+    client: u8,
+    object_id: u32,
+    pool: u16,
+    offset: u32,
+    width: u32,
+    height: u32,
+    stride: u32,
+    format: u32,
+};
+
+// Signed pending damage bounds (clipped at commit).
+const DamageBounds = struct {
+    x0: i64,
+    y0: i64,
+    x1: i64,
+    y1: i64,
+};
+
+const SurfaceState = struct {
+    live: bool,
+    client: u8,
+    object_id: u32,
+    window_id: u32,
+    pending_attached: bool,
+    pending_buffer: ?u16,
+    pending_damage: ?DamageBounds,
+    pending_callbacks: [MAX_FRAME_CALLBACKS]u32,
+    pending_callbacks_len: u32,
+    current_buffer: ?u16,
+    current_callbacks: [MAX_FRAME_CALLBACKS]u32,
+    current_callbacks_len: u32,
+};
+
+pub const Server = struct {
+    clients: [MAX_SERVER_CLIENTS]Client,
+    pools: [MAX_POOLS]Pool,
+    buffers: [MAX_BUFFERS]Buffer,
+    surfaces: [MAX_SURFACES]SurfaceState,
+    mapper: ShmMapper,
+    sink: ?SurfaceSink,
+    serial: u32,
+    scratch: [wire.MAX_MESSAGE_SIZE]u8,
+
+    // Initialize in place (Server is large; avoid copies).
+    pub fn init(self: *Server, mapper: ShmMapper) void {
+        var i: u32 = 0;
+        while (i < MAX_SERVER_CLIENTS) : (i += 1) {
+            self.clients[i].live = false;
+        }
+        i = 0;
+        while (i < MAX_POOLS) : (i += 1) {
+            self.pools[i].live = false;
+        }
+        i = 0;
+        while (i < MAX_BUFFERS) : (i += 1) {
+            self.buffers[i].live = false;
+        }
+        i = 0;
+        while (i < MAX_SURFACES) : (i += 1) {
+            self.surfaces[i].live = false;
+        }
+        self.mapper = mapper;
+        self.sink = null;
+        self.serial = 0;
+    }
+
+    pub fn set_sink(self: *Server, sink: SurfaceSink) void {
+        self.sink = sink;
+    }
+
+    // Accept a client connection. Returns client index, or null if full.
+    pub fn connect(self: *Server, transport: Transport) ?u32 {
+        var i: u32 = 0;
+        while (i < MAX_SERVER_CLIENTS) : (i += 1) {
+            const client = &self.clients[i];
+            if (client.live) continue;
+            client.live = true;
+            client.transport = transport;
+            client.in_len = 0;
+            client.out_len = 0;
+            @memset(&client.objects, ObjectEntry{});
+            client.objects[DISPLAY_ID] = .{ .interface = .display };
+            return i;
+        }
+        return null;
+    }
+
+    pub fn is_connected(self: *const Server, client_index: u32) bool {
+        std.debug.assert(client_index < MAX_SERVER_CLIENTS);
+        return self.clients[client_index].live;
+    }
+
+    // Read and handle all pending requests from one client, then flush.
+    pub fn dispatch(self: *Server, client_index: u32) void {
+        std.debug.assert(client_index < MAX_SERVER_CLIENTS);
+        const client = &self.clients[client_index];
+        if (!client.live) return;
+        var round: u32 = 0;
+        while (round < MAX_RECV_ROUNDS) : (round += 1) {
+            const space = client.in_buf[client.in_len..];
+            if (space.len == 0) break;
+            const n = client.transport.recv(space);
+            if (n == 0) break;
+            client.in_len += n;
+            if (!self.handle_buffered(client_index)) return;
+        }
+        self.flush(client_index);
+    }
+
+    // Dispatch every connected client.
+    pub fn dispatch_all(self: *Server) void {
+        var i: u32 = 0;
+        while (i < MAX_SERVER_CLIENTS) : (i += 1) {
+            if (self.clients[i].live) self.dispatch(i);
+        }
+    }
+
+    // Complete frame callbacks for every surface (call after repaint).
+    pub fn send_frame_done(self: *Server, time_ms: u32) void {
+        var s: u32 = 0;
+        while (s < MAX_SURFACES) : (s += 1) {
+            const surface = &self.surfaces[s];
+            if (!surface.live) continue;
+            var c: u32 = 0;
+            while (c < surface.current_callbacks_len) : (c += 1) {
+                self.complete_callback(surface.client, surface.current_callbacks[c], time_ms);
+            }
+            surface.current_callbacks_len = 0;
+        }
+        var i: u32 = 0;
+        while (i < MAX_SERVER_CLIENTS) : (i += 1) {
+            if (self.clients[i].live) self.flush(i);
+        }
+    }
+
+    // Drop a client and every resource it owns.
+    pub fn disconnect(self: *Server, client_index: u32) void {
+        std.debug.assert(client_index < MAX_SERVER_CLIENTS);
+        const client = &self.clients[client_index];
+        if (!client.live) return;
+        var s: u32 = 0;
+        while (s < MAX_SURFACES) : (s += 1) {
+            const surface = &self.surfaces[s];
+            if (surface.live and surface.client == client_index) self.free_surface(@intCast(s));
+        }
+        var b: u32 = 0;
+        while (b < MAX_BUFFERS) : (b += 1) {
+            const buffer = &self.buffers[b];
+            if (buffer.live and buffer.client == client_index) self.free_buffer(@intCast(b));
+        }
+        var p: u32 = 0;
+        while (p < MAX_POOLS) : (p += 1) {
+            const pool = &self.pools[p];
+            if (pool.live and pool.client == client_index) pool.live = false;
+        }
+        client.live = false;
+    }
+
+    // Handle every complete message in the input buffer.
+    // Returns: false if the client was disconnected.
+    fn handle_buffered(self: *Server, client_index: u32) bool {
+        const client = &self.clients[client_index];
+        var pos: u32 = 0;
+        while (true) {
+            const header = wire.Header.decode(client.in_buf[pos..client.in_len]) orelse break;
+            if (header.size < wire.HEADER_SIZE or header.size % 4 != 0 or
+                header.size > wire.MAX_MESSAGE_SIZE)
+            {
+                self.post_error(client_index, DISPLAY_ID, DisplayError.invalid_method, "bad message size");
+                return false;
+            }
+            if (pos + header.size > client.in_len) break;
+            const message = client.in_buf[pos .. pos + header.size];
+            self.handle_message(client_index, header, message) catch |err| {
+                const code = switch (err) {
+                    error.InvalidObject => DisplayError.invalid_object,
+                    error.NoMemory => DisplayError.no_memory,
+                    else => DisplayError.invalid_method,
+                };
+                self.post_error(client_index, header.object_id, code, @errorName(err));
+                return false;
+            };
+            if (!client.live) return false;
+            pos += header.size;
+        }
+        // Keep the partial tail for the next read.
+        const tail = client.in_len - pos;
+        std.mem.copyForwards(u8, client.in_buf[0..tail], client.in_buf[pos..client.in_len]);
+        client.in_len = tail;
+        return true;
+    }
+
+    fn handle_message(self: *Server, ci: u32, header: wire.Header, message: []const u8) ProtocolError!void {
+        const entry = try self.lookup(ci, header.object_id);
+        var args = wire.MessageReader.init(message);
+        switch (entry.interface) {
+            .display => try self.handle_display(ci, header.opcode, &args),
+            .registry => try self.handle_registry(ci, header.opcode, &args),
+            .compositor => try self.handle_compositor(ci, header.opcode, &args),
+            .shm => try self.handle_shm(ci, header.object_id, header.opcode, &args),
+            .shm_pool => try self.handle_pool(ci, header.object_id, entry.index, header.opcode, &args),
+            .buffer => try self.handle_buffer(ci, header.object_id, entry.index, header.opcode),
+            .surface => try self.handle_surface(ci, header.object_id, entry.index, header.opcode, &args),
+            .region => {
+                if (header.opcode > Op.region_last) return error.InvalidMethod;
+                if (header.opcode == Op.region_destroy) self.destroy_object(ci, header.object_id);
+            },
+            .callback, .none => return error.InvalidObject,
+        }
+    }
+
+    fn handle_display(self: *Server, ci: u32, opcode: u16, args: *wire.MessageReader) ProtocolError!void {
+        switch (opcode) {
+            Op.display_sync => {
+                const callback_id = try args.uint();
+                try self.check_new_id(ci, callback_id);
+                self.serial +%= 1;
+                self.complete_callback(ci, callback_id, self.serial);
+            },
+            Op.display_get_registry => {
+                const registry_id = try args.uint();
+                try self.register(ci, registry_id, .registry, 0);
+                self.send_global(ci, registry_id, GLOBAL_COMPOSITOR, "wl_compositor", COMPOSITOR_VERSION);
+                self.send_global(ci, registry_id, GLOBAL_SHM, "wl_shm", SHM_VERSION);
+            },
+            else => return error.InvalidMethod,
+        }
+    }
+
+    fn handle_registry(self: *Server, ci: u32, opcode: u16, args: *wire.MessageReader) ProtocolError!void {
+        if (opcode != Op.registry_bind) return error.InvalidMethod;
+        const name = try args.uint();
+        const interface = try args.string();
+        const version = try args.uint();
+        const new_id = try args.uint();
+        if (version == 0) return error.InvalidArgument;
+        if (name == GLOBAL_COMPOSITOR and std.mem.eql(u8, interface, "wl_compositor") and
+            version <= COMPOSITOR_VERSION)
+        {
+            try self.register(ci, new_id, .compositor, 0);
+        } else if (name == GLOBAL_SHM and std.mem.eql(u8, interface, "wl_shm") and
+            version <= SHM_VERSION)
+        {
+            try self.register(ci, new_id, .shm, 0);
+            for (SUPPORTED_FORMATS) |format| {
+                var msg = wire.MessageWriter.begin(&self.scratch, new_id, Ev.shm_format);
+                msg.put_uint(format);
+                self.queue(ci, &msg);
+            }
+        } else {
+            return error.InvalidObject;
+        }
+    }
+
+    fn handle_compositor(self: *Server, ci: u32, opcode: u16, args: *wire.MessageReader) ProtocolError!void {
+        const new_id = try args.uint();
+        switch (opcode) {
+            Op.compositor_create_surface => {
+                try self.check_new_id(ci, new_id);
+                const index = self.alloc_surface(@intCast(ci), new_id) orelse return error.NoMemory;
+                try self.register(ci, new_id, .surface, index);
+            },
+            Op.compositor_create_region => try self.register(ci, new_id, .region, 0),
+            else => return error.InvalidMethod,
+        }
+    }
+
+    fn handle_shm(self: *Server, ci: u32, object_id: u32, opcode: u16, args: *wire.MessageReader) ProtocolError!void {
+        switch (opcode) {
+            Op.shm_create_pool => {
+                const new_id = try args.uint();
+                const handle = try args.uint(); // fd slot: shared-memory handle.
+                const size = try args.int();
+                if (size <= 0) return error.InvalidArgument;
+                try self.check_new_id(ci, new_id);
+                const memory = self.mapper.map(handle, @intCast(size)) orelse return error.InvalidArgument;
+                const index = self.alloc_pool(@intCast(ci), handle, memory) orelse return error.NoMemory;
+                try self.register(ci, new_id, .shm_pool, index);
+            },
+            Op.shm_release => self.destroy_object(ci, object_id),
+            else => return error.InvalidMethod,
+        }
+    }
+
+    fn handle_pool(
+        self: *Server,
+        ci: u32,
+        object_id: u32,
+        pool_index: u16,
+        opcode: u16,
+        args: *wire.MessageReader,
+    ) ProtocolError!void {
+        const pool = &self.pools[pool_index];
+        switch (opcode) {
+            Op.pool_create_buffer => {
+                const new_id = try args.uint();
+                const offset = try args.int();
+                const width = try args.int();
+                const height = try args.int();
+                const stride = try args.int();
+                const format = try args.uint();
+                if (offset < 0 or width <= 0 or height <= 0 or stride <= 0) return error.InvalidArgument;
+                if (!format_supported(format)) return error.InvalidArgument;
+                const w: u32 = @intCast(width);
+                const h: u32 = @intCast(height);
+                const s: u32 = @intCast(stride);
+                if (w > protocol.MAX_SURFACE_WIDTH or h > protocol.MAX_SURFACE_HEIGHT) return error.InvalidArgument;
+                if (s < w * fb_primitives.BYTES_PER_PIXEL) return error.InvalidArgument;
+                const end = @as(u64, @intCast(offset)) + @as(u64, s) * h;
+                if (end > pool.memory.len) return error.InvalidArgument;
+                try self.check_new_id(ci, new_id);
+                const index = self.alloc_buffer() orelse return error.NoMemory;
+                self.buffers[index] = Buffer{
+                    .live = true,
+                    .client = @intCast(ci),
+                    .object_id = new_id,
+                    .pool = pool_index,
+                    .offset = @intCast(offset),
+                    .width = w,
+                    .height = h,
+                    .stride = s,
+                    .format = format,
+                };
+                pool.buffer_refs += 1;
+                try self.register(ci, new_id, .buffer, index);
+            },
+            Op.pool_destroy => {
+                pool.destroyed = true;
+                if (pool.buffer_refs == 0) pool.live = false;
+                self.destroy_object(ci, object_id);
+            },
+            Op.pool_resize => {
+                const size = try args.int();
+                // Pools may only grow; the handle is re-resolved at the new size.
+                if (size <= 0 or @as(u64, @intCast(size)) < pool.memory.len) return error.InvalidArgument;
+                pool.memory = self.mapper.map(pool.handle, @intCast(size)) orelse return error.InvalidArgument;
+            },
+            else => return error.InvalidMethod,
+        }
+    }
+
+    fn handle_buffer(self: *Server, ci: u32, object_id: u32, buffer_index: u16, opcode: u16) ProtocolError!void {
+        if (opcode != Op.buffer_destroy) return error.InvalidMethod;
+        // Surfaces must not keep sampling a destroyed buffer.
+        var s: u32 = 0;
+        while (s < MAX_SURFACES) : (s += 1) {
+            const surface = &self.surfaces[s];
+            if (!surface.live) continue;
+            if (same_buffer(surface.pending_buffer, buffer_index)) surface.pending_buffer = null;
+            if (same_buffer(surface.current_buffer, buffer_index)) {
+                surface.current_buffer = null;
+                self.notify_commit(surface, null);
+            }
+        }
+        self.free_buffer(buffer_index);
+        self.destroy_object(ci, object_id);
+    }
+
+    fn handle_surface(
+        self: *Server,
+        ci: u32,
+        object_id: u32,
+        surface_index: u16,
+        opcode: u16,
+        args: *wire.MessageReader,
+    ) ProtocolError!void {
+        const surface = &self.surfaces[surface_index];
+        switch (opcode) {
+            Op.surface_destroy => {
+                self.free_surface(surface_index);
+                self.destroy_object(ci, object_id);
+            },
+            Op.surface_attach => {
+                const buffer_id = try args.uint();
+                _ = try args.int(); // x (ignored: no surface offset support)
+                _ = try args.int(); // y
+                if (buffer_id == 0) {
+                    surface.pending_buffer = null;
+                } else {
+                    const entry = try self.lookup(ci, buffer_id);
+                    if (entry.interface != .buffer) return error.InvalidObject;
+                    surface.pending_buffer = entry.index;
+                }
+                surface.pending_attached = true;
+            },
+            Op.surface_damage, Op.surface_damage_buffer => {
+                // Scale and transform are always 1/normal: both are buffer pixels.
+                const x = try args.int();
+                const y = try args.int();
+                const width = try args.int();
+                const height = try args.int();
+                if (width <= 0 or height <= 0) return;
+                const rect = DamageBounds{
+                    .x0 = x,
+                    .y0 = y,
+                    .x1 = @as(i64, x) + width,
+                    .y1 = @as(i64, y) + height,
+                };
+                surface.pending_damage = if (surface.pending_damage) |acc| DamageBounds{
+                    .x0 = @min(acc.x0, rect.x0),
+                    .y0 = @min(acc.y0, rect.y0),
+                    .x1 = @max(acc.x1, rect.x1),
+                    .y1 = @max(acc.y1, rect.y1),
+                } else rect;
+            },
+            Op.surface_frame => {
+                const callback_id = try args.uint();
+                if (surface.pending_callbacks_len >= MAX_FRAME_CALLBACKS) return error.NoMemory;
+                try self.register(ci, callback_id, .callback, 0);
+                surface.pending_callbacks[surface.pending_callbacks_len] = callback_id;
+                surface.pending_callbacks_len += 1;
+            },
+            Op.surface_commit => self.commit(surface),
+            else => {
+                // Opaque/input regions, transform, scale, offset: accepted, unused.
+                if (opcode > Op.surface_last) return error.InvalidMethod;
+            },
+        }
+    }
+
+    // Apply pending state: buffer, damage, frame callbacks.
+    fn commit(self: *Server, surface: *SurfaceState) void {
+        var new_contents = false;
+        if (surface.pending_attached) {
+            const previous = surface.current_buffer;
+            surface.current_buffer = surface.pending_buffer;
+            if (previous) |prev| {
+                if (!same_buffer(surface.current_buffer, prev)) self.release_buffer(prev);
+            }
+            surface.pending_attached = false;
+            new_contents = true;
+        }
+        var damage: ?fb_primitives.Rect = null;
+        if (surface.current_buffer) |buffer_index| {
+            const buffer = &self.buffers[buffer_index];
+            if (surface.pending_damage) |bounds| {
+                damage = clip_damage(bounds, buffer.width, buffer.height);
+            } else if (new_contents) {
+                damage = fb_primitives.Rect{ .x = 0, .y = 0, .width = buffer.width, .height = buffer.height };
+            }
+        }
+        surface.pending_damage = null;
+
+        // Move frame callbacks to the current list (fired after repaint).
+        var i: u32 = 0;
+        while (i < surface.pending_callbacks_len) : (i += 1) {
+            if (surface.current_callbacks_len < MAX_FRAME_CALLBACKS) {
+                surface.current_callbacks[surface.current_callbacks_len] = surface.pending_callbacks[i];
+                surface.current_callbacks_len += 1;
+            } else {
+                self.complete_callback(surface.client, surface.pending_callbacks[i], 0);
+            }
+        }
+        surface.pending_callbacks_len = 0;
+
+        if (new_contents or damage != null) self.notify_commit(surface, damage);
+    }
+
+    fn notify_commit(self: *Server, surface: *SurfaceState, damage: ?fb_primitives.Rect) void {
+        const sink = self.sink orelse return;
+        const view = if (surface.current_buffer) |b| self.buffer_view(b) else null;
+        if (surface.window_id == 0) {
+            const v = view orelse return;
+            surface.window_id = sink.map_fn(sink.context, v.width, v.height);
+            if (surface.window_id == 0) return;
+        }
+        sink.commit_fn(sink.context, surface.window_id, view, damage);
+    }
+
+    // Pixels of a live buffer (view into pool memory, no copy).
+    pub fn buffer_view(self: *const Server, buffer_index: u16) BufferView {
+        const buffer = &self.buffers[buffer_index];
+        std.debug.assert(buffer.live);
+        const pool = &self.pools[buffer.pool];
+        const len = @as(usize, buffer.stride) * buffer.height;
+        return BufferView{
+            .pixels = pool.memory[buffer.offset..][0..len],
+            .width = buffer.width,
+            .height = buffer.height,
+            .stride = buffer.stride,
+            .format = buffer.format,
+        };
+    }
+
+    fn release_buffer(self: *Server, buffer_index: u16) void {
+        const buffer = &self.buffers[buffer_index];
+        if (!buffer.live) return;
+        var msg = wire.MessageWriter.begin(&self.scratch, buffer.object_id, Ev.buffer_release);
+        self.queue(buffer.client, &msg);
+    }
+
+    fn complete_callback(self: *Server, client_index: u32, callback_id: u32, data: u32) void {
+        var msg = wire.MessageWriter.begin(&self.scratch, callback_id, Ev.callback_done);
+        msg.put_uint(data);
+        self.queue(client_index, &msg);
+        self.destroy_object(client_index, callback_id);
+    }
+
+    fn send_global(self: *Server, ci: u32, registry_id: u32, name: u32, interface: []const u8, version: u32) void {
+        var msg = wire.MessageWriter.begin(&self.scratch, registry_id, Ev.registry_global);
+        msg.put_uint(name);
+        msg.put_string(interface);
+        msg.put_uint(version);
+        self.queue(ci, &msg);
+    }
+
+    // Send wl_display.error, flush, and disconnect.
+    fn post_error(self: *Server, ci: u32, object_id: u32, code: u32, message: []const u8) void {
+        var msg = wire.MessageWriter.begin(&self.scratch, DISPLAY_ID, Ev.display_error);
+        msg.put_uint(object_id);
+        msg.put_uint(code);
+        msg.put_string(message);
+        self.queue(ci, &msg);
+        self.flush(ci);
+        self.disconnect(ci);
+    }
+
+    // Free a client object id and tell the client (wl_display.delete_id).
+    fn destroy_object(self: *Server, ci: u32, object_id: u32) void {
+        const client = &self.clients[ci];
+        if (object_id >= protocol.MAX_OBJECTS_PER_CLIENT) return;
+        client.objects[object_id] = ObjectEntry{};
+        var msg = wire.MessageWriter.begin(&self.scratch, DISPLAY_ID, Ev.display_delete_id);
+        msg.put_uint(object_id);
+        self.queue(ci, &msg);
+    }
+
+    // Append an event to the client's output buffer (flushing if full).
+    fn queue(self: *Server, ci: u32, msg: *wire.MessageWriter) void {
+        const client = &self.clients[ci];
+        if (!client.live) return;
+        const bytes = msg.finish() catch unreachable; // Server events are bounded.
+        if (client.out_len + bytes.len > client.out_buf.len) self.flush(ci);
+        if (!client.live) return;
+        @memcpy(client.out_buf[client.out_len..][0..bytes.len], bytes);
+        client.out_len += @intCast(bytes.len);
+    }
+
+    fn flush(self: *Server, ci: u32) void {
+        const client = &self.clients[ci];
+        if (!client.live or client.out_len == 0) return;
+        const sent = client.transport.send(client.out_buf[0..client.out_len]);
+        client.out_len = 0;
+        if (!sent) self.disconnect(ci);
+    }
+
+    fn lookup(self: *const Server, ci: u32, object_id: u32) ProtocolError!ObjectEntry {
+        if (object_id == 0 or object_id >= protocol.MAX_OBJECTS_PER_CLIENT) return error.InvalidObject;
+        const entry = self.clients[ci].objects[object_id];
+        if (entry.interface == .none) return error.InvalidObject;
+        return entry;
+    }
+
+    fn check_new_id(self: *const Server, ci: u32, object_id: u32) ProtocolError!void {
+        if (object_id == 0 or object_id >= protocol.MAX_OBJECTS_PER_CLIENT) return error.InvalidObject;
+        if (self.clients[ci].objects[object_id].interface != .none) return error.InvalidObject;
+    }
+
+    fn register(self: *Server, ci: u32, object_id: u32, interface: Interface, index: u16) ProtocolError!void {
+        try self.check_new_id(ci, object_id);
+        self.clients[ci].objects[object_id] = ObjectEntry{ .interface = interface, .index = index };
+    }
+
+    fn alloc_pool(self: *Server, client: u8, handle: u32, memory: []u8) ?u16 {
+        var i: u32 = 0;
+        while (i < MAX_POOLS) : (i += 1) {
+            if (self.pools[i].live) continue;
+            self.pools[i] = Pool{
+                .live = true,
+                .destroyed = false,
+                .client = client,
+                .handle = handle,
+                .memory = memory,
+                .buffer_refs = 0,
+            };
+            return @intCast(i);
+        }
+        return null;
+    }
+
+    fn alloc_buffer(self: *const Server) ?u16 {
+        var i: u32 = 0;
+        while (i < MAX_BUFFERS) : (i += 1) {
+            if (!self.buffers[i].live) return @intCast(i);
+        }
+        return null;
+    }
+
+    fn free_buffer(self: *Server, buffer_index: u16) void {
+        const buffer = &self.buffers[buffer_index];
+        if (!buffer.live) return;
+        buffer.live = false;
+        const pool = &self.pools[buffer.pool];
+        std.debug.assert(pool.buffer_refs > 0);
+        pool.buffer_refs -= 1;
+        if (pool.destroyed and pool.buffer_refs == 0) pool.live = false;
+    }
+
+    fn alloc_surface(self: *Server, client: u8, object_id: u32) ?u16 {
+        var i: u32 = 0;
+        while (i < MAX_SURFACES) : (i += 1) {
+            const surface = &self.surfaces[i];
+            if (surface.live) continue;
+            surface.* = SurfaceState{
+                .live = true,
+                .client = client,
+                .object_id = object_id,
+                .window_id = 0,
+                .pending_attached = false,
+                .pending_buffer = null,
+                .pending_damage = null,
+                .pending_callbacks = undefined,
+                .pending_callbacks_len = 0,
+                .current_buffer = null,
+                .current_callbacks = undefined,
+                .current_callbacks_len = 0,
+            };
+            return @intCast(i);
+        }
+        return null;
+    }
+
+    fn free_surface(self: *Server, surface_index: u16) void {
+        const surface = &self.surfaces[surface_index];
+        if (!surface.live) return;
+        if (surface.window_id != 0) {
+            if (self.sink) |sink| sink.unmap_fn(sink.context, surface.window_id);
+        }
+        surface.live = false;
+    }
+};
+
+fn same_buffer(slot: ?u16, buffer_index: u16) bool {
+    const index = slot orelse return false;
+    return index == buffer_index;
+}
+
+fn format_supported(format: u32) bool {
+    for (SUPPORTED_FORMATS) |supported| {
+        if (format == supported) return true;
+    }
+    return false;
+}
+
+// Clip signed damage bounds to the buffer (null if nothing remains).
+fn clip_damage(bounds: DamageBounds, width: u32, height: u32) ?fb_primitives.Rect {
+    const x0 = std.math.clamp(bounds.x0, 0, @as(i64, width));
+    const y0 = std.math.clamp(bounds.y0, 0, @as(i64, height));
+    const x1 = std.math.clamp(bounds.x1, 0, @as(i64, width));
+    const y1 = std.math.clamp(bounds.y1, 0, @as(i64, height));
+    if (x1 <= x0 or y1 <= y0) return null;
+    return fb_primitives.Rect{
+        .x = @intCast(x0),
+        .y = @intCast(y0),
+        .width = @intCast(x1 - x0),
+        .height = @intCast(y1 - y0),
+    };
+}
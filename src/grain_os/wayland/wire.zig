@@ -0,0 +1,161 @@
+//! Wayland wire format: message header and argument marshalling.
+//!
+//! Why: Speak the core protocol byte-for-byte so standard client logic
+//! (and a headless test client) can drive the compositor.
+//! Architecture: 8-byte header (object id, size << 16 | opcode) followed by
+//! 32-bit aligned arguments in host byte order. Strings and arrays carry a
+//! u32 length and are padded to 4 bytes. File descriptors have no Basin
+//! equivalent; fd arguments travel in-band as a u32 shared-memory handle.
+//! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
+
+const std = @import("std");
+
+// Bounded: Max message size (matches libwayland and Basin channel limit).
+pub const MAX_MESSAGE_SIZE: u32 = 4096;
+
+// Header size in bytes.
+pub const HEADER_SIZE: u32 = 8;
+
+// Bounded: Max string length (including terminating NUL).
+pub const MAX_STRING_LEN: u32 = 256;
+
+// Signed 24.8 fixed-point value.
+pub const Fixed = i32;
+
+pub const WireError = error{
+    MessageTooLarge,
+    Truncated,
+    InvalidString,
+};
+
+// Message header.
+pub const Header = struct {
+    object_id: u32,
+    opcode: u16,
+    size: u16,
+
+    // Decode header from the start of buf (null if fewer than 8 bytes).
+    pub fn decode(buf: []const u8) ?Header {
+        if (buf.len < HEADER_SIZE) return null;
+        const word = std.mem.readInt(u32, buf[4..8], .little);
+        return Header{
+            .object_id = std.mem.readInt(u32, buf[0..4], .little),
+            .opcode = @truncate(word & 0xFFFF),
+            .size = @truncate(word >> 16),
+        };
+    }
+};
+
+// Builds one message into a caller-owned buffer.
+pub const MessageWriter = struct {
+    buffer: []u8,
+    len: u32,
+    overflow: bool,
+
+    // Start a message for object_id/opcode (size patched by finish).
+    pub fn begin(buffer: []u8, object_id: u32, opcode: u16) MessageWriter {
+        std.debug.assert(buffer.len >= HEADER_SIZE);
+        std.debug.assert(object_id > 0);
+        std.mem.writeInt(u32, buffer[0..4], object_id, .little);
+        std.mem.writeInt(u32, buffer[4..8], opcode, .little);
+        return MessageWriter{ .buffer = buffer, .len = HEADER_SIZE, .overflow = false };
+    }
+
+    pub fn put_uint(self: *MessageWriter, value: u32) void {
+        if (!self.reserve(4)) return;
+        std.mem.writeInt(u32, self.buffer[self.len..][0..4], value, .little);
+        self.len += 4;
+    }
+
+    pub fn put_int(self: *MessageWriter, value: i32) void {
+        self.put_uint(@bitCast(value));
+    }
+
+    // Strings are NUL-terminated on the wire; length includes the NUL.
+    pub fn put_string(self: *MessageWriter, value: []const u8) void {
+        std.debug.assert(value.len < MAX_STRING_LEN);
+        const len: u32 = @intCast(value.len + 1);
+        const padded = pad4(len);
+        if (!self.reserve(4 + padded)) return;
+        self.put_uint(len);
+        @memcpy(self.buffer[self.len..][0..value.len], value);
+        @memset(self.buffer[self.len + value.len .. self.len + padded], 0);
+        self.len += padded;
+    }
+
+    pub fn put_array(self: *MessageWriter, value: []const u8) void {
+        const len: u32 = @intCast(value.len);
+        const padded = pad4(len);
+        if (!self.reserve(4 + padded)) return;
+        self.put_uint(len);
+        @memcpy(self.buffer[self.len..][0..value.len], value);
+        @memset(self.buffer[self.len + value.len .. self.len + padded], 0);
+        self.len += padded;
+    }
+
+    // Patch the size field; returns the encoded message.
+    pub fn finish(self: *MessageWriter) WireError![]const u8 {
+        if (self.overflow) return error.MessageTooLarge;
+        std.debug.assert(self.len % 4 == 0);
+        const opcode = std.mem.readInt(u32, self.buffer[4..8], .little) & 0xFFFF;
+        std.mem.writeInt(u32, self.buffer[4..8], (self.len << 16) | opcode, .little);
+        return self.buffer[0..self.len];
+    }
+
+    fn reserve(self: *MessageWriter, bytes: u32) bool {
+        if (self.len + bytes > self.buffer.len or self.len + bytes > MAX_MESSAGE_SIZE) {
+            self.overflow = true;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Reads arguments from one message body.
+pub const MessageReader = struct {
+    body: []const u8,
+    pos: u32,
+
+    // Wrap a complete message (header included).
+    pub fn init(message: []const u8) MessageReader {
+        std.debug.assert(message.len >= HEADER_SIZE);
+        return MessageReader{ .body = message[HEADER_SIZE..], .pos = 0 };
+    }
+
+    pub fn uint(self: *MessageReader) WireError!u32 {
+        if (self.pos + 4 > self.body.len) return error.Truncated;
+        const value = std.mem.readInt(u32, self.body[self.pos..][0..4], .little);
+        self.pos += 4;
+        return value;
+    }
+
+    pub fn int(self: *MessageReader) WireError!i32 {
+        return @bitCast(try self.uint());
+    }
+
+    // Returns the string without its terminating NUL.
+    pub fn string(self: *MessageReader) WireError![]const u8 {
+        const len = try self.uint();
+        if (len == 0 or len > MAX_STRING_LEN) return error.InvalidString;
+        const padded = pad4(len);
+        if (self.pos + padded > self.body.len) return error.Truncated;
+        const bytes = self.body[self.pos..][0..len];
+        if (bytes[len - 1] != 0) return error.InvalidString;
+        self.pos += padded;
+        return bytes[0 .. len - 1];
+    }
+
+    pub fn array(self: *MessageReader) WireError![]const u8 {
+        const len = try self.uint();
+        const padded = pad4(len);
+        if (self.pos + padded > self.body.len) return error.Truncated;
+        const bytes = self.body[self.pos..][0..len];
+        self.pos += padded;
+        return bytes;
+    }
+};
+
+// Round up to the 32-bit argument alignment.
+pub fn pad4(len: u32) u32 {
+    return (len + 3) & ~@as(u32, 3);
+}
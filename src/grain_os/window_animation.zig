@@ -1,18 +1,35 @@
 //! Grain OS Window Animation: Smooth transitions for window operations.
 //!
 //! Why: Provide smooth animations for window move, resize, minimize, maximize.
-//! Architecture: Animation state management and interpolation.
+//! Architecture: Structure-of-arrays animation table plus a window-id index.
+//! advance() runs one pass over @Vector lanes that computes progress, easing
+//! and every interpolated channel for all active animations, then retires
+//! the finished ones and returns their window ids to the compositor.
 //! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
 
 const std = @import("std");
-const compositor = @import("compositor.zig");
+const bounded_map = @import("bounded_map.zig");
 
-// Bounded: Max active animations.
-pub const MAX_ANIMATIONS: u32 = 64;
+// Bounded: Max active animations (every window sliding at once, plus fades).
+pub const MAX_ANIMATIONS: u32 = 1024;
 
 // Bounded: Animation duration (milliseconds).
 pub const ANIMATION_DURATION_MS: u32 = 200;
 
+// Lanes per vector step (MAX_ANIMATIONS is a multiple).
+pub const LANES: u32 = 8;
+
+const EMPTY_ID: u32 = 0;
+
+const FloatVec = @Vector(LANES, f32);
+const IntVec = @Vector(LANES, i32);
+const CodeVec = @Vector(LANES, u8);
+
+comptime {
+    std.debug.assert(MAX_ANIMATIONS % LANES == 0);
+    std.debug.assert(MAX_ANIMATIONS <= std.math.maxInt(u16));
+}
+
 // Animation type.
 pub const AnimationType = enum(u8) {
     none,
@@ -23,10 +40,45 @@ pub const AnimationType = enum(u8) {
     opacity,
 };
 
-// Animation state.
+// Easing curve applied to linear progress.
+pub const Easing = enum(u8) {
+    linear,
+    ease_in_quad,
+    ease_out_quad,
+    ease_out_cubic,
+    ease_in_out_cubic,
+};
+
+// Channels an animation drives; the others keep the window's own values.
+pub const CHANNEL_POSITION: u8 = 1 << 0;
+pub const CHANNEL_SIZE: u8 = 1 << 1;
+pub const CHANNEL_OPACITY: u8 = 1 << 2;
+
+// Channels written back for an animation type.
+// Why: A fade must not pull geometry toward its unused zero targets.
+pub fn channels_for(anim_type: AnimationType) u8 {
+    return switch (anim_type) {
+        .none => 0,
+        .move => CHANNEL_POSITION,
+        .resize => CHANNEL_SIZE,
+        .minimize, .maximize => CHANNEL_POSITION | CHANNEL_SIZE,
+        .opacity => CHANNEL_OPACITY,
+    };
+}
+
+// Default curve for an animation type (override with set_easing).
+pub fn default_easing(anim_type: AnimationType) Easing {
+    return switch (anim_type) {
+        .move, .resize, .minimize, .maximize => .ease_out_cubic,
+        .none, .opacity => .linear,
+    };
+}
+
+// Animation state (snapshot of one table row).
 pub const AnimationState = struct {
     window_id: u32,
     anim_type: AnimationType,
+    easing: Easing,
     start_x: i32,
     start_y: i32,
     start_width: u32,
@@ -42,40 +94,74 @@ pub const AnimationState = struct {
     active: bool,
 };
 
+// Interpolated values for one animation after advance().
+pub const Sample = struct {
+    window_id: u32,
+    channels: u8,
+    x: i32,
+    y: i32,
+    width: u32,
+    height: u32,
+    opacity: u8,
+    done: bool,
+};
+
+// Result of advance(): samples 0..len (read via sample()) and finished ids.
+pub const Step = struct {
+    len: u32,
+    completed: []const u32,
+};
+
 // Animation manager: manages window animations.
 pub const AnimationManager = struct {
-    animations: [MAX_ANIMATIONS]AnimationState,
+    // Live table, dense in 0..animations_len (swap-remove on retire).
+    window_ids: [MAX_ANIMATIONS]u32,
+    anim_types: [MAX_ANIMATIONS]AnimationType,
+    easing_codes: [MAX_ANIMATIONS]u8,
+    channel_masks: [MAX_ANIMATIONS]u8,
+    start_times: [MAX_ANIMATIONS]u64,
+    durations: [MAX_ANIMATIONS]u32,
+    // Interpolation inputs: start value and (target - start), as f32 lanes.
+    start_x: [MAX_ANIMATIONS]f32,
+    start_y: [MAX_ANIMATIONS]f32,
+    start_w: [MAX_ANIMATIONS]f32,
+    start_h: [MAX_ANIMATIONS]f32,
+    start_o: [MAX_ANIMATIONS]f32,
+    delta_x: [MAX_ANIMATIONS]f32,
+    delta_y: [MAX_ANIMATIONS]f32,
+    delta_w: [MAX_ANIMATIONS]f32,
+    delta_h: [MAX_ANIMATIONS]f32,
+    delta_o: [MAX_ANIMATIONS]f32,
     animations_len: u32,
+    // Window id -> table row.
+    rows: bounded_map.BoundedMap(MAX_ANIMATIONS),
+    // Outputs of the last advance(), in pre-retirement row order.
+    out_ids: [MAX_ANIMATIONS]u32,
+    out_channels: [MAX_ANIMATIONS]u8,
+    out_x: [MAX_ANIMATIONS]i32,
+    out_y: [MAX_ANIMATIONS]i32,
+    out_w: [MAX_ANIMATIONS]i32,
+    out_h: [MAX_ANIMATIONS]i32,
+    out_o: [MAX_ANIMATIONS]u8,
+    out_done: [MAX_ANIMATIONS]bool,
+    out_len: u32,
+    completed: [MAX_ANIMATIONS]u32,
+    completed_len: u32,
 
     pub fn init() AnimationManager {
-        var manager = AnimationManager{
-            .animations = undefined,
-            .animations_len = 0,
-        };
-        var i: u32 = 0;
-        while (i < MAX_ANIMATIONS) : (i += 1) {
-            manager.animations[i] = AnimationState{
-                .window_id = 0,
-                .anim_type = AnimationType.none,
-                .start_x = 0,
-                .start_y = 0,
-                .start_width = 0,
-                .start_height = 0,
-                .start_opacity = 0,
-                .target_x = 0,
-                .target_y = 0,
-                .target_width = 0,
-                .target_height = 0,
-                .target_opacity = 0,
-                .start_time = 0,
-                .duration_ms = 0,
-                .active = false,
-            };
+        var manager: AnimationManager = undefined;
+        manager.animations_len = 0;
+        manager.out_len = 0;
+        manager.completed_len = 0;
+        manager.rows = bounded_map.BoundedMap(MAX_ANIMATIONS).init();
+        var row: u32 = 0;
+        while (row < MAX_ANIMATIONS) : (row += 1) {
+            manager.clear_row(row);
         }
         return manager;
     }
 
-    // Start animation for window.
+    // Start animation for window (replaces any running one for it).
     pub fn start_animation(
         self: *AnimationManager,
         window_id: u32,
@@ -93,86 +179,90 @@ pub const AnimationManager = struct {
         start_time: u64,
     ) bool {
         std.debug.assert(window_id > 0);
-        if (self.animations_len >= MAX_ANIMATIONS) {
-            return false;
-        }
-        // Check if animation already exists, update it.
-        var i: u32 = 0;
-        while (i < self.animations_len) : (i += 1) {
-            if (self.animations[i].window_id == window_id) {
-                self.animations[i].anim_type = anim_type;
-                self.animations[i].start_x = start_x;
-                self.animations[i].start_y = start_y;
-                self.animations[i].start_width = start_width;
-                self.animations[i].start_height = start_height;
-                self.animations[i].start_opacity = start_opacity;
-                self.animations[i].target_x = target_x;
-                self.animations[i].target_y = target_y;
-                self.animations[i].target_width = target_width;
-                self.animations[i].target_height = target_height;
-                self.animations[i].target_opacity = target_opacity;
-                self.animations[i].start_time = start_time;
-                self.animations[i].duration_ms = ANIMATION_DURATION_MS;
-                self.animations[i].active = true;
-                return true;
+        const row = self.row_of(window_id) orelse blk: {
+            if (self.animations_len >= MAX_ANIMATIONS) {
+                return false;
             }
-        }
-        // Add new animation.
-        self.animations[self.animations_len] = AnimationState{
-            .window_id = window_id,
-            .anim_type = anim_type,
-            .start_x = start_x,
-            .start_y = start_y,
-            .start_width = start_width,
-            .start_height = start_height,
-            .start_opacity = start_opacity,
-            .target_x = target_x,
-            .target_y = target_y,
-            .target_width = target_width,
-            .target_height = target_height,
-            .target_opacity = target_opacity,
-            .start_time = start_time,
-            .duration_ms = ANIMATION_DURATION_MS,
-            .active = true,
+            const new_row = self.animations_len;
+            self.animations_len += 1;
+            const indexed = self.rows.put(window_id, new_row);
+            std.debug.assert(indexed);
+            break :blk new_row;
         };
-        self.animations_len += 1;
+        self.window_ids[row] = window_id;
+        self.anim_types[row] = anim_type;
+        self.easing_codes[row] = @intFromEnum(default_easing(anim_type));
+        self.channel_masks[row] = channels_for(anim_type);
+        self.start_times[row] = start_time;
+        self.durations[row] = ANIMATION_DURATION_MS;
+        self.start_x[row] = @floatFromInt(start_x);
+        self.start_y[row] = @floatFromInt(start_y);
+        self.start_w[row] = @floatFromInt(start_width);
+        self.start_h[row] = @floatFromInt(start_height);
+        self.start_o[row] = @floatFromInt(start_opacity);
+        self.delta_x[row] = @floatFromInt(@as(i64, target_x) - start_x);
+        self.delta_y[row] = @floatFromInt(@as(i64, target_y) - start_y);
+        self.delta_w[row] = @floatFromInt(@as(i64, target_width) - start_width);
+        self.delta_h[row] = @floatFromInt(@as(i64, target_height) - start_height);
+        self.delta_o[row] = @floatFromInt(@as(i32, target_opacity) - start_opacity);
+        std.debug.assert(self.animations_len <= MAX_ANIMATIONS);
         return true;
     }
 
-    // Get animation for window.
+    // Override the easing curve of a running animation.
+    pub fn set_easing(self: *AnimationManager, window_id: u32, easing: Easing) bool {
+        std.debug.assert(window_id > 0);
+        const row = self.row_of(window_id) orelse return false;
+        self.easing_codes[row] = @intFromEnum(easing);
+        return true;
+    }
+
+    // Get animation for window (snapshot of its row).
     pub fn get_animation(
-        self: *AnimationManager,
+        self: *const AnimationManager,
         window_id: u32,
-    ) ?*AnimationState {
+    ) ?AnimationState {
         std.debug.assert(window_id > 0);
-        var i: u32 = 0;
-        while (i < self.animations_len) : (i += 1) {
-            if (self.animations[i].window_id == window_id and
-                self.animations[i].active)
-            {
-                return &self.animations[i];
-            }
-        }
-        return null;
+        const row = self.row_of(window_id) orelse return null;
+        return AnimationState{
+            .window_id = window_id,
+            .anim_type = self.anim_types[row],
+            .easing = @enumFromInt(self.easing_codes[row]),
+            .start_x = @intFromFloat(self.start_x[row]),
+            .start_y = @intFromFloat(self.start_y[row]),
+            .start_width = @intFromFloat(self.start_w[row]),
+            .start_height = @intFromFloat(self.start_h[row]),
+            .start_opacity = @intFromFloat(self.start_o[row]),
+            .target_x = @intFromFloat(self.start_x[row] + self.delta_x[row]),
+            .target_y = @intFromFloat(self.start_y[row] + self.delta_y[row]),
+            .target_width = @intFromFloat(self.start_w[row] + self.delta_w[row]),
+            .target_height = @intFromFloat(self.start_h[row] + self.delta_h[row]),
+            .target_opacity = @intFromFloat(self.start_o[row] + self.delta_o[row]),
+            .start_time = self.start_times[row],
+            .duration_ms = self.durations[row],
+            .active = true,
+        };
     }
 
-    // Remove animation for window.
+    // Remove animation for window (swap the last row into its place).
     pub fn remove_animation(self: *AnimationManager, window_id: u32) bool {
         std.debug.assert(window_id > 0);
-        var i: u32 = 0;
-        while (i < self.animations_len) : (i += 1) {
-            if (self.animations[i].window_id == window_id) {
-                self.animations[i].active = false;
-                return true;
-            }
+        const row = self.rows.remove(window_id) orelse return false;
+        const last = self.animations_len - 1;
+        if (row != last) {
+            self.copy_row(row, last);
+            const moved = self.rows.put(self.window_ids[row], row);
+            std.debug.assert(moved);
         }
-        return false;
+        self.clear_row(last);
+        self.animations_len = last;
+        return true;
     }
 
-    // Calculate interpolation progress (0.0 to 1.0).
+    // Calculate interpolation progress (0.0 to 1.0, before easing).
     pub fn calc_progress(
         _self: *const AnimationManager,
-        anim: *const AnimationState,
+        anim: AnimationState,
         current_time: u64,
     ) f32 {
         _ = _self;
@@ -193,56 +283,128 @@ pub const AnimationManager = struct {
         return start + (target - start) * progress;
     }
 
-    // Update animation and return current values.
+    // Update one window's animation and return its current values.
+    // Why: Single-window queries; per-frame work goes through advance().
     pub fn update_animation(
         self: *AnimationManager,
         window_id: u32,
         current_time: u64,
     ) ?struct { x: i32, y: i32, width: u32, height: u32, opacity: u8, done: bool } {
         std.debug.assert(window_id > 0);
-        if (self.get_animation(window_id)) |anim| {
-            const progress = self.calc_progress(anim, current_time);
-            const done = (progress >= 1.0);
-            // Interpolate values.
-            const x = @as(i32, @intFromFloat(AnimationManager.lerp(
-                @as(f32, @floatFromInt(anim.start_x)),
-                @as(f32, @floatFromInt(anim.target_x)),
-                progress,
-            )));
-            const y = @as(i32, @intFromFloat(AnimationManager.lerp(
-                @as(f32, @floatFromInt(anim.start_y)),
-                @as(f32, @floatFromInt(anim.target_y)),
-                progress,
-            )));
-            const width = @as(u32, @intFromFloat(AnimationManager.lerp(
-                @as(f32, @floatFromInt(anim.start_width)),
-                @as(f32, @floatFromInt(anim.target_width)),
-                progress,
-            )));
-            const height = @as(u32, @intFromFloat(AnimationManager.lerp(
-                @as(f32, @floatFromInt(anim.start_height)),
-                @as(f32, @floatFromInt(anim.target_height)),
-                progress,
-            )));
-            const opacity = @as(u8, @intFromFloat(AnimationManager.lerp(
-                @as(f32, @floatFromInt(anim.start_opacity)),
-                @as(f32, @floatFromInt(anim.target_opacity)),
-                progress,
-            )));
-            if (done) {
-                _ = self.remove_animation(window_id);
+        const anim = self.get_animation(window_id) orelse return null;
+        const progress = self.calc_progress(anim, current_time);
+        const done = (progress >= 1.0);
+        const eased = ease(anim.easing, progress);
+        const x = @as(i32, @intFromFloat(AnimationManager.lerp(
+            @as(f32, @floatFromInt(anim.start_x)),
+            @as(f32, @floatFromInt(anim.target_x)),
+            eased,
+        )));
+        const y = @as(i32, @intFromFloat(AnimationManager.lerp(
+            @as(f32, @floatFromInt(anim.start_y)),
+            @as(f32, @floatFromInt(anim.target_y)),
+            eased,
+        )));
+        const width = @as(u32, @intFromFloat(@max(AnimationManager.lerp(
+            @as(f32, @floatFromInt(anim.start_width)),
+            @as(f32, @floatFromInt(anim.target_width)),
+            eased,
+        ), 0.0)));
+        const height = @as(u32, @intFromFloat(@max(AnimationManager.lerp(
+            @as(f32, @floatFromInt(anim.start_height)),
+            @as(f32, @floatFromInt(anim.target_height)),
+            eased,
+        ), 0.0)));
+        const opacity = @as(u8, @intFromFloat(std.math.clamp(AnimationManager.lerp(
+            @as(f32, @floatFromInt(anim.start_opacity)),
+            @as(f32, @floatFromInt(anim.target_opacity)),
+            eased,
+        ), 0.0, 255.0)));
+        if (done) {
+            _ = self.remove_animation(window_id);
+        }
+        return .{ .x = x, .y = y, .width = width, .height = height, .opacity = opacity, .done = done };
+    }
+
+    // Advance every active animation to current_time in one vector pass.
+    // Returns: sample count (read with sample(i)) and the ids that finished;
+    // finished animations are already removed from the table.
+    pub fn advance(self: *AnimationManager, current_time: u64) Step {
+        const len = self.animations_len;
+        const now: @Vector(LANES, u64) = @splat(current_time);
+        const zero: FloatVec = @splat(0.0);
+        const one: FloatVec = @splat(1.0);
+        const max_opacity: FloatVec = @splat(255.0);
+        // Rows past len hold neutral values (see clear_row), so whole
+        // vectors are safe to evaluate; their results are never read.
+        var base: u32 = 0;
+        while (base < len) : (base += LANES) {
+            const start: @Vector(LANES, u64) = self.start_times[base..][0..LANES].*;
+            const started = now > start;
+            const elapsed = @select(u64, started, now -% start, @as(@Vector(LANES, u64), @splat(0)));
+            const durations: @Vector(LANES, u32) = self.durations[base..][0..LANES].*;
+            const elapsed_f: FloatVec = @floatFromInt(elapsed);
+            const duration_f: FloatVec = @floatFromInt(durations);
+            const progress = @min(elapsed_f / duration_f, one);
+            const eased = ease_vector(progress, self.easing_codes[base..][0..LANES].*);
+            const x: IntVec = @intFromFloat(lane(&self.start_x, base) + lane(&self.delta_x, base) * eased);
+            const y: IntVec = @intFromFloat(lane(&self.start_y, base) + lane(&self.delta_y, base) * eased);
+            const w: IntVec = @intFromFloat(@max(lane(&self.start_w, base) + lane(&self.delta_w, base) * eased, zero));
+            const h: IntVec = @intFromFloat(@max(lane(&self.start_h, base) + lane(&self.delta_h, base) * eased, zero));
+            const o: @Vector(LANES, u8) = @intFromFloat(@max(@min(
+                lane(&self.start_o, base) + lane(&self.delta_o, base) * eased,
+                max_opacity,
+            ), zero));
+            const done = progress >= one;
+            self.out_x[base..][0..LANES].* = x;
+            self.out_y[base..][0..LANES].* = y;
+            self.out_w[base..][0..LANES].* = w;
+            self.out_h[base..][0..LANES].* = h;
+            self.out_o[base..][0..LANES].* = o;
+            self.out_done[base..][0..LANES].* = done;
+        }
+        @memcpy(self.out_ids[0..len], self.window_ids[0..len]);
+        @memcpy(self.out_channels[0..len], self.channel_masks[0..len]);
+        self.out_len = len;
+        // Retire finished animations (ids were captured above).
+        self.completed_len = 0;
+        var i: u32 = 0;
+        while (i < len) : (i += 1) {
+            if (self.out_done[i]) {
+                self.completed[self.completed_len] = self.out_ids[i];
+                self.completed_len += 1;
             }
-            return .{ .x = x, .y = y, .width = width, .height = height, .opacity = opacity, .done = done };
         }
-        return null;
+        i = 0;
+        while (i < self.completed_len) : (i += 1) {
+            const removed = self.remove_animation(self.completed[i]);
+            std.debug.assert(removed);
+        }
+        return Step{ .len = len, .completed = self.completed[0..self.completed_len] };
+    }
+
+    // Values for row i of the last advance().
+    pub fn sample(self: *const AnimationManager, i: u32) Sample {
+        std.debug.assert(i < self.out_len);
+        return Sample{
+            .window_id = self.out_ids[i],
+            .channels = self.out_channels[i],
+            .x = self.out_x[i],
+            .y = self.out_y[i],
+            .width = @intCast(self.out_w[i]),
+            .height = @intCast(self.out_h[i]),
+            .opacity = self.out_o[i],
+            .done = self.out_done[i],
+        };
     }
 
     // Clear all animations.
     pub fn clear_all(self: *AnimationManager) void {
-        var i: u32 = 0;
-        while (i < self.animations_len) : (i += 1) {
-            self.animations[i].active = false;
+        var row: u32 = 0;
+        while (row < self.animations_len) : (row += 1) {
+            self.clear_row(row);
         }
+        self.rows.clear();
         self.animations_len = 0;
     }
 
@@ -250,5 +412,87 @@ pub const AnimationManager = struct {
     pub fn get_count(self: *const AnimationManager) u32 {
         return self.animations_len;
     }
+
+    fn row_of(self: *const AnimationManager, window_id: u32) ?u32 {
+        return self.rows.get(window_id);
+    }
+
+    // Neutral row: finite values, non-zero duration (safe vector lanes).
+    fn clear_row(self: *AnimationManager, row: u32) void {
+        self.window_ids[row] = EMPTY_ID;
+        self.anim_types[row] = .none;
+        self.easing_codes[row] = @intFromEnum(Easing.linear);
+        self.channel_masks[row] = 0;
+        self.start_times[row] = 0;
+        self.durations[row] = ANIMATION_DURATION_MS;
+        self.start_x[row] = 0;
+        self.start_y[row] = 0;
+        self.start_w[row] = 0;
+        self.start_h[row] = 0;
+        self.start_o[row] = 0;
+        self.delta_x[row] = 0;
+        self.delta_y[row] = 0;
+        self.delta_w[row] = 0;
+        self.delta_h[row] = 0;
+        self.delta_o[row] = 0;
+    }
+
+    fn copy_row(self: *AnimationManager, dst: u32, src: u32) void {
+        self.window_ids[dst] = self.window_ids[src];
+        self.anim_types[dst] = self.anim_types[src];
+        self.easing_codes[dst] = self.easing_codes[src];
+        self.channel_masks[dst] = self.channel_masks[src];
+        self.start_times[dst] = self.start_times[src];
+        self.durations[dst] = self.durations[src];
+        self.start_x[dst] = self.start_x[src];
+        self.start_y[dst] = self.start_y[src];
+        self.start_w[dst] = self.start_w[src];
+        self.start_h[dst] = self.start_h[src];
+        self.start_o[dst] = self.start_o[src];
+        self.delta_x[dst] = self.delta_x[src];
+        self.delta_y[dst] = self.delta_y[src];
+        self.delta_w[dst] = self.delta_w[src];
+        self.delta_h[dst] = self.delta_h[src];
+        self.delta_o[dst] = self.delta_o[src];
+    }
 };
 
+fn lane(values: *const [MAX_ANIMATIONS]f32, base: u32) FloatVec {
+    return values[base..][0..LANES].*;
+}
+
+// Scalar easing (same curves as ease_vector).
+pub fn ease(easing: Easing, t: f32) f32 {
+    const inv = 1.0 - t;
+    return switch (easing) {
+        .linear => t,
+        .ease_in_quad => t * t,
+        .ease_out_quad => 1.0 - inv * inv,
+        .ease_out_cubic => 1.0 - inv * inv * inv,
+        .ease_in_out_cubic => if (t < 0.5)
+            4.0 * t * t * t
+        else
+            1.0 - 4.0 * inv * inv * inv,
+    };
+}
+
+// Every curve evaluated per lane, each lane picks its own.
+// Why: Branch-free; five polynomials cost less than per-lane dispatch.
+fn ease_vector(t: FloatVec, codes: CodeVec) FloatVec {
+    const one: FloatVec = @splat(1.0);
+    const half: FloatVec = @splat(0.5);
+    const four: FloatVec = @splat(4.0);
+    const inv = one - t;
+    const inv_cubed = inv * inv * inv;
+    const in_out = @select(f32, t < half, four * t * t * t, one - four * inv_cubed);
+    var result = t;
+    result = @select(f32, codes == code_splat(.ease_in_quad), t * t, result);
+    result = @select(f32, codes == code_splat(.ease_out_quad), one - inv * inv, result);
+    result = @select(f32, codes == code_splat(.ease_out_cubic), one - inv_cubed, result);
+    result = @select(f32, codes == code_splat(.ease_in_out_cubic), in_out, result);
+    return result;
+}
+
+fn code_splat(easing: Easing) CodeVec {
+    return @splat(@intFromEnum(easing));
+}
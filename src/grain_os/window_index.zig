@@ -0,0 +1,258 @@
+//! Grain OS Window Index: id→slot lookup and spatial hit-testing.
+//!
+//! Why: Every compositor operation resolves a window id, and every mouse
+//! event hit-tests the cursor; linear scans of the window array made both
+//! O(windows) and hit-testing ignored stacking order.
+//! Architecture: Bounded id map (id → entry), per-entry compositor
+//! slot, rect, and stacking rank, plus a coarse grid of per-cell entry
+//! bitsets. Hit-testing visits only entries whose rect overlaps the
+//! cursor's cell and returns the highest-ranked one that contains it.
+//! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
+
+const std = @import("std");
+const bounded_map = @import("bounded_map.zig");
+
+// Bounded: Max indexed windows (matches compositor MAX_WINDOWS).
+pub const MAX_INDEXED_WINDOWS: u32 = 256;
+
+// Grid cell edge in pixels.
+pub const GRID_CELL_SIZE: u32 = 64;
+
+// Grid dimensions (cover 1024x768; points beyond clamp to edge cells).
+pub const GRID_COLUMNS: u32 = 16;
+pub const GRID_ROWS: u32 = 12;
+
+const GRID_CELLS: u32 = GRID_COLUMNS * GRID_ROWS;
+const ENTRY_WORDS: u32 = MAX_INDEXED_WINDOWS / 64;
+
+// Inclusive cell range covered by a rect.
+const CellRange = struct {
+    col0: u8,
+    row0: u8,
+    col1: u8,
+    row1: u8,
+};
+
+// Indexed window entry.
+const Entry = struct {
+    id: u32,
+    slot: u32,
+    x: i32,
+    y: i32,
+    width: u32,
+    height: u32,
+    rank: u32,
+    cells: ?CellRange,
+};
+
+// Window index: id table, entry pool, and spatial grid.
+pub const WindowIndex = struct {
+    ids: bounded_map.BoundedMap(MAX_INDEXED_WINDOWS), // window id → entry
+    entries: [MAX_INDEXED_WINDOWS]Entry,
+    free_entries: [MAX_INDEXED_WINDOWS]u16,
+    free_len: u32,
+    entries_len: u32,
+    cells: [GRID_CELLS][ENTRY_WORDS]u64,
+
+    pub fn init() WindowIndex {
+        var index = WindowIndex{
+            .ids = bounded_map.BoundedMap(MAX_INDEXED_WINDOWS).init(),
+            .entries = undefined,
+            .free_entries = undefined,
+            .free_len = MAX_INDEXED_WINDOWS,
+            .entries_len = 0,
+            .cells = [_][ENTRY_WORDS]u64{[_]u64{0} ** ENTRY_WORDS} ** GRID_CELLS,
+        };
+        // Free list pops from the end: hand out entry 0 first.
+        var i: u32 = 0;
+        while (i < MAX_INDEXED_WINDOWS) : (i += 1) {
+            index.free_entries[i] = @intCast(MAX_INDEXED_WINDOWS - 1 - i);
+        }
+        std.debug.assert(index.entries_len == 0);
+        return index;
+    }
+
+    // Index a new window at compositor slot (no rect until update_rect).
+    pub fn insert(self: *WindowIndex, window_id: u32, slot: u32) bool {
+        std.debug.assert(window_id > 0);
+        std.debug.assert(slot < MAX_INDEXED_WINDOWS);
+        if (self.find_entry(window_id) != null) {
+            return false;
+        }
+        if (self.free_len == 0) {
+            return false;
+        }
+        self.free_len -= 1;
+        const entry_index = self.free_entries[self.free_len];
+        self.entries[entry_index] = Entry{
+            .id = window_id,
+            .slot = slot,
+            .x = 0,
+            .y = 0,
+            .width = 0,
+            .height = 0,
+            .rank = 0,
+            .cells = null,
+        };
+        const indexed = self.ids.put(window_id, entry_index);
+        std.debug.assert(indexed);
+        self.entries_len += 1;
+        std.debug.assert(self.entries_len + self.free_len == MAX_INDEXED_WINDOWS);
+        return true;
+    }
+
+    // Drop a window from the id table and grid.
+    pub fn remove(self: *WindowIndex, window_id: u32) bool {
+        std.debug.assert(window_id > 0);
+        const entry_index: u16 = @intCast(self.ids.remove(window_id) orelse return false);
+        self.clear_cells(entry_index);
+        self.free_entries[self.free_len] = entry_index;
+        self.free_len += 1;
+        self.entries_len -= 1;
+        std.debug.assert(self.entries_len + self.free_len == MAX_INDEXED_WINDOWS);
+        return true;
+    }
+
+    // Compositor slot holding window_id.
+    pub fn slot_of(self: *const WindowIndex, window_id: u32) ?u32 {
+        const entry_index = self.find_entry(window_id) orelse return null;
+        return self.entries[entry_index].slot;
+    }
+
+    // Record that window_id moved to a new compositor slot.
+    pub fn set_slot(self: *WindowIndex, window_id: u32, slot: u32) void {
+        std.debug.assert(slot < MAX_INDEXED_WINDOWS);
+        if (self.find_entry(window_id)) |entry_index| {
+            self.entries[entry_index].slot = slot;
+        }
+    }
+
+    // Record window geometry; grid bits change only if the cell range does.
+    pub fn update_rect(
+        self: *WindowIndex,
+        window_id: u32,
+        x: i32,
+        y: i32,
+        width: u32,
+        height: u32,
+    ) void {
+        const entry_index = self.find_entry(window_id) orelse return;
+        const entry = &self.entries[entry_index];
+        entry.x = x;
+        entry.y = y;
+        entry.width = width;
+        entry.height = height;
+        const range = cell_range(x, y, width, height);
+        if (std.meta.eql(range, entry.cells)) {
+            return;
+        }
+        self.clear_cells(entry_index);
+        if (range) |r| {
+            self.set_cells(entry_index, r, true);
+        }
+        entry.cells = range;
+    }
+
+    // Set stacking ranks from a bottom-to-top id list.
+    pub fn set_stack_order(self: *WindowIndex, window_ids: []const u32) void {
+        std.debug.assert(window_ids.len <= MAX_INDEXED_WINDOWS);
+        var i: u32 = 0;
+        while (i < window_ids.len) : (i += 1) {
+            if (self.find_entry(window_ids[i])) |entry_index| {
+                self.entries[entry_index].rank = i + 1;
+            }
+        }
+    }
+
+    // Topmost window containing (x, y) that accept() allows.
+    // Contract: accept(context, slot) filters hidden/minimized windows.
+    pub fn hit_test(
+        self: *const WindowIndex,
+        x: u32,
+        y: u32,
+        context: anytype,
+        comptime accept: fn (@TypeOf(context), u32) bool,
+    ) ?u32 {
+        const col = @min(x / GRID_CELL_SIZE, GRID_COLUMNS - 1);
+        const row = @min(y / GRID_CELL_SIZE, GRID_ROWS - 1);
+        const cell = &self.cells[row * GRID_COLUMNS + col];
+        var best_id: ?u32 = null;
+        var best_rank: u32 = 0;
+        var word: u32 = 0;
+        while (word < ENTRY_WORDS) : (word += 1) {
+            var bits = cell[word];
+            while (bits != 0) {
+                const bit: u32 = @ctz(bits);
+                bits &= bits - 1;
+                const entry = &self.entries[word * 64 + bit];
+                if (best_id != null and entry.rank <= best_rank) continue;
+                if (!rect_contains(entry, x, y)) continue;
+                if (!accept(context, entry.slot)) continue;
+                best_id = entry.id;
+                best_rank = entry.rank;
+            }
+        }
+        return best_id;
+    }
+
+    // Number of indexed windows.
+    pub fn get_count(self: *const WindowIndex) u32 {
+        return self.entries_len;
+    }
+
+    fn find_entry(self: *const WindowIndex, window_id: u32) ?u16 {
+        const entry_index = self.ids.get(window_id) orelse return null;
+        return @intCast(entry_index);
+    }
+
+    fn clear_cells(self: *WindowIndex, entry_index: u16) void {
+        if (self.entries[entry_index].cells) |r| {
+            self.set_cells(entry_index, r, false);
+        }
+        self.entries[entry_index].cells = null;
+    }
+
+    fn set_cells(self: *WindowIndex, entry_index: u16, range: CellRange, value: bool) void {
+        const word = entry_index / 64;
+        const mask = @as(u64, 1) << @intCast(entry_index % 64);
+        var row: u32 = range.row0;
+        while (row <= range.row1) : (row += 1) {
+            var col: u32 = range.col0;
+            while (col <= range.col1) : (col += 1) {
+                const cell = &self.cells[row * GRID_COLUMNS + col];
+                if (value) {
+                    cell[word] |= mask;
+                } else {
+                    cell[word] &= ~mask;
+                }
+            }
+        }
+    }
+};
+
+fn rect_contains(entry: *const Entry, x: u32, y: u32) bool {
+    const px = @as(i64, x);
+    const py = @as(i64, y);
+    return px >= entry.x and px < @as(i64, entry.x) + entry.width and
+        py >= entry.y and py < @as(i64, entry.y) + entry.height;
+}
+
+// Grid cells overlapped by a rect (null if empty or fully off-grid).
+fn cell_range(x: i32, y: i32, width: u32, height: u32) ?CellRange {
+    if (width == 0 or height == 0) return null;
+    const right = @as(i64, x) + width - 1;
+    const bottom = @as(i64, y) + height - 1;
+    if (right < 0 or bottom < 0) return null;
+    return CellRange{
+        .col0 = clamp_cell(x, GRID_COLUMNS),
+        .row0 = clamp_cell(y, GRID_ROWS),
+        .col1 = clamp_cell(right, GRID_COLUMNS),
+        .row1 = clamp_cell(bottom, GRID_ROWS),
+    };
+}
+
+fn clamp_cell(coord: i64, cells: u32) u8 {
+    if (coord <= 0) return 0;
+    const cell = @as(u64, @intCast(coord)) / GRID_CELL_SIZE;
+    return @intCast(@min(cell, cells - 1));
+}
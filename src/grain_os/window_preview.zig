@@ -1,12 +1,15 @@
 //! Grain OS Window Preview: Thumbnail generation for windows.
 //!
 //! Why: Provide visual previews of windows for switching and taskbar.
-//! Architecture: Window thumbnail generation and caching.
+//! Architecture: Window thumbnail generation and caching. Thumbnails are
+//! box-filtered from window pixels (client buffer or screen) and only
+//! recaptured after damage, a few per frame under a sampling budget.
 //! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
 
 const std = @import("std");
 const compositor = @import("compositor.zig");
 const framebuffer_renderer = @import("framebuffer_renderer.zig");
+const fb_primitives = @import("framebuffer_primitives");
 
 // Bounded: Max preview cache size.
 pub const MAX_PREVIEW_CACHE: u32 = 256;
@@ -15,6 +18,37 @@ pub const MAX_PREVIEW_CACHE: u32 = 256;
 pub const PREVIEW_WIDTH: u32 = 160;
 pub const PREVIEW_HEIGHT: u32 = 90;
 
+// Bounded: Max source taps per axis per thumbnail pixel (box filter).
+// Why: A 4x4 box caps cost at 16 taps per pixel whatever the window size.
+pub const MAX_TAPS_PER_AXIS: u32 = 4;
+
+// Bounded: Source taps sampled per refresh call (per-frame time budget).
+// Why: Roughly two full-cost thumbnails per frame; a damaged overview of
+// 256 windows converges over frames instead of stalling one.
+pub const REFRESH_TAP_BUDGET: u32 = 2 * PREVIEW_WIDTH * PREVIEW_HEIGHT *
+    MAX_TAPS_PER_AXIS * MAX_TAPS_PER_AXIS;
+
+// Fallback fill when no pixels are available to sample.
+const PREVIEW_FALLBACK_COLOR: u32 = 0xFFCCCCCC;
+
+// Source surface type (shared framebuffer primitives).
+pub const Surface = fb_primitives.Surface;
+
+// Pixels to capture a preview from (rect already clipped to surface).
+pub const PreviewSource = struct {
+    surface: fb_primitives.Surface,
+    rect: fb_primitives.Rect,
+    swap_red_blue: bool = false, // Bytes are B,G,R,A (argb/xrgb client buffers).
+    force_opaque: bool = false, // Alpha byte undefined (x* formats).
+};
+
+// What a preview is recaptured from.
+pub const Capture = union(enum) {
+    pixels: PreviewSource,
+    fallback, // Nothing to show: fill with the fallback color.
+    keep, // Pixels hidden for now: keep the last capture, retry later.
+};
+
 // Preview entry: cached window thumbnail.
 pub const WindowPreview = struct {
     window_id: u32,
@@ -22,6 +56,7 @@ pub const WindowPreview = struct {
     height: u32,
     pixels: [PREVIEW_WIDTH * PREVIEW_HEIGHT]u32,
     valid: bool,
+    dirty: bool, // Content damaged since last capture.
     timestamp: u64, // Last update timestamp.
 
     pub fn init(window_id: u32) WindowPreview {
@@ -32,6 +67,7 @@ pub const WindowPreview = struct {
             .height = PREVIEW_HEIGHT,
             .pixels = undefined,
             .valid = false,
+            .dirty = true,
             .timestamp = 0,
         };
         var i: u32 = 0;
@@ -44,6 +80,7 @@ pub const WindowPreview = struct {
     // Clear preview (mark invalid).
     pub fn clear(self: *WindowPreview) void {
         self.valid = false;
+        self.dirty = true;
         self.timestamp = 0;
     }
 };
@@ -52,11 +89,17 @@ pub const WindowPreview = struct {
 pub const PreviewManager = struct {
     previews: [MAX_PREVIEW_CACHE]WindowPreview,
     previews_len: u32,
+    screen: ?fb_primitives.Surface, // Screen pixels for generate_preview.
+    refresh_cursor: u32, // Round-robin start for refresh_dirty.
+    now: u64, // Timestamp stamped on captures.
 
     pub fn init() PreviewManager {
         var manager = PreviewManager{
             .previews = undefined,
             .previews_len = 0,
+            .screen = null,
+            .refresh_cursor = 0,
+            .now = 0,
         };
         var i: u32 = 0;
         while (i < MAX_PREVIEW_CACHE) : (i += 1) {
@@ -118,42 +161,126 @@ pub const PreviewManager = struct {
         self.previews_len = 0;
     }
 
-    // Generate preview from window (downscaled thumbnail).
+    // Attach the screen surface that generate_preview samples from.
+    pub fn set_screen_source(self: *PreviewManager, screen: fb_primitives.Surface) void {
+        self.screen = screen;
+    }
+
+    // Mark a window's preview stale (content or geometry changed).
+    pub fn mark_damaged(self: *PreviewManager, window_id: u32) void {
+        std.debug.assert(window_id > 0);
+        var i: u32 = 0;
+        while (i < self.previews_len) : (i += 1) {
+            if (self.previews[i].window_id == window_id) {
+                self.previews[i].dirty = true;
+                return;
+            }
+        }
+    }
+
+    // Generate preview from window (downscaled thumbnail of the screen rect).
     pub fn generate_preview(
         self: *PreviewManager,
         window_id: u32,
-        _win_x: i32,
-        _win_y: i32,
-        _win_width: u32,
-        _win_height: u32,
-        _screen_width: u32,
-        _screen_height: u32,
+        win_x: i32,
+        win_y: i32,
+        win_width: u32,
+        win_height: u32,
+        screen_width: u32,
+        screen_height: u32,
     ) bool {
         std.debug.assert(window_id > 0);
-        // Discard unused parameters (for future framebuffer sampling).
-        _ = _win_x;
-        _ = _win_y;
-        _ = _win_width;
-        _ = _win_height;
-        _ = _screen_width;
-        _ = _screen_height;
-        if (self.get_preview(window_id)) |preview| {
-            // Generate downscaled preview (simplified: solid color for now).
-            // In full implementation, would sample from framebuffer.
-            const bg_color: u32 = 0xFFCCCCCC; // Light gray.
-            var y: u32 = 0;
-            while (y < PREVIEW_HEIGHT) : (y += 1) {
-                var x: u32 = 0;
-                while (x < PREVIEW_WIDTH) : (x += 1) {
-                    const idx = y * PREVIEW_WIDTH + x;
-                    preview.pixels[idx] = bg_color;
-                }
+        const preview = self.get_preview(window_id) orelse return false;
+        const source: Capture = blk: {
+            const screen = self.screen orelse break :blk .fallback;
+            const rect = fb_primitives.clip_rect(
+                @min(screen_width, screen.width),
+                @min(screen_height, screen.height),
+                win_x,
+                win_y,
+                win_width,
+                win_height,
+            ) orelse break :blk .fallback;
+            break :blk .{ .pixels = PreviewSource{ .surface = screen, .rect = rect } };
+        };
+        _ = self.capture(preview, source);
+        return true;
+    }
+
+    // Generate preview from explicit pixels, fallback fill, or kept capture.
+    pub fn generate_preview_from(
+        self: *PreviewManager,
+        window_id: u32,
+        source: Capture,
+    ) bool {
+        std.debug.assert(window_id > 0);
+        const preview = self.get_preview(window_id) orelse return false;
+        _ = self.capture(preview, source);
+        return true;
+    }
+
+    // Recapture dirty previews, round-robin, until the tap budget is spent.
+    // Contract: source_of(context, window_id) returns what to capture from
+    // (see Capture). At least one dirty preview is refreshed per call so
+    // progress is guaranteed; kept previews stay dirty for a later call.
+    // Returns: number of previews refreshed.
+    pub fn refresh_dirty(
+        self: *PreviewManager,
+        context: anytype,
+        comptime source_of: fn (@TypeOf(context), u32) Capture,
+        now: u64,
+        tap_budget: u32,
+    ) u32 {
+        self.now = now;
+        if (self.previews_len == 0) return 0;
+        var spent: u64 = 0;
+        var refreshed: u32 = 0;
+        var visited: u32 = 0;
+        while (visited < self.previews_len) : (visited += 1) {
+            const index = (self.refresh_cursor + visited) % self.previews_len;
+            const preview = &self.previews[index];
+            if (!preview.dirty) continue;
+            const source = source_of(context, preview.window_id);
+            if (source == .keep and preview.valid) continue;
+            const cost: u64 = switch (source) {
+                .pixels => |src| capture_cost(src.rect),
+                .fallback, .keep => 0,
+            };
+            if (refreshed > 0 and spent + cost > tap_budget) {
+                // Resume here next frame.
+                self.refresh_cursor = index;
+                return refreshed;
             }
-            preview.valid = true;
-            preview.timestamp = 0; // Would use actual timestamp in full impl.
-            return true;
+            spent += self.capture(preview, source);
+            refreshed += 1;
+        }
+        self.refresh_cursor = 0;
+        return refreshed;
+    }
+
+    // Number of previews awaiting recapture.
+    pub fn get_dirty_count(self: *const PreviewManager) u32 {
+        var count: u32 = 0;
+        var i: u32 = 0;
+        while (i < self.previews_len) : (i += 1) {
+            if (self.previews[i].dirty) count += 1;
+        }
+        return count;
+    }
+
+    // Fill preview from source (or fallback color). A kept preview with no
+    // earlier capture gets the fallback. Returns taps sampled.
+    fn capture(self: *PreviewManager, preview: *WindowPreview, source: Capture) u64 {
+        var taps: u64 = 0;
+        switch (source) {
+            .pixels => |src| taps = downsample_box(&preview.pixels, src),
+            .keep => if (!preview.valid) @memset(&preview.pixels, PREVIEW_FALLBACK_COLOR),
+            .fallback => @memset(&preview.pixels, PREVIEW_FALLBACK_COLOR),
         }
-        return false;
+        preview.valid = true;
+        preview.dirty = false;
+        preview.timestamp = self.now;
+        return taps;
     }
 
     // Get preview count.
@@ -162,3 +289,64 @@ pub const PreviewManager = struct {
     }
 };
 
+// Taps per axis for a source span mapped onto dst_len thumbnail pixels.
+fn taps_for(src_len: u32, dst_len: u32) u32 {
+    const box = (src_len + dst_len - 1) / dst_len;
+    return std.math.clamp(box, 1, MAX_TAPS_PER_AXIS);
+}
+
+// Source taps a capture of rect will sample.
+fn capture_cost(rect: fb_primitives.Rect) u64 {
+    const taps = taps_for(rect.width, PREVIEW_WIDTH) * taps_for(rect.height, PREVIEW_HEIGHT);
+    return @as(u64, PREVIEW_WIDTH) * PREVIEW_HEIGHT * taps;
+}
+
+// Box-filter source rect down (or up) to the thumbnail.
+// Why: Channels are averaged as one 4-lane vector per tap; taps are spread
+// evenly over each thumbnail pixel's source box (at most 4x4). Client
+// buffers in B,G,R,A order are swizzled and x* alpha forced opaque here.
+// Returns: taps sampled.
+fn downsample_box(
+    pixels: *[PREVIEW_WIDTH * PREVIEW_HEIGHT]u32,
+    source: PreviewSource,
+) u64 {
+    const rect = source.rect;
+    const surface = source.surface;
+    std.debug.assert(rect.width > 0 and rect.height > 0);
+    std.debug.assert(rect.x + rect.width <= surface.width);
+    std.debug.assert(rect.y + rect.height <= surface.height);
+    const taps_x = taps_for(rect.width, PREVIEW_WIDTH);
+    const taps_y = taps_for(rect.height, PREVIEW_HEIGHT);
+    const count: @Vector(4, u32) = @splat(taps_x * taps_y);
+    var dy: u32 = 0;
+    while (dy < PREVIEW_HEIGHT) : (dy += 1) {
+        // Source box rows [sy0, sy0 + box_h).
+        const sy0 = rect.y + dy * rect.height / PREVIEW_HEIGHT;
+        const box_h = @max((dy + 1) * rect.height / PREVIEW_HEIGHT + rect.y - sy0, 1);
+        var dx: u32 = 0;
+        while (dx < PREVIEW_WIDTH) : (dx += 1) {
+            const sx0 = rect.x + dx * rect.width / PREVIEW_WIDTH;
+            const box_w = @max((dx + 1) * rect.width / PREVIEW_WIDTH + rect.x - sx0, 1);
+            var acc: @Vector(4, u32) = @splat(0);
+            var ty: u32 = 0;
+            while (ty < taps_y) : (ty += 1) {
+                const sy = @min(sy0 + ty * box_h / taps_y, surface.height - 1);
+                const row_offset = @as(usize, sy) * surface.stride;
+                var tx: u32 = 0;
+                while (tx < taps_x) : (tx += 1) {
+                    const sx = @min(sx0 + tx * box_w / taps_x, surface.width - 1);
+                    const offset = row_offset + @as(usize, sx) * fb_primitives.BYTES_PER_PIXEL;
+                    const texel: @Vector(4, u8) = surface.memory[offset..][0..4].*;
+                    acc += @as(@Vector(4, u32), @intCast(texel));
+                }
+            }
+            const avg: [4]u32 = acc / count;
+            const red = if (source.swap_red_blue) avg[2] else avg[0];
+            const blue = if (source.swap_red_blue) avg[0] else avg[2];
+            const alpha: u32 = if (source.force_opaque) 0xFF else avg[3];
+            // Pack as 0xRRGGBBAA (renderer color order).
+            pixels[dy * PREVIEW_WIDTH + dx] = (red << 24) | (avg[1] << 16) | (blue << 8) | alpha;
+        }
+    }
+    return @as(u64, PREVIEW_WIDTH) * PREVIEW_HEIGHT * taps_x * taps_y;
+}
@@ -1,7 +1,12 @@
 //! Grain OS Window Rules: Automatic window configuration based on properties.
 //!
 //! Why: Allow windows to be automatically configured based on title, class, etc.
-//! Architecture: Rule matching and application system.
+//! Architecture: Rules are compiled into one Aho-Corasick automaton over
+//! their literal patterns (glob rules contribute their longest literal run
+//! and are verified on a hit), so one pass over a title finds every
+//! matching rule. Compilation is lazy (after rule changes) and sizes the
+//! automaton from the pattern bytes actually in use; the compositor
+//! matches on window create and title change and caches the result.
 //! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
 
 const std = @import("std");
@@ -9,11 +14,26 @@ const compositor = @import("compositor.zig");
 const window_constraints = @import("window_constraints.zig");
 
 // Bounded: Max window rules.
-pub const MAX_RULES: u32 = 64;
+pub const MAX_RULES: u32 = 4096;
 
 // Bounded: Max rule pattern length.
 pub const MAX_PATTERN_LEN: u32 = 256;
 
+// Bounded: Total pattern bytes across all rules (shared pool).
+pub const MAX_PATTERN_BYTES: u32 = 64 * 1024;
+
+// Bounded: Automaton states (root plus at most one per pattern byte).
+pub const MAX_STATES: u32 = MAX_PATTERN_BYTES + 1;
+
+// Per-state link arrays carved from one allocation.
+const LINK_ARRAYS: u32 = 6;
+
+// Sentinel for "no state" / "no rule".
+const NONE: u32 = std.math.maxInt(u32);
+
+// Root state of the automaton.
+const ROOT: u32 = 0;
+
 // Rule match type.
 pub const MatchType = enum(u8) {
     title,
@@ -34,11 +54,14 @@ pub const ActionType = enum(u8) {
 };
 
 // Window rule: matches windows and applies actions.
+// Patterns without '*' or '?' match as substrings; glob patterns match
+// the whole text ('*' = any run, '?' = any one byte).
 pub const WindowRule = struct {
     rule_id: u32,
     match_type: MatchType,
-    pattern: [MAX_PATTERN_LEN]u8,
+    pattern_start: u32, // Offset into the manager's pattern pool
     pattern_len: u32,
+    is_glob: bool,
     action_type: ActionType,
     action_value_x: i32,
     action_value_y: i32,
@@ -49,40 +72,176 @@ pub const WindowRule = struct {
     active: bool,
 };
 
+// Multi-pattern automaton over rule key literals.
+// Why: Trie edges are first-child/next-sibling lists (states are bounded by
+// pattern bytes, not bytes x 256); the root keeps a dense table because
+// most bytes of a title restart there. State arrays are allocated for the
+// keys being compiled (grown, never shrunk), not for MAX_STATES.
+pub const RuleAutomaton = struct {
+    labels: []u8, // Byte on the edge into each state
+    links: []u32, // Backing for the per-state arrays below
+    first_child: []u32,
+    next_sibling: []u32,
+    fail: []u32, // Longest proper suffix that is a trie state
+    out_head: []u32, // First rule whose key ends here
+    out_link: []u32, // Nearest fail-chain state with rules
+    queue: []u32, // BFS scratch for failure links
+    root_next: [256]u32,
+    states_len: u32,
+    rule_next: [MAX_RULES]u32, // Next rule sharing the same key state
+    always: [MAX_RULES]u32, // Glob rules without a literal (verified on every query)
+    always_len: u32,
+
+    fn init() RuleAutomaton {
+        return RuleAutomaton{
+            .labels = &.{},
+            .links = &.{},
+            .first_child = &.{},
+            .next_sibling = &.{},
+            .fail = &.{},
+            .out_head = &.{},
+            .out_link = &.{},
+            .queue = &.{},
+            .root_next = undefined,
+            .states_len = 0,
+            .rule_next = undefined,
+            .always = undefined,
+            .always_len = 0,
+        };
+    }
+
+    fn deinit(self: *RuleAutomaton, allocator: std.mem.Allocator) void {
+        allocator.free(self.labels);
+        allocator.free(self.links);
+        self.* = RuleAutomaton.init();
+    }
+
+    // Make room for states states (root included); contents are not kept.
+    fn ensure_capacity(self: *RuleAutomaton, allocator: std.mem.Allocator, states: u32) !void {
+        std.debug.assert(states > 0 and states <= MAX_STATES);
+        if (states <= self.labels.len) return;
+        const capacity = @min(@max(states, @as(u32, @intCast(self.labels.len)) * 2), MAX_STATES);
+        const labels = try allocator.alloc(u8, capacity);
+        errdefer allocator.free(labels);
+        const links = try allocator.alloc(u32, @as(usize, capacity) * LINK_ARRAYS);
+        self.deinit(allocator);
+        self.labels = labels;
+        self.links = links;
+        self.first_child = links[0 * capacity ..][0..capacity];
+        self.next_sibling = links[1 * capacity ..][0..capacity];
+        self.fail = links[2 * capacity ..][0..capacity];
+        self.out_head = links[3 * capacity ..][0..capacity];
+        self.out_link = links[4 * capacity ..][0..capacity];
+        self.queue = links[5 * capacity ..][0..capacity];
+    }
+
+    fn reset(self: *RuleAutomaton) void {
+        std.debug.assert(self.labels.len > 0);
+        self.states_len = 1;
+        self.first_child[ROOT] = NONE;
+        self.next_sibling[ROOT] = NONE;
+        self.fail[ROOT] = ROOT;
+        self.out_head[ROOT] = NONE;
+        self.out_link[ROOT] = NONE;
+        self.root_next = [_]u32{NONE} ** 256;
+        self.always_len = 0;
+    }
+
+    fn child(self: *const RuleAutomaton, state: u32, byte: u8) u32 {
+        if (state == ROOT) return self.root_next[byte];
+        var c = self.first_child[state];
+        while (c != NONE) : (c = self.next_sibling[c]) {
+            if (self.labels[c] == byte) return c;
+        }
+        return NONE;
+    }
+
+    // Insert a key literal; returns its final state.
+    fn insert(self: *RuleAutomaton, key: []const u8) u32 {
+        std.debug.assert(key.len > 0);
+        var state: u32 = ROOT;
+        for (key) |byte| {
+            const next = self.child(state, byte);
+            if (next != NONE) {
+                state = next;
+                continue;
+            }
+            std.debug.assert(self.states_len < self.labels.len);
+            const s = self.states_len;
+            self.states_len += 1;
+            self.labels[s] = byte;
+            self.first_child[s] = NONE;
+            self.next_sibling[s] = self.first_child[state];
+            self.first_child[state] = s;
+            self.out_head[s] = NONE;
+            if (state == ROOT) self.root_next[byte] = s;
+            state = s;
+        }
+        return state;
+    }
+
+    // Breadth-first failure and output links.
+    fn link(self: *RuleAutomaton) void {
+        var head: u32 = 0;
+        var tail: u32 = 0;
+        var c = self.first_child[ROOT];
+        while (c != NONE) : (c = self.next_sibling[c]) {
+            self.fail[c] = ROOT;
+            self.out_link[c] = NONE;
+            self.queue[tail] = c;
+            tail += 1;
+        }
+        while (head < tail) {
+            const state = self.queue[head];
+            head += 1;
+            c = self.first_child[state];
+            while (c != NONE) : (c = self.next_sibling[c]) {
+                const byte = self.labels[c];
+                var f = self.fail[state];
+                while (f != ROOT and self.child(f, byte) == NONE) f = self.fail[f];
+                const target = self.child(f, byte);
+                self.fail[c] = if (target != NONE and target != c) target else ROOT;
+                const fs = self.fail[c];
+                self.out_link[c] = if (self.out_head[fs] != NONE) fs else self.out_link[fs];
+                self.queue[tail] = c;
+                tail += 1;
+            }
+        }
+        std.debug.assert(tail + 1 == self.states_len);
+    }
+};
+
 // Window rule manager: manages window rules.
 pub const WindowRuleManager = struct {
+    allocator: std.mem.Allocator,
     rules: [MAX_RULES]WindowRule,
     rules_len: u32,
     next_rule_id: u32,
+    patterns: [MAX_PATTERN_BYTES]u8,
+    patterns_len: u32,
+    automaton: RuleAutomaton,
+    compiled: bool,
+    // Bumped on every rule change; windows cache matches per generation.
+    generation: u32,
 
-    pub fn init() WindowRuleManager {
-        var manager = WindowRuleManager{
+    pub fn init(allocator: std.mem.Allocator) WindowRuleManager {
+        // Slots past rules_len/patterns_len/states_len are never read.
+        return WindowRuleManager{
+            .allocator = allocator,
             .rules = undefined,
             .rules_len = 0,
             .next_rule_id = 1,
+            .patterns = undefined,
+            .patterns_len = 0,
+            .automaton = RuleAutomaton.init(),
+            .compiled = false,
+            .generation = 1,
         };
-        var i: u32 = 0;
-        while (i < MAX_RULES) : (i += 1) {
-            manager.rules[i] = WindowRule{
-                .rule_id = 0,
-                .match_type = MatchType.title,
-                .pattern = undefined,
-                .pattern_len = 0,
-                .action_type = ActionType.none,
-                .action_value_x = 0,
-                .action_value_y = 0,
-                .action_value_width = 0,
-                .action_value_height = 0,
-                .action_value_u32 = 0,
-                .action_value_u8 = 0,
-                .active = false,
-            };
-            var j: u32 = 0;
-            while (j < MAX_PATTERN_LEN) : (j += 1) {
-                manager.rules[i].pattern[j] = 0;
-            }
-        }
-        return manager;
+    }
+
+    pub fn deinit(self: *WindowRuleManager) void {
+        self.automaton.deinit(self.allocator);
+        self.compiled = false;
     }
 
     // Add window rule.
@@ -98,13 +257,20 @@ pub const WindowRuleManager = struct {
         if (pattern.len > MAX_PATTERN_LEN) {
             return null;
         }
+        if (self.patterns_len + pattern.len > MAX_PATTERN_BYTES) {
+            return null;
+        }
         const rule_id = self.next_rule_id;
         self.next_rule_id += 1;
-        var rule = WindowRule{
+        const start = self.patterns_len;
+        @memcpy(self.patterns[start..][0..pattern.len], pattern);
+        self.patterns_len += @intCast(pattern.len);
+        self.rules[self.rules_len] = WindowRule{
             .rule_id = rule_id,
             .match_type = match_type,
-            .pattern = undefined,
-            .pattern_len = 0,
+            .pattern_start = start,
+            .pattern_len = @intCast(pattern.len),
+            .is_glob = is_glob_pattern(pattern),
             .action_type = action_type,
             .action_value_x = 0,
             .action_value_y = 0,
@@ -114,69 +280,124 @@ pub const WindowRuleManager = struct {
             .action_value_u8 = 0,
             .active = true,
         };
-        var i: u32 = 0;
-        while (i < MAX_PATTERN_LEN) : (i += 1) {
-            rule.pattern[i] = 0;
-        }
-        const copy_len = @min(pattern.len, MAX_PATTERN_LEN);
-        i = 0;
-        while (i < copy_len) : (i += 1) {
-            rule.pattern[i] = pattern[i];
-        }
-        rule.pattern_len = @intCast(copy_len);
-        self.rules[self.rules_len] = rule;
         self.rules_len += 1;
+        self.mark_changed();
         return rule_id;
     }
 
-    // Match window against rules.
+    // Pattern bytes of a rule.
+    pub fn pattern_of(self: *const WindowRuleManager, rule: *const WindowRule) []const u8 {
+        std.debug.assert(rule.pattern_start + rule.pattern_len <= self.patterns_len);
+        return self.patterns[rule.pattern_start..][0..rule.pattern_len];
+    }
+
+    // Match window title against title rules (first rule in order wins).
     pub fn match_window(
-        self: *const WindowRuleManager,
+        self: *WindowRuleManager,
         window_title: []const u8,
     ) ?*const WindowRule {
-        var i: u32 = 0;
-        while (i < self.rules_len) : (i += 1) {
-            const rule = &self.rules[i];
-            if (!rule.active) {
-                continue;
+        return self.match_text(MatchType.title, window_title);
+    }
+
+    // Match text against rules of one match type (first rule in order wins).
+    pub fn match_text(
+        self: *WindowRuleManager,
+        match_type: MatchType,
+        text: []const u8,
+    ) ?*const WindowRule {
+        const slot = self.match_slot(match_type, text) orelse return null;
+        return &self.rules[slot];
+    }
+
+    // Index of the first matching rule (valid until the rules change).
+    pub fn match_slot(
+        self: *WindowRuleManager,
+        match_type: MatchType,
+        text: []const u8,
+    ) ?u32 {
+        // Why: No rules, no automaton (most compositors never allocate one).
+        if (self.rules_len == 0) return null;
+        self.compile() catch return self.match_scan(match_type, text);
+        const auto = &self.automaton;
+        var best: u32 = NONE;
+        var state: u32 = ROOT;
+        for (text) |byte| {
+            var next = auto.child(state, byte);
+            while (next == NONE and state != ROOT) {
+                state = auto.fail[state];
+                next = auto.child(state, byte);
             }
-            if (rule.match_type == MatchType.title) {
-                if (self.match_pattern(window_title, rule.pattern[0..rule.pattern_len])) {
-                    return rule;
+            state = if (next == NONE) ROOT else next;
+            var out = if (auto.out_head[state] != NONE) state else auto.out_link[state];
+            while (out != NONE) : (out = auto.out_link[out]) {
+                var r = auto.out_head[out];
+                while (r != NONE) : (r = auto.rule_next[r]) {
+                    // Why: Only an earlier rule can improve on the best hit.
+                    if (r < best and self.rule_matches(r, match_type, text)) best = r;
                 }
             }
         }
-        return null;
+        var i: u32 = 0;
+        while (i < auto.always_len) : (i += 1) {
+            const r = auto.always[i];
+            if (r < best and self.rule_matches(r, match_type, text)) best = r;
+        }
+        if (best == NONE) return null;
+        return best;
     }
 
-    // Match pattern against text (simple substring match).
-    fn match_pattern(
-        _self: *const WindowRuleManager,
-        text: []const u8,
-        pattern: []const u8,
-    ) bool {
-        _ = _self;
-        if (pattern.len == 0) {
-            return false;
+    // Rules in order, one at a time (used when the automaton can't be built).
+    fn match_scan(self: *const WindowRuleManager, match_type: MatchType, text: []const u8) ?u32 {
+        var i: u32 = 0;
+        while (i < self.rules_len) : (i += 1) {
+            const rule = &self.rules[i];
+            const pattern = self.pattern_of(rule);
+            if (pattern.len == 0) continue; // Empty patterns never match.
+            if (!rule.is_glob and std.mem.indexOf(u8, text, pattern) == null) continue;
+            if (self.rule_matches(i, match_type, text)) return i;
         }
-        if (pattern.len > text.len) {
-            return false;
+        return null;
+    }
+
+    // Verify a candidate rule (its key literal already occurs in text).
+    fn rule_matches(self: *const WindowRuleManager, index: u32, match_type: MatchType, text: []const u8) bool {
+        const rule = &self.rules[index];
+        if (!rule.active or rule.match_type != match_type) return false;
+        if (!rule.is_glob) return true;
+        return glob_match(text, self.pattern_of(rule));
+    }
+
+    // Build the automaton if rules changed since the last compile.
+    // Errors: OutOfMemory if the state arrays can't grow (rules unchanged).
+    pub fn compile(self: *WindowRuleManager) !void {
+        if (self.compiled) return;
+        const auto = &self.automaton;
+        // States: root plus at most one per key byte.
+        var states: u32 = 1;
+        var k: u32 = 0;
+        while (k < self.rules_len) : (k += 1) {
+            const pattern = self.pattern_of(&self.rules[k]);
+            states += @intCast(if (self.rules[k].is_glob) longest_literal(pattern).len else pattern.len);
         }
+        try auto.ensure_capacity(self.allocator, states);
+        auto.reset();
         var i: u32 = 0;
-        while (i <= text.len - pattern.len) : (i += 1) {
-            var match: bool = true;
-            var j: u32 = 0;
-            while (j < pattern.len) : (j += 1) {
-                if (text[i + j] != pattern[j]) {
-                    match = false;
-                    break;
-                }
-            }
-            if (match) {
-                return true;
+        while (i < self.rules_len) : (i += 1) {
+            const rule = &self.rules[i];
+            const pattern = self.pattern_of(rule);
+            if (pattern.len == 0) continue; // Empty patterns never match.
+            const key = if (rule.is_glob) longest_literal(pattern) else pattern;
+            if (key.len == 0) {
+                auto.always[auto.always_len] = i;
+                auto.always_len += 1;
+                continue;
             }
+            const state = auto.insert(key);
+            auto.rule_next[i] = auto.out_head[state];
+            auto.out_head[state] = i;
         }
-        return false;
+        auto.link();
+        self.compiled = true;
     }
 
     // Remove window rule.
@@ -198,17 +419,97 @@ pub const WindowRuleManager = struct {
             self.rules[i] = self.rules[i + 1];
         }
         self.rules_len -= 1;
+        self.compact_patterns();
+        self.mark_changed();
         return true;
     }
 
     // Clear all rules.
     pub fn clear_all(self: *WindowRuleManager) void {
         self.rules_len = 0;
+        self.patterns_len = 0;
+        self.mark_changed();
     }
 
     // Get rule count.
     pub fn get_rule_count(self: *const WindowRuleManager) u32 {
         return self.rules_len;
     }
+
+    fn mark_changed(self: *WindowRuleManager) void {
+        self.compiled = false;
+        self.generation +%= 1;
+        // Generation 0 is reserved for "never matched".
+        if (self.generation == 0) self.generation = 1;
+    }
+
+    // Close the holes left by removed rules (patterns stay in rule order).
+    fn compact_patterns(self: *WindowRuleManager) void {
+        var write: u32 = 0;
+        var i: u32 = 0;
+        while (i < self.rules_len) : (i += 1) {
+            const rule = &self.rules[i];
+            std.debug.assert(rule.pattern_start >= write);
+            std.mem.copyForwards(
+                u8,
+                self.patterns[write..][0..rule.pattern_len],
+                self.patterns[rule.pattern_start..][0..rule.pattern_len],
+            );
+            rule.pattern_start = write;
+            write += rule.pattern_len;
+        }
+        self.patterns_len = write;
+    }
 };
 
+fn is_glob_pattern(pattern: []const u8) bool {
+    for (pattern) |byte| {
+        if (byte == '*' or byte == '?') return true;
+    }
+    return false;
+}
+
+// Longest run of literal bytes in a glob (empty if it is all wildcards).
+fn longest_literal(pattern: []const u8) []const u8 {
+    var best_start: usize = 0;
+    var best_len: usize = 0;
+    var start: usize = 0;
+    var i: usize = 0;
+    while (i <= pattern.len) : (i += 1) {
+        if (i == pattern.len or pattern[i] == '*' or pattern[i] == '?') {
+            if (i - start > best_len) {
+                best_start = start;
+                best_len = i - start;
+            }
+            start = i + 1;
+        }
+    }
+    return pattern[best_start..][0..best_len];
+}
+
+// Whole-text glob match: '*' matches any run, '?' any one byte.
+// Why: Single backtrack point keeps it linear-ish and allocation-free.
+pub fn glob_match(text: []const u8, pattern: []const u8) bool {
+    var t: usize = 0;
+    var p: usize = 0;
+    var star_p: ?usize = null;
+    var star_t: usize = 0;
+    while (t < text.len) {
+        if (p < pattern.len and pattern[p] == '*') {
+            star_p = p;
+            star_t = t;
+            p += 1;
+        } else if (p < pattern.len and (pattern[p] == '?' or pattern[p] == text[t])) {
+            t += 1;
+            p += 1;
+        } else if (star_p) |sp| {
+            p = sp + 1;
+            star_t += 1;
+            t = star_t;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.len and pattern[p] == '*') p += 1;
+    return p == pattern.len;
+}
@@ -1,10 +1,13 @@
 //! Grain OS Workspace: Workspace management for window organization.
 //!
 //! Why: Organize windows into separate workspaces (River-style).
-//! Architecture: Multiple workspaces, window assignment, switching.
+//! Architecture: Multiple workspaces, window assignment, switching. A
+//! window→workspace id table answers ownership in O(1); each workspace
+//! records whether its cached tiling geometry is still valid.
 //! GrainStyle: grain_case, u32/u64, bounded allocations, assertions.
 
 const std = @import("std");
+const bounded_map = @import("bounded_map.zig");
 
 // Bounded: Max number of workspaces.
 pub const MAX_WORKSPACES: u32 = 10;
@@ -12,6 +15,9 @@ pub const MAX_WORKSPACES: u32 = 10;
 // Bounded: Max windows per workspace.
 pub const MAX_WORKSPACE_WINDOWS: u32 = 256;
 
+// Bounded: Max windows tracked by the window→workspace index.
+pub const MAX_TRACKED_WINDOWS: u32 = 512;
+
 // Workspace: represents a workspace with windows.
 pub const Workspace = struct {
     id: u32,
@@ -21,6 +27,7 @@ pub const Workspace = struct {
     window_ids_len: u32,
     focused_window_id: u32,
     visible: bool,
+    layout_valid: bool, // Cached tiling geometry matches current windows.
 
     pub fn init(id: u32, name: []const u8) Workspace {
         std.debug.assert(id > 0);
@@ -34,6 +41,7 @@ pub const Workspace = struct {
             .window_ids_len = 0,
             .focused_window_id = 0,
             .visible = false,
+            .layout_valid = true,
         };
         var j: u32 = 0;
         while (j < 32) : (j += 1) {
@@ -125,12 +133,15 @@ pub const WorkspaceManager = struct {
     workspaces: [MAX_WORKSPACES]Workspace,
     workspaces_len: u32,
     current_workspace_id: u32,
+    // Window→workspace index.
+    window_owners: bounded_map.BoundedMap(MAX_TRACKED_WINDOWS),
 
     pub fn init() WorkspaceManager {
         var manager = WorkspaceManager{
             .workspaces = undefined,
             .workspaces_len = 0,
             .current_workspace_id = 0,
+            .window_owners = bounded_map.BoundedMap(MAX_TRACKED_WINDOWS).init(),
         };
         var i: u32 = 0;
         while (i < MAX_WORKSPACES) : (i += 1) {
@@ -147,13 +158,13 @@ pub const WorkspaceManager = struct {
 
     pub fn get_workspace(self: *WorkspaceManager, workspace_id: u32) ?*Workspace {
         std.debug.assert(workspace_id > 0);
-        var i: u32 = 0;
-        while (i < self.workspaces_len) : (i += 1) {
-            if (self.workspaces[i].id == workspace_id) {
-                return &self.workspaces[i];
-            }
+        // Workspace ids are dense: id N lives at index N - 1.
+        if (workspace_id > self.workspaces_len) {
+            return null;
         }
-        return null;
+        const ws = &self.workspaces[workspace_id - 1];
+        std.debug.assert(ws.id == workspace_id);
+        return ws;
     }
 
     pub fn get_current_workspace(self: *WorkspaceManager) ?*Workspace {
@@ -165,13 +176,13 @@ pub const WorkspaceManager = struct {
 
     pub fn switch_workspace(self: *WorkspaceManager, workspace_id: u32) bool {
         std.debug.assert(workspace_id > 0);
-        if (self.get_workspace(workspace_id)) |workspace| {
+        if (self.get_workspace(workspace_id)) |ws| {
             // Hide current workspace.
             if (self.get_current_workspace()) |current| {
                 current.visible = false;
             }
             // Show new workspace.
-            workspace.visible = true;
+            ws.visible = true;
             self.current_workspace_id = workspace_id;
             std.debug.assert(self.current_workspace_id > 0);
             return true;
@@ -199,16 +210,35 @@ pub const WorkspaceManager = struct {
     ) bool {
         std.debug.assert(window_id > 0);
         std.debug.assert(workspace_id > 0);
-        // Remove from current workspace (if any).
-        var i: u32 = 0;
-        while (i < self.workspaces_len) : (i += 1) {
-            _ = self.workspaces[i].remove_window(window_id);
+        const target = self.get_workspace(workspace_id) orelse return false;
+        // Remove from owning workspace (if any); index says which one.
+        if (self.window_owners.get(window_id)) |owner| {
+            _ = self.workspaces[owner - 1].remove_window(window_id);
+            if (!target.add_window(window_id)) {
+                _ = self.window_owners.remove(window_id);
+                return false;
+            }
+            const tracked = self.window_owners.put(window_id, workspace_id);
+            std.debug.assert(tracked);
+            return true;
         }
-        // Add to target workspace.
-        if (self.get_workspace(workspace_id)) |workspace| {
-            return workspace.add_window(window_id);
+        if (self.window_owners.count() >= MAX_TRACKED_WINDOWS) {
+            return false;
         }
-        return false;
+        if (!target.add_window(window_id)) {
+            return false;
+        }
+        const tracked = self.window_owners.put(window_id, workspace_id);
+        std.debug.assert(tracked);
+        return true;
+    }
+
+    // Drop a window from its workspace. Returns the former workspace id.
+    pub fn remove_window(self: *WorkspaceManager, window_id: u32) ?u32 {
+        std.debug.assert(window_id > 0);
+        const owner = self.window_owners.remove(window_id) orelse return null;
+        _ = self.workspaces[owner - 1].remove_window(window_id);
+        return owner;
     }
 
     pub fn get_window_workspace(
@@ -216,12 +246,16 @@ pub const WorkspaceManager = struct {
         window_id: u32,
     ) ?u32 {
         std.debug.assert(window_id > 0);
+        return self.window_owners.get(window_id);
+    }
+
+    // Mark every workspace except the current one as needing layout.
+    pub fn invalidate_hidden_layouts(self: *WorkspaceManager) void {
         var i: u32 = 0;
         while (i < self.workspaces_len) : (i += 1) {
-            if (self.workspaces[i].has_window(window_id)) {
-                return self.workspaces[i].id;
+            if (self.workspaces[i].id != self.current_workspace_id) {
+                self.workspaces[i].layout_valid = false;
             }
         }
-        return null;
     }
 };
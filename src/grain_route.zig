@@ -1,7 +1,19 @@
 const std = @import("std");
 
 /// GrainRoute: static npub-aware routing for GrainAurora.
+/// Route tables compile once into a radix trie on the npub prefix; each
+/// prefix that ends a route roots a trie of path segments. Segments are
+/// literals, `:name` captures, or a trailing `*name` that captures the
+/// rest. Matching walks both tries without allocating: the longest npub
+/// prefix wins, then the route that consumes the most path segments
+/// (literal before capture before wildcard); unmatched segments are left
+/// in `remainder`.
 pub const GrainRoute = struct {
+    pub const max_segments = 32;
+    pub const max_captures = 8;
+    pub const max_npub_prefix = 63;
+    const none: u32 = std.math.maxInt(u32);
+
     pub const RouteSpec = struct {
         npub_prefix: []const u8,
         path: []const []const u8,
@@ -13,36 +25,436 @@ pub const GrainRoute = struct {
         params: Params,
     };
 
+    pub const Capture = struct {
+        name: []const u8,
+        value: []const u8,
+    };
+
     pub const Params = struct {
         npub: []const u8,
         remainder: []const u8,
+        captures: [max_captures]Capture = undefined,
+        captures_len: usize = 0,
+
+        /// capture: value captured by `:name` or `*name`, if any.
+        pub fn capture(self: *const Params, name: []const u8) ?[]const u8 {
+            for (self.captures[0..self.captures_len]) |c| {
+                if (std.mem.eql(u8, c.name, name)) return c.value;
+            }
+            return null;
+        }
+    };
+
+    // Radix node over npub prefix bytes; children sorted by first byte.
+    const NpubNode = struct {
+        label: []const u8,
+        first_child: u32,
+        child_count: u32,
+        path_root: u32, // PathNode for routes whose prefix ends here, or none
+    };
+
+    // Path segment node; literal children sorted by segment.
+    const PathNode = struct {
+        segment: []const u8,
+        first_child: u32,
+        child_count: u32,
+        route: u32, // Route whose path ends here, or none
+        param_child: u32,
+        wildcard_route: u32,
     };
 
+    const SegmentKind = enum(u8) { literal, param, wildcard };
+
+    allocator: std.mem.Allocator,
     routes: []const RouteSpec,
+    npub_nodes: []NpubNode,
+    path_nodes: []PathNode,
+
+    /// init: compile `routes` (borrowed, must outlive the router).
+    /// Identical routes resolve to the earliest one in the table; routes
+    /// that differ only in capture names are ambiguous and rejected.
+    pub fn init(allocator: std.mem.Allocator, routes: []const RouteSpec) !GrainRoute {
+        for (routes) |route| try validate(route);
+
+        const order = try allocator.alloc(u32, routes.len);
+        defer allocator.free(order);
+        for (order, 0..) |*slot, i| slot.* = @intCast(i);
+        // Stable: equal routes keep table order.
+        std.sort.block(u32, order, routes, route_less_than);
+        // Same-shape routes are adjacent after the sort.
+        var k: usize = 1;
+        while (k < order.len) : (k += 1) {
+            const a = order[k - 1];
+            const b = order[k];
+            if (route_less_than(routes, a, b)) continue;
+            if (!same_names(routes[a].path, routes[b].path)) return error.ConflictingCaptures;
+        }
 
-    pub fn init(routes: []const RouteSpec) GrainRoute {
-        return GrainRoute{ .routes = routes };
+        var builder = Builder{
+            .allocator = allocator,
+            .routes = routes,
+            .order = order,
+            .npub_nodes = .{},
+            .path_nodes = .{},
+        };
+        errdefer builder.npub_nodes.deinit(allocator);
+        errdefer builder.path_nodes.deinit(allocator);
+        try builder.npub_nodes.append(allocator, undefined);
+        try builder.build_npub(0, 0, @intCast(order.len), 0, "");
+
+        const npub_nodes = try builder.npub_nodes.toOwnedSlice(allocator);
+        errdefer allocator.free(npub_nodes);
+        const path_nodes = try builder.path_nodes.toOwnedSlice(allocator);
+        return GrainRoute{
+            .allocator = allocator,
+            .routes = routes,
+            .npub_nodes = npub_nodes,
+            .path_nodes = path_nodes,
+        };
+    }
+
+    pub fn deinit(self: *GrainRoute) void {
+        self.allocator.free(self.npub_nodes);
+        self.allocator.free(self.path_nodes);
+        self.* = undefined;
     }
 
-    pub fn match(self: GrainRoute, url: []const u8) ?Match {
+    pub fn match(self: *const GrainRoute, url: []const u8) ?Match {
         const trimmed = std.mem.trim(u8, url, "/");
         var parts_it = std.mem.splitScalar(u8, trimmed, '/');
         const npub = parts_it.next() orelse return null;
-        const remainder_start = trimmed[0..npub.len];
-        const remainder = trimmed[remainder_start.len..];
+        if (npub.len == 0) return null;
 
-        while (parts_it.next()) |_| {} // consume for now
+        // Path segments (empty ones skipped) and where each starts, so the
+        // unmatched tail can be returned as a slice of the URL.
+        var segments: [max_segments][]const u8 = undefined;
+        var starts: [max_segments + 1]usize = undefined;
+        var count: usize = 0;
+        var overflow = false;
+        while (parts_it.next()) |part| {
+            if (part.len == 0) continue;
+            starts[count] = @intFromPtr(part.ptr) - @intFromPtr(trimmed.ptr);
+            if (count == max_segments) {
+                overflow = true;
+                break;
+            }
+            segments[count] = part;
+            count += 1;
+        }
+        if (!overflow) starts[count] = trimmed.len;
 
-        for (self.routes) |route| {
-            if (std.mem.startsWith(u8, npub, route.npub_prefix)) {
-                return Match{
-                    .component_id = route.component_id,
-                    .params = .{ .npub = npub, .remainder = remainder },
+        // Every npub prefix on the walk that roots path routes, shortest first
+        // (at most one per prefix length).
+        var candidates: [max_npub_prefix + 1]u32 = undefined;
+        var candidates_len: usize = 0;
+        var node_index: u32 = 0;
+        var depth: usize = 0;
+        while (true) {
+            const node = &self.npub_nodes[node_index];
+            if (node.path_root != none) {
+                candidates[candidates_len] = node.path_root;
+                candidates_len += 1;
+            }
+            if (depth == npub.len) break;
+            const child = self.npub_child(node, npub[depth]) orelse break;
+            const label = self.npub_nodes[child].label;
+            if (!std.mem.startsWith(u8, npub[depth..], label)) break;
+            depth += label.len;
+            node_index = child;
+        }
+
+        // Longest prefix first; fall back to shorter ones.
+        var search = PathSearch{
+            .router = self,
+            .segments = segments[0..count],
+            .url = trimmed,
+            .starts = &starts,
+        };
+        while (candidates_len > 0) {
+            candidates_len -= 1;
+            search.best_route = none;
+            search.visit(candidates[candidates_len], 0);
+            if (search.best_route != none) {
+                var result = Match{
+                    .component_id = self.routes[search.best_route].component_id,
+                    .params = .{
+                        .npub = npub,
+                        .remainder = trimmed[search.best_end..],
+                    },
                 };
+                result.params.captures = search.best_captures;
+                result.params.captures_len = search.best_captures_len;
+                return result;
+            }
+        }
+        return null;
+    }
+
+    fn npub_child(self: *const GrainRoute, node: *const NpubNode, byte: u8) ?u32 {
+        var lo: u32 = node.first_child;
+        var hi: u32 = node.first_child + node.child_count;
+        while (lo < hi) {
+            const mid = lo + (hi - lo) / 2;
+            const first = self.npub_nodes[mid].label[0];
+            if (first == byte) return mid;
+            if (first < byte) lo = mid + 1 else hi = mid;
+        }
+        return null;
+    }
+
+    fn path_child(self: *const GrainRoute, node: *const PathNode, segment: []const u8) ?u32 {
+        var lo: u32 = node.first_child;
+        var hi: u32 = node.first_child + node.child_count;
+        while (lo < hi) {
+            const mid = lo + (hi - lo) / 2;
+            switch (std.mem.order(u8, self.path_nodes[mid].segment, segment)) {
+                .eq => return mid,
+                .lt => lo = mid + 1,
+                .gt => hi = mid,
             }
         }
         return null;
     }
+
+    // Depth-first search for the route consuming the most segments.
+    const PathSearch = struct {
+        router: *const GrainRoute,
+        segments: []const []const u8,
+        url: []const u8,
+        starts: *const [max_segments + 1]usize,
+        captures: [max_captures]Capture = undefined,
+        captures_len: usize = 0,
+        best_route: u32 = none,
+        best_depth: usize = 0,
+        best_end: usize = 0,
+        best_captures: [max_captures]Capture = undefined,
+        best_captures_len: usize = 0,
+
+        fn record(self: *PathSearch, route: u32, depth: usize, end: usize) void {
+            if (self.best_route != none and depth <= self.best_depth) return;
+            self.best_route = route;
+            self.best_depth = depth;
+            self.best_end = end;
+            self.best_captures = self.captures;
+            self.best_captures_len = self.captures_len;
+            // Capture nodes are shared by routes with different names, so
+            // name the values from the winning route's own segments.
+            var n: usize = 0;
+            for (self.router.routes[route].path) |segment| {
+                if (segment_kind(segment) == .literal) continue;
+                self.best_captures[n].name = segment[1..];
+                n += 1;
+            }
+            std.debug.assert(n == self.captures_len);
+        }
+
+        fn visit(self: *PathSearch, node_index: u32, k: usize) void {
+            const router = self.router;
+            const node = &router.path_nodes[node_index];
+            if (node.route != none) self.record(node.route, k, self.starts[k]);
+            if (k == self.segments.len) return;
+            const segment = self.segments[k];
+            if (router.path_child(node, segment)) |child| {
+                self.visit(child, k + 1);
+            }
+            if (node.param_child != none) {
+                self.captures[self.captures_len] = .{ .name = "", .value = segment };
+                self.captures_len += 1;
+                self.visit(node.param_child, k + 1);
+                self.captures_len -= 1;
+            }
+            if (node.wildcard_route != none) {
+                // Rest of the URL (including any segments past max_segments).
+                const rest = self.url[self.starts[k]..];
+                self.captures[self.captures_len] = .{ .name = "", .value = rest };
+                self.captures_len += 1;
+                self.record(node.wildcard_route, self.segments.len, self.url.len);
+                self.captures_len -= 1;
+            }
+        }
+    };
+
+    const Builder = struct {
+        allocator: std.mem.Allocator,
+        routes: []const RouteSpec,
+        order: []const u32,
+        npub_nodes: std.ArrayListUnmanaged(NpubNode),
+        path_nodes: std.ArrayListUnmanaged(PathNode),
+
+        fn prefix(self: *const Builder, i: u32) []const u8 {
+            return self.routes[self.order[i]].npub_prefix;
+        }
+
+        fn path(self: *const Builder, i: u32) []const []const u8 {
+            return self.routes[self.order[i]].path;
+        }
+
+        // Fill npub node `index` for sorted routes [lo, hi) sharing `depth` bytes.
+        fn build_npub(self: *Builder, index: u32, lo: u32, hi: u32, depth: usize, label: []const u8) std.mem.Allocator.Error!void {
+            var t = lo;
+            while (t < hi and self.prefix(t).len == depth) t += 1;
+            var path_root: u32 = none;
+            if (t > lo) {
+                path_root = @intCast(self.path_nodes.items.len);
+                try self.path_nodes.append(self.allocator, undefined);
+                try self.build_path(path_root, lo, t, 0, "");
+            }
+
+            var groups: u32 = 0;
+            var i = t;
+            while (i < hi) : (groups += 1) i = self.npub_group_end(i, hi, depth);
+            const first_child: u32 = @intCast(self.npub_nodes.items.len);
+            try self.npub_nodes.appendNTimes(self.allocator, undefined, groups);
+
+            var child = first_child;
+            i = t;
+            while (i < hi) : (child += 1) {
+                const end = self.npub_group_end(i, hi, depth);
+                const first = self.prefix(i);
+                const common = common_prefix_len(first, self.prefix(end - 1));
+                try self.build_npub(child, i, end, common, first[depth..common]);
+                i = end;
+            }
+            self.npub_nodes.items[index] = .{
+                .label = label,
+                .first_child = first_child,
+                .child_count = groups,
+                .path_root = path_root,
+            };
+        }
+
+        fn npub_group_end(self: *const Builder, start: u32, hi: u32, depth: usize) u32 {
+            const byte = self.prefix(start)[depth];
+            var end = start + 1;
+            while (end < hi and self.prefix(end)[depth] == byte) end += 1;
+            return end;
+        }
+
+        // Fill path node `index` for sorted routes [lo, hi) sharing `depth` segments.
+        fn build_path(self: *Builder, index: u32, lo: u32, hi: u32, depth: usize, segment: []const u8) std.mem.Allocator.Error!void {
+            var t = lo;
+            var route: u32 = none;
+            while (t < hi and self.path(t).len == depth) : (t += 1) {
+                if (route == none) route = self.order[t];
+            }
+
+            // Literal children (sorted), then the capture group, then wildcards.
+            var groups: u32 = 0;
+            var i = t;
+            while (i < hi and segment_kind(self.path(i)[depth]) == .literal) : (groups += 1) {
+                i = self.path_group_end(i, hi, depth);
+            }
+            const literal_end = i;
+            const first_child: u32 = @intCast(self.path_nodes.items.len);
+            try self.path_nodes.appendNTimes(self.allocator, undefined, groups);
+            var child = first_child;
+            i = t;
+            while (i < literal_end) : (child += 1) {
+                const end = self.path_group_end(i, hi, depth);
+                try self.build_path(child, i, end, depth + 1, self.path(i)[depth]);
+                i = end;
+            }
+
+            var param_child: u32 = none;
+            var param_end = i;
+            while (param_end < hi and segment_kind(self.path(param_end)[depth]) == .param) param_end += 1;
+            if (param_end > i) {
+                param_child = @intCast(self.path_nodes.items.len);
+                try self.path_nodes.append(self.allocator, undefined);
+                try self.build_path(param_child, i, param_end, depth + 1, "");
+            }
+
+            var wildcard_route: u32 = none;
+            if (param_end < hi) wildcard_route = self.order[param_end];
+
+            self.path_nodes.items[index] = .{
+                .segment = segment,
+                .first_child = first_child,
+                .child_count = groups,
+                .route = route,
+                .param_child = param_child,
+                .wildcard_route = wildcard_route,
+            };
+        }
+
+        fn path_group_end(self: *const Builder, start: u32, hi: u32, depth: usize) u32 {
+            const segment = self.path(start)[depth];
+            var end = start + 1;
+            while (end < hi and std.mem.eql(u8, self.path(end)[depth], segment)) end += 1;
+            return end;
+        }
+    };
+
+    fn validate(route: RouteSpec) !void {
+        if (route.npub_prefix.len > max_npub_prefix) return error.PrefixTooLong;
+        if (route.path.len > max_segments) return error.RouteTooDeep;
+        var captures: usize = 0;
+        for (route.path, 0..) |segment, i| {
+            if (segment.len == 0 or std.mem.indexOfScalar(u8, segment, '/') != null) {
+                return error.InvalidSegment;
+            }
+            switch (segment_kind(segment)) {
+                .literal => {},
+                .param => captures += 1,
+                .wildcard => {
+                    if (i + 1 != route.path.len) return error.WildcardNotLast;
+                    captures += 1;
+                },
+            }
+        }
+        if (captures > max_captures) return error.TooManyCaptures;
+    }
+
+    fn segment_kind(segment: []const u8) SegmentKind {
+        return switch (segment[0]) {
+            ':' => .param,
+            '*' => .wildcard,
+            else => .literal,
+        };
+    }
+
+    // Sort key: npub prefix, then path (shorter first; per segment
+    // literals in byte order, then captures, then wildcards).
+    fn route_less_than(routes: []const RouteSpec, a: u32, b: u32) bool {
+        const ra = routes[a];
+        const rb = routes[b];
+        switch (std.mem.order(u8, ra.npub_prefix, rb.npub_prefix)) {
+            .lt => return true,
+            .gt => return false,
+            .eq => {},
+        }
+        const n = @min(ra.path.len, rb.path.len);
+        var i: usize = 0;
+        while (i < n) : (i += 1) {
+            const ka = segment_kind(ra.path[i]);
+            const kb = segment_kind(rb.path[i]);
+            if (ka != kb) return @intFromEnum(ka) < @intFromEnum(kb);
+            // Captures at the same position share one node (names ignored).
+            if (ka != .literal) continue;
+            switch (std.mem.order(u8, ra.path[i], rb.path[i])) {
+                .lt => return true,
+                .gt => return false,
+                .eq => {},
+            }
+        }
+        return ra.path.len < rb.path.len;
+    }
+
+    // Same-shape paths: equal unless some capture is named differently.
+    fn same_names(a: []const []const u8, b: []const []const u8) bool {
+        std.debug.assert(a.len == b.len);
+        for (a, b) |sa, sb| {
+            if (!std.mem.eql(u8, sa, sb)) return false;
+        }
+        return true;
+    }
+
+    fn common_prefix_len(a: []const u8, b: []const u8) usize {
+        const n = @min(a.len, b.len);
+        var i: usize = 0;
+        while (i < n and a[i] == b[i]) i += 1;
+        return i;
+    }
 };
 
 test "grain route matches prefix" {
@@ -53,8 +465,91 @@ test "grain route matches prefix" {
             .component_id = "timeline",
         },
     };
-    const router = GrainRoute.init(&route_table);
+    var router = try GrainRoute.init(std.testing.allocator, &route_table);
+    defer router.deinit();
     const match = router.match("/npub1grnz9wf/timeline") orelse return std.testing.expect(false);
     try std.testing.expectEqualStrings("timeline", match.component_id);
     try std.testing.expectEqualStrings("npub1grnz9wf", match.params.npub);
 }
+
+test "grain route uses the path and the longest npub prefix" {
+    const route_table = [_]GrainRoute.RouteSpec{
+        .{ .npub_prefix = "npub1", .path = &.{}, .component_id = "home" },
+        .{ .npub_prefix = "npub1", .path = &.{"timeline"}, .component_id = "timeline" },
+        .{ .npub_prefix = "npub1grn", .path = &.{"timeline"}, .component_id = "grain-timeline" },
+        .{ .npub_prefix = "npub1grn", .path = &.{ "notes", ":note" }, .component_id = "note" },
+        .{ .npub_prefix = "npub1grn", .path = &.{ "notes", "drafts" }, .component_id = "drafts" },
+        .{ .npub_prefix = "npub1grn", .path = &.{ "files", "*path" }, .component_id = "files" },
+    };
+    var router = try GrainRoute.init(std.testing.allocator, &route_table);
+    defer router.deinit();
+
+    try std.testing.expectEqualStrings("grain-timeline", router.match("/npub1grnq/timeline").?.component_id);
+    try std.testing.expectEqualStrings("timeline", router.match("/npub1xyz/timeline").?.component_id);
+
+    // No path route under npub1grn matches, so the shorter prefix answers.
+    const home = router.match("/npub1grnq/settings/theme").?;
+    try std.testing.expectEqualStrings("home", home.component_id);
+    try std.testing.expectEqualStrings("settings/theme", home.params.remainder);
+
+    const note = router.match("/npub1grnq/notes/abc123/").?;
+    try std.testing.expectEqualStrings("note", note.component_id);
+    try std.testing.expectEqualStrings("abc123", note.params.capture("note").?);
+    try std.testing.expectEqualStrings("", note.params.remainder);
+
+    // Literal beats capture at the same depth.
+    try std.testing.expectEqualStrings("drafts", router.match("/npub1grnq/notes/drafts").?.component_id);
+
+    const files = router.match("/npub1grnq/files/a/b/c.txt").?;
+    try std.testing.expectEqualStrings("files", files.component_id);
+    try std.testing.expectEqualStrings("a/b/c.txt", files.params.capture("path").?);
+
+    try std.testing.expect(router.match("/nostr1abc/timeline") == null);
+    try std.testing.expect(router.match("/") == null);
+}
+
+test "grain route rejects malformed routes" {
+    const wildcard_first = [_]GrainRoute.RouteSpec{
+        .{ .npub_prefix = "npub1", .path = &.{ "*rest", "more" }, .component_id = "bad" },
+    };
+    try std.testing.expectError(error.WildcardNotLast, GrainRoute.init(std.testing.allocator, &wildcard_first));
+    const empty_segment = [_]GrainRoute.RouteSpec{
+        .{ .npub_prefix = "npub1", .path = &.{""}, .component_id = "bad" },
+    };
+    try std.testing.expectError(error.InvalidSegment, GrainRoute.init(std.testing.allocator, &empty_segment));
+    const duplicate_wildcard = [_]GrainRoute.RouteSpec{
+        .{ .npub_prefix = "npub1", .path = &.{ "files", "*path" }, .component_id = "files" },
+        .{ .npub_prefix = "npub1", .path = &.{ "files", "*rest" }, .component_id = "other" },
+    };
+    try std.testing.expectError(error.ConflictingCaptures, GrainRoute.init(std.testing.allocator, &duplicate_wildcard));
+    const duplicate_param = [_]GrainRoute.RouteSpec{
+        .{ .npub_prefix = "npub1", .path = &.{ "notes", ":id" }, .component_id = "note" },
+        .{ .npub_prefix = "npub1", .path = &.{ "notes", ":note" }, .component_id = "other" },
+    };
+    try std.testing.expectError(error.ConflictingCaptures, GrainRoute.init(std.testing.allocator, &duplicate_param));
+}
+
+test "grain route names captures per route" {
+    const route_table = [_]GrainRoute.RouteSpec{
+        .{ .npub_prefix = "npub1", .path = &.{ "notes", ":note" }, .component_id = "note" },
+        .{ .npub_prefix = "npub1", .path = &.{ "notes", ":id", "edit" }, .component_id = "edit" },
+        .{ .npub_prefix = "npub1", .path = &.{ "notes", ":id", "*rest" }, .component_id = "rest" },
+    };
+    var router = try GrainRoute.init(std.testing.allocator, &route_table);
+    defer router.deinit();
+
+    const note = router.match("/npub1abc/notes/n1").?;
+    try std.testing.expectEqualStrings("note", note.component_id);
+    try std.testing.expectEqualStrings("n1", note.params.capture("note").?);
+    try std.testing.expect(note.params.capture("id") == null);
+
+    const edit = router.match("/npub1abc/notes/n2/edit").?;
+    try std.testing.expectEqualStrings("edit", edit.component_id);
+    try std.testing.expectEqualStrings("n2", edit.params.capture("id").?);
+    try std.testing.expect(edit.params.capture("note") == null);
+
+    const rest = router.match("/npub1abc/notes/n3/a/b").?;
+    try std.testing.expectEqualStrings("rest", rest.component_id);
+    try std.testing.expectEqualStrings("n3", rest.params.capture("id").?);
+    try std.testing.expectEqualStrings("a/b", rest.params.capture("rest").?);
+}
@@ -1,5 +1,6 @@
 const std = @import("std");
 const foundations = @import("grain-foundations");
+const grainmirror = @import("grainmirror");
 
 const GrainDevName = foundations.GrainDevName;
 
@@ -13,6 +14,9 @@ pub const GrainStore = struct {
     allocator: std.mem.Allocator,
     devname: GrainDevName,
     base_dir: []const u8,
+    // where repos are cloned from: null means each platform's public
+    // host, otherwise "{remote_base}/{platform}/{org}/{repo}".
+    remote_base: ?[]const u8 = null,
 
     pub fn init(
         allocator: std.mem.Allocator,
@@ -65,23 +69,73 @@ pub const GrainStore = struct {
         );
     }
 
+    pub fn remote_url(
+        self: GrainStore,
+        entry: ManifestEntry,
+    ) ![]u8 {
+        if (self.remote_base) |base| {
+            return std.fmt.allocPrint(
+                self.allocator,
+                "{s}/{s}/{s}/{s}",
+                .{ base, entry.platform, entry.org, entry.repo },
+            );
+        }
+        return std.fmt.allocPrint(
+            self.allocator,
+            "https://{s}/{s}/{s}",
+            .{ platform_host(entry.platform), entry.org, entry.repo },
+        );
+    }
+
+    // clone or update every entry through grainmirror's worker
+    // pool. failed repos are counted in the report, not returned.
+    // `self.allocator` must be thread-safe.
     pub fn sync_manifest_entries(
         self: GrainStore,
         entries: []const ManifestEntry,
-    ) !void {
+        options: grainmirror.pool.Options,
+    ) !grainmirror.pool.Report {
         const cwd = std.fs.cwd();
-        for (entries) |entry| {
-            const dir = try self.repo_path(
+        const jobs = try self.allocator.alloc(grainmirror.Job, entries.len);
+        defer self.allocator.free(jobs);
+        const outcomes = try self.allocator.alloc(grainmirror.Outcome, entries.len);
+        defer self.allocator.free(outcomes);
+
+        var filled: usize = 0;
+        defer for (jobs[0..filled]) |job| {
+            self.allocator.free(job.url);
+            self.allocator.free(job.path);
+        };
+        for (entries, jobs) |entry, *job| {
+            const path = try self.repo_path(
                 entry.platform,
                 entry.org,
                 entry.repo,
             );
-            defer self.allocator.free(dir);
-            try cwd.makePath(dir);
+            errdefer self.allocator.free(path);
+            // git clones into the repo dir itself; make its parent.
+            try cwd.makePath(std.fs.path.dirname(path).?);
+            const url = try self.remote_url(entry);
+            job.* = .{ .url = url, .path = path };
+            filled += 1;
         }
+
+        return grainmirror.mirror_all(
+            self.allocator,
+            jobs,
+            outcomes,
+            options,
+        );
     }
 };
 
+fn platform_host(platform: []const u8) []const u8 {
+    if (std.mem.eql(u8, platform, "github")) return "github.com";
+    if (std.mem.eql(u8, platform, "codeberg")) return "codeberg.org";
+    if (std.mem.eql(u8, platform, "gitlab")) return "gitlab.com";
+    return platform;
+}
+
 test "grainstore sync manifest entries" {
     var tmp = std.testing.tmpDir(.{});
     defer tmp.cleanup();
@@ -103,14 +157,24 @@ test "grainstore sync manifest entries" {
     const platforms = [_][]const u8{ "codeberg", "github", "gitab" };
     try store.ensure_platforms(&platforms);
 
+    // an empty local remote base: every job fails fast, offline.
+    store.remote_base = "remote";
+
     const manifest_entries = @import("grain_manifest.zig").entries;
-    try store.sync_manifest_entries(manifest_entries[0..]);
+    const report = try store.sync_manifest_entries(
+        manifest_entries[0..],
+        .{ .workers = 2 },
+    );
+    try std.testing.expectEqual(
+        @as(u32, manifest_entries.len),
+        report.failed,
+    );
 
     for (manifest_entries) |entry| {
         const path = try std.fmt.allocPrint(
             allocator,
-            "grainstore/{s}/{s}/{s}",
-            .{ entry.platform, entry.org, entry.repo },
+            "grainstore/{s}/{s}",
+            .{ entry.platform, entry.org },
         );
         defer allocator.free(path);
         try tmp.dir.access(path, .{});
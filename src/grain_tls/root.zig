@@ -5,3 +5,5 @@ pub const TlsClient = @import("tls_client.zig").TlsClient;
 pub const CipherSuite = @import("tls_client.zig").CipherSuite;
 pub const NamedGroup = @import("tls_client.zig").NamedGroup;
 pub const Version = @import("tls_client.zig").Version;
+pub const TrustStore = @import("trust_store.zig").TrustStore;
+pub const Bundle = @import("trust_store.zig").Bundle;
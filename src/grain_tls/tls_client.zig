@@ -3,9 +3,28 @@ const std = @import("std");
 // Import from grainstore fork (now as a proper module)
 const tls_impl = @import("grain_tls_impl");
 
+const trust_store = @import("trust_store.zig");
+const TrustStore = trust_store.TrustStore;
+
 /// Simplified TLS 1.3 client for Grain OS
 /// Wraps ianic/tls.zig with grain_case naming
 pub const TlsClient = struct {
+    pub const Options = struct {
+        /// Roots to verify against; null uses the shared system store.
+        root_ca: ?trust_store.Bundle = null,
+    };
+
+    /// Stream buffers the connection reads and writes through. Heap-owned
+    /// so they live as long as the connection, not just the handshake.
+    const Transport = struct {
+        input_buf: [tls_impl.input_buffer_len]u8,
+        output_buf: [tls_impl.output_buffer_len]u8,
+        reader: std.net.Stream.Reader,
+        writer: std.net.Stream.Writer,
+    };
+
+    allocator: std.mem.Allocator,
+    transport: *Transport,
     connection: tls_impl.Connection,
     
     /// Initialize TLS client and perform handshake
@@ -14,25 +33,33 @@ pub const TlsClient = struct {
         stream: std.net.Stream,
         host: []const u8,
     ) !TlsClient {
-        // Load system root certificates
-        var root_ca = try tls_impl.config.cert.fromSystem(allocator);
-        errdefer root_ca.deinit(allocator);
-        
-        // Create IO buffers
-        var input_buf: [tls_impl.input_buffer_len]u8 = undefined;
-        var output_buf: [tls_impl.output_buffer_len]u8 = undefined;
-        
-        // Create reader/writer from stream
-        var reader = stream.reader(&input_buf);
-        var writer = stream.writer(&output_buf);
-        
+        return init_with(allocator, stream, host, .{});
+    }
+
+    /// Initialize with explicit roots, then handshake.
+    pub fn init_with(
+        allocator: std.mem.Allocator,
+        stream: std.net.Stream,
+        host: []const u8,
+        options: Options,
+    ) !TlsClient {
+        const root_ca = options.root_ca orelse (try TrustStore.shared()).*;
+
+        const transport = try allocator.create(Transport);
+        errdefer allocator.destroy(transport);
+        transport.reader = stream.reader(&transport.input_buf);
+        transport.writer = stream.writer(&transport.output_buf);
+
         // Perform TLS handshake
-        const connection = try tls_impl.client(reader.interface(), &writer.interface, .{
-            .host = host,
-            .root_ca = root_ca,
-        });
+        const connection = try tls_impl.client(
+            transport.reader.interface(),
+            &transport.writer.interface,
+            .{ .host = host, .root_ca = root_ca },
+        );
         
         return TlsClient{
+            .allocator = allocator,
+            .transport = transport,
             .connection = connection,
         };
     }
@@ -54,6 +81,7 @@ pub const TlsClient = struct {
     
     pub fn deinit(self: *TlsClient) void {
         self.close() catch {};
+        self.allocator.destroy(self.transport);
     }
 };
 
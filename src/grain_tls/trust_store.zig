@@ -0,0 +1,46 @@
+const std = @import("std");
+
+const tls_impl = @import("grain_tls_impl");
+
+/// Root certificate bundle type returned by the TLS implementation.
+pub const Bundle = @typeInfo(@typeInfo(@TypeOf(tls_impl.config.cert.fromSystem)).@"fn".return_type.?).error_union.payload;
+
+/// Process-wide system root store, loaded and parsed on first use and then
+/// shared by every connection (loading the system roots costs milliseconds;
+/// doing it per connection dominated short-lived HTTPS requests).
+///
+/// The bundle is read-only after loading, so concurrent handshakes may
+/// verify against it without further locking.
+pub const TrustStore = struct {
+    // Process lifetime: owned by the page allocator, not any caller.
+    const allocator = std.heap.page_allocator;
+
+    var mutex: std.Thread.Mutex = .{};
+    var bundle: Bundle = .{};
+    var loaded: bool = false;
+
+    /// Shared system roots, loading them on the first call. The pointer
+    /// stays valid for the process: `reset` empties and reloads the same
+    /// storage rather than handing out copies that outlive their memory.
+    pub fn shared() !*const Bundle {
+        mutex.lock();
+        defer mutex.unlock();
+        if (!loaded) {
+            bundle = try tls_impl.config.cert.fromSystem(allocator);
+            loaded = true;
+        }
+        return &bundle;
+    }
+
+    /// Drop the shared roots; the next `shared` call reloads them
+    /// (e.g. after the system store changed). Pointers from `shared` see
+    /// an empty store until then. No connection may be handshaking while
+    /// this runs.
+    pub fn reset() void {
+        mutex.lock();
+        defer mutex.unlock();
+        if (loaded) bundle.deinit(allocator);
+        bundle = .{};
+        loaded = false;
+    }
+};
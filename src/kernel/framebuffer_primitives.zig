@@ -0,0 +1,377 @@
+//! framebuffer_primitives: shared 2D drawing primitives for RGBA framebuffers.
+//!
+//! Why: One vectorized implementation of fill, glyph, and blit used by the
+//! kernel framebuffer driver, the VM host side, and grain_os, instead of
+//! three per-pixel copies that drift apart.
+//! Architecture: Row-wise `@Vector` fills, 8-pixel glyph rows expanded via a
+//! comptime lookup table, clipped blits. Every primitive returns the clipped
+//! rectangle it touched so callers mark dirty regions per rect, not per pixel.
+//! GrainStyle: Static tables, explicit limits, clipping instead of panics.
+
+const std = @import("std");
+
+// Pixel format: 32-bit RGBA, stored as bytes R, G, B, A (color 0xRRGGBBAA).
+pub const BYTES_PER_PIXEL: u32 = 4;
+
+// Glyph cell size of the built-in 8x8 bitmap font.
+pub const GLYPH_WIDTH: u32 = 8;
+pub const GLYPH_HEIGHT: u32 = 8;
+
+// Vector lane width: one glyph row (8 pixels, 32 bytes) per vector.
+// Why: Matches the glyph width so a font row expands with a single select.
+const LANE_PIXELS: u32 = 8;
+const LANE_BYTES: u32 = LANE_PIXELS * BYTES_PER_PIXEL;
+const Lanes = @Vector(LANE_BYTES, u8);
+const LaneMask = @Vector(LANE_BYTES, bool);
+
+// Rectangle in surface pixel coordinates (x/y inclusive, width/height extent).
+pub const Rect = struct {
+    x: u32,
+    y: u32,
+    width: u32,
+    height: u32,
+
+    // Smallest rectangle containing both inputs.
+    // Why: Accumulate the area touched by a sequence of draws (e.g. text).
+    pub fn union_with(self: Rect, other: Rect) Rect {
+        const min_x = @min(self.x, other.x);
+        const min_y = @min(self.y, other.y);
+        const max_x = @max(self.x + self.width, other.x + other.width);
+        const max_y = @max(self.y + self.height, other.y + other.height);
+        std.debug.assert(max_x > min_x);
+        std.debug.assert(max_y > min_y);
+        return Rect{
+            .x = min_x,
+            .y = min_y,
+            .width = max_x - min_x,
+            .height = max_y - min_y,
+        };
+    }
+};
+
+// Drawable RGBA pixel surface (borrowed memory, no ownership).
+pub const Surface = struct {
+    memory: []u8,
+    width: u32,
+    height: u32,
+    // Bytes per row (>= width * BYTES_PER_PIXEL).
+    stride: u32,
+
+    // Wrap tightly packed RGBA memory as a surface.
+    pub fn init(memory: []u8, width: u32, height: u32) Surface {
+        std.debug.assert(width > 0);
+        std.debug.assert(height > 0);
+        const stride = width * BYTES_PER_PIXEL;
+        std.debug.assert(memory.len >= @as(u64, stride) * height);
+        return Surface{
+            .memory = memory,
+            .width = width,
+            .height = height,
+            .stride = stride,
+        };
+    }
+
+    // Full-surface rectangle.
+    pub fn bounds(self: Surface) Rect {
+        return Rect{ .x = 0, .y = 0, .width = self.width, .height = self.height };
+    }
+
+    // Clip a signed rectangle against the surface.
+    // Returns: visible part, or null if nothing is visible.
+    pub fn clip(self: Surface, x: i32, y: i32, width: u32, height: u32) ?Rect {
+        return clip_rect(self.width, self.height, x, y, width, height);
+    }
+
+    // Byte slice covering one clipped row span.
+    fn row_span(self: Surface, x: u32, y: u32, width: u32) []u8 {
+        std.debug.assert(x + width <= self.width);
+        std.debug.assert(y < self.height);
+        const offset: usize = @as(usize, y) * self.stride + @as(usize, x) * BYTES_PER_PIXEL;
+        return self.memory[offset..][0 .. @as(usize, width) * BYTES_PER_PIXEL];
+    }
+};
+
+// Clip a signed rectangle against a width x height area.
+// Why: Shared by surfaces and by callers that draw through syscalls.
+// Returns: visible part, or null if nothing is visible.
+pub fn clip_rect(area_width: u32, area_height: u32, x: i32, y: i32, width: u32, height: u32) ?Rect {
+    const left: i64 = @max(@as(i64, x), 0);
+    const top: i64 = @max(@as(i64, y), 0);
+    const right: i64 = @min(@as(i64, x) + width, @as(i64, area_width));
+    const bottom: i64 = @min(@as(i64, y) + height, @as(i64, area_height));
+    if (right <= left or bottom <= top) {
+        return null;
+    }
+    const rect = Rect{
+        .x = @intCast(left),
+        .y = @intCast(top),
+        .width = @intCast(right - left),
+        .height = @intCast(bottom - top),
+    };
+    std.debug.assert(rect.x + rect.width <= area_width);
+    std.debug.assert(rect.y + rect.height <= area_height);
+    return rect;
+}
+
+// Split 0xRRGGBBAA into framebuffer byte order.
+pub fn color_bytes(color: u32) [BYTES_PER_PIXEL]u8 {
+    return [BYTES_PER_PIXEL]u8{
+        @truncate(color >> 24),
+        @truncate(color >> 16),
+        @truncate(color >> 8),
+        @truncate(color),
+    };
+}
+
+// Replicate one color across a lane vector (8 pixels).
+fn splat_color(color: u32) Lanes {
+    const bytes = color_bytes(color);
+    var lanes: [LANE_BYTES]u8 = undefined;
+    var i: u32 = 0;
+    while (i < LANE_BYTES) : (i += 1) {
+        lanes[i] = bytes[i % BYTES_PER_PIXEL];
+    }
+    return lanes;
+}
+
+// Fill a row span with a splatted color, 8 pixels per vector store.
+fn fill_span(span: []u8, lanes: Lanes) void {
+    std.debug.assert(span.len % BYTES_PER_PIXEL == 0);
+    var offset: usize = 0;
+    while (offset + LANE_BYTES <= span.len) : (offset += LANE_BYTES) {
+        span[offset..][0..LANE_BYTES].* = lanes;
+    }
+    // Tail (< 8 pixels): copy from the pattern.
+    const pattern: [LANE_BYTES]u8 = lanes;
+    const tail: usize = span.len - offset;
+    @memcpy(span[offset..], pattern[0..tail]);
+}
+
+// Fill the whole surface with one color.
+// Returns: surface bounds (entire surface is dirty).
+pub fn clear(surface: Surface, color: u32) Rect {
+    const lanes = splat_color(color);
+    if (surface.stride == surface.width * BYTES_PER_PIXEL) {
+        // Packed rows: one contiguous span.
+        const len: usize = @as(usize, surface.stride) * surface.height;
+        fill_span(surface.memory[0..len], lanes);
+    } else {
+        var row: u32 = 0;
+        while (row < surface.height) : (row += 1) {
+            fill_span(surface.row_span(0, row, surface.width), lanes);
+        }
+    }
+    std.debug.assert(surface.memory[0] == color_bytes(color)[0]);
+    return surface.bounds();
+}
+
+// Fill a (possibly partially off-surface) rectangle.
+// Returns: clipped rectangle that was written, or null if fully clipped.
+pub fn fill_rect(surface: Surface, x: i32, y: i32, width: u32, height: u32, color: u32) ?Rect {
+    const rect = surface.clip(x, y, width, height) orelse return null;
+    const lanes = splat_color(color);
+    var row: u32 = 0;
+    while (row < rect.height) : (row += 1) {
+        fill_span(surface.row_span(rect.x, rect.y + row, rect.width), lanes);
+    }
+    return rect;
+}
+
+// Glyph row expansion table: byte of font bits -> per-lane fg/bg mask.
+// Why: One table lookup and one vector select per glyph row instead of
+// eight bit tests and eight 4-byte stores.
+const GLYPH_ROW_MASKS: [256]LaneMask = build_glyph_row_masks();
+
+fn build_glyph_row_masks() [256]LaneMask {
+    @setEvalBranchQuota(20000);
+    var table: [256]LaneMask = undefined;
+    var bits: u32 = 0;
+    while (bits < 256) : (bits += 1) {
+        var mask: [LANE_BYTES]bool = undefined;
+        var lane: u32 = 0;
+        while (lane < LANE_BYTES) : (lane += 1) {
+            const px: u5 = @intCast(lane / BYTES_PER_PIXEL);
+            // MSB is the leftmost pixel.
+            mask[lane] = ((bits >> (7 - px)) & 1) == 1;
+        }
+        table[bits] = mask;
+    }
+    return table;
+}
+
+// Draw one 8x8 glyph (row-major, MSB first) with fg/bg colors.
+// Returns: clipped rectangle that was written, or null if fully clipped.
+pub fn draw_glyph(surface: Surface, pattern: u64, x: i32, y: i32, fg_color: u32, bg_color: u32) ?Rect {
+    const rect = surface.clip(x, y, GLYPH_WIDTH, GLYPH_HEIGHT) orelse return null;
+    const fg_lanes = splat_color(fg_color);
+    const bg_lanes = splat_color(bg_color);
+    // Glyph-space offset of the visible part (non-zero only when clipped).
+    const skip_x: u32 = @intCast(@as(i64, rect.x) - x);
+    const skip_y: u32 = @intCast(@as(i64, rect.y) - y);
+    std.debug.assert(skip_x < GLYPH_WIDTH);
+    std.debug.assert(skip_y < GLYPH_HEIGHT);
+
+    var row: u32 = 0;
+    while (row < rect.height) : (row += 1) {
+        const glyph_row: u6 = @intCast(skip_y + row);
+        const bits: u8 = @truncate(pattern >> (56 - glyph_row * 8));
+        const expanded: [LANE_BYTES]u8 = @select(u8, GLYPH_ROW_MASKS[bits], fg_lanes, bg_lanes);
+        const span = surface.row_span(rect.x, rect.y + row, rect.width);
+        @memcpy(span, expanded[skip_x * BYTES_PER_PIXEL ..][0..span.len]);
+    }
+    return rect;
+}
+
+// Draw text with the built-in font ('\n' starts a new line, long lines wrap).
+// Returns: union of all glyph rectangles written, or null if nothing drawn.
+pub fn draw_text(surface: Surface, text: []const u8, x: u32, y: u32, fg_color: u32, bg_color: u32) ?Rect {
+    var touched: ?Rect = null;
+    var char_x: u32 = x;
+    var char_y: u32 = y;
+    for (text) |ch| {
+        if (ch == 0) break;
+        if (ch == '\n') {
+            char_x = x;
+            char_y += GLYPH_HEIGHT;
+            continue;
+        }
+        if (char_x + GLYPH_WIDTH > surface.width) {
+            char_x = x;
+            char_y += GLYPH_HEIGHT;
+        }
+        if (char_y + GLYPH_HEIGHT > surface.height) {
+            break;
+        }
+        const drawn = draw_glyph(surface, glyph_pattern(ch), @intCast(char_x), @intCast(char_y), fg_color, bg_color);
+        if (drawn) |rect| {
+            touched = if (touched) |acc| acc.union_with(rect) else rect;
+        }
+        char_x += GLYPH_WIDTH;
+    }
+    return touched;
+}
+
+// Copy a source rectangle onto the destination at (dst_x, dst_y), clipped.
+// Contract: src_rect lies within src; src and dst memory do not overlap.
+// Returns: clipped destination rectangle that was written, or null.
+pub fn blit(dst: Surface, dst_x: i32, dst_y: i32, src: Surface, src_rect: Rect) ?Rect {
+    std.debug.assert(src_rect.x + src_rect.width <= src.width);
+    std.debug.assert(src_rect.y + src_rect.height <= src.height);
+    const rect = dst.clip(dst_x, dst_y, src_rect.width, src_rect.height) orelse return null;
+    const skip_x: u32 = @intCast(@as(i64, rect.x) - dst_x);
+    const skip_y: u32 = @intCast(@as(i64, rect.y) - dst_y);
+
+    var row: u32 = 0;
+    while (row < rect.height) : (row += 1) {
+        const dst_span = dst.row_span(rect.x, rect.y + row, rect.width);
+        const src_span = src.row_span(src_rect.x + skip_x, src_rect.y + skip_y + row, rect.width);
+        @memcpy(dst_span, src_span);
+    }
+    return rect;
+}
+
+// Get 8x8 bitmap pattern for character.
+// Why: Simple bitmap font shared by kernel, VM host, and grain_os text.
+// Pattern is row-major, MSB first (top-left to bottom-right).
+pub fn glyph_pattern(ch: u8) u64 {
+    return switch (ch) {
+        ' ' => 0x0000000000000000,
+        '!' => 0x1818181818001800,
+        '"' => 0x3636000000000000,
+        '#' => 0x36367F36367F3636,
+        '$' => 0x0C3E033E301F0C00,
+        '%' => 0x006333180C666300,
+        '&' => 0x1C361C6E3B331E00,
+        '\'' => 0x0C0C180000000000,
+        '(' => 0x0C18181818180C00,
+        ')' => 0x180C0C0C0C0C1800,
+        '*' => 0x00183C7E3C180000,
+        '+' => 0x000018187E181800,
+        ',' => 0x0000000000180C18,
+        '-' => 0x000000007E000000,
+        '.' => 0x0000000000181800,
+        '/' => 0x303018180C0C0606,
+        '0' => 0x3C666E7E76663C00,
+        '1' => 0x1818381818187E00,
+        '2' => 0x3C66060C18307E00,
+        '3' => 0x3C66061C06663C00,
+        '4' => 0x060E1E367F060600,
+        '5' => 0x7E607C0606663C00,
+        '6' => 0x1C30607C66663C00,
+        '7' => 0x7E060C1818181800,
+        '8' => 0x3C66663C66663C00,
+        '9' => 0x3C66663E060C3800,
+        ':' => 0x0000180000180000,
+        ';' => 0x0000180000180C18,
+        '<' => 0x000C1830180C0000,
+        '=' => 0x00007E00007E0000,
+        '>' => 0x00180C060C180000,
+        '?' => 0x3C66060C18001800,
+        '@' => 0x3C66766E60663C00,
+        'A' => 0x183C66667E666600,
+        'B' => 0x7C66667C66667C00,
+        'C' => 0x3C66606060663C00,
+        'D' => 0x786C6666666C7800,
+        'E' => 0x7E60607C60607E00,
+        'F' => 0x7E60607C60606000,
+        'G' => 0x3C66606E66663C00,
+        'H' => 0x6666667E66666600,
+        'I' => 0x3C18181818183C00,
+        'J' => 0x1E0C0C0C6C6C3800,
+        'K' => 0x666C78786C666600,
+        'L' => 0x6060606060607E00,
+        'M' => 0x63777F6B63636300,
+        'N' => 0x66767E7E6E666600,
+        'O' => 0x3C66666666663C00,
+        'P' => 0x7C66667C60606000,
+        'Q' => 0x3C6666666E3C0600,
+        'R' => 0x7C66667C6C666600,
+        // The old kernel table had 'S' one row short (0x3C603C06063C00,
+        // drawn shifted up); this is the full 8-row glyph the VM used.
+        'S' => 0x3C603C0606663C00,
+        'T' => 0x7E18181818181800,
+        'U' => 0x6666666666663C00,
+        'V' => 0x66666666663C1800,
+        'W' => 0x63636B7F77636300,
+        'X' => 0x66663C183C666600,
+        'Y' => 0x6666663C18181800,
+        'Z' => 0x7E060C1830607E00,
+        '[' => 0x3C30303030303C00,
+        '\\' => 0x06060C0C18183030,
+        ']' => 0x3C0C0C0C0C0C3C00,
+        '^' => 0x183C660000000000,
+        '_' => 0x0000000000007E00,
+        '`' => 0x18180C0000000000,
+        'a' => 0x00003C063E663E00,
+        'b' => 0x60607C6666667C00,
+        'c' => 0x00003C6660603C00,
+        'd' => 0x06063E6666663E00,
+        'e' => 0x00003C667E603C00,
+        'f' => 0x1C30307C30303000,
+        'g' => 0x00003E66663E063C,
+        'h' => 0x60607C6666666600,
+        'i' => 0x1800181818181800,
+        'j' => 0x0C000C0C0C6C3800,
+        'k' => 0x6060666C786C6600,
+        'l' => 0x1818181818181800,
+        'm' => 0x0000767F6B636300,
+        'n' => 0x00007C6666666600,
+        'o' => 0x00003C6666663C00,
+        'p' => 0x00007C66667C6060,
+        'q' => 0x00003E66663E0606,
+        'r' => 0x00007C6660606000,
+        's' => 0x00003E603C067C00,
+        't' => 0x30307C3030301C00,
+        'u' => 0x0000666666663E00,
+        'v' => 0x00006666663C1800,
+        'w' => 0x0000636B7F360000,
+        'x' => 0x0000663C183C6600,
+        'y' => 0x00006666663E063C,
+        'z' => 0x00007E0C18307E00,
+        '{' => 0x0C18187018180C00,
+        '|' => 0x1818180018181800,
+        '}' => 0x3018180E18183000,
+        '~' => 0x0000003E6C000000,
+        else => 0x7E8185B581817E00, // fallback: box
+    };
+}
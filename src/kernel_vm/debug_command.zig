@@ -73,19 +73,19 @@ pub const VMDebugCommand = struct {
 
     pub fn continue_execution(self: *VMDebugCommand) void {
         self.execution_controller.continue_execution();
-        self.debug_interface.clear_breakpoint_hit();
+        self.debug_interface.resume_from_breakpoint();
         self.debug_interface.clear_watchpoint_triggered();
     }
 
     pub fn step_over(self: *VMDebugCommand) void {
         self.execution_controller.step_over();
-        self.debug_interface.clear_breakpoint_hit();
+        self.debug_interface.resume_from_breakpoint();
         self.debug_interface.clear_watchpoint_triggered();
     }
 
     pub fn step_into(self: *VMDebugCommand) void {
         self.execution_controller.step_into();
-        self.debug_interface.clear_breakpoint_hit();
+        self.debug_interface.resume_from_breakpoint();
         self.debug_interface.clear_watchpoint_triggered();
     }
 
@@ -11,6 +11,10 @@
 //! - Register watch (monitor register changes)
 //! - Debug state tracking (breakpoint hit, watchpoint triggered)
 //! - Bounded breakpoint/watchpoint arrays
+//! - Armed counts + hashed filters: with nothing armed, checks are one
+//!   compare; with something armed, only filter hits scan the arrays
+//! - Watchpoints are page traps: a hashed per-page filter decides whether
+//!   an access needs the slow containment check at all
 //!
 //! TigerStyle Principles:
 //! - Explicit types: u32/u64 instead of usize
@@ -28,6 +32,27 @@ const std = @import("std");
 pub const MAX_BREAKPOINTS: u32 = 32;
 // Bounded: Maximum number of watchpoints (sufficient for memory debugging).
 pub const MAX_WATCHPOINTS: u32 = 32;
+// Hashed filter size in bits (power of two; PCs hash by halfword, pages by 4KB).
+pub const FILTER_BITS: u32 = 1024;
+const FILTER_WORDS: u32 = FILTER_BITS / 64;
+const PAGE_SHIFT: u6 = 12;
+
+const Filter = [FILTER_WORDS]u64;
+
+fn filter_bit(key: u64) struct { word: u32, mask: u64 } {
+    const bit: u32 = @intCast(key & (FILTER_BITS - 1));
+    return .{ .word = bit / 64, .mask = @as(u64, 1) << @intCast(bit % 64) };
+}
+
+fn filter_set(filter: *Filter, key: u64) void {
+    const b = filter_bit(key);
+    filter[b.word] |= b.mask;
+}
+
+fn filter_test(filter: *const Filter, key: u64) bool {
+    const b = filter_bit(key);
+    return filter[b.word] & b.mask != 0;
+}
 
 // Breakpoint entry: tracks breakpoint at PC address.
 pub const Breakpoint = struct {
@@ -61,6 +86,19 @@ pub const Watchpoint = struct {
             .enabled = true,
         };
     }
+
+    pub fn kind(self: Watchpoint) WatchKind {
+        if (self.watch_reads and self.watch_writes) return .access;
+        return if (self.watch_reads) .read else .write;
+    }
+};
+
+// What a watchpoint traps (gdb Z2 write, Z3 read, Z4 access).
+// Why: gdb may watch one address with several kinds; each gets a slot.
+pub const WatchKind = enum(u8) {
+    write,
+    read,
+    access,
 };
 
 // VM debugging interface.
@@ -74,6 +112,19 @@ pub const VMDebugInterface = struct {
     watchpoint_triggered: bool,
     last_breakpoint_pc: u64,
     last_watchpoint_addr: u64,
+    last_watchpoint_kind: WatchKind,
+    /// Enabled breakpoint count (0 = breakpoint checks are a single compare).
+    armed_breakpoints: u32,
+    /// Enabled watchpoint count (0 = memory accesses skip watch checks).
+    armed_watchpoints: u32,
+    /// Hashed set of breakpoint PCs (rebuilt on set/remove).
+    breakpoint_filter: Filter,
+    /// Hashed set of 4KB pages holding any watchpoint (rebuilt on set/remove).
+    watch_page_filter: Filter,
+    /// Breakpoint to ignore once (resume from a breakpoint without removing it).
+    resume_pc: ?u64,
+    /// Bumped whenever the breakpoint set changes (JIT invalidation key).
+    breakpoint_generation: u32,
 
     pub fn init() VMDebugInterface {
         var debug = VMDebugInterface{
@@ -86,6 +137,13 @@ pub const VMDebugInterface = struct {
             .watchpoint_triggered = false,
             .last_breakpoint_pc = 0,
             .last_watchpoint_addr = 0,
+            .last_watchpoint_kind = .write,
+            .armed_breakpoints = 0,
+            .armed_watchpoints = 0,
+            .breakpoint_filter = [_]u64{0} ** FILTER_WORDS,
+            .watch_page_filter = [_]u64{0} ** FILTER_WORDS,
+            .resume_pc = null,
+            .breakpoint_generation = 0,
         };
         var i: u32 = 0;
         while (i < MAX_BREAKPOINTS) : (i += 1) {
@@ -99,19 +157,21 @@ pub const VMDebugInterface = struct {
     }
 
     pub fn set_breakpoint(self: *VMDebugInterface, pc: u64) bool {
-        if (self.breakpoints_len >= MAX_BREAKPOINTS) {
-            return false;
-        }
         var i: u32 = 0;
         while (i < self.breakpoints_len) : (i += 1) {
             if (self.breakpoints[i].pc == pc) {
                 self.breakpoints[i].enabled = true;
+                self.rebuild_breakpoint_filter();
                 return true;
             }
         }
+        if (self.breakpoints_len >= MAX_BREAKPOINTS) {
+            return false;
+        }
         const idx = self.breakpoints_len;
         self.breakpoints[idx] = Breakpoint.init(pc);
         self.breakpoints_len += 1;
+        self.rebuild_breakpoint_filter();
         return true;
     }
 
@@ -120,47 +180,109 @@ pub const VMDebugInterface = struct {
         while (i < self.breakpoints_len) : (i += 1) {
             if (self.breakpoints[i].pc == pc) {
                 self.breakpoints[i].enabled = false;
+                self.rebuild_breakpoint_filter();
                 return true;
             }
         }
         return false;
     }
 
-    pub fn check_breakpoint(self: *VMDebugInterface, pc: u64) bool {
+    /// Whether pc holds an enabled breakpoint (no side effects).
+    /// Why: JIT block formation ends blocks at breakpoint PCs.
+    pub fn is_breakpoint(self: *const VMDebugInterface, pc: u64) bool {
+        if (self.armed_breakpoints == 0) return false;
+        if (!filter_test(&self.breakpoint_filter, pc >> 1)) return false;
         var i: u32 = 0;
         while (i < self.breakpoints_len) : (i += 1) {
             const bp = &self.breakpoints[i];
-            if (bp.enabled and bp.pc == pc) {
-                self.breakpoint_hit = true;
-                self.last_breakpoint_pc = pc;
-                return true;
-            }
+            if (bp.enabled and bp.pc == pc) return true;
         }
         return false;
     }
 
+    pub fn check_breakpoint(self: *VMDebugInterface, pc: u64) bool {
+        if (!self.is_breakpoint(pc)) return false;
+        if (self.resume_pc) |resume_pc| {
+            if (resume_pc == pc) {
+                // Resuming from this breakpoint: let the instruction run once.
+                self.resume_pc = null;
+                return false;
+            }
+        }
+        self.breakpoint_hit = true;
+        self.last_breakpoint_pc = pc;
+        return true;
+    }
+
+    /// Resume after a breakpoint hit without removing the breakpoint.
+    pub fn resume_from_breakpoint(self: *VMDebugInterface) void {
+        if (self.breakpoint_hit) {
+            self.resume_pc = self.last_breakpoint_pc;
+        }
+        self.breakpoint_hit = false;
+    }
+
+    /// Set a watchpoint, reusing the slot already watching address for
+    /// the same kind.
+    /// Why: gdb re-inserts every watchpoint on each continue.
     pub fn set_watchpoint(self: *VMDebugInterface, address: u64, size: u64, watch_reads: bool, watch_writes: bool) bool {
-        if (self.watchpoints_len >= MAX_WATCHPOINTS) {
-            return false;
+        const wanted = Watchpoint.init(address, size, watch_reads, watch_writes);
+        var idx: u32 = 0;
+        while (idx < self.watchpoints_len) : (idx += 1) {
+            const wp = &self.watchpoints[idx];
+            if (wp.address == address and wp.kind() == wanted.kind()) break;
         }
-        const idx = self.watchpoints_len;
-        self.watchpoints[idx] = Watchpoint.init(address, size, watch_reads, watch_writes);
-        self.watchpoints_len += 1;
+        if (idx == self.watchpoints_len) {
+            if (self.watchpoints_len >= MAX_WATCHPOINTS) {
+                return false;
+            }
+            self.watchpoints_len += 1;
+        }
+        self.watchpoints[idx] = wanted;
+        self.rebuild_watch_filter();
         return true;
     }
 
+    /// Remove every watchpoint at address and free their slots.
     pub fn remove_watchpoint(self: *VMDebugInterface, address: u64) bool {
+        var removed = false;
         var i: u32 = 0;
-        while (i < self.watchpoints_len) : (i += 1) {
+        while (i < self.watchpoints_len) {
             if (self.watchpoints[i].address == address) {
-                self.watchpoints[i].enabled = false;
+                self.free_watch_slot(i);
+                removed = true;
+            } else {
+                i += 1;
+            }
+        }
+        if (removed) self.rebuild_watch_filter();
+        return removed;
+    }
+
+    /// Remove the watchpoint of one kind at address (gdb z2/z3/z4).
+    pub fn remove_watchpoint_kind(self: *VMDebugInterface, address: u64, kind: WatchKind) bool {
+        var i: u32 = 0;
+        while (i < self.watchpoints_len) : (i += 1) {
+            const wp = &self.watchpoints[i];
+            if (wp.address == address and wp.kind() == kind) {
+                self.free_watch_slot(i);
+                self.rebuild_watch_filter();
                 return true;
             }
         }
         return false;
     }
 
+    // Free slot i; the last slot moves in.
+    fn free_watch_slot(self: *VMDebugInterface, i: u32) void {
+        std.debug.assert(i < self.watchpoints_len);
+        self.watchpoints_len -= 1;
+        self.watchpoints[i] = self.watchpoints[self.watchpoints_len];
+        self.watchpoints[self.watchpoints_len] = Watchpoint.init(0, 1, false, false);
+    }
+
     pub fn check_watchpoint_read(self: *VMDebugInterface, address: u64, size: u64) bool {
+        if (!self.page_trapped(address, size)) return false;
         var i: u32 = 0;
         while (i < self.watchpoints_len) : (i += 1) {
             const wp = &self.watchpoints[i];
@@ -168,6 +290,7 @@ pub const VMDebugInterface = struct {
                 if (address >= wp.address and address + size <= wp.address + wp.size) {
                     self.watchpoint_triggered = true;
                     self.last_watchpoint_addr = address;
+                    self.last_watchpoint_kind = wp.kind();
                     return true;
                 }
             }
@@ -176,6 +299,7 @@ pub const VMDebugInterface = struct {
     }
 
     pub fn check_watchpoint_write(self: *VMDebugInterface, address: u64, size: u64) bool {
+        if (!self.page_trapped(address, size)) return false;
         var i: u32 = 0;
         while (i < self.watchpoints_len) : (i += 1) {
             const wp = &self.watchpoints[i];
@@ -183,6 +307,7 @@ pub const VMDebugInterface = struct {
                 if (address >= wp.address and address + size <= wp.address + wp.size) {
                     self.watchpoint_triggered = true;
                     self.last_watchpoint_addr = address;
+                    self.last_watchpoint_kind = wp.kind();
                     return true;
                 }
             }
@@ -190,6 +315,47 @@ pub const VMDebugInterface = struct {
         return false;
     }
 
+    /// Page-trap test: does this access touch a page holding a watchpoint?
+    /// Why: Most accesses miss every watched page; one filter probe per page
+    /// replaces a scan of all watchpoints.
+    fn page_trapped(self: *const VMDebugInterface, address: u64, size: u64) bool {
+        std.debug.assert(size > 0);
+        if (self.armed_watchpoints == 0) return false;
+        const first_page = address >> PAGE_SHIFT;
+        const last_page = (address + size - 1) >> PAGE_SHIFT;
+        return filter_test(&self.watch_page_filter, first_page) or
+            filter_test(&self.watch_page_filter, last_page);
+    }
+
+    fn rebuild_breakpoint_filter(self: *VMDebugInterface) void {
+        self.breakpoint_filter = [_]u64{0} ** FILTER_WORDS;
+        self.armed_breakpoints = 0;
+        var i: u32 = 0;
+        while (i < self.breakpoints_len) : (i += 1) {
+            const bp = &self.breakpoints[i];
+            if (!bp.enabled) continue;
+            filter_set(&self.breakpoint_filter, bp.pc >> 1);
+            self.armed_breakpoints += 1;
+        }
+        self.breakpoint_generation +%= 1;
+        std.debug.assert(self.armed_breakpoints <= self.breakpoints_len);
+    }
+
+    fn rebuild_watch_filter(self: *VMDebugInterface) void {
+        self.watch_page_filter = [_]u64{0} ** FILTER_WORDS;
+        self.armed_watchpoints = 0;
+        var i: u32 = 0;
+        while (i < self.watchpoints_len) : (i += 1) {
+            const wp = &self.watchpoints[i];
+            if (!wp.enabled or !(wp.watch_reads or wp.watch_writes)) continue;
+            // Watchpoints are at most 8 bytes: at most two pages.
+            filter_set(&self.watch_page_filter, wp.address >> PAGE_SHIFT);
+            filter_set(&self.watch_page_filter, (wp.address + wp.size - 1) >> PAGE_SHIFT);
+            self.armed_watchpoints += 1;
+        }
+        std.debug.assert(self.armed_watchpoints <= self.watchpoints_len);
+    }
+
     pub fn enable_step_mode(self: *VMDebugInterface) void {
         self.step_mode = true;
     }
@@ -0,0 +1,86 @@
+//! Framebuffer Tile Sync
+//!
+//! Objective: Copy only dirty 32x32 tiles from the VM framebuffer to a host buffer.
+//! Why: Most frames touch a cursor or a line of text; copying and uploading
+//! the full 3MB framebuffer every frame wastes memory bandwidth.
+//!
+//! Methodology:
+//! - VM stores (interpreter and JIT) and host syscalls mark tiles in
+//!   FramebufferDirtyRegion.tiles
+//! - sync() drains the tile map into a static tile list and copies each tile
+//! - The returned list is handed to the platform backend for partial upload
+//!
+//! GrainStyle: Static allocation, explicit types, bounded loops, assertions.
+
+const std = @import("std");
+const vm_mod = @import("vm.zig");
+const VM = vm_mod.VM;
+const DirtyTile = vm_mod.DirtyTile;
+
+const FRAMEBUFFER_WIDTH: u32 = 1024;
+const FRAMEBUFFER_HEIGHT: u32 = 768;
+const BYTES_PER_PIXEL: u32 = 4;
+const ROW_STRIDE: u32 = FRAMEBUFFER_WIDTH * BYTES_PER_PIXEL;
+
+/// Tile sync state: static tile list plus cumulative counters.
+/// Why: Tile list lives here (not on the stack) so callers can hold the
+/// returned slice until the platform has uploaded it.
+pub const TileSync = struct {
+    tiles: [vm_mod.FRAMEBUFFER_TILE_COUNT]DirtyTile = undefined,
+    count: u32 = 0,
+    /// Total tiles copied since init (for profiling).
+    total_tiles: u64 = 0,
+    /// Total bytes copied since init (for profiling).
+    total_bytes: u64 = 0,
+
+    /// Drain dirty tiles from the VM and copy them into dst.
+    /// Contract: dst must be a 1024x768 RGBA buffer with the same layout
+    /// as the VM framebuffer.
+    /// Returns: the tiles copied (valid until the next sync).
+    pub fn sync(self: *TileSync, vm: *VM, dst: []u8) []const DirtyTile {
+        std.debug.assert(dst.len == FRAMEBUFFER_WIDTH * FRAMEBUFFER_HEIGHT * BYTES_PER_PIXEL);
+
+        const src = vm.get_framebuffer_memory();
+        std.debug.assert(src.len == dst.len);
+
+        self.count = vm.framebuffer_dirty.take_dirty_tiles(&self.tiles);
+        var i: u32 = 0;
+        while (i < self.count) : (i += 1) {
+            copy_tile(dst, src, self.tiles[i]);
+        }
+
+        const tile_bytes: u64 = vm_mod.FRAMEBUFFER_TILE_SIZE * vm_mod.FRAMEBUFFER_TILE_SIZE * BYTES_PER_PIXEL;
+        self.total_tiles += self.count;
+        self.total_bytes += @as(u64, self.count) * tile_bytes;
+
+        std.debug.assert(self.count <= vm_mod.FRAMEBUFFER_TILE_COUNT);
+        return self.tiles[0..self.count];
+    }
+
+    /// Copy the whole framebuffer into dst and clear the dirty tiles.
+    /// Why: Full redraws (UI change, filter) need every pixel fresh.
+    pub fn sync_all(self: *TileSync, vm: *VM, dst: []u8) void {
+        std.debug.assert(dst.len == FRAMEBUFFER_WIDTH * FRAMEBUFFER_HEIGHT * BYTES_PER_PIXEL);
+
+        const src = vm.get_framebuffer_memory();
+        std.debug.assert(src.len == dst.len);
+
+        _ = vm.framebuffer_dirty.take_dirty_tiles(&self.tiles);
+        self.count = 0;
+        @memcpy(dst, src);
+        self.total_bytes += dst.len;
+    }
+};
+
+/// Copy one tile's rows from src to dst (identical layouts).
+fn copy_tile(dst: []u8, src: []const u8, tile: DirtyTile) void {
+    std.debug.assert(tile.x + tile.width <= FRAMEBUFFER_WIDTH);
+    std.debug.assert(tile.y + tile.height <= FRAMEBUFFER_HEIGHT);
+
+    const row_len: u32 = tile.width * BYTES_PER_PIXEL;
+    var y: u32 = tile.y;
+    while (y < tile.y + tile.height) : (y += 1) {
+        const offset: u32 = y * ROW_STRIDE + tile.x * BYTES_PER_PIXEL;
+        @memcpy(dst[offset..][0..row_len], src[offset..][0..row_len]);
+    }
+}
@@ -0,0 +1,432 @@
+//! GDB Remote Serial Protocol Stub
+//!
+//! Objective: Let `gdb` (target remote :PORT) debug kernels running in the VM.
+//! Why: Breakpoints, watchpoints, and single-step already exist in
+//! VMDebugInterface; RSP exposes them to standard tooling.
+//!
+//! Methodology:
+//! - PacketReader frames `$payload#cs` packets from a byte stream (acks,
+//!   checksums, 0x03 interrupt)
+//! - GdbStub.handle_packet maps one payload to one reply payload (pure,
+//!   testable without sockets)
+//! - serve() binds 127.0.0.1:port, accepts one client, and pumps bytes
+//!
+//! Supported: ? g G p P m M c s Z0/z0 (sw breakpoint) Z2/Z3/Z4 (watchpoints)
+//! qSupported qAttached H k D. Registers: x0-x31, pc (64-bit, little-endian).
+//! Stop replies name their reason: swbreak, watch, rwatch, or awatch.
+//!
+//! GrainStyle: Static allocation, explicit types, bounded loops, assertions.
+
+const std = @import("std");
+const VM = @import("vm.zig").VM;
+const WatchKind = @import("debug_interface.zig").WatchKind;
+
+/// Maximum packet payload (advertised as PacketSize).
+pub const MAX_PACKET_SIZE: u32 = 4096;
+/// Steps between interrupt polls while continuing.
+const CONTINUE_POLL_INTERVAL: u32 = 4096;
+/// RISC-V register count exposed to gdb (x0-x31 + pc).
+const REGISTER_COUNT: u32 = 33;
+/// SIGTRAP: reported for breakpoints, watchpoints, and steps.
+const SIGTRAP: u8 = 5;
+/// SIGINT: reported for Ctrl-C interrupts.
+const SIGINT: u8 = 2;
+
+/// Incremental packet framer.
+pub const PacketReader = struct {
+    const State = enum { idle, payload, checksum_hi, checksum_lo };
+
+    state: State = .idle,
+    buffer: [MAX_PACKET_SIZE]u8 = undefined,
+    len: u32 = 0,
+    sum: u8 = 0,
+    checksum: u8 = 0,
+
+    pub const Event = union(enum) {
+        none,
+        /// Complete packet with valid checksum (payload valid until next feed).
+        packet: []const u8,
+        /// Packet with bad checksum (reply '-').
+        bad_checksum,
+        /// Ctrl-C from the client.
+        interrupt,
+    };
+
+    /// Feed one byte; returns what completed, if anything.
+    pub fn feed(self: *PacketReader, byte: u8) Event {
+        switch (self.state) {
+            .idle => {
+                if (byte == '$') {
+                    self.state = .payload;
+                    self.len = 0;
+                    self.sum = 0;
+                } else if (byte == 0x03) {
+                    return .interrupt;
+                }
+                // '+' / '-' acks and noise are ignored.
+            },
+            .payload => {
+                if (byte == '#') {
+                    self.state = .checksum_hi;
+                } else if (self.len < MAX_PACKET_SIZE) {
+                    self.buffer[self.len] = byte;
+                    self.len += 1;
+                    self.sum +%= byte;
+                } else {
+                    // Oversized packet: drop and resynchronize.
+                    self.state = .idle;
+                }
+            },
+            .checksum_hi => {
+                self.checksum = (hex_value(byte) orelse 0) << 4;
+                self.state = .checksum_lo;
+            },
+            .checksum_lo => {
+                self.checksum |= hex_value(byte) orelse 0;
+                self.state = .idle;
+                if (self.checksum != self.sum) return .bad_checksum;
+                return .{ .packet = self.buffer[0..self.len] };
+            },
+        }
+        return .none;
+    }
+};
+
+/// Frame a payload as `$payload#cs` into out.
+pub fn frame_packet(payload: []const u8, out: []u8) []const u8 {
+    std.debug.assert(out.len >= payload.len + 4);
+    out[0] = '$';
+    var sum: u8 = 0;
+    for (payload, 0..) |byte, i| {
+        out[1 + i] = byte;
+        sum +%= byte;
+    }
+    const end = 1 + payload.len;
+    out[end] = '#';
+    out[end + 1] = hex_digit(sum >> 4);
+    out[end + 2] = hex_digit(sum & 0xF);
+    return out[0 .. end + 3];
+}
+
+/// Result of handling one packet.
+pub const Reply = union(enum) {
+    /// Send this payload.
+    payload: []const u8,
+    /// Resume execution, then send a stop reply.
+    resume_continue,
+    /// Single-step, then send a stop reply.
+    resume_step,
+    /// Client asked to kill or detach: reply payload, then close.
+    close: []const u8,
+};
+
+pub const GdbStub = struct {
+    vm: *VM,
+    reply: [MAX_PACKET_SIZE]u8 = undefined,
+
+    pub fn init(vm: *VM) GdbStub {
+        return .{ .vm = vm };
+    }
+
+    /// Map one packet payload to a reply.
+    pub fn handle_packet(self: *GdbStub, packet: []const u8) Reply {
+        if (packet.len == 0) return .{ .payload = "" };
+        const args = packet[1..];
+        return switch (packet[0]) {
+            '?' => .{ .payload = self.stop_reply(SIGTRAP) },
+            'g' => .{ .payload = self.read_registers() },
+            'G' => .{ .payload = self.write_registers(args) },
+            'p' => .{ .payload = self.read_register(args) },
+            'P' => .{ .payload = self.write_register(args) },
+            'm' => .{ .payload = self.read_memory(args) },
+            'M' => .{ .payload = self.write_memory(args) },
+            'c' => .resume_continue,
+            's' => .resume_step,
+            'Z' => .{ .payload = self.set_point(args, true) },
+            'z' => .{ .payload = self.set_point(args, false) },
+            'H' => .{ .payload = "OK" },
+            'k' => .{ .close = "" },
+            'D' => .{ .close = "OK" },
+            'q' => .{ .payload = query(args) },
+            else => .{ .payload = "" }, // Unsupported: empty reply.
+        };
+    }
+
+    /// Continue until a breakpoint, watchpoint, halt, or interrupt.
+    /// Contract: poll_interrupt returns true if the client sent Ctrl-C.
+    pub fn run_continue(self: *GdbStub, poll_context: anytype, comptime poll_interrupt: fn (@TypeOf(poll_context)) bool) []const u8 {
+        const debug = &self.vm.debug_interface;
+        debug.resume_from_breakpoint();
+        debug.clear_watchpoint_triggered();
+        if (self.vm.state == .halted) self.vm.state = .running;
+
+        var steps: u32 = 0;
+        while (self.vm.state == .running) {
+            self.vm.step() catch break;
+            if (debug.breakpoint_hit or debug.watchpoint_triggered) break;
+            steps += 1;
+            if (steps % CONTINUE_POLL_INTERVAL == 0 and poll_interrupt(poll_context)) {
+                return self.stop_reply(SIGINT);
+            }
+        }
+        return self.stop_after_run();
+    }
+
+    /// Execute exactly one instruction.
+    pub fn run_step(self: *GdbStub) []const u8 {
+        const debug = &self.vm.debug_interface;
+        debug.resume_from_breakpoint();
+        debug.clear_watchpoint_triggered();
+        if (self.vm.state == .halted) self.vm.state = .running;
+        // A breakpoint at the current pc is skipped by resume_from_breakpoint.
+        debug.resume_pc = self.vm.regs.pc;
+        self.vm.step() catch {};
+        debug.resume_pc = null;
+        if (self.vm.state == .running) self.vm.state = .halted;
+        return self.stop_after_run();
+    }
+
+    fn stop_after_run(self: *GdbStub) []const u8 {
+        if (self.vm.state == .errored) {
+            // Report the fault as SIGSEGV so gdb stops at the faulting pc.
+            return self.stop_reply(11);
+        }
+        if (self.vm.state == .running) self.vm.state = .halted;
+        // Stop reasons let gdb tell watchpoint and breakpoint traps apart
+        // (swbreak is advertised in qSupported).
+        const debug = &self.vm.debug_interface;
+        if (debug.watchpoint_triggered) {
+            const reason = switch (debug.last_watchpoint_kind) {
+                .write => "watch",
+                .read => "rwatch",
+                .access => "awatch",
+            };
+            return std.fmt.bufPrint(&self.reply, "T05{s}:{x};", .{ reason, debug.last_watchpoint_addr }) catch unreachable;
+        }
+        if (debug.breakpoint_hit) return "T05swbreak:;";
+        return self.stop_reply(SIGTRAP);
+    }
+
+    fn stop_reply(self: *GdbStub, signal: u8) []const u8 {
+        return std.fmt.bufPrint(&self.reply, "S{x:0>2}", .{signal}) catch unreachable;
+    }
+
+    fn register_value(self: *const GdbStub, index: u32) u64 {
+        std.debug.assert(index < REGISTER_COUNT);
+        if (index == 32) return self.vm.regs.pc;
+        return self.vm.regs.get(@intCast(index));
+    }
+
+    fn set_register_value(self: *GdbStub, index: u32, value: u64) void {
+        std.debug.assert(index < REGISTER_COUNT);
+        if (index == 32) {
+            self.vm.regs.pc = value;
+        } else {
+            self.vm.regs.set(@intCast(index), value);
+        }
+    }
+
+    fn read_registers(self: *GdbStub) []const u8 {
+        var i: u32 = 0;
+        while (i < REGISTER_COUNT) : (i += 1) {
+            write_hex_le(self.reply[i * 16 ..][0..16], self.register_value(i));
+        }
+        return self.reply[0 .. REGISTER_COUNT * 16];
+    }
+
+    fn write_registers(self: *GdbStub, args: []const u8) []const u8 {
+        if (args.len < REGISTER_COUNT * 16) return "E01";
+        var i: u32 = 0;
+        while (i < REGISTER_COUNT) : (i += 1) {
+            const value = parse_hex_le(args[i * 16 ..][0..16]) orelse return "E01";
+            self.set_register_value(i, value);
+        }
+        return "OK";
+    }
+
+    fn read_register(self: *GdbStub, args: []const u8) []const u8 {
+        const index = std.fmt.parseInt(u32, args, 16) catch return "E01";
+        if (index >= REGISTER_COUNT) return "E01";
+        write_hex_le(self.reply[0..16], self.register_value(index));
+        return self.reply[0..16];
+    }
+
+    fn write_register(self: *GdbStub, args: []const u8) []const u8 {
+        const eq = std.mem.indexOfScalar(u8, args, '=') orelse return "E01";
+        const index = std.fmt.parseInt(u32, args[0..eq], 16) catch return "E01";
+        if (index >= REGISTER_COUNT or args.len - eq - 1 != 16) return "E01";
+        const value = parse_hex_le(args[eq + 1 ..][0..16]) orelse return "E01";
+        self.set_register_value(index, value);
+        return "OK";
+    }
+
+    fn read_memory(self: *GdbStub, args: []const u8) []const u8 {
+        const range = parse_memory_range(args) orelse return "E01";
+        var i: u32 = 0;
+        while (i < range.len) : (i += 1) {
+            const phys = self.vm.translate_address(range.addr + i) orelse return "E14";
+            if (phys >= self.vm.memory_size) return "E14";
+            const byte = self.vm.memory[@intCast(phys)];
+            self.reply[i * 2] = hex_digit(byte >> 4);
+            self.reply[i * 2 + 1] = hex_digit(byte & 0xF);
+        }
+        return self.reply[0 .. range.len * 2];
+    }
+
+    fn write_memory(self: *GdbStub, args: []const u8) []const u8 {
+        const colon = std.mem.indexOfScalar(u8, args, ':') orelse return "E01";
+        const range = parse_memory_range(args[0..colon]) orelse return "E01";
+        const data = args[colon + 1 ..];
+        if (data.len != range.len * 2) return "E01";
+        var i: u32 = 0;
+        while (i < range.len) : (i += 1) {
+            const hi = hex_value(data[i * 2]) orelse return "E01";
+            const lo = hex_value(data[i * 2 + 1]) orelse return "E01";
+            const phys = self.vm.translate_address(range.addr + i) orelse return "E14";
+            if (phys >= self.vm.memory_size) return "E14";
+            self.vm.memory[@intCast(phys)] = (hi << 4) | lo;
+        }
+        // Code may have changed under compiled blocks.
+        if (self.vm.jit) |jit_ctx| jit_ctx.invalidate_all();
+        return "OK";
+    }
+
+    /// Z/z type,addr,kind: 0 = sw breakpoint, 2 = write, 3 = read, 4 = access watchpoint.
+    fn set_point(self: *GdbStub, args: []const u8, insert: bool) []const u8 {
+        if (args.len < 2 or args[1] != ',') return "E01";
+        const range = parse_addr_len(args[2..]) orelse return "E01";
+        const debug = &self.vm.debug_interface;
+        switch (args[0]) {
+            '0', '1' => {
+                const ok = if (insert) debug.set_breakpoint(range.addr) else debug.remove_breakpoint(range.addr);
+                // Unlink compiled blocks now rather than at the next block entry.
+                if (self.vm.jit) |jit_ctx| jit_ctx.sync_breakpoints();
+                return if (ok) "OK" else "E0E";
+            },
+            '2', '3', '4' => {
+                if (range.len == 0 or range.len > 8) return "E01";
+                const kind: WatchKind = switch (args[0]) {
+                    '2' => .write,
+                    '3' => .read,
+                    else => .access,
+                };
+                if (!insert) return if (debug.remove_watchpoint_kind(range.addr, kind)) "OK" else "E0E";
+                const reads = kind != .write;
+                const writes = kind != .read;
+                return if (debug.set_watchpoint(range.addr, range.len, reads, writes)) "OK" else "E0E";
+            },
+            else => return "",
+        }
+    }
+};
+
+fn query(args: []const u8) []const u8 {
+    if (std.mem.startsWith(u8, args, "Supported")) return "PacketSize=1000;swbreak+";
+    if (std.mem.eql(u8, args, "Attached")) return "1";
+    if (std.mem.eql(u8, args, "C")) return "QC1";
+    if (std.mem.startsWith(u8, args, "fThreadInfo")) return "m1";
+    if (std.mem.startsWith(u8, args, "sThreadInfo")) return "l";
+    return "";
+}
+
+/// Serve one gdb client on 127.0.0.1:port until it detaches or kills.
+/// Why: Local socket only; the stub exposes full guest memory access.
+pub fn serve(vm: *VM, port: u16) !void {
+    const address = try std.net.Address.parseIp4("127.0.0.1", port);
+    var server = try address.listen(.{ .reuse_address = true });
+    defer server.deinit();
+    const connection = try server.accept();
+    defer connection.stream.close();
+
+    var stub = GdbStub.init(vm);
+    var reader = PacketReader{};
+    var input: [1024]u8 = undefined;
+    var framed: [MAX_PACKET_SIZE + 4]u8 = undefined;
+    while (true) {
+        const n = try connection.stream.read(&input);
+        if (n == 0) return;
+        for (input[0..n]) |byte| {
+            switch (reader.feed(byte)) {
+                .none => {},
+                .interrupt => try connection.stream.writeAll(frame_packet(stub.stop_reply(SIGINT), &framed)),
+                .bad_checksum => try connection.stream.writeAll("-"),
+                .packet => |packet| {
+                    try connection.stream.writeAll("+");
+                    const payload = switch (stub.handle_packet(packet)) {
+                        .payload => |p| p,
+                        .resume_continue => stub.run_continue(connection.stream, poll_interrupt),
+                        .resume_step => stub.run_step(),
+                        .close => |p| {
+                            try connection.stream.writeAll(frame_packet(p, &framed));
+                            return;
+                        },
+                    };
+                    try connection.stream.writeAll(frame_packet(payload, &framed));
+                },
+            }
+        }
+    }
+}
+
+/// Non-blocking check for a Ctrl-C byte from the client.
+fn poll_interrupt(stream: std.net.Stream) bool {
+    var fds = [_]std.posix.pollfd{.{ .fd = stream.handle, .events = std.posix.POLL.IN, .revents = 0 }};
+    const ready = std.posix.poll(&fds, 0) catch return false;
+    if (ready == 0) return false;
+    var byte: [1]u8 = undefined;
+    const n = stream.read(&byte) catch return false;
+    return n == 1 and byte[0] == 0x03;
+}
+
+const AddrLen = struct { addr: u64, len: u32 };
+
+fn parse_addr_len(args: []const u8) ?AddrLen {
+    const comma = std.mem.indexOfScalar(u8, args, ',') orelse return null;
+    const addr = std.fmt.parseInt(u64, args[0..comma], 16) catch return null;
+    const len = std.fmt.parseInt(u32, args[comma + 1 ..], 16) catch return null;
+    return .{ .addr = addr, .len = len };
+}
+
+/// addr,len for m/M: len fits a packet as hex and addr + len does not wrap.
+/// Why: Client-supplied lengths must not overflow `len * 2` or `addr + i`.
+fn parse_memory_range(args: []const u8) ?AddrLen {
+    const range = parse_addr_len(args) orelse return null;
+    if (range.len > MAX_PACKET_SIZE / 2) return null;
+    _ = std.math.add(u64, range.addr, range.len) catch return null;
+    return range;
+}
+
+fn hex_digit(nibble: u8) u8 {
+    std.debug.assert(nibble < 16);
+    return "0123456789abcdef"[nibble];
+}
+
+fn hex_value(ch: u8) ?u8 {
+    return switch (ch) {
+        '0'...'9' => ch - '0',
+        'a'...'f' => ch - 'a' + 10,
+        'A'...'F' => ch - 'A' + 10,
+        else => null,
+    };
+}
+
+/// Write value as 16 hex chars in target (little-endian) byte order.
+fn write_hex_le(out: *[16]u8, value: u64) void {
+    var i: u32 = 0;
+    while (i < 8) : (i += 1) {
+        const byte: u8 = @truncate(value >> @intCast(i * 8));
+        out[i * 2] = hex_digit(byte >> 4);
+        out[i * 2 + 1] = hex_digit(byte & 0xF);
+    }
+}
+
+fn parse_hex_le(hex: *const [16]u8) ?u64 {
+    var value: u64 = 0;
+    var i: u32 = 0;
+    while (i < 8) : (i += 1) {
+        const hi = hex_value(hex[i * 2]) orelse return null;
+        const lo = hex_value(hex[i * 2 + 1]) orelse return null;
+        value |= @as(u64, (hi << 4) | lo) << @intCast(i * 8);
+    }
+    return value;
+}
@@ -0,0 +1,159 @@
+//! Lock-free Single-Producer/Single-Consumer Ring
+//!
+//! Objective: Move input events from the host thread to the VM thread without locks.
+//! Why: Once the VM runs on its own thread, `inject_*_event` (host) and the
+//! read_input_event syscall (VM) race on the queue indices.
+//!
+//! Methodology:
+//! - Producer owns `head`, consumer owns `tail`; each lives on its own cache
+//!   line with a cached copy of the other side's index (no false sharing,
+//!   one cross-core load per refill instead of per item)
+//! - Indices are free-running u32 counters; slot = index & (capacity - 1)
+//! - Release store publishes a slot, acquire load observes it
+//! - Full ring drops the new item and counts it (consumer owns the oldest)
+//!
+//! GrainStyle: Static allocation, explicit types, bounded loops, assertions.
+
+const std = @import("std");
+
+/// Cache line size for the target (padding between producer and consumer).
+pub const CACHE_LINE_SIZE: u32 = std.atomic.cache_line;
+
+/// SPSC ring over a power-of-two number of slots.
+/// Contract: exactly one thread calls push (producer), exactly one thread
+/// calls pop/pop_batch (consumer).
+pub fn SpscRing(comptime T: type, comptime capacity: u32) type {
+    comptime {
+        std.debug.assert(capacity > 0);
+        std.debug.assert(std.math.isPowerOfTwo(capacity));
+    }
+    return struct {
+        const Self = @This();
+        const MASK: u32 = capacity - 1;
+        pub const CAPACITY: u32 = capacity;
+
+        /// Producer-owned cache line.
+        const Producer = struct {
+            /// Next index to write (published with release).
+            head: std.atomic.Value(u32) = std.atomic.Value(u32).init(0),
+            /// Producer's last observed consumer tail.
+            cached_tail: u32 = 0,
+            /// Items dropped because the ring was full.
+            overflow_count: u64 = 0,
+        };
+
+        /// Consumer-owned cache line.
+        const Consumer = struct {
+            /// Next index to read (published with release).
+            tail: std.atomic.Value(u32) = std.atomic.Value(u32).init(0),
+            /// Consumer's last observed producer head.
+            cached_head: u32 = 0,
+        };
+
+        producer: Producer align(CACHE_LINE_SIZE) = .{},
+        consumer: Consumer align(CACHE_LINE_SIZE) = .{},
+        slots: [capacity]T align(CACHE_LINE_SIZE) = undefined,
+
+        /// Push one item (producer only).
+        /// Returns: false if the ring was full (item dropped, overflow counted).
+        pub fn push(self: *Self, item: T) bool {
+            const head = self.producer.head.raw;
+            if (head -% self.producer.cached_tail >= capacity) {
+                // Refresh the consumer's index only when we look full.
+                self.producer.cached_tail = self.consumer.tail.load(.acquire);
+                if (head -% self.producer.cached_tail >= capacity) {
+                    self.producer.overflow_count += 1;
+                    return false;
+                }
+            }
+            self.slots[head & MASK] = item;
+            self.producer.head.store(head +% 1, .release);
+
+            // Assert: Ring never holds more than capacity (postcondition).
+            std.debug.assert(head +% 1 -% self.producer.cached_tail <= capacity);
+            return true;
+        }
+
+        /// Pop one item (consumer only).
+        /// Returns: oldest item, or null if the ring is empty.
+        pub fn pop(self: *Self) ?T {
+            var one: [1]T = undefined;
+            if (self.pop_batch(&one) == 0) return null;
+            return one[0];
+        }
+
+        /// Pop up to out.len items with a single tail publish (consumer only).
+        /// Why: One acquire load and one release store per batch instead of per item.
+        /// Returns: number of items written to out.
+        pub fn pop_batch(self: *Self, out: []T) u32 {
+            const tail = self.consumer.tail.raw;
+            var available = self.consumer.cached_head -% tail;
+            if (available == 0) {
+                self.consumer.cached_head = self.producer.head.load(.acquire);
+                available = self.consumer.cached_head -% tail;
+                if (available == 0) return 0;
+            }
+            std.debug.assert(available <= capacity);
+
+            const n: u32 = @intCast(@min(available, out.len));
+            var i: u32 = 0;
+            while (i < n) : (i += 1) {
+                out[i] = self.slots[(tail +% i) & MASK];
+            }
+            self.consumer.tail.store(tail +% n, .release);
+            return n;
+        }
+
+        /// Approximate number of queued items (exact from either owning thread
+        /// when the other side is idle).
+        pub fn len(self: *const Self) u32 {
+            // Load tail first: tail never passes head, so a later head load
+            // cannot wrap the difference. Between the two loads the consumer
+            // may pop and the producer refill, so clamp to capacity.
+            const tail = self.consumer.tail.load(.acquire);
+            const head = self.producer.head.load(.acquire);
+            return @min(head -% tail, capacity);
+        }
+
+        /// Items dropped by push because the ring was full.
+        pub fn overflow_count(self: *const Self) u64 {
+            return self.producer.overflow_count;
+        }
+    };
+}
+
+/// End-to-end latency statistics (enqueue on host → delivery to kernel).
+/// Why: Input responsiveness is the user-visible metric; record it where the
+/// event is actually consumed.
+/// Note: Histogram buckets are log2(microseconds): bucket 0 = <1us,
+/// bucket k = [2^(k-1), 2^k) us, last bucket catches everything above.
+pub const LatencyStats = struct {
+    pub const BUCKET_COUNT: u32 = 24;
+
+    count: u64 = 0,
+    total_ns: u64 = 0,
+    min_ns: u64 = std.math.maxInt(u64),
+    max_ns: u64 = 0,
+    buckets: [BUCKET_COUNT]u32 = [_]u32{0} ** BUCKET_COUNT,
+
+    /// Record one delivered event's latency.
+    pub fn record(self: *LatencyStats, latency_ns: u64) void {
+        self.count += 1;
+        self.total_ns +|= latency_ns;
+        if (latency_ns < self.min_ns) self.min_ns = latency_ns;
+        if (latency_ns > self.max_ns) self.max_ns = latency_ns;
+
+        const us = latency_ns / 1000;
+        const bucket: u32 = if (us == 0) 0 else @min(BUCKET_COUNT - 1, 64 - @as(u32, @clz(us)));
+        self.buckets[bucket] += 1;
+
+        // Assert: Min never exceeds max once anything is recorded (postcondition).
+        std.debug.assert(self.min_ns <= self.max_ns);
+    }
+
+    /// Mean latency in nanoseconds (0 if nothing recorded).
+    pub fn mean_ns(self: *const LatencyStats) u64 {
+        if (self.count == 0) return 0;
+        return self.total_ns / self.count;
+    }
+};
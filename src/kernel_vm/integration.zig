@@ -4,6 +4,7 @@
 
 const std = @import("std");
 const VM = @import("vm.zig").VM;
+const InputEvent = @import("vm.zig").InputEvent;
 const basin_kernel = @import("basin_kernel");
 const BasinKernel = basin_kernel.BasinKernel;
 const BasinError = basin_kernel.BasinError;
@@ -11,6 +12,7 @@ const SyscallResult = basin_kernel.SyscallResult;
 const ProcessContext = basin_kernel.ProcessContext;
 const process_execution = basin_kernel.process_execution;
 const loadKernel = @import("loader.zig").loadKernel;
+const fb_primitives = @import("framebuffer_primitives");
 
 /// Module-level kernel pointer for syscall handler access.
 /// Why: VM syscall handler interface doesn't support closures, so we use module-level storage.
@@ -577,6 +579,26 @@ pub const Integration = struct {
     }
 };
 
+/// Serialize one input event into its 32-byte syscall wire format.
+/// Layout: [0] type, [4] kind; mouse: [5] button, [6..10] x, [10..14] y,
+/// [14] modifiers; keyboard: [8..12] key_code, [12..16] character, [16] modifiers.
+fn write_input_event(out: *[32]u8, event: InputEvent) void {
+    @memset(out, 0);
+    out[0] = event.event_type;
+    if (event.event_type == 0) {
+        out[4] = event.mouse.kind;
+        out[5] = event.mouse.button;
+        std.mem.writeInt(u32, out[6..10], event.mouse.x, .little);
+        std.mem.writeInt(u32, out[10..14], event.mouse.y, .little);
+        out[14] = event.mouse.modifiers;
+    } else {
+        out[4] = event.keyboard.kind;
+        std.mem.writeInt(u32, out[8..12], event.keyboard.key_code, .little);
+        std.mem.writeInt(u32, out[12..16], event.keyboard.character, .little);
+        out[16] = event.keyboard.modifiers;
+    }
+}
+
 /// Syscall handler wrapper (converts SyscallResult to u64).
 /// Contract:
 ///   Input: syscall_num >= 10 (kernel syscalls), user_data must be valid Integration pointer
@@ -615,49 +637,31 @@ fn syscall_handler_wrapper(
         std.debug.assert(vm_addr != 0);
         std.debug.assert(vm_addr % @alignOf(VM) == 0);
         
-        if (vm.input_event_queue.count == 0) {
-            return @as(u64, @bitCast(@as(i64, -6))); // would_block
-        }
-        
-        const event = vm.input_event_queue.dequeue() orelse {
-            return @as(u64, @bitCast(@as(i64, -6))); // would_block
-        };
-        
         if (arg1 == 0) {
             return @as(u64, @bitCast(@as(i64, -2))); // invalid_argument
         }
         
+        // arg2 = max events to drain (0 = single event, legacy callers).
+        // Why: One trap per batch instead of one per event.
         const VM_MEMORY_SIZE: u64 = 4 * 1024 * 1024;
         const EVENT_SIZE: u64 = 32;
-        if (arg1 + EVENT_SIZE > VM_MEMORY_SIZE) {
+        const MAX_BATCH_EVENTS: u64 = 64;
+        const max_events: u64 = if (arg2 == 0) 1 else @min(arg2, MAX_BATCH_EVENTS);
+        if (arg1 + max_events * EVENT_SIZE > VM_MEMORY_SIZE) {
             return @as(u64, @bitCast(@as(i64, -9))); // invalid_address
         }
         
         const event_ptr = @as([*]u8, @ptrFromInt(@as(usize, @intCast(arg1))));
-        event_ptr[0] = event.event_type;
-        event_ptr[1] = 0;
-        event_ptr[2] = 0;
-        event_ptr[3] = 0;
-        
-        if (event.event_type == 0) {
-            event_ptr[4] = event.mouse.kind;
-            event_ptr[5] = event.mouse.button;
-            @memcpy(event_ptr[6..10], &std.mem.toBytes(@as(u32, event.mouse.x)));
-            @memcpy(event_ptr[10..14], &std.mem.toBytes(@as(u32, event.mouse.y)));
-            event_ptr[14] = event.mouse.modifiers;
-            @memset(event_ptr[15..32], 0);
-        } else {
-            event_ptr[4] = event.keyboard.kind;
-            event_ptr[5] = 0;
-            event_ptr[6] = 0;
-            event_ptr[7] = 0;
-            @memcpy(event_ptr[8..12], &std.mem.toBytes(@as(u32, event.keyboard.key_code)));
-            @memcpy(event_ptr[12..16], &std.mem.toBytes(@as(u32, event.keyboard.character)));
-            event_ptr[16] = event.keyboard.modifiers;
-            @memset(event_ptr[17..32], 0);
+        var count: u64 = 0;
+        while (count < max_events) : (count += 1) {
+            const event = vm.next_input_event() orelse break;
+            write_input_event(event_ptr[@intCast(count * EVENT_SIZE)..][0..@intCast(EVENT_SIZE)], event);
+        }
+        if (count == 0) {
+            return @as(u64, @bitCast(@as(i64, -6))); // would_block
         }
         
-        return EVENT_SIZE;
+        return count * EVENT_SIZE;
     }
     
     // Handle clock_gettime syscall (needs VM access to write timespec).
@@ -697,10 +701,12 @@ fn syscall_handler_wrapper(
         }
         
         // Get time from kernel timer.
-        const time_ns: u64 = if (clock_id == 0)
+        const live_ns: u64 = if (clock_id == 0)
             kernel.timer.get_monotonic_ns()
         else
             kernel.timer.get_realtime_ns();
+        // Record/replay: host time is a nondeterministic input.
+        const time_ns: u64 = vm.read_clock_ns(live_ns);
         
         // Convert nanoseconds to seconds and nanoseconds.
         const seconds: u64 = time_ns / 1000000000;
@@ -748,17 +754,8 @@ fn syscall_handler_wrapper(
                 return @as(u64, @bitCast(@as(i64, -9))); // invalid_address
             };
             const fb_memory = vm.memory[@as(usize, @intCast(fb_phys_offset))..@as(usize, @intCast(fb_phys_offset + FRAMEBUFFER_SIZE))];
-            const r: u8 = @truncate((color >> 24) & 0xFF);
-            const g: u8 = @truncate((color >> 16) & 0xFF);
-            const b: u8 = @truncate((color >> 8) & 0xFF);
-            const a: u8 = @truncate(color & 0xFF);
-            var i: u32 = 0;
-            while (i < FRAMEBUFFER_SIZE) : (i += 4) {
-                fb_memory[i + 0] = r;
-                fb_memory[i + 1] = g;
-                fb_memory[i + 2] = b;
-                fb_memory[i + 3] = a;
-            }
+            const surface = fb_primitives.Surface.init(fb_memory, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+            _ = fb_primitives.clear(surface, color);
             // Mark entire framebuffer as dirty (clear operation changes everything).
             vm.framebuffer_dirty.mark_all();
             return 0;
@@ -823,10 +820,12 @@ fn syscall_handler_wrapper(
                 return @as(u64, @bitCast(@as(i64, -9))); // invalid_address
             };
             const text_slice = text_buf[0..text_len];
+            const fb_memory = vm.memory[@as(usize, @intCast(fb_phys_offset))..@as(usize, @intCast(fb_phys_offset + FRAMEBUFFER_SIZE))];
+            const surface = fb_primitives.Surface.init(fb_memory, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
             var char_x: u32 = x;
             var char_y: u32 = y;
-            const char_width: u32 = 8;
-            const char_height: u32 = 8;
+            const char_width: u32 = fb_primitives.GLYPH_WIDTH;
+            const char_height: u32 = fb_primitives.GLYPH_HEIGHT;
             for (text_slice) |ch| {
                 if (ch == 0) break;
                 if (ch == '\n') {
@@ -835,25 +834,11 @@ fn syscall_handler_wrapper(
                     continue;
                 }
                 if (char_x + char_width <= FRAMEBUFFER_WIDTH and char_y + char_height <= FRAMEBUFFER_HEIGHT) {
-                    var py: u32 = 0;
-                    while (py < char_height) : (py += 1) {
-                        var px: u32 = 0;
-                        while (px < char_width) : (px += 1) {
-                            const pixel_offset: u32 = ((char_y + py) * FRAMEBUFFER_WIDTH + (char_x + px)) * FRAMEBUFFER_BPP;
-                            const pixel_addr = @as(usize, @intCast(fb_phys_offset + pixel_offset));
-                            const use_fg = (px > 0 and px < char_width - 1 and py > 0 and py < char_height - 1);
-                            const pixel_color = if (use_fg) fg_color else bg_color;
-                            const r: u8 = @truncate((pixel_color >> 24) & 0xFF);
-                            const g: u8 = @truncate((pixel_color >> 16) & 0xFF);
-                            const b: u8 = @truncate((pixel_color >> 8) & 0xFF);
-                            const a: u8 = @truncate(pixel_color & 0xFF);
-                            vm.memory[pixel_addr + 0] = r;
-                            vm.memory[pixel_addr + 1] = g;
-                            vm.memory[pixel_addr + 2] = b;
-                            vm.memory[pixel_addr + 3] = a;
-                            // Mark pixel as dirty (optimization: only sync changed regions).
-                            vm.framebuffer_dirty.mark_pixel(char_x + px, char_y + py);
-                        }
+                    // Vectorized glyph expansion; mark dirty once per glyph rect.
+                    const pattern = fb_primitives.glyph_pattern(ch);
+                    const drawn = fb_primitives.draw_glyph(surface, pattern, @intCast(char_x), @intCast(char_y), fg_color, bg_color);
+                    if (drawn) |rect| {
+                        vm.framebuffer_dirty.mark_rect(rect.x, rect.y, rect.width, rect.height);
                     }
                 }
                 char_x += char_width;
@@ -1,5 +1,6 @@
 const std = @import("std");
 const builtin = @import("builtin");
+const debug_interface_mod = @import("debug_interface.zig");
 
 extern fn pthread_jit_write_protect_np(enabled: c_int) void;
 
@@ -264,6 +265,16 @@ pub const JitContext = struct {
     guest_ram: []u8,
     memory_size: u64, // VM memory size in bytes
     framebuffer_size: u32,
+    /// VM framebuffer dirty tile map (one byte per 32x32 tile), or null.
+    /// Why: Compiled stores into the framebuffer mark their tile so host
+    /// sync sees JIT drawing as well as interpreter drawing.
+    framebuffer_tile_map: ?[*]u8 = null,
+    /// VM debug interface (breakpoints), or null when not attached.
+    /// Why: Blocks end at breakpoint PCs so the host checks breakpoints once
+    /// per block entry instead of once per instruction.
+    debug: ?*const debug_interface_mod.VMDebugInterface = null,
+    /// Breakpoint generation the cached blocks were compiled against.
+    breakpoint_generation: u32 = 0,
     perf_counters: JitPerfCounters,
 
     block_cache: std.AutoHashMap(u64, u32), // Maps guest PC to code buffer offset
@@ -515,6 +526,17 @@ pub const JitContext = struct {
         std.debug.assert(self.cursor <= self.code_buffer.len);
     }
 
+    /// Store register to GuestState.pc ([x28 + 32*8]).
+    pub fn emit_str_pc(self: *JitContext, rt: u5) void {
+        std.debug.assert(self.cursor + 4 <= self.code_buffer.len);
+        std.debug.assert(self.cursor % 4 == 0);
+        const start_cursor = self.cursor;
+        const pc_index: u32 = @offsetOf(GuestState, "pc") / 8;
+        const inst = 0xF9000000 | (pc_index << 10) | (28 << 5) | @as(u32, rt);
+        self.emit_u32(inst);
+        std.debug.assert(self.cursor == start_cursor + 4);
+    }
+
     pub fn emit_and(self: *JitContext, rd: u5, rn: u5, rm: u5) void {
         std.debug.assert(self.cursor + 4 <= self.code_buffer.len);
         std.debug.assert(self.cursor % 4 == 0);
@@ -644,6 +666,46 @@ pub const JitContext = struct {
         std.debug.assert(self.cursor <= self.code_buffer.len);
     }
 
+    /// Emit framebuffer dirty tile marking for a translated store
+    /// Why: Keep the VM tile map exact for JIT stores without exiting to the host
+    /// Contract: offset_reg holds the physical offset of the store (after translation)
+    /// Sequence (x4, x5, x6 clobbered, same temps as emit_translate_address):
+    ///   x5 = offset - fb_start; if below, skip
+    ///   x5 = ((x5 >> 17) << 5) + ((x5 >> 7) & 31)   // tile_y * 32 + tile_x
+    ///   strb 1, [tile_map + x5]
+    fn emit_mark_framebuffer_tile(self: *JitContext, offset_reg: u5, tile_map: [*]u8) void {
+        std.debug.assert(offset_reg < 32);
+        std.debug.assert(self.memory_size >= self.framebuffer_size);
+        
+        const tmp1: u5 = 4;
+        const tmp2: u5 = 5;
+        const tmp3: u5 = 6;
+        const framebuffer_start: u64 = self.memory_size - @as(u64, self.framebuffer_size);
+        
+        self.emit_mov_u64(tmp1, framebuffer_start);
+        self.emit_subs(tmp2, offset_reg, tmp1); // tmp2 = offset in framebuffer, sets flags
+        self.emit_b_cond(0x3, 0); // LO (unsigned <): not a framebuffer store, will patch
+        const skip_patch_pos: u32 = self.cursor - 4;
+        
+        // Row stride 4096 bytes, tile height 32 rows: tile_y = off >> 17.
+        self.emit_lsr_i(tmp3, tmp2, 17);
+        self.emit_lsl_i(tmp3, tmp3, 5); // tmp3 = tile_y * 32
+        // Tile width 32 pixels * 4 bytes: tile_x = (off >> 7) & 31.
+        self.emit_lsr_i(tmp2, tmp2, 7);
+        self.emit_mov_imm(tmp1, 31);
+        self.emit_and(tmp2, tmp2, tmp1);
+        self.emit_add(tmp2, tmp2, tmp3); // tmp2 = tile index
+        self.emit_mov_u64(tmp1, @intFromPtr(tile_map));
+        self.emit_mov_imm(tmp3, 1);
+        self.emit_str_reg(tmp3, tmp1, tmp2, 0); // strb w6, [x4, x5]
+        
+        const skip_code_start: u32 = self.cursor;
+        const skip_diff: i32 = @as(i32, @intCast(skip_code_start)) - @as(i32, @intCast(skip_patch_pos));
+        self.patch_b_cond(skip_patch_pos, @as(i19, @intCast(skip_diff >> 2)));
+        
+        std.debug.assert(self.cursor <= self.code_buffer.len);
+    }
+
     /// Emit address translation code
     /// Why: Translate guest virtual address to physical offset in VM memory
     /// Contract: Takes guest address in addr_reg, outputs physical offset in same register
@@ -1057,6 +1119,8 @@ pub const JitContext = struct {
         self.unprotect_code();
         defer self.protect_code();
 
+        self.sync_breakpoints();
+
         const start_offset: u32 = self.cursor;
         var current_pc = guest_pc;
         var instructions_in_block: u32 = 0;
@@ -1069,9 +1133,22 @@ pub const JitContext = struct {
 
         // Cache miss: compile new block.
         self.perf_counters.cache_misses += 1;
-        self.apply_fixups(guest_pc, start_offset);
+        if (self.breaks_at(guest_pc)) {
+            // Branches into a breakpoint PC exit instead of recording fixups,
+            // so nothing can chain past the dispatcher's breakpoint check.
+            std.debug.assert(!self.pending_fixups.contains(guest_pc));
+        } else {
+            self.apply_fixups(guest_pc, start_offset);
+        }
 
         while (true) {
+            // End the block before a breakpoint PC: exit to the host with
+            // pc = breakpoint so the next block entry sees it.
+            if (instructions_in_block > 0 and self.breaks_at(current_pc)) {
+                self.emit_exit_to(current_pc);
+                break;
+            }
+
             const fetch_result = try self.fetch_inst(current_pc);
             const inst = Instruction.decode(fetch_result.inst);
 
@@ -1200,6 +1277,10 @@ pub const JitContext = struct {
 
                     // Store to memory: [x27 + x1] = x0 where x27 is mem_base
                     self.emit_str_reg(0, 27, 1, size);
+
+                    if (self.framebuffer_tile_map) |tile_map| {
+                        self.emit_mark_framebuffer_tile(1, tile_map);
+                    }
                 },
                 0x63 => { // BRANCH (B-Type)
                     self.emit_ldr_from_state(0, inst.rs1);
@@ -1216,18 +1297,36 @@ pub const JitContext = struct {
                         else => 0xE, // AL
                     };
 
-                    const patch_pos = self.cursor;
-                    self.emit_b_cond(cond, 0);
-                    try self.record_fixup(current_pc + @as(u64, @bitCast(@as(i64, inst.imm))), patch_pos);
+                    const target_pc = current_pc + @as(u64, @bitCast(@as(i64, inst.imm)));
+                    if (self.breaks_at(target_pc)) {
+                        // Taken branch exits to the dispatcher (breakpoint check).
+                        if (cond == 0xE) {
+                            self.emit_exit_to(target_pc);
+                        } else {
+                            const skip_pos = self.cursor;
+                            self.emit_b_cond(cond ^ 1, 0);
+                            self.emit_exit_to(target_pc);
+                            self.patch_branch(skip_pos, self.cursor);
+                        }
+                    } else {
+                        const patch_pos = self.cursor;
+                        self.emit_b_cond(cond, 0);
+                        try self.record_fixup(target_pc, patch_pos);
+                    }
                 },
                 0x6F => { // JAL (J-Type)
                     const ret_addr = current_pc + 4;
                     self.emit_mov_u64(0, ret_addr);
                     self.emit_str_to_state(0, inst.rd);
 
-                    const patch_pos = self.cursor;
-                    self.emit_b(0);
-                    try self.record_fixup(current_pc + @as(u64, @bitCast(@as(i64, inst.imm))), patch_pos);
+                    const target_pc = current_pc + @as(u64, @bitCast(@as(i64, inst.imm)));
+                    if (self.breaks_at(target_pc)) {
+                        self.emit_exit_to(target_pc);
+                    } else {
+                        const patch_pos = self.cursor;
+                        self.emit_b(0);
+                        try self.record_fixup(target_pc, patch_pos);
+                    }
 
                     break;
                 },
@@ -1281,28 +1380,78 @@ pub const JitContext = struct {
         return @ptrCast(@alignCast(@as(*const anyopaque, @ptrFromInt(code_ptr))));
     }
 
-    /// GrainStyle: Use explicit u32 instead of usize for code buffer offsets
+    /// Drop every compiled block and pending fixup, reusing the code buffer.
+    /// Why: Blocks chain into each other through patched branches, so a
+    /// single stale block cannot be unlinked safely; breakpoint changes are
+    /// rare, recompiling is cheap.
+    pub fn invalidate_all(self: *JitContext) void {
+        var it = self.pending_fixups.valueIterator();
+        while (it.next()) |head| {
+            var current: ?*Fixup = head.*;
+            while (current) |fixup| {
+                current = fixup.next;
+                self.allocator.destroy(fixup);
+            }
+        }
+        self.pending_fixups.clearRetainingCapacity();
+        self.block_cache.clearRetainingCapacity();
+        self.cursor = 0;
+
+        std.debug.assert(self.block_cache.count() == 0);
+    }
+
+    /// Drop cached blocks if the breakpoint set changed since they were compiled.
+    /// Why: Cached blocks may run through a new breakpoint (and are chained
+    /// via patched branches), so drop them all. Called on every block entry
+    /// and eagerly by debuggers when they change breakpoints.
+    pub fn sync_breakpoints(self: *JitContext) void {
+        if (self.debug) |debug| {
+            if (debug.breakpoint_generation != self.breakpoint_generation) {
+                self.invalidate_all();
+                self.breakpoint_generation = debug.breakpoint_generation;
+            }
+        }
+    }
+
+    /// Whether pc holds an enabled breakpoint (false when no debugger attached).
+    fn breaks_at(self: *const JitContext, pc: u64) bool {
+        const debug = self.debug orelse return false;
+        return debug.is_breakpoint(pc);
+    }
+
+    /// Exit to the host with pc = target (the dispatcher re-checks breakpoints).
+    fn emit_exit_to(self: *JitContext, target_pc: u64) void {
+        self.emit_mov_u64(0, target_pc);
+        self.emit_str_pc(0);
+        self.emit_ret();
+    }
+
+    /// Point the B or B.cond at patch_addr to target_addr.
+    fn patch_branch(self: *JitContext, patch_addr: u32, target_addr: u32) void {
+        const offset = @as(i64, @intCast(target_addr)) - @as(i64, @intCast(patch_addr));
+
+        const existing = std.mem.readInt(u32, self.code_buffer[patch_addr..][0..4], .little);
+
+        var inst: u32 = 0;
+        if ((existing & 0x7C000000) == 0x14000000) {
+            const imm26: u32 = @as(u32, @bitCast(@as(i32, @intCast(offset >> 2)))) & 0x03FFFFFF;
+            inst = 0x14000000 | imm26;
+        } else if ((existing & 0xFF000000) == 0x54000000) {
+            const imm19: u32 = @as(u32, @bitCast(@as(i32, @intCast(offset >> 2)))) & 0x7FFFF;
+            const cond = existing & 0xF;
+            inst = 0x54000000 | (imm19 << 5) | cond;
+        }
+
+        if (inst != 0) {
+            std.mem.writeInt(u32, self.code_buffer[patch_addr..][0..4], inst, .little);
+        }
+    }
+
     fn apply_fixups(self: *JitContext, target_pc: u64, target_addr: u32) void {
         if (self.pending_fixups.fetchRemove(target_pc)) |entry| {
             var current: ?*Fixup = entry.value;
             while (current) |fixup| {
-                const offset = @as(i64, @intCast(target_addr)) - @as(i64, @intCast(fixup.patch_addr));
-
-                const existing = std.mem.readInt(u32, self.code_buffer[fixup.patch_addr..][0..4], .little);
-
-                var inst: u32 = 0;
-                if ((existing & 0x7C000000) == 0x14000000) {
-                    const imm26: u32 = @as(u32, @bitCast(@as(i32, @intCast(offset >> 2)))) & 0x03FFFFFF;
-                    inst = 0x14000000 | imm26;
-                } else if ((existing & 0xFF000000) == 0x54000000) {
-                    const imm19: u32 = @as(u32, @bitCast(@as(i32, @intCast(offset >> 2)))) & 0x7FFFF;
-                    const cond = existing & 0xF;
-                    inst = 0x54000000 | (imm19 << 5) | cond;
-                }
-
-                if (inst != 0) {
-                    std.mem.writeInt(u32, self.code_buffer[fixup.patch_addr..][0..4], inst, .little);
-                }
+                self.patch_branch(fixup.patch_addr, target_addr);
 
                 const next = fixup.next;
                 self.allocator.destroy(fixup);
@@ -5,6 +5,14 @@
 pub const VM = @import("vm.zig").VM;
 pub const VMError = @import("vm.zig").VM.VMError;
 pub const FramebufferDirtyRegion = @import("vm.zig").FramebufferDirtyRegion;
+pub const DirtyTile = @import("vm.zig").DirtyTile;
+pub const FRAMEBUFFER_TILE_SIZE = @import("vm.zig").FRAMEBUFFER_TILE_SIZE;
+pub const FRAMEBUFFER_TILE_COUNT = @import("vm.zig").FRAMEBUFFER_TILE_COUNT;
+pub const framebuffer_sync = @import("framebuffer_sync.zig");
+pub const InputEvent = @import("vm.zig").InputEvent;
+pub const InputEventQueue = @import("vm.zig").InputEventQueue;
+pub const input_ring = @import("input_ring.zig");
+pub const replay = @import("replay.zig");
 pub const loadKernel = @import("loader.zig").loadKernel;
 pub const SerialOutput = @import("serial.zig").SerialOutput;
 pub const handleSyscall = @import("syscall.zig").handleSyscall;
@@ -27,4 +35,5 @@ pub const debug_interface = @import("debug_interface.zig");
 pub const state_inspection = @import("state_inspection.zig");
 pub const execution_control = @import("execution_control.zig");
 pub const debug_command = @import("debug_command.zig");
+pub const gdb_stub = @import("gdb_stub.zig");
 
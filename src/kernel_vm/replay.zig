@@ -0,0 +1,390 @@
+//! VM Record/Replay
+//!
+//! Objective: Reproduce VM runs that depend on nondeterministic inputs.
+//! Why: Host input events, clock reads, and serial input make two runs of the
+//! same kernel diverge; debugging a performance regression needs the exact run.
+//!
+//! Methodology:
+//! - Record mode logs only nondeterministic inputs, tagged with the
+//!   instruction count at which the kernel consumed them
+//! - Log format: ULEB128(instruction count delta) | kind u8 | payload
+//!   (input events and clock values are ULEB128-packed, getchar is one byte)
+//! - Polls that found nothing (no input, no serial char) are not logged:
+//!   execution up to the poll is deterministic, so replay answers "nothing"
+//!   at every instruction count that has no entry
+//! - Periodic snapshots (state_snapshot) paired with the log position allow
+//!   seek: restore the nearest earlier snapshot, then replay forward
+//! - Snapshots hold registers and guest memory only; device rings, serial
+//!   output, and host-side state are not captured (seek relies on the log to
+//!   re-deliver inputs and marks the framebuffer fully dirty)
+//!
+//! Contract: Replay requires the interpreter (JIT blocks do not count
+//! instructions individually, so snapshots and entries would misalign).
+//!
+//! GrainStyle: Static allocation, explicit types, bounded loops, assertions.
+
+const std = @import("std");
+const vm_mod = @import("vm.zig");
+const VM = vm_mod.VM;
+const InputEvent = vm_mod.InputEvent;
+const state_snapshot = @import("state_snapshot.zig");
+
+/// Backing for an unconfigured session (no log, no snapshot memory).
+var empty_buffer: [0]u8 = .{};
+
+/// Maximum snapshots kept for seek (ring, oldest overwritten).
+pub const MAX_SNAPSHOTS: u32 = 16;
+
+/// Nondeterministic input kinds.
+pub const EventKind = enum(u8) {
+    input = 1,
+    clock = 2,
+    getchar = 3,
+};
+
+pub const Mode = enum {
+    off,
+    record,
+    replay,
+};
+
+/// Decoded log entry.
+pub const Entry = struct {
+    instruction_count: u64,
+    kind: EventKind,
+    /// Clock value (ns) or getchar byte; unused for input.
+    value: u64,
+    input: InputEvent,
+};
+
+/// Compact binary log over a caller-owned buffer.
+/// Why: Caller decides log capacity (static buffer, file mapping, etc.).
+pub const Log = struct {
+    buffer: []u8,
+    /// Bytes of valid log data.
+    len: u32 = 0,
+    /// Instruction count of the last written entry (delta base for writes).
+    write_count: u64 = 0,
+    /// Replay read position and its delta base.
+    cursor: u32 = 0,
+    read_count: u64 = 0,
+    /// Entries dropped because the buffer was full (record mode).
+    overflow_count: u32 = 0,
+
+    pub fn init(buffer: []u8) Log {
+        std.debug.assert(buffer.len > 0);
+        std.debug.assert(buffer.len <= std.math.maxInt(u32));
+        return .{ .buffer = buffer };
+    }
+
+    /// Append one entry (record mode).
+    /// Returns: false if the buffer is full (entry dropped, overflow counted).
+    pub fn append(self: *Log, entry: Entry) bool {
+        std.debug.assert(entry.instruction_count >= self.write_count);
+
+        // Encode into a scratch record first so a full buffer never leaves a
+        // partial entry behind.
+        var scratch: [48]u8 = undefined;
+        var n: u32 = 0;
+        n += write_uleb(scratch[n..], entry.instruction_count - self.write_count);
+        scratch[n] = @intFromEnum(entry.kind);
+        n += 1;
+        switch (entry.kind) {
+            .clock => n += write_uleb(scratch[n..], entry.value),
+            .getchar => {
+                scratch[n] = @intCast(entry.value);
+                n += 1;
+            },
+            .input => n += encode_input(scratch[n..], entry.input),
+        }
+
+        if (self.len + n > self.buffer.len) {
+            self.overflow_count += 1;
+            return false;
+        }
+        @memcpy(self.buffer[self.len..][0..n], scratch[0..n]);
+        self.len += n;
+        self.write_count = entry.instruction_count;
+
+        // Assert: Log never exceeds buffer (postcondition).
+        std.debug.assert(self.len <= self.buffer.len);
+        return true;
+    }
+
+    /// Decode the entry at the read cursor without consuming it.
+    /// Returns: entry and the byte length it occupies, or null at end of log.
+    pub fn peek(self: *const Log) ?struct { entry: Entry, size: u32 } {
+        if (self.cursor >= self.len) return null;
+        const bytes = self.buffer[self.cursor..self.len];
+        var pos: u32 = 0;
+        const delta = read_uleb(bytes, &pos);
+        const kind: EventKind = @enumFromInt(bytes[pos]);
+        pos += 1;
+        var entry = Entry{
+            .instruction_count = self.read_count + delta,
+            .kind = kind,
+            .value = 0,
+            .input = undefined,
+        };
+        switch (kind) {
+            .clock => entry.value = read_uleb(bytes, &pos),
+            .getchar => {
+                entry.value = bytes[pos];
+                pos += 1;
+            },
+            .input => entry.input = decode_input(bytes, &pos),
+        }
+        std.debug.assert(self.cursor + pos <= self.len);
+        return .{ .entry = entry, .size = pos };
+    }
+
+    /// Consume the entry returned by the last peek.
+    pub fn advance(self: *Log, entry: Entry, size: u32) void {
+        std.debug.assert(self.cursor + size <= self.len);
+        self.cursor += size;
+        self.read_count = entry.instruction_count;
+    }
+};
+
+/// Snapshot paired with the log position at which it was taken.
+const SnapshotSlot = struct {
+    snapshot: state_snapshot.VMStateSnapshot,
+    log_len: u32,
+    log_count: u64,
+};
+
+/// Record/replay session: log, mode, and periodic snapshots.
+pub const Session = struct {
+    mode: Mode = .off,
+    log: Log = .{ .buffer = &empty_buffer },
+    /// Instruction counts between snapshots (0 = no snapshots).
+    snapshot_interval: u64 = 0,
+    next_snapshot_at: u64 = 0,
+    snapshot_memory: []u8 = &empty_buffer,
+    snapshots: [MAX_SNAPSHOTS]SnapshotSlot = undefined,
+    snapshot_len: u32 = 0,
+    snapshot_next: u32 = 0,
+    /// Replay found an entry the kernel never consumed (execution diverged).
+    diverged: bool = false,
+
+    /// Start recording into log_buffer.
+    /// Contract: snapshot_memory holds whole VM memories (one per slot), or
+    /// is empty when snapshot_interval is 0.
+    pub fn start_record(self: *Session, vm: *const VM, log_buffer: []u8, snapshot_memory: []u8, snapshot_interval: u64) void {
+        std.debug.assert(!vm.jit_enabled);
+        std.debug.assert(snapshot_interval == 0 or snapshot_memory.len >= vm.memory.len);
+        self.* = .{
+            .mode = .record,
+            .log = Log.init(log_buffer),
+            .snapshot_interval = snapshot_interval,
+            .next_snapshot_at = vm.performance.instructions_executed,
+            .snapshot_memory = snapshot_memory,
+        };
+        // Log deltas start from the count at which recording began.
+        self.log.write_count = vm.performance.instructions_executed;
+        self.log.read_count = vm.performance.instructions_executed;
+    }
+
+    /// Start replaying a recorded log from its beginning.
+    /// Contract: VM must be in the state recording started from.
+    pub fn start_replay(self: *Session, vm: *const VM, log_data: []u8, log_len: u32) void {
+        std.debug.assert(!vm.jit_enabled);
+        std.debug.assert(log_len <= log_data.len);
+        self.* = .{ .mode = .replay, .log = Log.init(log_data) };
+        self.log.len = log_len;
+        self.log.read_count = vm.performance.instructions_executed;
+    }
+
+    /// Take a snapshot if the interval elapsed (called at instruction boundaries).
+    /// Returns: any error from VMStateSnapshot.create (interval is not advanced).
+    pub fn maybe_snapshot(self: *Session, vm: *const VM) !void {
+        if (self.snapshot_interval == 0) return;
+        const count = vm.performance.instructions_executed;
+        if (count < self.next_snapshot_at) return;
+
+        const slot_count: u32 = @intCast(@min(MAX_SNAPSHOTS, self.snapshot_memory.len / vm.memory.len));
+        std.debug.assert(slot_count > 0);
+        const index = self.snapshot_next % slot_count;
+        const memory = self.snapshot_memory[@as(usize, index) * vm.memory.len ..][0..vm.memory.len];
+        self.snapshots[index] = .{
+            .snapshot = try state_snapshot.VMStateSnapshot.create(vm, memory),
+            .log_len = if (self.mode == .record) self.log.len else self.log.cursor,
+            .log_count = if (self.mode == .record) self.log.write_count else self.log.read_count,
+        };
+        self.snapshot_next = (index + 1) % slot_count;
+        if (self.snapshot_len < slot_count) self.snapshot_len += 1;
+        self.next_snapshot_at = count + self.snapshot_interval;
+    }
+
+    /// Seek to an instruction count: restore the nearest snapshot at or
+    /// before it, then replay forward.
+    /// Why: Reverse-seek without re-running from boot.
+    /// Returns: error.no_snapshot if no snapshot precedes target.
+    pub fn seek(self: *Session, vm: *VM, target_count: u64) !void {
+        std.debug.assert(self.mode != .off);
+        std.debug.assert(!vm.jit_enabled);
+
+        var best: ?u32 = null;
+        var i: u32 = 0;
+        while (i < self.snapshot_len) : (i += 1) {
+            const count = self.snapshots[i].snapshot.performance.instructions_executed;
+            if (count > target_count) continue;
+            if (best == null or count > self.snapshots[best.?].snapshot.performance.instructions_executed) {
+                best = i;
+            }
+        }
+        const slot = self.snapshots[best orelse return error.no_snapshot];
+
+        try slot.snapshot.restore(vm);
+        vm.framebuffer_dirty.mark_all();
+        if (self.mode == .record) {
+            // Everything recorded so far becomes the replay script.
+            self.mode = .replay;
+        }
+        self.log.cursor = slot.log_len;
+        self.log.read_count = slot.log_count;
+        self.diverged = false;
+        // Keep existing snapshots; do not retake them while replaying forward.
+        self.next_snapshot_at = std.math.maxInt(u64);
+
+        vm.state = .running;
+        while (vm.performance.instructions_executed < target_count and vm.state == .running) {
+            try vm.step();
+        }
+
+        // Assert: Landed exactly on target unless the run ended first (postcondition).
+        std.debug.assert(vm.performance.instructions_executed == target_count or vm.state != .running);
+    }
+
+    /// Record or replay an input-event poll.
+    /// Contract: live is only consulted in record/off modes.
+    pub fn filter_input(self: *Session, count: u64, live: ?InputEvent) ?InputEvent {
+        switch (self.mode) {
+            .off => return live,
+            .record => {
+                if (live) |event| _ = self.log.append(.{ .instruction_count = count, .kind = .input, .value = 0, .input = event });
+                return live;
+            },
+            .replay => {
+                const next = self.take(count, .input) orelse return null;
+                return next.input;
+            },
+        }
+    }
+
+    /// Record or replay a clock read.
+    pub fn filter_clock(self: *Session, count: u64, live_ns: u64) u64 {
+        switch (self.mode) {
+            .off => return live_ns,
+            .record => {
+                _ = self.log.append(.{ .instruction_count = count, .kind = .clock, .value = live_ns, .input = undefined });
+                return live_ns;
+            },
+            .replay => {
+                const next = self.take(count, .clock) orelse return live_ns;
+                return next.value;
+            },
+        }
+    }
+
+    /// Record or replay a console getchar.
+    pub fn filter_getchar(self: *Session, count: u64, live: ?u8) ?u8 {
+        switch (self.mode) {
+            .off => return live,
+            .record => {
+                if (live) |ch| _ = self.log.append(.{ .instruction_count = count, .kind = .getchar, .value = ch, .input = undefined });
+                return live;
+            },
+            .replay => {
+                const next = self.take(count, .getchar) orelse return null;
+                return @intCast(next.value);
+            },
+        }
+    }
+
+    /// Consume the next entry if it belongs to this instruction and kind.
+    fn take(self: *Session, count: u64, kind: EventKind) ?Entry {
+        const peeked = self.log.peek() orelse return null;
+        if (peeked.entry.instruction_count < count) {
+            // Kernel skipped a recorded input: execution no longer matches.
+            self.diverged = true;
+            return null;
+        }
+        if (peeked.entry.instruction_count != count or peeked.entry.kind != kind) return null;
+        self.log.advance(peeked.entry, peeked.size);
+        return peeked.entry;
+    }
+};
+
+fn write_uleb(out: []u8, value: u64) u32 {
+    var v = value;
+    var n: u32 = 0;
+    while (true) {
+        const byte: u8 = @truncate(v & 0x7F);
+        v >>= 7;
+        if (v == 0) {
+            out[n] = byte;
+            return n + 1;
+        }
+        out[n] = byte | 0x80;
+        n += 1;
+        std.debug.assert(n < 10);
+    }
+}
+
+fn read_uleb(bytes: []const u8, pos: *u32) u64 {
+    var result: u64 = 0;
+    var shift: u32 = 0;
+    while (shift < 64) : (shift += 7) {
+        const byte = bytes[pos.*];
+        pos.* += 1;
+        result |= @as(u64, byte & 0x7F) << @intCast(shift);
+        if (byte & 0x80 == 0) break;
+    }
+    return result;
+}
+
+fn encode_input(out: []u8, event: InputEvent) u32 {
+    var n: u32 = 0;
+    out[n] = event.event_type;
+    n += 1;
+    if (event.event_type == 0) {
+        out[n] = event.mouse.kind;
+        out[n + 1] = event.mouse.button;
+        out[n + 2] = event.mouse.modifiers;
+        n += 3;
+        n += write_uleb(out[n..], event.mouse.x);
+        n += write_uleb(out[n..], event.mouse.y);
+    } else {
+        out[n] = event.keyboard.kind;
+        out[n + 1] = event.keyboard.modifiers;
+        n += 2;
+        n += write_uleb(out[n..], event.keyboard.key_code);
+        n += write_uleb(out[n..], event.keyboard.character);
+    }
+    return n;
+}
+
+fn decode_input(bytes: []const u8, pos: *u32) InputEvent {
+    var event = InputEvent{
+        .event_type = bytes[pos.*],
+        .mouse = .{ .kind = 0, .button = 0, .x = 0, .y = 0, .modifiers = 0 },
+        .keyboard = .{ .kind = 0, .key_code = 0, .character = 0, .modifiers = 0 },
+    };
+    pos.* += 1;
+    if (event.event_type == 0) {
+        event.mouse.kind = bytes[pos.*];
+        event.mouse.button = bytes[pos.* + 1];
+        event.mouse.modifiers = bytes[pos.* + 2];
+        pos.* += 3;
+        event.mouse.x = @intCast(read_uleb(bytes, pos));
+        event.mouse.y = @intCast(read_uleb(bytes, pos));
+    } else {
+        event.keyboard.kind = bytes[pos.*];
+        event.keyboard.modifiers = bytes[pos.* + 1];
+        pos.* += 2;
+        event.keyboard.key_code = @intCast(read_uleb(bytes, pos));
+        event.keyboard.character = @intCast(read_uleb(bytes, pos));
+    }
+    return event;
+}
@@ -50,7 +50,11 @@ pub const ExceptionStatsSnapshot = struct {
 /// VM state snapshot (complete VM state capture).
 /// Why: Enable state persistence, debugging, and reproducible execution.
 /// GrainStyle: Explicit types, static allocation, deterministic encoding.
-/// Note: Snapshot includes all VM state except JIT code buffer (can be recompiled).
+/// Note: Snapshot covers guest-visible CPU and memory state only. It leaves out
+/// device and host state: input event and console input rings, serial output,
+/// framebuffer dirty map, syscall/permission handlers (and the kernel state
+/// behind them), JIT code cache, debug breakpoints/watchpoints, and the stats
+/// modules. Callers that restore mid-run must reset or replay those themselves.
 pub const VMStateSnapshot = struct {
     /// Register file (32 GP registers + PC).
     /// Why: Capture all register state for complete restoration.
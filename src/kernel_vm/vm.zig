@@ -14,6 +14,9 @@ const branch_stats_mod = @import("branch_stats.zig");
 const register_stats_mod = @import("register_stats.zig");
 const instruction_perf_mod = @import("instruction_perf.zig");
 const debug_interface_mod = @import("debug_interface.zig");
+const fb_primitives = @import("framebuffer_primitives");
+const input_ring = @import("input_ring.zig");
+const replay_mod = @import("replay.zig");
 
 /// Pure Zig RISC-V64 emulator for kernel development.
 /// Grain Style: Static allocation where possible, comprehensive assertions,
@@ -46,52 +49,166 @@ pub const InputEvent = struct {
     };
 };
 
-/// Input event queue (bounded circular buffer).
-/// Why: Buffer input events for kernel to read via syscalls.
+/// Input event queue (lock-free SPSC ring between host and VM).
+/// Why: Host thread injects events, VM thread drains them via syscalls; an
+/// unsynchronized ring corrupts indices once those are different threads.
 /// GrainStyle: Static allocation, bounded queue, deterministic behavior.
-/// Note: Max 64 events (sufficient for interactive input, prevents overflow).
-const MAX_INPUT_EVENTS: u32 = 64;
+/// Note: Producer side is enqueue (host); everything else is consumer side (VM).
+const MAX_INPUT_EVENTS: u32 = 256;
+/// Events drained from the ring per refill (one "frame" of input).
+const INPUT_BATCH_SIZE: u32 = 64;
 pub const InputEventQueue = struct {
-    /// Event buffer (circular queue)
-    events: [MAX_INPUT_EVENTS]InputEvent = [_]InputEvent{undefined} ** MAX_INPUT_EVENTS,
-    /// Write index (next position to write)
-    write_idx: u32 = 0,
-    /// Read index (next position to read)
-    read_idx: u32 = 0,
-    /// Number of events in queue
-    count: u32 = 0,
-    
+    /// Ring slot: event plus host enqueue time for latency measurement.
+    pub const TimedEvent = struct {
+        event: InputEvent,
+        enqueue_ns: u64,
+    };
+    const Ring = input_ring.SpscRing(TimedEvent, MAX_INPUT_EVENTS);
+
+    /// Shared ring (producer and consumer lines are cache-line padded).
+    ring: Ring = .{},
+    /// Consumer-side staging batch (coalesced).
+    batch: [INPUT_BATCH_SIZE]TimedEvent = undefined,
+    batch_len: u32 = 0,
+    batch_pos: u32 = 0,
+    /// Mouse moves merged into a later move (consumer side).
+    coalesced_count: u64 = 0,
+    /// Enqueue-to-delivery latency (consumer side).
+    latency: input_ring.LatencyStats = .{},
+
+    /// Enqueue event (host/producer thread).
+    /// Returns: false if the ring was full (event dropped, overflow counted).
+    pub fn enqueue(self: *InputEventQueue, event: InputEvent) bool {
+        return self.enqueue_at(event, monotonic_ns());
+    }
+
+    /// Enqueue with explicit timestamp (deterministic tests, replay).
+    pub fn enqueue_at(self: *InputEventQueue, event: InputEvent, now_ns: u64) bool {
+        std.debug.assert(event.event_type < 2);
+        return self.ring.push(.{ .event = event, .enqueue_ns = now_ns });
+    }
+
     /// Dequeue event (for kernel to read).
     /// Why: Kernel reads events via syscall.
     /// Returns: event if available, null if queue empty.
     pub fn dequeue(self: *InputEventQueue) ?InputEvent {
-        if (self.count == 0) {
-            return null;
+        return self.dequeue_at(monotonic_ns());
+    }
+
+    /// Dequeue with explicit delivery timestamp (deterministic tests, replay).
+    pub fn dequeue_at(self: *InputEventQueue, now_ns: u64) ?InputEvent {
+        if (self.batch_pos == self.batch_len) {
+            self.refill_batch();
+            if (self.batch_len == 0) return null;
         }
-        
-        const event = self.events[self.read_idx];
-        self.read_idx = (self.read_idx + 1) % MAX_INPUT_EVENTS;
-        self.count -= 1;
-        
-        // Assert: count must be consistent.
-        std.debug.assert(self.count < MAX_INPUT_EVENTS);
-        
-        return event;
+        const timed = self.batch[self.batch_pos];
+        self.batch_pos += 1;
+        self.latency.record(now_ns -| timed.enqueue_ns);
+
+        // Assert: Staging cursor within batch (postcondition).
+        std.debug.assert(self.batch_pos <= self.batch_len);
+        return timed.event;
     }
-    
-    /// Get queue size (number of events available).
+
+    /// Drain up to out.len events at once (coalesced, latency recorded).
+    /// Returns: number of events written to out.
+    pub fn dequeue_batch(self: *InputEventQueue, out: []InputEvent) u32 {
+        const now_ns = monotonic_ns();
+        var n: u32 = 0;
+        while (n < out.len) : (n += 1) {
+            out[n] = self.dequeue_at(now_ns) orelse break;
+        }
+        return n;
+    }
+
+    /// Get queue size (number of events available, before coalescing).
     pub fn size(self: *const InputEventQueue) u32 {
-        return self.count;
+        return self.ring.len() + (self.batch_len - self.batch_pos);
+    }
+
+    /// Events dropped because the ring was full.
+    pub fn overflow_count(self: *const InputEventQueue) u64 {
+        return self.ring.overflow_count();
+    }
+
+    /// Pull one batch from the ring, keeping only the latest of consecutive
+    /// mouse moves (same kind, button, modifiers).
+    /// Why: A fast mouse produces many moves per frame; the kernel only needs
+    /// the final position. Latency keeps the earliest enqueue time of the run
+    /// so coalescing never hides queueing delay.
+    fn refill_batch(self: *InputEventQueue) void {
+        std.debug.assert(self.batch_pos == self.batch_len);
+        const raw_len = self.ring.pop_batch(&self.batch);
+        var out: u32 = 0;
+        var i: u32 = 0;
+        while (i < raw_len) : (i += 1) {
+            const timed = self.batch[i];
+            if (out > 0 and is_coalescable_move(self.batch[out - 1].event, timed.event)) {
+                self.batch[out - 1].event = timed.event;
+                self.coalesced_count += 1;
+                continue;
+            }
+            self.batch[out] = timed;
+            out += 1;
+        }
+        self.batch_len = out;
+        self.batch_pos = 0;
+
+        // Assert: Coalescing only shrinks the batch (postcondition).
+        std.debug.assert(self.batch_len <= raw_len);
+    }
+
+    fn is_coalescable_move(prev: InputEvent, next: InputEvent) bool {
+        if (prev.event_type != 0 or next.event_type != 0) return false;
+        const is_motion = next.mouse.kind == 2 or next.mouse.kind == 3; // move, drag
+        return is_motion and prev.mouse.kind == next.mouse.kind and
+            prev.mouse.button == next.mouse.button and
+            prev.mouse.modifiers == next.mouse.modifiers;
+    }
+
+    // Why: Latency needs a clock that never steps backwards; wall time
+    // (nanoTimestamp) jumps with NTP. Instants are measured from the first
+    // call, set once for both the host and VM threads.
+    var clock_origin: ?std.time.Instant = null;
+    var clock_origin_once = std.once(set_clock_origin);
+
+    fn set_clock_origin() void {
+        clock_origin = std.time.Instant.now() catch null;
+    }
+
+    fn monotonic_ns() u64 {
+        clock_origin_once.call();
+        const origin = clock_origin orelse return 0;
+        const now = std.time.Instant.now() catch return 0;
+        return now.since(origin);
     }
 };
 
+/// Framebuffer dirty tile geometry (32x32 pixel tiles over 1024x768).
+/// Why: Tiles are the unit of host sync; 32 divides both dimensions, so
+/// every tile is full-size and tile indices are pure shifts.
+pub const FRAMEBUFFER_TILE_SIZE: u32 = 32;
+pub const FRAMEBUFFER_TILES_X: u32 = 1024 / FRAMEBUFFER_TILE_SIZE;
+pub const FRAMEBUFFER_TILES_Y: u32 = 768 / FRAMEBUFFER_TILE_SIZE;
+pub const FRAMEBUFFER_TILE_COUNT: u32 = FRAMEBUFFER_TILES_X * FRAMEBUFFER_TILES_Y;
+
+/// Dirty tile in pixel coordinates (always TILE_SIZE x TILE_SIZE).
+/// Why: Host backends upload rects, not tile indices; reuse the drawing
+/// primitives' rect so damage and tiles share one type.
+pub const DirtyTile = fb_primitives.Rect;
+
 /// Framebuffer dirty region tracking.
 /// Why: Optimize framebuffer sync by only copying changed regions.
 /// GrainStyle: Static allocation, explicit types, bounded regions.
-/// Note: Tracks single rectangular region (can be expanded to multiple regions if needed).
+/// Note: Tracks a bounding box plus a per-tile map; the bounding box stays for
+/// cheap "anything dirty?" queries, the tile map drives the actual sync.
 pub const FramebufferDirtyRegion = struct {
     /// Whether any region is dirty (optimization: skip tracking if false).
     is_dirty: bool = false,
+    /// One byte per 32x32 tile, non-zero when dirty (row-major, 32 per row).
+    /// Why: Byte (not bit) per tile so interpreter and JIT stores mark a tile
+    /// with a single store and no read-modify-write.
+    tiles: [FRAMEBUFFER_TILE_COUNT]u8 = [_]u8{0} ** FRAMEBUFFER_TILE_COUNT,
     /// Minimum X coordinate of dirty region (inclusive).
     min_x: u32 = 0,
     /// Minimum Y coordinate of dirty region (inclusive).
@@ -125,6 +242,49 @@ pub const FramebufferDirtyRegion = struct {
             if (x + 1 > self.max_x) self.max_x = x + 1;
             if (y + 1 > self.max_y) self.max_y = y + 1;
         }
+        self.tiles[(y / FRAMEBUFFER_TILE_SIZE) * FRAMEBUFFER_TILES_X + x / FRAMEBUFFER_TILE_SIZE] = 1;
+        
+        // Assert: Region bounds must be valid (postcondition).
+        std.debug.assert(self.min_x < self.max_x);
+        std.debug.assert(self.min_y < self.max_y);
+        std.debug.assert(self.max_x <= FRAMEBUFFER_WIDTH);
+        std.debug.assert(self.max_y <= FRAMEBUFFER_HEIGHT);
+    }
+    
+    /// Mark rectangle as dirty.
+    /// Why: Drawing primitives report the clipped rect they touched; one
+    /// bounds update per rect instead of one per pixel.
+    /// Contract: rectangle must be non-empty and within framebuffer bounds.
+    pub fn mark_rect(self: *FramebufferDirtyRegion, x: u32, y: u32, width: u32, height: u32) void {
+        const FRAMEBUFFER_WIDTH: u32 = 1024;
+        const FRAMEBUFFER_HEIGHT: u32 = 768;
+        std.debug.assert(width > 0);
+        std.debug.assert(height > 0);
+        std.debug.assert(x + width <= FRAMEBUFFER_WIDTH);
+        std.debug.assert(y + height <= FRAMEBUFFER_HEIGHT);
+        
+        if (!self.is_dirty) {
+            self.is_dirty = true;
+            self.min_x = x;
+            self.min_y = y;
+            self.max_x = x + width;
+            self.max_y = y + height;
+        } else {
+            if (x < self.min_x) self.min_x = x;
+            if (y < self.min_y) self.min_y = y;
+            if (x + width > self.max_x) self.max_x = x + width;
+            if (y + height > self.max_y) self.max_y = y + height;
+        }
+        
+        // Mark every tile the rect overlaps (rows of the tile map are contiguous).
+        const tile_x0 = x / FRAMEBUFFER_TILE_SIZE;
+        const tile_x1 = (x + width - 1) / FRAMEBUFFER_TILE_SIZE;
+        var tile_y = y / FRAMEBUFFER_TILE_SIZE;
+        const tile_y1 = (y + height - 1) / FRAMEBUFFER_TILE_SIZE;
+        while (tile_y <= tile_y1) : (tile_y += 1) {
+            const row = tile_y * FRAMEBUFFER_TILES_X;
+            @memset(self.tiles[row + tile_x0 .. row + tile_x1 + 1], 1);
+        }
         
         // Assert: Region bounds must be valid (postcondition).
         std.debug.assert(self.min_x < self.max_x);
@@ -144,6 +304,7 @@ pub const FramebufferDirtyRegion = struct {
         self.min_y = 0;
         self.max_x = FRAMEBUFFER_WIDTH;
         self.max_y = FRAMEBUFFER_HEIGHT;
+        @memset(&self.tiles, 1);
         
         // Assert: Region must cover entire framebuffer (postcondition).
         std.debug.assert(self.min_x == 0);
@@ -160,11 +321,65 @@ pub const FramebufferDirtyRegion = struct {
         self.min_y = 0;
         self.max_x = 0;
         self.max_y = 0;
+        @memset(&self.tiles, 0);
         
         // Assert: Region must be cleared (postcondition).
         std.debug.assert(!self.is_dirty);
     }
     
+    /// Mark bytes written at a framebuffer byte offset as dirty.
+    /// Why: Guest stores know a byte offset, not pixel coordinates.
+    /// Contract: offset + len must be within the 1024x768x4 framebuffer.
+    pub fn mark_offset(self: *FramebufferDirtyRegion, offset: u64, len: u32) void {
+        const FRAMEBUFFER_BYTES: u64 = 1024 * 768 * 4;
+        std.debug.assert(len > 0);
+        std.debug.assert(offset + len <= FRAMEBUFFER_BYTES);
+        
+        const first_pixel: u32 = @intCast(offset / 4);
+        const last_pixel: u32 = @intCast((offset + len - 1) / 4);
+        // Stores are naturally aligned (at most 8 bytes), so both pixels
+        // share a row (row stride 4096 bytes is a multiple of 8).
+        std.debug.assert(first_pixel / 1024 == last_pixel / 1024);
+        self.mark_rect(first_pixel % 1024, first_pixel / 1024, last_pixel - first_pixel + 1, 1);
+    }
+    
+    /// Collect dirty tiles as pixel rects and reset tracking.
+    /// Why: Host sync copies and uploads exactly these tiles.
+    /// Contract: out must hold FRAMEBUFFER_TILE_COUNT entries (worst case).
+    /// Returns: number of tiles written to out.
+    pub fn take_dirty_tiles(self: *FramebufferDirtyRegion, out: []DirtyTile) u32 {
+        std.debug.assert(out.len >= FRAMEBUFFER_TILE_COUNT);
+        
+        // Scan the tile map unconditionally: JIT stores set tile bytes
+        // directly without updating the bounding box.
+        const Row = @Vector(FRAMEBUFFER_TILES_X, u8);
+        const zero: Row = @splat(0);
+        var count: u32 = 0;
+        var tile_y: u32 = 0;
+        while (tile_y < FRAMEBUFFER_TILES_Y) : (tile_y += 1) {
+            const row_start = tile_y * FRAMEBUFFER_TILES_X;
+            // Skip clean tile rows with one vector compare.
+            const row: Row = self.tiles[row_start..][0..FRAMEBUFFER_TILES_X].*;
+            if (!@reduce(.Or, row != zero)) continue;
+            var tile_x: u32 = 0;
+            while (tile_x < FRAMEBUFFER_TILES_X) : (tile_x += 1) {
+                if (self.tiles[row_start + tile_x] == 0) continue;
+                out[count] = .{
+                    .x = tile_x * FRAMEBUFFER_TILE_SIZE,
+                    .y = tile_y * FRAMEBUFFER_TILE_SIZE,
+                    .width = FRAMEBUFFER_TILE_SIZE,
+                    .height = FRAMEBUFFER_TILE_SIZE,
+                };
+                count += 1;
+            }
+        }
+        self.clear();
+        
+        // Assert: Tile count bounded by tile map size (postcondition).
+        std.debug.assert(count <= FRAMEBUFFER_TILE_COUNT);
+        return count;
+    }
+    
     /// Get dirty region bounds (if dirty).
     /// Why: Query dirty region for optimized sync.
     /// Returns: true if dirty, false if clean.
@@ -351,9 +566,35 @@ pub const VM = struct {
     /// Why: Provide breakpoints, watchpoints, and step debugging capabilities.
     /// GrainStyle: Static allocation, bounded arrays, explicit types.
     debug_interface: debug_interface_mod.VMDebugInterface = debug_interface_mod.VMDebugInterface.init(),
+    /// Host-fed serial input for SBI CONSOLE_GETCHAR (host thread produces).
+    console_input: input_ring.SpscRing(u8, 256) = .{},
+    /// Record/replay of nondeterministic inputs (input events, clock, getchar).
+    /// Why: Reproduce a run exactly for debugging; off by default.
+    replay: replay_mod.Session = .{},
 
     const Self = @This();
 
+    /// Inject a serial input character (host side).
+    /// Returns: false if the console input ring is full (character dropped).
+    pub fn inject_console_char(self: *Self, ch: u8) bool {
+        return self.console_input.push(ch);
+    }
+
+    /// Next input event for the kernel (record/replay aware).
+    /// Why: Single consumption point for input so recording sees exactly
+    /// what the kernel saw, and replay ignores live host input.
+    pub fn next_input_event(self: *Self) ?InputEvent {
+        const count = self.performance.instructions_executed;
+        const live: ?InputEvent = if (self.replay.mode == .replay) null else self.input_event_queue.dequeue();
+        return self.replay.filter_input(count, live);
+    }
+
+    /// Clock value for the kernel (record/replay aware).
+    /// Why: Host time is nondeterministic; replay returns the recorded value.
+    pub fn read_clock_ns(self: *Self, live_ns: u64) u64 {
+        return self.replay.filter_clock(self.performance.instructions_executed, live_ns);
+    }
+
     /// Inject mouse event into VM input queue.
     /// Why: Route macOS mouse events to kernel via VM.
     /// GrainStyle: Explicit bounds checking, deterministic encoding.
@@ -390,18 +631,9 @@ pub const VM = struct {
             },
         };
         
-        // Enqueue event (handle queue full by dropping oldest).
-        if (self.input_event_queue.count >= MAX_INPUT_EVENTS) {
-            self.input_event_queue.read_idx = (self.input_event_queue.read_idx + 1) % MAX_INPUT_EVENTS;
-            self.input_event_queue.count -= 1;
-        }
-        
-        self.input_event_queue.events[self.input_event_queue.write_idx] = input_event;
-        self.input_event_queue.write_idx = (self.input_event_queue.write_idx + 1) % MAX_INPUT_EVENTS;
-        self.input_event_queue.count += 1;
-        
-        // Assert: Event must be enqueued (queue size increased or oldest dropped).
-        std.debug.assert(self.input_event_queue.count <= MAX_INPUT_EVENTS);
+        // Enqueue event (ring full drops this event and counts the overflow;
+        // the oldest slot belongs to the consumer thread).
+        _ = self.input_event_queue.enqueue(input_event);
     }
     
     /// Inject keyboard event into VM input queue.
@@ -433,18 +665,9 @@ pub const VM = struct {
             },
         };
         
-        // Enqueue event (handle queue full by dropping oldest).
-        if (self.input_event_queue.count >= MAX_INPUT_EVENTS) {
-            self.input_event_queue.read_idx = (self.input_event_queue.read_idx + 1) % MAX_INPUT_EVENTS;
-            self.input_event_queue.count -= 1;
-        }
-        
-        self.input_event_queue.events[self.input_event_queue.write_idx] = input_event;
-        self.input_event_queue.write_idx = (self.input_event_queue.write_idx + 1) % MAX_INPUT_EVENTS;
-        self.input_event_queue.count += 1;
-        
-        // Assert: Event must be enqueued (queue size increased or oldest dropped).
-        std.debug.assert(self.input_event_queue.count <= MAX_INPUT_EVENTS);
+        // Enqueue event (ring full drops this event and counts the overflow;
+        // the oldest slot belongs to the consumer thread).
+        _ = self.input_event_queue.enqueue(input_event);
     }
 
     pub const VMState = enum {
@@ -554,6 +777,8 @@ pub const VM = struct {
         
         const jit_ctx = try allocator.create(jit_mod.JitContext);
         jit_ctx.* = try jit_mod.JitContext.init(allocator, &guest_state, target.memory[0..target.memory_size], target.memory_size);
+        jit_ctx.framebuffer_tile_map = &target.framebuffer_dirty.tiles;
+        jit_ctx.debug = &target.debug_interface;
         target.jit = jit_ctx;
         target.jit_enabled = true;
         
@@ -574,6 +799,16 @@ pub const VM = struct {
         const jit_ctx = self.jit.?;
         const pc = self.regs.pc;
         
+        // Watchpoints and single-step need per-access / per-instruction
+        // checks: run those sessions on the interpreter.
+        if (self.debug_interface.armed_watchpoints != 0 or self.debug_interface.step_mode) {
+            return self.step();
+        }
+        // Blocks end at breakpoint PCs, so checking block entry is enough.
+        if (self.debug_interface.armed_breakpoints != 0 and self.debug_interface.check_breakpoint(pc)) {
+            return;
+        }
+        
         // Check cache first (avoid compilation if already compiled).
         const compile_start = std.time.nanoTimestamp();
         const func = jit_ctx.compile_block(pc) catch {
@@ -632,6 +867,8 @@ pub const VM = struct {
         const FRAMEBUFFER_SIZE: u32 = 1024 * 768 * 4; // 3MB
         jit_ctx.* = try jit_mod.JitContext.init(allocator, &guest_state, self.memory[0..self.memory_size], self.memory_size);
         jit_ctx.framebuffer_size = FRAMEBUFFER_SIZE;
+        jit_ctx.framebuffer_tile_map = &self.framebuffer_dirty.tiles;
+        jit_ctx.debug = &self.debug_interface;
         self.jit = jit_ctx;
         self.jit_enabled = true;
         
@@ -756,10 +993,22 @@ pub const VM = struct {
         return self.memory[@intCast(framebuffer_offset)..][0..FRAMEBUFFER_SIZE];
     }
 
+    /// Mark framebuffer tiles touched by a guest store.
+    /// Why: Guest drawing goes through plain stores; host sync needs to know
+    /// which tiles they hit without diffing the whole framebuffer.
+    /// Contract: phys_offset + len already bounds-checked against memory_size.
+    fn mark_framebuffer_store(self: *Self, phys_offset: u64, len: u32) void {
+        const FRAMEBUFFER_SIZE: u64 = 1024 * 768 * 4; // 3MB
+        const framebuffer_offset: u64 = self.memory_size - FRAMEBUFFER_SIZE;
+        std.debug.assert(phys_offset + len <= self.memory_size);
+        if (phys_offset < framebuffer_offset) return;
+        self.framebuffer_dirty.mark_offset(phys_offset - framebuffer_offset, len);
+    }
+
     /// Initialize framebuffer from host-side code
     /// Why: Set up framebuffer before kernel starts, clear to background, draw test pattern
     /// Contract: Initializes framebuffer memory with test pattern for visual verification
-    /// GrainStyle: Explicit assertions, bounded execution, static allocation, no external dependencies
+    /// GrainStyle: Explicit assertions, bounded execution, static allocation
     pub fn init_framebuffer(self: *Self) void {
         // Mark entire framebuffer as dirty (initialization changes everything).
         self.framebuffer_dirty.mark_all();
@@ -788,20 +1037,12 @@ pub const VM = struct {
         
         // Clear framebuffer to dark background color
         // Why: Fill entire framebuffer with background color before drawing test pattern
-        const bg_r: u8 = @truncate((COLOR_DARK_BG >> 24) & 0xFF);
-        const bg_g: u8 = @truncate((COLOR_DARK_BG >> 16) & 0xFF);
-        const bg_b: u8 = @truncate((COLOR_DARK_BG >> 8) & 0xFF);
-        const bg_a: u8 = @truncate(COLOR_DARK_BG & 0xFF);
-        
-        var i: u32 = 0;
-        while (i < FRAMEBUFFER_SIZE) : (i += 4) {
-            fb_memory[i + 0] = bg_r;
-            fb_memory[i + 1] = bg_g;
-            fb_memory[i + 2] = bg_b;
-            fb_memory[i + 3] = bg_a;
-        }
+        // Note: Shared vectorized primitives (same code path as kernel and grain_os).
+        const surface = fb_primitives.Surface.init(fb_memory, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+        _ = fb_primitives.clear(surface, COLOR_DARK_BG);
         
         // Assert: framebuffer must be cleared (check first and last pixel)
+        const bg_r: u8 = @truncate((COLOR_DARK_BG >> 24) & 0xFF);
         std.debug.assert(fb_memory[0] == bg_r);
         std.debug.assert(fb_memory[FRAMEBUFFER_SIZE - 4] == bg_r);
         
@@ -809,53 +1050,20 @@ pub const VM = struct {
         // Why: Visual verification that framebuffer is working correctly
         const rect_size: u32 = 100;
         const spacing: u32 = 20;
-        
-        // Helper: Draw a filled rectangle
-        // Why: Reusable drawing primitive for test pattern
-        const draw_rect = struct {
-            fn draw(memory: []u8, x: u32, y: u32, w: u32, h: u32, color: u32) void {
-                std.debug.assert(x < FRAMEBUFFER_WIDTH);
-                std.debug.assert(y < FRAMEBUFFER_HEIGHT);
-                std.debug.assert(x + w <= FRAMEBUFFER_WIDTH);
-                std.debug.assert(y + h <= FRAMEBUFFER_HEIGHT);
-                std.debug.assert(w > 0);
-                std.debug.assert(h > 0);
-                
-                const r: u8 = @truncate((color >> 24) & 0xFF);
-                const g: u8 = @truncate((color >> 16) & 0xFF);
-                const b: u8 = @truncate((color >> 8) & 0xFF);
-                const a: u8 = @truncate(color & 0xFF);
-                
-                var py: u32 = y;
-                while (py < y + h) : (py += 1) {
-                    var px: u32 = x;
-                    while (px < x + w) : (px += 1) {
-                        const offset: u32 = (py * FRAMEBUFFER_WIDTH + px) * FRAMEBUFFER_BPP;
-                        std.debug.assert(offset + 3 < FRAMEBUFFER_SIZE);
-                        memory[offset + 0] = r;
-                        memory[offset + 1] = g;
-                        memory[offset + 2] = b;
-                        memory[offset + 3] = a;
-                    }
-                }
-                
-                // Assert: rectangle must be drawn (check top-left corner)
-                const corner_offset: u32 = (y * FRAMEBUFFER_WIDTH + x) * FRAMEBUFFER_BPP;
-                std.debug.assert(memory[corner_offset] == r);
-            }
-        }.draw;
+        const far_x: i32 = @intCast(FRAMEBUFFER_WIDTH - rect_size - spacing);
+        const far_y: i32 = @intCast(FRAMEBUFFER_HEIGHT - rect_size - spacing);
         
         // Red rectangle (top-left)
-        draw_rect(fb_memory, spacing, spacing, rect_size, rect_size, COLOR_RED);
+        _ = fb_primitives.fill_rect(surface, spacing, spacing, rect_size, rect_size, COLOR_RED);
         
         // Green rectangle (top-right)
-        draw_rect(fb_memory, FRAMEBUFFER_WIDTH - rect_size - spacing, spacing, rect_size, rect_size, COLOR_GREEN);
+        _ = fb_primitives.fill_rect(surface, far_x, spacing, rect_size, rect_size, COLOR_GREEN);
         
         // Blue rectangle (bottom-left)
-        draw_rect(fb_memory, spacing, FRAMEBUFFER_HEIGHT - rect_size - spacing, rect_size, rect_size, COLOR_BLUE);
+        _ = fb_primitives.fill_rect(surface, spacing, far_y, rect_size, rect_size, COLOR_BLUE);
         
         // White rectangle (bottom-right)
-        draw_rect(fb_memory, FRAMEBUFFER_WIDTH - rect_size - spacing, FRAMEBUFFER_HEIGHT - rect_size - spacing, rect_size, rect_size, COLOR_WHITE);
+        _ = fb_primitives.fill_rect(surface, far_x, far_y, rect_size, rect_size, COLOR_WHITE);
         
         // Assert: test pattern must be drawn (check first red pixel)
         const red_offset: u32 = (spacing * FRAMEBUFFER_WIDTH + spacing) * FRAMEBUFFER_BPP;
@@ -863,130 +1071,9 @@ pub const VM = struct {
         
         // Draw boot message text
         // Why: Display kernel boot message on framebuffer for visual verification
-        // Note: Using inline text rendering to avoid cross-module dependency
+        // Note: Glyph alpha is forced opaque (matches kernel Framebuffer.draw_char).
         const boot_text = "Grain Basin Kernel v0.1.0\nRISC-V64 Emulator\nFramebuffer Ready";
-        draw_text_inline(fb_memory, boot_text, 250, 300, COLOR_WHITE, COLOR_DARK_BG);
-    }
-    
-    /// Draw text inline (helper for init_framebuffer)
-    /// Why: Render text directly to framebuffer memory without Framebuffer struct
-    /// GrainStyle: Explicit bounds checking, deterministic rendering
-    fn draw_text_inline(memory: []u8, text: []const u8, start_x: u32, start_y: u32, fg_color: u32, bg_color: u32) void {
-        const FRAMEBUFFER_WIDTH: u32 = 1024;
-        const FRAMEBUFFER_BPP: u32 = 4;
-        const CHAR_WIDTH: u32 = 8;
-        const CHAR_HEIGHT: u32 = 8;
-        
-        // Extract colors
-        const fg_r: u8 = @truncate((fg_color >> 24) & 0xFF);
-        const fg_g: u8 = @truncate((fg_color >> 16) & 0xFF);
-        const fg_b: u8 = @truncate((fg_color >> 8) & 0xFF);
-        const bg_r: u8 = @truncate((bg_color >> 24) & 0xFF);
-        const bg_g: u8 = @truncate((bg_color >> 16) & 0xFF);
-        const bg_b: u8 = @truncate((bg_color >> 8) & 0xFF);
-        
-        var char_x: u32 = start_x;
-        var char_y: u32 = start_y;
-        
-        var i: u32 = 0;
-        while (i < text.len) : (i += 1) {
-            const ch = text[i];
-            
-            // Handle newline
-            if (ch == '\n') {
-                char_x = start_x;
-                char_y += CHAR_HEIGHT;
-                continue;
-            }
-            
-            // Get character pattern (8x8 bitmap)
-            const pattern = get_char_pattern_inline(ch);
-            
-            // Draw character
-            var py: u32 = 0;
-            while (py < CHAR_HEIGHT) : (py += 1) {
-                var px: u32 = 0;
-                while (px < CHAR_WIDTH) : (px += 1) {
-                    const pixel_x = char_x + px;
-                    const pixel_y = char_y + py;
-                    
-                    // Bounds check
-                    if (pixel_x >= FRAMEBUFFER_WIDTH or pixel_y >= 768) continue;
-                    
-                    const bit_idx = py * CHAR_WIDTH + px;
-                    const bit = (pattern >> @as(u6, @intCast(63 - bit_idx))) & 1;
-                    
-                    const offset: u32 = (pixel_y * FRAMEBUFFER_WIDTH + pixel_x) * FRAMEBUFFER_BPP;
-                    if (offset + 3 >= memory.len) continue;
-                    
-                    if (bit == 1) {
-                        memory[offset + 0] = fg_r;
-                        memory[offset + 1] = fg_g;
-                        memory[offset + 2] = fg_b;
-                    } else {
-                        memory[offset + 0] = bg_r;
-                        memory[offset + 1] = bg_g;
-                        memory[offset + 2] = bg_b;
-                    }
-                    memory[offset + 3] = 0xFF; // Alpha
-                }
-            }
-            
-            char_x += CHAR_WIDTH;
-        }
-    }
-    
-    /// Get 8x8 bitmap pattern for character (inline version)
-    /// Why: Simple bitmap font for text rendering
-    fn get_char_pattern_inline(ch: u8) u64 {
-        return switch (ch) {
-            ' ' => 0x0000000000000000,
-            '!' => 0x1818181818001800,
-            '.' => 0x0000000000181800,
-            '0' => 0x3C666E7E76663C00,
-            '1' => 0x1818381818187E00,
-            'A' => 0x183C66667E666600,
-            'B' => 0x7C66667C66667C00,
-            'C' => 0x3C66606060663C00,
-            'D' => 0x786C6666666C7800,
-            'E' => 0x7E60607C60607E00,
-            'F' => 0x7E60607C60606000,
-            'G' => 0x3C66606E66663C00,
-            'I' => 0x3C18181818183C00,
-            'K' => 0x666C78786C666600,
-            'L' => 0x6060606060607E00,
-            'M' => 0x63777F6B63636300,
-            'N' => 0x66767E7E6E666600,
-            'O' => 0x3C66666666663C00,
-            'R' => 0x7C66667C6C666600,
-            'S' => 0x3C603C0606663C00,
-            'V' => 0x66666666663C1800,
-            'a' => 0x00003C063E663E00,
-            'b' => 0x60607C6666667C00,
-            'c' => 0x00003C6660603C00,
-            'd' => 0x06063E6666663E00,
-            'e' => 0x00003C667E603C00,
-            'f' => 0x1C30307C30303000,
-            'g' => 0x00003E66663E063C,
-            'h' => 0x60607C6666666600,
-            'i' => 0x1800181818181800,
-            'l' => 0x1818181818181800,
-            'm' => 0x0000767F6B636300,
-            'n' => 0x00007C6666666600,
-            'o' => 0x00003C6666663C00,
-            'r' => 0x00007C6660606000,
-            's' => 0x00003E603C067C00,
-            't' => 0x30307C3030301C00,
-            'u' => 0x0000666666663E00,
-            'v' => 0x00006666663C1800,
-            'w' => 0x0000636B7F360000,
-            'x' => 0x0000663C183C6600,
-            'y' => 0x00006666663E063C,
-            'z' => 0x00007E0C18307E00,
-            '-' => 0x000000007E000000,
-            '/' => 0x303018180C0C0606,
-            else => 0x7E8185B581817E00, // fallback: box
-        };
+        _ = fb_primitives.draw_text(surface, boot_text, 250, 300, COLOR_WHITE | 0xFF, COLOR_DARK_BG | 0xFF);
     }
 
     /// Read instruction at PC (32-bit, little-endian).
@@ -1045,8 +1132,13 @@ pub const VM = struct {
         // Store PC before instruction execution (for branch detection).
         const pc_before = self.regs.pc;
 
-        // Check for breakpoint at current PC.
-        if (self.debug_interface.check_breakpoint(pc_before)) {
+        // Periodic record/replay snapshot at the instruction boundary.
+        if (self.replay.mode != .off) {
+            try self.replay.maybe_snapshot(self);
+        }
+
+        // Check for breakpoint at current PC (single compare when none armed).
+        if (self.debug_interface.armed_breakpoints != 0 and self.debug_interface.check_breakpoint(pc_before)) {
             // Breakpoint hit: stop execution (caller should check breakpoint_hit flag).
             return;
         }
@@ -2216,6 +2308,11 @@ pub const VM = struct {
             return VMError.unaligned_memory_access;
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_read(eff_addr, 4);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             self.state = .errored;
@@ -2294,6 +2391,11 @@ pub const VM = struct {
             }
         }
         
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_write(eff_addr, 4);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             self.state = .errored;
@@ -2315,6 +2417,7 @@ pub const VM = struct {
         // Write 32-bit word to memory.
         // GrainStyle: Cast u64 to usize only for array indexing
         @memcpy(self.memory[@intCast(phys_offset)..][0..4], &std.mem.toBytes(word));
+        self.mark_framebuffer_store(phys_offset, 4);
     }
 
     /// Execute LB (Load Byte) instruction.
@@ -2358,6 +2461,11 @@ pub const VM = struct {
             }
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_read(eff_addr, 1);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             // Address translation failed: record page fault (load page fault, code 13).
@@ -2434,6 +2542,11 @@ pub const VM = struct {
             }
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_read(eff_addr, 2);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             // Address translation failed: record page fault (load page fault, code 13).
@@ -2529,6 +2642,11 @@ pub const VM = struct {
             }
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_read(eff_addr, 8);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             // Address translation failed: record page fault (load page fault, code 13).
@@ -2597,6 +2715,11 @@ pub const VM = struct {
             }
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_read(eff_addr, 1);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             // Address translation failed: record page fault (load page fault, code 13).
@@ -2671,6 +2794,11 @@ pub const VM = struct {
             }
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_read(eff_addr, 2);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             // Address translation failed: record page fault (load page fault, code 13).
@@ -2746,6 +2874,11 @@ pub const VM = struct {
             }
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_read(eff_addr, 4);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             // Address translation failed: record page fault (load page fault, code 13).
@@ -2828,6 +2961,11 @@ pub const VM = struct {
             }
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_write(eff_addr, 1);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             self.state = .errored;
@@ -2848,6 +2986,7 @@ pub const VM = struct {
         // Write byte to memory using translated physical offset
         // GrainStyle: Cast u64 to usize only for array indexing
         self.memory[@intCast(phys_offset)] = byte;
+        self.mark_framebuffer_store(phys_offset, 1);
 
         // Assert: byte must be written correctly.
         std.debug.assert(self.memory[@intCast(phys_offset)] == byte);
@@ -2897,6 +3036,11 @@ pub const VM = struct {
             }
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_write(eff_addr, 2);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             self.state = .errored;
@@ -2917,6 +3061,7 @@ pub const VM = struct {
         // Write 16-bit halfword to memory using translated physical offset
         // GrainStyle: Cast u64 to usize only for array indexing
         @memcpy(self.memory[@intCast(phys_offset)..][0..2], &std.mem.toBytes(halfword));
+        self.mark_framebuffer_store(phys_offset, 2);
 
         // Assert: halfword must be written correctly.
         const read_back = std.mem.readInt(u16, self.memory[@intCast(phys_offset)..][0..2], .little);
@@ -2972,6 +3117,11 @@ pub const VM = struct {
             return VMError.unaligned_memory_access;
         }
 
+        // Watchpoint page trap (single compare when none armed).
+        if (self.debug_interface.armed_watchpoints != 0) {
+            _ = self.debug_interface.check_watchpoint_write(eff_addr, 8);
+        }
+
         // Translate virtual address to physical offset
         const phys_offset = self.translate_address(eff_addr) orelse {
             self.state = .errored;
@@ -2991,6 +3141,7 @@ pub const VM = struct {
         // Write 64-bit doubleword to memory using translated physical offset
         // GrainStyle: Cast u64 to usize only for array indexing
         @memcpy(self.memory[@intCast(phys_offset)..][0..8], &std.mem.toBytes(rs2_value));
+        self.mark_framebuffer_store(phys_offset, 8);
 
         // Assert: doubleword must be written correctly.
         const read_back = std.mem.readInt(u64, self.memory[@intCast(phys_offset)..][0..8], .little);
@@ -3606,8 +3757,20 @@ pub const VM = struct {
                 // SBI SHUTDOWN doesn't return.
                 self.regs.set(10, 0);
             },
+            // LEGACY_CONSOLE_GETCHAR (0x2): Read character from console.
+            // Calling convention: returns character in a0, or -1 if none available.
+            @intFromEnum(sbi.EID.LEGACY_CONSOLE_GETCHAR) => {
+                const count = self.performance.instructions_executed;
+                const live: ?u8 = if (self.replay.mode == .replay) null else self.console_input.pop();
+                const ch = self.replay.filter_getchar(count, live);
+                const result: i64 = if (ch) |c| @as(i64, c) else -1;
+                self.regs.set(10, @as(u64, @bitCast(result)));
+
+                // Assert: a0 holds a byte or -1.
+                std.debug.assert(self.regs.get(10) <= 0xFF or result == -1);
+            },
             // Other SBI functions: Not implemented yet.
-            // TODO: Implement SET_TIMER, CONSOLE_GETCHAR, etc.
+            // TODO: Implement SET_TIMER, etc.
             else => {
                 // Assert: Unknown SBI function must return error code.
                 std.debug.assert(eid != @intFromEnum(sbi.EID.LEGACY_CONSOLE_PUTCHAR));
@@ -17,6 +17,15 @@ pub const Platform = struct {
     /// Single pointer to type-erased window: cast to concrete type in impls.
     impl: *anyopaque,
 
+    /// Buffer region in pixels (present only these rects).
+    /// Why: Framebuffer sync produces dirty tiles; backends upload only those.
+    pub const Region = struct {
+        x: u32,
+        y: u32,
+        width: u32,
+        height: u32,
+    };
+
     /// VTable: function pointers for platform dispatch (single-level only).
     /// 
     /// Pointer design (GrainStyle):
@@ -37,6 +46,8 @@ pub const Platform = struct {
         getBuffer: *const fn (impl: *anyopaque) []u8,
         /// Single pointer to present function: takes single pointer to anyopaque.
         present: *const fn (impl: *anyopaque) anyerror!void,
+        /// Single pointer to presentRegions function: takes single pointer and region slice.
+        presentRegions: *const fn (impl: *anyopaque, regions: []const Region) anyerror!void,
         /// Single pointer to width function: takes single pointer to anyopaque.
         width: *const fn (impl: *anyopaque) u32,
         /// Single pointer to height function: takes single pointer to anyopaque.
@@ -110,6 +121,16 @@ pub const Platform = struct {
     pub fn present(self: *Platform) !void {
         try self.vtable.present(self.impl);
     }
+
+    /// Present only the given buffer regions: single pointer to Platform struct.
+    /// Why: Dirty-tile sync changes a few tiles per frame; backends that can
+    /// upload partial rects skip the rest of the buffer.
+    pub fn presentRegions(self: *Platform, regions: []const Region) !void {
+        // Assert arguments: regions must be bounded by tile count (32x24).
+        std.debug.assert(regions.len <= 32 * 24);
+        if (regions.len == 0) return;
+        try self.vtable.presentRegions(self.impl, regions);
+    }
     
     /// Run the platform event loop: blocks until app terminates.
     /// Why: macOS needs NSApplication run loop; RISC-V may need custom event handling.
@@ -141,6 +162,9 @@ pub const Platform = struct {
         return h;
     }
 
+    /// Null (headless) backend: exported for headless tests.
+    pub const null_backend = @import("platform/null/impl.zig");
+
     /// Get platform vtable: returns single pointer to VTable.
     /// 
     /// Pointer design: Returns `*const VTable` (single pointer). Address-of
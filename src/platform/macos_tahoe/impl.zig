@@ -10,6 +10,7 @@ pub const vtable = Platform.VTable{
     .show = show,
     .getBuffer = getBuffer,
     .present = present,
+    .presentRegions = presentRegions,
     .width = width,
     .height = height,
     .runEventLoop = runEventLoop,
@@ -99,6 +100,15 @@ fn present(impl: *anyopaque) !void {
     try window.present();
 }
 
+/// Present macOS platform regions: single pointer to type-erased window.
+/// Why: Backend rebuilds its image from the whole buffer, so partial
+/// presents fall back to a full present (buffer is already up to date).
+fn presentRegions(impl: *anyopaque, regions: []const Platform.Region) !void {
+    // Assert arguments: at least one region (Platform skips empty lists).
+    std.debug.assert(regions.len > 0);
+    try present(impl);
+}
+
 /// Get macOS platform width: single pointer to type-erased window, returns u32.
 /// 
 /// Pointer flow: `impl: *anyopaque` (single pointer) → cast to `*Window`
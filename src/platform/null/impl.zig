@@ -8,6 +8,7 @@ pub const vtable = Platform.VTable{
     .show = show,
     .getBuffer = getBuffer,
     .present = present,
+    .presentRegions = presentRegions,
     .width = width,
     .height = height,
     .runEventLoop = runEventLoop,
@@ -24,6 +25,13 @@ pub const NullWindow = struct {
     height: u32 = 768,
     /// Slice (pointer + length) to RGBA buffer: single-level pointer, not pointer to pointer.
     rgba_buffer: []u8,
+    /// Number of presents (full or partial).
+    /// Why: Headless tests assert what a real backend would have uploaded.
+    present_count: u32 = 0,
+    /// Regions passed to the last present (full present counts as one region).
+    last_region_count: u32 = 0,
+    /// Total bytes a real backend would have uploaded.
+    uploaded_bytes: u64 = 0,
 
     /// Initialize null window: returns value struct, not pointer.
     /// 
@@ -97,6 +105,27 @@ pub const NullWindow = struct {
     pub fn present(self: *NullWindow) !void {
         // Assert invariant: window must have valid buffer.
         std.debug.assert(self.rgba_buffer.len > 0);
+        self.present_count += 1;
+        self.last_region_count = 1;
+        self.uploaded_bytes += self.rgba_buffer.len;
+    }
+
+    /// Present only the given regions: records upload size, draws nothing.
+    /// 
+    /// Pointer flow: `self: *NullWindow` (single pointer), `regions` (slice).
+    pub fn presentRegions(self: *NullWindow, regions: []const Platform.Region) !void {
+        // Assert invariant: window must have valid buffer.
+        std.debug.assert(self.rgba_buffer.len > 0);
+        var bytes: u64 = 0;
+        for (regions) |region| {
+            // Assert arguments: region must lie inside the buffer.
+            std.debug.assert(region.x + region.width <= self.width);
+            std.debug.assert(region.y + region.height <= self.height);
+            bytes += @as(u64, region.width) * region.height * 4;
+        }
+        self.present_count += 1;
+        self.last_region_count = @intCast(regions.len);
+        self.uploaded_bytes += bytes;
     }
 };
 
@@ -178,6 +207,17 @@ fn present(impl: *anyopaque) !void {
     try window.present();
 }
 
+/// Present null platform regions: single pointer to type-erased window.
+/// 
+/// Pointer flow: `impl: *anyopaque` (single pointer) → cast to `*NullWindow`
+/// (single pointer). Both are same level; no double indirection.
+fn presentRegions(impl: *anyopaque, regions: []const Platform.Region) !void {
+    // Cast single pointer from type-erased to concrete type: single-level only.
+    const window: *NullWindow = @ptrCast(@alignCast(impl));
+    std.debug.assert(window.rgba_buffer.len > 0);
+    try window.presentRegions(regions);
+}
+
 /// Get null platform width: single pointer to type-erased window, returns u32.
 /// 
 /// Pointer flow: `impl: *anyopaque` (single pointer) → cast to `*NullWindow`
@@ -8,6 +8,7 @@ pub const vtable = Platform.VTable{
     .show = show,
     .getBuffer = getBuffer,
     .present = present,
+    .presentRegions = presentRegions,
     .width = width,
     .height = height,
     .runEventLoop = runEventLoop,
@@ -164,6 +165,15 @@ fn present(impl: *anyopaque) !void {
     try window.present();
 }
 
+/// Present RISC-V platform regions: single pointer to type-erased window.
+/// Why: Backend rebuilds its image from the whole buffer, so partial
+/// presents fall back to a full present (buffer is already up to date).
+fn presentRegions(impl: *anyopaque, regions: []const Platform.Region) !void {
+    // Assert arguments: at least one region (Platform skips empty lists).
+    std.debug.assert(regions.len > 0);
+    try present(impl);
+}
+
 /// Get RISC-V platform width: single pointer to type-erased window, returns u32.
 /// 
 /// Pointer flow: `impl: *anyopaque` (single pointer) → cast to `*RiscvWindow`
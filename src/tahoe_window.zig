@@ -50,6 +50,15 @@ pub const TahoeSandbox = struct {
     stdout_buffer: [16 * 1024]u8 = [_]u8{0} ** (16 * 1024),
     /// Stdout buffer write position (bytes written so far).
     stdout_pos: u32 = 0,
+    /// Dirty tile sync state (static tile list, copy counters).
+    /// Why: Copy only the 32x32 tiles the kernel touched since last frame.
+    tile_sync: kernel_vm.framebuffer_sync.TileSync = .{},
+    /// Regions handed to presentRegions (one per dirty tile).
+    present_regions: [kernel_vm.FRAMEBUFFER_TILE_COUNT]Platform.Region = undefined,
+    /// UI state behind the last presented frame, and whether one was presented.
+    /// Why: An unchanged UI means overlays are unchanged; only VM tiles are damaged.
+    last_ui: UiSnapshot = .{},
+    presented_once: bool = false,
     /// Grain Basin kernel instance (for syscall handling).
     /// Why: Handle syscalls from VM via Grain Basin kernel.
     /// Note: Stored as pointer to avoid stack overflow (large struct with many static arrays).
@@ -707,15 +716,14 @@ pub const TahoeSandbox = struct {
         try self.platform.show();
     }
 
-    /// Sync VM framebuffer to window buffer (optimized with dirty region tracking).
+    /// Sync VM framebuffer to window buffer (optimized with dirty tile tracking).
     /// Why: Copy kernel framebuffer memory to macOS window for display.
     /// GrainStyle: Explicit bounds checking, static allocation, deterministic copy.
     /// Contract:
     ///   Input: VM must be initialized, buffer must be 1024x768x4 bytes
-    ///   Output: Window buffer contains VM framebuffer content (only dirty regions copied)
-    /// Note: Uses dirty region tracking to optimize copy (only sync changed areas).
-    fn sync_framebuffer(self: *TahoeSandbox, vm: *VM, buffer: []u8, buffer_width: u32, buffer_height: u32) void {
-        _ = self; // Unused (method receiver)
+    ///   Output: Window buffer contains VM framebuffer content (only dirty tiles copied)
+    /// Returns: number of 32x32 tiles copied (0 when the framebuffer is unchanged).
+    fn sync_framebuffer(self: *TahoeSandbox, vm: *VM, buffer: []u8, buffer_width: u32, buffer_height: u32) u32 {
         // Assert: VM must be initialized.
         std.debug.assert(vm.memory_size > 0);
         std.debug.assert(vm.memory.len > 0);
@@ -725,55 +733,42 @@ pub const TahoeSandbox = struct {
         const framebuffer_height: u32 = 768;
         std.debug.assert(buffer_width == framebuffer_width);
         std.debug.assert(buffer_height == framebuffer_height);
+        std.debug.assert(buffer.len == framebuffer_width * framebuffer_height * 4);
         
-        // Assert: Buffer size must match expected framebuffer size.
-        const expected_framebuffer_size: u32 = framebuffer_width * framebuffer_height * 4;
-        std.debug.assert(buffer.len == expected_framebuffer_size);
-        
-        // Get framebuffer memory slice from VM.
-        const framebuffer_memory = vm.get_framebuffer_memory();
-        
-        // Assert: Framebuffer memory size must match expected size.
-        std.debug.assert(framebuffer_memory.len == expected_framebuffer_size);
-        
-        // Check if any region is dirty (optimization: skip copy if nothing changed).
-        var min_x: u32 = 0;
-        var min_y: u32 = 0;
-        var max_x: u32 = 0;
-        var max_y: u32 = 0;
-        const has_dirty = vm.framebuffer_dirty.get_bounds(&min_x, &min_y, &max_x, &max_y);
-        
-        if (has_dirty) {
-            // Copy only dirty region (optimization: reduce memory bandwidth).
-            // Why: Most frames only have small changes (cursor movement, text updates).
-            const bpp: u32 = 4; // RGBA
-            var y: u32 = min_y;
-            while (y < max_y) : (y += 1) {
-                const row_offset_fb: u32 = y * framebuffer_width * bpp;
-                const row_offset_buf: u32 = y * buffer_width * bpp;
-                const row_start_fb: u32 = row_offset_fb + min_x * bpp;
-                const row_start_buf: u32 = row_offset_buf + min_x * bpp;
-                const row_len: u32 = (max_x - min_x) * bpp;
-                
-                // Assert: Row offsets must be within bounds.
-                std.debug.assert(row_start_fb + row_len <= framebuffer_memory.len);
-                std.debug.assert(row_start_buf + row_len <= buffer.len);
-                
-                // Copy row (only dirty region).
-                @memcpy(buffer[row_start_buf..][0..row_len], framebuffer_memory[row_start_fb..][0..row_len]);
-            }
-            
-            // Clear dirty region after sync (reset tracking).
-            vm.framebuffer_dirty.clear();
-        } else {
-            // No dirty regions: framebuffer unchanged, skip copy.
-            // Why: Optimization - avoid unnecessary memory copy when nothing changed.
-        }
+        // Copy only dirty tiles (interpreter stores, JIT stores, and syscalls
+        // all mark tiles); clean frames copy nothing.
+        const tiles = self.tile_sync.sync(vm, buffer);
         
-        // Assert: Buffer must be valid after sync (postcondition).
-        std.debug.assert(buffer.len == expected_framebuffer_size);
+        // Assert: Tile count bounded by tile map (postcondition).
+        std.debug.assert(tiles.len <= kernel_vm.FRAMEBUFFER_TILE_COUNT);
+        return @intCast(tiles.len);
     }
 
+    /// State the UI overlays are drawn from (focus bar, cursor, text, VM pane).
+    const UiSnapshot = struct {
+        mouse_x: f64 = 0.0,
+        mouse_y: f64 = 0.0,
+        mouse_button_down: bool = false,
+        typed_text_hash: u64 = 0,
+        has_focus: bool = false,
+        vm_state: ?VM.VMState = null,
+        stdout_pos: u32 = 0,
+        filter_mode: AuroraFilter.Mode = .none,
+    };
+    
+    fn ui_snapshot(self: *const TahoeSandbox) UiSnapshot {
+        return .{
+            .mouse_x = self.last_mouse_x,
+            .mouse_y = self.last_mouse_y,
+            .mouse_button_down = self.mouse_button_down,
+            .typed_text_hash = std.hash.Wyhash.hash(0, self.typed_text[0..self.typed_text_len]),
+            .has_focus = self.has_focus,
+            .vm_state = if (self.vm) |vm| vm.state else null,
+            .stdout_pos = self.stdout_pos,
+            .filter_mode = self.filter_state.mode,
+        };
+    }
+    
     pub fn tick(self: *TahoeSandbox) !void {
         // Assert precondition: platform must be initialized.
         // VTable and impl are non-optional pointers in Zig 0.15.
@@ -805,12 +800,27 @@ pub const TahoeSandbox = struct {
         const buffer_width: u32 = 1024;
         const buffer_height: u32 = 768;
         
+        // Decide how much of the frame is damaged.
+        // Why: UI overlays depend only on UiSnapshot; when it is unchanged and
+        // the filter is off, only VM tiles can change, so only they are presented.
+        // The darkroom filter rewrites pixels in place, so it always needs a
+        // fresh full frame (filtering a kept pixel twice would compound).
+        const ui = self.ui_snapshot();
+        const full_frame = !self.presented_once or
+            !std.meta.eql(ui, self.last_ui) or
+            self.filter_state.mode != .none;
+        var tile_count: u32 = 0;
+        
         // Sync VM framebuffer to window buffer (if VM is running).
         // Why: Display kernel framebuffer content in macOS window.
         // GrainStyle: Explicit bounds checking, static allocation, deterministic copy.
         if (self.vm) |vm| {
-            self.sync_framebuffer(vm, buffer, buffer_width, buffer_height);
-        } else {
+            if (full_frame) {
+                self.tile_sync.sync_all(vm, buffer);
+            } else {
+                tile_count = self.sync_framebuffer(vm, buffer, buffer_width, buffer_height);
+            }
+        } else if (full_frame) {
             // No VM: Fill with dark blue-gray background (Tahoe aesthetic).
         const bg_color: u32 = 0xFF1E1E2E; // Dark blue-gray (RGBA)
         @memset(buffer, @as(u8, @truncate(bg_color)));
@@ -835,6 +845,9 @@ pub const TahoeSandbox = struct {
             }
         }
         
+        // Nothing damaged: skip redrawing overlays and presenting.
+        if (!full_frame and tile_count == 0) return;
+        
         // Debug: Draw a bright red rectangle in top-left corner to verify rendering works.
         // Why: Verify that the buffer is being drawn and presented correctly.
         // Also fill entire buffer with a test pattern to verify buffer is being read.
@@ -1267,9 +1280,20 @@ pub const TahoeSandbox = struct {
         // Apply Aurora filter if enabled.
         AuroraFilter.apply(self.filter_state, buffer);
         
-        // Present the buffer to the window.
-        try self.platform.present();
-        std.debug.print("[tahoe_window] Buffer presented to window.\n", .{});
+        // Present the buffer to the window: whole frame when the UI changed,
+        // otherwise only the dirty VM tiles (overlays inside them were redrawn).
+        if (full_frame) {
+            try self.platform.present();
+        } else {
+            const tiles = self.tile_sync.tiles[0..tile_count];
+            for (tiles, self.present_regions[0..tile_count]) |tile, *region| {
+                region.* = .{ .x = tile.x, .y = tile.y, .width = tile.width, .height = tile.height };
+            }
+            try self.platform.presentRegions(self.present_regions[0..tile_count]);
+        }
+        self.last_ui = ui;
+        self.presented_once = true;
+        std.debug.print("[tahoe_window] Buffer presented to window ({d} tiles, full={}).\n", .{ tile_count, full_frame });
     }
 
     pub fn toggle_flux(self: *TahoeSandbox, mode: AuroraFilter.Mode) void {
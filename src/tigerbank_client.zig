@@ -1,4 +1,5 @@
 const std = @import("std");
+const Contracts = @import("contracts.zig").SettlementContracts;
 
 pub const ClusterEndpoint = struct {
     host: []const u8,
@@ -9,6 +10,442 @@ pub const RelayEndpoint = struct {
     url: []const u8,
 };
 
+/// Batch framing between the client and a settlement cluster.
+///
+/// Batch: magic u32 | batch_id u64 | count u32 | body_len u32, then
+/// `count` entries of u16 length + encoded envelope (all little endian).
+/// Ack:   magic u32 | batch_id u64 | status u8 | settled u32.
+///
+/// Batch ids make resends idempotent: a cluster acknowledges a batch id
+/// it already settled without applying it twice.
+pub const Wire = struct {
+    pub const batch_magic: u32 = 0x4242_5447; // "GTBB"
+    pub const ack_magic: u32 = 0x4142_5447; // "GTBA"
+    pub const batch_header_len: usize = 4 + 8 + 4 + 4;
+    pub const entry_prefix_len: usize = 2;
+    pub const ack_len: usize = 4 + 8 + 1 + 4;
+    pub const max_entry_len: usize = std.math.maxInt(u16);
+
+    pub const AckStatus = enum(u8) {
+        settled = 0,
+        retry = 1, // Transient (e.g. view change); resend as is
+        rejected = 2, // Malformed or refused; do not resend
+    };
+
+    pub const BatchHeader = struct {
+        batch_id: u64,
+        count: u32,
+        body_len: u32,
+    };
+
+    pub const Ack = struct {
+        batch_id: u64,
+        status: AckStatus,
+        settled: u32,
+    };
+
+    pub fn parseBatchHeader(bytes: *const [batch_header_len]u8) !BatchHeader {
+        if (std.mem.readInt(u32, bytes[0..4], .little) != batch_magic) return error.BadMagic;
+        return .{
+            .batch_id = std.mem.readInt(u64, bytes[4..12], .little),
+            .count = std.mem.readInt(u32, bytes[12..16], .little),
+            .body_len = std.mem.readInt(u32, bytes[16..20], .little),
+        };
+    }
+
+    pub fn writeAck(ack: Ack, out: *[ack_len]u8) void {
+        std.mem.writeInt(u32, out[0..4], ack_magic, .little);
+        std.mem.writeInt(u64, out[4..12], ack.batch_id, .little);
+        out[12] = @intFromEnum(ack.status);
+        std.mem.writeInt(u32, out[13..17], ack.settled, .little);
+    }
+
+    pub fn parseAck(bytes: *const [ack_len]u8) !Ack {
+        if (std.mem.readInt(u32, bytes[0..4], .little) != ack_magic) return error.BadMagic;
+        return .{
+            .batch_id = std.mem.readInt(u64, bytes[4..12], .little),
+            .status = std.meta.intToEnum(AckStatus, bytes[12]) catch return error.BadAckStatus,
+            .settled = std.mem.readInt(u32, bytes[13..17], .little),
+        };
+    }
+
+    /// Walk a batch body's entries.
+    pub const EntryIterator = struct {
+        body: []const u8,
+        index: usize = 0,
+
+        pub fn next(self: *EntryIterator) !?[]const u8 {
+            if (self.index == self.body.len) return null;
+            if (self.body.len - self.index < entry_prefix_len) return error.TruncatedEntry;
+            const len = std.mem.readInt(u16, self.body[self.index..][0..2], .little);
+            self.index += entry_prefix_len;
+            if (self.body.len - self.index < len) return error.TruncatedEntry;
+            defer self.index += len;
+            return self.body[self.index..][0..len];
+        }
+    };
+};
+
+/// Packs envelopes straight into one caller-owned batch buffer: each is
+/// encoded in place behind its length prefix, with no staging copy.
+pub const BatchWriter = struct {
+    buffer: []u8,
+    len: usize,
+    count: u32,
+
+    pub fn init(buffer: []u8) BatchWriter {
+        std.debug.assert(buffer.len > Wire.batch_header_len + Wire.entry_prefix_len);
+        return .{ .buffer = buffer, .len = Wire.batch_header_len, .count = 0 };
+    }
+
+    /// Encode `envelope` into the batch. Returns false (batch unchanged)
+    /// if it does not fit.
+    pub fn append(self: *BatchWriter, envelope: Contracts.Envelope) !bool {
+        const needed = try envelope.encodedLength();
+        if (!self.fits(needed)) return false;
+        const written = try envelope.encode(self.buffer[self.len + Wire.entry_prefix_len ..][0..needed]);
+        std.debug.assert(written.len == needed);
+        self.commit(needed);
+        return true;
+    }
+
+    /// Add an already-encoded entry. Returns false if it does not fit.
+    pub fn appendEncoded(self: *BatchWriter, bytes: []const u8) !bool {
+        if (bytes.len > Wire.max_entry_len) return error.EntryTooLarge;
+        if (!self.fits(bytes.len)) return false;
+        @memcpy(self.buffer[self.len + Wire.entry_prefix_len ..][0..bytes.len], bytes);
+        self.commit(bytes.len);
+        return true;
+    }
+
+    /// Write the header and return the finished frame.
+    pub fn finish(self: *BatchWriter, batch_id: u64) []const u8 {
+        std.mem.writeInt(u32, self.buffer[0..4], Wire.batch_magic, .little);
+        std.mem.writeInt(u64, self.buffer[4..12], batch_id, .little);
+        std.mem.writeInt(u32, self.buffer[12..16], self.count, .little);
+        std.mem.writeInt(u32, self.buffer[16..20], @intCast(self.len - Wire.batch_header_len), .little);
+        return self.buffer[0..self.len];
+    }
+
+    fn fits(self: *const BatchWriter, entry_len: usize) bool {
+        return self.len + Wire.entry_prefix_len + entry_len <= self.buffer.len;
+    }
+
+    fn commit(self: *BatchWriter, entry_len: usize) void {
+        std.mem.writeInt(u16, self.buffer[self.len..][0..2], @intCast(entry_len), .little);
+        self.len += Wire.entry_prefix_len + entry_len;
+        self.count += 1;
+    }
+};
+
+/// Pipelined batch submission to a cluster.
+///
+/// Envelopes fill the current batch; a full batch is sent without waiting
+/// for earlier acks, up to `window` batches in flight. Each in-flight batch
+/// keeps its frame in a preallocated slot until acknowledged, so retries
+/// resend the same bytes. A dead or silent endpoint (connection error or
+/// ack timeout) fails over to the next endpoint and resends every batch in
+/// flight, oldest first. A batch is dropped after `max_attempts` sends.
+pub const Pipeline = struct {
+    pub const Options = struct {
+        // Bounded: Max batches awaiting acknowledgement
+        window: u32 = 8,
+        // Bounded: Max bytes per batch frame (header + entries)
+        batch_bytes: u32 = 64 * 1024,
+        max_attempts: u32 = 4,
+        ack_timeout_ms: i64 = 2000,
+        first_batch_id: u64 = 1,
+    };
+
+    pub const Stats = struct {
+        batches_sent: u64 = 0, // Including resends
+        batches_settled: u64 = 0,
+        envelopes_settled: u64 = 0,
+        retries: u64 = 0,
+        failovers: u64 = 0,
+        batches_failed: u64 = 0,
+        envelopes_failed: u64 = 0,
+    };
+
+    const Slot = struct {
+        buffer: []u8,
+        frame_len: usize = 0,
+        batch_id: u64 = 0,
+        count: u32 = 0,
+        attempts: u32 = 0,
+        sent_at_ms: i64 = 0,
+        in_flight: bool = false,
+        pending: bool = false, // Needs (re)sending
+    };
+
+    allocator: std.mem.Allocator,
+    endpoints: []const ClusterEndpoint,
+    options: Options,
+    storage: []u8,
+    slots: []Slot, // window + 1: one is always filling
+    filling: usize,
+    writer: BatchWriter,
+    in_flight: u32,
+    next_batch_id: u64,
+    endpoint_index: usize,
+    stream: ?std.net.Stream,
+    acks: [Wire.ack_len * 64]u8,
+    acks_len: usize,
+    stats: Stats,
+
+    pub fn init(
+        allocator: std.mem.Allocator,
+        endpoints: []const ClusterEndpoint,
+        options: Options,
+    ) !Pipeline {
+        if (endpoints.len == 0) return error.NoClusterEndpoints;
+        std.debug.assert(options.window > 0);
+        std.debug.assert(options.max_attempts > 0);
+
+        const slot_count = options.window + 1;
+        const storage = try allocator.alloc(u8, slot_count * options.batch_bytes);
+        errdefer allocator.free(storage);
+        const slots = try allocator.alloc(Slot, slot_count);
+        for (slots, 0..) |*slot, i| {
+            slot.* = .{ .buffer = storage[i * options.batch_bytes ..][0..options.batch_bytes] };
+        }
+        return .{
+            .allocator = allocator,
+            .endpoints = endpoints,
+            .options = options,
+            .storage = storage,
+            .slots = slots,
+            .filling = 0,
+            .writer = BatchWriter.init(slots[0].buffer),
+            .in_flight = 0,
+            .next_batch_id = options.first_batch_id,
+            .endpoint_index = 0,
+            .stream = null,
+            .acks = undefined,
+            .acks_len = 0,
+            .stats = .{},
+        };
+    }
+
+    pub fn deinit(self: *Pipeline) void {
+        if (self.stream) |stream| stream.close();
+        self.allocator.free(self.slots);
+        self.allocator.free(self.storage);
+        self.* = undefined;
+    }
+
+    /// Queue an envelope; sends the current batch once it is full.
+    pub fn submit(self: *Pipeline, envelope: Contracts.Envelope) !void {
+        if (try self.writer.append(envelope)) return;
+        try self.seal();
+        if (!try self.writer.append(envelope)) return error.EnvelopeTooLarge;
+    }
+
+    /// Queue an already-encoded payload.
+    pub fn submitEncoded(self: *Pipeline, bytes: []const u8) !void {
+        if (try self.writer.appendEncoded(bytes)) return;
+        try self.seal();
+        if (!try self.writer.appendEncoded(bytes)) return error.EnvelopeTooLarge;
+    }
+
+    /// Send the partial batch and wait until every batch is settled or
+    /// has failed (see `stats`).
+    pub fn flush(self: *Pipeline) !void {
+        try self.seal();
+        while (self.in_flight > 0) try self.pump(true);
+    }
+
+    /// Handle any acknowledgements that already arrived, without blocking.
+    pub fn poll(self: *Pipeline) !void {
+        if (self.in_flight > 0) try self.pump(false);
+    }
+
+    fn seal(self: *Pipeline) !void {
+        if (self.writer.count == 0) return;
+        while (self.in_flight == self.options.window) try self.pump(true);
+
+        const slot = &self.slots[self.filling];
+        slot.frame_len = self.writer.finish(self.next_batch_id).len;
+        slot.batch_id = self.next_batch_id;
+        slot.count = self.writer.count;
+        slot.attempts = 0;
+        slot.in_flight = true;
+        slot.pending = true;
+        self.next_batch_id += 1;
+        self.in_flight += 1;
+
+        for (self.slots, 0..) |candidate, i| {
+            if (!candidate.in_flight) {
+                self.filling = i;
+                break;
+            }
+        } else unreachable; // window + 1 slots, at most window in flight
+        self.writer = BatchWriter.init(self.slots[self.filling].buffer);
+        try self.transmit();
+    }
+
+    // Send every pending batch, oldest first.
+    fn transmit(self: *Pipeline) !void {
+        while (self.oldestPending()) |slot| {
+            slot.attempts += 1;
+            if (slot.attempts > self.options.max_attempts) {
+                self.fail(slot);
+                continue;
+            }
+            if (slot.attempts > 1) self.stats.retries += 1;
+            const stream = try self.connection();
+            writeAll(stream.handle, slot.buffer[0..slot.frame_len]) catch {
+                self.failover();
+                continue;
+            };
+            slot.pending = false;
+            slot.sent_at_ms = std.time.milliTimestamp();
+            self.stats.batches_sent += 1;
+        }
+    }
+
+    // Wait (or just check) for acks; handles timeouts and dead endpoints.
+    fn pump(self: *Pipeline, block: bool) !void {
+        const stream = self.stream orelse return self.transmit();
+        var fds = [1]std.posix.pollfd{.{
+            .fd = stream.handle,
+            .events = std.posix.POLL.IN,
+            .revents = 0,
+        }};
+        const timeout: i32 = if (block) @intCast(self.untilDeadline()) else 0;
+        if (try std.posix.poll(&fds, timeout) == 0) {
+            if (block) self.expire();
+            return self.transmit();
+        }
+
+        // std.posix.read retries EINTR itself; what reaches us is either a
+        // spurious wakeup, a dead connection, or a local failure.
+        const n = std.posix.read(stream.handle, self.acks[self.acks_len..]) catch |err| switch (err) {
+            error.WouldBlock => return self.transmit(),
+            error.ConnectionResetByPeer,
+            error.ConnectionTimedOut,
+            error.BrokenPipe,
+            error.SocketNotConnected,
+            error.NotOpenForReading,
+            error.InputOutput,
+            => 0,
+            else => return err,
+        };
+        if (n == 0) {
+            self.failover();
+            return self.transmit();
+        }
+        self.acks_len += n;
+        var index: usize = 0;
+        while (self.acks_len - index >= Wire.ack_len) : (index += Wire.ack_len) {
+            const ack = Wire.parseAck(self.acks[index..][0..Wire.ack_len]) catch {
+                // Out of sync with this endpoint; start over elsewhere.
+                self.failover();
+                return self.transmit();
+            };
+            self.acknowledge(ack);
+        }
+        std.mem.copyForwards(u8, self.acks[0 .. self.acks_len - index], self.acks[index..self.acks_len]);
+        self.acks_len -= index;
+        try self.transmit();
+    }
+
+    fn acknowledge(self: *Pipeline, ack: Wire.Ack) void {
+        for (self.slots) |*slot| {
+            if (!slot.in_flight or slot.batch_id != ack.batch_id) continue;
+            switch (ack.status) {
+                .settled => {
+                    self.stats.batches_settled += 1;
+                    self.stats.envelopes_settled += slot.count;
+                    self.release(slot);
+                },
+                .retry => slot.pending = true,
+                .rejected => self.fail(slot),
+            }
+            return;
+        }
+        // Stale ack for a batch already settled or dropped: ignore.
+    }
+
+    fn release(self: *Pipeline, slot: *Slot) void {
+        std.debug.assert(slot.in_flight);
+        slot.in_flight = false;
+        slot.pending = false;
+        self.in_flight -= 1;
+    }
+
+    fn fail(self: *Pipeline, slot: *Slot) void {
+        self.stats.batches_failed += 1;
+        self.stats.envelopes_failed += slot.count;
+        self.release(slot);
+    }
+
+    fn oldestPending(self: *Pipeline) ?*Slot {
+        var oldest: ?*Slot = null;
+        for (self.slots) |*slot| {
+            if (!slot.in_flight or !slot.pending) continue;
+            if (oldest == null or slot.batch_id < oldest.?.batch_id) oldest = slot;
+        }
+        return oldest;
+    }
+
+    // Milliseconds until the oldest unacknowledged send times out.
+    fn untilDeadline(self: *const Pipeline) i64 {
+        const now = std.time.milliTimestamp();
+        var wait = self.options.ack_timeout_ms;
+        for (self.slots) |slot| {
+            if (!slot.in_flight or slot.pending) continue;
+            wait = @min(wait, slot.sent_at_ms + self.options.ack_timeout_ms - now);
+        }
+        return std.math.clamp(wait, 0, std.math.maxInt(i32));
+    }
+
+    fn expire(self: *Pipeline) void {
+        const now = std.time.milliTimestamp();
+        for (self.slots) |slot| {
+            if (slot.in_flight and !slot.pending and now - slot.sent_at_ms >= self.options.ack_timeout_ms) {
+                self.failover();
+                return;
+            }
+        }
+    }
+
+    // Drop the current endpoint; everything in flight is resent.
+    fn failover(self: *Pipeline) void {
+        if (self.stream) |stream| stream.close();
+        self.stream = null;
+        self.acks_len = 0;
+        self.endpoint_index = (self.endpoint_index + 1) % self.endpoints.len;
+        self.stats.failovers += 1;
+        for (self.slots) |*slot| {
+            if (slot.in_flight) slot.pending = true;
+        }
+    }
+
+    fn connection(self: *Pipeline) !std.net.Stream {
+        if (self.stream) |stream| return stream;
+        var tries: usize = 0;
+        while (tries < self.endpoints.len) : (tries += 1) {
+            const endpoint = self.endpoints[self.endpoint_index];
+            if (std.net.tcpConnectToHost(self.allocator, endpoint.host, endpoint.port)) |stream| {
+                self.stream = stream;
+                self.acks_len = 0;
+                return stream;
+            } else |_| {
+                self.endpoint_index = (self.endpoint_index + 1) % self.endpoints.len;
+            }
+        }
+        return error.ClusterUnavailable;
+    }
+
+    fn writeAll(fd: std.posix.fd_t, bytes: []const u8) !void {
+        var index: usize = 0;
+        while (index < bytes.len) {
+            index += try std.posix.write(fd, bytes[index..]);
+        }
+    }
+};
+
 pub const Client = struct {
     allocator: std.mem.Allocator,
     cluster: []const ClusterEndpoint,
@@ -26,18 +463,27 @@ pub const Client = struct {
         };
     }
 
+    /// Pipeline for bulk submission to this client's cluster.
+    pub fn pipeline(self: *Client, options: Pipeline.Options) !Pipeline {
+        return Pipeline.init(self.allocator, self.cluster, options);
+    }
+
+    /// Submit one encoded payload as a single-entry batch and wait for
+    /// its settlement.
     pub fn submitTigerBeetle(
         self: *Client,
         payload: []const u8,
     ) !void {
-        _ = payload;
         if (self.cluster.len == 0) return error.NoClusterEndpoints;
-        for (self.cluster) |endpoint| {
-            std.debug.print(
-                "TigerBank stub: would submit {d} bytes to {s}:{d}\n",
-                .{ payload.len, endpoint.host, endpoint.port },
-            );
-        }
+        if (payload.len == 0) return error.EmptyPayload;
+        var single = try self.pipeline(.{
+            .window = 1,
+            .batch_bytes = @intCast(Wire.batch_header_len + Wire.entry_prefix_len + payload.len),
+        });
+        defer single.deinit();
+        try single.submitEncoded(payload);
+        try single.flush();
+        if (single.stats.batches_failed > 0) return error.SubmissionRejected;
     }
 
     pub fn broadcastRelays(
@@ -69,3 +515,65 @@ test "client rejects empty cluster" {
         client.submitTigerBeetle("payload"),
     );
 }
+
+fn testEnvelope(i: u32) Contracts.Envelope {
+    return .{ .tigerbank_cdn = .{
+        .tier = .basic,
+        .subscriber_npub = [_]u8{@truncate(i)} ** 32,
+        .start_timestamp_seconds = i,
+        .seats = 1,
+        .autopay_enabled = false,
+    } };
+}
+
+test "batch writer packs envelopes in place" {
+    var buffer: [256]u8 = undefined;
+    var writer = BatchWriter.init(&buffer);
+    var packed_count: u32 = 0;
+    while (try writer.append(testEnvelope(packed_count))) packed_count += 1;
+
+    const entry_len = Contracts.kind_tag_len + Contracts.TigerBankCDN.encoded_len;
+    const expected = (buffer.len - Wire.batch_header_len) / (Wire.entry_prefix_len + entry_len);
+    try std.testing.expectEqual(@as(u32, @intCast(expected)), packed_count);
+
+    const frame = writer.finish(7);
+    const header = try Wire.parseBatchHeader(frame[0..Wire.batch_header_len]);
+    try std.testing.expectEqual(@as(u64, 7), header.batch_id);
+    try std.testing.expectEqual(packed_count, header.count);
+
+    var entries = Wire.EntryIterator{ .body = frame[Wire.batch_header_len..] };
+    var scratch: [Contracts.Envelope.max_len]u8 = undefined;
+    var i: u32 = 0;
+    while (try entries.next()) |entry| : (i += 1) {
+        try std.testing.expectEqualSlices(u8, try testEnvelope(i).encode(&scratch), entry);
+    }
+    try std.testing.expectEqual(packed_count, i);
+}
+
+test "pipeline settles batches against the mock cluster with retries" {
+    const MockCluster = @import("tigerbank_mock_cluster.zig").MockCluster;
+    var cluster: MockCluster = undefined;
+    try cluster.start(std.testing.allocator, .{ .retry_every = 5 });
+    defer cluster.stop();
+
+    // First endpoint is dead: the pipeline fails over to the mock.
+    const endpoints = [_]ClusterEndpoint{
+        .{ .host = "127.0.0.1", .port = 1 },
+        .{ .host = "127.0.0.1", .port = cluster.port() },
+    };
+    var pipeline = try Pipeline.init(std.testing.allocator, &endpoints, .{
+        .window = 4,
+        .batch_bytes = 512,
+    });
+    defer pipeline.deinit();
+
+    const total = 1000;
+    var i: u32 = 0;
+    while (i < total) : (i += 1) try pipeline.submit(testEnvelope(i));
+    try pipeline.flush();
+
+    try std.testing.expectEqual(@as(u64, total), pipeline.stats.envelopes_settled);
+    try std.testing.expectEqual(@as(u64, 0), pipeline.stats.batches_failed);
+    try std.testing.expect(pipeline.stats.retries > 0);
+    try std.testing.expectEqual(@as(u64, total), cluster.settledEnvelopes());
+}
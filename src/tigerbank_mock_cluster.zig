@@ -0,0 +1,141 @@
+const std = @import("std");
+const Wire = @import("tigerbank_client.zig").Wire;
+
+/// Loopback stand-in for a settlement cluster, for tests and benchmarks.
+///
+/// Serves one client connection at a time on 127.0.0.1. Each batch frame is
+/// validated, "settled" after an optional fixed commit latency, and
+/// acknowledged. Settled batch ids are remembered, so resends are acked
+/// without settling twice. `retry_every = n` answers `retry` the first time
+/// it sees each n-th batch id, to exercise client retries.
+pub const MockCluster = struct {
+    pub const Options = struct {
+        batch_latency_us: u32 = 0,
+        retry_every: u64 = 0,
+        // Bounded: Max batch frame accepted
+        max_batch_bytes: u32 = 1024 * 1024,
+    };
+
+    allocator: std.mem.Allocator,
+    options: Options,
+    listener: std.net.Server,
+    thread: std.Thread,
+    body: []u8,
+    settled_ids: std.AutoHashMapUnmanaged(u64, void),
+    retried_ids: std.AutoHashMapUnmanaged(u64, void),
+    settled_envelopes: std.atomic.Value(u64),
+    settled_batches: std.atomic.Value(u64),
+    stopping: std.atomic.Value(bool),
+
+    /// Listen on an ephemeral loopback port and start serving.
+    pub fn start(self: *MockCluster, allocator: std.mem.Allocator, options: Options) !void {
+        const address = try std.net.Address.parseIp("127.0.0.1", 0);
+        self.* = .{
+            .allocator = allocator,
+            .options = options,
+            .listener = try address.listen(.{ .reuse_address = true }),
+            .thread = undefined,
+            .body = undefined,
+            .settled_ids = .{},
+            .retried_ids = .{},
+            .settled_envelopes = std.atomic.Value(u64).init(0),
+            .settled_batches = std.atomic.Value(u64).init(0),
+            .stopping = std.atomic.Value(bool).init(false),
+        };
+        errdefer self.listener.deinit();
+        self.body = try allocator.alloc(u8, options.max_batch_bytes);
+        errdefer allocator.free(self.body);
+        self.thread = try std.Thread.spawn(.{}, serve, .{self});
+    }
+
+    pub fn stop(self: *MockCluster) void {
+        self.stopping.store(true, .release);
+        // Wake the accept loop.
+        if (std.net.tcpConnectToAddress(self.listener.listen_address)) |stream| stream.close() else |_| {}
+        self.thread.join();
+        self.listener.deinit();
+        self.settled_ids.deinit(self.allocator);
+        self.retried_ids.deinit(self.allocator);
+        self.allocator.free(self.body);
+        self.* = undefined;
+    }
+
+    pub fn port(self: *const MockCluster) u16 {
+        return self.listener.listen_address.getPort();
+    }
+
+    pub fn settledEnvelopes(self: *const MockCluster) u64 {
+        return self.settled_envelopes.load(.acquire);
+    }
+
+    pub fn settledBatches(self: *const MockCluster) u64 {
+        return self.settled_batches.load(.acquire);
+    }
+
+    fn serve(self: *MockCluster) void {
+        while (!self.stopping.load(.acquire)) {
+            const accepted = self.listener.accept() catch return;
+            defer accepted.stream.close();
+            self.serveConnection(accepted.stream.handle) catch {};
+        }
+    }
+
+    fn serveConnection(self: *MockCluster, fd: std.posix.fd_t) !void {
+        var header_bytes: [Wire.batch_header_len]u8 = undefined;
+        while (try readExact(fd, &header_bytes)) {
+            const header = try Wire.parseBatchHeader(&header_bytes);
+            if (header.body_len > self.body.len) return error.BatchTooLarge;
+            const body = self.body[0..header.body_len];
+            if (!try readExact(fd, body)) return;
+
+            var ack_bytes: [Wire.ack_len]u8 = undefined;
+            Wire.writeAck(try self.settle(header, body), &ack_bytes);
+            var index: usize = 0;
+            while (index < ack_bytes.len) index += try std.posix.write(fd, ack_bytes[index..]);
+        }
+    }
+
+    fn settle(self: *MockCluster, header: Wire.BatchHeader, body: []const u8) !Wire.Ack {
+        var ack = Wire.Ack{ .batch_id = header.batch_id, .status = .settled, .settled = header.count };
+        if (self.settled_ids.contains(header.batch_id)) return ack;
+
+        var entries = Wire.EntryIterator{ .body = body };
+        var count: u32 = 0;
+        while (entries.next() catch null) |_| count += 1;
+        if (count != header.count or entries.index != body.len) {
+            ack.status = .rejected;
+            ack.settled = 0;
+            return ack;
+        }
+        if (self.options.retry_every > 0 and header.batch_id % self.options.retry_every == 0 and
+            !self.retried_ids.contains(header.batch_id))
+        {
+            try self.retried_ids.put(self.allocator, header.batch_id, {});
+            ack.status = .retry;
+            ack.settled = 0;
+            return ack;
+        }
+
+        if (self.options.batch_latency_us > 0) {
+            std.Thread.sleep(@as(u64, self.options.batch_latency_us) * std.time.ns_per_us);
+        }
+        try self.settled_ids.put(self.allocator, header.batch_id, {});
+        _ = self.settled_envelopes.fetchAdd(header.count, .acq_rel);
+        _ = self.settled_batches.fetchAdd(1, .acq_rel);
+        return ack;
+    }
+
+    // False on a clean end of stream before any byte.
+    fn readExact(fd: std.posix.fd_t, out: []u8) !bool {
+        var index: usize = 0;
+        while (index < out.len) {
+            const n = try std.posix.read(fd, out[index..]);
+            if (n == 0) {
+                if (index == 0) return false;
+                return error.UnexpectedEof;
+            }
+            index += n;
+        }
+        return true;
+    }
+};
@@ -29,7 +29,7 @@ test "read_input_event reads keyboard events" {
     integration.finish_init();
     
     // Assert: Event must be in queue.
-    try testing.expect(vm.input_event_queue.count > 0);
+    try testing.expect(vm.input_event_queue.size() > 0);
     
     // Note: Integration layer handles read_input_event directly, not via kernel.
     // The event is available for reading via the syscall.
@@ -50,7 +50,7 @@ test "read_input_event reads mouse events" {
     integration.finish_init();
     
     // Assert: Event must be in queue.
-    try testing.expect(vm.input_event_queue.count > 0);
+    try testing.expect(vm.input_event_queue.size() > 0);
 }
 
 // Test: file I/O syscalls work for configuration files.
@@ -185,7 +185,7 @@ test "read_input_event returns would_block when no events" {
     integration.finish_init();
     
     // Assert: Event queue must be empty.
-    try testing.expect(vm.input_event_queue.count == 0);
+    try testing.expect(vm.input_event_queue.size() == 0);
     
     // Note: Integration layer handles read_input_event and returns would_block.
     // This test verifies the queue is empty.
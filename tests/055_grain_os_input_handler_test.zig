@@ -113,3 +113,72 @@ test "input event parse mouse" {
     std.debug.assert(event.mouse.y == 250);
 }
 
+
+// Mock syscall that drains three events (move, move, down) in one call.
+fn mock_syscall_event_batch(
+    syscall_num: u32,
+    arg1: u64,
+    arg2: u64,
+    _arg3: u64,
+    _arg4: u64,
+) i64 {
+    _ = _arg3;
+    _ = _arg4;
+    if (syscall_num != 60 or arg2 < 3) {
+        return -1;
+    }
+    const buf = @as([*]u8, @ptrFromInt(@as(usize, @intCast(arg1))));
+    const kinds = [_]u8{ 2, 2, 0 };
+    var i: u32 = 0;
+    while (i < kinds.len) : (i += 1) {
+        const event = buf[i * 32 .. (i + 1) * 32];
+        @memset(event, 0);
+        event[0] = 0; // event_type = mouse
+        event[4] = kinds[i];
+        std.mem.writeInt(u32, event[6..10], 10 * (i + 1), .little);
+        std.mem.writeInt(u32, event[10..14], 20 * (i + 1), .little);
+    }
+    return 3 * 32;
+}
+
+fn mouse_event(kind: grain_os.input_handler.MouseEventKind, x: u32, y: u32) InputEvent {
+    var event = InputEvent{ .event_type = .mouse, .mouse = undefined, .keyboard = undefined };
+    event.mouse.kind = kind;
+    event.mouse.button = 0;
+    event.mouse.x = x;
+    event.mouse.y = y;
+    event.mouse.modifiers = 0;
+    return event;
+}
+
+test "input handler reads event batch in one syscall" {
+    var handler = InputHandler.init();
+    handler.set_syscall_fn(mock_syscall_event_batch);
+    var events: [grain_os.input_handler.MAX_BATCH_EVENTS]InputEvent = undefined;
+    const count = try handler.read_events(&events);
+    std.debug.assert(count == 3);
+    std.debug.assert(events[0].mouse.kind == .move);
+    std.debug.assert(events[1].mouse.x == 20);
+    std.debug.assert(events[2].mouse.kind == .down);
+    std.debug.assert(events[2].mouse.y == 60);
+}
+
+test "coalesce motion keeps latest position and button order" {
+    var events = [_]InputEvent{
+        mouse_event(.move, 1, 1),
+        mouse_event(.move, 2, 2),
+        mouse_event(.move, 3, 3),
+        mouse_event(.down, 3, 3),
+        mouse_event(.move, 4, 4),
+        mouse_event(.move, 5, 5),
+        mouse_event(.up, 5, 5),
+    };
+    const count = grain_os.input_handler.coalesce_motion(&events);
+    std.debug.assert(count == 4);
+    std.debug.assert(events[0].mouse.kind == .move);
+    std.debug.assert(events[0].mouse.x == 3);
+    std.debug.assert(events[1].mouse.kind == .down);
+    std.debug.assert(events[2].mouse.kind == .move);
+    std.debug.assert(events[2].mouse.x == 5);
+    std.debug.assert(events[3].mouse.kind == .up);
+}
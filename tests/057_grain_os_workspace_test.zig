@@ -5,6 +5,7 @@ const std = @import("std");
 const testing = std.testing;
 const workspace = @import("grain_os").workspace;
 const compositor = @import("grain_os").compositor;
+const tiling = @import("grain_os").tiling;
 
 test "workspace initialization" {
     const ws = workspace.Workspace.init(1, "test");
@@ -97,3 +98,88 @@ test "compositor window workspace assignment" {
     const success = comp.assign_window_to_workspace(win1, ws2_id);
     try testing.expect(success == true);
 }
+
+test "workspace manager window index" {
+    var manager = workspace.WorkspaceManager.init();
+    const ws2_id = manager.create_workspace("workspace2") orelse unreachable;
+    var id: u32 = 1;
+    while (id <= 64) : (id += 1) {
+        const target = if (id % 2 == 0) ws2_id else 1;
+        try testing.expect(manager.assign_window_to_workspace(id, target));
+    }
+    try testing.expect(manager.get_window_workspace(2) == ws2_id);
+    try testing.expect(manager.get_window_workspace(3) == 1);
+    // Move, then remove: index follows.
+    try testing.expect(manager.assign_window_to_workspace(3, ws2_id));
+    try testing.expect(manager.get_window_workspace(3) == ws2_id);
+    try testing.expect(!manager.get_workspace(1).?.has_window(3));
+    try testing.expect(manager.remove_window(3) == ws2_id);
+    try testing.expect(manager.get_window_workspace(3) == null);
+    try testing.expect(manager.remove_window(3) == null);
+    // Remaining ids still resolve after backward-shift deletes.
+    id = 4;
+    while (id <= 64) : (id += 1) {
+        const expected = if (id % 2 == 0) ws2_id else 1;
+        try testing.expect(manager.get_window_workspace(id) == expected);
+    }
+}
+
+test "workspace manager invalidates hidden layouts" {
+    var manager = workspace.WorkspaceManager.init();
+    const ws2_id = manager.create_workspace("workspace2") orelse unreachable;
+    manager.invalidate_hidden_layouts();
+    try testing.expect(manager.get_workspace(1).?.layout_valid);
+    try testing.expect(!manager.get_workspace(ws2_id).?.layout_valid);
+}
+
+test "compositor workspace switch restores focus and damages switched windows" {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    var comp = compositor.Compositor.init(gpa.allocator());
+    const win1 = try comp.create_window(100, 100);
+    const ws2_id = comp.create_workspace("workspace2") orelse unreachable;
+    try testing.expect(comp.switch_workspace(ws2_id));
+    const win2 = try comp.create_window(100, 100);
+    _ = comp.focus_window(win2);
+    _ = comp.take_repaint_damage();
+    try testing.expect(comp.switch_workspace(1));
+    try testing.expect(comp.get_window(win1).?.visible);
+    try testing.expect(!comp.get_window(win2).?.visible);
+    try testing.expect(comp.take_repaint_damage() != null);
+    try testing.expect(comp.switch_workspace(ws2_id));
+    try testing.expect(comp.focused_window_id == win2);
+    try testing.expect(comp.workspace_manager.get_window_workspace(win2) == ws2_id);
+}
+
+test "compositor remove window invalidates its hidden workspace" {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    var comp = compositor.Compositor.init(gpa.allocator());
+    _ = try comp.create_window(100, 100);
+    const ws2_id = comp.create_workspace("workspace2") orelse unreachable;
+    try testing.expect(comp.switch_workspace(ws2_id));
+    const win2 = try comp.create_window(100, 100);
+    _ = try comp.create_window(100, 100);
+    try testing.expect(comp.switch_workspace(1));
+    comp.workspace_manager.get_workspace(ws2_id).?.layout_valid = true;
+    try testing.expect(comp.remove_window(win2));
+    try testing.expect(!comp.workspace_manager.get_workspace(ws2_id).?.layout_valid);
+}
+
+test "compositor session restore moves windows between tiling trees" {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    var comp = compositor.Compositor.init(gpa.allocator());
+    const win1 = try comp.create_window(100, 100);
+    const ws2_id = comp.create_workspace("workspace2") orelse unreachable;
+    try testing.expect(comp.assign_window_to_workspace(win1, ws2_id));
+    const session_id = comp.create_window_session("parked") orelse unreachable;
+    try testing.expect(comp.assign_window_to_workspace(win1, 1));
+    try testing.expect(comp.tiling_tree.get_window_bounds(win1) != null);
+
+    try testing.expect(comp.restore_window_session(session_id));
+    try testing.expect(comp.workspace_manager.get_window_workspace(win1) == ws2_id);
+    try testing.expect(comp.tiling_tree.root_index == tiling.MAX_LAYOUT_WINDOWS);
+    try testing.expect(comp.workspace_trees[ws2_id - 1].get_window_bounds(win1) != null);
+    try testing.expect(!comp.get_window(win1).?.visible);
+}
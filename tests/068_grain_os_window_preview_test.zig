@@ -137,3 +137,127 @@ test "preview window clear" {
     std.debug.assert(preview.valid == false);
 }
 
+// Fill an RGBA surface: left half red, right half blue.
+fn fill_halves(memory: []u8, width: u32, height: u32) void {
+    var y: u32 = 0;
+    while (y < height) : (y += 1) {
+        var x: u32 = 0;
+        while (x < width) : (x += 1) {
+            const offset = (y * width + x) * 4;
+            const left = x < width / 2;
+            memory[offset + 0] = if (left) 0xFF else 0x00;
+            memory[offset + 1] = 0x00;
+            memory[offset + 2] = if (left) 0x00 else 0xFF;
+            memory[offset + 3] = 0xFF;
+        }
+    }
+}
+
+test "preview downsamples source pixels" {
+    const allocator = std.testing.allocator;
+    const manager = try allocator.create(PreviewManager);
+    defer allocator.destroy(manager);
+    manager.* = PreviewManager.init();
+    const memory = try allocator.alloc(u8, 640 * 360 * 4);
+    defer allocator.free(memory);
+    fill_halves(memory, 640, 360);
+    manager.set_screen_source(grain_os.window_preview.Surface.init(memory, 640, 360));
+    std.debug.assert(manager.generate_preview(1, 0, 0, 640, 360, 640, 360));
+    const preview = manager.get_preview(1).?;
+    std.debug.assert(preview.valid);
+    std.debug.assert(!preview.dirty);
+    // 0xRRGGBBAA: left edge red, right edge blue.
+    std.debug.assert(preview.pixels[0] == 0xFF0000FF);
+    std.debug.assert(preview.pixels[grain_os.window_preview.PREVIEW_WIDTH - 1] == 0x0000FFFF);
+}
+
+fn halves_source(surface: *const grain_os.window_preview.Surface, _: u32) grain_os.window_preview.Capture {
+    return .{ .pixels = .{ .surface = surface.*, .rect = surface.bounds() } };
+}
+
+fn hidden_source(_: *const grain_os.window_preview.Surface, _: u32) grain_os.window_preview.Capture {
+    return .keep;
+}
+
+test "refresh only recaptures damaged previews within budget" {
+    const allocator = std.testing.allocator;
+    const manager = try allocator.create(PreviewManager);
+    defer allocator.destroy(manager);
+    manager.* = PreviewManager.init();
+    const memory = try allocator.alloc(u8, 640 * 360 * 4);
+    defer allocator.free(memory);
+    fill_halves(memory, 640, 360);
+    const surface = grain_os.window_preview.Surface.init(memory, 640, 360);
+    var id: u32 = 1;
+    while (id <= 8) : (id += 1) {
+        _ = manager.get_preview(id);
+    }
+    // 640x360 → 4x4 taps: the budget covers two captures per frame.
+    const budget = grain_os.window_preview.REFRESH_TAP_BUDGET;
+    std.debug.assert(manager.get_dirty_count() == 8);
+    std.debug.assert(manager.refresh_dirty(&surface, halves_source, 1, budget) == 2);
+    std.debug.assert(manager.get_dirty_count() == 6);
+    var frame: u64 = 2;
+    while (manager.get_dirty_count() > 0) : (frame += 1) {
+        _ = manager.refresh_dirty(&surface, halves_source, frame, budget);
+    }
+    std.debug.assert(frame == 5);
+    // Nothing damaged: nothing refreshed.
+    std.debug.assert(manager.refresh_dirty(&surface, halves_source, frame, budget) == 0);
+    manager.mark_damaged(3);
+    std.debug.assert(manager.refresh_dirty(&surface, halves_source, frame, budget) == 1);
+    std.debug.assert(manager.get_preview(3).?.timestamp == frame);
+    std.debug.assert(manager.get_preview(4).?.timestamp != frame);
+}
+
+test "preview swizzles bgra client buffers and forces x* alpha" {
+    const allocator = std.testing.allocator;
+    const manager = try allocator.create(PreviewManager);
+    defer allocator.destroy(manager);
+    manager.* = PreviewManager.init();
+    const memory = try allocator.alloc(u8, 640 * 360 * 4);
+    defer allocator.free(memory);
+    fill_halves(memory, 640, 360);
+    // xrgb8888 bytes are B,G,R,X: left half is blue, alpha is garbage.
+    var i: usize = 3;
+    while (i < memory.len) : (i += 4) memory[i] = 0x00;
+    const surface = grain_os.window_preview.Surface.init(memory, 640, 360);
+    std.debug.assert(manager.generate_preview_from(1, .{ .pixels = .{
+        .surface = surface,
+        .rect = surface.bounds(),
+        .swap_red_blue = true,
+        .force_opaque = true,
+    } }));
+    const preview = manager.get_preview(1).?;
+    std.debug.assert(preview.pixels[0] == 0x0000FFFF);
+    std.debug.assert(preview.pixels[grain_os.window_preview.PREVIEW_WIDTH - 1] == 0xFF0000FF);
+}
+
+test "hidden previews keep their last capture" {
+    const allocator = std.testing.allocator;
+    const manager = try allocator.create(PreviewManager);
+    defer allocator.destroy(manager);
+    manager.* = PreviewManager.init();
+    const memory = try allocator.alloc(u8, 640 * 360 * 4);
+    defer allocator.free(memory);
+    fill_halves(memory, 640, 360);
+    const surface = grain_os.window_preview.Surface.init(memory, 640, 360);
+    const budget = grain_os.window_preview.REFRESH_TAP_BUDGET;
+    // Never captured: a hidden window gets the fallback fill.
+    _ = manager.get_preview(1);
+    std.debug.assert(manager.refresh_dirty(&surface, hidden_source, 1, budget) == 1);
+    std.debug.assert(manager.get_preview(1).?.pixels[0] == 0xFFCCCCCC);
+    std.debug.assert(manager.refresh_dirty(&surface, halves_source, 2, budget) == 0);
+    manager.mark_damaged(1);
+    std.debug.assert(manager.refresh_dirty(&surface, halves_source, 3, budget) == 1);
+    // Damaged while hidden: the capture is kept and stays dirty.
+    manager.mark_damaged(1);
+    std.debug.assert(manager.refresh_dirty(&surface, hidden_source, 4, budget) == 0);
+    const preview = manager.get_preview(1).?;
+    std.debug.assert(preview.dirty);
+    std.debug.assert(preview.timestamp == 3);
+    std.debug.assert(preview.pixels[0] == 0xFF0000FF);
+    // Uncovered: recaptured.
+    std.debug.assert(manager.refresh_dirty(&surface, halves_source, 5, budget) == 1);
+    std.debug.assert(!manager.get_preview(1).?.dirty);
+}
@@ -33,8 +33,8 @@ test "start animation" {
     );
     std.debug.assert(result);
     std.debug.assert(manager.animations_len == 1);
-    std.debug.assert(manager.animations[0].window_id == 1);
-    std.debug.assert(manager.animations[0].active == true);
+    std.debug.assert(manager.window_ids[0] == 1);
+    std.debug.assert(manager.get_animation(1).?.active == true);
 }
 
 test "get animation" {
@@ -138,7 +138,96 @@ test "compositor update animations" {
 }
 
 test "animation constants" {
-    std.debug.assert(grain_os.window_animation.MAX_ANIMATIONS == 64);
+    std.debug.assert(grain_os.window_animation.MAX_ANIMATIONS == 1024);
     std.debug.assert(grain_os.window_animation.ANIMATION_DURATION_MS == 200);
 }
 
+test "advance interpolates all animations in one pass" {
+    const manager = try std.testing.allocator.create(AnimationManager);
+    defer std.testing.allocator.destroy(manager);
+    manager.* = AnimationManager.init();
+    // Odd count: exercises a partial final vector.
+    var id: u32 = 1;
+    while (id <= 13) : (id += 1) {
+        const x: i32 = @intCast(id * 10);
+        std.debug.assert(manager.start_animation(id, AnimationType.move, x, 0, 100, 100, 255, x + 100, 50, 100, 100, 255, 0));
+    }
+    _ = manager.set_easing(13, .linear);
+    const step = manager.advance(100);
+    std.debug.assert(step.len == 13);
+    std.debug.assert(step.completed.len == 0);
+    var i: u32 = 0;
+    while (i < step.len) : (i += 1) {
+        const sample = manager.sample(i);
+        const start_x: i32 = @intCast(sample.window_id * 10);
+        std.debug.assert(sample.channels == grain_os.window_animation.CHANNEL_POSITION);
+        std.debug.assert(sample.x > start_x and sample.x < start_x + 100);
+        if (sample.window_id == 13) {
+            std.debug.assert(sample.x == start_x + 50); // Linear at half time.
+        } else {
+            std.debug.assert(sample.x > start_x + 50); // Ease-out runs ahead.
+        }
+    }
+}
+
+test "advance retires finished animations and reports them" {
+    const manager = try std.testing.allocator.create(AnimationManager);
+    defer std.testing.allocator.destroy(manager);
+    manager.* = AnimationManager.init();
+    _ = manager.start_animation(1, AnimationType.move, 0, 0, 100, 100, 255, 100, 0, 100, 100, 255, 0);
+    _ = manager.start_animation(2, AnimationType.move, 0, 0, 100, 100, 255, 100, 0, 100, 100, 255, 150);
+    _ = manager.start_animation(3, AnimationType.opacity, 0, 0, 0, 0, 0, 0, 0, 0, 0, 255, 0);
+    const step = manager.advance(200);
+    std.debug.assert(step.len == 3);
+    std.debug.assert(step.completed.len == 2);
+    std.debug.assert(manager.get_count() == 1);
+    std.debug.assert(manager.get_animation(2) != null);
+    std.debug.assert(manager.get_animation(1) == null);
+    std.debug.assert(manager.get_animation(3) == null);
+    // Samples stay readable after retirement, finished ones at target.
+    var i: u32 = 0;
+    while (i < step.len) : (i += 1) {
+        const sample = manager.sample(i);
+        if (sample.window_id == 1) std.debug.assert(sample.done and sample.x == 100);
+        if (sample.window_id == 3) std.debug.assert(sample.done and sample.opacity == 255);
+        if (sample.window_id == 2) std.debug.assert(!sample.done);
+    }
+}
+
+test "animation table holds every window of a workspace transition" {
+    const manager = try std.testing.allocator.create(AnimationManager);
+    defer std.testing.allocator.destroy(manager);
+    manager.* = AnimationManager.init();
+    var id: u32 = 1;
+    while (id <= 256) : (id += 1) {
+        std.debug.assert(manager.start_animation(id, AnimationType.move, 0, 0, 64, 64, 255, 1024, 0, 64, 64, 255, 0));
+    }
+    std.debug.assert(manager.get_count() == 256);
+    // Swap-removes keep the id index consistent.
+    id = 1;
+    while (id <= 256) : (id += 2) {
+        std.debug.assert(manager.remove_animation(id));
+    }
+    id = 2;
+    while (id <= 256) : (id += 2) {
+        std.debug.assert(manager.get_animation(id).?.window_id == id);
+    }
+    const step = manager.advance(1000);
+    std.debug.assert(step.completed.len == 128);
+    std.debug.assert(manager.get_count() == 0);
+}
+
+test "fade animation leaves geometry alone" {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const comp = try gpa.allocator().create(Compositor);
+    defer gpa.allocator().destroy(comp);
+    comp.* = Compositor.init(gpa.allocator());
+    const window_id = try comp.create_window(800, 600);
+    const before = comp.get_window(window_id).?.*;
+    comp.update_animations(100);
+    const win = comp.get_window(window_id).?;
+    std.debug.assert(win.width == before.width and win.height == before.height);
+    std.debug.assert(win.x == before.x and win.y == before.y);
+    std.debug.assert(win.opacity > 0 and win.opacity < 255);
+}
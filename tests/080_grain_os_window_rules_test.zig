@@ -11,13 +11,14 @@ const MatchType = grain_os.window_rules.MatchType;
 const ActionType = grain_os.window_rules.ActionType;
 
 test "window rule manager initialization" {
-    const manager = WindowRuleManager.init();
+    const manager = WindowRuleManager.init(std.testing.allocator);
     std.debug.assert(manager.rules_len == 0);
     std.debug.assert(manager.next_rule_id == 1);
 }
 
 test "add window rule" {
-    var manager = WindowRuleManager.init();
+    var manager = WindowRuleManager.init(std.testing.allocator);
+    defer manager.deinit();
     const rule_id_opt = manager.add_rule(
         MatchType.title,
         "Terminal",
@@ -31,7 +32,8 @@ test "add window rule" {
 }
 
 test "match window" {
-    var manager = WindowRuleManager.init();
+    var manager = WindowRuleManager.init(std.testing.allocator);
+    defer manager.deinit();
     _ = manager.add_rule(MatchType.title, "Terminal", ActionType.set_position);
     const rule_opt = manager.match_window("Terminal");
     std.debug.assert(rule_opt != null);
@@ -42,14 +44,16 @@ test "match window" {
 }
 
 test "match window substring" {
-    var manager = WindowRuleManager.init();
+    var manager = WindowRuleManager.init(std.testing.allocator);
+    defer manager.deinit();
     _ = manager.add_rule(MatchType.title, "Term", ActionType.set_position);
     const rule_opt = manager.match_window("Terminal");
     std.debug.assert(rule_opt != null);
 }
 
 test "remove window rule" {
-    var manager = WindowRuleManager.init();
+    var manager = WindowRuleManager.init(std.testing.allocator);
+    defer manager.deinit();
     if (manager.add_rule(MatchType.title, "Terminal", ActionType.set_position)) |rule_id| {
         const result = manager.remove_rule(rule_id);
         std.debug.assert(result);
@@ -58,7 +62,8 @@ test "remove window rule" {
 }
 
 test "clear all rules" {
-    var manager = WindowRuleManager.init();
+    var manager = WindowRuleManager.init(std.testing.allocator);
+    defer manager.deinit();
     _ = manager.add_rule(MatchType.title, "Terminal", ActionType.set_position);
     _ = manager.add_rule(MatchType.title, "Editor", ActionType.set_size);
     manager.clear_all();
@@ -66,7 +71,8 @@ test "clear all rules" {
 }
 
 test "get rule count" {
-    var manager = WindowRuleManager.init();
+    var manager = WindowRuleManager.init(std.testing.allocator);
+    defer manager.deinit();
     std.debug.assert(manager.get_rule_count() == 0);
     _ = manager.add_rule(MatchType.title, "Terminal", ActionType.set_position);
     std.debug.assert(manager.get_rule_count() == 1);
@@ -78,6 +84,7 @@ test "compositor add window rule" {
     const allocator = gpa.allocator();
 
     var comp = Compositor.init(allocator);
+    defer comp.deinit();
     const rule_id_opt = comp.add_window_rule(
         MatchType.title,
         "Terminal",
@@ -92,6 +99,7 @@ test "compositor remove window rule" {
     const allocator = gpa.allocator();
 
     var comp = Compositor.init(allocator);
+    defer comp.deinit();
     if (comp.add_window_rule(MatchType.title, "Terminal", ActionType.set_position)) |rule_id| {
         const result = comp.remove_window_rule(rule_id);
         std.debug.assert(result);
@@ -104,13 +112,14 @@ test "compositor get rule count" {
     const allocator = gpa.allocator();
 
     var comp = Compositor.init(allocator);
+    defer comp.deinit();
     std.debug.assert(comp.get_rule_count() == 0);
     _ = comp.add_window_rule(MatchType.title, "Terminal", ActionType.set_position);
     std.debug.assert(comp.get_rule_count() == 1);
 }
 
 test "window rules constants" {
-    std.debug.assert(grain_os.window_rules.MAX_RULES == 64);
+    std.debug.assert(grain_os.window_rules.MAX_RULES == 4096);
     std.debug.assert(grain_os.window_rules.MAX_PATTERN_LEN == 256);
 }
 
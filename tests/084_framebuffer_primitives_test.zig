@@ -0,0 +1,108 @@
+//! Tests for shared vectorized framebuffer primitives.
+//!
+//! Why: Verify fills, glyph expansion, and blits match per-pixel reference
+//! output, clip correctly, and report the rect they touched.
+//! GrainStyle: grain_case, u32/u64, bounded operations, assertions.
+
+const std = @import("std");
+const testing = std.testing;
+const fb = @import("framebuffer_primitives");
+
+const WIDTH: u32 = 37; // Odd width exercises vector tails.
+const HEIGHT: u32 = 21;
+
+fn read_pixel(surface: fb.Surface, x: u32, y: u32) u32 {
+    const offset: usize = @as(usize, y) * surface.stride + @as(usize, x) * fb.BYTES_PER_PIXEL;
+    return std.mem.readInt(u32, surface.memory[offset..][0..4], .big);
+}
+
+test "clear fills every pixel with color bytes in RGBA order" {
+    var memory: [WIDTH * HEIGHT * 4]u8 = undefined;
+    const surface = fb.Surface.init(&memory, WIDTH, HEIGHT);
+    const rect = fb.clear(surface, 0x11223344);
+    try testing.expectEqual(WIDTH, rect.width);
+    try testing.expectEqual(HEIGHT, rect.height);
+    try testing.expectEqual(@as(u8, 0x11), memory[0]);
+    try testing.expectEqual(@as(u8, 0x44), memory[3]);
+    var y: u32 = 0;
+    while (y < HEIGHT) : (y += 1) {
+        var x: u32 = 0;
+        while (x < WIDTH) : (x += 1) {
+            try testing.expectEqual(@as(u32, 0x11223344), read_pixel(surface, x, y));
+        }
+    }
+}
+
+test "fill rect clips against surface edges" {
+    var memory: [WIDTH * HEIGHT * 4]u8 = undefined;
+    const surface = fb.Surface.init(&memory, WIDTH, HEIGHT);
+    _ = fb.clear(surface, 0);
+    const rect = fb.fill_rect(surface, -5, -3, 10, 6, 0xFF0000FF).?;
+    try testing.expectEqual(@as(u32, 0), rect.x);
+    try testing.expectEqual(@as(u32, 0), rect.y);
+    try testing.expectEqual(@as(u32, 5), rect.width);
+    try testing.expectEqual(@as(u32, 3), rect.height);
+    try testing.expectEqual(@as(u32, 0xFF0000FF), read_pixel(surface, 4, 2));
+    try testing.expectEqual(@as(u32, 0), read_pixel(surface, 5, 2));
+    try testing.expectEqual(@as(u32, 0), read_pixel(surface, 4, 3));
+    // Fully off-surface rect touches nothing.
+    try testing.expect(fb.fill_rect(surface, 100, 100, 4, 4, 0xFFFFFFFF) == null);
+}
+
+test "glyph expansion matches per-bit reference" {
+    var memory: [WIDTH * HEIGHT * 4]u8 = undefined;
+    const surface = fb.Surface.init(&memory, WIDTH, HEIGHT);
+    _ = fb.clear(surface, 0);
+    const fg: u32 = 0xFFFFFFFF;
+    const bg: u32 = 0x1E1E2EFF;
+    const pattern = fb.glyph_pattern('A');
+    _ = fb.draw_glyph(surface, pattern, 3, 2, fg, bg).?;
+    var py: u32 = 0;
+    while (py < fb.GLYPH_HEIGHT) : (py += 1) {
+        var px: u32 = 0;
+        while (px < fb.GLYPH_WIDTH) : (px += 1) {
+            const bit_idx: u6 = @intCast(py * 8 + px);
+            const bit = (pattern >> (63 - bit_idx)) & 1;
+            const expected: u32 = if (bit == 1) fg else bg;
+            try testing.expectEqual(expected, read_pixel(surface, 3 + px, 2 + py));
+        }
+    }
+}
+
+test "clipped glyph writes only visible columns" {
+    var memory: [WIDTH * HEIGHT * 4]u8 = undefined;
+    const surface = fb.Surface.init(&memory, WIDTH, HEIGHT);
+    _ = fb.clear(surface, 0);
+    const rect = fb.draw_glyph(surface, 0xFFFFFFFFFFFFFFFF, -6, HEIGHT - 3, 0xABCDEFFF, 0).?;
+    try testing.expectEqual(@as(u32, 2), rect.width);
+    try testing.expectEqual(@as(u32, 3), rect.height);
+    try testing.expectEqual(@as(u32, 0xABCDEFFF), read_pixel(surface, 1, HEIGHT - 1));
+    try testing.expectEqual(@as(u32, 0), read_pixel(surface, 2, HEIGHT - 1));
+}
+
+test "text reports union of glyph rects" {
+    var memory: [WIDTH * HEIGHT * 4]u8 = undefined;
+    const surface = fb.Surface.init(&memory, WIDTH, HEIGHT);
+    const rect = fb.draw_text(surface, "ab\nc", 1, 1, 0xFFFFFFFF, 0x000000FF).?;
+    try testing.expectEqual(@as(u32, 1), rect.x);
+    try testing.expectEqual(@as(u32, 1), rect.y);
+    try testing.expectEqual(@as(u32, 16), rect.width);
+    try testing.expectEqual(@as(u32, 16), rect.height);
+}
+
+test "blit copies clipped source rows" {
+    var src_memory: [8 * 8 * 4]u8 = undefined;
+    const src = fb.Surface.init(&src_memory, 8, 8);
+    _ = fb.clear(src, 0x00FF00FF);
+    _ = fb.fill_rect(src, 0, 0, 1, 8, 0x0000FFFF);
+    var dst_memory: [WIDTH * HEIGHT * 4]u8 = undefined;
+    const dst = fb.Surface.init(&dst_memory, WIDTH, HEIGHT);
+    _ = fb.clear(dst, 0);
+    const rect = fb.blit(dst, WIDTH - 4, 0, src, src.bounds()).?;
+    try testing.expectEqual(@as(u32, WIDTH - 4), rect.x);
+    try testing.expectEqual(@as(u32, 4), rect.width);
+    try testing.expectEqual(@as(u32, 8), rect.height);
+    try testing.expectEqual(@as(u32, 0x0000FFFF), read_pixel(dst, WIDTH - 4, 0));
+    try testing.expectEqual(@as(u32, 0x00FF00FF), read_pixel(dst, WIDTH - 1, 7));
+    try testing.expectEqual(@as(u32, 0), read_pixel(dst, WIDTH - 1, 8));
+}
@@ -0,0 +1,134 @@
+//! Tests for the lock-free SPSC input ring and InputEventQueue.
+//!
+//! Why: Verify FIFO order, overflow accounting, batched dequeue, mouse-move
+//! coalescing, latency recording, and ordering across real threads.
+//! GrainStyle: grain_case, u32/u64, bounded operations, assertions.
+
+const std = @import("std");
+const testing = std.testing;
+const kernel_vm = @import("kernel_vm");
+const input_ring = kernel_vm.input_ring;
+const InputEvent = kernel_vm.InputEvent;
+const InputEventQueue = kernel_vm.InputEventQueue;
+
+fn mouse(kind: u8, x: u32, y: u32) InputEvent {
+    return .{
+        .event_type = 0,
+        .mouse = .{ .kind = kind, .button = 0, .x = x, .y = y, .modifiers = 0 },
+        .keyboard = .{ .kind = 0, .key_code = 0, .character = 0, .modifiers = 0 },
+    };
+}
+
+fn key(character: u32) InputEvent {
+    return .{
+        .event_type = 1,
+        .mouse = .{ .kind = 0, .button = 0, .x = 0, .y = 0, .modifiers = 0 },
+        .keyboard = .{ .kind = 0, .key_code = character, .character = character, .modifiers = 0 },
+    };
+}
+
+test "ring preserves FIFO order and counts overflow" {
+    var ring = input_ring.SpscRing(u32, 4){};
+    try testing.expect(ring.push(1));
+    try testing.expect(ring.push(2));
+    try testing.expect(ring.push(3));
+    try testing.expect(ring.push(4));
+    try testing.expect(!ring.push(5));
+    try testing.expectEqual(@as(u64, 1), ring.overflow_count());
+    try testing.expectEqual(@as(u32, 4), ring.len());
+
+    var out: [3]u32 = undefined;
+    try testing.expectEqual(@as(u32, 3), ring.pop_batch(&out));
+    try testing.expectEqualSlices(u32, &.{ 1, 2, 3 }, &out);
+    // Freed slots are reusable across the wrap.
+    try testing.expect(ring.push(6));
+    try testing.expectEqual(@as(u32, 4), ring.pop().?);
+    try testing.expectEqual(@as(u32, 6), ring.pop().?);
+    try testing.expect(ring.pop() == null);
+}
+
+test "ring producer and consumer lines do not share a cache line" {
+    const Ring = input_ring.SpscRing(u32, 8);
+    const producer = @offsetOf(Ring, "producer");
+    const consumer = @offsetOf(Ring, "consumer");
+    const distance = if (producer > consumer) producer - consumer else consumer - producer;
+    try testing.expect(distance >= input_ring.CACHE_LINE_SIZE);
+}
+
+test "queue coalesces consecutive mouse moves to the latest position" {
+    var queue = InputEventQueue{};
+    _ = queue.enqueue_at(mouse(2, 1, 1), 100);
+    _ = queue.enqueue_at(mouse(2, 2, 2), 200);
+    _ = queue.enqueue_at(mouse(2, 3, 3), 300);
+    _ = queue.enqueue_at(key('a'), 400);
+    _ = queue.enqueue_at(mouse(2, 9, 9), 500);
+    _ = queue.enqueue_at(mouse(0, 9, 9), 600); // Button down is never merged.
+
+    const first = queue.dequeue_at(1000).?;
+    try testing.expectEqual(@as(u32, 3), first.mouse.x);
+    try testing.expectEqual(@as(u8, 1), queue.dequeue_at(1000).?.event_type);
+    try testing.expectEqual(@as(u32, 9), queue.dequeue_at(1000).?.mouse.x);
+    try testing.expectEqual(@as(u8, 0), queue.dequeue_at(1000).?.mouse.kind);
+    try testing.expect(queue.dequeue_at(1000) == null);
+    try testing.expectEqual(@as(u64, 2), queue.coalesced_count);
+
+    // Merged move keeps the earliest enqueue time (900ns), not the latest.
+    try testing.expectEqual(@as(u64, 4), queue.latency.count);
+    try testing.expectEqual(@as(u64, 900), queue.latency.max_ns);
+    try testing.expectEqual(@as(u64, 400), queue.latency.min_ns);
+}
+
+test "queue batch dequeue drains in order and reports size" {
+    var queue = InputEventQueue{};
+    var i: u32 = 0;
+    while (i < 10) : (i += 1) {
+        _ = queue.enqueue(key('a' + i));
+    }
+    try testing.expectEqual(@as(u32, 10), queue.size());
+    var out: [4]InputEvent = undefined;
+    try testing.expectEqual(@as(u32, 4), queue.dequeue_batch(&out));
+    try testing.expectEqual(@as(u32, 'a'), out[0].keyboard.character);
+    try testing.expectEqual(@as(u32, 'd'), out[3].keyboard.character);
+    try testing.expectEqual(@as(u32, 6), queue.size());
+}
+
+test "vm inject keeps events beyond old 64-entry limit and counts overflow" {
+    var vm: kernel_vm.VM = undefined;
+    kernel_vm.VM.init(&vm, &[_]u8{}, 0);
+    var i: u32 = 0;
+    while (i < 300) : (i += 1) {
+        vm.inject_keyboard_event(0, 65, 'A', 0);
+    }
+    try testing.expectEqual(@as(u32, 256), vm.input_event_queue.size());
+    try testing.expectEqual(@as(u64, 44), vm.input_event_queue.overflow_count());
+}
+
+const STRESS_COUNT: u32 = 100_000;
+
+fn produce(ring: *input_ring.SpscRing(u32, 64)) void {
+    var i: u32 = 0;
+    while (i < STRESS_COUNT) {
+        if (ring.push(i)) {
+            i += 1;
+        } else {
+            std.atomic.spinLoopHint();
+        }
+    }
+}
+
+test "ring delivers every item in order across threads" {
+    var ring = input_ring.SpscRing(u32, 64){};
+    const thread = try std.Thread.spawn(.{}, produce, .{&ring});
+    var expected: u32 = 0;
+    var out: [16]u32 = undefined;
+    while (expected < STRESS_COUNT) {
+        const n = ring.pop_batch(&out);
+        for (out[0..n]) |value| {
+            try testing.expectEqual(expected, value);
+            expected += 1;
+        }
+        if (n == 0) std.atomic.spinLoopHint();
+    }
+    thread.join();
+    try testing.expect(ring.pop() == null);
+}
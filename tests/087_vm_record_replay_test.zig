@@ -0,0 +1,117 @@
+//! Tests for VM record/replay of nondeterministic inputs.
+//!
+//! Why: Verify the log round-trips every input kind, replay returns recorded
+//! values regardless of live host input, and seek lands on the exact
+//! instruction count via snapshots.
+//! GrainStyle: grain_case, u32/u64, bounded operations, assertions.
+
+const std = @import("std");
+const testing = std.testing;
+const kernel_vm = @import("kernel_vm");
+const VM = kernel_vm.VM;
+const replay = kernel_vm.replay;
+
+const LOAD_ADDRESS: u64 = 0x1000;
+const SBI_GETCHAR: u32 = 2;
+
+fn set_count(vm: *VM, count: u64) void {
+    vm.performance.instructions_executed = count;
+}
+
+test "log round-trips input, clock, and getchar entries" {
+    var buffer: [256]u8 = undefined;
+    var log = replay.Log.init(&buffer);
+    var event: kernel_vm.InputEvent = undefined;
+    event.event_type = 0;
+    event.mouse = .{ .kind = 2, .button = 1, .x = 1023, .y = 300, .modifiers = 4 };
+    event.keyboard = .{ .kind = 0, .key_code = 0, .character = 0, .modifiers = 0 };
+    try testing.expect(log.append(.{ .instruction_count = 5, .kind = .input, .value = 0, .input = event }));
+    try testing.expect(log.append(.{ .instruction_count = 5000, .kind = .clock, .value = 123_456_789_000, .input = undefined }));
+    try testing.expect(log.append(.{ .instruction_count = 5001, .kind = .getchar, .value = 'q', .input = undefined }));
+
+    const first = log.peek().?;
+    try testing.expectEqual(replay.EventKind.input, first.entry.kind);
+    try testing.expectEqual(@as(u32, 1023), first.entry.input.mouse.x);
+    try testing.expectEqual(@as(u8, 4), first.entry.input.mouse.modifiers);
+    log.advance(first.entry, first.size);
+    const second = log.peek().?;
+    try testing.expectEqual(@as(u64, 5000), second.entry.instruction_count);
+    try testing.expectEqual(@as(u64, 123_456_789_000), second.entry.value);
+    log.advance(second.entry, second.size);
+    const third = log.peek().?;
+    try testing.expectEqual(@as(u64, 'q'), third.entry.value);
+    log.advance(third.entry, third.size);
+    try testing.expect(log.peek() == null);
+    // Compact: small deltas and values take a few bytes per entry.
+    try testing.expect(log.len < 32);
+}
+
+test "replay returns recorded inputs and ignores live host input" {
+    var vm: VM = undefined;
+    VM.init(&vm, &[_]u8{}, 0);
+    var log_buffer: [256]u8 = undefined;
+    vm.replay.start_record(&vm, &log_buffer, log_buffer[0..0], 0);
+
+    vm.inject_keyboard_event(0, 65, 'A', 0);
+    _ = vm.inject_console_char('z');
+    set_count(&vm, 10);
+    try testing.expectEqual(@as(u32, 'A'), vm.next_input_event().?.keyboard.character);
+    set_count(&vm, 11);
+    try testing.expectEqual(@as(u64, 777), vm.read_clock_ns(777));
+    set_count(&vm, 12);
+    vm.handle_sbi_call(SBI_GETCHAR, 0, 0, 0, 0);
+    try testing.expectEqual(@as(u64, 'z'), vm.regs.get(10));
+    set_count(&vm, 13);
+    try testing.expect(vm.next_input_event() == null); // Empty poll: not logged.
+    const recorded_len = vm.replay.log.len;
+
+    // Replay from the start: different live inputs must not leak through.
+    set_count(&vm, 0);
+    vm.replay.start_replay(&vm, &log_buffer, recorded_len);
+    vm.inject_keyboard_event(0, 66, 'B', 0);
+    set_count(&vm, 9);
+    try testing.expect(vm.next_input_event() == null);
+    set_count(&vm, 10);
+    try testing.expectEqual(@as(u32, 'A'), vm.next_input_event().?.keyboard.character);
+    set_count(&vm, 11);
+    try testing.expectEqual(@as(u64, 777), vm.read_clock_ns(999));
+    set_count(&vm, 12);
+    vm.handle_sbi_call(SBI_GETCHAR, 0, 0, 0, 0);
+    try testing.expectEqual(@as(u64, 'z'), vm.regs.get(10));
+    set_count(&vm, 13);
+    vm.handle_sbi_call(SBI_GETCHAR, 0, 0, 0, 0);
+    try testing.expectEqual(@as(i64, -1), @as(i64, @bitCast(vm.regs.get(10))));
+    try testing.expect(!vm.replay.diverged);
+}
+
+test "seek restores nearest snapshot and replays to exact instruction count" {
+    // Program: 200 x "ADDI x1, x1, 1" (x1 == instructions executed).
+    var program: [200 * 4]u8 = undefined;
+    var i: u32 = 0;
+    while (i < 200) : (i += 1) {
+        std.mem.writeInt(u32, program[i * 4 ..][0..4], 0x00108093, .little);
+    }
+    var vm: VM = undefined;
+    VM.init(&vm, &program, LOAD_ADDRESS);
+
+    const snapshot_memory = try testing.allocator.alloc(u8, 4 * vm.memory.len);
+    defer testing.allocator.free(snapshot_memory);
+    var log_buffer: [64]u8 = undefined;
+    vm.replay.start_record(&vm, &log_buffer, snapshot_memory, 50);
+
+    vm.state = .running;
+    while (vm.performance.instructions_executed < 150) {
+        try vm.step();
+    }
+    try testing.expectEqual(@as(u64, 150), vm.regs.get(1));
+    try testing.expectEqual(@as(u32, 3), vm.replay.snapshot_len);
+
+    try vm.replay.seek(&vm, 75);
+    try testing.expectEqual(@as(u64, 75), vm.performance.instructions_executed);
+    try testing.expectEqual(@as(u64, 75), vm.regs.get(1));
+    try testing.expectEqual(LOAD_ADDRESS + 75 * 4, vm.regs.pc);
+
+    try vm.replay.seek(&vm, 10);
+    try testing.expectEqual(@as(u64, 10), vm.regs.get(1));
+    try testing.expectEqual(replay.Mode.replay, vm.replay.mode);
+}
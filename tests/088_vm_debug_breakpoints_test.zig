@@ -0,0 +1,179 @@
+//! Tests for VM breakpoints, watchpoints, and the GDB remote stub.
+//!
+//! Why: Verify idle debugging costs nothing (armed counts stay zero), the
+//! filters hit and miss correctly, resume steps past a breakpoint once, and
+//! RSP packets map onto VM state.
+//! GrainStyle: grain_case, u32/u64, bounded operations, assertions.
+
+const std = @import("std");
+const testing = std.testing;
+const kernel_vm = @import("kernel_vm");
+const VM = kernel_vm.VM;
+const debug_interface = kernel_vm.debug_interface;
+const gdb_stub = kernel_vm.gdb_stub;
+
+const LOAD_ADDRESS: u64 = 0x1000;
+const ADDI_X1_X1_1: u32 = 0x00108093;
+const SW_X1_0_X2: u32 = 0x00112023;
+
+fn init_addi_vm(vm: *VM, program: []u8) void {
+    var i: u32 = 0;
+    while (i * 4 < program.len) : (i += 1) {
+        std.mem.writeInt(u32, program[i * 4 ..][0..4], ADDI_X1_X1_1, .little);
+    }
+    VM.init(vm, program, LOAD_ADDRESS);
+    vm.state = .running;
+}
+
+test "armed counts track set and remove" {
+    var debug = debug_interface.VMDebugInterface.init();
+    try testing.expectEqual(@as(u32, 0), debug.armed_breakpoints);
+    try testing.expect(debug.set_breakpoint(0x1010));
+    try testing.expect(debug.set_watchpoint(0x2000, 4, false, true));
+    try testing.expectEqual(@as(u32, 1), debug.armed_breakpoints);
+    try testing.expectEqual(@as(u32, 1), debug.armed_watchpoints);
+    const generation = debug.breakpoint_generation;
+    try testing.expect(debug.remove_breakpoint(0x1010));
+    try testing.expect(debug.remove_watchpoint(0x2000));
+    try testing.expectEqual(@as(u32, 0), debug.armed_breakpoints);
+    try testing.expectEqual(@as(u32, 0), debug.armed_watchpoints);
+    try testing.expect(debug.breakpoint_generation != generation);
+}
+
+test "breakpoint filter hits exact pc and misses neighbours" {
+    var debug = debug_interface.VMDebugInterface.init();
+    try testing.expect(debug.set_breakpoint(0x1010));
+    try testing.expect(debug.is_breakpoint(0x1010));
+    try testing.expect(!debug.is_breakpoint(0x100C));
+    try testing.expect(!debug.is_breakpoint(0x1014));
+    // Same filter bit, different pc: the scan must reject it.
+    try testing.expect(!debug.is_breakpoint(0x1010 + debug_interface.FILTER_BITS * 4));
+}
+
+test "breakpoint stops execution and resume runs past it once" {
+    var program: [16 * 4]u8 = undefined;
+    var vm: VM = undefined;
+    init_addi_vm(&vm, &program);
+    try testing.expect(vm.debug_interface.set_breakpoint(LOAD_ADDRESS + 4 * 4));
+
+    var steps: u32 = 0;
+    while (steps < 16 and !vm.debug_interface.breakpoint_hit) : (steps += 1) {
+        try vm.step();
+    }
+    try testing.expect(vm.debug_interface.breakpoint_hit);
+    try testing.expectEqual(LOAD_ADDRESS + 4 * 4, vm.regs.pc);
+    try testing.expectEqual(@as(u64, 4), vm.regs.get(1));
+
+    vm.debug_interface.resume_from_breakpoint();
+    try vm.step();
+    try testing.expect(!vm.debug_interface.breakpoint_hit);
+    try testing.expectEqual(@as(u64, 5), vm.regs.get(1));
+}
+
+test "watchpoint traps store on watched page only" {
+    var program: [4]u8 = undefined;
+    var vm: VM = undefined;
+    init_addi_vm(&vm, &program);
+    try testing.expect(vm.debug_interface.set_watchpoint(0x2000, 4, false, true));
+    vm.regs.set(1, 0xAB);
+
+    vm.regs.set(2, 0x3000); // Different page: no trigger.
+    try vm.execute_sw(SW_X1_0_X2);
+    try testing.expect(!vm.debug_interface.watchpoint_triggered);
+
+    vm.regs.set(2, 0x2000);
+    try vm.execute_sw(SW_X1_0_X2);
+    try testing.expect(vm.debug_interface.watchpoint_triggered);
+    try testing.expectEqual(@as(u64, 0x2000), vm.debug_interface.last_watchpoint_addr);
+}
+
+test "watchpoint reinsert reuses its slot and remove frees it" {
+    var debug = debug_interface.VMDebugInterface.init();
+    var round: u32 = 0;
+    while (round < debug_interface.MAX_WATCHPOINTS * 2) : (round += 1) {
+        try testing.expect(debug.set_watchpoint(0x2000, 4, false, true));
+        try testing.expect(debug.set_watchpoint(0x2000, 4, false, true));
+        try testing.expectEqual(@as(u32, 1), debug.watchpoints_len);
+        try testing.expect(debug.remove_watchpoint(0x2000));
+        try testing.expectEqual(@as(u32, 0), debug.watchpoints_len);
+        try testing.expectEqual(@as(u32, 0), debug.armed_watchpoints);
+    }
+}
+
+test "packet reader validates checksums and frames replies" {
+    var reader = gdb_stub.PacketReader{};
+    var packet: ?[]const u8 = null;
+    for ("+$g#67") |byte| {
+        switch (reader.feed(byte)) {
+            .packet => |p| packet = p,
+            else => {},
+        }
+    }
+    try testing.expectEqualStrings("g", packet.?);
+
+    var bad = false;
+    for ("$g#00") |byte| {
+        if (reader.feed(byte) == .bad_checksum) bad = true;
+    }
+    try testing.expect(bad);
+    try testing.expect(reader.feed(0x03) == .interrupt);
+
+    var out: [16]u8 = undefined;
+    try testing.expectEqualStrings("$OK#9a", gdb_stub.frame_packet("OK", &out));
+}
+
+test "gdb stub reads registers, memory, and sets breakpoints" {
+    var program: [8 * 4]u8 = undefined;
+    var vm: VM = undefined;
+    init_addi_vm(&vm, &program);
+    vm.regs.set(1, 0x1122334455667788);
+    var stub = gdb_stub.GdbStub.init(&vm);
+
+    try testing.expectEqualStrings("S05", stub.handle_packet("?").payload);
+
+    const regs = stub.handle_packet("g").payload;
+    try testing.expectEqual(@as(usize, 33 * 16), regs.len);
+    try testing.expectEqualStrings("8877665544332211", regs[16..32]);
+    try testing.expectEqualStrings("0010000000000000", regs[32 * 16 ..]);
+
+    try testing.expectEqualStrings("93801000", stub.handle_packet("m1000,4").payload);
+    try testing.expectEqualStrings("E01", stub.handle_packet("m1000,ffffffff").payload);
+    try testing.expectEqualStrings("E01", stub.handle_packet("mfffffffffffffffe,4").payload);
+    try testing.expectEqualStrings("E01", stub.handle_packet("M1000,80000000:00").payload);
+
+    try testing.expectEqualStrings("OK", stub.handle_packet("Z0,1008,4").payload);
+    try testing.expect(vm.debug_interface.is_breakpoint(0x1008));
+    const stop = stub.run_continue(@as(u32, 0), never_interrupt);
+    try testing.expectEqualStrings("T05swbreak:;", stop);
+    try testing.expectEqual(@as(u64, 0x1008), vm.regs.pc);
+    try testing.expectEqualStrings("OK", stub.handle_packet("z0,1008,4").payload);
+    try testing.expect(!vm.debug_interface.is_breakpoint(0x1008));
+
+    try testing.expectEqualStrings("", stub.handle_packet("vMustReplyEmpty").payload);
+}
+
+test "gdb stub keeps a watchpoint per kind and reports the stop reason" {
+    var program: [8 * 4]u8 = undefined;
+    var vm: VM = undefined;
+    init_addi_vm(&vm, &program);
+    var stub = gdb_stub.GdbStub.init(&vm);
+    try testing.expectEqualStrings("OK", stub.handle_packet("M1000,4:23201100").payload);
+    vm.regs.set(1, 0xAB);
+    vm.regs.set(2, 0x2000);
+
+    try testing.expectEqualStrings("OK", stub.handle_packet("Z2,2000,4").payload);
+    try testing.expectEqualStrings("OK", stub.handle_packet("Z3,2000,4").payload);
+    try testing.expectEqual(@as(u32, 2), vm.debug_interface.watchpoints_len);
+    // Removing the read watchpoint leaves the write watchpoint armed.
+    try testing.expectEqualStrings("OK", stub.handle_packet("z3,2000,4").payload);
+    try testing.expectEqualStrings("E0E", stub.handle_packet("z3,2000,4").payload);
+    try testing.expectEqual(@as(u32, 1), vm.debug_interface.armed_watchpoints);
+
+    try testing.expectEqualStrings("T05watch:2000;", stub.run_step());
+    try testing.expectEqualStrings("OK", stub.handle_packet("z2,2000,4").payload);
+    try testing.expectEqual(@as(u32, 0), vm.debug_interface.watchpoints_len);
+}
+
+fn never_interrupt(_: u32) bool {
+    return false;
+}
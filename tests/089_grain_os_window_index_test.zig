@@ -0,0 +1,81 @@
+//! Tests for Grain OS window id index and spatial hit-testing.
+//!
+//! Why: Verify id lookups survive removals, hit-testing returns the topmost
+//! window in stacking order, and the grid follows moves and resizes.
+//! GrainStyle: grain_case, u32/u64, bounded operations, assertions.
+
+const std = @import("std");
+const grain_os = @import("grain_os");
+const WindowIndex = grain_os.window_index.WindowIndex;
+const MAX_INDEXED_WINDOWS = grain_os.window_index.MAX_INDEXED_WINDOWS;
+
+fn accept_all(_: void, _: u32) bool {
+    return true;
+}
+
+fn reject_slot_zero(_: void, slot: u32) bool {
+    return slot != 0;
+}
+
+test "window index initialization" {
+    const index = WindowIndex.init();
+    std.debug.assert(index.get_count() == 0);
+    std.debug.assert(index.slot_of(1) == null);
+}
+
+test "id lookups survive removals" {
+    var index = WindowIndex.init();
+    var id: u32 = 1;
+    while (id <= MAX_INDEXED_WINDOWS) : (id += 1) {
+        std.debug.assert(index.insert(id, id - 1));
+    }
+    std.debug.assert(!index.insert(MAX_INDEXED_WINDOWS + 1, 0));
+    // Remove every third id, then every remaining id must still resolve.
+    id = 1;
+    while (id <= MAX_INDEXED_WINDOWS) : (id += 3) {
+        std.debug.assert(index.remove(id));
+    }
+    id = 1;
+    while (id <= MAX_INDEXED_WINDOWS) : (id += 1) {
+        if ((id - 1) % 3 == 0) {
+            std.debug.assert(index.slot_of(id) == null);
+        } else {
+            std.debug.assert(index.slot_of(id).? == id - 1);
+        }
+    }
+    index.set_slot(2, 7);
+    std.debug.assert(index.slot_of(2).? == 7);
+}
+
+test "hit test returns topmost window in stacking order" {
+    var index = WindowIndex.init();
+    _ = index.insert(1, 0);
+    _ = index.insert(2, 1);
+    index.update_rect(1, 0, 0, 400, 300);
+    index.update_rect(2, 100, 100, 400, 300);
+    // Window 1 stacked above window 2 despite later insertion of 2.
+    const order = [_]u32{ 2, 1 };
+    index.set_stack_order(&order);
+    std.debug.assert(index.hit_test(150, 150, {}, accept_all).? == 1);
+    std.debug.assert(index.hit_test(450, 350, {}, accept_all).? == 2);
+    std.debug.assert(index.hit_test(800, 700, {}, accept_all) == null);
+    // Filter skips hidden windows and falls through to the next one.
+    std.debug.assert(index.hit_test(150, 150, {}, reject_slot_zero).? == 2);
+}
+
+test "grid follows moves and removals" {
+    var index = WindowIndex.init();
+    _ = index.insert(1, 0);
+    index.update_rect(1, 0, 0, 64, 64);
+    const order = [_]u32{1};
+    index.set_stack_order(&order);
+    std.debug.assert(index.hit_test(10, 10, {}, accept_all).? == 1);
+    index.update_rect(1, 900, 600, 100, 100);
+    std.debug.assert(index.hit_test(10, 10, {}, accept_all) == null);
+    std.debug.assert(index.hit_test(950, 650, {}, accept_all).? == 1);
+    // Partly off-screen windows are still hit on their visible part.
+    index.update_rect(1, -50, -50, 100, 100);
+    std.debug.assert(index.hit_test(20, 20, {}, accept_all).? == 1);
+    std.debug.assert(index.remove(1));
+    std.debug.assert(index.hit_test(20, 20, {}, accept_all) == null);
+}
@@ -0,0 +1,355 @@
+//! Tests for Grain OS Wayland server over a loopback transport.
+//!
+//! Why: Drive the core protocol with a headless client (registry bind,
+//! shm pool, buffer, attach/damage/frame/commit) and verify the compositor
+//! sees the committed pixels in place, the damage, and frame callbacks.
+//! GrainStyle: grain_case, u32/u64, bounded operations, assertions.
+
+const std = @import("std");
+const grain_os = @import("grain_os");
+const wire = grain_os.wayland_wire;
+const server_mod = grain_os.wayland_server;
+const Server = server_mod.Server;
+const FramebufferRenderer = grain_os.framebuffer_renderer.FramebufferRenderer;
+
+// One direction of the loopback connection.
+const ByteQueue = struct {
+    bytes: [16384]u8 = undefined,
+    len: u32 = 0,
+
+    fn push(self: *ByteQueue, data: []const u8) void {
+        std.debug.assert(self.len + data.len <= self.bytes.len);
+        @memcpy(self.bytes[self.len..][0..data.len], data);
+        self.len += @intCast(data.len);
+    }
+
+    fn pop(self: *ByteQueue, out: []u8) u32 {
+        const n: u32 = @intCast(@min(out.len, self.len));
+        @memcpy(out[0..n], self.bytes[0..n]);
+        std.mem.copyForwards(u8, self.bytes[0 .. self.len - n], self.bytes[n..self.len]);
+        self.len -= n;
+        return n;
+    }
+};
+
+// Headless client: writes requests, reads events.
+const Loopback = struct {
+    to_server: ByteQueue = .{},
+    to_client: ByteQueue = .{},
+    scratch: [wire.MAX_MESSAGE_SIZE]u8 = undefined,
+
+    fn transport(self: *Loopback) server_mod.Transport {
+        return .{ .context = self, .send_fn = server_send, .recv_fn = server_recv };
+    }
+
+    fn server_send(context: *anyopaque, bytes: []const u8) bool {
+        const self: *Loopback = @ptrCast(@alignCast(context));
+        self.to_client.push(bytes);
+        return true;
+    }
+
+    fn server_recv(context: *anyopaque, buf: []u8) u32 {
+        const self: *Loopback = @ptrCast(@alignCast(context));
+        return self.to_server.pop(buf);
+    }
+
+    fn request(self: *Loopback, object_id: u32, opcode: u16, args: []const u32) void {
+        var msg = wire.MessageWriter.begin(&self.scratch, object_id, opcode);
+        for (args) |arg| msg.put_uint(arg);
+        self.to_server.push(msg.finish() catch unreachable);
+    }
+
+    fn bind(self: *Loopback, registry: u32, name: u32, interface: []const u8, version: u32, id: u32) void {
+        var msg = wire.MessageWriter.begin(&self.scratch, registry, 0);
+        msg.put_uint(name);
+        msg.put_string(interface);
+        msg.put_uint(version);
+        msg.put_uint(id);
+        self.to_server.push(msg.finish() catch unreachable);
+    }
+
+    // Count events for object_id/opcode; optionally return the first u32 arg.
+    fn count_events(self: *const Loopback, object_id: u32, opcode: u16, first_arg: ?*u32) u32 {
+        var count: u32 = 0;
+        var pos: u32 = 0;
+        while (wire.Header.decode(self.to_client.bytes[pos..self.to_client.len])) |header| {
+            std.debug.assert(header.size >= wire.HEADER_SIZE);
+            if (header.object_id == object_id and header.opcode == opcode) {
+                if (count == 0) {
+                    if (first_arg) |out| {
+                        var reader = wire.MessageReader.init(self.to_client.bytes[pos .. pos + header.size]);
+                        out.* = reader.uint() catch unreachable;
+                    }
+                }
+                count += 1;
+            }
+            pos += header.size;
+        }
+        return count;
+    }
+
+    fn clear_events(self: *Loopback) void {
+        self.to_client.len = 0;
+    }
+};
+
+// Records compositor-side hook calls.
+const TestSink = struct {
+    next_window: u32 = 1,
+    mapped: u32 = 0,
+    unmapped: u32 = 0,
+    commits: u32 = 0,
+    last_view: ?server_mod.BufferView = null,
+    last_damage: ?server_mod.Rect = null,
+
+    fn sink(self: *TestSink) server_mod.SurfaceSink {
+        return .{ .context = self, .map_fn = map, .commit_fn = commit, .unmap_fn = unmap };
+    }
+
+    fn map(context: *anyopaque, width: u32, height: u32) u32 {
+        const self: *TestSink = @ptrCast(@alignCast(context));
+        std.debug.assert(width > 0 and height > 0);
+        self.mapped += 1;
+        const id = self.next_window;
+        self.next_window += 1;
+        return id;
+    }
+
+    fn commit(
+        context: *anyopaque,
+        window_id: u32,
+        view: ?server_mod.BufferView,
+        damage: ?server_mod.Rect,
+    ) void {
+        const self: *TestSink = @ptrCast(@alignCast(context));
+        std.debug.assert(window_id > 0);
+        self.commits += 1;
+        self.last_view = view;
+        self.last_damage = damage;
+    }
+
+    fn unmap(context: *anyopaque, window_id: u32) void {
+        const self: *TestSink = @ptrCast(@alignCast(context));
+        std.debug.assert(window_id > 0);
+        self.unmapped += 1;
+    }
+};
+
+// Object ids used by the headless client.
+const REGISTRY: u32 = 2;
+const COMPOSITOR: u32 = 3;
+const SHM: u32 = 4;
+const POOL: u32 = 5;
+const BUFFER: u32 = 6;
+const SURFACE: u32 = 7;
+const FRAME: u32 = 8;
+
+const POOL_OFFSET: u32 = 256;
+const BUF_W: u32 = 4;
+const BUF_H: u32 = 2;
+
+const Fixture = struct {
+    arena: [4096]u8 = [_]u8{0} ** 4096,
+    mapper: server_mod.ArenaShmMapper = undefined,
+    client: Loopback = .{},
+    sink: TestSink = .{},
+    server: *Server = undefined,
+    client_index: u32 = 0,
+    pool_handle: u32 = 0,
+
+    fn setup(self: *Fixture) void {
+        self.mapper = .{ .arena = &self.arena };
+        self.pool_handle = self.mapper.grant(POOL_OFFSET, 1024).?;
+        self.server = std.testing.allocator.create(Server) catch unreachable;
+        self.server.init(self.mapper.mapper());
+        self.server.set_sink(self.sink.sink());
+        self.client_index = self.server.connect(self.client.transport()).?;
+    }
+
+    fn teardown(self: *Fixture) void {
+        std.testing.allocator.destroy(self.server);
+    }
+
+    // Registry, globals, pool, one argb8888 buffer, one surface.
+    fn create_surface_with_buffer(self: *Fixture) void {
+        self.client.request(server_mod.DISPLAY_ID, 1, &.{REGISTRY});
+        self.client.bind(REGISTRY, server_mod.GLOBAL_COMPOSITOR, "wl_compositor", 4, COMPOSITOR);
+        self.client.bind(REGISTRY, server_mod.GLOBAL_SHM, "wl_shm", 1, SHM);
+        self.client.request(SHM, 0, &.{ POOL, self.pool_handle, 1024 });
+        self.client.request(POOL, 0, &.{ BUFFER, 0, BUF_W, BUF_H, BUF_W * 4, server_mod.ShmFormat.argb8888 });
+        self.client.request(COMPOSITOR, 0, &.{SURFACE});
+        self.server.dispatch(self.client_index);
+        std.debug.assert(self.server.is_connected(self.client_index));
+    }
+};
+
+test "registry advertises globals and shm formats" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    f.create_surface_with_buffer();
+    std.debug.assert(f.client.count_events(REGISTRY, 0, null) == 2);
+    std.debug.assert(f.client.count_events(SHM, 0, null) == 4);
+}
+
+test "commit maps surface and exposes pool pixels in place" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    f.create_surface_with_buffer();
+    // Client draws first pixel (B,G,R,A order for argb8888).
+    f.arena[POOL_OFFSET + 0] = 0x30;
+    f.arena[POOL_OFFSET + 1] = 0x20;
+    f.arena[POOL_OFFSET + 2] = 0x10;
+    f.arena[POOL_OFFSET + 3] = 0xFF;
+    f.client.request(SURFACE, 1, &.{ BUFFER, 0, 0 });
+    f.client.request(SURFACE, 2, &.{ 1, 0, 2, 1 });
+    f.client.request(SURFACE, 6, &.{});
+    f.server.dispatch(f.client_index);
+    std.debug.assert(f.sink.mapped == 1);
+    std.debug.assert(f.sink.commits == 1);
+    const view = f.sink.last_view.?;
+    std.debug.assert(view.width == BUF_W and view.height == BUF_H);
+    // Zero-copy: the view aliases the shared arena.
+    std.debug.assert(@intFromPtr(view.pixels.ptr) == @intFromPtr(&f.arena[POOL_OFFSET]));
+    const damage = f.sink.last_damage.?;
+    std.debug.assert(damage.x == 1 and damage.y == 0 and damage.width == 2 and damage.height == 1);
+
+    // Composite into a framebuffer: red/blue swapped into RGBA order.
+    const fb_memory = std.testing.allocator.alloc(u8, grain_os.framebuffer_renderer.FRAMEBUFFER_WIDTH *
+        grain_os.framebuffer_renderer.FRAMEBUFFER_HEIGHT * 4) catch unreachable;
+    defer std.testing.allocator.free(fb_memory);
+    @memset(fb_memory, 0);
+    var renderer = FramebufferRenderer.init();
+    renderer.set_surface(fb_memory);
+    const src = view.as_surface();
+    std.debug.assert(renderer.blit_surface(0, 0, src, src.bounds(), !view.is_rgba_order(), view.is_opaque()));
+    std.debug.assert(fb_memory[0] == 0x10);
+    std.debug.assert(fb_memory[1] == 0x20);
+    std.debug.assert(fb_memory[2] == 0x30);
+    std.debug.assert(fb_memory[3] == 0xFF);
+    const drawn = renderer.take_damage().?;
+    std.debug.assert(drawn.width == BUF_W and drawn.height == BUF_H);
+}
+
+test "frame callbacks fire after repaint and ids are released" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    f.create_surface_with_buffer();
+    f.client.clear_events();
+    f.client.request(SURFACE, 1, &.{ BUFFER, 0, 0 });
+    f.client.request(SURFACE, 3, &.{FRAME});
+    f.client.request(SURFACE, 6, &.{});
+    f.server.dispatch(f.client_index);
+    // Not done until the compositor repaints.
+    std.debug.assert(f.client.count_events(FRAME, 0, null) == 0);
+    f.server.send_frame_done(1234);
+    var time: u32 = 0;
+    std.debug.assert(f.client.count_events(FRAME, 0, &time) == 1);
+    std.debug.assert(time == 1234);
+    var deleted: u32 = 0;
+    std.debug.assert(f.client.count_events(server_mod.DISPLAY_ID, 1, &deleted) == 1);
+    std.debug.assert(deleted == FRAME);
+    // Callback id is free again.
+    f.client.request(SURFACE, 3, &.{FRAME});
+    f.server.dispatch(f.client_index);
+    std.debug.assert(f.server.is_connected(f.client_index));
+}
+
+test "replacing the attached buffer releases the old one" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    f.create_surface_with_buffer();
+    const BUFFER2: u32 = 9;
+    f.client.request(POOL, 0, &.{ BUFFER2, 64, BUF_W, BUF_H, BUF_W * 4, server_mod.ShmFormat.abgr8888 });
+    f.client.request(SURFACE, 1, &.{ BUFFER, 0, 0 });
+    f.client.request(SURFACE, 6, &.{});
+    f.server.dispatch(f.client_index);
+    f.client.clear_events();
+    f.client.request(SURFACE, 1, &.{ BUFFER2, 0, 0 });
+    f.client.request(SURFACE, 6, &.{});
+    f.server.dispatch(f.client_index);
+    std.debug.assert(f.client.count_events(BUFFER, 0, null) == 1);
+    // New contents without explicit damage: whole buffer is damaged.
+    const damage = f.sink.last_damage.?;
+    std.debug.assert(damage.width == BUF_W and damage.height == BUF_H);
+    std.debug.assert(f.sink.last_view.?.is_rgba_order());
+}
+
+test "protocol errors disconnect the client" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    f.create_surface_with_buffer();
+    f.client.clear_events();
+    // Buffer larger than the pool.
+    f.client.request(POOL, 0, &.{ 10, 1000, 64, 64, 256, server_mod.ShmFormat.argb8888 });
+    f.server.dispatch(f.client_index);
+    std.debug.assert(!f.server.is_connected(f.client_index));
+    var object_id: u32 = 0;
+    std.debug.assert(f.client.count_events(server_mod.DISPLAY_ID, 0, &object_id) == 1);
+    std.debug.assert(object_id == POOL);
+}
+
+test "shm pools stay inside their granted region" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    f.create_surface_with_buffer();
+    // Asking for more than the grant clamps the pool to it.
+    const POOL2: u32 = 10;
+    const small = f.mapper.grant(2048, 64).?;
+    f.client.request(SHM, 0, &.{ POOL2, small, 4096 });
+    f.client.request(POOL2, 0, &.{ 11, 0, 4, 4, 16, server_mod.ShmFormat.argb8888 });
+    f.server.dispatch(f.client_index);
+    std.debug.assert(f.server.is_connected(f.client_index));
+    // A buffer past the grant is a protocol error.
+    f.client.request(POOL2, 0, &.{ 12, 0, 4, 8, 16, server_mod.ShmFormat.argb8888 });
+    f.server.dispatch(f.client_index);
+    std.debug.assert(!f.server.is_connected(f.client_index));
+    // Out-of-range grants and handles are refused.
+    std.debug.assert(f.mapper.grant(4000, 512) == null);
+    std.debug.assert(f.mapper.mapper().map(f.mapper.grants_len, 16) == null);
+}
+
+test "shm pool with an unknown handle disconnects the client" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    f.client.request(server_mod.DISPLAY_ID, 1, &.{REGISTRY});
+    f.client.bind(REGISTRY, server_mod.GLOBAL_SHM, "wl_shm", 1, SHM);
+    f.client.request(SHM, 0, &.{ POOL, POOL_OFFSET, 1024 });
+    f.server.dispatch(f.client_index);
+    std.debug.assert(!f.server.is_connected(f.client_index));
+}
+
+test "surface destroy unmaps the window" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    f.create_surface_with_buffer();
+    f.client.request(SURFACE, 1, &.{ BUFFER, 0, 0 });
+    f.client.request(SURFACE, 6, &.{});
+    f.client.request(SURFACE, 0, &.{});
+    f.server.dispatch(f.client_index);
+    std.debug.assert(f.sink.mapped == 1);
+    std.debug.assert(f.sink.unmapped == 1);
+}
+
+test "partial messages wait for the rest" {
+    var f = Fixture{};
+    f.setup();
+    defer f.teardown();
+    // Split get_registry across two reads.
+    var msg = wire.MessageWriter.begin(&f.client.scratch, server_mod.DISPLAY_ID, 1);
+    msg.put_uint(REGISTRY);
+    const bytes = msg.finish() catch unreachable;
+    f.client.to_server.push(bytes[0..6]);
+    f.server.dispatch(f.client_index);
+    std.debug.assert(f.client.count_events(REGISTRY, 0, null) == 0);
+    f.client.to_server.push(bytes[6..]);
+    f.server.dispatch(f.client_index);
+    std.debug.assert(f.client.count_events(REGISTRY, 0, null) == 2);
+}
@@ -0,0 +1,185 @@
+//! Tests for Grain OS binary session snapshots.
+//! Why: Verify a saved desktop restores exactly and damaged data is rejected.
+
+const std = @import("std");
+const testing = std.testing;
+const grain_os = @import("grain_os");
+const compositor = grain_os.compositor;
+const session_snapshot = grain_os.session_snapshot;
+
+fn build_desktop(comp: *compositor.Compositor) !void {
+    const ws2_id = comp.create_workspace("code") orelse unreachable;
+    var i: u32 = 0;
+    while (i < 6) : (i += 1) {
+        const win = try comp.create_window(200 + i * 10, 150);
+        comp.get_window(win).?.set_title("terminal");
+        if (i % 2 == 1) try testing.expect(comp.assign_window_to_workspace(win, ws2_id));
+    }
+    _ = comp.raise_window(1);
+    _ = comp.focus_window(3);
+    _ = comp.add_window_rule(.title, "terminal", .set_floating);
+}
+
+test "session snapshot round trip" {
+    const allocator = testing.allocator;
+    const source = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(source);
+    source.* = compositor.Compositor.init(allocator);
+    defer source.deinit();
+    try build_desktop(source);
+
+    const buf = try allocator.alloc(u8, session_snapshot.MAX_SNAPSHOT_SIZE);
+    defer allocator.free(buf);
+    const len = try source.save_snapshot(buf);
+    try testing.expect(len > session_snapshot.HEADER_SIZE);
+
+    const restored = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(restored);
+    restored.* = compositor.Compositor.init(allocator);
+    defer restored.deinit();
+    try restored.restore_snapshot(buf[0..len]);
+
+    try testing.expect(restored.windows_len == source.windows_len);
+    var i: u32 = 0;
+    while (i < source.windows_len) : (i += 1) {
+        const a = &source.windows[i];
+        const b = restored.get_window(a.id).?;
+        try testing.expect(a.x == b.x and a.y == b.y);
+        try testing.expect(a.width == b.width and a.height == b.height);
+        try testing.expect(a.visible == b.visible);
+        try testing.expectEqualStrings(a.title[0..a.title_len], b.title[0..b.title_len]);
+        try testing.expect(source.workspace_manager.get_window_workspace(a.id) ==
+            restored.workspace_manager.get_window_workspace(a.id));
+    }
+    const stack_len = source.window_stack.window_ids_len;
+    try testing.expect(restored.window_stack.window_ids_len == stack_len);
+    try testing.expectEqualSlices(
+        u32,
+        source.window_stack.window_ids[0..stack_len],
+        restored.window_stack.window_ids[0..stack_len],
+    );
+    try testing.expect(restored.focused_window_id == source.focused_window_id);
+    try testing.expect(restored.get_rule_count() == source.get_rule_count());
+    try testing.expect(restored.take_repaint_damage() != null);
+    // New ids continue after the restored ones.
+    const next = try restored.create_window(100, 100);
+    try testing.expect(next > 6);
+}
+
+test "session snapshot rejects corruption" {
+    const allocator = testing.allocator;
+    const source = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(source);
+    source.* = compositor.Compositor.init(allocator);
+    defer source.deinit();
+    try build_desktop(source);
+
+    const buf = try allocator.alloc(u8, session_snapshot.MAX_SNAPSHOT_SIZE);
+    defer allocator.free(buf);
+    const len = try source.save_snapshot(buf);
+
+    const target = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(target);
+    target.* = compositor.Compositor.init(allocator);
+    defer target.deinit();
+
+    // Flipped body byte: checksum mismatch, nothing restored.
+    buf[len - 1] ^= 0x40;
+    try testing.expectError(error.Corrupt, target.restore_snapshot(buf[0..len]));
+    try testing.expect(target.windows_len == 0);
+    buf[len - 1] ^= 0x40;
+
+    // Truncated snapshot.
+    try testing.expectError(error.Corrupt, target.restore_snapshot(buf[0 .. len - 4]));
+
+    // Wrong magic.
+    buf[0] ^= 0xFF;
+    try testing.expectError(error.BadMagic, target.restore_snapshot(buf[0..len]));
+    buf[0] ^= 0xFF;
+
+    // Restore only into an empty compositor.
+    try testing.expectError(error.NotEmpty, source.restore_snapshot(buf[0..len]));
+    try target.restore_snapshot(buf[0..len]);
+}
+
+// Overwrite a u32 in the body and re-seal the checksum. Returns the old value.
+fn poke_u32(buf: []u8, len: u32, offset: u32, value: u32) u32 {
+    const old = std.mem.readInt(u32, buf[offset..][0..4], .little);
+    std.mem.writeInt(u32, buf[offset..][0..4], value, .little);
+    const body = buf[session_snapshot.HEADER_SIZE..len];
+    std.mem.writeInt(u32, buf[12..16], std.hash.Crc32.hash(body), .little);
+    return old;
+}
+
+test "session snapshot validates every section before restoring" {
+    const allocator = testing.allocator;
+    const source = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(source);
+    source.* = compositor.Compositor.init(allocator);
+    defer source.deinit();
+    try build_desktop(source);
+
+    const buf = try allocator.alloc(u8, session_snapshot.MAX_SNAPSHOT_SIZE);
+    defer allocator.free(buf);
+    const len = try source.save_snapshot(buf);
+
+    const target = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(target);
+    target.* = compositor.Compositor.init(allocator);
+    defer target.deinit();
+
+    // Stack entry naming a missing window, checksum intact: rejected with
+    // nothing restored, so the same compositor can retry.
+    // Window records are 24 bytes plus the padded title ("terminal").
+    const stack_offset = session_snapshot.HEADER_SIZE + 6 * 32;
+    const old = poke_u32(buf, len, stack_offset, 999);
+    try testing.expectError(error.Corrupt, target.restore_snapshot(buf[0..len]));
+    try testing.expect(target.windows_len == 0);
+    try testing.expect(target.get_rule_count() == 0);
+    _ = poke_u32(buf, len, stack_offset, old);
+    try target.restore_snapshot(buf[0..len]);
+    try testing.expect(target.windows_len == source.windows_len);
+}
+
+test "session snapshot rejects bad split ratios" {
+    const allocator = testing.allocator;
+    const source = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(source);
+    source.* = compositor.Compositor.init(allocator);
+    defer source.deinit();
+    try build_desktop(source);
+
+    const buf = try allocator.alloc(u8, session_snapshot.MAX_SNAPSHOT_SIZE);
+    defer allocator.free(buf);
+    const len = try source.save_snapshot(buf);
+
+    const target = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(target);
+    target.* = compositor.Compositor.init(allocator);
+    defer target.deinit();
+
+    // First split node's ratio (0.6); its high word holds sign and exponent.
+    var ratio_bytes: [8]u8 = undefined;
+    std.mem.writeInt(u64, &ratio_bytes, @bitCast(@as(f64, 0.6)), .little);
+    const ratio_offset: u32 = @intCast(std.mem.indexOf(u8, buf[session_snapshot.HEADER_SIZE..len], &ratio_bytes).?);
+    const high_offset = session_snapshot.HEADER_SIZE + ratio_offset + 4;
+
+    for ([_]u32{ 0x7FF80000, 0x7FF00000, 0xBFE33333, 0x40000000 }) |high| {
+        const old = poke_u32(buf, len, high_offset, high);
+        try testing.expectError(error.Corrupt, target.restore_snapshot(buf[0..len]));
+        try testing.expect(target.windows_len == 0);
+        _ = poke_u32(buf, len, high_offset, old);
+    }
+    try target.restore_snapshot(buf[0..len]);
+}
+
+test "session snapshot reports small buffer" {
+    const allocator = testing.allocator;
+    const source = try allocator.create(compositor.Compositor);
+    defer allocator.destroy(source);
+    source.* = compositor.Compositor.init(allocator);
+    defer source.deinit();
+    try build_desktop(source);
+    var small: [64]u8 = undefined;
+    try testing.expectError(error.BufferTooSmall, source.save_snapshot(&small));
+}
@@ -0,0 +1,116 @@
+//! Tests for the Grain OS headless render harness.
+//! Why: Scripted scenarios on the null backend must be deterministic so
+//! frame hashes catch output regressions and counters catch slowdowns.
+
+const std = @import("std");
+const testing = std.testing;
+const grain_os = @import("grain_os");
+const platform = @import("platform");
+const render_harness = grain_os.render_harness;
+const compositor = grain_os.compositor;
+const NullWindow = platform.Platform.null_backend.NullWindow;
+
+const FRAMES: u32 = 24;
+
+const Fixture = struct {
+    window: NullWindow,
+    comp: *compositor.Compositor,
+    harness: render_harness.Harness,
+};
+
+fn fixture_init(fixture: *Fixture) !void {
+    fixture.window = try NullWindow.init(testing.allocator, "render harness");
+    errdefer fixture.window.deinit();
+    fixture.comp = try testing.allocator.create(compositor.Compositor);
+    fixture.harness.init(fixture.comp, testing.allocator, fixture.window.getBuffer());
+}
+
+fn fixture_deinit(fixture: *Fixture) void {
+    fixture.harness.deinit();
+    testing.allocator.destroy(fixture.comp);
+    fixture.window.deinit();
+}
+
+test "render harness scenarios are deterministic" {
+    const fixture = try testing.allocator.create(Fixture);
+    defer testing.allocator.destroy(fixture);
+    try fixture_init(fixture);
+    defer fixture_deinit(fixture);
+    var first: [FRAMES]render_harness.FrameStats = undefined;
+    var second: [FRAMES]render_harness.FrameStats = undefined;
+    inline for (std.meta.fields(render_harness.Scenario)) |field| {
+        const scenario: render_harness.Scenario = @enumFromInt(field.value);
+        const a = try fixture.harness.run(scenario, &first);
+        const b = try fixture.harness.run(scenario, &second);
+        try testing.expect(a.frames == FRAMES);
+        try testing.expect(a.hash == b.hash);
+        try testing.expect(a.pixels_touched == b.pixels_touched);
+        try testing.expect(a.syscalls == b.syscalls);
+        var i: u32 = 0;
+        while (i < FRAMES) : (i += 1) {
+            try testing.expect(first[i].hash == second[i].hash);
+            // Full-render scenarios repaint at least the full-screen clear.
+            if (scenario != .client_commit) {
+                try testing.expect(first[i].pixels_touched >= 1024 * 768);
+            }
+        }
+        try fixture.window.present();
+    }
+    try testing.expect(fixture.window.present_count == std.meta.fields(render_harness.Scenario).len);
+}
+
+test "render harness drag issues input syscalls and moves the window" {
+    const fixture = try testing.allocator.create(Fixture);
+    defer testing.allocator.destroy(fixture);
+    try fixture_init(fixture);
+    defer fixture_deinit(fixture);
+    var frames: [FRAMES]render_harness.FrameStats = undefined;
+    const report = try fixture.harness.run(.drag, &frames);
+    // At least one input read per frame.
+    try testing.expect(report.syscalls >= FRAMES);
+    const win = fixture.comp.get_window(fixture.harness.drag_window_id).?;
+    try testing.expect(win.drag_state.active);
+    try testing.expect(win.x != win.drag_state.window_start_x or win.y != win.drag_state.window_start_y);
+    // The window moves, so consecutive frames differ.
+    try testing.expect(frames[1].hash != frames[2].hash);
+}
+
+test "render harness scenarios produce distinct output" {
+    const fixture = try testing.allocator.create(Fixture);
+    defer testing.allocator.destroy(fixture);
+    try fixture_init(fixture);
+    defer fixture_deinit(fixture);
+    var frames: [FRAMES]render_harness.FrameStats = undefined;
+    const tiling = try fixture.harness.run(.tiling, &frames);
+    // Tall and wide layouts place windows differently.
+    try testing.expect(frames[0].hash != frames[1].hash);
+    const flip = try fixture.harness.run(.workspace_flip, &frames);
+    // Workspaces hold 3, 4 and 5 windows; once fade-ins finish (200 ms)
+    // the cycle repeats every 3 frames.
+    try testing.expect(frames[15].hash != frames[16].hash);
+    try testing.expect(frames[15].hash == frames[18].hash);
+    try testing.expect(tiling.hash != flip.hash);
+}
+
+test "render harness client commits repaint only their damage" {
+    const fixture = try testing.allocator.create(Fixture);
+    defer testing.allocator.destroy(fixture);
+    try fixture_init(fixture);
+    defer fixture_deinit(fixture);
+    var frames: [FRAMES]render_harness.FrameStats = undefined;
+    _ = try fixture.harness.run(.client_commit, &frames);
+    // The client's surface became a managed window.
+    try testing.expect(fixture.comp.windows_len == 1);
+    try testing.expect(fixture.comp.windows[0].content != null);
+    // The first frame draws the whole scene (nothing presented yet).
+    try testing.expect(frames[0].pixels_touched >= 1024 * 768);
+    // Once the fade-in (200 ms) is done, only the committed strip repaints
+    // (each decoration layer under it is clipped to the strip).
+    const strip = render_harness.CLIENT_WIDTH * render_harness.CLIENT_STRIP_ROWS;
+    var i: u32 = 15;
+    while (i < FRAMES) : (i += 1) {
+        try testing.expect(frames[i].pixels_touched > 0);
+        try testing.expect(frames[i].pixels_touched <= strip * 8);
+        try testing.expect(frames[i].hash != frames[i - 1].hash);
+    }
+}
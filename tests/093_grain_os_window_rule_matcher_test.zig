@@ -0,0 +1,122 @@
+//! Tests for the compiled Grain OS window-rule matcher.
+//! Why: Thousands of rules compile into one automaton; matches must equal
+//! the first rule in order (substring or glob) and be cached per window.
+
+const std = @import("std");
+const testing = std.testing;
+const grain_os = @import("grain_os");
+const window_rules = grain_os.window_rules;
+const compositor = grain_os.compositor;
+const WindowRuleManager = window_rules.WindowRuleManager;
+
+test "rule matcher returns the first matching rule in order" {
+    const manager = try testing.allocator.create(WindowRuleManager);
+    defer testing.allocator.destroy(manager);
+    manager.* = WindowRuleManager.init(testing.allocator);
+    defer manager.deinit();
+    const term = manager.add_rule(.title, "Term", .set_floating).?;
+    _ = manager.add_rule(.title, "Terminal", .set_tiled).?;
+    _ = manager.add_rule(.title, "minal", .set_size).?;
+    const rule = manager.match_window("My Terminal").?;
+    try testing.expect(rule.rule_id == term);
+    // Only the last rule occurs in "subliminal".
+    try testing.expect(manager.match_window("subliminal").?.action_type == .set_size);
+    try testing.expect(manager.match_window("Editor") == null);
+    // Class rules never match titles.
+    _ = manager.add_rule(.class, "Editor", .set_size).?;
+    try testing.expect(manager.match_window("Editor") == null);
+    try testing.expect(manager.match_text(.class, "Editor") != null);
+    // States are sized from the compiled keys (capacity at most doubles
+    // on growth), not MAX_STATES.
+    try testing.expect(manager.automaton.labels.len <= 2 * (1 + 4 + 8 + 5 + 6));
+}
+
+test "rule matcher scans rules when the automaton can't be allocated" {
+    var failing = std.testing.FailingAllocator.init(testing.allocator, .{ .fail_index = 0 });
+    const manager = try testing.allocator.create(WindowRuleManager);
+    defer testing.allocator.destroy(manager);
+    manager.* = WindowRuleManager.init(failing.allocator());
+    defer manager.deinit();
+    _ = manager.add_rule(.title, "Editor", .set_size).?;
+    const term = manager.add_rule(.title, "Term", .set_floating).?;
+    _ = manager.add_rule(.title, "vim ?.txt", .set_tiled).?;
+    try testing.expect(manager.match_window("My Terminal").?.rule_id == term);
+    try testing.expect(manager.match_window("vim a.txt").?.action_type == .set_tiled);
+    try testing.expect(manager.match_window("vim ab.txt") == null);
+    try testing.expect(manager.automaton.labels.len == 0);
+}
+
+test "rule matcher supports globs" {
+    const manager = try testing.allocator.create(WindowRuleManager);
+    defer testing.allocator.destroy(manager);
+    manager.* = WindowRuleManager.init(testing.allocator);
+    defer manager.deinit();
+    _ = manager.add_rule(.title, "Firefox*Private", .set_workspace).?;
+    _ = manager.add_rule(.title, "vim ?.txt", .set_tiled).?;
+    try testing.expect(manager.match_window("Firefox - Private").?.action_type == .set_workspace);
+    // Globs match the whole title.
+    try testing.expect(manager.match_window("Firefox - Private Browsing") == null);
+    try testing.expect(manager.match_window("vim a.txt").?.action_type == .set_tiled);
+    try testing.expect(manager.match_window("vim ab.txt") == null);
+    // A glob without literals is checked for every title.
+    _ = manager.add_rule(.title, "*", .set_opacity).?;
+    try testing.expect(manager.match_window("anything").?.action_type == .set_opacity);
+    try testing.expect(!window_rules.glob_match("axxbyy", "a*b*c"));
+    try testing.expect(window_rules.glob_match("axxbyyc", "a*b*c"));
+}
+
+test "rule matcher handles thousands of rules" {
+    const manager = try testing.allocator.create(WindowRuleManager);
+    defer testing.allocator.destroy(manager);
+    manager.* = WindowRuleManager.init(testing.allocator);
+    defer manager.deinit();
+    var name: [32]u8 = undefined;
+    var i: u32 = 0;
+    while (i < window_rules.MAX_RULES) : (i += 1) {
+        const pattern = try std.fmt.bufPrint(&name, "app-{d}-", .{i});
+        try testing.expect(manager.add_rule(.title, pattern, .set_floating) != null);
+    }
+    try testing.expect(manager.add_rule(.title, "overflow", .none) == null);
+    const rule = manager.match_window("window of app-3071-main").?;
+    try testing.expectEqualStrings("app-3071-", manager.pattern_of(rule));
+    try testing.expect(manager.match_window("app-99999") == null);
+
+    // Removing a rule compacts the pool and recompiles.
+    try testing.expect(manager.remove_rule(rule.rule_id));
+    try testing.expect(manager.match_window("window of app-3071-main") == null);
+    const other = manager.match_window("app-4095-").?;
+    try testing.expectEqualStrings("app-4095-", manager.pattern_of(other));
+}
+
+test "compositor caches window rule matches" {
+    const comp = try testing.allocator.create(compositor.Compositor);
+    defer testing.allocator.destroy(comp);
+    comp.init_in_place(testing.allocator);
+    defer comp.deinit();
+    const rule_id = comp.add_window_rule(.title, "Terminal", .set_floating).?;
+    const win_id = try comp.create_window(400, 300);
+    try testing.expect(comp.get_window_rule(win_id) == null);
+
+    try testing.expect(comp.set_window_title(win_id, "Terminal - zsh"));
+    const win = comp.get_window(win_id).?;
+    const generation = win.rule_generation;
+    try testing.expect(generation == comp.rule_manager.generation);
+    try testing.expect(comp.get_window_rule(win_id).?.rule_id == rule_id);
+
+    // Rule changes invalidate the cache; the next query re-matches.
+    _ = comp.add_window_rule(.title, "zsh", .set_tiled).?;
+    try testing.expect(win.rule_generation != comp.rule_manager.generation);
+    try testing.expect(comp.get_window_rule(win_id).?.rule_id == rule_id);
+    try testing.expect(comp.remove_window_rule(rule_id));
+    try testing.expect(comp.get_window_rule(win_id).?.action_type == .set_tiled);
+}
+
+test "compositor rejects rules on properties windows lack" {
+    const comp = try testing.allocator.create(compositor.Compositor);
+    defer testing.allocator.destroy(comp);
+    comp.init_in_place(testing.allocator);
+    defer comp.deinit();
+    try testing.expect(comp.add_window_rule(.class, "Editor", .set_size) == null);
+    try testing.expect(comp.add_window_rule(.instance, "editor", .set_size) == null);
+    try testing.expect(comp.get_rule_count() == 0);
+}
@@ -0,0 +1,92 @@
+//! Tests for the shared Grain OS bounded map.
+//! Why: Every id index deletes with backward shift; removing keys from the
+//! middle of probe chains must never hide the keys behind them.
+
+const std = @import("std");
+const testing = std.testing;
+const grain_os = @import("grain_os");
+const bounded_map = grain_os.bounded_map;
+
+test "bounded map puts, updates and removes" {
+    var map = bounded_map.BoundedMap(8).init();
+    try testing.expect(map.get(1) == null);
+    try testing.expect(map.put(1, 10));
+    try testing.expect(map.put(2, 20));
+    try testing.expect(map.put(1, 11));
+    try testing.expect(map.count() == 2);
+    try testing.expect(map.get(1).? == 11);
+    try testing.expect(map.remove(1).? == 11);
+    try testing.expect(map.remove(1) == null);
+    try testing.expect(map.get(2).? == 20);
+    // Key 0 is reserved and never found.
+    try testing.expect(map.get(0) == null);
+    map.clear();
+    try testing.expect(map.count() == 0);
+    try testing.expect(map.get(2) == null);
+}
+
+test "bounded map is bounded" {
+    var map = bounded_map.BoundedMap(4).init();
+    var key: u32 = 1;
+    while (key <= 4) : (key += 1) try testing.expect(map.put(key, key));
+    try testing.expect(!map.put(5, 5));
+    // Updates still succeed when full.
+    try testing.expect(map.put(4, 40));
+    try testing.expect(map.get(4).? == 40);
+}
+
+test "bounded map removal keeps probe chains intact" {
+    const Map = bounded_map.BoundedMap(256);
+    var map = Map.init();
+    // Fill to capacity (load 0.5) so probe chains form, then drop every
+    // other key.
+    var key: u32 = 1;
+    while (key <= Map.CAPACITY) : (key += 1) {
+        try testing.expect(map.put(key * 512, key));
+    }
+    key = 1;
+    while (key <= Map.CAPACITY) : (key += 2) {
+        try testing.expect(map.remove(key * 512).? == key);
+    }
+    key = 1;
+    while (key <= Map.CAPACITY) : (key += 1) {
+        const expected: ?u32 = if (key % 2 == 0) key else null;
+        try testing.expectEqual(expected, map.get(key * 512));
+    }
+    try testing.expect(map.count() == Map.CAPACITY / 2);
+}
+
+// Slots hold indexes into names; keys live outside the table.
+const Names = struct {
+    names: []const []const u8,
+
+    fn home(self: Names, slot: u8) usize {
+        return self.names[slot].len;
+    }
+};
+
+const Lookup = struct {
+    names: Names,
+    key: []const u8,
+
+    fn matches(self: Lookup, slot: u8) bool {
+        return std.mem.eql(u8, self.names.names[slot], self.key);
+    }
+};
+
+test "open table removes slots keyed outside the table" {
+    const Table = bounded_map.OpenTable(u8, 0xFF);
+    const names = Names{ .names = &.{ "a", "b", "cc", "d" } };
+    var slots = [_]u8{0xFF} ** 8;
+    // "a", "b" and "d" share home 1; "cc" (home 2) is displaced by "b".
+    for (0..names.names.len) |i| {
+        _ = Table.insert(&slots, names.home(@intCast(i)), @intCast(i));
+    }
+    try testing.expectEqualSlices(u8, &.{ 0xFF, 0, 1, 2, 3, 0xFF, 0xFF, 0xFF }, &slots);
+    try testing.expect(Table.find(&slots, 1, Lookup{ .names = names, .key = "d" }, Lookup.matches).? == 4);
+    Table.remove_at(&slots, 1, names, Names.home);
+    // Each later chain member moves back one slot ("cc" reaches its home).
+    try testing.expectEqualSlices(u8, &.{ 0xFF, 1, 2, 3, 0xFF, 0xFF, 0xFF, 0xFF }, &slots);
+    try testing.expect(Table.find(&slots, 1, Lookup{ .names = names, .key = "a" }, Lookup.matches) == null);
+    try testing.expect(Table.find(&slots, 1, Lookup{ .names = names, .key = "d" }, Lookup.matches).? == 3);
+}